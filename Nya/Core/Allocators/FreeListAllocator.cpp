@@ -59,10 +59,10 @@ void* FreeListAllocator::allocate( const std::size_t allocationSize, const std::
             if ( previousFreeBlock != nullptr )
                 previousFreeBlock->next = freeBlock->next;
             else
-                freeBlock = freeBlock->next;
+                freeBlockList = freeBlock->next;
         } else {
             // Else create a new FreeBlock containing remaining memory 
-            FreeBlock* nextFreeBlock = static_cast<FreeBlock*>( freeBlock + requiredSize );
+            FreeBlock* nextFreeBlock = reinterpret_cast<FreeBlock*>( reinterpret_cast<std::uint8_t*>( freeBlock ) + requiredSize );
 
             nextFreeBlock->size = freeBlock->size - requiredSize;
             nextFreeBlock->next = freeBlock->next;
@@ -89,7 +89,7 @@ void* FreeListAllocator::allocate( const std::size_t allocationSize, const std::
 
 void FreeListAllocator::free( void* pointer )
 {
-    AllocationHeader* header = ( reinterpret_cast<AllocationHeader*>( pointer ) - sizeof( AllocationHeader ) );
+    AllocationHeader* header = reinterpret_cast<AllocationHeader*>( reinterpret_cast<std::uint8_t*>( pointer ) - sizeof( AllocationHeader ) );
 
     const std::uint8_t* blockBaseAddress = reinterpret_cast<std::uint8_t*>( pointer ) - header->adjustment;
     const size_t blockSize = header->size;
@@ -0,0 +1,472 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "TLSFAllocator.h"
+
+#include <Maths/Helpers.h>
+
+namespace
+{
+    // Index of the least significant bit set (word should not be zero)
+    inline std::uint32_t FindFirstSet( const std::uint32_t word )
+    {
+#if NYA_MSVC
+        unsigned long bitIndex = 0ul;
+        _BitScanForward( &bitIndex, word );
+        return static_cast<std::uint32_t>( bitIndex );
+#else
+        return static_cast<std::uint32_t>( __builtin_ctz( word ) );
+#endif
+    }
+
+    // Index of the most significant bit set (word should not be zero)
+    inline std::uint32_t FindLastSet( const std::uint64_t word )
+    {
+#if NYA_MSVC
+        unsigned long bitIndex = 0ul;
+        _BitScanReverse64( &bitIndex, word );
+        return static_cast<std::uint32_t>( bitIndex );
+#else
+        return 63u - static_cast<std::uint32_t>( __builtin_clzll( word ) );
+#endif
+    }
+
+    inline std::size_t AlignUp( const std::size_t value, const std::size_t alignment )
+    {
+        return ( value + ( alignment - 1 ) ) & ~( alignment - 1 );
+    }
+
+    inline std::size_t AlignDown( const std::size_t value, const std::size_t alignment )
+    {
+        return value & ~( alignment - 1 );
+    }
+}
+
+std::size_t TLSFAllocator::BlockHeader::getSize() const
+{
+    return sizeAndFlags & ~BLOCK_FLAGS_MASK;
+}
+
+void TLSFAllocator::BlockHeader::setSize( const std::size_t size )
+{
+    sizeAndFlags = size | ( sizeAndFlags & BLOCK_FLAGS_MASK );
+}
+
+bool TLSFAllocator::BlockHeader::isFree() const
+{
+    return ( sizeAndFlags & BLOCK_FREE_FLAG ) != 0;
+}
+
+void TLSFAllocator::BlockHeader::setFree( const bool isFree )
+{
+    sizeAndFlags = ( isFree ) ? ( sizeAndFlags | BLOCK_FREE_FLAG ) : ( sizeAndFlags & ~BLOCK_FREE_FLAG );
+}
+
+bool TLSFAllocator::BlockHeader::isPreviousFree() const
+{
+    return ( sizeAndFlags & BLOCK_PREVIOUS_FREE_FLAG ) != 0;
+}
+
+void TLSFAllocator::BlockHeader::setPreviousFree( const bool isPreviousFree )
+{
+    sizeAndFlags = ( isPreviousFree ) ? ( sizeAndFlags | BLOCK_PREVIOUS_FREE_FLAG ) : ( sizeAndFlags & ~BLOCK_PREVIOUS_FREE_FLAG );
+}
+
+void* TLSFAllocator::BlockHeader::getPayload()
+{
+    return reinterpret_cast<std::uint8_t*>( this ) + BLOCK_PAYLOAD_OFFSET;
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::BlockHeader::getNextPhysicalBlock()
+{
+    // The header of the next block overlaps the last word of this block payload (previousPhysicalBlock)
+    return reinterpret_cast<BlockHeader*>( static_cast<std::uint8_t*>( getPayload() ) + getSize() - BLOCK_HEADER_OVERHEAD );
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::BlockHeader::linkNextPhysicalBlock()
+{
+    BlockHeader* nextBlock = getNextPhysicalBlock();
+    nextBlock->previousPhysicalBlock = this;
+
+    return nextBlock;
+}
+
+void TLSFAllocator::BlockHeader::markAsFree()
+{
+    BlockHeader* nextBlock = linkNextPhysicalBlock();
+    nextBlock->setPreviousFree( true );
+
+    setFree( true );
+}
+
+void TLSFAllocator::BlockHeader::markAsUsed()
+{
+    BlockHeader* nextBlock = getNextPhysicalBlock();
+    nextBlock->setPreviousFree( false );
+
+    setFree( false );
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::BlockHeader::FromPayload( void* payload )
+{
+    return reinterpret_cast<BlockHeader*>( static_cast<std::uint8_t*>( payload ) - BLOCK_PAYLOAD_OFFSET );
+}
+
+TLSFAllocator::TLSFAllocator( const std::size_t size, void* baseAddress )
+    : BaseAllocator( size, baseAddress )
+    , firstLevelBitmap( 0u )
+    , secondLevelBitmaps{ 0u }
+    , freeBlocks{}
+{
+    // The first block header starts one word before the pool (its previousPhysicalBlock is never accessed)
+    // Two words are kept at the end of the pool for the sentinel block (zero sized used block which stops merges)
+    const std::size_t poolStart = AlignUp( reinterpret_cast<std::size_t>( baseAddress ), ALIGNMENT );
+    const std::size_t alignmentOffset = poolStart - reinterpret_cast<std::size_t>( baseAddress );
+
+    NYA_DEV_ASSERT( size > alignmentOffset + BLOCK_HEADER_OVERHEAD * 2 + BLOCK_SIZE_MIN, "TLSF pool is too small (%zu bytes)", size );
+
+    const std::size_t poolSize = AlignDown( size - alignmentOffset - BLOCK_HEADER_OVERHEAD * 2, ALIGNMENT );
+
+    NYA_DEV_ASSERT( poolSize < BLOCK_SIZE_MAX, "TLSF pool is too large (%zu bytes; max is %zu bytes)", size, static_cast<std::size_t>( BLOCK_SIZE_MAX ) );
+
+    BlockHeader* block = reinterpret_cast<BlockHeader*>( poolStart - BLOCK_HEADER_OVERHEAD );
+    block->sizeAndFlags = poolSize;
+    block->setFree( true );
+    insertFreeBlock( block );
+
+    BlockHeader* sentinelBlock = block->linkNextPhysicalBlock();
+    sentinelBlock->sizeAndFlags = 0;
+    sentinelBlock->setPreviousFree( true );
+}
+
+TLSFAllocator::~TLSFAllocator()
+{
+    firstLevelBitmap = 0u;
+}
+
+void* TLSFAllocator::allocate( const std::size_t allocationSize, const std::uint8_t alignment )
+{
+    NYA_DEV_ASSERT( ( alignment & ( alignment - 1 ) ) == 0, "Alignment should be a power of two (got %u)", alignment );
+
+    const std::size_t blockSize = nya::maths::max( AlignUp( allocationSize, ALIGNMENT ), BLOCK_SIZE_MIN );
+
+    BlockHeader* block = nullptr;
+
+    if ( alignment <= ALIGNMENT ) {
+        block = locateFreeBlock( blockSize );
+
+        if ( block == nullptr ) {
+            return nullptr;
+        }
+    } else {
+        // Request enough space to split a free block in front of the aligned payload
+        constexpr std::size_t GAP_SIZE_MIN = sizeof( BlockHeader );
+        const std::size_t sizeWithGap = AlignUp( blockSize + alignment + GAP_SIZE_MIN, alignment );
+
+        block = locateFreeBlock( sizeWithGap );
+
+        if ( block == nullptr ) {
+            return nullptr;
+        }
+
+        const std::size_t payloadAddress = reinterpret_cast<std::size_t>( block->getPayload() );
+        std::size_t alignedAddress = AlignUp( payloadAddress, alignment );
+
+        // The gap should be large enough to hold a free block
+        if ( alignedAddress != payloadAddress && alignedAddress - payloadAddress < GAP_SIZE_MIN ) {
+            alignedAddress = AlignUp( payloadAddress + GAP_SIZE_MIN, alignment );
+        }
+
+        const std::size_t gapSize = alignedAddress - payloadAddress;
+        if ( gapSize > 0 ) {
+            block = trimFreeLeadingBlock( block, gapSize );
+        }
+    }
+
+    trimFreeBlock( block, blockSize );
+    block->markAsUsed();
+
+    memoryUsage += ( block->getSize() + BLOCK_HEADER_OVERHEAD );
+    allocationCount++;
+
+    return block->getPayload();
+}
+
+void TLSFAllocator::free( void* pointer )
+{
+    if ( pointer == nullptr ) {
+        return;
+    }
+
+    BlockHeader* block = BlockHeader::FromPayload( pointer );
+
+    NYA_DEV_ASSERT( !block->isFree(), "Block 0x%p has already been freed", pointer );
+
+    memoryUsage -= ( block->getSize() + BLOCK_HEADER_OVERHEAD );
+    allocationCount--;
+
+    block->markAsFree();
+    block = mergeWithPreviousBlock( block );
+    block = mergeWithNextBlock( block );
+
+    insertFreeBlock( block );
+}
+
+std::size_t TLSFAllocator::getFreeBlockCount() const
+{
+    std::size_t freeBlockCount = 0;
+
+    for ( std::uint32_t firstLevelIdx = 0u; firstLevelIdx < FL_INDEX_COUNT; firstLevelIdx++ ) {
+        for ( std::uint32_t secondLevelIdx = 0u; secondLevelIdx < SL_INDEX_COUNT; secondLevelIdx++ ) {
+            for ( const BlockHeader* block = freeBlocks[firstLevelIdx][secondLevelIdx]; block != nullptr; block = block->nextFreeBlock ) {
+                freeBlockCount++;
+            }
+        }
+    }
+
+    return freeBlockCount;
+}
+
+std::size_t TLSFAllocator::getLargestFreeBlockSize() const
+{
+    if ( firstLevelBitmap == 0u ) {
+        return 0;
+    }
+
+    // Blocks of the highest bin are not sorted
+    const std::uint32_t firstLevelIndex = FindLastSet( firstLevelBitmap );
+    const std::uint32_t secondLevelIndex = FindLastSet( secondLevelBitmaps[firstLevelIndex] );
+
+    std::size_t largestBlockSize = 0;
+    for ( const BlockHeader* block = freeBlocks[firstLevelIndex][secondLevelIndex]; block != nullptr; block = block->nextFreeBlock ) {
+        largestBlockSize = nya::maths::max( largestBlockSize, block->getSize() );
+    }
+
+    return largestBlockSize;
+}
+
+float TLSFAllocator::getFragmentation() const
+{
+    std::size_t freeMemorySize = 0;
+
+    for ( std::uint32_t firstLevelIdx = 0u; firstLevelIdx < FL_INDEX_COUNT; firstLevelIdx++ ) {
+        for ( std::uint32_t secondLevelIdx = 0u; secondLevelIdx < SL_INDEX_COUNT; secondLevelIdx++ ) {
+            for ( const BlockHeader* block = freeBlocks[firstLevelIdx][secondLevelIdx]; block != nullptr; block = block->nextFreeBlock ) {
+                freeMemorySize += block->getSize();
+            }
+        }
+    }
+
+    if ( freeMemorySize == 0 ) {
+        return 0.0f;
+    }
+
+    return 1.0f - static_cast<float>( static_cast<double>( getLargestFreeBlockSize() ) / freeMemorySize );
+}
+
+void TLSFAllocator::MappingInsert( const std::size_t size, std::uint32_t& firstLevelIndex, std::uint32_t& secondLevelIndex )
+{
+    if ( size < SMALL_BLOCK_SIZE ) {
+        firstLevelIndex = 0u;
+        secondLevelIndex = static_cast<std::uint32_t>( size / ( SMALL_BLOCK_SIZE / SL_INDEX_COUNT ) );
+    } else {
+        const std::uint32_t lastBitSet = FindLastSet( size );
+
+        firstLevelIndex = lastBitSet - ( FL_INDEX_SHIFT - 1u );
+        secondLevelIndex = static_cast<std::uint32_t>( size >> ( lastBitSet - SL_INDEX_COUNT_LOG2 ) ) ^ SL_INDEX_COUNT;
+    }
+}
+
+void TLSFAllocator::MappingSearch( const std::size_t size, std::uint32_t& firstLevelIndex, std::uint32_t& secondLevelIndex )
+{
+    // Round the size up to the next bin (any block of this bin is large enough)
+    std::size_t roundedSize = size;
+    if ( size >= SMALL_BLOCK_SIZE ) {
+        roundedSize += ( 1ull << ( FindLastSet( size ) - SL_INDEX_COUNT_LOG2 ) ) - 1;
+    }
+
+    MappingInsert( roundedSize, firstLevelIndex, secondLevelIndex );
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::searchSuitableBlock( std::uint32_t& firstLevelIndex, std::uint32_t& secondLevelIndex ) const
+{
+    std::uint32_t secondLevelBitmap = secondLevelBitmaps[firstLevelIndex] & ( ~0u << secondLevelIndex );
+
+    // Use the first non empty bin of the next first levels
+    if ( secondLevelBitmap == 0u ) {
+        const std::uint32_t firstLevelBitmapMasked = firstLevelBitmap & ( ~0u << ( firstLevelIndex + 1u ) );
+
+        if ( firstLevelBitmapMasked == 0u ) {
+            return nullptr;
+        }
+
+        firstLevelIndex = FindFirstSet( firstLevelBitmapMasked );
+        secondLevelBitmap = secondLevelBitmaps[firstLevelIndex];
+    }
+
+    secondLevelIndex = FindFirstSet( secondLevelBitmap );
+
+    return freeBlocks[firstLevelIndex][secondLevelIndex];
+}
+
+void TLSFAllocator::insertFreeBlock( BlockHeader* block )
+{
+    std::uint32_t firstLevelIndex = 0u, secondLevelIndex = 0u;
+    MappingInsert( block->getSize(), firstLevelIndex, secondLevelIndex );
+
+    BlockHeader* listHead = freeBlocks[firstLevelIndex][secondLevelIndex];
+
+    block->nextFreeBlock = listHead;
+    block->previousFreeBlock = nullptr;
+
+    if ( listHead != nullptr ) {
+        listHead->previousFreeBlock = block;
+    }
+
+    freeBlocks[firstLevelIndex][secondLevelIndex] = block;
+
+    firstLevelBitmap |= ( 1u << firstLevelIndex );
+    secondLevelBitmaps[firstLevelIndex] |= ( 1u << secondLevelIndex );
+}
+
+void TLSFAllocator::removeFreeBlock( BlockHeader* block, const std::uint32_t firstLevelIndex, const std::uint32_t secondLevelIndex )
+{
+    BlockHeader* previousBlock = block->previousFreeBlock;
+    BlockHeader* nextBlock = block->nextFreeBlock;
+
+    if ( previousBlock != nullptr ) {
+        previousBlock->nextFreeBlock = nextBlock;
+    }
+
+    if ( nextBlock != nullptr ) {
+        nextBlock->previousFreeBlock = previousBlock;
+    }
+
+    if ( freeBlocks[firstLevelIndex][secondLevelIndex] == block ) {
+        freeBlocks[firstLevelIndex][secondLevelIndex] = nextBlock;
+
+        // Update bitmaps if the bin is now empty
+        if ( nextBlock == nullptr ) {
+            secondLevelBitmaps[firstLevelIndex] &= ~( 1u << secondLevelIndex );
+
+            if ( secondLevelBitmaps[firstLevelIndex] == 0u ) {
+                firstLevelBitmap &= ~( 1u << firstLevelIndex );
+            }
+        }
+    }
+}
+
+void TLSFAllocator::removeFreeBlock( BlockHeader* block )
+{
+    std::uint32_t firstLevelIndex = 0u, secondLevelIndex = 0u;
+    MappingInsert( block->getSize(), firstLevelIndex, secondLevelIndex );
+
+    removeFreeBlock( block, firstLevelIndex, secondLevelIndex );
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::locateFreeBlock( const std::size_t size )
+{
+    std::uint32_t firstLevelIndex = 0u, secondLevelIndex = 0u;
+    MappingSearch( size, firstLevelIndex, secondLevelIndex );
+
+    if ( firstLevelIndex >= FL_INDEX_COUNT ) {
+        return nullptr;
+    }
+
+    BlockHeader* block = searchSuitableBlock( firstLevelIndex, secondLevelIndex );
+
+    if ( block != nullptr ) {
+        removeFreeBlock( block, firstLevelIndex, secondLevelIndex );
+    }
+
+    return block;
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::splitBlock( BlockHeader* block, const std::size_t size )
+{
+    BlockHeader* remainingBlock = reinterpret_cast<BlockHeader*>( static_cast<std::uint8_t*>( block->getPayload() ) + size - BLOCK_HEADER_OVERHEAD );
+    remainingBlock->sizeAndFlags = block->getSize() - ( size + BLOCK_HEADER_OVERHEAD );
+
+    block->setSize( size );
+    remainingBlock->markAsFree();
+
+    return remainingBlock;
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::mergeWithPreviousBlock( BlockHeader* block )
+{
+    if ( !block->isPreviousFree() ) {
+        return block;
+    }
+
+    BlockHeader* previousBlock = block->previousPhysicalBlock;
+    removeFreeBlock( previousBlock );
+
+    previousBlock->setSize( previousBlock->getSize() + block->getSize() + BLOCK_HEADER_OVERHEAD );
+    previousBlock->linkNextPhysicalBlock();
+
+    return previousBlock;
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::mergeWithNextBlock( BlockHeader* block )
+{
+    BlockHeader* nextBlock = block->getNextPhysicalBlock();
+
+    if ( !nextBlock->isFree() ) {
+        return block;
+    }
+
+    removeFreeBlock( nextBlock );
+
+    block->setSize( block->getSize() + nextBlock->getSize() + BLOCK_HEADER_OVERHEAD );
+    block->linkNextPhysicalBlock();
+
+    return block;
+}
+
+void TLSFAllocator::trimFreeBlock( BlockHeader* block, const std::size_t size )
+{
+    // The remaining block should be able to hold a free block header
+    if ( block->getSize() < size + sizeof( BlockHeader ) ) {
+        return;
+    }
+
+    BlockHeader* remainingBlock = splitBlock( block, size );
+    block->linkNextPhysicalBlock();
+    remainingBlock->setPreviousFree( true );
+
+    insertFreeBlock( remainingBlock );
+}
+
+TLSFAllocator::BlockHeader* TLSFAllocator::trimFreeLeadingBlock( BlockHeader* block, const std::size_t size )
+{
+    if ( block->getSize() < size + sizeof( BlockHeader ) ) {
+        return block;
+    }
+
+    // The leading block goes back to the free lists
+    BlockHeader* remainingBlock = splitBlock( block, size - BLOCK_HEADER_OVERHEAD );
+    block->linkNextPhysicalBlock();
+    remainingBlock->setPreviousFree( true );
+
+    insertFreeBlock( block );
+
+    return remainingBlock;
+}
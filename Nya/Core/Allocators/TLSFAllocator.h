@@ -0,0 +1,116 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "BaseAllocator.h"
+
+// Two-Level Segregated Fit allocator (O(1) allocation and free)
+// Free blocks are binned by size: the first level splits sizes in powers of two, the second level splits each power of two
+// in SL_INDEX_COUNT linear ranges. Two bitmaps give the first non empty bin large enough for a request without any scan
+// Adjacent free blocks are merged immediately (boundary tags)
+// NOTE Pool size is limited to 64GB
+class TLSFAllocator final : public BaseAllocator
+{
+public:
+                        TLSFAllocator( const std::size_t size, void* baseAddress );
+                        TLSFAllocator( TLSFAllocator& ) = delete;
+                        TLSFAllocator& operator = ( TLSFAllocator& ) = delete;
+                        ~TLSFAllocator();
+
+    void*               allocate( const std::size_t allocationSize, const std::uint8_t alignment = 4 ) override;
+    void                free( void* pointer ) override;
+
+    // Fragmentation metrics (free bins are scanned; should not be called in hot paths)
+    std::size_t         getFreeBlockCount() const;
+    std::size_t         getLargestFreeBlockSize() const;
+
+    // 0: every free byte is in a single block; 1: free memory is scattered in tiny blocks
+    float               getFragmentation() const;
+
+private:
+    static constexpr std::uint32_t  ALIGNMENT_LOG2 = 3u;
+    static constexpr std::size_t    ALIGNMENT = ( 1ull << ALIGNMENT_LOG2 );
+
+    static constexpr std::uint32_t  SL_INDEX_COUNT_LOG2 = 5u;
+    static constexpr std::uint32_t  SL_INDEX_COUNT = ( 1u << SL_INDEX_COUNT_LOG2 );
+
+    // Blocks smaller than SMALL_BLOCK_SIZE are stored in the first level bin 0 (linear second level)
+    static constexpr std::uint32_t  FL_INDEX_SHIFT = ( SL_INDEX_COUNT_LOG2 + ALIGNMENT_LOG2 );
+    static constexpr std::uint32_t  FL_INDEX_MAX = 36u;
+    static constexpr std::uint32_t  FL_INDEX_COUNT = ( FL_INDEX_MAX - FL_INDEX_SHIFT + 1u );
+    static constexpr std::size_t    SMALL_BLOCK_SIZE = ( 1ull << FL_INDEX_SHIFT );
+
+    // Physical block header
+    // previousPhysicalBlock is stored at the end of the previous block (only valid if the previous block is free)
+    // Free list links are stored in the block payload (only valid if the block is free)
+    struct BlockHeader {
+        BlockHeader*    previousPhysicalBlock;
+        std::size_t     sizeAndFlags;
+        BlockHeader*    nextFreeBlock;
+        BlockHeader*    previousFreeBlock;
+
+        std::size_t     getSize() const;
+        void            setSize( const std::size_t size );
+        bool            isFree() const;
+        void            setFree( const bool isFree );
+        bool            isPreviousFree() const;
+        void            setPreviousFree( const bool isPreviousFree );
+
+        void*           getPayload();
+        BlockHeader*    getNextPhysicalBlock();
+        BlockHeader*    linkNextPhysicalBlock();
+
+        void            markAsFree();
+        void            markAsUsed();
+
+        static BlockHeader* FromPayload( void* payload );
+    };
+
+    static constexpr std::size_t    BLOCK_FREE_FLAG = ( 1ull << 0 );
+    static constexpr std::size_t    BLOCK_PREVIOUS_FREE_FLAG = ( 1ull << 1 );
+    static constexpr std::size_t    BLOCK_FLAGS_MASK = ( BLOCK_FREE_FLAG | BLOCK_PREVIOUS_FREE_FLAG );
+
+    // Only the size is stored before the payload of a used block
+    static constexpr std::size_t    BLOCK_HEADER_OVERHEAD = sizeof( std::size_t );
+    static constexpr std::size_t    BLOCK_PAYLOAD_OFFSET = ( sizeof( BlockHeader* ) + sizeof( std::size_t ) );
+    static constexpr std::size_t    BLOCK_SIZE_MIN = ( sizeof( BlockHeader ) - sizeof( BlockHeader* ) );
+    static constexpr std::size_t    BLOCK_SIZE_MAX = ( 1ull << FL_INDEX_MAX );
+
+private:
+    std::uint32_t   firstLevelBitmap;
+    std::uint32_t   secondLevelBitmaps[FL_INDEX_COUNT];
+    BlockHeader*    freeBlocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+private:
+    static void     MappingInsert( const std::size_t size, std::uint32_t& firstLevelIndex, std::uint32_t& secondLevelIndex );
+    static void     MappingSearch( const std::size_t size, std::uint32_t& firstLevelIndex, std::uint32_t& secondLevelIndex );
+
+    BlockHeader*    searchSuitableBlock( std::uint32_t& firstLevelIndex, std::uint32_t& secondLevelIndex ) const;
+    void            insertFreeBlock( BlockHeader* block );
+    void            removeFreeBlock( BlockHeader* block, const std::uint32_t firstLevelIndex, const std::uint32_t secondLevelIndex );
+    void            removeFreeBlock( BlockHeader* block );
+
+    BlockHeader*    locateFreeBlock( const std::size_t size );
+    BlockHeader*    splitBlock( BlockHeader* block, const std::size_t size );
+    BlockHeader*    mergeWithPreviousBlock( BlockHeader* block );
+    BlockHeader*    mergeWithNextBlock( BlockHeader* block );
+    void            trimFreeBlock( BlockHeader* block, const std::size_t size );
+    BlockHeader*    trimFreeLeadingBlock( BlockHeader* block, const std::size_t size );
+};
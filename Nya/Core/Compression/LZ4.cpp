@@ -0,0 +1,255 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "LZ4.h"
+
+#include <string.h>
+
+static constexpr std::size_t MIN_MATCH_LENGTH = 4;
+static constexpr std::size_t LAST_LITERALS_LENGTH = 5; // The last 5 bytes of a block are always literals
+static constexpr std::size_t MATCH_FIND_LIMIT = 12; // The last match starts at least 12 bytes before the end of the block
+static constexpr std::size_t MAX_MATCH_DISTANCE = 65535;
+static constexpr uint32_t HASH_TABLE_BITS = 12;
+static constexpr uint32_t SKIP_TRIGGER = 6; // Step forward faster on incompressible data
+
+static uint32_t Read32( const uint8_t* pointer )
+{
+    uint32_t value;
+    memcpy( &value, pointer, sizeof( uint32_t ) );
+    return value;
+}
+
+static uint32_t HashSequence( const uint32_t sequence )
+{
+    return ( sequence * 2654435761u ) >> ( 32 - HASH_TABLE_BITS );
+}
+
+// Write the length overflowing the token nibble
+static bool WriteLength( std::size_t length, uint8_t*& output, const uint8_t* outputEnd )
+{
+    while ( length >= 255 ) {
+        if ( output == outputEnd ) {
+            return false;
+        }
+
+        *output++ = 255;
+        length -= 255;
+    }
+
+    if ( output == outputEnd ) {
+        return false;
+    }
+
+    *output++ = static_cast<uint8_t>( length );
+    return true;
+}
+
+static bool ReadLength( std::size_t& length, const uint8_t*& input, const uint8_t* inputEnd )
+{
+    uint8_t lengthByte = 0;
+
+    do {
+        if ( input == inputEnd ) {
+            return false;
+        }
+
+        lengthByte = *input++;
+        length += lengthByte;
+    } while ( lengthByte == 255 );
+
+    return true;
+}
+
+// Write a sequence (literals, then a match if matchLength is not zero)
+static bool WriteSequence( const uint8_t* literals, const std::size_t literalLength, const std::size_t matchOffset, const std::size_t matchLength, uint8_t*& output, const uint8_t* outputEnd )
+{
+    if ( output == outputEnd ) {
+        return false;
+    }
+
+    uint8_t* token = output++;
+    *token = static_cast<uint8_t>( ( ( literalLength >= 15 ) ? 15 : literalLength ) << 4 );
+
+    if ( literalLength >= 15 && !WriteLength( literalLength - 15, output, outputEnd ) ) {
+        return false;
+    }
+
+    if ( static_cast<std::size_t>( outputEnd - output ) < literalLength ) {
+        return false;
+    }
+
+    if ( literalLength != 0 ) {
+        memcpy( output, literals, literalLength );
+        output += literalLength;
+    }
+
+    if ( matchLength == 0 ) {
+        return true;
+    }
+
+    if ( outputEnd - output < 2 ) {
+        return false;
+    }
+
+    *output++ = static_cast<uint8_t>( matchOffset & 0xFF );
+    *output++ = static_cast<uint8_t>( matchOffset >> 8 );
+
+    const std::size_t encodedMatchLength = matchLength - MIN_MATCH_LENGTH;
+    *token |= static_cast<uint8_t>( ( encodedMatchLength >= 15 ) ? 15 : encodedMatchLength );
+
+    return ( encodedMatchLength < 15 || WriteLength( encodedMatchLength - 15, output, outputEnd ) );
+}
+
+std::size_t nya::core::LZ4GetCompressBound( const std::size_t size )
+{
+    return size + ( size / 255 ) + 16;
+}
+
+std::size_t nya::core::LZ4Compress( const uint8_t* source, const std::size_t sourceSize, uint8_t* destination, const std::size_t destinationCapacity )
+{
+    uint8_t* output = destination;
+    const uint8_t* outputEnd = destination + destinationCapacity;
+
+    std::size_t anchor = 0;
+
+    if ( sourceSize > MATCH_FIND_LIMIT ) {
+        // Positions of the last sequences seen for each hash (greedy parsing; no chains)
+        uint32_t hashTable[1 << HASH_TABLE_BITS] = {};
+
+        const std::size_t matchStartLimit = sourceSize - MATCH_FIND_LIMIT;
+        const std::size_t matchEndLimit = sourceSize - LAST_LITERALS_LENGTH;
+
+        std::size_t position = 0;
+        std::size_t missCount = 0;
+
+        while ( position < matchStartLimit ) {
+            const uint32_t sequence = Read32( source + position );
+            const uint32_t hash = HashSequence( sequence );
+
+            std::size_t candidate = hashTable[hash];
+            hashTable[hash] = static_cast<uint32_t>( position );
+
+            if ( candidate >= position || ( position - candidate ) > MAX_MATCH_DISTANCE || Read32( source + candidate ) != sequence ) {
+                position += 1 + ( missCount++ >> SKIP_TRIGGER );
+                continue;
+            }
+
+            missCount = 0;
+
+            // Extend the match backward (over pending literals), then forward
+            while ( position > anchor && candidate > 0 && source[position - 1] == source[candidate - 1] ) {
+                position--;
+                candidate--;
+            }
+
+            std::size_t matchLength = MIN_MATCH_LENGTH;
+            while ( position + matchLength < matchEndLimit && source[candidate + matchLength] == source[position + matchLength] ) {
+                matchLength++;
+            }
+
+            if ( !WriteSequence( source + anchor, position - anchor, position - candidate, matchLength, output, outputEnd ) ) {
+                return 0;
+            }
+
+            position += matchLength;
+            anchor = position;
+
+            // Keep the table up to date with the end of the match (helps repeated patterns)
+            if ( position - 2 < matchStartLimit ) {
+                hashTable[HashSequence( Read32( source + position - 2 ) )] = static_cast<uint32_t>( position - 2 );
+            }
+        }
+    }
+
+    if ( !WriteSequence( source + anchor, sourceSize - anchor, 0, 0, output, outputEnd ) ) {
+        return 0;
+    }
+
+    return static_cast<std::size_t>( output - destination );
+}
+
+bool nya::core::LZ4Decompress( const uint8_t* source, const std::size_t sourceSize, uint8_t* destination, const std::size_t destinationSize )
+{
+    const uint8_t* input = source;
+    const uint8_t* inputEnd = source + sourceSize;
+
+    uint8_t* output = destination;
+    const uint8_t* outputEnd = destination + destinationSize;
+
+    while ( input < inputEnd ) {
+        const uint8_t token = *input++;
+
+        std::size_t literalLength = ( token >> 4 );
+        if ( literalLength == 15 && !ReadLength( literalLength, input, inputEnd ) ) {
+            return false;
+        }
+
+        if ( static_cast<std::size_t>( inputEnd - input ) < literalLength || static_cast<std::size_t>( outputEnd - output ) < literalLength ) {
+            return false;
+        }
+
+        if ( literalLength != 0 ) {
+            memcpy( output, input, literalLength );
+            input += literalLength;
+            output += literalLength;
+        }
+
+        // The last sequence only has literals
+        if ( input == inputEnd ) {
+            break;
+        }
+
+        if ( inputEnd - input < 2 ) {
+            return false;
+        }
+
+        const std::size_t matchOffset = static_cast<std::size_t>( input[0] ) | ( static_cast<std::size_t>( input[1] ) << 8 );
+        input += 2;
+
+        if ( matchOffset == 0 || matchOffset > static_cast<std::size_t>( output - destination ) ) {
+            return false;
+        }
+
+        std::size_t matchLength = ( token & 0x0F );
+        if ( matchLength == 15 && !ReadLength( matchLength, input, inputEnd ) ) {
+            return false;
+        }
+
+        matchLength += MIN_MATCH_LENGTH;
+
+        if ( static_cast<std::size_t>( outputEnd - output ) < matchLength ) {
+            return false;
+        }
+
+        const uint8_t* match = output - matchOffset;
+
+        // Overlapping matches repeat the last matchOffset bytes
+        if ( matchOffset >= matchLength ) {
+            memcpy( output, match, matchLength );
+            output += matchLength;
+        } else {
+            for ( std::size_t byteIdx = 0; byteIdx < matchLength; byteIdx++ ) {
+                *output++ = *match++;
+            }
+        }
+    }
+
+    return ( output == outputEnd );
+}
@@ -0,0 +1,37 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+// LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md)
+// Blocks are compatible with the reference implementation (LZ4_compress_default/LZ4_decompress_safe)
+namespace nya
+{
+    namespace core
+    {
+        // Return the worst case size of a compressed block
+        std::size_t LZ4GetCompressBound( const std::size_t size );
+
+        // Return the size of the compressed block (0 if the destination is too small)
+        std::size_t LZ4Compress( const uint8_t* source, const std::size_t sourceSize, uint8_t* destination, const std::size_t destinationCapacity );
+
+        // Return false if the block is malformed or if it does not decompress to exactly destinationSize bytes
+        bool        LZ4Decompress( const uint8_t* source, const std::size_t sourceSize, uint8_t* destination, const std::size_t destinationSize );
+    }
+}
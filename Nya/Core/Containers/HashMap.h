@@ -0,0 +1,74 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "HashTable.h"
+
+namespace nya
+{
+    namespace core
+    {
+        template<typename TKey, typename TValue>
+        struct HashMapGetKey
+        {
+            const TKey& operator () ( const std::pair<TKey, TValue>& entry ) const
+            {
+                return entry.first;
+            }
+        };
+    }
+}
+
+// Open addressing hash map (see HashTable)
+// Entries are std::pair (first: key; second: value) so the interface matches std::map for lookups and iteration
+template<typename TKey, typename TValue>
+class HashMap : public HashTable<TKey, std::pair<TKey, TValue>, nya::core::HashMapGetKey<TKey, TValue>>
+{
+public:
+    using Entry = std::pair<TKey, TValue>;
+
+public:
+    TValue& operator [] ( const TKey& key )
+    {
+        bool isNewEntry = false;
+        const uint32_t slotIndex = this->findOrInsertSlot( key, isNewEntry );
+
+        if ( isNewEntry ) {
+            new ( &this->getEntry( slotIndex ) ) Entry( key, TValue() );
+        }
+
+        return this->getEntry( slotIndex ).second;
+    }
+
+    // Insert or overwrite the value of a key
+    TValue& insert( const TKey& key, const TValue& value )
+    {
+        bool isNewEntry = false;
+        const uint32_t slotIndex = this->findOrInsertSlot( key, isNewEntry );
+
+        if ( isNewEntry ) {
+            new ( &this->getEntry( slotIndex ) ) Entry( key, value );
+        } else {
+            this->getEntry( slotIndex ).second = value;
+        }
+
+        return this->getEntry( slotIndex ).second;
+    }
+};
@@ -0,0 +1,56 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "HashTable.h"
+
+namespace nya
+{
+    namespace core
+    {
+        template<typename TKey>
+        struct HashSetGetKey
+        {
+            const TKey& operator () ( const TKey& entry ) const
+            {
+                return entry;
+            }
+        };
+    }
+}
+
+// Open addressing hash set (see HashTable)
+template<typename TKey>
+class HashSet : public HashTable<TKey, TKey, nya::core::HashSetGetKey<TKey>>
+{
+public:
+    // Return true if the key was not in the set yet
+    bool insert( const TKey& key )
+    {
+        bool isNewEntry = false;
+        const uint32_t slotIndex = this->findOrInsertSlot( key, isNewEntry );
+
+        if ( isNewEntry ) {
+            new ( &this->getEntry( slotIndex ) ) TKey( key );
+        }
+
+        return isNewEntry;
+    }
+};
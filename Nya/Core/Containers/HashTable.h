@@ -0,0 +1,422 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <type_traits>
+#include <utility>
+#include <new>
+
+namespace nya
+{
+    namespace core
+    {
+        // Key hashing for HashTable (integer, enum and pointer keys)
+        // NOTE Keys are mixed again by the table (Fibonacci hashing), so identity is fine for string hashes
+        template<typename TKey, typename = void>
+        struct Hash;
+
+        template<typename TKey>
+        struct Hash<TKey, typename std::enable_if<std::is_integral<TKey>::value || std::is_enum<TKey>::value>::type>
+        {
+            uint64_t operator () ( const TKey key ) const
+            {
+                return static_cast<uint64_t>( key );
+            }
+        };
+
+        template<typename TKey>
+        struct Hash<TKey, typename std::enable_if<std::is_pointer<TKey>::value>::type>
+        {
+            uint64_t operator () ( const TKey key ) const
+            {
+                return static_cast<uint64_t>( reinterpret_cast<uintptr_t>( key ) );
+            }
+        };
+    }
+}
+
+// Open addressing hash table (linear probing, power of two capacity, backward shift deletion; no tombstones)
+// Storage is allocated from a BaseAllocator and grows once the load factor goes above 3/4
+// NOTE Inserting can move entries (iterators and references are invalidated); erasing only invalidates the erased entry and the
+// entries of the same probe sequence
+// Use HashMap or HashSet instead of this class
+template<typename TKey, typename TEntry, typename TGetKey>
+class HashTable
+{
+public:
+    static constexpr uint32_t MIN_CAPACITY = 8u;
+
+    template<typename TTable, typename TValue>
+    class Iterator
+    {
+    public:
+        Iterator( TTable* table, const uint32_t slotIndex )
+            : table( table )
+            , slotIndex( slotIndex )
+        {
+
+        }
+
+        TValue& operator * () const
+        {
+            return table->entries[slotIndex];
+        }
+
+        TValue* operator -> () const
+        {
+            return &table->entries[slotIndex];
+        }
+
+        Iterator& operator ++ ()
+        {
+            slotIndex = table->findOccupiedSlot( slotIndex + 1u );
+            return *this;
+        }
+
+        bool operator == ( const Iterator& iterator ) const
+        {
+            return slotIndex == iterator.slotIndex;
+        }
+
+        bool operator != ( const Iterator& iterator ) const
+        {
+            return slotIndex != iterator.slotIndex;
+        }
+
+    private:
+        friend class HashTable;
+
+        TTable*     table;
+        uint32_t    slotIndex;
+    };
+
+    using iterator = Iterator<HashTable, TEntry>;
+    using const_iterator = Iterator<const HashTable, const TEntry>;
+
+public:
+    HashTable()
+        : memoryAllocator( nullptr )
+        , entries( nullptr )
+        , isSlotOccupied( nullptr )
+        , capacity( 0u )
+        , capacityShift( 64u )
+        , entryCount( 0u )
+    {
+
+    }
+
+    HashTable( HashTable& ) = delete;
+    HashTable& operator = ( HashTable& ) = delete;
+
+    ~HashTable()
+    {
+        destroy();
+    }
+
+    void create( BaseAllocator* allocator, const uint32_t initialCapacity = MIN_CAPACITY )
+    {
+        memoryAllocator = allocator;
+
+        allocateSlots( getCapacityForEntryCount( initialCapacity ) );
+    }
+
+    void destroy()
+    {
+        clear();
+        freeSlots();
+
+        memoryAllocator = nullptr;
+    }
+
+    // Copy the entries of another table (reuses the allocated slots if they are large enough)
+    void copyFrom( const HashTable& table )
+    {
+        clear();
+        reserve( table.entryCount );
+
+        for ( const TEntry& entry : table ) {
+            new ( &entries[findInsertionSlot( TGetKey()( entry ) )] ) TEntry( entry );
+        }
+
+        entryCount = table.entryCount;
+    }
+
+    void clear()
+    {
+        for ( uint32_t slotIdx = 0u; slotIdx < capacity; slotIdx++ ) {
+            if ( isSlotOccupied[slotIdx] ) {
+                entries[slotIdx].~TEntry();
+                isSlotOccupied[slotIdx] = 0u;
+            }
+        }
+
+        entryCount = 0u;
+    }
+
+    // Grow the table so that reservedEntryCount entries can be stored without rehashing
+    void reserve( const uint32_t reservedEntryCount )
+    {
+        const uint32_t requiredCapacity = getCapacityForEntryCount( reservedEntryCount );
+
+        if ( requiredCapacity > capacity ) {
+            rehash( requiredCapacity );
+        }
+    }
+
+    iterator find( const TKey& key )
+    {
+        return iterator( this, findSlot( key ) );
+    }
+
+    const_iterator find( const TKey& key ) const
+    {
+        return const_iterator( this, findSlot( key ) );
+    }
+
+    bool contains( const TKey& key ) const
+    {
+        return findSlot( key ) != capacity;
+    }
+
+    void erase( const iterator& entryIterator )
+    {
+        eraseSlot( entryIterator.slotIndex );
+    }
+
+    // Return true if the key was found
+    bool erase( const TKey& key )
+    {
+        const uint32_t slotIndex = findSlot( key );
+
+        if ( slotIndex == capacity ) {
+            return false;
+        }
+
+        eraseSlot( slotIndex );
+        return true;
+    }
+
+    iterator begin()
+    {
+        return iterator( this, findOccupiedSlot( 0u ) );
+    }
+
+    iterator end()
+    {
+        return iterator( this, capacity );
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator( this, findOccupiedSlot( 0u ) );
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator( this, capacity );
+    }
+
+    uint32_t size() const
+    {
+        return entryCount;
+    }
+
+    bool empty() const
+    {
+        return entryCount == 0u;
+    }
+
+    uint32_t getCapacity() const
+    {
+        return capacity;
+    }
+
+protected:
+    // Return the slot of the entry; if the key is not in the table yet, a slot is reserved and the caller should construct the entry
+    uint32_t findOrInsertSlot( const TKey& key, bool& isNewEntry )
+    {
+        const uint32_t existingSlot = findSlot( key );
+        isNewEntry = ( existingSlot == capacity );
+
+        if ( !isNewEntry ) {
+            return existingSlot;
+        }
+
+        reserve( entryCount + 1u );
+
+        const uint32_t slotIndex = findInsertionSlot( key );
+        entryCount++;
+
+        return slotIndex;
+    }
+
+    TEntry& getEntry( const uint32_t slotIndex )
+    {
+        return entries[slotIndex];
+    }
+
+private:
+    BaseAllocator*  memoryAllocator;
+    TEntry*         entries;
+    uint8_t*        isSlotOccupied;
+    uint32_t        capacity;
+    uint32_t        capacityShift;
+    uint32_t        entryCount;
+
+private:
+    static uint32_t getCapacityForEntryCount( const uint32_t entryCount )
+    {
+        uint32_t requiredCapacity = MIN_CAPACITY;
+        while ( entryCount > requiredCapacity - ( requiredCapacity >> 2u ) ) {
+            requiredCapacity <<= 1u;
+        }
+
+        return requiredCapacity;
+    }
+
+    uint32_t getHomeSlot( const TKey& key ) const
+    {
+        // Fibonacci hashing (spreads sequential and aligned keys)
+        return static_cast<uint32_t>( ( nya::core::Hash<TKey>()( key ) * 11400714819323198485ull ) >> capacityShift );
+    }
+
+    uint32_t findSlot( const TKey& key ) const
+    {
+        if ( entryCount == 0u ) {
+            return capacity;
+        }
+
+        const uint32_t slotMask = ( capacity - 1u );
+
+        for ( uint32_t slotIndex = getHomeSlot( key ); isSlotOccupied[slotIndex]; slotIndex = ( slotIndex + 1u ) & slotMask ) {
+            if ( TGetKey()( entries[slotIndex] ) == key ) {
+                return slotIndex;
+            }
+        }
+
+        return capacity;
+    }
+
+    // Return the first free slot of the key probe sequence (the key should not be in the table)
+    uint32_t findInsertionSlot( const TKey& key )
+    {
+        const uint32_t slotMask = ( capacity - 1u );
+
+        uint32_t slotIndex = getHomeSlot( key );
+        while ( isSlotOccupied[slotIndex] ) {
+            slotIndex = ( slotIndex + 1u ) & slotMask;
+        }
+
+        isSlotOccupied[slotIndex] = 1u;
+
+        return slotIndex;
+    }
+
+    uint32_t findOccupiedSlot( uint32_t slotIndex ) const
+    {
+        while ( slotIndex < capacity && !isSlotOccupied[slotIndex] ) {
+            slotIndex++;
+        }
+
+        return slotIndex;
+    }
+
+    void eraseSlot( uint32_t slotIndex )
+    {
+        const uint32_t slotMask = ( capacity - 1u );
+
+        entries[slotIndex].~TEntry();
+        isSlotOccupied[slotIndex] = 0u;
+        entryCount--;
+
+        // Move back the following entries of the cluster which can't be reached anymore from their home slot
+        for ( uint32_t nextSlotIndex = ( slotIndex + 1u ) & slotMask; isSlotOccupied[nextSlotIndex]; nextSlotIndex = ( nextSlotIndex + 1u ) & slotMask ) {
+            const uint32_t homeSlot = getHomeSlot( TGetKey()( entries[nextSlotIndex] ) );
+
+            // Distance from the home slot (wrapped) tells whether the free slot is in between
+            if ( ( ( nextSlotIndex - homeSlot ) & slotMask ) < ( ( nextSlotIndex - slotIndex ) & slotMask ) ) {
+                continue;
+            }
+
+            new ( &entries[slotIndex] ) TEntry( std::move( entries[nextSlotIndex] ) );
+            isSlotOccupied[slotIndex] = 1u;
+
+            entries[nextSlotIndex].~TEntry();
+            isSlotOccupied[nextSlotIndex] = 0u;
+
+            slotIndex = nextSlotIndex;
+        }
+    }
+
+    void allocateSlots( const uint32_t slotCount )
+    {
+        NYA_DEV_ASSERT( memoryAllocator != nullptr, "HashTable has not been created (%u slots requested)", slotCount );
+
+        entries = static_cast<TEntry*>( memoryAllocator->allocate( sizeof( TEntry ) * slotCount, alignof( TEntry ) ) );
+        isSlotOccupied = static_cast<uint8_t*>( memoryAllocator->allocate( sizeof( uint8_t ) * slotCount ) );
+
+        for ( uint32_t slotIdx = 0u; slotIdx < slotCount; slotIdx++ ) {
+            isSlotOccupied[slotIdx] = 0u;
+        }
+
+        capacity = slotCount;
+
+        capacityShift = 64u;
+        for ( uint32_t slotCountPow2 = slotCount; slotCountPow2 > 1u; slotCountPow2 >>= 1u ) {
+            capacityShift--;
+        }
+    }
+
+    void freeSlots()
+    {
+        if ( entries != nullptr ) {
+            memoryAllocator->free( entries );
+            memoryAllocator->free( isSlotOccupied );
+        }
+
+        entries = nullptr;
+        isSlotOccupied = nullptr;
+        capacity = 0u;
+        capacityShift = 64u;
+    }
+
+    void rehash( const uint32_t newCapacity )
+    {
+        TEntry* previousEntries = entries;
+        uint8_t* previousSlotOccupancy = isSlotOccupied;
+        const uint32_t previousCapacity = capacity;
+
+        allocateSlots( newCapacity );
+
+        for ( uint32_t slotIdx = 0u; slotIdx < previousCapacity; slotIdx++ ) {
+            if ( previousSlotOccupancy[slotIdx] ) {
+                TEntry& entry = previousEntries[slotIdx];
+
+                new ( &entries[findInsertionSlot( TGetKey()( entry ) )] ) TEntry( std::move( entry ) );
+                entry.~TEntry();
+            }
+        }
+
+        if ( previousEntries != nullptr ) {
+            memoryAllocator->free( previousEntries );
+            memoryAllocator->free( previousSlotOccupancy );
+        }
+    }
+};
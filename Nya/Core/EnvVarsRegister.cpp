@@ -21,6 +21,7 @@
 #include "EnvVarsRegister.h"
 
 #include <Io/TextStreamHelpers.h>
+#include <Io/TextStreamReader.h>
 #include <Core/StringHelpers.h>
 
 // Not really nice, but this way we can control the initialization of global vars
@@ -170,48 +171,37 @@ void EnvironmentVariables::serialize( FileSystemObject* file )
 
 void EnvironmentVariables::deserialize( FileSystemObject* file )
 {
-    nyaString_t streamLine, dictionaryKey, dictionaryValue;
+    TextStreamReader streamReader( file );
+    TextToken streamLine, dictionaryKey, dictionaryValue;
+    nyaString_t value;
 
     NYA_CLOG << "Env vars deserialization started..." << std::endl;
 
-    while ( file->isGood() ) {
-        nya::core::ReadString( file, streamLine );
-
-        // Find seperator character offset in the line (if any)
-        const auto commentSeparator = streamLine.find_first_of( NYA_STRING( "#" ) );
-
+    while ( streamReader.readLine( streamLine ) ) {
         // Remove user comments before reading the keypair value
-        if ( commentSeparator != nyaString_t::npos ) {
-            streamLine.erase( streamLine.begin() + commentSeparator, streamLine.end() );
-        }
+        streamLine.end = streamLine.find( '#' );
 
         // Skip commented out and empty lines
         if ( streamLine.empty() ) {
             continue;
         }
 
-        const auto keyValueSeparator = streamLine.find_first_of( ':' );
-
         // Check if this is a key value line
-        if ( keyValueSeparator != nyaString_t::npos ) {
-            dictionaryKey = streamLine.substr( 0, keyValueSeparator );
-            dictionaryValue = streamLine.substr( keyValueSeparator + 1 );
-
+        if ( streamLine.split( ':', dictionaryKey, dictionaryValue ) ) {
             // Trim both key and values (useful if a file has inconsistent spacing, ...)
-            nya::core::TrimString( dictionaryKey );
-            nya::core::TrimString( dictionaryValue );
+            dictionaryKey = dictionaryKey.trim();
+            dictionaryValue = dictionaryValue.trim();
 
             // Do the check after triming, since the value might be a space or a tab character
             if ( !dictionaryValue.empty() ) {
-                auto keyHashcode = nya::core::CRC32( dictionaryKey.c_str() );
+                auto keyHashcode = dictionaryKey.hash();
                 auto variablesIterator = getEnvironmentVariableMap().find( keyHashcode );
 
                 if ( variablesIterator != getEnvironmentVariableMap().end() ) {
-                    auto variableInstance = getEnvironmentVariableMap().at( keyHashcode );
-
-                    readValue( variableInstance, dictionaryValue );
+                    dictionaryValue.toString( value );
+                    readValue( variablesIterator->second, value );
                 } else {
-                    NYA_CERR << "Unknown environment variable '" << dictionaryKey << "' (either spelling mistake or deprecated)" << std::endl;
+                    NYA_CERR << "Unknown environment variable '" << dictionaryKey.toString() << "' (either spelling mistake or deprecated)" << std::endl;
                 }
             }
         }
@@ -59,12 +59,39 @@ namespace
 
         return ~hashcode;
     }
+
+    template<typename T>
+    static uint32_t Core_CRC32Impl( const T* string, const std::size_t length )
+    {
+        unsigned int hashcode = ~0u;
+
+        for ( std::size_t i = 0; i < length; i++ ) {
+            hashcode ^= static_cast<unsigned int>( string[i] );
+
+            for ( int bitIdx = 0; bitIdx < 8; bitIdx++ ) {
+                hashcode = hashcode & 1 ? ( hashcode >> 1 ) ^ 0x82f63b78 : hashcode >> 1;
+            }
+        }
+
+        return ~hashcode;
+    }
 }
 
 namespace nya
 {
     namespace core
     {
+        static inline uint32_t CRC32( const char* string )
+        {
+            return Core_CRC32Impl( string );
+        }
+
+        // Hash of a string which is not null terminated (same hashcode as the null terminated string)
+        static inline uint32_t CRC32( const char* string, const std::size_t length )
+        {
+            return Core_CRC32Impl( string, length );
+        }
+
         static inline uint32_t CRC32( const std::string& string )
         {
             return Core_CRC32Impl( string.c_str() );
@@ -3,11 +3,27 @@
 #if NYA_DEVBUILD
 #include "Profiler.h"
 
+#include <vector>
+#include <mutex>
+
+struct OpenedSection
+{
+    uint32_t    SectionIndex;
+    uint32_t    FrameNumber;
+};
+
+// Sections opened by the calling thread (the innermost section is the last one)
+static thread_local std::vector<OpenedSection> g_OpenedSections;
+
 Profiler::Profiler()
-    : sectionSummaryString( "" )
+    : frameNumber( 0u )
+    , sectionSummaryString( "" )
     , sectionsResult{ -1.0 }
     , sectionsName{ "" }
     , sectionCount( 0 )
+    , statsValue{ 0.0 }
+    , statsName{ "" }
+    , statCount( 0 )
 {
     std::fill_n( sectionsResult, MAX_PROFILE_SECTION_COUNT, -1.0 );
 }
@@ -19,6 +35,8 @@ Profiler::~Profiler()
 
 void Profiler::onFrame()
 {
+    std::lock_guard<SpinLock> lock( profilerLock );
+
     sectionSummaryString.clear();
 
     for ( unsigned int sectionIdx = 0; sectionIdx < sectionCount; sectionIdx++ ) {
@@ -27,11 +45,23 @@ void Profiler::onFrame()
         sectionSummaryString.append( std::to_string( sectionsResult[sectionIdx] ) + "ms\n" );
     }
 
+    for ( unsigned int statIdx = 0; statIdx < statCount; statIdx++ ) {
+        sectionSummaryString.append( statsName[statIdx] );
+        sectionSummaryString.append( "  " );
+        sectionSummaryString.append( std::to_string( statsValue[statIdx] ) + "\n" );
+    }
+
     sectionCount = 0;
+    statCount = 0;
+
+    // Sections still opened belong to the previous frame and are discarded once closed
+    frameNumber++;
 }
 
 void Profiler::beginSection( const std::string& sectionName )
 {
+    std::lock_guard<SpinLock> lock( profilerLock );
+
     if ( sectionCount >= MAX_PROFILE_SECTION_COUNT ) {
         return;
     }
@@ -42,25 +72,49 @@ void Profiler::beginSection( const std::string& sectionName )
     nya::core::StartTimer( &sectionsTimer[sectionIdx] );
     sectionsName[sectionIdx].clear();
 
-    for ( size_t depth = 0; depth < recordedSectionIndexes.size(); depth++ ) {
+    for ( size_t depth = 0; depth < g_OpenedSections.size(); depth++ ) {
         sectionsName[sectionIdx] += "\t";
     }
     sectionsName[sectionIdx] += sectionName;
 
     sectionCount++;
-    recordedSectionIndexes.push_back( sectionIdx );
+    g_OpenedSections.push_back( { sectionIdx, frameNumber } );
 }
 
 void Profiler::endSection()
 {
-    if ( recordedSectionIndexes.empty() ) {
+    std::lock_guard<SpinLock> lock( profilerLock );
+
+    if ( g_OpenedSections.empty() ) {
         return;
     }
 
-    auto latestSectionIdx = recordedSectionIndexes.back();
-    sectionsResult[latestSectionIdx] = nya::core::GetTimerDeltaAsMiliseconds( &sectionsTimer[latestSectionIdx] );
+    const OpenedSection latestSection = g_OpenedSections.back();
+    if ( latestSection.FrameNumber == frameNumber ) {
+        sectionsResult[latestSection.SectionIndex] = nya::core::GetTimerDeltaAsMiliseconds( &sectionsTimer[latestSection.SectionIndex] );
+    }
+
+    g_OpenedSections.pop_back();
+}
+
+void Profiler::setStat( const std::string& statName, const double statValue )
+{
+    std::lock_guard<SpinLock> lock( profilerLock );
+
+    for ( unsigned int statIdx = 0; statIdx < statCount; statIdx++ ) {
+        if ( statsName[statIdx] == statName ) {
+            statsValue[statIdx] = statValue;
+            return;
+        }
+    }
+
+    if ( statCount >= MAX_PROFILE_STAT_COUNT ) {
+        return;
+    }
 
-    recordedSectionIndexes.pop_back();
+    statsName[statCount] = statName;
+    statsValue[statCount] = statValue;
+    statCount++;
 }
 
 const double* Profiler::getSectionResultArray() const
@@ -2,8 +2,7 @@
 
 #if NYA_DEVBUILD
 #include "Timer.h"
-
-#include <list>
+#include "Threading/SpinLock.h"
 
 class Profiler
 {
@@ -18,14 +17,20 @@ public:
     void                        beginSection( const std::string& sectionName );
     void                        endSection();
 
+    // Per-frame statistic (displayed after the sections in the summary string; reset every frame)
+    void                        setStat( const std::string& statName, const double statValue );
+
     const double*               getSectionResultArray() const;
     const std::string&          getProfilingSummaryString() const;
 
 private:
     static constexpr int        MAX_PROFILE_SECTION_COUNT = 128;
+    static constexpr int        MAX_PROFILE_STAT_COUNT = 64;
 
 private:
-    std::list<uint32_t>         recordedSectionIndexes;
+    // NOTE Sections and stats can be recorded from any thread (opened sections are tracked per thread)
+    SpinLock                    profilerLock;
+    uint32_t                    frameNumber;
 
     std::string                 sectionSummaryString;
 
@@ -34,6 +39,11 @@ private:
     std::string                 sectionsName[MAX_PROFILE_SECTION_COUNT];
 
     unsigned int                sectionCount;
+
+    double                      statsValue[MAX_PROFILE_STAT_COUNT];
+    std::string                 statsName[MAX_PROFILE_STAT_COUNT];
+
+    unsigned int                statCount;
 };
 
 extern Profiler                 g_Profiler;
@@ -56,8 +66,11 @@ struct ProfileSection
 // Use NYA_PROFILE for automatic scope-based profiling
 #define NYA_BEGIN_PROFILE_SCOPE( section ) g_Profiler.beginSection( section );
 #define NYA_END_PROFILE_SCOPE() g_Profiler.endSection();
+
+#define NYA_PROFILE_STAT( stat, value ) g_Profiler.setStat( stat, static_cast<double>( value ) );
 #else
 #define NYA_PROFILE( section )
 #define NYA_BEGIN_PROFILE_SCOPE( section )
 #define NYA_END_PROFILE_SCOPE( section )
+#define NYA_PROFILE_STAT( stat, value )
 #endif
@@ -47,13 +47,33 @@ fnSIMDVecf_t nya::simd::MulAdd( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& v2,
     return _mm_add_ps( _mm_mul_ps( v1, v2 ), v3 );
 }
 
+fnSIMDVecf_t nya::simd::Min( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& v2 )
+{
+    return _mm_min_ps( v1, v2 );
+}
+
+fnSIMDVecf_t nya::simd::Max( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& v2 )
+{
+    return _mm_max_ps( v1, v2 );
+}
+
 fnSIMDVecf_t nya::simd::CompareGreaterMask( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& mask )
 {
     return _mm_cmpgt_ps( v1, mask );
 }
 
+fnSIMDVecf_t nya::simd::CompareLessMask( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& mask )
+{
+    return _mm_cmplt_ps( v1, mask );
+}
+
 fnSIMDVecf_t nya::simd::OrMask( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& mask )
 {
     return _mm_or_ps( v1, mask );
 }
+
+int nya::simd::MoveMask( const fnSIMDVecf_t& v )
+{
+    return _mm_movemask_ps( v );
+}
 #endif
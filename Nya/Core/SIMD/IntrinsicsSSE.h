@@ -30,10 +30,16 @@ namespace nya
         fnSIMDVecf_t Sub( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& v2 );
         fnSIMDVecf_t Mul( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& v2 );
         fnSIMDVecf_t MulAdd( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& v2, const fnSIMDVecf_t& v3 );
+        fnSIMDVecf_t Min( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& v2 );
+        fnSIMDVecf_t Max( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& v2 );
 
         fnSIMDVecf_t CompareGreaterMask( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& mask );
+        fnSIMDVecf_t CompareLessMask( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& mask );
         fnSIMDVecf_t OrMask( const fnSIMDVecf_t& v1, const fnSIMDVecf_t& mask );
 
+        // Returns the sign bit of each component packed in the 4 lowest bits
+        int          MoveMask( const fnSIMDVecf_t& v );
+
         template<eVectorMask mask>
         fnSIMDVecf_t Splat( const fnSIMDVecf_t& v )
         {
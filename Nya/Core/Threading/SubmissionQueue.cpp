@@ -0,0 +1,51 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "SubmissionQueue.h"
+
+#include <atomic>
+
+static constexpr uint32_t INVALID_SUBMISSION_THREAD_INDEX = ~0u;
+
+static thread_local uint32_t g_SubmissionThreadIndex = INVALID_SUBMISSION_THREAD_INDEX;
+
+// Indexes assigned on first use are allocated from the end of the range (explicit indexes are expected to be small)
+static std::atomic<uint32_t> g_AssignedSubmissionThreadCount( 0u );
+
+void nya::core::SetSubmissionThreadIndex( const uint32_t threadIndex )
+{
+    NYA_DEV_ASSERT( threadIndex < MAX_SUBMISSION_THREAD_COUNT, "Submission thread index out of bounds (%u >= %u)", threadIndex, MAX_SUBMISSION_THREAD_COUNT );
+
+    g_SubmissionThreadIndex = threadIndex;
+}
+
+uint32_t nya::core::GetSubmissionThreadIndex()
+{
+    if ( g_SubmissionThreadIndex == INVALID_SUBMISSION_THREAD_INDEX ) {
+        const uint32_t assignedThreadCount = g_AssignedSubmissionThreadCount.fetch_add( 1u, std::memory_order_relaxed );
+
+        NYA_DEV_ASSERT( assignedThreadCount < MAX_SUBMISSION_THREAD_COUNT - 1u, "Too many submission threads (%u); call SetSubmissionThreadIndex explicitly", assignedThreadCount + 1u );
+
+        // The index is kept for the lifetime of the thread (the merge order stays the same from one frame to the next)
+        g_SubmissionThreadIndex = ( assignedThreadCount < MAX_SUBMISSION_THREAD_COUNT - 1u ) ? ( MAX_SUBMISSION_THREAD_COUNT - 1u - assignedThreadCount ) : ( MAX_SUBMISSION_THREAD_COUNT - 1u );
+    }
+
+    return g_SubmissionThreadIndex;
+}
@@ -0,0 +1,170 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <atomic>
+#include <type_traits>
+#include <new>
+
+namespace nya
+{
+    namespace core
+    {
+        // Max number of threads allowed to push to a SubmissionQueue concurrently
+        static constexpr uint32_t MAX_SUBMISSION_THREAD_COUNT = 16u;
+
+        // Set the submission index of the calling thread (0 is reserved to the main thread)
+        // Threads which never call this function get a unique index on first use (allocated from MAX_SUBMISSION_THREAD_COUNT - 1
+        // downward); set indexes explicitly to keep the merge order the same from one run to the next
+        void        SetSubmissionThreadIndex( const uint32_t threadIndex );
+        uint32_t    GetSubmissionThreadIndex();
+    }
+}
+
+// Multi-producer bump allocated queue
+// Entries are allocated with an atomic increment (no lock); merge() then builds a deterministic
+// iteration order (entries are sorted by producer index, then by submission order for a given producer)
+// NOTE merge(), clear() and the accessors are NOT thread safe and should be called once submission is over
+template<typename T>
+class SubmissionQueue
+{
+public:
+    SubmissionQueue()
+        : entries( nullptr )
+        , producerIndexes( nullptr )
+        , mergedOrder( nullptr )
+        , capacity( 0u )
+        , entryCount( 0u )
+    {
+        allocationCount.store( 0u, std::memory_order_relaxed );
+    }
+
+    SubmissionQueue( SubmissionQueue& ) = delete;
+    SubmissionQueue& operator = ( SubmissionQueue& ) = delete;
+
+    ~SubmissionQueue()
+    {
+        entries = nullptr;
+        producerIndexes = nullptr;
+        mergedOrder = nullptr;
+        capacity = 0u;
+        entryCount = 0u;
+    }
+
+    void create( BaseAllocator* allocator, const uint32_t queueCapacity )
+    {
+        capacity = queueCapacity;
+
+        entries = static_cast<T*>( allocator->allocate( sizeof( T ) * queueCapacity, alignof( T ) ) );
+        producerIndexes = static_cast<uint8_t*>( allocator->allocate( sizeof( uint8_t ) * queueCapacity ) );
+        mergedOrder = static_cast<uint32_t*>( allocator->allocate( sizeof( uint32_t ) * queueCapacity ) );
+    }
+
+    void destroy( BaseAllocator* allocator )
+    {
+        clear();
+
+        allocator->free( entries );
+        allocator->free( producerIndexes );
+        allocator->free( mergedOrder );
+
+        entries = nullptr;
+        producerIndexes = nullptr;
+        mergedOrder = nullptr;
+        capacity = 0u;
+    }
+
+    // Thread safe; returns nullptr if the queue is full
+    T* push()
+    {
+        const uint32_t entryIndex = allocationCount.fetch_add( 1u, std::memory_order_relaxed );
+
+        if ( entryIndex >= capacity ) {
+            return nullptr;
+        }
+
+        producerIndexes[entryIndex] = static_cast<uint8_t>( nya::core::GetSubmissionThreadIndex() );
+
+        return new ( &entries[entryIndex] ) T();
+    }
+
+    // Counting sort on producer indexes (stable, so per-producer submission order is kept)
+    void merge()
+    {
+        entryCount = getAllocatedEntryCount();
+
+        uint32_t histogram[nya::core::MAX_SUBMISSION_THREAD_COUNT] = { 0u };
+        for ( uint32_t i = 0u; i < entryCount; i++ ) {
+            histogram[producerIndexes[i]]++;
+        }
+
+        uint32_t offset = 0u;
+        for ( uint32_t i = 0u; i < nya::core::MAX_SUBMISSION_THREAD_COUNT; i++ ) {
+            const uint32_t count = histogram[i];
+            histogram[i] = offset;
+            offset += count;
+        }
+
+        for ( uint32_t i = 0u; i < entryCount; i++ ) {
+            mergedOrder[histogram[producerIndexes[i]]++] = i;
+        }
+    }
+
+    void clear()
+    {
+        const uint32_t allocatedEntryCount = getAllocatedEntryCount();
+
+        if ( !std::is_trivially_destructible<T>::value ) {
+            for ( uint32_t i = 0u; i < allocatedEntryCount; i++ ) {
+                entries[i].~T();
+            }
+        }
+
+        entryCount = 0u;
+        allocationCount.store( 0u, std::memory_order_relaxed );
+    }
+
+    // Merged entry count (valid after a call to merge())
+    uint32_t getEntryCount() const
+    {
+        return entryCount;
+    }
+
+    // Retrieve an entry using the merged order (valid after a call to merge())
+    T& operator [] ( const uint32_t mergedIndex )
+    {
+        return entries[mergedOrder[mergedIndex]];
+    }
+
+private:
+    T*                      entries;
+    uint8_t*                producerIndexes;
+    uint32_t*               mergedOrder;
+    uint32_t                capacity;
+    uint32_t                entryCount;
+    std::atomic<uint32_t>   allocationCount;
+
+private:
+    uint32_t getAllocatedEntryCount() const
+    {
+        const uint32_t allocatedEntryCount = allocationCount.load( std::memory_order_acquire );
+        return ( allocatedEntryCount > capacity ) ? capacity : allocatedEntryCount;
+    }
+};
@@ -0,0 +1,438 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "AsyncIOQueue.h"
+
+#include "FileSystem.h"
+#include "FileSystemObject.h"
+#include "IoUring.h"
+
+#if NYA_UNIX
+#include "FileSystemUnix.h"
+#elif NYA_WIN
+#include "FileSystemWin32.h"
+#endif
+
+#include <Core/EnvVarsRegister.h>
+#include <Maths/Helpers.h>
+
+#if NYA_IO_URING
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+
+using namespace nya::core;
+
+NYA_ENV_VAR( AsyncIOWorkerCount, 2, uint32_t ) // "Number of threads serving asynchronous reads (reads of native files are submitted to io_uring if available) [1..8]"
+NYA_ENV_VAR( UseIoUring, true, bool ) // "Submit asynchronous reads of native files to io_uring (Linux only; workers are used if io_uring is not available)"
+
+static constexpr uint32_t IO_URING_BATCH_SIZE = 64u;
+static constexpr uint64_t IO_URING_MAX_READ_SIZE = ( 1ull << 30 ); // Reads are split in chunks (io_uring read sizes are 32 bits)
+
+bool AsyncIOQueue::RequestQueue::empty() const
+{
+    for ( const std::deque<ReadRequest>& priorityRequests : requests ) {
+        if ( !priorityRequests.empty() ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void AsyncIOQueue::RequestQueue::pop( std::vector<ReadRequest>& batch, const uint32_t maxCount )
+{
+    for ( std::deque<ReadRequest>& priorityRequests : requests ) {
+        while ( !priorityRequests.empty() && batch.size() < maxCount ) {
+            batch.push_back( std::move( priorityRequests.front() ) );
+            priorityRequests.pop_front();
+        }
+    }
+}
+
+AsyncIOQueue::AsyncIOQueue()
+    : ioUring( nullptr )
+    , inFlightRequestCount( 0u )
+    , isStarted( false )
+    , stopRequested( false )
+{
+
+}
+
+AsyncIOQueue::~AsyncIOQueue()
+{
+    flush();
+    stop();
+}
+
+void AsyncIOQueue::push( ReadRequest&& request, const eIoPriority priority )
+{
+    NYA_DEV_ASSERT( priority < IO_PRIORITY_COUNT, "Invalid I/O priority (%u)", priority );
+
+    {
+        std::lock_guard<std::mutex> lock( queueLock );
+
+        if ( !isStarted ) {
+            start();
+        }
+
+        RequestQueue& queue = ( ioUring != nullptr && request.media->hasNativeFilenames() ) ? nativeRequests : pendingRequests;
+        queue.requests[priority].push_back( std::move( request ) );
+
+        inFlightRequestCount++;
+    }
+
+    requestPushedEvent.notify_all();
+}
+
+void AsyncIOQueue::flush()
+{
+    std::unique_lock<std::mutex> lock( queueLock );
+    requestsCompletedEvent.wait( lock, [&]() { return inFlightRequestCount == 0u; } );
+}
+
+uint32_t AsyncIOQueue::getInFlightRequestCount()
+{
+    std::lock_guard<std::mutex> lock( queueLock );
+    return inFlightRequestCount;
+}
+
+bool AsyncIOQueue::isUsingIoUring()
+{
+    std::lock_guard<std::mutex> lock( queueLock );
+    return ioUring != nullptr;
+}
+
+void AsyncIOQueue::start()
+{
+#if NYA_IO_URING
+    if ( UseIoUring ) {
+        ioUring = new IoUring();
+
+        if ( ioUring->create( IO_URING_BATCH_SIZE ) ) {
+            ioUringThread = std::thread( &AsyncIOQueue::ioUringLoop, this );
+        } else {
+            NYA_CWARN << "io_uring is not available (asynchronous reads are served by the workers)" << std::endl;
+
+            delete ioUring;
+            ioUring = nullptr;
+        }
+    }
+#endif
+
+    const uint32_t workerCount = nya::maths::clamp( AsyncIOWorkerCount, 1u, 8u );
+    for ( uint32_t workerIdx = 0u; workerIdx < workerCount; workerIdx++ ) {
+        workers.push_back( std::thread( &AsyncIOQueue::workerLoop, this ) );
+    }
+
+    isStarted = true;
+}
+
+void AsyncIOQueue::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock( queueLock );
+        stopRequested = true;
+    }
+
+    requestPushedEvent.notify_all();
+
+    for ( std::thread& worker : workers ) {
+        worker.join();
+    }
+
+    workers.clear();
+
+    if ( ioUringThread.joinable() ) {
+        ioUringThread.join();
+    }
+
+#if NYA_IO_URING
+    delete ioUring;
+    ioUring = nullptr;
+#endif
+}
+
+void AsyncIOQueue::completeRequests( const uint32_t requestCount )
+{
+    {
+        std::lock_guard<std::mutex> lock( queueLock );
+        inFlightRequestCount -= requestCount;
+    }
+
+    requestsCompletedEvent.notify_all();
+}
+
+void AsyncIOQueue::workerLoop()
+{
+    std::vector<ReadRequest> batch;
+
+    while ( true ) {
+        {
+            std::unique_lock<std::mutex> lock( queueLock );
+            requestPushedEvent.wait( lock, [&]() { return stopRequested || !pendingRequests.empty(); } );
+
+            if ( pendingRequests.empty() ) {
+                return;
+            }
+
+            pendingRequests.pop( batch, 1u );
+        }
+
+        ReadRequest& request = batch.front();
+
+        bool isSuccessful = false;
+        uint64_t readSize = 0ull;
+
+        if ( request.media->hasNativeFilenames() ) {
+            isSuccessful = ReadFileImpl( request.filename, request.offset, request.size, request.destination, readSize );
+        } else {
+            FileSystemObject* file = request.media->openFile( request.filename, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY );
+
+            if ( file != nullptr ) {
+                const uint64_t fileSize = file->getSize();
+
+                if ( request.offset < fileSize ) {
+                    readSize = nya::maths::min( request.size, fileSize - request.offset );
+
+                    file->seek( request.offset, eFileReadDirection::FILE_READ_DIRECTION_BEGIN );
+                    file->read( request.destination, readSize );
+                }
+
+                file->close();
+                isSuccessful = true;
+            }
+        }
+
+        if ( request.callback ) {
+            request.callback( isSuccessful, readSize );
+        }
+
+        batch.clear();
+        completeRequests( 1u );
+    }
+}
+
+void AsyncIOQueue::ioUringLoop()
+{
+#if NYA_IO_URING
+    struct InFlightRead
+    {
+        int         fileDescriptor;
+        uint64_t    readSize;
+        bool        isDone;
+        bool        isSuccessful;
+    };
+
+    const uint32_t batchSize = nya::maths::min( IO_URING_BATCH_SIZE, ioUring->getEntryCount() );
+
+    std::vector<ReadRequest> batch;
+    std::vector<InFlightRead> inFlightReads;
+
+    batch.reserve( batchSize );
+    inFlightReads.reserve( batchSize );
+
+    // Queue the next chunk of a read; reads are done once the whole size has been read or the end of the file is reached
+    auto pushNextChunk = [&]( const uint32_t readIndex ) {
+        const ReadRequest& request = batch[readIndex];
+        InFlightRead& inFlightRead = inFlightReads[readIndex];
+
+        const uint64_t chunkSize = nya::maths::min( request.size - inFlightRead.readSize, IO_URING_MAX_READ_SIZE );
+
+        // Every read of the batch has a single chunk in flight (the submission queue can't be full)
+        ioUring->pushRead( inFlightRead.fileDescriptor, request.destination + inFlightRead.readSize, static_cast<uint32_t>( chunkSize ), request.offset + inFlightRead.readSize, readIndex );
+    };
+
+    // Account a chunk completion; returns true if the read needs another chunk
+    auto onChunkCompleted = [&]( const uint64_t readIndex, const int32_t result ) {
+        InFlightRead& inFlightRead = inFlightReads[readIndex];
+
+        if ( result == -EINTR || result == -EAGAIN ) {
+            return true;
+        }
+
+        if ( result > 0 ) {
+            inFlightRead.readSize += static_cast<uint64_t>( result );
+
+            if ( inFlightRead.readSize < batch[readIndex].size ) {
+                return true;
+            }
+        }
+
+        // Done (error, end of file or whole size read)
+        inFlightRead.isDone = true;
+        inFlightRead.isSuccessful = ( result >= 0 );
+
+        return false;
+    };
+
+    while ( true ) {
+        {
+            std::unique_lock<std::mutex> lock( queueLock );
+            requestPushedEvent.wait( lock, [&]() { return stopRequested || !nativeRequests.empty(); } );
+
+            if ( nativeRequests.empty() ) {
+                return;
+            }
+
+            nativeRequests.pop( batch, batchSize );
+        }
+
+        // Group reads of the same file (a file is opened once per batch) and sort them by offset (helps the kernel readahead)
+        std::stable_sort( batch.begin(), batch.end(), []( const ReadRequest& lRequest, const ReadRequest& rRequest ) {
+            return ( lRequest.filename < rRequest.filename ) || ( lRequest.filename == rRequest.filename && lRequest.offset < rRequest.offset );
+        } );
+
+        uint32_t inFlightReadCount = 0u;
+        for ( uint32_t readIdx = 0u; readIdx < batch.size(); readIdx++ ) {
+            const ReadRequest& request = batch[readIdx];
+
+            const bool isSameFile = ( readIdx > 0u && batch[readIdx - 1u].filename == request.filename );
+            const int fileDescriptor = ( isSameFile ) ? inFlightReads[readIdx - 1u].fileDescriptor : open( request.filename.c_str(), O_RDONLY );
+
+            inFlightReads.push_back( { fileDescriptor, 0ull, false, false } );
+
+            if ( fileDescriptor == -1 ) {
+                inFlightReads.back().isDone = true;
+            } else if ( request.size == 0ull ) {
+                inFlightReads.back().isDone = true;
+                inFlightReads.back().isSuccessful = true;
+            } else {
+                pushNextChunk( readIdx );
+                inFlightReadCount++;
+            }
+        }
+
+        bool isRingBroken = false;
+        while ( inFlightReadCount > 0u ) {
+            if ( !ioUring->submitAndWait( 1u ) ) {
+                NYA_CERR << "io_uring submission failed (errno: " << errno << "); asynchronous reads are now served by the workers" << std::endl;
+                isRingBroken = true;
+                break;
+            }
+
+            uint64_t readIndex = 0ull;
+            int32_t result = 0;
+            while ( ioUring->popCompletion( readIndex, result ) ) {
+                if ( onChunkCompleted( readIndex, result ) ) {
+                    pushNextChunk( static_cast<uint32_t>( readIndex ) );
+                } else {
+                    inFlightReadCount--;
+                }
+            }
+        }
+
+        if ( isRingBroken ) {
+            // Chunks which have not reached the kernel are withdrawn; the submitted ones might still write to their destination, so
+            // wait for their completions before the requests are handed to the workers (or their callbacks are called)
+            std::vector<uint64_t> cancelledReads;
+            ioUring->cancelPendingSubmissions( cancelledReads );
+            inFlightReadCount -= static_cast<uint32_t>( cancelledReads.size() );
+
+            while ( inFlightReadCount > 0u ) {
+                uint64_t readIndex = 0ull;
+                int32_t result = 0;
+                if ( !ioUring->popCompletion( readIndex, result ) ) {
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                    continue;
+                }
+
+                onChunkCompleted( readIndex, result );
+                inFlightReadCount--;
+            }
+        }
+
+        // Reads left unfinished by a broken ring; the remaining part of each read is served by the workers
+        std::vector<ReadRequest> remainingReads;
+
+        for ( uint32_t readIdx = 0u; readIdx < batch.size(); readIdx++ ) {
+            const InFlightRead& inFlightRead = inFlightReads[readIdx];
+
+            const bool isLastReadOfFile = ( readIdx + 1u == batch.size() || batch[readIdx + 1u].filename != batch[readIdx].filename );
+            if ( isLastReadOfFile && inFlightRead.fileDescriptor != -1 ) {
+                close( inFlightRead.fileDescriptor );
+            }
+
+            if ( !inFlightRead.isDone ) {
+                ReadRequest& request = batch[readIdx];
+                const uint64_t readSize = inFlightRead.readSize;
+
+                nyaAsyncReadCallback_t callback = std::move( request.callback );
+                if ( callback ) {
+                    request.callback = [callback, readSize]( const bool isSuccessful, const uint64_t remainingReadSize ) {
+                        callback( isSuccessful, readSize + remainingReadSize );
+                    };
+                }
+
+                request.offset += readSize;
+                request.size -= readSize;
+                request.destination += readSize;
+
+                remainingReads.push_back( std::move( request ) );
+                continue;
+            }
+
+            if ( batch[readIdx].callback ) {
+                batch[readIdx].callback( inFlightRead.isSuccessful, inFlightRead.readSize );
+            }
+        }
+
+        const uint32_t completedRequestCount = static_cast<uint32_t>( batch.size() - remainingReads.size() );
+
+        batch.clear();
+        inFlightReads.clear();
+
+        if ( isRingBroken ) {
+            // Stop using the ring: requests left in the native queue (and the next pushes) go to the workers
+            {
+                std::lock_guard<std::mutex> lock( queueLock );
+
+                // Unfinished reads have already been waiting; serve them first
+                for ( ReadRequest& request : remainingReads ) {
+                    pendingRequests.requests[IO_PRIORITY_HIGH].push_back( std::move( request ) );
+                }
+
+                for ( uint32_t priority = 0u; priority < IO_PRIORITY_COUNT; priority++ ) {
+                    std::deque<ReadRequest>& nativePriorityRequests = nativeRequests.requests[priority];
+
+                    for ( ReadRequest& request : nativePriorityRequests ) {
+                        pendingRequests.requests[priority].push_back( std::move( request ) );
+                    }
+
+                    nativePriorityRequests.clear();
+                }
+
+                delete ioUring;
+                ioUring = nullptr;
+            }
+
+            requestPushedEvent.notify_all();
+            completeRequests( completedRequestCount );
+            return;
+        }
+
+        completeRequests( completedRequestCount );
+    }
+#endif
+}
@@ -0,0 +1,115 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+class FileSystem;
+class IoUring;
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace nya
+{
+    namespace core
+    {
+        enum eIoPriority : uint32_t
+        {
+            IO_PRIORITY_HIGH = 0, // Needed as soon as possible (e.g. data blocking a frame)
+            IO_PRIORITY_NORMAL,
+            IO_PRIORITY_LOW, // Prefetching (only served once there is no request of higher priority left)
+
+            IO_PRIORITY_COUNT
+        };
+    }
+}
+
+// Called from an I/O thread once the read is done (readSize is lower than the requested size if the end of the file was reached)
+using nyaAsyncReadCallback_t = std::function<void( const bool isSuccessful, const uint64_t readSize )>;
+
+// Asynchronous reads, served by priority (FIFO for requests of the same priority)
+// Reads of native files are batched and submitted to io_uring (Linux); other reads (or every read if io_uring is not available) are
+// served by a pool of worker threads
+class AsyncIOQueue
+{
+public:
+    struct ReadRequest
+    {
+        FileSystem*             media;
+        nyaString_t             filename; // Resolved by the media
+        uint64_t                offset;
+        uint64_t                size;
+        uint8_t*                destination; // Should stay valid until the callback is called
+        nyaAsyncReadCallback_t  callback;
+    };
+
+public:
+                                AsyncIOQueue();
+                                AsyncIOQueue( AsyncIOQueue& ) = delete;
+                                AsyncIOQueue& operator = ( AsyncIOQueue& ) = delete;
+                                ~AsyncIOQueue();
+
+    // Threads are started on the first push
+    void                        push( ReadRequest&& request, const nya::core::eIoPriority priority );
+
+    // Block until every pushed request has completed
+    void                        flush();
+
+    uint32_t                    getInFlightRequestCount();
+    bool                        isUsingIoUring();
+
+private:
+    struct RequestQueue
+    {
+        std::deque<ReadRequest> requests[nya::core::IO_PRIORITY_COUNT];
+
+        bool                    empty() const;
+
+        // Append up to maxCount requests to the batch (highest priority first)
+        void                    pop( std::vector<ReadRequest>& batch, const uint32_t maxCount );
+    };
+
+private:
+    std::mutex                  queueLock;
+    std::condition_variable     requestPushedEvent;
+    std::condition_variable     requestsCompletedEvent;
+
+    RequestQueue                nativeRequests; // Served by the io_uring thread
+    RequestQueue                pendingRequests; // Served by the workers
+
+    std::vector<std::thread>    workers;
+    std::thread                 ioUringThread;
+    IoUring*                    ioUring;
+
+    uint32_t                    inFlightRequestCount;
+    bool                        isStarted;
+    bool                        stopRequested;
+
+private:
+    void                        start();
+    void                        stop();
+    void                        completeRequests( const uint32_t requestCount );
+
+    void                        workerLoop();
+    void                        ioUringLoop();
+};
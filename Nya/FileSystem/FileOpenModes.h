@@ -32,6 +32,10 @@ namespace nya
             FILE_OPEN_MODE_APPEND = 8,
             FILE_OPEN_MODE_TRUNCATE = 16,
             FILE_OPEN_MODE_START_FROM_END = 32,
+
+            // Read-only; the content can be read in place with FileSystemObject::map() (the media falls back to a regular stream
+            // if the file can't be mapped)
+            FILE_OPEN_MODE_MEMORY_MAPPED = 64,
         };
     }
 }
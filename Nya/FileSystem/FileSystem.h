@@ -21,6 +21,8 @@
 
 #include "FileOpenModes.h"
 
+#include <vector>
+
 class FileSystemObject;
 
 class FileSystem
@@ -33,4 +35,18 @@ public:
     virtual bool                fileExists( const nyaString_t& filename ) = 0;
     virtual bool                isReadOnly() = 0;
     virtual nyaString_t          resolveFilename( const nyaString_t& mountPoint, const nyaString_t& filename ) = 0;
+
+    // Return true if resolved filenames are native paths (files can then be read with the OS APIs; see AsyncIOQueue)
+    virtual bool                hasNativeFilenames() { return false; }
+
+    // Append the files of a folder and its subfolders (paths are relative to the folder and use '/' as separator)
+    // Return false if the folder does not exist
+    virtual bool                listFolder( const nyaString_t& folderName, std::vector<nyaString_t>& filenames ) { return false; }
+
+    // Drop the informations cached for a file (existence, folder listings); called when the file is modified outside of the media
+    virtual void                invalidateCachedFile( const nyaString_t& filename ) { }
+
+    // Enable the caching of the OS queries (only safe if external changes are reported with invalidateCachedFile)
+    // Disabling the caching drops every cached information
+    virtual void                setQueryCachingEnabled( const bool isEnabled ) { }
 };
@@ -21,6 +21,7 @@
 #include "FileSystemNative.h"
 
 #include "FileSystemObjectNative.h"
+#include "FileSystemObjectMapped.h"
 
 #if NYA_UNIX
 #include "FileSystemUnix.h"
@@ -30,9 +31,17 @@
 
 #include <Core/Environment.h>
 
+#include <algorithm>
+
 using namespace nya::core;
 
 FileSystemNative::FileSystemNative( const nyaString_t& customWorkingDirectory )
+    : cacheGeneration( 0u )
+#if NYA_DEVBUILD
+    , isQueryCachingEnabled( false )
+#else
+    , isQueryCachingEnabled( true )
+#endif
 {
     if ( customWorkingDirectory.empty() ) {
         RetrieveWorkingDirectory( workingDirectory );
@@ -49,14 +58,18 @@ FileSystemNative::~FileSystemNative()
 {
     workingDirectory.clear();
 
-    while ( !openedFiles.empty() ) {
-        auto& openedFile = openedFiles.back();
+    for ( auto& openedFile : openedFiles ) {
         // TODO Fucks up the CRT at closing; probably due to some race condition or poor thread sync...
-        //openedFile->close();
-        delete openedFile;
+        //openedFile.second->close();
+        delete openedFile.second;
+    }
 
-        openedFiles.pop_back();
+    for ( auto& mappedFile : mappedFiles ) {
+        delete mappedFile.second;
     }
+
+    openedFiles.clear();
+    mappedFiles.clear();
 }
 
 FileSystemObject* FileSystemNative::openFile( const nyaString_t& filename, const int32_t mode )
@@ -67,6 +80,15 @@ FileSystemObject* FileSystemNative::openFile( const nyaString_t& filename, const
         return nullptr;
     }
 
+    if ( ( mode & eFileOpenMode::FILE_OPEN_MODE_MEMORY_MAPPED ) == eFileOpenMode::FILE_OPEN_MODE_MEMORY_MAPPED && !useWriteMode ) {
+        FileSystemObject* mappedFile = openMappedFile( filename );
+
+        // Fallback to a regular stream if the file can't be mapped (e.g. empty file)
+        if ( mappedFile != nullptr ) {
+            return mappedFile;
+        }
+    }
+
     // Build flagset
     int32_t openMode = 0;
     if ( ( mode & eFileOpenMode::FILE_OPEN_MODE_READ ) == eFileOpenMode::FILE_OPEN_MODE_READ ) {
@@ -93,20 +115,33 @@ FileSystemObject* FileSystemNative::openFile( const nyaString_t& filename, const
         openMode |= std::ios::ate;
     }
 
-    // Check if the file has already been opened
-    auto fileHashcode = CRC32( filename );
-    for ( auto openedFile : openedFiles ) {
-        if ( openedFile->getHashcode() == fileHashcode && !openedFile->isOpen() ) {
-            openedFile->open( openMode );
-            return openedFile;
+    FileSystemObjectNative* openedFile = nullptr;
+
+    {
+        std::lock_guard<std::mutex> openedFilesLockGuard( openedFilesLock );
+
+        // Check if the file has already been opened (filenames are compared since hashcodes can collide)
+        auto fileHashcode = CRC32( filename );
+        auto sameFileObjects = openedFiles.equal_range( fileHashcode );
+        for ( auto it = sameFileObjects.first; it != sameFileObjects.second; ++it ) {
+            if ( !it->second->isOpen() && it->second->getFilename() == filename ) {
+                openedFile = it->second;
+                break;
+            }
         }
-    }
 
-    // If the file has never been opened, open it
-    openedFiles.push_back( new FileSystemObjectNative( filename ) );
+        // If the file has never been opened, open it
+        if ( openedFile == nullptr ) {
+            openedFile = new FileSystemObjectNative( filename );
+            openedFiles.emplace( fileHashcode, openedFile );
+        }
 
-    auto openedFile = openedFiles.back();
-    openedFile->open( openMode );
+        openedFile->open( openMode );
+    }
+
+    if ( useWriteMode && openedFile->isOpen() ) {
+        onFileCreated( filename );
+    }
 
     return openedFile;
 }
@@ -117,21 +152,161 @@ void FileSystemNative::closeFile( FileSystemObject* fileSystemObject )
         return;
     }
 
-    openedFiles.remove_if( [=]( FileSystemObject* obj ) { 
-        return obj->getHashcode() == fileSystemObject->getHashcode(); 
-    } );
+    std::lock_guard<std::mutex> openedFilesLockGuard( openedFilesLock );
+
+    // Native and mapped objects of the same file can coexist; objects are looked up by address
+    auto eraseObject = [=]( auto& objectTable ) {
+        auto sameFileObjects = objectTable.equal_range( fileSystemObject->getHashcode() );
+        for ( auto it = sameFileObjects.first; it != sameFileObjects.second; ++it ) {
+            if ( it->second == fileSystemObject ) {
+                objectTable.erase( it );
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    if ( !eraseObject( mappedFiles ) ) {
+        eraseObject( openedFiles );
+    }
 
     delete fileSystemObject;
 }
 
+FileSystemObject* FileSystemNative::openMappedFile( const nyaString_t& filename )
+{
+    std::lock_guard<std::mutex> openedFilesLockGuard( openedFilesLock );
+
+    FileSystemObjectMapped* mappedFile = nullptr;
+
+    // Reuse a closed object of the same file
+    auto fileHashcode = CRC32( filename );
+    auto sameFileObjects = mappedFiles.equal_range( fileHashcode );
+    for ( auto it = sameFileObjects.first; it != sameFileObjects.second; ++it ) {
+        if ( !it->second->isOpen() && it->second->getFilename() == filename ) {
+            mappedFile = it->second;
+            break;
+        }
+    }
+
+    if ( mappedFile == nullptr ) {
+        mappedFile = new FileSystemObjectMapped( filename );
+        mappedFiles.emplace( fileHashcode, mappedFile );
+    }
+
+    mappedFile->open( eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY );
+
+    return ( mappedFile->isOpen() ) ? mappedFile : nullptr;
+}
+
 void FileSystemNative::createFolder( const nyaString_t& folderName )
 {
     CreateFolderImpl( folderName );
+    onFileCreated( folderName );
 }
 
 bool FileSystemNative::fileExists( const nyaString_t& filename )
 {
-    return FileExistsImpl( filename );
+    uint32_t queryGeneration = 0u;
+
+    {
+        std::lock_guard<std::mutex> cacheLockGuard( cacheLock );
+
+        auto cachedResult = fileExistenceCache.find( filename );
+        if ( cachedResult != fileExistenceCache.end() ) {
+            return cachedResult->second;
+        }
+
+        queryGeneration = cacheGeneration;
+    }
+
+    const bool fileExists = FileExistsImpl( filename );
+
+    {
+        std::lock_guard<std::mutex> cacheLockGuard( cacheLock );
+
+        if ( isQueryCachingEnabled && queryGeneration == cacheGeneration ) {
+            fileExistenceCache[filename] = fileExists;
+        }
+    }
+
+    return fileExists;
+}
+
+bool FileSystemNative::listFolder( const nyaString_t& folderName, std::vector<nyaString_t>& filenames )
+{
+    if ( !fileExists( folderName ) ) {
+        return false;
+    }
+
+    uint32_t queryGeneration = 0u;
+
+    {
+        std::lock_guard<std::mutex> cacheLockGuard( cacheLock );
+
+        auto cachedListing = folderListingCache.find( folderName );
+        if ( cachedListing != folderListingCache.end() ) {
+            filenames.insert( filenames.end(), cachedListing->second.begin(), cachedListing->second.end() );
+            return true;
+        }
+
+        queryGeneration = cacheGeneration;
+    }
+
+    std::vector<nyaString_t> folderListing;
+    ListFolderContentImpl( folderName, folderListing );
+
+    filenames.insert( filenames.end(), folderListing.begin(), folderListing.end() );
+
+    {
+        std::lock_guard<std::mutex> cacheLockGuard( cacheLock );
+
+        if ( isQueryCachingEnabled && queryGeneration == cacheGeneration ) {
+            folderListingCache[folderName] = std::move( folderListing );
+        }
+    }
+
+    return true;
+}
+
+void FileSystemNative::invalidateCachedFile( const nyaString_t& filename )
+{
+    std::lock_guard<std::mutex> cacheLockGuard( cacheLock );
+
+    fileExistenceCache.erase( filename );
+
+    // Listings are recursive (any folder could list the file)
+    folderListingCache.clear();
+
+    cacheGeneration++;
+}
+
+void FileSystemNative::onFileCreated( const nyaString_t& filename )
+{
+    std::lock_guard<std::mutex> cacheLockGuard( cacheLock );
+
+    if ( isQueryCachingEnabled ) {
+        fileExistenceCache[filename] = true;
+    }
+
+    folderListingCache.clear();
+
+    cacheGeneration++;
+}
+
+void FileSystemNative::setQueryCachingEnabled( const bool isEnabled )
+{
+    std::lock_guard<std::mutex> cacheLockGuard( cacheLock );
+
+    isQueryCachingEnabled = isEnabled;
+
+    if ( !isEnabled ) {
+        fileExistenceCache.clear();
+        folderListingCache.clear();
+    }
+
+    cacheGeneration++;
 }
 
 bool FileSystemNative::isReadOnly()
@@ -139,6 +314,11 @@ bool FileSystemNative::isReadOnly()
     return false;
 }
 
+bool FileSystemNative::hasNativeFilenames()
+{
+    return true;
+}
+
 nyaString_t FileSystemNative::resolveFilename( const nyaString_t& mountPoint, const nyaString_t& filename )
 {
     nyaString_t resolvedFilename( filename );
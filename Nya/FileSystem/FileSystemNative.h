@@ -21,9 +21,11 @@
 
 #include "FileSystem.h"
 
-#include <list>
+#include <unordered_map>
+#include <mutex>
 
 class FileSystemObjectNative;
+class FileSystemObjectMapped;
 
 class FileSystemNative final : public FileSystem
 {
@@ -39,8 +41,38 @@ public:
     virtual bool                        fileExists( const nyaString_t& filename ) override;
     virtual bool                        isReadOnly() override;
     virtual nyaString_t                 resolveFilename( const nyaString_t& mountPoint, const nyaString_t& filename );
+    virtual bool                        hasNativeFilenames() override;
+    virtual bool                        listFolder( const nyaString_t& folderName, std::vector<nyaString_t>& filenames ) override;
+    virtual void                        invalidateCachedFile( const nyaString_t& filename ) override;
+    virtual void                        setQueryCachingEnabled( const bool isEnabled ) override;
 
 private:
     nyaString_t                          workingDirectory;
-    std::list<FileSystemObjectNative*>  openedFiles;
+
+    // Objects are kept once closed (and reopened the next time the file is opened); keyed by filename hashcode (the filename
+    // is compared on lookup)
+    std::unordered_multimap<nyaStringHash_t, FileSystemObjectNative*>   openedFiles;
+    std::unordered_multimap<nyaStringHash_t, FileSystemObjectMapped*>   mappedFiles;
+
+    // Files can be opened from several threads (e.g. asset streaming workers)
+    std::mutex                          openedFilesLock;
+
+    // Results of the OS queries, keyed by filename (files which do not exist are cached too)
+    // Keys are full paths rather than hashcodes: a CRC32 collision would report an existing asset as missing
+    // NOTE HashMap is not used since it only hashes integer/pointer keys and needs an allocator (the FileSystem layer has none)
+    // Updated when a file is written or a folder is created through the media; external changes should be reported with
+    // invalidateCachedFile (see FileSystemWatchdog)
+    // Dev builds only cache once a watchdog is running (files are edited while the engine is running)
+    std::unordered_map<nyaString_t, bool>                               fileExistenceCache;
+    std::unordered_map<nyaString_t, std::vector<nyaString_t>>           folderListingCache;
+    uint32_t                            cacheGeneration; // Incremented on invalidation (OS queries done in the meantime are not cached)
+    bool                                isQueryCachingEnabled;
+    std::mutex                          cacheLock;
+
+private:
+    // Return nullptr if the file can't be mapped
+    FileSystemObject*                   openMappedFile( const nyaString_t& filename );
+
+    // Update the caches after a file or a folder has been created
+    void                                onFileCreated( const nyaString_t& filename );
 };
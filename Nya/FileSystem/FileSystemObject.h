@@ -58,6 +58,10 @@ public:
     virtual void            skip( const uint64_t byteCountToSkip ) = 0;
     virtual void            seek( const uint64_t byteCount, const nya::core::eFileReadDirection direction ) = 0;
 
+    // Return the whole content of the object (valid until the object is closed) or nullptr if the content can't be accessed
+    // in place (the content should then be read with read())
+    virtual const uint8_t*  map( uint64_t& mappedSize ) { mappedSize = 0ull; return nullptr; }
+
 protected:
     nyaStringHash_t          fileHashcode;
     nyaString_t              nativeObjectPath;
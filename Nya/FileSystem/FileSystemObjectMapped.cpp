@@ -0,0 +1,146 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "FileSystemObjectMapped.h"
+
+#if NYA_UNIX
+#include "FileSystemUnix.h"
+#elif NYA_WIN
+#include "FileSystemWin32.h"
+#endif
+
+#include <string.h>
+
+using namespace nya::core;
+
+FileSystemObjectMapped::FileSystemObjectMapped( const nyaString_t& objectPath )
+    : mappedContent( nullptr )
+    , contentSize( 0ull )
+    , streamOffset( 0ull )
+    , isEndOfStreamReached( false )
+{
+    nativeObjectPath = objectPath;
+    fileHashcode = CRC32( nativeObjectPath );
+}
+
+FileSystemObjectMapped::~FileSystemObjectMapped()
+{
+    close();
+}
+
+void FileSystemObjectMapped::open( const int32_t mode )
+{
+    NYA_DEV_ASSERT( ( mode & eFileOpenMode::FILE_OPEN_MODE_WRITE ) == 0, "Mapped objects are read-only (open mode: 0x%X)", mode );
+
+    if ( mappedContent == nullptr ) {
+        mappedContent = MapFileImpl( nativeObjectPath, contentSize );
+    }
+
+    streamOffset = 0ull;
+    isEndOfStreamReached = false;
+}
+
+void FileSystemObjectMapped::close()
+{
+    if ( mappedContent != nullptr ) {
+        UnmapFileImpl( mappedContent, contentSize );
+    }
+
+    mappedContent = nullptr;
+    contentSize = 0ull;
+}
+
+bool FileSystemObjectMapped::isOpen()
+{
+    return mappedContent != nullptr;
+}
+
+bool FileSystemObjectMapped::isGood()
+{
+    return mappedContent != nullptr && !isEndOfStreamReached;
+}
+
+uint64_t FileSystemObjectMapped::tell()
+{
+    return streamOffset;
+}
+
+uint64_t FileSystemObjectMapped::getSize()
+{
+    return contentSize;
+}
+
+void FileSystemObjectMapped::read( uint8_t* buffer, const uint64_t size )
+{
+    const uint64_t availableSize = contentSize - streamOffset;
+    const uint64_t readSize = ( size > availableSize ) ? availableSize : size;
+
+    if ( readSize != 0ull ) {
+        memcpy( buffer, mappedContent + streamOffset, readSize );
+    }
+
+    streamOffset += readSize;
+    isEndOfStreamReached = ( readSize < size );
+}
+
+void FileSystemObjectMapped::write( uint8_t* buffer, const uint64_t size )
+{
+    NYA_DEV_ASSERT( false, "Mapped objects are read-only (tried to write %llu bytes)", static_cast<unsigned long long>( size ) );
+}
+
+void FileSystemObjectMapped::writeString( const std::string& string )
+{
+    writeString( string.c_str(), string.length() );
+}
+
+void FileSystemObjectMapped::writeString( const char* string, const std::size_t length )
+{
+    NYA_DEV_ASSERT( false, "Mapped objects are read-only (tried to write %zu bytes)", length );
+}
+
+void FileSystemObjectMapped::skip( const uint64_t byteCountToSkip )
+{
+    seek( byteCountToSkip, eFileReadDirection::FILE_READ_DIRECTION_CURRENT );
+}
+
+void FileSystemObjectMapped::seek( const uint64_t byteCount, const eFileReadDirection direction )
+{
+    uint64_t offset = 0ull;
+    switch ( direction ) {
+    case eFileReadDirection::FILE_READ_DIRECTION_BEGIN:
+        offset = byteCount;
+        break;
+    case eFileReadDirection::FILE_READ_DIRECTION_CURRENT:
+        offset = streamOffset + byteCount;
+        break;
+    case eFileReadDirection::FILE_READ_DIRECTION_END:
+        offset = ( byteCount > contentSize ) ? 0ull : ( contentSize - byteCount );
+        break;
+    }
+
+    isEndOfStreamReached = ( offset > contentSize );
+    streamOffset = ( isEndOfStreamReached ) ? contentSize : offset;
+}
+
+const uint8_t* FileSystemObjectMapped::map( uint64_t& mappedSize )
+{
+    mappedSize = contentSize;
+    return mappedContent;
+}
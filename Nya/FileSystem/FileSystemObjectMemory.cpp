@@ -0,0 +1,136 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "FileSystemObjectMemory.h"
+
+#include <string.h>
+
+using namespace nya::core;
+
+FileSystemObjectMemory::FileSystemObjectMemory( const nyaString_t& objectPath, std::vector<uint8_t>&& content )
+    : memoryContent( std::move( content ) )
+    , streamOffset( 0ull )
+    , isOpened( true )
+    , isEndOfStreamReached( false )
+{
+    nativeObjectPath = objectPath;
+    fileHashcode = CRC32( nativeObjectPath );
+}
+
+FileSystemObjectMemory::~FileSystemObjectMemory()
+{
+    close();
+
+    memoryContent.clear();
+}
+
+void FileSystemObjectMemory::open( const int32_t mode )
+{
+    NYA_DEV_ASSERT( ( mode & eFileOpenMode::FILE_OPEN_MODE_WRITE ) == 0, "Memory objects are read-only (open mode: 0x%X)", mode );
+
+    streamOffset = 0ull;
+    isOpened = true;
+    isEndOfStreamReached = false;
+}
+
+void FileSystemObjectMemory::close()
+{
+    isOpened = false;
+}
+
+bool FileSystemObjectMemory::isOpen()
+{
+    return isOpened;
+}
+
+bool FileSystemObjectMemory::isGood()
+{
+    return isOpened && !isEndOfStreamReached;
+}
+
+uint64_t FileSystemObjectMemory::tell()
+{
+    return streamOffset;
+}
+
+uint64_t FileSystemObjectMemory::getSize()
+{
+    return memoryContent.size();
+}
+
+void FileSystemObjectMemory::read( uint8_t* buffer, const uint64_t size )
+{
+    const uint64_t availableSize = memoryContent.size() - streamOffset;
+    const uint64_t readSize = ( size > availableSize ) ? availableSize : size;
+
+    if ( readSize != 0ull ) {
+        memcpy( buffer, memoryContent.data() + streamOffset, readSize );
+    }
+
+    streamOffset += readSize;
+    isEndOfStreamReached = ( readSize < size );
+}
+
+void FileSystemObjectMemory::write( uint8_t* buffer, const uint64_t size )
+{
+    NYA_DEV_ASSERT( false, "Memory objects are read-only (tried to write %llu bytes)", static_cast<unsigned long long>( size ) );
+}
+
+void FileSystemObjectMemory::writeString( const std::string& string )
+{
+    writeString( string.c_str(), string.length() );
+}
+
+void FileSystemObjectMemory::writeString( const char* string, const std::size_t length )
+{
+    NYA_DEV_ASSERT( false, "Memory objects are read-only (tried to write %zu bytes)", length );
+}
+
+void FileSystemObjectMemory::skip( const uint64_t byteCountToSkip )
+{
+    seek( byteCountToSkip, eFileReadDirection::FILE_READ_DIRECTION_CURRENT );
+}
+
+void FileSystemObjectMemory::seek( const uint64_t byteCount, const eFileReadDirection direction )
+{
+    const uint64_t contentSize = memoryContent.size();
+
+    uint64_t offset = 0ull;
+    switch ( direction ) {
+    case eFileReadDirection::FILE_READ_DIRECTION_BEGIN:
+        offset = byteCount;
+        break;
+    case eFileReadDirection::FILE_READ_DIRECTION_CURRENT:
+        offset = streamOffset + byteCount;
+        break;
+    case eFileReadDirection::FILE_READ_DIRECTION_END:
+        offset = ( byteCount > contentSize ) ? 0ull : ( contentSize - byteCount );
+        break;
+    }
+
+    isEndOfStreamReached = ( offset > contentSize );
+    streamOffset = ( isEndOfStreamReached ) ? contentSize : offset;
+}
+
+const uint8_t* FileSystemObjectMemory::map( uint64_t& mappedSize )
+{
+    mappedSize = memoryContent.size();
+    return memoryContent.data();
+}
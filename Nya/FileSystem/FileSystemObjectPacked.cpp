@@ -0,0 +1,169 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "FileSystemObjectPacked.h"
+
+#include "PackFile.h"
+
+#include <Core/Compression/LZ4.h>
+
+#include <string.h>
+
+using namespace nya::core;
+
+FileSystemObjectPacked::FileSystemObjectPacked( const nyaString_t& objectPath, const PackEntry& packEntry, const uint8_t* packContent )
+    : storedContent( packContent + packEntry.offset )
+    , storedSize( packEntry.storedSize )
+    , compression( packEntry.compression )
+    , content( nullptr )
+    , contentSize( packEntry.size )
+    , streamOffset( 0ull )
+    , isOpened( false )
+    , isEndOfStreamReached( false )
+{
+    nativeObjectPath = objectPath;
+    fileHashcode = CRC32( nativeObjectPath );
+}
+
+FileSystemObjectPacked::~FileSystemObjectPacked()
+{
+    close();
+}
+
+void FileSystemObjectPacked::open( const int32_t mode )
+{
+    NYA_DEV_ASSERT( ( mode & eFileOpenMode::FILE_OPEN_MODE_WRITE ) == 0, "Packed objects are read-only (open mode: 0x%X)", mode );
+
+    switch ( compression ) {
+    case ePackCompression::PACK_COMPRESSION_NONE:
+        content = storedContent;
+        isOpened = true;
+        break;
+
+    case ePackCompression::PACK_COMPRESSION_LZ4:
+        if ( decompressedContent.empty() ) {
+            decompressedContent.resize( static_cast<std::size_t>( contentSize ) );
+
+            if ( !LZ4Decompress( storedContent, static_cast<std::size_t>( storedSize ), decompressedContent.data(), decompressedContent.size() ) ) {
+                NYA_CERR << "'" << nativeObjectPath << "': corrupted pack entry" << std::endl;
+                decompressedContent.clear();
+            }
+        }
+
+        content = decompressedContent.data();
+        isOpened = ( decompressedContent.size() == contentSize );
+        break;
+
+    default:
+        NYA_CERR << "'" << nativeObjectPath << "': unsupported pack entry compression (" << compression << ")" << std::endl;
+        isOpened = false;
+        break;
+    }
+
+    streamOffset = 0ull;
+    isEndOfStreamReached = false;
+}
+
+void FileSystemObjectPacked::close()
+{
+    isOpened = false;
+    content = nullptr;
+
+    // Release the decompressed content (the entry is decompressed again on the next open)
+    std::vector<uint8_t>().swap( decompressedContent );
+}
+
+bool FileSystemObjectPacked::isOpen()
+{
+    return isOpened;
+}
+
+bool FileSystemObjectPacked::isGood()
+{
+    return isOpened && !isEndOfStreamReached;
+}
+
+uint64_t FileSystemObjectPacked::tell()
+{
+    return streamOffset;
+}
+
+uint64_t FileSystemObjectPacked::getSize()
+{
+    return contentSize;
+}
+
+void FileSystemObjectPacked::read( uint8_t* buffer, const uint64_t size )
+{
+    const uint64_t availableSize = ( isOpened ) ? ( contentSize - streamOffset ) : 0ull;
+    const uint64_t readSize = ( size > availableSize ) ? availableSize : size;
+
+    if ( readSize != 0ull ) {
+        memcpy( buffer, content + streamOffset, readSize );
+    }
+
+    streamOffset += readSize;
+    isEndOfStreamReached = ( readSize < size );
+}
+
+void FileSystemObjectPacked::write( uint8_t* buffer, const uint64_t size )
+{
+    NYA_DEV_ASSERT( false, "Packed objects are read-only (tried to write %llu bytes)", static_cast<unsigned long long>( size ) );
+}
+
+void FileSystemObjectPacked::writeString( const std::string& string )
+{
+    writeString( string.c_str(), string.length() );
+}
+
+void FileSystemObjectPacked::writeString( const char* string, const std::size_t length )
+{
+    NYA_DEV_ASSERT( false, "Packed objects are read-only (tried to write %zu bytes)", length );
+}
+
+void FileSystemObjectPacked::skip( const uint64_t byteCountToSkip )
+{
+    seek( byteCountToSkip, eFileReadDirection::FILE_READ_DIRECTION_CURRENT );
+}
+
+void FileSystemObjectPacked::seek( const uint64_t byteCount, const eFileReadDirection direction )
+{
+    uint64_t offset = 0ull;
+    switch ( direction ) {
+    case eFileReadDirection::FILE_READ_DIRECTION_BEGIN:
+        offset = byteCount;
+        break;
+    case eFileReadDirection::FILE_READ_DIRECTION_CURRENT:
+        offset = streamOffset + byteCount;
+        break;
+    case eFileReadDirection::FILE_READ_DIRECTION_END:
+        offset = ( byteCount > contentSize ) ? 0ull : ( contentSize - byteCount );
+        break;
+    }
+
+    isEndOfStreamReached = ( offset > contentSize );
+    streamOffset = ( isEndOfStreamReached ) ? contentSize : offset;
+}
+
+const uint8_t* FileSystemObjectPacked::map( uint64_t& mappedSize )
+{
+    mappedSize = ( isOpened ) ? contentSize : 0ull;
+    return ( isOpened ) ? content : nullptr;
+}
@@ -0,0 +1,256 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "FileSystemPack.h"
+
+#include "FileSystemObjectPacked.h"
+
+#if NYA_UNIX
+#include "FileSystemUnix.h"
+#elif NYA_WIN
+#include "FileSystemWin32.h"
+#endif
+
+#include <algorithm>
+#include <string.h>
+
+using namespace nya::core;
+
+FileSystemPack::FileSystemPack( const nyaString_t& packFilename )
+    : packContent( MapFileImpl( packFilename, packSize ) )
+    , header( nullptr )
+    , tableOfContents( nullptr )
+    , names( nullptr )
+{
+    if ( packContent == nullptr || packSize < sizeof( PackHeader ) ) {
+        NYA_CERR << "'" << packFilename << "': failed to map pack file" << std::endl;
+        return;
+    }
+
+    const PackHeader* packHeader = reinterpret_cast<const PackHeader*>( packContent );
+
+    const bool isValidPack = ( packHeader->magic == PACK_MAGIC
+                            && packHeader->version == PACK_VERSION
+                            && packHeader->fileSize == packSize
+                            && packHeader->tocSlotCount != 0u
+                            && ( packHeader->tocSlotCount & ( packHeader->tocSlotCount - 1u ) ) == 0u
+                            && packHeader->entryCount < packHeader->tocSlotCount
+                            && packHeader->tocOffset <= packSize
+                            && static_cast<uint64_t>( packHeader->tocSlotCount ) * sizeof( PackEntry ) <= packSize - packHeader->tocOffset
+                            && packHeader->namesOffset <= packSize
+                            && packHeader->namesSize <= packSize - packHeader->namesOffset );
+
+    if ( !isValidPack ) {
+        NYA_CERR << "'" << packFilename << "': invalid pack file (or unsupported version)" << std::endl;
+        return;
+    }
+
+    // Entries are validated once, then trusted on lookup
+    const PackEntry* entries = reinterpret_cast<const PackEntry*>( packContent + packHeader->tocOffset );
+    for ( uint32_t slotIdx = 0u; slotIdx < packHeader->tocSlotCount; slotIdx++ ) {
+        const PackEntry& entry = entries[slotIdx];
+        if ( entry.nameLength == 0 ) {
+            continue;
+        }
+
+        if ( entry.offset > packSize || entry.storedSize > packSize - entry.offset
+          || static_cast<uint64_t>( entry.nameOffset ) + entry.nameLength > packHeader->namesSize ) {
+            NYA_CERR << "'" << packFilename << "': corrupted pack table of contents (slot " << slotIdx << ")" << std::endl;
+            return;
+        }
+    }
+
+    header = packHeader;
+    tableOfContents = entries;
+    names = reinterpret_cast<const char*>( packContent + packHeader->namesOffset );
+
+    entryFiles.resize( packHeader->tocSlotCount, nullptr );
+}
+
+FileSystemPack::~FileSystemPack()
+{
+    for ( FileSystemObjectPacked* entryFile : entryFiles ) {
+        delete entryFile;
+    }
+
+    while ( !extraOpenedFiles.empty() ) {
+        delete extraOpenedFiles.back();
+        extraOpenedFiles.pop_back();
+    }
+
+    if ( packContent != nullptr ) {
+        UnmapFileImpl( packContent, packSize );
+    }
+}
+
+FileSystemObject* FileSystemPack::openFile( const nyaString_t& filename, const int32_t mode )
+{
+    if ( ( mode & eFileOpenMode::FILE_OPEN_MODE_WRITE ) == eFileOpenMode::FILE_OPEN_MODE_WRITE ) {
+        return nullptr;
+    }
+
+    const PackEntry* entry = findEntry( filename );
+    if ( entry == nullptr ) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> openedFilesLockGuard( openedFilesLock );
+
+    FileSystemObjectPacked*& entryFile = entryFiles[entry - tableOfContents];
+    if ( entryFile == nullptr ) {
+        entryFile = new FileSystemObjectPacked( filename, *entry, packContent );
+    }
+
+    FileSystemObjectPacked* openedFile = entryFile;
+
+    // The file is already opened; look for a closed extra object
+    if ( openedFile->isOpen() ) {
+        openedFile = nullptr;
+
+        auto fileHashcode = CRC32( filename );
+        for ( auto packedFile : extraOpenedFiles ) {
+            if ( packedFile->getHashcode() == fileHashcode && !packedFile->isOpen() ) {
+                openedFile = packedFile;
+                break;
+            }
+        }
+
+        if ( openedFile == nullptr ) {
+            extraOpenedFiles.push_back( new FileSystemObjectPacked( filename, *entry, packContent ) );
+            openedFile = extraOpenedFiles.back();
+        }
+    }
+
+    openedFile->open( mode );
+
+    return ( openedFile->isOpen() ) ? openedFile : nullptr;
+}
+
+void FileSystemPack::closeFile( FileSystemObject* fileSystemObject )
+{
+    if ( fileSystemObject == nullptr ) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> openedFilesLockGuard( openedFilesLock );
+
+    auto entryFileIt = std::find( entryFiles.begin(), entryFiles.end(), fileSystemObject );
+    if ( entryFileIt != entryFiles.end() ) {
+        *entryFileIt = nullptr;
+        delete fileSystemObject;
+        return;
+    }
+
+    auto extraFileIt = std::find( extraOpenedFiles.begin(), extraOpenedFiles.end(), fileSystemObject );
+    if ( extraFileIt != extraOpenedFiles.end() ) {
+        extraOpenedFiles.erase( extraFileIt );
+        delete fileSystemObject;
+    }
+}
+
+void FileSystemPack::createFolder( const nyaString_t& folderName )
+{
+
+}
+
+bool FileSystemPack::fileExists( const nyaString_t& filename )
+{
+    return findEntry( filename ) != nullptr;
+}
+
+bool FileSystemPack::isReadOnly()
+{
+    return true;
+}
+
+bool FileSystemPack::listFolder( const nyaString_t& folderName, std::vector<nyaString_t>& filenames )
+{
+    if ( header == nullptr ) {
+        return false;
+    }
+
+    // Folders only exist through the entries they contain
+    nyaString_t folderPrefix = folderName;
+    while ( !folderPrefix.empty() && folderPrefix.back() == '/' ) {
+        folderPrefix.pop_back();
+    }
+
+    if ( !folderPrefix.empty() ) {
+        folderPrefix += '/';
+    }
+
+    bool folderExists = folderPrefix.empty();
+    for ( uint32_t slotIdx = 0u; slotIdx < header->tocSlotCount; slotIdx++ ) {
+        const PackEntry& entry = tableOfContents[slotIdx];
+        const char* entryName = names + entry.nameOffset;
+
+        if ( entry.nameLength <= folderPrefix.length() || !std::equal( folderPrefix.begin(), folderPrefix.end(), entryName ) ) {
+            continue;
+        }
+
+        filenames.push_back( nyaString_t( entryName + folderPrefix.length(), entryName + entry.nameLength ) );
+        folderExists = true;
+    }
+
+    return folderExists;
+}
+
+nyaString_t FileSystemPack::resolveFilename( const nyaString_t& mountPoint, const nyaString_t& filename )
+{
+    // Entries are named after their path relative to the mount point
+    const std::size_t nameOffset = filename.find_first_not_of( NYA_STRING( "/" ), mountPoint.length() );
+
+    return ( nameOffset != nyaString_t::npos ) ? filename.substr( nameOffset ) : NYA_STRING( "" );
+}
+
+bool FileSystemPack::isValid() const
+{
+    return header != nullptr;
+}
+
+uint32_t FileSystemPack::getEntryCount() const
+{
+    return ( header != nullptr ) ? header->entryCount : 0u;
+}
+
+const PackEntry* FileSystemPack::findEntry( const nyaString_t& filename ) const
+{
+    if ( header == nullptr || filename.empty() ) {
+        return nullptr;
+    }
+
+    // NOTE Names are ASCII; CRC32 gives the same hashcode for narrow and wide strings
+    const uint32_t nameHashcode = CRC32( filename );
+    const uint32_t slotMask = ( header->tocSlotCount - 1u );
+
+    for ( uint32_t slotIdx = ( nameHashcode & slotMask ); tableOfContents[slotIdx].nameLength != 0; slotIdx = ( slotIdx + 1u ) & slotMask ) {
+        const PackEntry& entry = tableOfContents[slotIdx];
+
+        if ( entry.nameHashcode != nameHashcode || entry.nameLength != filename.length() ) {
+            continue;
+        }
+
+        if ( std::equal( filename.begin(), filename.end(), names + entry.nameOffset ) ) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
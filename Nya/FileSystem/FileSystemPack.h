@@ -0,0 +1,67 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "FileSystem.h"
+#include "PackFile.h"
+
+#include <list>
+#include <mutex>
+#include <vector>
+
+class FileSystemObjectPacked;
+
+// Read-only media over a pack file (see PackFile.h); the pack is mapped in memory for the lifetime of the media
+class FileSystemPack final : public FileSystem
+{
+public:
+                                        FileSystemPack( const nyaString_t& packFilename );
+                                        FileSystemPack( FileSystemPack& ) = delete;
+                                        FileSystemPack& operator = ( FileSystemPack& ) = delete;
+                                        ~FileSystemPack() override;
+
+    virtual FileSystemObject*           openFile( const nyaString_t& filename, const int32_t mode = nya::core::eFileOpenMode::FILE_OPEN_MODE_READ ) override;
+    virtual void                        closeFile( FileSystemObject* fileSystemObject ) override;
+    virtual void                        createFolder( const nyaString_t& folderName ) override;
+    virtual bool                        fileExists( const nyaString_t& filename ) override;
+    virtual bool                        isReadOnly() override;
+    virtual bool                        listFolder( const nyaString_t& folderName, std::vector<nyaString_t>& filenames ) override;
+    virtual nyaString_t                 resolveFilename( const nyaString_t& mountPoint, const nyaString_t& filename ) override;
+
+    // Return false if the pack could not be mapped or is invalid (the media is then empty)
+    bool                                isValid() const;
+    uint32_t                            getEntryCount() const;
+
+private:
+    const uint8_t*                      packContent;
+    uint64_t                            packSize;
+
+    const nya::core::PackHeader*        header;
+    const nya::core::PackEntry*         tableOfContents;
+    const char*                         names;
+
+    // One object per table of contents slot (created on first open); files opened several times at once get extra objects
+    std::vector<FileSystemObjectPacked*> entryFiles;
+    std::list<FileSystemObjectPacked*>  extraOpenedFiles;
+    std::mutex                          openedFilesLock;
+
+private:
+    const nya::core::PackEntry*         findEntry( const nyaString_t& filename ) const;
+};
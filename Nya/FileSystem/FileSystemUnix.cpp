@@ -23,6 +23,11 @@
 #include "FileSystemUnix.h"
 
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
 
 bool nya::core::FileExistsImpl( const nyaString_t& filename )
 {
@@ -34,4 +39,111 @@ void nya::core::CreateFolderImpl( const nyaString_t& folderName )
 {
     mkdir( folderName.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH );
 }
+
+const uint8_t* nya::core::MapFileImpl( const nyaString_t& filename, uint64_t& fileSize )
+{
+    fileSize = 0ull;
+
+    const int fileDescriptor = open( filename.c_str(), O_RDONLY );
+    if ( fileDescriptor == -1 ) {
+        return nullptr;
+    }
+
+    struct stat fileStat = {};
+    if ( fstat( fileDescriptor, &fileStat ) != 0 || fileStat.st_size <= 0 ) {
+        close( fileDescriptor );
+        return nullptr;
+    }
+
+    void* mappedContent = mmap( nullptr, static_cast<size_t>( fileStat.st_size ), PROT_READ, MAP_PRIVATE, fileDescriptor, 0 );
+
+    // The mapping keeps a reference to the file
+    close( fileDescriptor );
+
+    if ( mappedContent == MAP_FAILED ) {
+        return nullptr;
+    }
+
+    // Loaders parse the content from the start to the end
+    madvise( mappedContent, static_cast<size_t>( fileStat.st_size ), MADV_SEQUENTIAL );
+
+    fileSize = static_cast<uint64_t>( fileStat.st_size );
+    return static_cast<const uint8_t*>( mappedContent );
+}
+
+void nya::core::UnmapFileImpl( const uint8_t* mappedContent, const uint64_t fileSize )
+{
+    munmap( const_cast<uint8_t*>( mappedContent ), static_cast<size_t>( fileSize ) );
+}
+
+static void ListFolderContentRecursive( const nyaString_t& folderName, const nyaString_t& relativePath, std::vector<nyaString_t>& filenames )
+{
+    DIR* directory = opendir( ( folderName + relativePath ).c_str() );
+    if ( directory == nullptr ) {
+        return;
+    }
+
+    while ( dirent* directoryEntry = readdir( directory ) ) {
+        const nyaString_t entryName = directoryEntry->d_name;
+        if ( entryName == NYA_STRING( "." ) || entryName == NYA_STRING( ".." ) ) {
+            continue;
+        }
+
+        const nyaString_t entryPath = relativePath + entryName;
+
+        struct stat entryStat = {};
+        if ( stat( ( folderName + entryPath ).c_str(), &entryStat ) != 0 ) {
+            continue;
+        }
+
+        if ( S_ISDIR( entryStat.st_mode ) ) {
+            ListFolderContentRecursive( folderName, entryPath + NYA_STRING( "/" ), filenames );
+        } else if ( S_ISREG( entryStat.st_mode ) ) {
+            filenames.push_back( entryPath );
+        }
+    }
+
+    closedir( directory );
+}
+
+bool nya::core::ReadFileImpl( const nyaString_t& filename, const uint64_t offset, const uint64_t size, uint8_t* destination, uint64_t& readSize )
+{
+    readSize = 0ull;
+
+    const int fileDescriptor = open( filename.c_str(), O_RDONLY );
+    if ( fileDescriptor == -1 ) {
+        return false;
+    }
+
+    bool isReadSuccessful = true;
+    while ( readSize < size ) {
+        const ssize_t chunkSize = pread( fileDescriptor, destination + readSize, static_cast<size_t>( size - readSize ), static_cast<off_t>( offset + readSize ) );
+
+        if ( chunkSize < 0 && errno == EINTR ) {
+            continue;
+        }
+
+        // Error or end of file
+        if ( chunkSize <= 0 ) {
+            isReadSuccessful = ( chunkSize == 0 );
+            break;
+        }
+
+        readSize += static_cast<uint64_t>( chunkSize );
+    }
+
+    close( fileDescriptor );
+
+    return isReadSuccessful;
+}
+
+void nya::core::ListFolderContentImpl( const nyaString_t& folderName, std::vector<nyaString_t>& filenames )
+{
+    nyaString_t folderPath = folderName;
+    if ( !folderPath.empty() && folderPath.back() != '/' ) {
+        folderPath += '/';
+    }
+
+    ListFolderContentRecursive( folderPath, NYA_STRING( "" ), filenames );
+}
 #endif
@@ -34,4 +34,114 @@ void nya::core::CreateFolderImpl( const nyaString_t& folderName )
 {
     CreateDirectory( folderName.c_str(), nullptr );
 }
+
+const uint8_t* nya::core::MapFileImpl( const nyaString_t& filename, uint64_t& fileSize )
+{
+    fileSize = 0ull;
+
+    HANDLE fileHandle = CreateFile( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+    if ( fileHandle == INVALID_HANDLE_VALUE ) {
+        return nullptr;
+    }
+
+    LARGE_INTEGER nativeFileSize = {};
+    if ( !GetFileSizeEx( fileHandle, &nativeFileSize ) || nativeFileSize.QuadPart <= 0 ) {
+        CloseHandle( fileHandle );
+        return nullptr;
+    }
+
+    HANDLE mappingHandle = CreateFileMapping( fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    void* mappedContent = ( mappingHandle != nullptr ) ? MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 ) : nullptr;
+
+    // The view keeps a reference to the mapping (and the mapping to the file)
+    if ( mappingHandle != nullptr ) {
+        CloseHandle( mappingHandle );
+    }
+    CloseHandle( fileHandle );
+
+    if ( mappedContent == nullptr ) {
+        return nullptr;
+    }
+
+    fileSize = static_cast<uint64_t>( nativeFileSize.QuadPart );
+    return static_cast<const uint8_t*>( mappedContent );
+}
+
+void nya::core::UnmapFileImpl( const uint8_t* mappedContent, const uint64_t fileSize )
+{
+    UnmapViewOfFile( mappedContent );
+}
+
+static void ListFolderContentRecursive( const nyaString_t& folderName, const nyaString_t& relativePath, std::vector<nyaString_t>& filenames )
+{
+    WIN32_FIND_DATA findData = {};
+    HANDLE findHandle = FindFirstFile( ( folderName + relativePath + NYA_STRING( "*" ) ).c_str(), &findData );
+    if ( findHandle == INVALID_HANDLE_VALUE ) {
+        return;
+    }
+
+    do {
+        const nyaString_t entryName = findData.cFileName;
+        if ( entryName == NYA_STRING( "." ) || entryName == NYA_STRING( ".." ) ) {
+            continue;
+        }
+
+        const nyaString_t entryPath = relativePath + entryName;
+
+        if ( findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) {
+            ListFolderContentRecursive( folderName, entryPath + NYA_STRING( "/" ), filenames );
+        } else {
+            filenames.push_back( entryPath );
+        }
+    } while ( FindNextFile( findHandle, &findData ) );
+
+    FindClose( findHandle );
+}
+
+bool nya::core::ReadFileImpl( const nyaString_t& filename, const uint64_t offset, const uint64_t size, uint8_t* destination, uint64_t& readSize )
+{
+    readSize = 0ull;
+
+    HANDLE fileHandle = CreateFile( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if ( fileHandle == INVALID_HANDLE_VALUE ) {
+        return false;
+    }
+
+    bool isReadSuccessful = true;
+    while ( readSize < size ) {
+        const uint64_t chunkOffset = offset + readSize;
+        const uint64_t remainingSize = size - readSize;
+
+        OVERLAPPED readOffset = {};
+        readOffset.Offset = static_cast<DWORD>( chunkOffset & 0xFFFFFFFF );
+        readOffset.OffsetHigh = static_cast<DWORD>( chunkOffset >> 32 );
+
+        DWORD chunkSize = 0;
+        if ( !ReadFile( fileHandle, destination + readSize, static_cast<DWORD>( ( remainingSize > 0x40000000 ) ? 0x40000000 : remainingSize ), &chunkSize, &readOffset ) ) {
+            isReadSuccessful = ( GetLastError() == ERROR_HANDLE_EOF );
+            break;
+        }
+
+        // End of file
+        if ( chunkSize == 0 ) {
+            break;
+        }
+
+        readSize += chunkSize;
+    }
+
+    CloseHandle( fileHandle );
+
+    return isReadSuccessful;
+}
+
+void nya::core::ListFolderContentImpl( const nyaString_t& folderName, std::vector<nyaString_t>& filenames )
+{
+    nyaString_t folderPath = folderName;
+    if ( !folderPath.empty() && folderPath.back() != '/' && folderPath.back() != '\\' ) {
+        folderPath += NYA_STRING( "/" );
+    }
+
+    ListFolderContentRecursive( folderPath, NYA_STRING( "" ), filenames );
+}
 #endif
@@ -19,6 +19,8 @@
 */
 #pragma once
 
+#include <vector>
+
 #if NYA_WIN
 namespace nya
 {
@@ -26,6 +28,16 @@ namespace nya
     {
         bool    FileExistsImpl( const nyaString_t& filename );
         void    CreateFolderImpl( const nyaString_t& folderName );
+
+        // Map the whole file (read-only); return nullptr if the file can't be mapped (e.g. empty file)
+        const uint8_t*  MapFileImpl( const nyaString_t& filename, uint64_t& fileSize );
+        void            UnmapFileImpl( const uint8_t* mappedContent, const uint64_t fileSize );
+
+        // Append the files of a folder and its subfolders (paths are relative to the folder and use '/' as separator)
+        void            ListFolderContentImpl( const nyaString_t& folderName, std::vector<nyaString_t>& filenames );
+
+        // Blocking positioned read (readSize is lower than size if the end of the file is reached); return false on error
+        bool            ReadFileImpl( const nyaString_t& filename, const uint64_t offset, const uint64_t size, uint8_t* destination, uint64_t& readSize );
     }
 }
 #endif
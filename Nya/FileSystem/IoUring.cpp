@@ -0,0 +1,250 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "IoUring.h"
+
+#if NYA_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+static int SetupRing( const uint32_t entryCount, io_uring_params* parameters )
+{
+    return static_cast<int>( syscall( __NR_io_uring_setup, entryCount, parameters ) );
+}
+
+static int EnterRing( const int ringFileDescriptor, const uint32_t submitCount, const uint32_t waitCount, const uint32_t flags )
+{
+    return static_cast<int>( syscall( __NR_io_uring_enter, ringFileDescriptor, submitCount, waitCount, flags, nullptr, 0 ) );
+}
+
+IoUring::IoUring()
+    : ringFileDescriptor( -1 )
+    , entryCount( 0u )
+    , submissionRing( nullptr )
+    , submissionRingSize( 0 )
+    , completionRing( nullptr )
+    , completionRingSize( 0 )
+    , submissionEntries( nullptr )
+    , submissionEntriesSize( 0 )
+    , submissionHead( nullptr )
+    , submissionTail( nullptr )
+    , submissionMask( 0u )
+    , submissionArray( nullptr )
+    , pendingSubmissionCount( 0u )
+    , completionHead( nullptr )
+    , completionTail( nullptr )
+    , completionMask( 0u )
+    , completionEntries( nullptr )
+{
+
+}
+
+IoUring::~IoUring()
+{
+    destroy();
+}
+
+bool IoUring::create( const uint32_t ringEntryCount )
+{
+    io_uring_params parameters = {};
+    ringFileDescriptor = SetupRing( ringEntryCount, &parameters );
+
+    if ( ringFileDescriptor < 0 ) {
+        ringFileDescriptor = -1;
+        return false;
+    }
+
+    entryCount = parameters.sq_entries;
+
+    submissionRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof( uint32_t );
+    completionRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof( io_uring_cqe );
+
+    // Kernels with IORING_FEAT_SINGLE_MMAP map both rings with a single call
+    const bool useSingleMapping = ( parameters.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+    if ( useSingleMapping ) {
+        submissionRingSize = completionRingSize = ( submissionRingSize > completionRingSize ) ? submissionRingSize : completionRingSize;
+    }
+
+    submissionRing = mmap( nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFileDescriptor, IORING_OFF_SQ_RING );
+    if ( submissionRing == MAP_FAILED ) {
+        submissionRing = nullptr;
+        destroy();
+        return false;
+    }
+
+    if ( useSingleMapping ) {
+        completionRing = submissionRing;
+    } else {
+        completionRing = mmap( nullptr, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFileDescriptor, IORING_OFF_CQ_RING );
+        if ( completionRing == MAP_FAILED ) {
+            completionRing = nullptr;
+            destroy();
+            return false;
+        }
+    }
+
+    submissionEntriesSize = parameters.sq_entries * sizeof( io_uring_sqe );
+    void* mappedEntries = mmap( nullptr, submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFileDescriptor, IORING_OFF_SQES );
+    if ( mappedEntries == MAP_FAILED ) {
+        destroy();
+        return false;
+    }
+
+    submissionEntries = static_cast<io_uring_sqe*>( mappedEntries );
+
+    uint8_t* submissionRingBase = static_cast<uint8_t*>( submissionRing );
+    submissionHead = reinterpret_cast<uint32_t*>( submissionRingBase + parameters.sq_off.head );
+    submissionTail = reinterpret_cast<uint32_t*>( submissionRingBase + parameters.sq_off.tail );
+    submissionMask = *reinterpret_cast<uint32_t*>( submissionRingBase + parameters.sq_off.ring_mask );
+    submissionArray = reinterpret_cast<uint32_t*>( submissionRingBase + parameters.sq_off.array );
+
+    uint8_t* completionRingBase = static_cast<uint8_t*>( completionRing );
+    completionHead = reinterpret_cast<uint32_t*>( completionRingBase + parameters.cq_off.head );
+    completionTail = reinterpret_cast<uint32_t*>( completionRingBase + parameters.cq_off.tail );
+    completionMask = *reinterpret_cast<uint32_t*>( completionRingBase + parameters.cq_off.ring_mask );
+    completionEntries = reinterpret_cast<io_uring_cqe*>( completionRingBase + parameters.cq_off.cqes );
+
+    pendingSubmissionCount = 0u;
+
+    return true;
+}
+
+void IoUring::destroy()
+{
+    if ( submissionEntries != nullptr ) {
+        munmap( submissionEntries, submissionEntriesSize );
+    }
+
+    if ( completionRing != nullptr && completionRing != submissionRing ) {
+        munmap( completionRing, completionRingSize );
+    }
+
+    if ( submissionRing != nullptr ) {
+        munmap( submissionRing, submissionRingSize );
+    }
+
+    if ( ringFileDescriptor >= 0 ) {
+        close( ringFileDescriptor );
+    }
+
+    ringFileDescriptor = -1;
+    entryCount = 0u;
+    submissionRing = nullptr;
+    completionRing = nullptr;
+    submissionEntries = nullptr;
+    pendingSubmissionCount = 0u;
+}
+
+bool IoUring::pushRead( const int fileDescriptor, uint8_t* destination, const uint32_t size, const uint64_t offset, const uint64_t userData )
+{
+    const uint32_t head = __atomic_load_n( submissionHead, __ATOMIC_ACQUIRE );
+    const uint32_t tail = *submissionTail;
+
+    if ( tail - head >= entryCount ) {
+        return false;
+    }
+
+    const uint32_t entryIndex = ( tail & submissionMask );
+
+    io_uring_sqe& entry = submissionEntries[entryIndex];
+    memset( &entry, 0, sizeof( io_uring_sqe ) );
+    entry.opcode = IORING_OP_READ;
+    entry.fd = fileDescriptor;
+    entry.addr = reinterpret_cast<uint64_t>( destination );
+    entry.len = size;
+    entry.off = offset;
+    entry.user_data = userData;
+
+    submissionArray[entryIndex] = entryIndex;
+
+    // Publish the entry to the kernel
+    __atomic_store_n( submissionTail, tail + 1u, __ATOMIC_RELEASE );
+    pendingSubmissionCount++;
+
+    return true;
+}
+
+bool IoUring::submitAndWait( const uint32_t waitCount )
+{
+    uint32_t submitCount = pendingSubmissionCount;
+    uint32_t remainingWaitCount = waitCount;
+
+    while ( submitCount > 0u || remainingWaitCount > 0u ) {
+        const int result = EnterRing( ringFileDescriptor, submitCount, remainingWaitCount, ( remainingWaitCount > 0u ) ? IORING_ENTER_GETEVENTS : 0u );
+
+        if ( result < 0 ) {
+            if ( errno == EINTR ) {
+                continue;
+            }
+
+            return false;
+        }
+
+        submitCount -= ( static_cast<uint32_t>( result ) < submitCount ) ? static_cast<uint32_t>( result ) : submitCount;
+        pendingSubmissionCount = submitCount;
+
+        // The kernel only returns once waitCount completions are available (or on signal)
+        const uint32_t availableCompletions = __atomic_load_n( completionTail, __ATOMIC_ACQUIRE ) - *completionHead;
+        remainingWaitCount = ( availableCompletions >= waitCount ) ? 0u : remainingWaitCount;
+    }
+
+    return true;
+}
+
+bool IoUring::popCompletion( uint64_t& userData, int32_t& result )
+{
+    const uint32_t head = *completionHead;
+    if ( head == __atomic_load_n( completionTail, __ATOMIC_ACQUIRE ) ) {
+        return false;
+    }
+
+    const io_uring_cqe& entry = completionEntries[head & completionMask];
+    userData = entry.user_data;
+    result = entry.res;
+
+    __atomic_store_n( completionHead, head + 1u, __ATOMIC_RELEASE );
+
+    return true;
+}
+
+void IoUring::cancelPendingSubmissions( std::vector<uint64_t>& userData )
+{
+    // The kernel only consumes entries when the ring is entered (no submission polling thread), so the pending entries can be unpublished
+    const uint32_t head = __atomic_load_n( submissionHead, __ATOMIC_ACQUIRE );
+    const uint32_t tail = *submissionTail;
+    const uint32_t cancelledCount = ( pendingSubmissionCount < ( tail - head ) ) ? pendingSubmissionCount : ( tail - head );
+
+    for ( uint32_t i = cancelledCount; i > 0u; i-- ) {
+        userData.push_back( submissionEntries[( tail - i ) & submissionMask].user_data );
+    }
+
+    __atomic_store_n( submissionTail, tail - cancelledCount, __ATOMIC_RELEASE );
+    pendingSubmissionCount = 0u;
+}
+
+uint32_t IoUring::getEntryCount() const
+{
+    return entryCount;
+}
+#endif
@@ -0,0 +1,85 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#if NYA_UNIX && defined( __linux__ ) && __has_include( <linux/io_uring.h> )
+#define NYA_IO_URING 1
+#else
+#define NYA_IO_URING 0
+#endif
+
+#if NYA_IO_URING
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+// Minimal io_uring wrapper (reads only; no liburing dependency)
+// NOTE Not thread-safe; the ring should be owned by a single thread
+class IoUring
+{
+public:
+                        IoUring();
+                        IoUring( IoUring& ) = delete;
+                        IoUring& operator = ( IoUring& ) = delete;
+                        ~IoUring();
+
+    // Return false if io_uring is not available (old kernel, blocked by a sandbox, etc.)
+    bool                create( const uint32_t entryCount );
+    void                destroy();
+
+    // Queue a read; return false if the submission queue is full
+    bool                pushRead( const int fileDescriptor, uint8_t* destination, const uint32_t size, const uint64_t offset, const uint64_t userData );
+
+    // Submit the queued reads and wait for at least waitCount completions; return false on error
+    bool                submitAndWait( const uint32_t waitCount );
+
+    // Return false if there is no completion left; result is the byte count read or -errno
+    bool                popCompletion( uint64_t& userData, int32_t& result );
+
+    // Withdraw the queued reads which have not been submitted yet (e.g. after a failed submission); their user data is appended
+    // to userData. Reads already submitted are not affected (their completions should still be popped)
+    void                cancelPendingSubmissions( std::vector<uint64_t>& userData );
+
+    uint32_t            getEntryCount() const;
+
+private:
+    int                 ringFileDescriptor;
+    uint32_t            entryCount;
+
+    void*               submissionRing;
+    std::size_t         submissionRingSize;
+    void*               completionRing;
+    std::size_t         completionRingSize;
+    io_uring_sqe*       submissionEntries;
+    std::size_t         submissionEntriesSize;
+
+    uint32_t*           submissionHead;
+    uint32_t*           submissionTail;
+    uint32_t            submissionMask;
+    uint32_t*           submissionArray;
+    uint32_t            pendingSubmissionCount;
+
+    uint32_t*           completionHead;
+    uint32_t*           completionTail;
+    uint32_t            completionMask;
+    io_uring_cqe*       completionEntries;
+};
+#endif
@@ -0,0 +1,69 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+// Pack file layout (little endian)
+//  PackHeader
+//  Entries content (each entry starts on a PACK_ENTRY_ALIGNMENT boundary)
+//  Names (relative paths using '/' as separator; not null terminated)
+//  Table of contents (open addressing table of PackEntry; see PackHeader::tocSlotCount)
+namespace nya
+{
+    namespace core
+    {
+        static constexpr uint32_t PACK_MAGIC = 0x4B41504E; // "NPAK"
+        static constexpr uint32_t PACK_VERSION = 1u;
+        static constexpr uint64_t PACK_ENTRY_ALIGNMENT = 64ull;
+
+        enum ePackCompression : uint16_t
+        {
+            PACK_COMPRESSION_NONE = 0,
+            PACK_COMPRESSION_LZ4,
+        };
+
+        struct PackHeader
+        {
+            uint32_t    magic;
+            uint32_t    version;
+            uint32_t    entryCount;
+            uint32_t    tocSlotCount; // Power of two; slots are probed linearly from ( nameHashcode & ( tocSlotCount - 1 ) )
+            uint64_t    tocOffset;
+            uint64_t    namesOffset;
+            uint64_t    namesSize;
+            uint64_t    fileSize;
+        };
+
+        // Empty table of contents slots have a nameLength of zero
+        struct PackEntry
+        {
+            uint64_t    offset;
+            uint64_t    size; // Uncompressed size
+            uint64_t    storedSize;
+            uint32_t    nameHashcode; // CRC32 of the name
+            uint32_t    nameOffset;
+            uint16_t    nameLength;
+            uint16_t    compression;
+            uint32_t    __PADDING__;
+        };
+
+        static_assert( sizeof( PackHeader ) == 48, "PackHeader layout is part of the pack format" );
+        static_assert( sizeof( PackEntry ) == 40, "PackEntry layout is part of the pack format" );
+    }
+}
@@ -22,40 +22,68 @@
 
 #include "FileSystem.h"
 
+#include <algorithm>
+
 VirtualFileSystem::VirtualFileSystem()
 {
-
+    // Root node
+    mountNodes.push_back( MountNode() );
 }
 
 VirtualFileSystem::~VirtualFileSystem()
 {
-    fileSystemEntries.clear();
+    mountNodes.clear();
 }
 
 void VirtualFileSystem::mount( FileSystem* media, const nyaString_t& mountPoint, const uint64_t mountOrder )
 {
-    fileSystemEntries.push_back( { media, mountOrder, mountPoint } );
+    uint32_t nodeIndex = 0u;
+
+    for ( const nyaChar_t character : mountPoint ) {
+        auto& children = mountNodes[nodeIndex].Children;
+        auto childIterator = std::find_if( children.begin(), children.end(), [=]( const std::pair<nyaChar_t, uint32_t>& child ) { return child.first == character; } );
+
+        if ( childIterator != children.end() ) {
+            nodeIndex = childIterator->second;
+        } else {
+            const uint32_t childIndex = static_cast<uint32_t>( mountNodes.size() );
+            children.push_back( std::make_pair( character, childIndex ) );
+
+            // NOTE Invalidates children
+            mountNodes.push_back( MountNode() );
+            nodeIndex = childIndex;
+        }
+    }
+
+    auto& entries = mountNodes[nodeIndex].Entries;
+    auto insertIterator = std::upper_bound( entries.begin(), entries.end(), mountOrder, []( const uint64_t order, const FileSystemEntry& entry ) { return order < entry.MountOrder; } );
 
-    fileSystemEntries.sort( [=]( FileSystemEntry& lEntry, FileSystemEntry& rEntry ) {
-        return lEntry.MountPoint.length() >= rEntry.MountPoint.length() && lEntry.MountOrder <= rEntry.MountOrder;
-    } );
+    entries.insert( insertIterator, { media, mountOrder, mountPoint } );
 }
 
 void VirtualFileSystem::unmount( FileSystem* media )
 {
-    fileSystemEntries.remove_if( [=]( const FileSystemEntry& entry ) { return entry.Media == media; } );
+    // Pending reads might target the media
+    asyncIOQueue.flush();
+
+    for ( MountNode& node : mountNodes ) {
+        node.Entries.erase( std::remove_if( node.Entries.begin(), node.Entries.end(), [=]( const FileSystemEntry& entry ) { return entry.Media == media; } ), node.Entries.end() );
+    }
 }
 
 FileSystemObject* VirtualFileSystem::openFile( const nyaString_t& filename, const int32_t mode )
 {
-    for ( auto& fileSystemEntry : fileSystemEntries ) {
-        if ( filename.compare( 0, fileSystemEntry.MountPoint.length(), fileSystemEntry.MountPoint ) == 0 ) {
-            auto absoluteFilename = fileSystemEntry.Media->resolveFilename( fileSystemEntry.MountPoint, filename );
-            auto openedFile = fileSystemEntry.Media->openFile( absoluteFilename, mode );
+    const FileSystemEntry* matchingEntries[MAX_MATCHING_MEDIA_COUNT];
+    const uint32_t matchingEntryCount = findMatchingEntries( filename, matchingEntries );
 
-            if ( openedFile != nullptr ) {
-                return openedFile;
-            }
+    for ( uint32_t entryIdx = 0u; entryIdx < matchingEntryCount; entryIdx++ ) {
+        const FileSystemEntry* fileSystemEntry = matchingEntries[entryIdx];
+
+        auto absoluteFilename = fileSystemEntry->Media->resolveFilename( fileSystemEntry->MountPoint, filename );
+        auto openedFile = fileSystemEntry->Media->openFile( absoluteFilename, mode );
+
+        if ( openedFile != nullptr ) {
+            return openedFile;
         }
     }
 
@@ -64,16 +92,148 @@ FileSystemObject* VirtualFileSystem::openFile( const nyaString_t& filename, cons
 
 bool VirtualFileSystem::fileExists( const nyaString_t& filename )
 {
-    for ( auto& fileSystemEntry : fileSystemEntries ) {
-        if ( filename.compare( 0, fileSystemEntry.MountPoint.length(), fileSystemEntry.MountPoint ) == 0 ) {
-            auto absoluteFilename = fileSystemEntry.Media->resolveFilename( fileSystemEntry.MountPoint, filename );
-            auto fileExists = fileSystemEntry.Media->fileExists( absoluteFilename );
+    const FileSystemEntry* matchingEntries[MAX_MATCHING_MEDIA_COUNT];
+    const uint32_t matchingEntryCount = findMatchingEntries( filename, matchingEntries );
 
-            if ( fileExists ) {
-                return true;
-            }
+    for ( uint32_t entryIdx = 0u; entryIdx < matchingEntryCount; entryIdx++ ) {
+        const FileSystemEntry* fileSystemEntry = matchingEntries[entryIdx];
+
+        auto absoluteFilename = fileSystemEntry->Media->resolveFilename( fileSystemEntry->MountPoint, filename );
+        auto fileExists = fileSystemEntry->Media->fileExists( absoluteFilename );
+
+        if ( fileExists ) {
+            return true;
         }
     }
 
     return false;
 }
+
+bool VirtualFileSystem::listFolder( const nyaString_t& folderName, std::vector<nyaString_t>& filenames )
+{
+    const FileSystemEntry* matchingEntries[MAX_MATCHING_MEDIA_COUNT];
+    const uint32_t matchingEntryCount = findMatchingEntries( folderName, matchingEntries );
+
+    const std::size_t firstFilenameIndex = filenames.size();
+
+    bool folderExists = false;
+    for ( uint32_t entryIdx = 0u; entryIdx < matchingEntryCount; entryIdx++ ) {
+        const FileSystemEntry* fileSystemEntry = matchingEntries[entryIdx];
+
+        auto absoluteFolderName = fileSystemEntry->Media->resolveFilename( fileSystemEntry->MountPoint, folderName );
+        folderExists |= fileSystemEntry->Media->listFolder( absoluteFolderName, filenames );
+    }
+
+    // Files stored on several medias are only listed once
+    if ( matchingEntryCount > 1u ) {
+        auto firstFilename = filenames.begin() + static_cast<std::ptrdiff_t>( firstFilenameIndex );
+
+        std::sort( firstFilename, filenames.end() );
+        filenames.erase( std::unique( firstFilename, filenames.end() ), filenames.end() );
+    }
+
+    return folderExists;
+}
+
+void VirtualFileSystem::invalidateCachedFile( const nyaString_t& filename )
+{
+    const FileSystemEntry* matchingEntries[MAX_MATCHING_MEDIA_COUNT];
+    const uint32_t matchingEntryCount = findMatchingEntries( filename, matchingEntries );
+
+    for ( uint32_t entryIdx = 0u; entryIdx < matchingEntryCount; entryIdx++ ) {
+        const FileSystemEntry* fileSystemEntry = matchingEntries[entryIdx];
+
+        auto absoluteFilename = fileSystemEntry->Media->resolveFilename( fileSystemEntry->MountPoint, filename );
+        fileSystemEntry->Media->invalidateCachedFile( absoluteFilename );
+    }
+}
+
+void VirtualFileSystem::setQueryCachingEnabled( const bool isEnabled )
+{
+    for ( MountNode& mountNode : mountNodes ) {
+        for ( FileSystemEntry& fileSystemEntry : mountNode.Entries ) {
+            fileSystemEntry.Media->setQueryCachingEnabled( isEnabled );
+        }
+    }
+}
+
+void VirtualFileSystem::readAsync( const nyaString_t& filename, const uint64_t offset, const uint64_t size, uint8_t* destination, nyaAsyncReadCallback_t callback, const nya::core::eIoPriority priority )
+{
+    const FileSystemEntry* matchingEntries[MAX_MATCHING_MEDIA_COUNT];
+    const uint32_t matchingEntryCount = findMatchingEntries( filename, matchingEntries );
+
+    if ( matchingEntryCount == 0u ) {
+        if ( callback ) {
+            callback( false, 0ull );
+        }
+
+        return;
+    }
+
+    // Existence is only checked if several medias could hold the file (the last candidate is used without checking; a missing file
+    // is then reported by the I/O thread)
+    const FileSystemEntry* candidateEntry = matchingEntries[matchingEntryCount - 1u];
+
+    for ( uint32_t entryIdx = 0u; entryIdx < ( matchingEntryCount - 1u ); entryIdx++ ) {
+        const FileSystemEntry* fileSystemEntry = matchingEntries[entryIdx];
+
+        if ( fileSystemEntry->Media->fileExists( fileSystemEntry->Media->resolveFilename( fileSystemEntry->MountPoint, filename ) ) ) {
+            candidateEntry = fileSystemEntry;
+            break;
+        }
+    }
+
+    auto absoluteFilename = candidateEntry->Media->resolveFilename( candidateEntry->MountPoint, filename );
+    asyncIOQueue.push( { candidateEntry->Media, absoluteFilename, offset, size, destination, std::move( callback ) }, priority );
+}
+
+void VirtualFileSystem::flushAsyncReads()
+{
+    asyncIOQueue.flush();
+}
+
+uint32_t VirtualFileSystem::findMatchingEntries( const nyaString_t& filename, const FileSystemEntry* ( &matchingEntries )[MAX_MATCHING_MEDIA_COUNT] ) const
+{
+    // Walk down the trie along the filename; every node on the way is a mount point prefixing the filename
+    uint32_t matchingNodes[MAX_MATCHING_MEDIA_COUNT];
+    uint32_t matchingNodeCount = 0u;
+
+    uint32_t nodeIndex = 0u;
+    std::size_t characterIndex = 0;
+
+    while ( true ) {
+        const MountNode& node = mountNodes[nodeIndex];
+
+        if ( !node.Entries.empty() && matchingNodeCount < MAX_MATCHING_MEDIA_COUNT ) {
+            matchingNodes[matchingNodeCount++] = nodeIndex;
+        }
+
+        if ( characterIndex == filename.size() ) {
+            break;
+        }
+
+        const nyaChar_t character = filename[characterIndex++];
+        auto childIterator = std::find_if( node.Children.begin(), node.Children.end(), [=]( const std::pair<nyaChar_t, uint32_t>& child ) { return child.first == character; } );
+
+        if ( childIterator == node.Children.end() ) {
+            break;
+        }
+
+        nodeIndex = childIterator->second;
+    }
+
+    // Longest mount points first
+    uint32_t matchingEntryCount = 0u;
+    for ( uint32_t nodeIdx = matchingNodeCount; nodeIdx > 0u; nodeIdx-- ) {
+        for ( const FileSystemEntry& entry : mountNodes[matchingNodes[nodeIdx - 1u]].Entries ) {
+            if ( matchingEntryCount == MAX_MATCHING_MEDIA_COUNT ) {
+                NYA_CWARN << "Too many medias mounted for '" << filename << "' (the least important medias are ignored)" << std::endl;
+                return matchingEntryCount;
+            }
+
+            matchingEntries[matchingEntryCount++] = &entry;
+        }
+    }
+
+    return matchingEntryCount;
+}
@@ -23,8 +23,9 @@ class FileSystem;
 class FileSystemObject;
 
 #include "FileOpenModes.h"
+#include "AsyncIOQueue.h"
 
-#include <list>
+#include <vector>
 
 class VirtualFileSystem
 {
@@ -40,13 +41,44 @@ public:
     FileSystemObject*   openFile( const nyaString_t& filename, const int32_t mode = nya::core::eFileOpenMode::FILE_OPEN_MODE_READ );
     bool                fileExists( const nyaString_t& filename );
 
+    // Append the files of a folder and its subfolders, merged from every media the folder is mounted on (see FileSystem::listFolder)
+    // Return false if the folder does not exist on any media
+    bool                listFolder( const nyaString_t& folderName, std::vector<nyaString_t>& filenames );
+
+    // Drop the cached informations of every media the file could be stored on (call when a file is modified outside of the VFS)
+    void                invalidateCachedFile( const nyaString_t& filename );
+
+    // Enable the caching of the OS queries on every mounted media (see FileSystem::setQueryCachingEnabled)
+    // Medias mounted afterwards keep their own setting
+    void                setQueryCachingEnabled( const bool isEnabled );
+
+    // Read size bytes at offset into destination without blocking the calling thread (the callback is called from an I/O thread)
+    // The callback is called immediately (with isSuccessful set to false) if no media is mounted for the file path
+    void                readAsync( const nyaString_t& filename, const uint64_t offset, const uint64_t size, uint8_t* destination, nyaAsyncReadCallback_t callback, const nya::core::eIoPriority priority = nya::core::IO_PRIORITY_NORMAL );
+
+    // Block until every asynchronous read has completed
+    void                flushAsyncReads();
+
 private:
+    static constexpr uint32_t   MAX_MATCHING_MEDIA_COUNT = 16u;
+
     struct FileSystemEntry {
         FileSystem* Media;
         uint64_t    MountOrder; // From 0 (most important fs; checked first when opening a file) to MAX_UINT64 (least important fs)
         nyaString_t MountPoint;
     };
 
+    // Mount points are stored in a character trie (the root node is the empty mount point)
+    struct MountNode {
+        std::vector<std::pair<nyaChar_t, uint32_t>> Children; // Character and child node index
+        std::vector<FileSystemEntry>                Entries; // Medias mounted on this node (sorted by mount order)
+    };
+
+private:
+    std::vector<MountNode>      mountNodes;
+    AsyncIOQueue                asyncIOQueue;
+
 private:
-    std::list<FileSystemEntry>  fileSystemEntries;
+    // Return the medias which could hold the file (in lookup order: longest mount point first, then by mount order)
+    uint32_t                    findMatchingEntries( const nyaString_t& filename, const FileSystemEntry* ( &matchingEntries )[MAX_MATCHING_MEDIA_COUNT] ) const;
 };
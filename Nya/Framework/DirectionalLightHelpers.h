@@ -35,17 +35,7 @@ namespace
     static constexpr float MinDistance = 0.0f;
     static constexpr float MaxDistance = 1.0f;
 
-    static constexpr float nearClip = 25.0f; // 250f;
-    static constexpr float farClip = 250.0f;
-    static constexpr float clipRange = farClip - nearClip;
-
-    static constexpr float minZ = nearClip + MinDistance * clipRange;
-    static constexpr float maxZ = nearClip + MaxDistance * clipRange;
-
-    static constexpr float range = maxZ - minZ;
-    static constexpr float ratio = maxZ / minZ;
-
-    // Compute the split distances based on the partitioning mode
+    // Default split distances (normalized between the depth projection near and far planes)
     static constexpr float CascadeSplits[4] = {
         MinDistance + 0.050f * MaxDistance,
         MinDistance + 0.150f * MaxDistance,
@@ -113,7 +103,18 @@ namespace nya
             return ( texScaleBias * shadowMatrix );
         }
 
-        void CSMComputeSliceData( const DirectionalLightData* lightData, const int cascadeIdx, CameraData* cameraData )
+        // Retrieve the view space depth range covered by the camera shadow frustum (depth projection near and far planes)
+        static void CSMGetDepthRange( const CameraData* cameraData, float& nearPlane, float& farPlane )
+        {
+            auto inverseProjection = cameraData->depthProjectionMatrix.inverse().transpose();
+
+            nearPlane = TransformVec3( nyaVec3f( 0.0f, 0.0f, 0.0f ), inverseProjection ).z;
+            farPlane = TransformVec3( nyaVec3f( 0.0f, 0.0f, 1.0f ), inverseProjection ).z;
+        }
+
+        // Compute the world space bounding sphere of a cascade slice
+        // Split distances are normalized between the depth projection near and far planes
+        static void CSMComputeSliceBoundingSphere( const CameraData* cameraData, const float prevSplitDist, const float splitDist, nyaVec3f& sphereCenter, float& sphereRadius )
         {
             // Get the 8 points of the view frustum in world space
             nyaVec3f frustumCornersWS[8] = {
@@ -127,10 +128,7 @@ namespace nya
                 nyaVec3f( -1.0f, -1.0f, 1.0f ),
             };
 
-            float prevSplitDist = ( cascadeIdx == 0 ) ? MinDistance : CascadeSplits[cascadeIdx - 1];
-            float splitDist = CascadeSplits[cascadeIdx];
-
-            auto inverseViewProjection = cameraData->depthProjectionMatrix.inverse().transpose();
+            auto inverseViewProjection = cameraData->depthViewProjectionMatrix.inverse().transpose();
 
             for ( int i = 0; i < 8; ++i ) {
                 frustumCornersWS[i] = TransformVec3( frustumCornersWS[i], inverseViewProjection );
@@ -153,31 +151,34 @@ namespace nya
 
             frustumCenter *= 1.0f / 8.0f;
 
-            nyaVec3f minExtents;
-            nyaVec3f maxExtents;
-
-            // Pick the up vector to use for the light camera
-            const nyaVec3f upDir = nyaVec3f( 0, 1, 0 );
-
-            float sphereRadius = 0.0f;
+            float radius = 0.0f;
             for ( int i = 0; i < 8; ++i ) {
                 float dist = ( frustumCornersWS[i] - frustumCenter ).length();
-                sphereRadius = nya::maths::max( sphereRadius, dist );
+                radius = nya::maths::max( radius, dist );
             }
 
-            sphereRadius = std::ceil( sphereRadius * 16.0f ) / 16.0f;
+            sphereCenter = frustumCenter;
+            sphereRadius = std::ceil( radius * 16.0f ) / 16.0f;
+        }
 
-            maxExtents = nyaVec3f( sphereRadius, sphereRadius, sphereRadius );
-            minExtents = -maxExtents;
+        // Build the orthographic projection of a cascade slice (returns the non-transposed light view projection)
+        // The projection is snapped to the shadow map texels to avoid shimmering when the slice moves
+        static nyaMat4x4f CSMComputeSliceShadowMatrix( const nyaVec3f& lightDirNormalized, const nyaVec3f& sphereCenter, const float sphereRadius )
+        {
+            nyaVec3f maxExtents = nyaVec3f( sphereRadius, sphereRadius, sphereRadius );
+            nyaVec3f minExtents = -maxExtents;
 
             nyaVec3f cascadeExtents = maxExtents - minExtents;
 
+            // Pick the up vector to use for the light camera
+            const nyaVec3f upDir = nyaVec3f( 0, 1, 0 );
+
             // Get position of the shadow camera
-            nyaVec3f shadowCameraPos = frustumCenter + lightData->direction.normalize() * -minExtents.z;
+            nyaVec3f shadowCameraPos = sphereCenter + lightDirNormalized * -minExtents.z;
 
             // Come up with a new orthographic camera for the shadow caster
             nyaMat4x4f shadowCamera = nya::maths::MakeOrtho( minExtents.x, maxExtents.x, minExtents.y, maxExtents.y, 0.0f, cascadeExtents.z );
-            nyaMat4x4f shadowLookAt = nya::maths::MakeLookAtMat( shadowCameraPos, frustumCenter, upDir );
+            nyaMat4x4f shadowLookAt = nya::maths::MakeLookAtMat( shadowCameraPos, sphereCenter, upDir );
             nyaMat4x4f shadowMatrix = shadowCamera * shadowLookAt;
 
             // Create the rounding matrix, by projecting the world-space origin and determining
@@ -193,8 +194,14 @@ namespace nya
             shadowCamera[3].y += roundOffset.y;
             shadowCamera[3].z += roundOffset.z;
 
-            shadowMatrix = shadowCamera * shadowLookAt;
-            cameraData->shadowViewMatrix[cascadeIdx] = shadowMatrix.transpose();
+            return shadowCamera * shadowLookAt;
+        }
+
+        // Write cascade data to the camera (shadow matrix, view space split distance and offset/scale relative to the global shadow matrix)
+        // NOTE cameraData->globalShadowMatrix must not be transposed yet
+        static void CSMUpdateCameraSliceData( const int cascadeIdx, const nyaMat4x4f& sliceShadowMatrix, const float splitDistanceVS, CameraData* cameraData )
+        {
+            cameraData->shadowViewMatrix[cascadeIdx] = sliceShadowMatrix.transpose();
 
             // Apply the scale/offset matrix, which transforms from [-1,1]
             // post-projection space to [0,1] UV space
@@ -204,10 +211,10 @@ namespace nya
                 0.0f, 0.0f, 1.0f, 0.0f,
                 0.5f, 0.5f, 0.0f, 1.0f );
 
-            shadowMatrix = texScaleBias * shadowMatrix;
+            nyaMat4x4f shadowMatrix = texScaleBias * sliceShadowMatrix;
 
             // Store the split distance in terms of view space depth
-            cameraData->cascadeSplitDistances[cascadeIdx] = nearClip + splitDist * clipRange;
+            cameraData->cascadeSplitDistances[cascadeIdx] = splitDistanceVS;
 
             // Calculate the position of the lower corner of the cascade partition, in the UV space
             // of the first cascade partition
@@ -225,5 +232,23 @@ namespace nya
             cameraData->cascadeOffsets[cascadeIdx] = nyaVec4f( -cascadeCorner, 0.0f );
             cameraData->cascadeScales[cascadeIdx] = nyaVec4f( cascadeScale, 1.0f );
         }
+
+        // Compute cascade data using the default (fixed) split distances
+        inline void CSMComputeSliceData( const DirectionalLightData* lightData, const int cascadeIdx, CameraData* cameraData )
+        {
+            float prevSplitDist = ( cascadeIdx == 0 ) ? MinDistance : CascadeSplits[cascadeIdx - 1];
+            float splitDist = CascadeSplits[cascadeIdx];
+
+            nyaVec3f sphereCenter;
+            float sphereRadius;
+            CSMComputeSliceBoundingSphere( cameraData, prevSplitDist, splitDist, sphereCenter, sphereRadius );
+
+            nyaMat4x4f shadowMatrix = CSMComputeSliceShadowMatrix( lightData->direction.normalize(), sphereCenter, sphereRadius );
+
+            float nearPlane, farPlane;
+            CSMGetDepthRange( cameraData, nearPlane, farPlane );
+
+            CSMUpdateCameraSliceData( cascadeIdx, shadowMatrix, nearPlane + splitDist * ( farPlane - nearPlane ), cameraData );
+        }
     }
 }
@@ -39,8 +39,10 @@ void GUIButton::onMouseButtonDown( const double mouseX, const double mouseY )
 
     GUIPanel::onMouseButtonDown( mouseX, mouseY );
 
-    if ( isMouseInside )
+    if ( isMouseInside ) {
         *Value = !*Value;
+        markDirty();
+    }
 }
 
 void GUIButton::onMouseButtonUp()
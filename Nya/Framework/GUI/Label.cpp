@@ -26,6 +26,7 @@ GUILabel::GUILabel()
     : GUIWidget()
     , Value( "" )
     , ColorAndAlpha( 1.0f, 1.0f, 1.0f, 1.0f )
+    , textDrawCmd{ "", 0, nyaVec4f( 1.0f, 1.0f, 1.0f, 1.0f ), nyaVec2f( 0.0f, 0.0f ), 0.0f }
 {
 
 }
@@ -34,9 +35,39 @@ GUILabel::~GUILabel()
 {
     Value.clear();
     ColorAndAlpha = nyaVec4f( 0.0f, 0.0f, 0.0f, 0.0f );
+    textDrawCmd.stringToPrint.clear();
 }
 
-void GUILabel::collectDrawCmds( DrawCommandBuilder& drawCmdBuilder )
+void GUILabel::setValue( const std::string& value )
 {
-    drawCmdBuilder.addHUDText( Position, Size.x, ColorAndAlpha, Value );
+    if ( Value == value ) {
+        return;
+    }
+
+    Value = value;
+    markDirty();
+}
+
+void GUILabel::setColorAndAlpha( const nyaVec4f& colorAndAlpha )
+{
+    if ( ColorAndAlpha == colorAndAlpha ) {
+        return;
+    }
+
+    ColorAndAlpha = colorAndAlpha;
+    markDirty();
+}
+
+void GUILabel::rebuildDrawCmds()
+{
+    textDrawCmd.stringToPrint = Value;
+    textDrawCmd.stringHashcode = nya::core::CRC32( Value );
+    textDrawCmd.color = ColorAndAlpha;
+    textDrawCmd.positionScreenSpace = Position;
+    textDrawCmd.scale = Size.x;
+}
+
+void GUILabel::submitDrawCmds( DrawCommandBuilder& drawCmdBuilder )
+{
+    drawCmdBuilder.addHUDText( textDrawCmd );
 }
@@ -25,17 +25,27 @@ class Material;
 #include "Widget.h"
 #include <string>
 
+#include <Graphics/FramePacket.h>
+
 class GUILabel : public GUIWidget
 {
 public:
-    std::string Value;
-    nyaVec4f    ColorAndAlpha;
+                    GUILabel();
+                    GUILabel( GUILabel& widget ) = default;
+                    GUILabel& operator = ( GUILabel& widget ) = default;
+                    ~GUILabel();
 
-public:
-                GUILabel();
-                GUILabel( GUILabel& widget ) = default;
-                GUILabel& operator = ( GUILabel& widget ) = default;
-                ~GUILabel();
+    void            setValue( const std::string& value );
+    void            setColorAndAlpha( const nyaVec4f& colorAndAlpha );
+
+protected:
+    std::string     Value;
+    nyaVec4f        ColorAndAlpha;
+
+protected:
+    void            rebuildDrawCmds() override;
+    void            submitDrawCmds( DrawCommandBuilder& drawCmdBuilder ) override;
 
-    void        collectDrawCmds( DrawCommandBuilder& drawCmdBuilder ) override;
+private:
+    FramePacket::TextDrawCommand    textDrawCmd;
 };
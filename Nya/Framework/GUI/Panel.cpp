@@ -31,6 +31,8 @@ GUIPanel::GUIPanel()
     , PanelMaterial( nullptr )
 {
     mousePressedCoordinates = nyaVec2f( 0.0f, 0.0f );
+    rectangleDrawCmd.modelMatrix = nyaMat4x4f::Identity;
+    rectangleDrawCmd.material = nullptr;
 }
 
 GUIPanel::~GUIPanel()
@@ -69,6 +71,7 @@ void GUIPanel::onMouseCoordinatesUpdate( const double mouseX, const double mouse
 {
     if ( IsDraggable && isMouseInside ) {
         Position = mousePressedCoordinates + nyaVec2f( static_cast< float >( mouseX ), static_cast< float >( mouseY ) );
+        markDirty();
 
         for ( GUIWidget* child : children ) {
             child->setScreenPosition( Position - Size + ( child->VirtualPosition * Size * 2.0f ) );
@@ -82,12 +85,23 @@ void GUIPanel::addChild( GUIWidget* widget )
     children.push_back( widget );
 }
 
-void GUIPanel::collectDrawCmds( DrawCommandBuilder& drawCmdBuilder )
+void GUIPanel::rebuildDrawCmds()
 {
-    drawCmdBuilder.addHUDRectangle( Position, Size, 0.0f, PanelMaterial );
+    rectangleDrawCmd.modelMatrix = nya::graphics::ComputeHUDRectangleModelMatrix( Position, Size, 0.0f );
+}
+
+void GUIPanel::submitDrawCmds( DrawCommandBuilder& drawCmdBuilder )
+{
+    // PanelMaterial is public (it can be swapped without marking the panel dirty)
+    rectangleDrawCmd.material = PanelMaterial;
 
+    drawCmdBuilder.addHUDRectangle( rectangleDrawCmd );
+}
+
+void GUIPanel::collectChildrenDrawCmds( DrawCommandBuilder& drawCmdBuilder, GUIRebuildStatistics& statistics )
+{
     for ( GUIWidget* child : children ) {
-        child->collectDrawCmds( drawCmdBuilder );
+        child->collectDrawCmds( drawCmdBuilder, statistics );
     }
 }
 
@@ -24,8 +24,11 @@ class Material;
 
 #include "Widget.h"
 
+#include <Maths/Matrix.h>
 #include <vector>
 
+#include <Graphics/FramePacket.h>
+
 class GUIPanel : public GUIWidget
 {
 public:
@@ -46,13 +49,19 @@ public:
     virtual void            onMouseCoordinatesUpdate( const double mouseX, const double mouseY );
 
     void                    addChild( GUIWidget* widget );
-    void                    collectDrawCmds( DrawCommandBuilder& drawCmdBuilder ) override;
     void                    setScreenPosition( const nyaVec2f& screenSpacePosition ) override;
 
 protected:
     bool                    isMouseInside;
 
+protected:
+    void                    rebuildDrawCmds() override;
+    void                    submitDrawCmds( DrawCommandBuilder& drawCmdBuilder ) override;
+    void                    collectChildrenDrawCmds( DrawCommandBuilder& drawCmdBuilder, GUIRebuildStatistics& statistics ) override;
+
 private:
     nyaVec2f                mousePressedCoordinates;
     std::vector<GUIWidget*> children;
+
+    FramePacket::PrimitiveInstance  rectangleDrawCmd;
 };
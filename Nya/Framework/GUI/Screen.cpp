@@ -29,6 +29,7 @@ GUIScreen::GUIScreen( BaseAllocator* allocator )
     : memoryAllocator( allocator )
     , virtualScreenSize( 1280u, 720u )
     , screenSize( 1280u, 720u )
+    , rebuildStatistics{ 0u, 0u }
 {
 
 }
@@ -60,13 +61,24 @@ void GUIScreen::onScreenResize( const nyaVec2u& screenSizeInPixels )
 
 void GUIScreen::collectDrawCmds( DrawCommandBuilder& drawCmdBuilder )
 {
+    rebuildStatistics.RebuiltWidgetCount = 0u;
+    rebuildStatistics.ReusedWidgetCount = 0u;
+
     for ( GUIPanel* panel : panels ) {
-        panel->collectDrawCmds( drawCmdBuilder );
+        panel->collectDrawCmds( drawCmdBuilder, rebuildStatistics );
     }
 
     for ( GUIWidget* widget : widgets ) {
-        widget->collectDrawCmds( drawCmdBuilder );
+        widget->collectDrawCmds( drawCmdBuilder, rebuildStatistics );
     }
+
+    NYA_PROFILE_STAT( "GUI Rebuilt Widgets", rebuildStatistics.RebuiltWidgetCount )
+    NYA_PROFILE_STAT( "GUI Reused Widgets", rebuildStatistics.ReusedWidgetCount )
+}
+
+const GUIRebuildStatistics& GUIScreen::getRebuildStatistics() const
+{
+    return rebuildStatistics;
 }
 
 void GUIScreen::onMouseCoordinatesUpdate( const double mouseX, const double mouseY )
@@ -25,6 +25,8 @@ class DrawCommandBuilder;
 class GUIWidget;
 class GUIPanel;
 
+#include "Widget.h"
+
 #include <Maths/Vector.h>
 #include <vector>
 
@@ -60,6 +62,7 @@ public:
     }
 
     void                    collectDrawCmds( DrawCommandBuilder& drawCmdBuilder );
+    const GUIRebuildStatistics& getRebuildStatistics() const;
 
     void                    onMouseCoordinatesUpdate( const double mouseX, const double mouseY );
     void                    onLeftMouseButtonDown( const double mouseX, const double mouseY );
@@ -70,6 +73,8 @@ private:
     nyaVec2u                virtualScreenSize;
     nyaVec2u                screenSize;
 
+    GUIRebuildStatistics    rebuildStatistics;
+
     std::vector<GUIWidget*> widgets;
     std::vector<GUIPanel*>  panels;
 };
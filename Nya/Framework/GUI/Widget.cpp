@@ -25,6 +25,7 @@ GUIWidget::GUIWidget()
     , VirtualSize( 0.0f, 0.0f )
     , Position( 0.0f, 0.0f )
     , Size( 0.0f, 0.0f )
+    , isDirty( true )
 {
 
 }
@@ -35,15 +36,40 @@ GUIWidget::~GUIWidget()
     VirtualSize = nyaVec2f( 0.0f, 0.0f );
     Position = nyaVec2f( 0.0f, 0.0f );
     Size = nyaVec2f( 0.0f, 0.0f );
+    isDirty = false;
+}
+
+void GUIWidget::collectDrawCmds( DrawCommandBuilder& drawCmdBuilder, GUIRebuildStatistics& statistics )
+{
+    if ( isDirty ) {
+        rebuildDrawCmds();
+        isDirty = false;
+
+        statistics.RebuiltWidgetCount++;
+    } else {
+        statistics.ReusedWidgetCount++;
+    }
+
+    submitDrawCmds( drawCmdBuilder );
+    collectChildrenDrawCmds( drawCmdBuilder, statistics );
 }
 
 void GUIWidget::onScreenSizeChange( const nyaVec2f& updatedVirtualToScreenSpaceFactor )
 {
     Position = VirtualPosition * updatedVirtualToScreenSpaceFactor;
     Size = VirtualSize * updatedVirtualToScreenSpaceFactor;
+
+    markDirty();
 }
 
 void GUIWidget::setScreenPosition( const nyaVec2f& screenSpacePosition )
 {
     Position = screenSpacePosition + Size;
+
+    markDirty();
+}
+
+void GUIWidget::markDirty()
+{
+    isDirty = true;
 }
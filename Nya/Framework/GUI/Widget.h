@@ -24,6 +24,13 @@ class DrawCommandBuilder;
 
 #include <Maths/Vector.h>
 
+// Retained GUI statistics (reset every frame)
+struct GUIRebuildStatistics
+{
+    uint32_t        RebuiltWidgetCount;
+    uint32_t        ReusedWidgetCount;
+};
+
 class GUIWidget
 {
 public:
@@ -38,16 +45,33 @@ public:
                     GUIWidget& operator = ( GUIWidget& widget ) = default;
                     ~GUIWidget();
 
-    virtual void    collectDrawCmds( DrawCommandBuilder& drawCmdBuilder ) = 0;
+    // Rebuild the widget cached draw data if its state has changed, then submit it to the builder
+    void            collectDrawCmds( DrawCommandBuilder& drawCmdBuilder, GUIRebuildStatistics& statistics );
     void            onScreenSizeChange( const nyaVec2f& updatedVirtualToScreenSpaceFactor );
 
     // Override widget screenspace position
     // It should only be use for specific case (e.g. relative positioning)
     virtual void    setScreenPosition( const nyaVec2f& screenSpacePosition );
 
+    // Force cached draw data rebuild (should be called whenever the widget visual state is updated)
+    void            markDirty();
+
 protected:
     // Position in screen coordinates system
     nyaVec2f        Position;
     // Size in screen coordinates system
     nyaVec2f        Size;
+
+    bool            isDirty;
+
+protected:
+    // Rebuild the retained draw commands (rectangles and text commands; glyph runs are cached by the text renderer using
+    // the retained text hashcode)
+    virtual void    rebuildDrawCmds() = 0;
+
+    // Submit the retained draw commands to the builder (copied as is)
+    virtual void    submitDrawCmds( DrawCommandBuilder& drawCmdBuilder ) = 0;
+
+    // Collect the draw commands of the child widgets (if any)
+    virtual void    collectChildrenDrawCmds( DrawCommandBuilder& drawCmdBuilder, GUIRebuildStatistics& statistics ) { }
 };
@@ -113,5 +113,9 @@ struct IBLProbeData
     bool        isCaptured;
     bool        isDynamic;
     bool        isFallbackProbe; // Should be used as a fallback in case no env probe is available? (this flag discards probe's world position/radius)
-    uint8_t     __PADDING__[4];
+    bool        hasIrradianceSH; // Use irradianceSH for diffuse lighting instead of the convoluted diffuse cubemap?
+    uint8_t     __PADDING__[6];
+
+    // Order 2 SH irradiance (divided by PI; xyz: rgb)
+    nyaVec4f    irradianceSH[9];
 };
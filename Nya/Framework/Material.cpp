@@ -25,6 +25,7 @@
 
 #include <Core/StringHelpers.h>
 #include <Io/TextStreamHelpers.h>
+#include <Io/TextStreamReader.h>
 
 #include <Graphics/ShaderCache.h>
 #include <Graphics/GraphicsAssetCache.h>
@@ -40,7 +41,7 @@
 using namespace nya::graphics;
 using namespace nya::rendering;
 
-void ReadEditableMaterialInput( const nyaString_t& materialInputLine, const int32_t layerIndex, const uint32_t inputTextureBindIndex, GraphicsAssetCache* graphicsAssetCache, MaterialEditionInput& materialComponent, Texture** textureSet, int& textureCount )
+void ReadEditableMaterialInput( const nyaString_t& materialInputLine, const int32_t layerIndex, const uint32_t inputTextureBindIndex, GraphicsAssetCache* graphicsAssetCache, const bool useAsyncTextureLoading, MaterialEditionInput& materialComponent, Texture** textureSet, int& textureCount )
 {
     auto valueHashcode = nya::core::CRC32( materialInputLine.c_str() );
     const bool isNone = ( valueHashcode == NYA_STRING_HASH( "None" ) ) || materialInputLine.empty();
@@ -63,7 +64,7 @@ void ReadEditableMaterialInput( const nyaString_t& materialInputLine, const int3
         auto extension = nya::core::GetFileExtensionFromPath( assetPath );
 
         materialComponent.InputType = MaterialEditionInput::TEXTURE;
-        materialComponent.InputTexture = graphicsAssetCache->getTexture( assetPath.c_str() );
+        materialComponent.InputTexture = ( useAsyncTextureLoading ) ? graphicsAssetCache->getTextureAsync( assetPath.c_str() ) : graphicsAssetCache->getTexture( assetPath.c_str() );
 
         textureSet[inputTextureBindIndex] = materialComponent.InputTexture;
 
@@ -237,8 +238,12 @@ void Material::create( RenderDevice* renderDevice, ShaderCache* shaderCache )
         defaultPipelineStateDesc.resourceListLayout.resources[11] = { 13, SHADER_STAGE_PIXEL, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_RENDER_TARGET }; // Texture2D g_SunShadowMap
         defaultPipelineStateDesc.resourceListLayout.resources[12] = { 14, SHADER_STAGE_PIXEL, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_RENDER_TARGET }; // TextureCubeArray g_EnvProbeDiffuseArray
         defaultPipelineStateDesc.resourceListLayout.resources[13] = { 15, SHADER_STAGE_PIXEL, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_RENDER_TARGET }; // TextureCubeArray  g_EnvProbeSpecularArray
+        defaultPipelineStateDesc.resourceListLayout.resources[14] = { 17, SHADER_STAGE_PIXEL, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_GENERIC_BUFFER }; // Buffer<uint4> g_PointLightBuffer
+        defaultPipelineStateDesc.resourceListLayout.resources[15] = { 18, SHADER_STAGE_PIXEL, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_GENERIC_BUFFER }; // Buffer<uint4> g_IBLProbeBuffer
+        defaultPipelineStateDesc.resourceListLayout.resources[16] = { 19, SHADER_STAGE_PIXEL, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_RENDER_TARGET }; // Texture2D g_LocalShadowAtlas
+        defaultPipelineStateDesc.resourceListLayout.resources[17] = { 5, SHADER_STAGE_PIXEL, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_CBUFFER }; // cbuffer LocalShadowBuffer
       
-        uint32_t resourceBindIdx = 14u;
+        uint32_t resourceBindIdx = 18u;
         for ( int32_t textureIndex = 0u; textureIndex < defaultTextureSetCount; textureIndex++ ) {
             defaultPipelineStateDesc.resourceListLayout.resources[resourceBindIdx++] = { textureIndex, SHADER_STAGE_PIXEL, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_TEXTURE };
         }
@@ -310,50 +315,41 @@ void Material::destroy( RenderDevice* renderDevice )
     renderDevice->destroyPipelineState( depthOnlyPipelineState );
 }
 
-void Material::load( FileSystemObject* stream, GraphicsAssetCache* graphicsAssetCache )
+void Material::load( FileSystemObject* stream, GraphicsAssetCache* graphicsAssetCache, const bool useAsyncTextureLoading )
 {
-#define NYA_CASE_READ_MATERIAL_FLAG( streamLine, variable ) case NYA_STRING_HASH( #variable ): editableMaterialData.variable = nya::core::StringToBoolean( streamLine ); break;
-#define NYA_CASE_READ_MATERIAL_FLOAT( streamLine, layerIndex, variable ) case NYA_STRING_HASH( #variable ): editableMaterialData.layers[layerIndex].variable = std::stof( dictionaryValue.c_str() ); break;
-#define NYA_CASE_READ_LAYER_PIXEL_INPUT( streamLine, layerIndex, variableIndex, variable )  case NYA_STRING_HASH( #variable ): ReadEditableMaterialInput( streamLine, layerIndex, variableIndex, graphicsAssetCache, editableMaterialData.layers[layerIndex].variable, defaultTextureSet, defaultTextureSetCount ); break;
-#define NYA_CASE_READ_LAYER_VERTEX_INPUT( streamLine, layerIndex, variableIndex, variable )  case NYA_STRING_HASH( #variable ): ReadEditableMaterialInput( streamLine, layerIndex, variableIndex, graphicsAssetCache, editableMaterialData.layers[layerIndex].variable, vertexTextureSet, defaultTextureSetCount ); break;
+#define NYA_CASE_READ_MATERIAL_FLAG( streamLine, variable ) case NYA_STRING_HASH( #variable ): editableMaterialData.variable = dictionaryValueToken.toBoolean(); break;
+#define NYA_CASE_READ_MATERIAL_FLOAT( streamLine, layerIndex, variable ) case NYA_STRING_HASH( #variable ): editableMaterialData.layers[layerIndex].variable = dictionaryValueToken.toFloat(); break;
+#define NYA_CASE_READ_LAYER_PIXEL_INPUT( streamLine, layerIndex, variableIndex, variable )  case NYA_STRING_HASH( #variable ): ReadEditableMaterialInput( streamLine, layerIndex, variableIndex, graphicsAssetCache, useAsyncTextureLoading, editableMaterialData.layers[layerIndex].variable, defaultTextureSet, defaultTextureSetCount ); break;
+#define NYA_CASE_READ_LAYER_VERTEX_INPUT( streamLine, layerIndex, variableIndex, variable )  case NYA_STRING_HASH( #variable ): ReadEditableMaterialInput( streamLine, layerIndex, variableIndex, graphicsAssetCache, useAsyncTextureLoading, editableMaterialData.layers[layerIndex].variable, vertexTextureSet, defaultTextureSetCount ); break;
 
     // Reset material inputs (incase of hot reloading)
     defaultTextureSetCount = 0;
 
-    nyaString_t streamLine, dictionaryKey, dictionaryValue;
+    TextStreamReader streamReader( stream );
+    TextToken streamLine, dictionaryKey, dictionaryValueToken;
+    nyaString_t dictionaryValue;
 
     int currentLayerIndex = -1;
     uint32_t slotBaseIndex = 0;
-    while ( stream->isGood() ) {
-        nya::core::ReadString( stream, streamLine );
-
-        // Find seperator character offset in the line (if any)
-        const auto commentSeparator = streamLine.find_first_of( NYA_STRING( ";" ) );
-
+    while ( streamReader.readLine( streamLine ) ) {
         // Remove user comments before reading the keypair value
-        if ( commentSeparator != nyaString_t::npos ) {
-            streamLine.erase( streamLine.begin() + static_cast<long>( commentSeparator ), streamLine.end() );
-        }
+        streamLine.end = streamLine.find( ';' );
 
         // Skip commented out and empty lines
         if ( streamLine.empty() ) {
             continue;
         }
 
-        const auto keyValueSeparator = streamLine.find_first_of( ':' );
-
         // Check if this is a key value line
-        if ( keyValueSeparator != nyaString_t::npos ) {
-            dictionaryKey = streamLine.substr( 0, keyValueSeparator );
-            dictionaryValue = streamLine.substr( keyValueSeparator + 1 );
-
+        if ( streamLine.split( ':', dictionaryKey, dictionaryValueToken ) ) {
             // Trim both key and values (useful if a stream has inconsistent spacing, ...)
-            nya::core::TrimString( dictionaryKey );
-            nya::core::TrimString( dictionaryValue );
+            dictionaryKey = dictionaryKey.trim();
+            dictionaryValueToken = dictionaryValueToken.trim();
 
             // Do the check after triming, since the value might be a space or a tab character
-            if ( !dictionaryValue.empty() ) {
-                auto keyHashcode = nya::core::CRC32( dictionaryKey.c_str() );
+            if ( !dictionaryValueToken.empty() ) {
+                auto keyHashcode = dictionaryKey.hash();
+                dictionaryValueToken.toString( dictionaryValue );
 
                 switch ( keyHashcode ) {
                 case NYA_STRING_HASH( "Name" ):
@@ -362,37 +358,37 @@ void Material::load( FileSystemObject* stream, GraphicsAssetCache* graphicsAsset
 
                 case NYA_STRING_HASH( "ShadingModel" ):
                     sortKeyInfos.shadingModel = nya::graphics::StringToShadingModel( nya::core::CRC32( dictionaryValue ) );
-                    getShadingModelResources( graphicsAssetCache );
+                    getShadingModelResources( graphicsAssetCache, useAsyncTextureLoading );
                     break;
 
                 case NYA_STRING_HASH( "Version" ):
-                    builderVersion = std::stoi( dictionaryValue );
+                    builderVersion = dictionaryValueToken.toInteger();
                     break;
 
                 case NYA_STRING_HASH( "ScaleUVByModelScale" ):
-                    sortKeyInfos.scaleUVByModelScale = nya::core::StringToBoolean( dictionaryValue );
+                    sortKeyInfos.scaleUVByModelScale = dictionaryValueToken.toBoolean();
                     break;
 
                 case NYA_STRING_HASH( "UseBaseColorsRGBSource" ):
-                    editableMaterialData.layers[currentLayerIndex].BaseColor.SamplingFlags = nya::core::StringToBoolean( dictionaryValue )
+                    editableMaterialData.layers[currentLayerIndex].BaseColor.SamplingFlags = dictionaryValueToken.toBoolean()
                         ? MaterialEditionInput::SRGB_SOURCE
                         : MaterialEditionInput::LINEAR_SOURCE;
                     break;
 
                 case NYA_STRING_HASH( "UseAlphaRoughnessSource" ):
-                    editableMaterialData.layers[currentLayerIndex].Roughness.SamplingFlags = nya::core::StringToBoolean( dictionaryValue )
+                    editableMaterialData.layers[currentLayerIndex].Roughness.SamplingFlags = dictionaryValueToken.toBoolean()
                         ? MaterialEditionInput::ALPHA_ROUGHNESS_SOURCE
                         : MaterialEditionInput::ROUGHNESS_SOURCE;
                     break;
 
                 case NYA_STRING_HASH( "IsNormalMapTangentSpace" ):
-                    editableMaterialData.layers[currentLayerIndex].Normal.SamplingFlags = nya::core::StringToBoolean( dictionaryValue )
+                    editableMaterialData.layers[currentLayerIndex].Normal.SamplingFlags = dictionaryValueToken.toBoolean()
                         ? MaterialEditionInput::TANGENT_SPACE_SOURCE
                         : MaterialEditionInput::WORLD_SPACE_SOURCE;
                     break;
 
                 case NYA_STRING_HASH( "IsSecondaryNormalMapTangentSpace" ):
-                    editableMaterialData.layers[currentLayerIndex].SecondaryNormal.SamplingFlags = nya::core::StringToBoolean( dictionaryValue )
+                    editableMaterialData.layers[currentLayerIndex].SecondaryNormal.SamplingFlags = dictionaryValueToken.toBoolean()
                         ? MaterialEditionInput::TANGENT_SPACE_SOURCE
                         : MaterialEditionInput::WORLD_SPACE_SOURCE;
                     break;
@@ -449,12 +445,10 @@ void Material::load( FileSystemObject* stream, GraphicsAssetCache* graphicsAsset
                 }
             }
         } else {
-            dictionaryKey = streamLine.substr( 0, keyValueSeparator );
-
-            // Trim both key and values (useful if a stream has inconsistent spacing, ...)
-            nya::core::TrimString( dictionaryKey );
+            // Trim the key (useful if a stream has inconsistent spacing, ...)
+            dictionaryKey = streamLine.trim();
 
-            auto keyHashcode = nya::core::CRC32( dictionaryKey.c_str() );
+            auto keyHashcode = dictionaryKey.hash();
 
             switch ( keyHashcode ) {
             case NYA_STRING_HASH( "Layer" ):
@@ -560,19 +554,20 @@ const Material::EditorBuffer& Material::getEditorBuffer() const
 
 void Material::bindDefaultTextureSet( ResourceList& resourceList ) const
 {
-    uint32_t resourceBindIndex = 14u;
+    uint32_t resourceBindIndex = 18u;
     for ( int32_t textureIdx = 0; textureIdx < defaultTextureSetCount; textureIdx++ ) {
         resourceList.resource[resourceBindIndex++].texture = defaultTextureSet[textureIdx];
     }
 }
 
-void Material::getShadingModelResources( GraphicsAssetCache* graphicsAssetCache )
+void Material::getShadingModelResources( GraphicsAssetCache* graphicsAssetCache, const bool useAsyncTextureLoading )
 {
     switch ( sortKeyInfos.shadingModel ) {
     case eShadingModel::SHADING_MODEL_CLEAR_COAT:
     case eShadingModel::SHADING_MODEL_STANDARD: {
         // Load BRDF DFG LUT
-        defaultTextureSet[0] = graphicsAssetCache->getTexture( NYA_STRING( "GameData/textures/DFG_LUT_Standard.dds" ) );
+        const nyaChar_t* DFG_LUT_NAME = NYA_STRING( "GameData/textures/DFG_LUT_Standard.dds" );
+        defaultTextureSet[0] = ( useAsyncTextureLoading ) ? graphicsAssetCache->getTextureAsync( DFG_LUT_NAME ) : graphicsAssetCache->getTexture( DFG_LUT_NAME );
         defaultTextureSetCount++;
     } break;
 
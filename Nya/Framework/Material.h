@@ -74,7 +74,8 @@ public:
     void                        create( RenderDevice* renderDevice, ShaderCache* shaderCache );
     void                        destroy( RenderDevice* renderDevice );
 
-    void                        load( FileSystemObject* stream, GraphicsAssetCache* graphicsAssetCache );
+    // If useAsyncTextureLoading is true, textures are requested asynchronously (placeholder textures are bound until they are loaded)
+    void                        load( FileSystemObject* stream, GraphicsAssetCache* graphicsAssetCache, const bool useAsyncTextureLoading = false );
 
     uint32_t                    getSortKey() const;
     bool                        isOpaque() const;
@@ -142,5 +143,5 @@ private:
 
 private:
     void                        bindDefaultTextureSet( ResourceList& resourceList ) const;
-    void                        getShadingModelResources( GraphicsAssetCache* graphicsAssetCache );
+    void                        getShadingModelResources( GraphicsAssetCache* graphicsAssetCache, const bool useAsyncTextureLoading );
 };
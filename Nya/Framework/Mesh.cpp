@@ -41,7 +41,7 @@ Mesh::~Mesh()
     aabb = {};
 }
 
-void Mesh::create( RenderDevice* renderDevice, const BufferDesc& vertexBufferDesc, const BufferDesc& indiceBufferDesc, const float* vertexBufferContent, const uint32_t* indiceBufferContent )
+void Mesh::create( RenderDevice* renderDevice, const BufferDesc& vertexBufferDesc, const BufferDesc& indiceBufferDesc, const float* vertexBufferContent, const void* indiceBufferContent )
 {
     vertexBuffer = renderDevice->createBuffer( vertexBufferDesc, vertexBufferContent );
     indiceBuffer = renderDevice->createBuffer( indiceBufferDesc, indiceBufferContent );
@@ -58,7 +58,7 @@ public:
                                 Mesh& operator = ( Mesh& mesh ) = default;
                                 ~Mesh();
 
-    void                        create( RenderDevice* renderDevice, const BufferDesc& vertexBufferDesc, const BufferDesc& indiceBufferDesc, const float* vertexBufferContent, const uint32_t* indiceBufferContent );
+    void                        create( RenderDevice* renderDevice, const BufferDesc& vertexBufferDesc, const BufferDesc& indiceBufferDesc, const float* vertexBufferContent, const void* indiceBufferContent );
     void                        destroy( RenderDevice* renderDevice );
 
     void                        addLevelOfDetail( const uint32_t lodIndex, const float lodDistance );
@@ -23,49 +23,116 @@
 #include <Maths/Transform.h>
 
 #include <Graphics/DrawCommandBuilder.h>
+#include <Graphics/GraphicsAssetCache.h>
 
 #include "Cameras/FreeCamera.h"
 #include "Light.h"
 
+#include <Graphics/LightGrid.h>
+
 #include <Core/EnvVarsRegister.h>
+#include <Core/Hashing/MurmurHash3.h>
 #include <Shaders/Shared.h>
 
+#include <algorithm>
+
 NYA_ENV_VAR( DisplayDebugIBLProbe, true, bool ) // [Debug] Display IBL Probe as reflective Sphere in the scene [True/False]
 NYA_ENV_VAR( DisplayGeometryAABB, true, bool ) // [Debug] Display Static Geometry AABB as wireframe boundingbox in the scene [True/False]
+NYA_ENV_VAR( DisplayPointLightVolume, false, bool ) // [Debug] Display Point Light influence volume as wireframe sphere in the scene [True/False]
+NYA_ENV_VAR( DisplayDebugGrid, false, bool ) // [Debug] Display a ground grid centered on the world origin [True/False]
+
+#if NYA_DEVBUILD
+static constexpr nyaStringHash_t DEBUG_GEOMETRY_AABB_BATCH_KEY = NYA_STRING_HASH( "Scene/GeometryAABB" );
+static constexpr nyaStringHash_t DEBUG_POINT_LIGHT_VOLUME_BATCH_KEY = NYA_STRING_HASH( "Scene/PointLightVolume" );
+static constexpr nyaStringHash_t DEBUG_GRID_BATCH_KEY = NYA_STRING_HASH( "Scene/Grid" );
+
+static bool IsSameDebugPrimitive( const AABB& left, const AABB& right )
+{
+    // NOTE AABB padding is left uninitialized (compare members individually)
+    return left.minPoint == right.minPoint && left.maxPoint == right.maxPoint;
+}
+
+static bool IsSameDebugPrimitive( nyaVec4f left, const nyaVec4f& right )
+{
+    return left == right;
+}
+
+// Write an entry of a retained debug batch content; returns true if the content has been modified
+template<typename T>
+static bool UpdateDebugBatchEntry( std::vector<T>& batchContent, const size_t entryIdx, const T& value )
+{
+    if ( entryIdx == batchContent.size() ) {
+        batchContent.push_back( value );
+        return true;
+    }
 
-Scene::Scene( BaseAllocator* allocator, const std::string& sceneName )
+    if ( IsSameDebugPrimitive( batchContent[entryIdx], value ) ) {
+        return false;
+    }
+
+    batchContent[entryIdx] = value;
+    return true;
+}
+
+// Remove the entries left from the previous submission; returns true if the content has been modified
+template<typename T>
+static bool TrimDebugBatchContent( std::vector<T>& batchContent, const size_t entryCount )
+{
+    if ( entryCount == batchContent.size() ) {
+        return false;
+    }
+
+    batchContent.resize( entryCount );
+    return true;
+}
+#endif
+
+Scene::Scene( BaseAllocator* allocator, GraphicsAssetCache* assetCache, const std::string& sceneName )
     : name( sceneName )
     , memoryAllocator( allocator )
+    , graphicsAssetCache( assetCache )
     , sceneAabb()
 {
     nya::maths::CreateAABB( sceneAabb, nyaVec3f( 0.0f ), nyaVec3f( 0.0f ) );
 
-    // TODO Test!!
-    TransformDatabase.components = nya::core::allocateArray<Transform>( allocator, 8192 );
-    TransformDatabase.capacity = 8192;
-
-    RenderableMeshDatabase.components = nya::core::allocateArray<RenderableMesh>( allocator, 1024 );
-    RenderableMeshDatabase.capacity = 1024;
-
-    FreeCameraDatabase.components = nya::core::allocateArray<FreeCamera>( allocator, 4 );
-    FreeCameraDatabase.capacity = 4;
-
-    IBLProbeDatabase.components = nya::core::allocateArray<IBLProbe>( allocator, MAX_IBL_PROBE_COUNT );
-    IBLProbeDatabase.capacity = MAX_IBL_PROBE_COUNT;
+#if NYA_DEVBUILD
+    // Batches are shared by scenes (overwrite whatever a previous scene has submitted)
+    isDebugGeometryAABBSubmitted = false;
+    isDebugPointLightVolumeSubmitted = false;
+    isDebugGridSubmitted = false;
+#endif
 
-    PointLightDatabase.components = nya::core::allocateArray<PointLight>( allocator, MAX_POINT_LIGHT_COUNT );
-    PointLightDatabase.capacity = MAX_POINT_LIGHT_COUNT;
+    TransformDatabase.create( allocator );
+    RenderableMeshDatabase.create( allocator );
+    FreeCameraDatabase.create( allocator );
+    IBLProbeDatabase.create( allocator );
+    PointLightDatabase.create( allocator );
 }
 
 Scene::~Scene()
 {
     name.clear();
 
-    nya::core::freeArray( memoryAllocator, TransformDatabase.components );
-    nya::core::freeArray( memoryAllocator, RenderableMeshDatabase.components );
-    nya::core::freeArray( memoryAllocator, FreeCameraDatabase.components );
-    nya::core::freeArray( memoryAllocator, IBLProbeDatabase.components );
-    nya::core::freeArray( memoryAllocator, PointLightDatabase.components );
+    for ( Node* node : sceneNodes ) {
+        nya::core::free( memoryAllocator, node );
+    }
+    sceneNodes.clear();
+
+    // Released components have a null mesh
+    for ( uint32_t staticGeomIdx = 0; staticGeomIdx < RenderableMeshDatabase.usageIndex; staticGeomIdx++ ) {
+        RenderableMesh& renderableMesh = RenderableMeshDatabase[staticGeomIdx];
+
+        if ( renderableMesh.meshResource != nullptr ) {
+            graphicsAssetCache->releaseMesh( renderableMesh.meshResource );
+            renderableMesh.meshResource = nullptr;
+        }
+    }
+
+    TransformDatabase.destroy();
+    RenderableMeshDatabase.destroy();
+    FreeCameraDatabase.destroy();
+    IBLProbeDatabase.destroy();
+    PointLightDatabase.destroy();
 }
 
 void Scene::setSceneName( const std::string& sceneName )
@@ -83,6 +150,12 @@ void Scene::updateLogic( const float deltaTime )
     // Propagate light transform prior to transform update
     for ( uint32_t pointLightIdx = 0; pointLightIdx < PointLightDatabase.usageIndex; pointLightIdx++ ) {
         auto& light = PointLightDatabase[pointLightIdx];
+
+        // Skip released lights
+        if ( light.pointLightData == nullptr ) {
+            continue;
+        }
+
         auto& transform = TransformDatabase[light.transform];
 
         light.pointLightData->worldPosition = transform.getLocalTranslation();
@@ -165,13 +238,72 @@ void Scene::collectDrawCmds( DrawCommandBuilder& drawCmdBuilder )
         }
     }
 
+    // Wireframe visualizations are drawn from persistent line batches (the content is only submitted when it has changed)
     if ( DisplayGeometryAABB ) {
+        bool isBatchModified = !isDebugGeometryAABBSubmitted;
+        size_t aabbCount = 0;
+
         for ( uint32_t staticGeomIdx = 0; staticGeomIdx < RenderableMeshDatabase.usageIndex; staticGeomIdx++ ) {
-            RenderableMesh& geometry = RenderableMeshDatabase[staticGeomIdx];
+            const RenderableMesh& geometry = RenderableMeshDatabase[staticGeomIdx];
 
             if ( geometry.isVisible ) {
-                drawCmdBuilder.addAABBToRender( geometry.meshBoundingBox, drawCmdBuilder.MaterialDebugWireframe );
+                isBatchModified |= UpdateDebugBatchEntry( debugGeometryAABBs, aabbCount++, geometry.meshBoundingBox );
+            }
+        }
+
+        isBatchModified |= TrimDebugBatchContent( debugGeometryAABBs, aabbCount );
+
+        if ( isBatchModified ) {
+            FramePacket::LineBatchUpdate& batchUpdate = drawCmdBuilder.updateLineBatch( DEBUG_GEOMETRY_AABB_BATCH_KEY );
+            batchUpdate.color = nyaVec4f( 0.0f, 1.0f, 0.0f, 1.0f );
+            batchUpdate.aabbs = debugGeometryAABBs;
+
+            isDebugGeometryAABBSubmitted = true;
+        } else {
+            drawCmdBuilder.addLineBatchToRender( DEBUG_GEOMETRY_AABB_BATCH_KEY );
+        }
+    }
+
+    if ( DisplayPointLightVolume ) {
+        bool isBatchModified = !isDebugPointLightVolumeSubmitted;
+        size_t sphereCount = 0;
+
+        for ( uint32_t pointLightIdx = 0; pointLightIdx < PointLightDatabase.usageIndex; pointLightIdx++ ) {
+            const PointLightData* pointLightData = PointLightDatabase[pointLightIdx].pointLightData;
+
+            // Skip released lights
+            if ( pointLightData == nullptr ) {
+                continue;
             }
+
+            const nyaVec4f lightVolume = nyaVec4f( pointLightData->worldPosition, pointLightData->radius );
+            isBatchModified |= UpdateDebugBatchEntry( debugPointLightVolumes, sphereCount++, lightVolume );
+        }
+
+        isBatchModified |= TrimDebugBatchContent( debugPointLightVolumes, sphereCount );
+
+        if ( isBatchModified ) {
+            FramePacket::LineBatchUpdate& batchUpdate = drawCmdBuilder.updateLineBatch( DEBUG_POINT_LIGHT_VOLUME_BATCH_KEY );
+            batchUpdate.color = nyaVec4f( 1.0f, 0.8f, 0.2f, 1.0f );
+            batchUpdate.spheres = debugPointLightVolumes;
+
+            isDebugPointLightVolumeSubmitted = true;
+        } else {
+            drawCmdBuilder.addLineBatchToRender( DEBUG_POINT_LIGHT_VOLUME_BATCH_KEY );
+        }
+    }
+
+    if ( DisplayDebugGrid ) {
+        if ( !isDebugGridSubmitted ) {
+            FramePacket::LineBatchUpdate& batchUpdate = drawCmdBuilder.updateLineBatch( DEBUG_GRID_BATCH_KEY );
+            batchUpdate.color = nyaVec4f( 0.5f, 0.5f, 0.5f, 1.0f );
+            batchUpdate.gridCenter = nyaVec3f( 0.0f, 0.0f, 0.0f );
+            batchUpdate.gridExtent = 64.0f;
+            batchUpdate.gridCellCount = 64u;
+
+            isDebugGridSubmitted = true;
+        } else {
+            drawCmdBuilder.addLineBatchToRender( DEBUG_GRID_BATCH_KEY );
         }
     }
 #endif
@@ -255,6 +387,56 @@ Scene::DirectionalLightNode* Scene::allocateDirectionalLight()
     return dirLightNode;
 }
 
+bool Scene::removeNode( Node* node, LightGrid* lightGrid )
+{
+    auto nodeIt = std::find( sceneNodes.begin(), sceneNodes.end(), node );
+    if ( nodeIt == sceneNodes.end() ) {
+        NYA_CWARN << "Node '" << node->name.c_str() << "' does not belong to the scene '" << name.c_str() << "'" << std::endl;
+        return false;
+    }
+
+    const nyaStringHash_t nodeType = node->getNodeType();
+    if ( nodeType == NYA_STRING_HASH( "IBLProbeNode" ) || nodeType == NYA_STRING_HASH( "DirectionalLightNode" ) ) {
+        NYA_CWARN << "Node '" << node->name.c_str() << "' can't be removed (the light grid can't release this kind of light)" << std::endl;
+        return false;
+    }
+
+    sceneNodes.erase( nodeIt );
+
+    for ( Node* sceneNode : sceneNodes ) {
+        auto& children = sceneNode->children;
+        children.erase( std::remove( children.begin(), children.end(), node ), children.end() );
+    }
+
+    node->remove( lightGrid );
+
+    // Reset the components so that the scene updates skip them until they are reused
+    if ( nodeType == NYA_STRING_HASH( "StaticGeometryNode" ) ) {
+        StaticGeometryNode* staticGeometryNode = static_cast<StaticGeometryNode*>( node );
+
+        RenderableMesh& renderableMesh = RenderableMeshDatabase[staticGeometryNode->mesh];
+        if ( renderableMesh.meshResource != nullptr ) {
+            graphicsAssetCache->releaseMesh( renderableMesh.meshResource );
+        }
+
+        renderableMesh.meshResource = nullptr;
+        renderableMesh.isVisible = 0;
+
+        RenderableMeshDatabase.release( staticGeometryNode->mesh );
+    } else if ( nodeType == NYA_STRING_HASH( "PointLightNode" ) ) {
+        PointLightNode* pointLightNode = static_cast<PointLightNode*>( node );
+        PointLightDatabase.release( pointLightNode->pointLight );
+    }
+
+    Transform defaultTransform;
+    TransformDatabase[node->transform] = defaultTransform;
+    TransformDatabase.release( node->transform );
+
+    nya::core::free( memoryAllocator, node );
+
+    return true;
+}
+
 const std::vector<Scene::Node*>& Scene::getNodes() const
 {
     return sceneNodes;
@@ -264,3 +446,55 @@ const AABB& Scene::getSceneAabb() const
 {
     return sceneAabb;
 }
+
+void Scene::PointLightNode::remove( LightGrid* lightGrid )
+{
+    if ( *pointLightData != nullptr ) {
+        lightGrid->releasePointLightData( *pointLightData );
+        *pointLightData = nullptr;
+    }
+}
+
+uint32_t Scene::computeContentHash() const
+{
+    uint32_t contentHash = 0;
+    auto hashContent = [&contentHash]( const void* key, const size_t keyLength ) {
+        MurmurHash3_x86_32( key, static_cast<int>( keyLength ), contentHash, &contentHash );
+    };
+
+    for ( uint32_t staticGeomIdx = 0; staticGeomIdx < RenderableMeshDatabase.usageIndex; staticGeomIdx++ ) {
+        const RenderableMesh& geometry = RenderableMeshDatabase[staticGeomIdx];
+        if ( !geometry.isVisible ) {
+            continue;
+        }
+
+        const nyaString_t& meshName = geometry.meshResource->getName();
+        hashContent( meshName.c_str(), meshName.size() * sizeof( nyaChar_t ) );
+        hashContent( TransformDatabase[geometry.transform].getWorldModelMatrix(), sizeof( nyaMat4x4f ) );
+        hashContent( &geometry.flags, sizeof( uint32_t ) );
+    }
+
+    for ( uint32_t pointLightIdx = 0; pointLightIdx < PointLightDatabase.usageIndex; pointLightIdx++ ) {
+        const PointLightData* pointLightData = PointLightDatabase[pointLightIdx].pointLightData;
+        if ( pointLightData == nullptr ) {
+            continue;
+        }
+
+        hashContent( pointLightData, sizeof( PointLightData ) );
+    }
+
+    for ( const Node* node : sceneNodes ) {
+        if ( node->getNodeType() != NYA_STRING_HASH( "DirectionalLightNode" ) ) {
+            continue;
+        }
+
+        // NOTE Hash members individually (the struct padding is left uninitialized)
+        const DirectionalLightData* dirLightData = static_cast<const DirectionalLightNode*>( node )->dirLightData;
+        hashContent( &dirLightData->colorRGB, sizeof( nyaVec3f ) );
+        hashContent( &dirLightData->direction, sizeof( nyaVec3f ) );
+        hashContent( &dirLightData->illuminanceInLux, sizeof( float ) );
+        hashContent( &dirLightData->isEnabled, sizeof( bool ) );
+    }
+
+    return contentHash;
+}
@@ -235,6 +235,8 @@ public:
             return NYA_STRING_HASH( "PointLightNode" );
         }
 
+        void remove( LightGrid* lightGrid ) override;
+
         bool intersect( const Ray& ray, float& hitDistance ) const override
         {
             BoundingSphere sphere;
@@ -302,45 +304,79 @@ public:
     };
 
 public:
-    template<typename T>
+    // Components are allocated per page so that the pointers to a component stay valid when the database grows
+    // Released handles are recycled by the next allocations; since handles stay in the [0..usageIndex) range, the
+    // owner of a component has to reset it to a state skipped by the scene updates before releasing it
+    template<typename T, uint32_t PageSize = 256u>
     struct ComponentDatabase
     {
-        T* components;
-        size_t                  capacity;
-        nyaComponentHandle_t    usageIndex;
+        BaseAllocator*                      memoryAllocator;
+        std::vector<T*>                     pages;
+        std::vector<nyaComponentHandle_t>   freeHandles;
+        nyaComponentHandle_t                usageIndex;
 
         ComponentDatabase()
-            : components( nullptr )
-            , capacity( 0ull )
+            : memoryAllocator( nullptr )
             , usageIndex( 0u )
         {
 
         }
 
+        void create( BaseAllocator* allocator )
+        {
+            memoryAllocator = allocator;
+        }
+
+        void destroy()
+        {
+            for ( T* page : pages ) {
+                nya::core::freeArray( memoryAllocator, page );
+            }
+
+            pages.clear();
+            freeHandles.clear();
+            usageIndex = 0u;
+        }
+
         nyaComponentHandle_t allocate()
         {
-            return ( usageIndex++ % capacity );
+            if ( !freeHandles.empty() ) {
+                const nyaComponentHandle_t handle = freeHandles.back();
+                freeHandles.pop_back();
+                return handle;
+            }
+
+            if ( ( usageIndex / PageSize ) >= pages.size() ) {
+                pages.push_back( nya::core::allocateArray<T>( memoryAllocator, PageSize ) );
+            }
+
+            return usageIndex++;
+        }
+
+        void release( const nyaComponentHandle_t handle )
+        {
+            freeHandles.push_back( handle );
         }
 
         T& operator [] ( const nyaComponentHandle_t handle )
         {
-            return components[handle];
+            return pages[handle / PageSize][handle % PageSize];
         }
 
         T& operator [] ( const nyaComponentHandle_t handle ) const
         {
-            return components[handle];
+            return pages[handle / PageSize][handle % PageSize];
         }
     };
 
-    ComponentDatabase<FreeCamera>       FreeCameraDatabase;
+    ComponentDatabase<FreeCamera, 4u>   FreeCameraDatabase;
     ComponentDatabase<Transform>        TransformDatabase;
     ComponentDatabase<RenderableMesh>   RenderableMeshDatabase;
-    ComponentDatabase<IBLProbe>         IBLProbeDatabase;
+    ComponentDatabase<IBLProbe, 16u>    IBLProbeDatabase;
     ComponentDatabase<PointLight>       PointLightDatabase;
 
 public:
-                            Scene( BaseAllocator* allocator, const std::string& sceneName = "Default Scene" );
+                            Scene( BaseAllocator* allocator, GraphicsAssetCache* assetCache, const std::string& sceneName = "Default Scene" );
                             Scene( Scene& scene ) = default;
                             Scene& operator = ( Scene& scene ) = default;
                             ~Scene();
@@ -358,13 +394,30 @@ public:
     IBLProbeNode*           allocateIBLProbe();
     DirectionalLightNode*   allocateDirectionalLight();
 
+    // Remove the node from the scene, release its components (and the cached assets they reference) and free it
+    // Returns false if the node can't be removed (IBL probes can't be released from the light grid)
+    bool                    removeNode( Node* node, LightGrid* lightGrid );
+
     const std::vector<Node*>&     getNodes() const;
     const AABB&                   getSceneAabb() const;
 
+    // Hash of the scene content affecting baked lighting (static geometry, lights)
+    uint32_t                      computeContentHash() const;
+
 private:
     std::string             name;
     BaseAllocator*          memoryAllocator;
+    GraphicsAssetCache*     graphicsAssetCache; // Renderable meshes hold a reference on their mesh
 
     AABB                    sceneAabb;
     std::vector<Node*>      sceneNodes;
+
+#if NYA_DEVBUILD
+    // Last content submitted to the persistent debug line batches (a batch is only resubmitted when its content changes)
+    std::vector<AABB>       debugGeometryAABBs;
+    std::vector<nyaVec4f>   debugPointLightVolumes;
+    bool                    isDebugGeometryAABBSubmitted;
+    bool                    isDebugPointLightVolumeSubmitted;
+    bool                    isDebugGridSubmitted;
+#endif
 };
@@ -0,0 +1,231 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "CSMUpdateScheduler.h"
+
+#include <Framework/Cameras/Camera.h>
+#include <Framework/Light.h>
+#include <Framework/DirectionalLightHelpers.h>
+
+#include <Core/EnvVarsRegister.h>
+
+#include <Maths/Helpers.h>
+
+#include <cmath>
+
+NYA_ENV_VAR( CSMAutomaticSplits, true, bool ) // "Compute CSM split distances from the depth range of the visible geometry (fixed splits are used otherwise)"
+NYA_ENV_VAR( CSMSplitLambda, 0.8f, float ) // "Blend factor between uniform (0) and logarithmic (1) CSM split distances [0..1]"
+NYA_ENV_VAR( CSMFarCascadeUpdatePeriod, 4, uint32_t ) // "Update period (in frames) of the far CSM cascades (1 updates every cascade each frame)"
+
+// Rate at which the visible depth range shrinks (the range grows instantly)
+static constexpr float DEPTH_RANGE_SHRINK_RATE = 0.05f;
+
+// Cached cascades are rendered with a bigger projection so that the slice stays covered between two updates
+static constexpr float CACHED_CASCADE_RADIUS_MARGIN = 0.15f;
+
+// Min cosine between the cached and current light directions before a cascade is invalidated
+static constexpr float LIGHT_DIRECTION_TOLERANCE = 0.99999f;
+
+static constexpr const char* CASCADE_DRAW_COUNT_STAT_NAMES[CSM_SLICE_COUNT] = {
+    "CSM Cascade 0 Draw Count",
+    "CSM Cascade 1 Draw Count",
+    "CSM Cascade 2 Draw Count",
+    "CSM Cascade 3 Draw Count",
+};
+
+CSMUpdateScheduler::CSMUpdateScheduler()
+    : frameIndex( 0u )
+    , smoothedMinDepth( -1.0f )
+    , smoothedMaxDepth( -1.0f )
+{
+    for ( CascadeState& state : cascadeStates ) {
+        state.ShadowMatrix = nyaMat4x4f::Identity;
+        state.BoundingSphereCenter = nyaVec3f( 0.0f, 0.0f, 0.0f );
+        state.BoundingSphereRadius = 0.0f;
+        state.LightDirection = nyaVec3f( 0.0f, 0.0f, 0.0f );
+        state.LastUpdateFrame = 0u;
+        state.DrawCount = 0u;
+        state.IsValid = 0;
+    }
+}
+
+CSMUpdateScheduler::~CSMUpdateScheduler()
+{
+    frameIndex = 0u;
+    smoothedMinDepth = -1.0f;
+    smoothedMaxDepth = -1.0f;
+}
+
+uint32_t CSMUpdateScheduler::scheduleUpdates( const DirectionalLightData* sunLight, CameraData* cameraData, const float visibleMinDepth, const float visibleMaxDepth )
+{
+    frameIndex++;
+
+    float nearPlane, farPlane;
+    nya::framework::CSMGetDepthRange( cameraData, nearPlane, farPlane );
+
+    updateDepthRange( nearPlane, farPlane, visibleMinDepth, visibleMaxDepth );
+
+    float splitDistances[CSM_SLICE_COUNT];
+    computeSplitDistances( nearPlane, farPlane, splitDistances );
+
+    cameraData->globalShadowMatrix = nya::framework::CSMCreateGlobalShadowMatrix( sunLight->direction, cameraData->depthViewProjectionMatrix );
+
+    const nyaVec3f lightDirection = sunLight->direction.normalize();
+    const uint32_t updatePeriod = nya::maths::max( 1u, static_cast<uint32_t>( CSMFarCascadeUpdatePeriod ) );
+
+    uint32_t cascadeUpdateMask = 0u;
+    for ( uint32_t cascadeIdx = 0u; cascadeIdx < CSM_SLICE_COUNT; cascadeIdx++ ) {
+        const float prevSplitDist = ( cascadeIdx == 0u ) ? 0.0f : splitDistances[cascadeIdx - 1u];
+        const float splitDist = splitDistances[cascadeIdx];
+
+        nyaVec3f sliceCenter;
+        float sliceRadius;
+        nya::framework::CSMComputeSliceBoundingSphere( cameraData, prevSplitDist, splitDist, sliceCenter, sliceRadius );
+
+        CascadeState& state = cascadeStates[cascadeIdx];
+
+        const bool isCachedCascade = ( cascadeIdx >= ALWAYS_UPDATED_CASCADE_COUNT && updatePeriod > 1u );
+        const bool isScheduled = !isCachedCascade || ( ( frameIndex + cascadeIdx ) % updatePeriod ) == 0u;
+
+        if ( isScheduled || needUpdate( cascadeIdx, lightDirection, sliceCenter, sliceRadius ) ) {
+            const float cascadeRadius = ( isCachedCascade )
+                ? std::ceil( sliceRadius * ( 1.0f + CACHED_CASCADE_RADIUS_MARGIN ) * 16.0f ) / 16.0f
+                : sliceRadius;
+
+            state.ShadowMatrix = nya::framework::CSMComputeSliceShadowMatrix( lightDirection, sliceCenter, cascadeRadius );
+            state.BoundingSphereCenter = sliceCenter;
+            state.BoundingSphereRadius = cascadeRadius;
+            state.LightDirection = lightDirection;
+            state.LastUpdateFrame = frameIndex;
+            state.IsValid = 1;
+
+            cascadeUpdateMask |= ( 1u << cascadeIdx );
+        } else {
+            setCascadeDrawCount( cascadeIdx, 0u );
+        }
+
+        nya::framework::CSMUpdateCameraSliceData( static_cast<int>( cascadeIdx ), state.ShadowMatrix, nearPlane + splitDist * ( farPlane - nearPlane ), cameraData );
+    }
+
+    cameraData->globalShadowMatrix = cameraData->globalShadowMatrix.transpose();
+
+    uint32_t updatedCascadeCount = 0u;
+    for ( uint32_t cascadeIdx = 0u; cascadeIdx < CSM_SLICE_COUNT; cascadeIdx++ ) {
+        updatedCascadeCount += ( cascadeUpdateMask >> cascadeIdx ) & 1u;
+    }
+
+    NYA_PROFILE_STAT( "CSM Cascades Updated", updatedCascadeCount )
+    NYA_PROFILE_STAT( "CSM Visible Depth Min", smoothedMinDepth )
+    NYA_PROFILE_STAT( "CSM Visible Depth Max", smoothedMaxDepth )
+
+    return cascadeUpdateMask;
+}
+
+void CSMUpdateScheduler::invalidateCascades()
+{
+    for ( CascadeState& state : cascadeStates ) {
+        state.IsValid = 0;
+    }
+}
+
+void CSMUpdateScheduler::setCascadeDrawCount( const uint32_t cascadeIdx, const uint32_t drawCount )
+{
+    NYA_DEV_ASSERT( cascadeIdx < CSM_SLICE_COUNT, "Cascade index out of bounds (%u >= %u)", cascadeIdx, CSM_SLICE_COUNT );
+
+    cascadeStates[cascadeIdx].DrawCount = drawCount;
+
+    NYA_PROFILE_STAT( CASCADE_DRAW_COUNT_STAT_NAMES[cascadeIdx], drawCount )
+}
+
+uint32_t CSMUpdateScheduler::getCascadeDrawCount( const uint32_t cascadeIdx ) const
+{
+    NYA_DEV_ASSERT( cascadeIdx < CSM_SLICE_COUNT, "Cascade index out of bounds (%u >= %u)", cascadeIdx, CSM_SLICE_COUNT );
+
+    return cascadeStates[cascadeIdx].DrawCount;
+}
+
+void CSMUpdateScheduler::updateDepthRange( const float nearPlane, const float farPlane, const float visibleMinDepth, const float visibleMaxDepth )
+{
+    // Fallback to the whole shadow frustum if nothing is visible
+    const bool isRangeValid = ( visibleMinDepth >= 0.0f && visibleMaxDepth > visibleMinDepth );
+
+    const float targetMinDepth = ( isRangeValid ) ? nya::maths::clamp( visibleMinDepth, nearPlane, farPlane ) : nearPlane;
+    const float targetMaxDepth = ( isRangeValid ) ? nya::maths::clamp( visibleMaxDepth, nearPlane, farPlane ) : farPlane;
+
+    if ( smoothedMinDepth < 0.0f || smoothedMaxDepth < 0.0f ) {
+        smoothedMinDepth = targetMinDepth;
+        smoothedMaxDepth = targetMaxDepth;
+        return;
+    }
+
+    // Grow instantly (to avoid missing shadows) and shrink slowly (to avoid visible cascade transitions)
+    smoothedMinDepth = ( targetMinDepth < smoothedMinDepth ) ? targetMinDepth : nya::maths::lerp( smoothedMinDepth, targetMinDepth, DEPTH_RANGE_SHRINK_RATE );
+    smoothedMaxDepth = ( targetMaxDepth > smoothedMaxDepth ) ? targetMaxDepth : nya::maths::lerp( smoothedMaxDepth, targetMaxDepth, DEPTH_RANGE_SHRINK_RATE );
+
+    smoothedMinDepth = nya::maths::clamp( smoothedMinDepth, nearPlane, farPlane );
+    smoothedMaxDepth = nya::maths::clamp( smoothedMaxDepth, smoothedMinDepth, farPlane );
+}
+
+void CSMUpdateScheduler::computeSplitDistances( const float nearPlane, const float farPlane, float splitDistances[CSM_SLICE_COUNT] ) const
+{
+    if ( !static_cast<bool>( CSMAutomaticSplits ) ) {
+        for ( uint32_t cascadeIdx = 0u; cascadeIdx < CSM_SLICE_COUNT; cascadeIdx++ ) {
+            splitDistances[cascadeIdx] = CascadeSplits[cascadeIdx];
+        }
+        return;
+    }
+
+    const float lambda = nya::maths::clamp( static_cast<float>( CSMSplitLambda ), 0.0f, 1.0f );
+
+    const float minZ = nya::maths::max( smoothedMinDepth, nya::maths::max( nearPlane, 1e-3f ) );
+    const float maxZ = nya::maths::max( smoothedMaxDepth, minZ + 1e-3f );
+
+    const float depthRange = maxZ - minZ;
+    const float depthRatio = maxZ / minZ;
+    const float clipRange = farPlane - nearPlane;
+
+    // Practical split scheme (blend between logarithmic and uniform splits)
+    for ( uint32_t cascadeIdx = 0u; cascadeIdx < CSM_SLICE_COUNT; cascadeIdx++ ) {
+        const float p = static_cast<float>( cascadeIdx + 1u ) / static_cast<float>( CSM_SLICE_COUNT );
+        const float logSplit = minZ * std::pow( depthRatio, p );
+        const float uniformSplit = minZ + depthRange * p;
+        const float splitDepth = nya::maths::lerp( uniformSplit, logSplit, lambda );
+
+        // Splits are normalized between the shadow frustum near and far planes
+        splitDistances[cascadeIdx] = nya::maths::clamp( ( splitDepth - nearPlane ) / clipRange, 0.0f, 1.0f );
+    }
+}
+
+bool CSMUpdateScheduler::needUpdate( const uint32_t cascadeIdx, const nyaVec3f& lightDirection, const nyaVec3f& sliceCenter, const float sliceRadius ) const
+{
+    const CascadeState& state = cascadeStates[cascadeIdx];
+
+    if ( !state.IsValid ) {
+        return true;
+    }
+
+    if ( nyaVec3f::dot( state.LightDirection, lightDirection ) < LIGHT_DIRECTION_TOLERANCE ) {
+        return true;
+    }
+
+    // The cached projection must fully contain the current slice
+    const float centerDistance = ( state.BoundingSphereCenter - sliceCenter ).length();
+    return ( centerDistance + sliceRadius ) > state.BoundingSphereRadius;
+}
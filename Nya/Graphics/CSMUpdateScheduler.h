@@ -0,0 +1,80 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <Maths/Vector.h>
+#include <Maths/Matrix.h>
+#include <Shaders/ShadowMappingShared.h>
+
+struct CameraData;
+struct DirectionalLightData;
+
+// Decides which sun shadow cascades are rendered each frame
+// Near cascades are updated every frame; far cascades are cached in a persistent shadow map and
+// refreshed on a staggered schedule (or as soon as the cached projection no longer covers the slice)
+// Split distances are derived from the depth range of the visible geometry (practical split scheme)
+class CSMUpdateScheduler
+{
+public:
+    // Cascades updated every frame (starting from the nearest cascade)
+    static constexpr uint32_t       ALWAYS_UPDATED_CASCADE_COUNT = 2u;
+
+public:
+                                    CSMUpdateScheduler();
+                                    CSMUpdateScheduler( CSMUpdateScheduler& ) = delete;
+                                    CSMUpdateScheduler& operator = ( CSMUpdateScheduler& ) = delete;
+                                    ~CSMUpdateScheduler();
+
+    // Compute the cascades of the camera (writes shadow matrices, split distances and cascade offset/scale to cameraData)
+    // Returns the mask of the cascades which need to be rendered this frame
+    // NOTE visibleMinDepth/visibleMaxDepth are view space depths (a negative range means the depth range is unknown)
+    uint32_t                        scheduleUpdates( const DirectionalLightData* sunLight, CameraData* cameraData, const float visibleMinDepth, const float visibleMaxDepth );
+
+    // Force the update of every cascade on the next call to scheduleUpdates
+    void                            invalidateCascades();
+
+    void                            setCascadeDrawCount( const uint32_t cascadeIdx, const uint32_t drawCount );
+    uint32_t                        getCascadeDrawCount( const uint32_t cascadeIdx ) const;
+
+private:
+    struct CascadeState
+    {
+        nyaMat4x4f  ShadowMatrix;
+        nyaVec3f    BoundingSphereCenter;
+        float       BoundingSphereRadius;
+        nyaVec3f    LightDirection;
+        uint32_t    LastUpdateFrame;
+        uint32_t    DrawCount;
+        uint8_t     IsValid : 1;
+    };
+
+private:
+    CascadeState                    cascadeStates[CSM_SLICE_COUNT];
+    uint32_t                        frameIndex;
+
+    // Smoothed depth range of the visible geometry (avoids popping when the range changes suddenly)
+    float                           smoothedMinDepth;
+    float                           smoothedMaxDepth;
+
+private:
+    void                            updateDepthRange( const float nearPlane, const float farPlane, const float visibleMinDepth, const float visibleMaxDepth );
+    void                            computeSplitDistances( const float nearPlane, const float farPlane, float splitDistances[CSM_SLICE_COUNT] ) const;
+    bool                            needUpdate( const uint32_t cascadeIdx, const nyaVec3f& lightDirection, const nyaVec3f& sliceCenter, const float sliceRadius ) const;
+};
@@ -31,6 +31,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "RenderPipeline.h"
 #include "LightGrid.h"
 #include "GraphicsAssetCache.h"
+#include "IBLProbeCache.h"
+#include "FramePacket.h"
 
 #include <Rendering/RenderDevice.h>
 
@@ -39,6 +41,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "RenderModules/ProbeCaptureModule.h"
 #include "RenderModules/LineRenderingModule.h"
 #include "RenderModules/TextRenderingModule.h"
+#include "RenderModules/LocalShadowRenderModule.h"
 #include "RenderPasses/PresentRenderPass.h"
 #include "RenderPasses/LightRenderPass.h"
 #include "RenderPasses/HUDRenderPass.h"
@@ -54,10 +57,23 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <Shaders/Shared.h>
 
 #include <Core/EnvVarsRegister.h>
-#include <Core/Allocators/StackAllocator.h>
-#include <Core/Allocators/PoolAllocator.h>
+#include <Core/Timer.h>
+
+#include <string.h>
+#include <algorithm>
 
 NYA_ENV_VAR( DisplayDebugIBLProbe, true, bool )
+NYA_ENV_VAR( LocalShadowMaxFaceUpdates, 12, uint32_t ) // "Max number of local light shadow faces rendered per frame (cached faces are reused) [0..64]"
+NYA_ENV_VAR( LocalShadowMaxDistance, 64.0f, float ) // "Max distance between the viewer and a shadow casting local light (in world units)"
+NYA_ENV_VAR( IBLProbeBakeMode, false, bool ) // "Ignore the IBL probe cache, capture every probe and write the results to the cache"
+
+// Upper bound of probe commands (captures + convolutions) issued in a single frame
+static constexpr uint32_t MAX_PROBE_COMMAND_PER_FRAME = 32u;
+
+// Render pipeline view keys (GPU timings are tagged with the key of the view rendered)
+static constexpr nyaStringHash_t CAMERA_VIEW_KEY = NYA_STRING_HASH( "Camera" ); // + camera index
+static constexpr nyaStringHash_t IBL_PROBE_CAPTURE_VIEW_KEY = NYA_STRING_HASH( "IBLProbeCapture" );
+static constexpr nyaStringHash_t IBL_PROBE_CONVOLUTION_VIEW_KEY = NYA_STRING_HASH( "IBLProbeConvolution" );
 
 nyaMat4x4f GetProbeCaptureViewMatrix( const nyaVec3f& probePositionWorldSpace, const eProbeCaptureStep captureStep )
 {
@@ -134,28 +150,46 @@ float CullSphereInfReversedZ( const Frustum* frustum, const nyaVec3f& vCenter, f
     return nya::maths::min( nya::maths::min( dist01, dist23 ), dist45 ) + fRadius;
 }
 
+// Frustum cullling on a sphere (all six planes). Returns > 0 if visible, <= 0 otherwise
+float CullSphere( const Frustum* frustum, const nyaVec3f& vCenter, float fRadius )
+{
+    float dist01 = nya::maths::min( DistanceToPlane( frustum->planes[0], vCenter ), DistanceToPlane( frustum->planes[1], vCenter ) );
+    float dist23 = nya::maths::min( DistanceToPlane( frustum->planes[2], vCenter ), DistanceToPlane( frustum->planes[3], vCenter ) );
+    float dist45 = nya::maths::min( DistanceToPlane( frustum->planes[4], vCenter ), DistanceToPlane( frustum->planes[5], vCenter ) );
+
+    return nya::maths::min( nya::maths::min( dist01, dist23 ), dist45 ) + fRadius;
+}
+
+// Conservative world space bounds of a mesh instance (valid for any instance rotation)
+AABB ComputeInstanceWorldBounds( const Mesh* mesh, const nyaMat4x4f& modelMatrix )
+{
+    const nyaVec3f instancePosition = nya::maths::ExtractTranslation( modelMatrix );
+    const float instanceScale = nya::maths::GetBiggestScalar( nya::maths::ExtractScale( modelMatrix ) );
+
+    const AABB& meshAABB = mesh->getMeshAABB();
+    const float extent = ( nya::maths::GetAABBCentroid( meshAABB ).length() + nya::maths::GetAABBHalfExtents( meshAABB ).length() ) * instanceScale;
+
+    AABB worldBounds;
+    nya::maths::CreateAABB( worldBounds, instancePosition, nyaVec3f( extent, extent, extent ) );
+
+    return worldBounds;
+}
+
 DrawCommandBuilder::DrawCommandBuilder( BaseAllocator* allocator )
     : memoryAllocator( allocator )
+    , submissionPacket( nullptr )
+    , renderPacket( nullptr )
+    , iblProbeCache( nullptr )
 {
-    cameras = nya::core::allocate<PoolAllocator>( allocator, sizeof( CameraData* ), 4, 8 * sizeof( CameraData* ), allocator->allocate( 8 * sizeof( CameraData* ) ) );
-    meshes = nya::core::allocate<PoolAllocator>( allocator, sizeof( MeshInstance ), 4, 4096 * sizeof( MeshInstance ), allocator->allocate( 4096 * sizeof( MeshInstance ) ) );
-    spheresToRender = nya::core::allocate<PoolAllocator>( allocator, sizeof( PrimitiveInstance ), 4, 4096 * sizeof( PrimitiveInstance ), allocator->allocate( 4096 * sizeof( PrimitiveInstance ) ) );
-    primitivesToRender = nya::core::allocate<PoolAllocator>( allocator, sizeof( PrimitiveInstance ), 4, 4096 * sizeof( PrimitiveInstance ), allocator->allocate( 4096 * sizeof( PrimitiveInstance ) ) );
-    textToRenderAllocator = nya::core::allocate<PoolAllocator>( allocator, sizeof( TextDrawCommand ), 4, 1024 * sizeof( TextDrawCommand ), allocator->allocate( 1024 * sizeof( TextDrawCommand ) ) );
-
-    probeCaptureCmdAllocator = nya::core::allocate<StackAllocator>( allocator, 16 * 6 * sizeof( IBLProbeCaptureCommand ), allocator->allocate( 16 * 6 * sizeof( IBLProbeCaptureCommand ) ) );
-    probeConvolutionCmdAllocator = nya::core::allocate<StackAllocator>( allocator, 16 * 8 * 6 * sizeof( IBLProbeConvolutionCommand ), allocator->allocate( 16 * 8 * 6 * sizeof( IBLProbeConvolutionCommand ) ) );
+    lineBatchHandles.create( allocator, LINE_RENDERING_MAX_STATIC_BATCH_COUNT );
 }
 
 DrawCommandBuilder::~DrawCommandBuilder()
 {
-    nya::core::free( memoryAllocator, cameras );
-    nya::core::free( memoryAllocator, meshes );
-    nya::core::free( memoryAllocator, spheresToRender );
-    nya::core::free( memoryAllocator, primitivesToRender );
-    nya::core::free( memoryAllocator, textToRenderAllocator );
-    nya::core::free( memoryAllocator, probeCaptureCmdAllocator );
-    nya::core::free( memoryAllocator, probeConvolutionCmdAllocator );
+    submissionPacket = nullptr;
+    renderPacket = nullptr;
+
+    lineBatchHandles.destroy();
 
 #if NYA_DEVBUILD
     MaterialDebugIBLProbe = nullptr;
@@ -170,57 +204,62 @@ void DrawCommandBuilder::loadDebugResources( GraphicsAssetCache* graphicsAssetCa
 }
 #endif
 
+void DrawCommandBuilder::setSubmissionPacket( FramePacket* framePacket )
+{
+    submissionPacket = framePacket;
+}
+
 void DrawCommandBuilder::addGeometryToRender( const Mesh* meshResource, const nyaMat4x4f* modelMatrix, const uint32_t flagset )
 {
-    auto* mesh = nya::core::allocate<MeshInstance>( meshes );
+    auto* mesh = submissionPacket->meshes.push();
+    if ( mesh == nullptr ) {
+        return;
+    }
+
     mesh->mesh = meshResource;
-    mesh->modelMatrix = modelMatrix;
+    mesh->modelMatrix = *modelMatrix;
+    mesh->modelMatrixKey = modelMatrix;
     mesh->flags = flagset;
 }
 
 void DrawCommandBuilder::addSphereToRender( const nyaVec3f& sphereCenter, const float sphereRadius, Material* material )
 {
-    auto sphereMatrix = nya::core::allocate<PrimitiveInstance>( spheresToRender );
+    auto sphereMatrix = submissionPacket->spheres.push();
+    if ( sphereMatrix == nullptr ) {
+        return;
+    }
+
     sphereMatrix->modelMatrix = nya::maths::MakeTranslationMat( sphereCenter ) *  nya::maths::MakeScaleMat( sphereRadius );
     sphereMatrix->material = material;
 }
 
 void DrawCommandBuilder::addAABBToRender( const AABB& aabb, Material* material )
 {
-    auto sphereMatrix = nya::core::allocate<PrimitiveInstance>( spheresToRender );
+    auto sphereMatrix = submissionPacket->spheres.push();
+    if ( sphereMatrix == nullptr ) {
+        return;
+    }
+
     sphereMatrix->modelMatrix = nya::maths::MakeTranslationMat( nya::maths::GetAABBCentroid( aabb ) ) *  nya::maths::MakeScaleMat( nya::maths::GetAABBHalfExtents( aabb ) );
     sphereMatrix->material = material;
 }
 
 void DrawCommandBuilder::addCamera( CameraData* cameraData )
 {
-    auto camera = nya::core::allocate<CameraData*>( cameras );
-    *camera = cameraData;
+    if ( submissionPacket->cameraCount >= FramePacket::MAX_CAMERA_COUNT ) {
+        NYA_CWARN << "Too many cameras submitted (max is set to " << FramePacket::MAX_CAMERA_COUNT << ")" << std::endl;
+        return;
+    }
+
+    submissionPacket->cameras[submissionPacket->cameraCount++] = *cameraData;
 }
 
 void DrawCommandBuilder::addIBLProbeToCapture( const IBLProbeData* probeData )
 {
-    for ( uint32_t i = 0; i < 6; i++ ) {
-        auto* probeCaptureCmd = nya::core::allocate<IBLProbeCaptureCommand>( probeCaptureCmdAllocator );
-        probeCaptureCmd->CommandInfos.EnvProbeArrayIndex = probeData->ProbeIndex;
-        probeCaptureCmd->CommandInfos.Step = static_cast<eProbeCaptureStep>( i );
-        probeCaptureCmd->Probe = probeData;
-
-        probeCaptureCmds.push( probeCaptureCmd );
-
-        for ( uint16_t mipIndex = 0; mipIndex < 8; mipIndex++ ) {
-            auto* probeConvolutionCmd = nya::core::allocate<IBLProbeConvolutionCommand>( probeConvolutionCmdAllocator );
-            probeConvolutionCmd->CommandInfos.EnvProbeArrayIndex = probeData->ProbeIndex;
-            probeConvolutionCmd->CommandInfos.Step = static_cast<eProbeCaptureStep>( i );
-            probeConvolutionCmd->CommandInfos.MipIndex = mipIndex;
-            probeConvolutionCmd->Probe = probeData;
-
-            probeConvolutionCmds.push( probeConvolutionCmd );
-        }
-    }
+    submissionPacket->iblProbesToCapture.push_back( probeData->ProbeIndex );
 }
 
-void DrawCommandBuilder::addHUDRectangle( const nyaVec2f& positionScreenSpace, const nyaVec2f& dimensionScreenSpace, const float rotationInRadians, Material* material )
+nyaMat4x4f nya::graphics::ComputeHUDRectangleModelMatrix( const nyaVec2f& positionScreenSpace, const nyaVec2f& dimensionScreenSpace, const float rotationInRadians )
 {
     nyaMat4x4f mat1 = nya::maths::MakeTranslationMat( nyaVec3f( positionScreenSpace, 0.0f ) );
 
@@ -228,43 +267,215 @@ void DrawCommandBuilder::addHUDRectangle( const nyaVec2f& positionScreenSpace, c
     nyaMat4x4f mat3 = nya::maths::MakeRotationMatrix( rotationInRadians, nyaVec3f( 0.0f, 0.0f, 1.0f ), mat2 );
     nyaMat4x4f mat4 = nya::maths::MakeTranslationMat( nyaVec3f( -0.5f * dimensionScreenSpace.x, -0.5f * dimensionScreenSpace.y, 0.0f ), mat3 );
 
-    nyaMat4x4f mat5 = nya::maths::MakeScaleMat( nyaVec3f( dimensionScreenSpace, 1.0f ), mat4 );
+    return nya::maths::MakeScaleMat( nyaVec3f( dimensionScreenSpace, 1.0f ), mat4 );
+}
+
+void DrawCommandBuilder::addHUDRectangle( const nyaVec2f& positionScreenSpace, const nyaVec2f& dimensionScreenSpace, const float rotationInRadians, Material* material )
+{
+    addHUDRectangle( nya::graphics::ComputeHUDRectangleModelMatrix( positionScreenSpace, dimensionScreenSpace, rotationInRadians ), material );
+}
 
-    auto primInstance = nya::core::allocate<PrimitiveInstance>( primitivesToRender );
-    primInstance->modelMatrix = mat5;
+void DrawCommandBuilder::addHUDRectangle( const nyaMat4x4f& modelMatrix, Material* material )
+{
+    auto primInstance = submissionPacket->primitives.push();
+    if ( primInstance == nullptr ) {
+        return;
+    }
+
+    primInstance->modelMatrix = modelMatrix;
     primInstance->material = material;
 }
 
 void DrawCommandBuilder::addHUDText( const nyaVec2f& positionScreenSpace, const float size, const nyaVec4f& colorAndAlpha, const std::string& value )
 {
-    auto textCmd = nya::core::allocate<TextDrawCommand>( textToRenderAllocator );
+    addHUDText( positionScreenSpace, size, colorAndAlpha, value, nya::core::CRC32( value ) );
+}
+
+void DrawCommandBuilder::addHUDText( const nyaVec2f& positionScreenSpace, const float size, const nyaVec4f& colorAndAlpha, const std::string& value, const nyaStringHash_t valueHashcode )
+{
+    auto textCmd = submissionPacket->texts.push();
+    if ( textCmd == nullptr ) {
+        return;
+    }
+
     textCmd->stringToPrint = value;
+    textCmd->stringHashcode = valueHashcode;
     textCmd->color = colorAndAlpha;
     textCmd->scale = size;
     textCmd->positionScreenSpace = positionScreenSpace;
 }
 
-void DrawCommandBuilder::buildRenderQueues( WorldRenderer* worldRenderer, LightGrid* lightGrid )
+void DrawCommandBuilder::addHUDRectangle( const FramePacket::PrimitiveInstance& rectangleCmd )
+{
+    auto primInstance = submissionPacket->primitives.push();
+    if ( primInstance == nullptr ) {
+        return;
+    }
+
+    *primInstance = rectangleCmd;
+}
+
+void DrawCommandBuilder::addHUDText( const FramePacket::TextDrawCommand& textCmd )
+{
+    auto packetTextCmd = submissionPacket->texts.push();
+    if ( packetTextCmd == nullptr ) {
+        return;
+    }
+
+    *packetTextCmd = textCmd;
+}
+
+void DrawCommandBuilder::addLineToRender( const nyaVec3f& from, const nyaVec3f& to, const nyaVec4f& color, const float lifetime )
+{
+    auto lineCmd = submissionPacket->lines.push();
+    if ( lineCmd == nullptr ) {
+        return;
+    }
+
+    lineCmd->from = from;
+    lineCmd->to = to;
+    lineCmd->color = color;
+    lineCmd->lifetime = lifetime;
+}
+
+void DrawCommandBuilder::addLineBatchToRender( const nyaStringHash_t batchKey )
+{
+    submissionPacket->lineBatches.push_back( batchKey );
+}
+
+FramePacket::LineBatchUpdate& DrawCommandBuilder::updateLineBatch( const nyaStringHash_t batchKey )
+{
+    addLineBatchToRender( batchKey );
+
+    submissionPacket->lineBatchUpdates.emplace_back();
+
+    FramePacket::LineBatchUpdate& batchUpdate = submissionPacket->lineBatchUpdates.back();
+    batchUpdate.batchKey = batchKey;
+    batchUpdate.color = nyaVec4f( 1.0f, 1.0f, 1.0f, 1.0f );
+    batchUpdate.gridCenter = nyaVec3f( 0.0f, 0.0f, 0.0f );
+    batchUpdate.gridExtent = 0.0f;
+    batchUpdate.gridCellCount = 0u;
+
+    return batchUpdate;
+}
+
+const IBLProbeUpdateScheduler& DrawCommandBuilder::getProbeUpdateScheduler() const
+{
+    return probeUpdateScheduler;
+}
+
+const CSMUpdateScheduler& DrawCommandBuilder::getCSMUpdateScheduler() const
+{
+    return csmUpdateScheduler;
+}
+
+void DrawCommandBuilder::setIBLProbeCache( IBLProbeCache* probeCache )
+{
+    iblProbeCache = probeCache;
+}
+
+bool DrawCommandBuilder::isIBLProbeBakeComplete() const
+{
+    if ( !IBLProbeBakeMode || iblProbeCache == nullptr ) {
+        return false;
+    }
+
+    // Nothing can be written if the render backend does not support render target readbacks
+    if ( !iblProbeCache->isEnabled() ) {
+        return true;
+    }
+
+    return probeUpdateScheduler.getPendingProbeCount() == 0u && !iblProbeCache->hasPendingWrites();
+}
+
+void DrawCommandBuilder::buildRenderQueues( WorldRenderer* worldRenderer, LightGrid* lightGrid, FramePacket* framePacket )
 {
     NYA_PROFILE_FUNCTION
 
+    renderPacket = framePacket;
+    renderPacket->merge();
+
+    lightGrid->setFrameLights( renderPacket->lights );
+
+    // NOTE The scene hash is only computed for frames capturing probes (it is used by the probes restored/baked from this frame)
+    if ( iblProbeCache != nullptr && !renderPacket->iblProbesToCapture.empty() ) {
+        iblProbeCache->setSceneHash( renderPacket->sceneHash );
+    }
+
+    scheduleProbeCaptures( lightGrid );
+
+    const uint32_t lineCount = renderPacket->lines.getEntryCount();
+    for ( uint32_t lineIdx = 0; lineIdx < lineCount; lineIdx++ ) {
+        const FramePacket::LineDrawCommand& lineCmd = renderPacket->lines[lineIdx];
+        worldRenderer->LineRenderModule->addLine( lineCmd.from, lineCmd.to, lineCmd.color, lineCmd.lifetime );
+    }
+
+    updateLineBatches( worldRenderer->LineRenderModule );
+
     uint32_t cameraIdx = 0;
-    CameraData** cameraArray = static_cast<CameraData**>( cameras->getBaseAddress() );
-    const size_t cameraCount = cameras->getAllocationCount();
+    const uint32_t cameraCount = renderPacket->cameraCount;
 
     for ( ; cameraIdx < cameraCount; cameraIdx++ ) {
-        CameraData* camera = cameraArray[cameraIdx];
+        CameraData* camera = &renderPacket->cameras[cameraIdx];
 
         // Register viewport into the world renderer
-        RenderPipeline& renderPipeline = worldRenderer->allocateRenderPipeline( { 0, 0, static_cast<int32_t>( camera->viewportSize.x ), static_cast<int32_t>( camera->viewportSize.y ), 0.0f, 1.0f }, camera );
+        RenderPipeline& renderPipeline = worldRenderer->allocateRenderPipeline( { 0, 0, static_cast<int32_t>( camera->viewportSize.x ), static_cast<int32_t>( camera->viewportSize.y ), 0.0f, 1.0f }, camera, CAMERA_VIEW_KEY + cameraIdx );
         renderPipeline.setMSAAQuality( camera->msaaSamplerCount );
         renderPipeline.setImageQuality( camera->imageQuality );
 
         worldRenderer->probeCaptureModule->importResourcesToPipeline( &renderPipeline );
+        worldRenderer->localShadowModule->importResourcesToPipeline( &renderPipeline );
+
+        // CSM Capture
+        // TODO Check if we can skip CSM capture depending on sun orientation?
+        const DirectionalLightData* sunLight = lightGrid->getDirectionalLightData();
+
+        // The main viewer cascades are cached in a persistent shadow map (far cascades are not updated every frame)
+        const bool useCachedShadowMap = ( cameraIdx == 0 );
+        uint32_t cascadeUpdateMask = CSM_ALL_CASCADES_MASK;
+
+        if ( useCachedShadowMap ) {
+            float visibleMinDepth, visibleMaxDepth;
+            computeVisibleDepthRange( camera, visibleMinDepth, visibleMaxDepth );
+
+            cascadeUpdateMask = csmUpdateScheduler.scheduleUpdates( sunLight, camera, visibleMinDepth, visibleMaxDepth );
+        } else {
+            camera->globalShadowMatrix = nya::framework::CSMCreateGlobalShadowMatrix( sunLight->direction, camera->depthViewProjectionMatrix );
+
+            for ( int sliceIdx = 0; sliceIdx < CSM_SLICE_COUNT; sliceIdx++ ) {
+                nya::framework::CSMComputeSliceData( sunLight, sliceIdx, camera );
+            }
+
+            camera->globalShadowMatrix = camera->globalShadowMatrix.transpose();
+        }
+
+        for ( int sliceIdx = 0; sliceIdx < CSM_SLICE_COUNT; sliceIdx++ ) {
+            if ( ( cascadeUpdateMask & ( 1u << sliceIdx ) ) == 0u ) {
+                continue;
+            }
+
+            // Create temporary frustum to cull geometry
+            Frustum csmCameraFrustum;
+            nya::maths::UpdateFrustumPlanes( camera->shadowViewMatrix[sliceIdx].transpose(), csmCameraFrustum );
+
+            // Cull static mesh instances (depth viewport)
+            const uint32_t drawCount = buildMeshDrawCmds( worldRenderer, camera, static_cast< uint8_t >( cameraIdx ), DrawCommandKey::LAYER_DEPTH, static_cast<DrawCommandKey::WorldViewportLayer>( DrawCommandKey::DEPTH_VIEWPORT_LAYER_CSM0 + sliceIdx ), &csmCameraFrustum );
+
+            if ( useCachedShadowMap ) {
+                csmUpdateScheduler.setCascadeDrawCount( static_cast<uint32_t>( sliceIdx ), drawCount );
+            }
+        }
 
             auto lightClustersData = lightGrid->updateClusters( &renderPipeline );
 
-            auto sunShadowMap = AddCSMCapturePass( &renderPipeline );
+            // Local shadows are only rendered from the main viewer point of view
+            const LocalShadowRenderModule::CaptureInfos* localShadows = nullptr;
+            if ( cameraIdx == 0 ) {
+                buildLocalShadowDrawCmds( worldRenderer, lightGrid, camera, static_cast<uint8_t>( cameraIdx ) );
+                localShadows = worldRenderer->localShadowModule->getCaptureInfos();
+            }
+
+            auto sunShadowMap = AddCSMCapturePass( &renderPipeline, localShadows, cascadeUpdateMask, useCachedShadowMap );
 
             auto skyRenderTarget = worldRenderer->SkyRenderModule->renderSky( &renderPipeline );
             auto lightRenderTarget = AddLightRenderPass( &renderPipeline, lightClustersData, sunShadowMap, skyRenderTarget );
@@ -287,148 +498,177 @@ void DrawCommandBuilder::buildRenderQueues( WorldRenderer* worldRenderer, LightG
             
             auto postFxRenderTarget = AddFinalPostFxRenderPass( &renderPipeline, resolvedTarget, blurPyramid );
             AddPresentRenderPass( &renderPipeline, postFxRenderTarget );
-        
-        // CSM Capture
-        // TODO Check if we can skip CSM capture depending on sun orientation?
-        const DirectionalLightData* sunLight = lightGrid->getDirectionalLightData();
 
-        camera->globalShadowMatrix = nya::framework::CSMCreateGlobalShadowMatrix( sunLight->direction, camera->depthViewProjectionMatrix );
+        // Cull static mesh instances (world viewport)
+        buildMeshDrawCmds( worldRenderer, camera, static_cast< uint8_t >( cameraIdx ), DrawCommandKey::LAYER_WORLD, DrawCommandKey::WORLD_VIEWPORT_LAYER_DEFAULT );
+        buildHUDDrawCmds( worldRenderer, camera, static_cast< uint8_t >( cameraIdx ) );
+    }
 
-        for ( int sliceIdx = 0; sliceIdx < CSM_SLICE_COUNT; sliceIdx++ ) {
-            nya::framework::CSMComputeSliceData( sunLight, sliceIdx, camera );
-        }
+    // IBL Probe capture & convolution (spread over several frames)
+    NYA_BEGIN_PROFILE_SCOPE( "IBL Probe Updates" )
+        restoreCachedProbes( worldRenderer, lightGrid );
 
-        camera->globalShadowMatrix = camera->globalShadowMatrix.transpose();
+        // Refine the GPU cost estimates with the timings retrieved during the previous frame (recorded a few frames ago)
+        uint32_t gpuTimingCount = 0u;
+        const PipelineGPUTiming* gpuTimings = worldRenderer->getLastGPUTimings( gpuTimingCount );
 
-        // Create temporary frustum to cull geometry
-        Frustum csmCameraFrustum;
-        for ( int sliceIdx = 0; sliceIdx < CSM_SLICE_COUNT; sliceIdx++ ) {
-            nya::maths::UpdateFrustumPlanes( camera->shadowViewMatrix[sliceIdx], csmCameraFrustum );
+        for ( uint32_t timingIdx = 0u; timingIdx < gpuTimingCount; timingIdx++ ) {
+            const PipelineGPUTiming& timing = gpuTimings[timingIdx];
 
-            // Cull static mesh instances (depth viewport)
-            buildMeshDrawCmds( worldRenderer, camera, static_cast< uint8_t >( cameraIdx ), DrawCommandKey::LAYER_DEPTH, static_cast<DrawCommandKey::WorldViewportLayer>( DrawCommandKey::DEPTH_VIEWPORT_LAYER_CSM0 + sliceIdx ) );
+            if ( timing.ViewKey == IBL_PROBE_CAPTURE_VIEW_KEY ) {
+                probeUpdateScheduler.onCaptureGPUTimeRetrieved( timing.GPUTime );
+            } else if ( timing.ViewKey == IBL_PROBE_CONVOLUTION_VIEW_KEY ) {
+                probeUpdateScheduler.onConvolutionGPUTimeRetrieved( timing.FrameIndex, timing.GPUTime );
+            }
         }
 
-        // Cull static mesh instances (world viewport)
-        buildMeshDrawCmds( worldRenderer, camera, static_cast< uint8_t >( cameraIdx ), DrawCommandKey::LAYER_WORLD, DrawCommandKey::WORLD_VIEWPORT_LAYER_DEFAULT );
-        buildHUDDrawCmds( worldRenderer, camera, static_cast< uint8_t >( cameraIdx ) );
-    }
+        const nyaVec3f viewerWorldPosition = ( cameraCount != 0 ) ? renderPacket->cameras[0].worldPosition : nyaVec3f( 0.0f, 0.0f, 0.0f );
 
-    if ( !probeCaptureCmds.empty() ) {
-        IBLProbeCaptureCommand* cmd = probeCaptureCmds.top();
+        // Each capture needs its own pipeline; convolutions are batched in a single pipeline
+        const uint32_t availablePipelineCount = worldRenderer->getAvailableRenderPipelineCount();
+        const uint32_t maxCaptureCount = ( availablePipelineCount > 1u ) ? ( availablePipelineCount - 1u ) : 0u;
+        const uint32_t maxCommandCount = ( availablePipelineCount > 0u ) ? MAX_PROBE_COMMAND_PER_FRAME : 0u;
 
-        // Tweak probe field of view to avoid visible seams
-        const float ENV_PROBE_FOV = 2.0f * atanf( IBL_PROBE_DIMENSION / ( IBL_PROBE_DIMENSION - 0.5f ) );
-        constexpr float ENV_PROBE_ASPECT_RATIO = ( IBL_PROBE_DIMENSION / static_cast<float>( IBL_PROBE_DIMENSION ) );
+        IBLProbeUpdateCommand probeCommands[MAX_PROBE_COMMAND_PER_FRAME];
+        const uint32_t probeCommandCount = probeUpdateScheduler.scheduleUpdates( viewerWorldPosition, probeCommands, maxCaptureCount, maxCommandCount );
 
-        CameraData probeCamera = {};
-        probeCamera.worldPosition = cmd->Probe->worldPosition;
+        // CPU recording time (GPU time is retrieved through the pipeline timings)
+        Timer probeUpdateTimer;
+        nya::core::StartTimer( &probeUpdateTimer );
 
-        probeCamera.projectionMatrix = nya::maths::MakeInfReversedZProj( ENV_PROBE_FOV, ENV_PROBE_ASPECT_RATIO, 0.01f );
-        probeCamera.inverseProjectionMatrix = probeCamera.projectionMatrix.inverse();
-        probeCamera.depthProjectionMatrix = nya::maths::MakeFovProj( ENV_PROBE_FOV, 1.0f, 1.0f, 125.0f );
+        uint32_t commandIdx = 0u;
+        for ( ; commandIdx < probeCommandCount && !probeCommands[commandIdx].IsConvolution; commandIdx++ ) {
+            buildProbeCaptureRenderQueue( worldRenderer, lightGrid, probeCommands[commandIdx], static_cast<uint8_t>( cameraIdx ) );
+            cameraIdx++;
+        }
 
-        probeCamera.viewMatrix = GetProbeCaptureViewMatrix( cmd->Probe->worldPosition, cmd->CommandInfos.Step );
-        probeCamera.depthViewProjectionMatrix = probeCamera.depthProjectionMatrix * probeCamera.viewMatrix;
+        const double captureTime = nya::core::GetTimerDeltaAsMiliseconds( &probeUpdateTimer );
 
-        probeCamera.inverseViewMatrix = probeCamera.viewMatrix.inverse();
+        if ( commandIdx < probeCommandCount ) {
+            RenderPipeline& renderPipeline = worldRenderer->allocateRenderPipeline( { 0, 0, IBL_PROBE_DIMENSION, IBL_PROBE_DIMENSION, 0.0f, 1.0f }, nullptr, IBL_PROBE_CONVOLUTION_VIEW_KEY );
+            worldRenderer->probeCaptureModule->importResourcesToPipeline( &renderPipeline );
 
-        probeCamera.viewProjectionMatrix = probeCamera.projectionMatrix * probeCamera.viewMatrix;
-        probeCamera.inverseViewProjectionMatrix = probeCamera.viewProjectionMatrix.inverse();
+            for ( ; commandIdx < probeCommandCount; commandIdx++ ) {
+                const IBLProbeUpdateCommand& command = probeCommands[commandIdx];
+                worldRenderer->probeCaptureModule->convoluteProbeFace( &renderPipeline, command.Probe->ProbeIndex, command.Step, command.MipIndex );
 
-        probeCamera.viewportSize = { IBL_PROBE_DIMENSION, IBL_PROBE_DIMENSION };
-        probeCamera.imageQuality = 1.0f;
-        probeCamera.msaaSamplerCount = 1;
+                // Last convolution step of the probe
+                const bool isProbeComplete = ( command.Step == eProbeCaptureStep::FACE_Z_MINUS && command.MipIndex == ( IBLProbeUpdateScheduler::CONVOLUTION_MIP_COUNT - 1u ) );
+                if ( IBLProbeBakeMode && iblProbeCache != nullptr && isProbeComplete && !command.Probe->isDynamic ) {
+                    iblProbeCache->queueProbeWrite( command.Probe );
+                }
+            }
 
-        RenderPipeline& renderPipeline = worldRenderer->allocateRenderPipeline( { 0, 0, IBL_PROBE_DIMENSION, IBL_PROBE_DIMENSION, 0.0f, 1.0f }, &probeCamera );
-        worldRenderer->probeCaptureModule->importResourcesToPipeline( &renderPipeline );
+            cameraIdx++;
+        }
 
-        if ( !cmd->Probe->isFallbackProbe ) {
-            nya::maths::UpdateFrustumPlanes( probeCamera.depthViewProjectionMatrix, probeCamera.frustum );
+        const double convolutionTime = nya::core::GetTimerDeltaAsMiliseconds( &probeUpdateTimer );
 
-            // CSM Capture
-            // TODO Check if we can skip CSM capture depending on sun orientation?
-            const DirectionalLightData* sunLight = lightGrid->getDirectionalLightData();
+        probeUpdateScheduler.onCommandsRecorded( worldRenderer->getFrameIndex(), captureTime, convolutionTime );
+    NYA_END_PROFILE_SCOPE()
 
-            probeCamera.globalShadowMatrix = nya::framework::CSMCreateGlobalShadowMatrix( sunLight->direction, probeCamera.depthViewProjectionMatrix );
+    renderPacket = nullptr;
+}
 
-            for ( int sliceIdx = 0; sliceIdx < CSM_SLICE_COUNT; sliceIdx++ ) {
-                nya::framework::CSMComputeSliceData( sunLight, sliceIdx, &probeCamera );
-            }
+void DrawCommandBuilder::scheduleProbeCaptures( LightGrid* lightGrid )
+{
+    // Probes are resolved to the render side copy (stays valid while the probe is captured over several frames)
+    for ( const uint32_t probeIndex : renderPacket->iblProbesToCapture ) {
+        const IBLProbeData* probeData = lightGrid->getIBLProbeData( probeIndex );
+        if ( probeData == nullptr ) {
+            continue;
+        }
 
-            probeCamera.globalShadowMatrix = probeCamera.globalShadowMatrix.transpose();
+        // Dynamic probes can't be baked
+        if ( iblProbeCache != nullptr && iblProbeCache->isEnabled() && !probeData->isDynamic && !IBLProbeBakeMode ) {
+            probesToRestore.push_back( probeData );
+            continue;
+        }
 
-            // Create temporary frustum to cull geometry
-            Frustum csmCameraFrustum;
-            for ( int sliceIdx = 0; sliceIdx < CSM_SLICE_COUNT; sliceIdx++ ) {
-                nya::maths::UpdateFrustumPlanes( probeCamera.shadowViewMatrix[sliceIdx], csmCameraFrustum );
+        probeUpdateScheduler.requestUpdate( probeData );
+    }
+}
 
-                // Cull static mesh instances (depth viewport)
-                buildMeshDrawCmds( worldRenderer, &probeCamera, static_cast< uint8_t >( cameraIdx ), DrawCommandKey::LAYER_DEPTH, static_cast<DrawCommandKey::WorldViewportLayer>( DrawCommandKey::DEPTH_VIEWPORT_LAYER_CSM0 + sliceIdx ) );
-            }
+void DrawCommandBuilder::restoreCachedProbes( WorldRenderer* worldRenderer, LightGrid* lightGrid )
+{
+    if ( iblProbeCache == nullptr ) {
+        return;
+    }
+
+    // Write probes convoluted during the previous frame
+    const uint32_t writtenProbeCount = iblProbeCache->flushPendingWrites( worldRenderer->probeCaptureModule );
+    NYA_PROFILE_STAT( "IBL Probes Written To Cache", writtenProbeCount )
 
-            buildMeshDrawCmds( worldRenderer, &probeCamera, static_cast< uint8_t >( cameraIdx ), DrawCommandKey::LAYER_WORLD, DrawCommandKey::WORLD_VIEWPORT_LAYER_DEFAULT );
+    uint32_t restoredProbeCount = 0u;
+    for ( const IBLProbeData* probeData : probesToRestore ) {
+        if ( iblProbeCache->restoreProbe( worldRenderer->probeCaptureModule, lightGrid, probeData ) ) {
+            restoredProbeCount++;
+            continue;
         }
 
-            auto faceRenderTarget = worldRenderer->SkyRenderModule->renderSky( &renderPipeline, false, false );
+        // Missing or stale entry; fallback to a live capture
+        probeUpdateScheduler.requestUpdate( probeData );
+    }
+
+    probesToRestore.clear();
 
-            // Capture World
-            if ( !cmd->Probe->isFallbackProbe ) {
-                auto lightClustersData = lightGrid->updateClusters( &renderPipeline );
+    NYA_PROFILE_STAT( "IBL Probes Restored From Cache", restoredProbeCount )
+}
 
-                auto sunShadowMap = AddCSMCapturePass( &renderPipeline );
+void DrawCommandBuilder::updateLineBatches( LineRenderingModule* lineRenderModule )
+{
+    for ( const FramePacket::LineBatchUpdate& batchUpdate : renderPacket->lineBatchUpdates ) {
+        auto it = lineBatchHandles.find( batchUpdate.batchKey );
+        LineBatchHandle_t batchHandle = ( it != lineBatchHandles.end() ) ? it->second : LINE_RENDERING_INVALID_BATCH_HANDLE;
 
-                auto lightRenderTarget = AddLightRenderPass( &renderPipeline, lightClustersData, sunShadowMap, faceRenderTarget, true );
+        if ( batchHandle == LINE_RENDERING_INVALID_BATCH_HANDLE ) {
+            batchHandle = lineRenderModule->allocateStaticBatch();
 
-                faceRenderTarget = lightRenderTarget.lightRenderTarget;
+            if ( batchHandle == LINE_RENDERING_INVALID_BATCH_HANDLE ) {
+                continue;
             }
 
-            worldRenderer->probeCaptureModule->saveCapturedProbeFace( &renderPipeline, faceRenderTarget, cmd->CommandInfos.EnvProbeArrayIndex, cmd->CommandInfos.Step );
-        
-        cameraIdx++;
-
-        probeCaptureCmdAllocator->free( cmd );
-        probeCaptureCmds.pop();
-    } else if ( !probeConvolutionCmds.empty() ) {
-        IBLProbeConvolutionCommand* cmd = probeConvolutionCmds.top();
+            lineBatchHandles.insert( batchUpdate.batchKey, batchHandle );
+        } else {
+            lineRenderModule->clearStaticBatch( batchHandle );
+        }
 
-        RenderPipeline& renderPipeline = worldRenderer->allocateRenderPipeline( { 0, 0, IBL_PROBE_DIMENSION, IBL_PROBE_DIMENSION, 0.0f, 1.0f }, nullptr );
-        worldRenderer->probeCaptureModule->importResourcesToPipeline( &renderPipeline );
+        for ( const AABB& aabb : batchUpdate.aabbs ) {
+            lineRenderModule->addAABB( batchHandle, aabb, batchUpdate.color );
+        }
 
-            worldRenderer->probeCaptureModule->convoluteProbeFace( &renderPipeline, cmd->CommandInfos.EnvProbeArrayIndex, cmd->CommandInfos.Step, cmd->CommandInfos.MipIndex );
-        
-        cameraIdx++;
+        for ( const nyaVec4f& sphere : batchUpdate.spheres ) {
+            lineRenderModule->addSphere( batchHandle, nyaVec3f( sphere.x, sphere.y, sphere.z ), sphere.w, batchUpdate.color );
+        }
 
-        probeConvolutionCmdAllocator->free( cmd );
-        probeConvolutionCmds.pop();
+        if ( batchUpdate.gridCellCount != 0u ) {
+            lineRenderModule->addGrid( batchHandle, batchUpdate.gridCenter, batchUpdate.gridExtent, batchUpdate.gridCellCount, batchUpdate.color );
+        }
     }
 
-    resetEntityCounters();
+    // Batches are kept uploaded, but are only drawn on frames they have been added to the packet
+    const std::vector<nyaStringHash_t>& drawnBatches = renderPacket->lineBatches;
+    for ( const auto& batch : lineBatchHandles ) {
+        const bool isVisible = ( std::find( drawnBatches.begin(), drawnBatches.end(), batch.first ) != drawnBatches.end() );
+        lineRenderModule->setStaticBatchVisibility( batch.second, isVisible );
+    }
 }
 
-void DrawCommandBuilder::resetEntityCounters()
+uint32_t DrawCommandBuilder::buildMeshDrawCmds( WorldRenderer* worldRenderer, CameraData* camera, const uint8_t cameraIdx, const uint8_t layer, const uint8_t viewportLayer, const Frustum* cullingFrustum )
 {
-    cameras->clear();
-    meshes->clear();
-    spheresToRender->clear();
-    primitivesToRender->clear();
-    textToRenderAllocator->clear();
-}
+    uint32_t drawCmdCount = 0u;
 
-void DrawCommandBuilder::buildMeshDrawCmds( WorldRenderer* worldRenderer, CameraData* camera, const uint8_t cameraIdx, const uint8_t layer, const uint8_t viewportLayer )
-{
-    MeshInstance* meshesArray = static_cast<MeshInstance*>( meshes->getBaseAddress() );
-    const size_t meshCount = meshes->getAllocationCount();
+    const uint32_t meshCount = renderPacket->meshes.getEntryCount();
     for ( uint32_t meshIdx = 0; meshIdx < meshCount; meshIdx++ ) {
-        const MeshInstance& meshInstance = meshesArray[meshIdx];
+        const FramePacket::MeshInstance& meshInstance = renderPacket->meshes[meshIdx];
 
         // TODO Avoid this crappy test per mesh instance (store per-layer list inside the commandBuilder?)
         if ( layer == DrawCommandKey::LAYER_DEPTH && meshInstance.renderDepth == 0 ) {
             continue;
         }
 
-        const nyaVec3f instancePosition = nya::maths::ExtractTranslation( *meshInstance.modelMatrix );
-        const float instanceScale = nya::maths::GetBiggestScalar( nya::maths::ExtractScale( *meshInstance.modelMatrix ) );
+        const nyaVec3f instancePosition = nya::maths::ExtractTranslation( meshInstance.modelMatrix );
+        const float instanceScale = nya::maths::GetBiggestScalar( nya::maths::ExtractScale( meshInstance.modelMatrix ) );
 
         const float distanceToCamera = nyaVec3f::distanceSquared( camera->worldPosition, instancePosition );
 
@@ -443,9 +683,14 @@ void DrawCommandBuilder::buildMeshDrawCmds( WorldRenderer* worldRenderer, Camera
             nyaVec3f position = instancePosition + subMesh.boundingSphere.center;
             float scaledRadius = instanceScale * subMesh.boundingSphere.radius;
 
-            if ( CullSphereInfReversedZ( &camera->frustum, position, scaledRadius ) > 0.0f ) {
+            const float cullingDistance = ( cullingFrustum != nullptr )
+                ? CullSphere( cullingFrustum, position, scaledRadius )
+                : CullSphereInfReversedZ( &camera->frustum, position, scaledRadius );
+
+            if ( cullingDistance > 0.0f ) {
                 // Build drawcmd is the submesh is visible
                 DrawCmd& drawCmd = worldRenderer->allocateDrawCmd();
+                drawCmdCount++;
 
                 auto& key = drawCmd.key.bitfield;
                 key.materialSortKey = subMesh.material->getSortKey();
@@ -463,50 +708,345 @@ void DrawCommandBuilder::buildMeshDrawCmds( WorldRenderer* worldRenderer, Camera
                 infos.indiceBufferCount = subMesh.indiceCount;
                 infos.alphaDitheringValue = 1.0f;
                 infos.instanceCount = 1;
-                infos.modelMatrix = meshInstance.modelMatrix;
+                infos.modelMatrix = &meshInstance.modelMatrix;
             }
         }
     }
 
-    PrimitiveInstance* sphereToRenderArray = static_cast<PrimitiveInstance*>( spheresToRender->getBaseAddress() );
-    const size_t sphereCount = spheresToRender->getAllocationCount();
+    const uint32_t sphereCount = renderPacket->spheres.getEntryCount();
 
     for ( uint32_t sphereIdx = 0; sphereIdx < sphereCount; sphereIdx++ ) {
-        sphereToRender[sphereIdx] = sphereToRenderArray[sphereIdx].modelMatrix.transpose();
+        const FramePacket::PrimitiveInstance& sphereInstance = renderPacket->spheres[sphereIdx];
+        sphereToRender[sphereIdx] = sphereInstance.modelMatrix.transpose();
 
         const nyaVec3f instancePosition = nya::maths::ExtractTranslation( sphereToRender[sphereIdx] );
         const float distanceToCamera = nyaVec3f::distanceSquared( camera->worldPosition, instancePosition );
 
         DrawCmd& drawCmd = worldRenderer->allocateSpherePrimitiveDrawCmd();
-        drawCmd.infos.material = sphereToRenderArray[sphereIdx].material;
+        drawCmd.infos.material = sphereInstance.material;
         drawCmd.infos.instanceCount = static_cast<uint32_t>( 1u );
         drawCmd.infos.modelMatrix = &sphereToRender[sphereIdx];
 
         auto& key = drawCmd.key.bitfield;
-        key.materialSortKey = sphereToRenderArray[sphereIdx].material->getSortKey();
+        key.materialSortKey = sphereInstance.material->getSortKey();
         key.depth = DepthToBits( distanceToCamera );
         key.sortOrder = DrawCommandKey::SORT_FRONT_TO_BACK;
         key.layer = static_cast< DrawCommandKey::Layer >( layer );
         key.viewportLayer = viewportLayer;
         key.viewportId = cameraIdx;
     }
+
+    return drawCmdCount + sphereCount;
+}
+
+void DrawCommandBuilder::computeVisibleDepthRange( const CameraData* camera, float& minDepth, float& maxDepth )
+{
+    // The near plane normal is the camera view direction
+    const nyaVec3f viewDirection = nyaVec3f( camera->frustum.planes[5].x, camera->frustum.planes[5].y, camera->frustum.planes[5].z );
+
+    // A negative range means nothing is visible
+    minDepth = -1.0f;
+    maxDepth = -1.0f;
+
+    bool isRangeEmpty = true;
+
+    const uint32_t meshCount = renderPacket->meshes.getEntryCount();
+    for ( uint32_t meshIdx = 0; meshIdx < meshCount; meshIdx++ ) {
+        const FramePacket::MeshInstance& meshInstance = renderPacket->meshes[meshIdx];
+
+        const nyaVec3f instancePosition = nya::maths::ExtractTranslation( meshInstance.modelMatrix );
+        const float instanceScale = nya::maths::GetBiggestScalar( nya::maths::ExtractScale( meshInstance.modelMatrix ) );
+
+        const float distanceToCamera = nyaVec3f::distanceSquared( camera->worldPosition, instancePosition );
+        const auto& activeLOD = meshInstance.mesh->getLevelOfDetail( distanceToCamera );
+
+        for ( const SubMesh& subMesh : activeLOD.subMeshes ) {
+            nyaVec3f position = instancePosition + subMesh.boundingSphere.center;
+            float scaledRadius = instanceScale * subMesh.boundingSphere.radius;
+
+            if ( CullSphereInfReversedZ( &camera->frustum, position, scaledRadius ) <= 0.0f ) {
+                continue;
+            }
+
+            const float viewDepth = nyaVec3f::dot( position - camera->worldPosition, viewDirection );
+            const float sphereMinDepth = nya::maths::max( 0.0f, viewDepth - scaledRadius );
+            const float sphereMaxDepth = viewDepth + scaledRadius;
+
+            minDepth = ( isRangeEmpty ) ? sphereMinDepth : nya::maths::min( minDepth, sphereMinDepth );
+            maxDepth = ( isRangeEmpty ) ? sphereMaxDepth : nya::maths::max( maxDepth, sphereMaxDepth );
+            isRangeEmpty = false;
+        }
+    }
+}
+
+void DrawCommandBuilder::invalidateMovedShadowCasters( WorldRenderer* worldRenderer )
+{
+    LocalShadowRenderModule* localShadowModule = worldRenderer->localShadowModule;
+
+    // Casters are compared with the previous frame casters (using the submission order)
+    uint32_t casterCount = 0u;
+
+    const uint32_t meshCount = renderPacket->meshes.getEntryCount();
+    for ( uint32_t meshIdx = 0; meshIdx < meshCount; meshIdx++ ) {
+        const FramePacket::MeshInstance& meshInstance = renderPacket->meshes[meshIdx];
+
+        if ( meshInstance.renderDepth == 0 ) {
+            continue;
+        }
+
+        if ( casterCount == shadowCasters.size() ) {
+            shadowCasters.push_back( { nullptr, nullptr, nyaMat4x4f::Identity, {}, {} } );
+        }
+
+        ShadowCasterState& caster = shadowCasters[casterCount++];
+
+        const AABB& meshBounds = meshInstance.mesh->getMeshAABB();
+
+        const bool hasMoved = ( caster.mesh != meshInstance.mesh
+                             || caster.modelMatrixPointer != meshInstance.modelMatrixKey
+                             || memcmp( &caster.modelMatrix, &meshInstance.modelMatrix, sizeof( nyaMat4x4f ) ) != 0
+                             || memcmp( &caster.meshBounds, &meshBounds, sizeof( AABB ) ) != 0 );
+
+        if ( !hasMoved ) {
+            continue;
+        }
+
+        // Invalidate both the previous and the current location
+        if ( caster.mesh != nullptr ) {
+            localShadowModule->invalidate( caster.worldBounds );
+        }
+
+        caster.mesh = meshInstance.mesh;
+        caster.modelMatrixPointer = meshInstance.modelMatrixKey;
+        caster.modelMatrix = meshInstance.modelMatrix;
+        caster.meshBounds = meshBounds;
+        caster.worldBounds = ComputeInstanceWorldBounds( meshInstance.mesh, meshInstance.modelMatrix );
+
+        localShadowModule->invalidate( caster.worldBounds );
+    }
+
+    // Casters removed since the last frame
+    for ( uint32_t casterIdx = casterCount; casterIdx < shadowCasters.size(); casterIdx++ ) {
+        if ( shadowCasters[casterIdx].mesh != nullptr ) {
+            localShadowModule->invalidate( shadowCasters[casterIdx].worldBounds );
+        }
+    }
+
+    shadowCasters.resize( casterCount );
+}
+
+void DrawCommandBuilder::buildLocalShadowDrawCmds( WorldRenderer* worldRenderer, LightGrid* lightGrid, CameraData* camera, const uint8_t cameraIdx )
+{
+    NYA_PROFILE_FUNCTION
+
+    LocalShadowRenderModule* localShadowModule = worldRenderer->localShadowModule;
+
+    invalidateMovedShadowCasters( worldRenderer );
+
+    // Retrieve visible point lights around the viewer
+    const float maxShadowDistance = static_cast<float>( LocalShadowMaxDistance );
+
+    AABB viewerBounds;
+    nya::maths::CreateAABB( viewerBounds, camera->worldPosition, nyaVec3f( maxShadowDistance, maxShadowDistance, maxShadowDistance ) );
+
+    shadowLightIndexes.clear();
+    lightGrid->queryPointLights( viewerBounds, shadowLightIndexes );
+
+    // Tile resolution is based on the light volume projected height (in pixels)
+    const float projectionScale = camera->projectionMatrix[1][1] * camera->viewportSize.y;
+
+    shadowRequests.clear();
+    for ( const uint32_t lightIdx : shadowLightIndexes ) {
+        const PointLightData* pointLight = lightGrid->getPointLightData( lightIdx );
+
+        if ( pointLight == nullptr || CullSphereInfReversedZ( &camera->frustum, pointLight->worldPosition, pointLight->radius ) <= 0.0f ) {
+            continue;
+        }
+
+        const float distanceSquared = nyaVec3f::distanceSquared( camera->worldPosition, pointLight->worldPosition );
+        const float radiusSquared = ( pointLight->radius * pointLight->radius );
+
+        LocalShadowRequest request;
+        request.LightIndex = lightIdx;
+        request.WorldPosition = pointLight->worldPosition;
+        request.Radius = pointLight->radius;
+        request.ScreenFootprint = ( distanceSquared > radiusSquared ) 
+            ? projectionScale * pointLight->radius / sqrtf( distanceSquared - radiusSquared ) 
+            : static_cast<float>( LOCAL_SHADOW_MAX_TILE_DIMENSIONS ); // Viewer inside the light volume
+        request.FaceCount = LOCAL_SHADOW_MAX_FACE_COUNT;
+
+        shadowRequests.push_back( request );
+    }
+
+    const uint32_t faceUpdateCount = localShadowModule->updateShadowAtlas( shadowRequests.data(), static_cast<uint32_t>( shadowRequests.size() ), LocalShadowMaxFaceUpdates );
+
+    // Build caster draw commands for each face to render
+    uint32_t casterCount = 0u;
+    Frustum faceFrustum;
+
+    const uint32_t meshCount = renderPacket->meshes.getEntryCount();
+    for ( uint32_t updateIdx = 0u; updateIdx < faceUpdateCount; updateIdx++ ) {
+        const LocalShadowFaceUpdate& faceUpdate = localShadowModule->getFaceUpdate( updateIdx );
+        const PointLightData* pointLight = lightGrid->getPointLightData( faceUpdate.LightIndex );
+
+        const nyaMat4x4f& faceViewProjection = localShadowModule->getFaceViewProjectionMatrix( faceUpdate.SlotIndex, faceUpdate.FaceIndex );
+        const nyaMat4x4f faceShadowMatrix = faceViewProjection.transpose();
+
+        nya::maths::UpdateFrustumPlanes( faceViewProjection, faceFrustum );
+
+        for ( uint32_t meshIdx = 0; meshIdx < meshCount && casterCount < MAX_LOCAL_SHADOW_CASTER_COUNT; meshIdx++ ) {
+            const FramePacket::MeshInstance& meshInstance = renderPacket->meshes[meshIdx];
+
+            if ( meshInstance.renderDepth == 0 ) {
+                continue;
+            }
+
+            const nyaVec3f instancePosition = nya::maths::ExtractTranslation( meshInstance.modelMatrix );
+            const float instanceScale = nya::maths::GetBiggestScalar( nya::maths::ExtractScale( meshInstance.modelMatrix ) );
+
+            const float distanceToCamera = nyaVec3f::distanceSquared( camera->worldPosition, instancePosition );
+            const float distanceToLight = nyaVec3f::distanceSquared( pointLight->worldPosition, instancePosition );
+
+            // Use the viewer LOD to match the geometry rendered in the world viewport
+            const auto& activeLOD = meshInstance.mesh->getLevelOfDetail( distanceToCamera );
+
+            const Buffer* vertexBuffer = meshInstance.mesh->getVertexBuffer();
+            const Buffer* indiceBuffer = meshInstance.mesh->getIndiceBuffer();
+
+            for ( const SubMesh& subMesh : activeLOD.subMeshes ) {
+                nyaVec3f position = instancePosition + subMesh.boundingSphere.center;
+                float scaledRadius = instanceScale * subMesh.boundingSphere.radius;
+
+                // Skip submeshes outside the light volume or the face frustum
+                const float maxDistance = ( pointLight->radius + scaledRadius );
+                if ( nyaVec3f::distanceSquared( position, pointLight->worldPosition ) > ( maxDistance * maxDistance )
+                  || CullSphere( &faceFrustum, position, scaledRadius ) <= 0.0f ) {
+                    continue;
+                }
+
+                if ( casterCount == MAX_LOCAL_SHADOW_CASTER_COUNT ) {
+                    break;
+                }
+
+                nyaMat4x4f& casterMatrix = localShadowCasterMatrices[casterCount++];
+                casterMatrix = meshInstance.modelMatrix * faceShadowMatrix;
+
+                DrawCmd& drawCmd = worldRenderer->allocateDrawCmd();
+
+                auto& key = drawCmd.key.bitfield;
+                key.materialSortKey = subMesh.material->getSortKey();
+                key.depth = DepthToBits( distanceToLight );
+                key.sortOrder = DrawCommandKey::SORT_FRONT_TO_BACK;
+                key.layer = DrawCommandKey::LAYER_DEPTH;
+                key.viewportLayer = DrawCommandKey::DEPTH_VIEWPORT_LAYER_LOCAL_SHADOW;
+                key.viewportSubLayer = static_cast<uint8_t>( updateIdx );
+                key.viewportId = cameraIdx;
+
+                DrawCommandInfos& infos = drawCmd.infos;
+                infos.material = subMesh.material;
+                infos.vertexBuffer = vertexBuffer;
+                infos.indiceBuffer = indiceBuffer;
+                infos.indiceBufferOffset = subMesh.indiceBufferOffset;
+                infos.indiceBufferCount = subMesh.indiceCount;
+                infos.alphaDitheringValue = 1.0f;
+                infos.instanceCount = 1;
+                infos.modelMatrix = &casterMatrix;
+            }
+        }
+    }
+
+    NYA_PROFILE_STAT( "Local Shadows Caster Count", casterCount )
+}
+
+void DrawCommandBuilder::buildProbeCaptureRenderQueue( WorldRenderer* worldRenderer, LightGrid* lightGrid, const IBLProbeUpdateCommand& command, const uint8_t cameraIdx )
+{
+    const IBLProbeData* probe = command.Probe;
+
+    // Tweak probe field of view to avoid visible seams
+    const float ENV_PROBE_FOV = 2.0f * atanf( IBL_PROBE_DIMENSION / ( IBL_PROBE_DIMENSION - 0.5f ) );
+    constexpr float ENV_PROBE_ASPECT_RATIO = ( IBL_PROBE_DIMENSION / static_cast<float>( IBL_PROBE_DIMENSION ) );
+
+    CameraData probeCamera = {};
+    probeCamera.worldPosition = probe->worldPosition;
+
+    probeCamera.projectionMatrix = nya::maths::MakeInfReversedZProj( ENV_PROBE_FOV, ENV_PROBE_ASPECT_RATIO, 0.01f );
+    probeCamera.inverseProjectionMatrix = probeCamera.projectionMatrix.inverse();
+    probeCamera.depthProjectionMatrix = nya::maths::MakeFovProj( ENV_PROBE_FOV, 1.0f, 1.0f, 125.0f );
+
+    probeCamera.viewMatrix = GetProbeCaptureViewMatrix( probe->worldPosition, command.Step );
+    probeCamera.depthViewProjectionMatrix = probeCamera.depthProjectionMatrix * probeCamera.viewMatrix;
+
+    probeCamera.inverseViewMatrix = probeCamera.viewMatrix.inverse();
+
+    probeCamera.viewProjectionMatrix = probeCamera.projectionMatrix * probeCamera.viewMatrix;
+    probeCamera.inverseViewProjectionMatrix = probeCamera.viewProjectionMatrix.inverse();
+
+    probeCamera.viewportSize = { IBL_PROBE_DIMENSION, IBL_PROBE_DIMENSION };
+    probeCamera.imageQuality = 1.0f;
+    probeCamera.msaaSamplerCount = 1;
+
+    RenderPipeline& renderPipeline = worldRenderer->allocateRenderPipeline( { 0, 0, IBL_PROBE_DIMENSION, IBL_PROBE_DIMENSION, 0.0f, 1.0f }, &probeCamera, IBL_PROBE_CAPTURE_VIEW_KEY );
+    worldRenderer->probeCaptureModule->importResourcesToPipeline( &renderPipeline );
+    worldRenderer->localShadowModule->importResourcesToPipeline( &renderPipeline );
+
+    if ( !probe->isFallbackProbe ) {
+        nya::maths::UpdateFrustumPlanes( probeCamera.depthViewProjectionMatrix, probeCamera.frustum );
+
+        // CSM Capture
+        // TODO Check if we can skip CSM capture depending on sun orientation?
+        const DirectionalLightData* sunLight = lightGrid->getDirectionalLightData();
+
+        probeCamera.globalShadowMatrix = nya::framework::CSMCreateGlobalShadowMatrix( sunLight->direction, probeCamera.depthViewProjectionMatrix );
+
+        for ( int sliceIdx = 0; sliceIdx < CSM_SLICE_COUNT; sliceIdx++ ) {
+            nya::framework::CSMComputeSliceData( sunLight, sliceIdx, &probeCamera );
+        }
+
+        probeCamera.globalShadowMatrix = probeCamera.globalShadowMatrix.transpose();
+
+        // Create temporary frustum to cull geometry
+        Frustum csmCameraFrustum;
+        for ( int sliceIdx = 0; sliceIdx < CSM_SLICE_COUNT; sliceIdx++ ) {
+            nya::maths::UpdateFrustumPlanes( probeCamera.shadowViewMatrix[sliceIdx].transpose(), csmCameraFrustum );
+
+            // Cull static mesh instances (depth viewport)
+            buildMeshDrawCmds( worldRenderer, &probeCamera, cameraIdx, DrawCommandKey::LAYER_DEPTH, static_cast<DrawCommandKey::WorldViewportLayer>( DrawCommandKey::DEPTH_VIEWPORT_LAYER_CSM0 + sliceIdx ), &csmCameraFrustum );
+        }
+
+        buildMeshDrawCmds( worldRenderer, &probeCamera, cameraIdx, DrawCommandKey::LAYER_WORLD, DrawCommandKey::WORLD_VIEWPORT_LAYER_DEFAULT );
+    }
+
+    auto faceRenderTarget = worldRenderer->SkyRenderModule->renderSky( &renderPipeline, false, false );
+
+    // Capture World
+    if ( !probe->isFallbackProbe ) {
+        auto lightClustersData = lightGrid->updateClusters( &renderPipeline );
+
+        auto sunShadowMap = AddCSMCapturePass( &renderPipeline );
+
+        auto lightRenderTarget = AddLightRenderPass( &renderPipeline, lightClustersData, sunShadowMap, faceRenderTarget, true );
+
+        faceRenderTarget = lightRenderTarget.lightRenderTarget;
+    }
+
+    worldRenderer->probeCaptureModule->saveCapturedProbeFace( &renderPipeline, faceRenderTarget, probe->ProbeIndex, command.Step );
 }
 
 void DrawCommandBuilder::buildHUDDrawCmds( WorldRenderer* worldRenderer, CameraData* camera, const uint8_t cameraIdx )
 {
-    PrimitiveInstance* primitivesToRenderArray = static_cast<PrimitiveInstance*>( primitivesToRender->getBaseAddress() );
-    const size_t primitiveCount = primitivesToRender->getAllocationCount();
+    const uint32_t primitiveCount = renderPacket->primitives.getEntryCount();
 
     for ( uint32_t primIdx = 0; primIdx < primitiveCount; primIdx++ ) {
-        primitivesModelMatricess[primIdx] = primitivesToRenderArray[primIdx].modelMatrix.transpose();
+        const FramePacket::PrimitiveInstance& primitiveInstance = renderPacket->primitives[primIdx];
+        primitivesModelMatricess[primIdx] = primitiveInstance.modelMatrix.transpose();
 
         DrawCmd& drawCmd = worldRenderer->allocateRectanglePrimitiveDrawCmd();
-        drawCmd.infos.material = primitivesToRenderArray[primIdx].material;
+        drawCmd.infos.material = primitiveInstance.material;
         drawCmd.infos.instanceCount = static_cast< uint32_t >( 1u );
         drawCmd.infos.modelMatrix = &primitivesModelMatricess[primIdx];
 
         auto& key = drawCmd.key.bitfield;
-        key.materialSortKey = primitivesToRenderArray[primIdx].material->getSortKey();
+        key.materialSortKey = primitiveInstance.material->getSortKey();
         key.depth = DepthToBits( 0.0f );
         key.sortOrder = DrawCommandKey::SORT_BACK_TO_FRONT;
         key.layer = DrawCommandKey::Layer::LAYER_HUD;
@@ -514,11 +1054,10 @@ void DrawCommandBuilder::buildHUDDrawCmds( WorldRenderer* worldRenderer, CameraD
         key.viewportId = cameraIdx;
     }
 
-    TextDrawCommand* textDrawCmdArray = static_cast<TextDrawCommand*>( textToRenderAllocator->getBaseAddress() );
-    const size_t textToDrawCount = textToRenderAllocator->getAllocationCount();
+    const uint32_t textToDrawCount = renderPacket->texts.getEntryCount();
 
     for ( uint32_t textIdx = 0; textIdx < textToDrawCount; textIdx++ ) {
-        const TextDrawCommand& drawCmd = textDrawCmdArray[textIdx];
-        worldRenderer->TextRenderModule->addOutlinedText( drawCmd.stringToPrint.c_str(), drawCmd.scale, drawCmd.positionScreenSpace.x, drawCmd.positionScreenSpace.y, drawCmd.color );
+        const FramePacket::TextDrawCommand& drawCmd = renderPacket->texts[textIdx];
+        worldRenderer->TextRenderModule->addOutlinedText( drawCmd.stringToPrint.c_str(), drawCmd.stringHashcode, drawCmd.scale, drawCmd.positionScreenSpace.x, drawCmd.positionScreenSpace.y, drawCmd.color );
     }
 }
@@ -25,31 +25,40 @@ class WorldRenderer;
 class Mesh;
 class VertexArrayObject;
 class LightGrid;
-class PoolAllocator;
-class StackAllocator;
+class IBLProbeCache;
 class Material;
 class GraphicsAssetCache;
+class LineRenderingModule;
 
 struct CameraData;
 struct IBLProbeData;
 struct AABB;
-
-#include <stack>
+struct Frustum;
 
 #include <Maths/Vector.h>
 #include <Maths/Matrix.h>
 
-enum eProbeCaptureStep : uint16_t
-{
-    FACE_X_PLUS = 0,
-    FACE_X_MINUS,
+#include <Maths/AABB.h>
 
-    FACE_Y_PLUS,
-    FACE_Y_MINUS,
+#include "IBLProbeUpdateScheduler.h"
+#include "CSMUpdateScheduler.h"
+#include "ShadowAtlas.h"
+#include "FramePacket.h"
 
-    FACE_Z_PLUS,
-    FACE_Z_MINUS,
-};
+#include <Core/Containers/HashMap.h>
+
+#include <vector>
+
+namespace nya
+{
+    namespace graphics
+    {
+        nyaMat4x4f ComputeHUDRectangleModelMatrix( const nyaVec2f& positionScreenSpace, const nyaVec2f& dimensionScreenSpace, const float rotationInRadians );
+    }
+}
+
+// Upper bound of local shadow caster instances rendered in a single frame (casters share the pipeline instance buffer)
+static constexpr uint32_t MAX_LOCAL_SHADOW_CASTER_COUNT = 128u;
 
 class DrawCommandBuilder
 {
@@ -70,109 +79,90 @@ public:
     void                        loadDebugResources( GraphicsAssetCache* graphicsAssetCache );
 #endif
 
+    // Packet written by the add* functions (game side)
+    void                        setSubmissionPacket( FramePacket* framePacket );
+
     void                        addGeometryToRender( const Mesh* meshResource, const nyaMat4x4f* modelMatrix, const uint32_t flagset );
     void                        addSphereToRender( const nyaVec3f& sphereCenter, const float sphereRadius, Material* material );
     void                        addAABBToRender( const AABB& aabb, Material* material );
     void                        addCamera( CameraData* cameraData );
     void                        addIBLProbeToCapture( const IBLProbeData* probeData );
     void                        addHUDRectangle( const nyaVec2f& positionScreenSpace, const nyaVec2f& dimensionScreenSpace, const float rotationInRadians, Material* material );
+    void                        addHUDRectangle( const nyaMat4x4f& modelMatrix, Material* material );
 
     void                        addHUDText( const nyaVec2f& positionScreenSpace, const float size, const nyaVec4f& colorAndAlpha, const std::string& value );
+    void                        addHUDText( const nyaVec2f& positionScreenSpace, const float size, const nyaVec4f& colorAndAlpha, const std::string& value, const nyaStringHash_t valueHashcode );
 
-    void                        buildRenderQueues( WorldRenderer* worldRenderer, LightGrid* lightGrid );
+    // Submit commands built ahead of time (e.g. retained GUI widgets); commands are copied to the packet as is
+    void                        addHUDRectangle( const FramePacket::PrimitiveInstance& rectangleCmd );
+    void                        addHUDText( const FramePacket::TextDrawCommand& textCmd );
+    // Lifetime is in seconds (0 means a single frame)
+    void                        addLineToRender( const nyaVec3f& from, const nyaVec3f& to, const nyaVec4f& color, const float lifetime = 0.0f );
 
-private:
-    struct MeshInstance {
-        const Mesh*         mesh;
-        const nyaMat4x4f*   modelMatrix;
-
-        // TODO Unify with Scene mesh instance flagset
-        union {
-            struct {
-                uint8_t isVisible : 1;
-                uint8_t renderDepth : 1;
-                uint8_t useBatching : 1;
-                uint8_t : 0;
-            };
-
-            uint32_t    flags;
-        };
-    };
+    // Persistent debug line batches (uploaded once on the render side); a batch is only drawn on frames it is added to the packet
+    // updateLineBatch replaces the content of the batch and draws it (the returned update must be filled before the packet is submitted)
+    // NOTE Batches are identified by their key; those functions are not thread safe
+    void                        addLineBatchToRender( const nyaStringHash_t batchKey );
+    FramePacket::LineBatchUpdate& updateLineBatch( const nyaStringHash_t batchKey );
 
-    struct IBLProbeCaptureCommand {
-        union {
-            // Higher bytes contains probe index (from the lowest to the highest one available in the queue)
-            // Lower bytes contains face to render (not used in queue sort)
-            struct {
-                uint32_t            EnvProbeArrayIndex;
-                eProbeCaptureStep   Step;
-                uint16_t            __PADDING__;
-            } CommandInfos;
+    // NOTE addGeometryToRender, addSphereToRender, addAABBToRender, addHUDRectangle, addHUDText and addLineToRender are thread safe
+    // (threads get a unique submission index on first use; call nya::core::SetSubmissionThreadIndex to pin it explicitly)
+    // Model matrices are copied to the packet (the game side matrix can be modified once the packet is submitted)
 
-            int64_t ProbeKey;
-        };
+    // Render side: build the render queues of a submitted packet (the packet must be kept alive until the world has been drawn)
+    void                        buildRenderQueues( WorldRenderer* worldRenderer, LightGrid* lightGrid, FramePacket* framePacket );
 
-        const IBLProbeData*   Probe;
+    const IBLProbeUpdateScheduler& getProbeUpdateScheduler() const;
+    const CSMUpdateScheduler&   getCSMUpdateScheduler() const;
 
-        inline bool operator < ( const IBLProbeCaptureCommand& cmd ) {
-            return ProbeKey < cmd.ProbeKey;
-        }
-    };
+    // Probes are restored from the cache when possible (and written to the cache once captured in bake mode)
+    void                        setIBLProbeCache( IBLProbeCache* probeCache );
 
-    struct IBLProbeConvolutionCommand {
-        union {
-            // Higher bytes contains probe index (from the lowest to the highest one available in the queue)
-            // Lower bytes contains mip index (with padding)
-            struct {
-                uint32_t            EnvProbeArrayIndex;
-                eProbeCaptureStep   Step;
-                uint16_t            MipIndex;
-            } CommandInfos;
+    // Returns true once every probe has been captured and written to the cache (always false if the bake mode is disabled)
+    bool                        isIBLProbeBakeComplete() const;
 
-            int64_t ProbeKey;
-        };
-
-        const IBLProbeData* Probe;
-
-        inline bool operator < ( const IBLProbeConvolutionCommand& cmd ) {
-            return ProbeKey < cmd.ProbeKey;
-        }
-    };
-
-    struct PrimitiveInstance {
-        nyaMat4x4f      modelMatrix;
-        Material*       material;
-    };
-
-    struct TextDrawCommand
-    {
-        std::string     stringToPrint;
-        nyaVec4f        color;
-        nyaVec2f        positionScreenSpace;
-        float           scale;
+private:
+    // Shadow caster state from the previous frame (used to invalidate cached local shadow maps)
+    struct ShadowCasterState {
+        const Mesh*         mesh;
+        const nyaMat4x4f*   modelMatrixPointer;
+        nyaMat4x4f          modelMatrix;
+        AABB                meshBounds; // Meshes can be replaced in place (streaming, hot reload)
+        AABB                worldBounds;
     };
 
 private:
     BaseAllocator*                          memoryAllocator;
 
-    PoolAllocator*                          cameras;
-    PoolAllocator*                          meshes;
-    PoolAllocator*                          spheresToRender;
-    nyaMat4x4f                              sphereToRender[8192];
+    FramePacket*                            submissionPacket;
+    FramePacket*                            renderPacket;
 
-    PoolAllocator*                          primitivesToRender;
+    nyaMat4x4f                              sphereToRender[8192];
     nyaMat4x4f                              primitivesModelMatricess[8192];
 
-    PoolAllocator*                          textToRenderAllocator;
+    IBLProbeUpdateScheduler                 probeUpdateScheduler;
+    CSMUpdateScheduler                      csmUpdateScheduler;
+
+    IBLProbeCache*                          iblProbeCache;
+    std::vector<const IBLProbeData*>        probesToRestore;
 
-    StackAllocator*                         probeCaptureCmdAllocator;
-    StackAllocator*                         probeConvolutionCmdAllocator;
+    std::vector<ShadowCasterState>          shadowCasters;
+    std::vector<uint32_t>                   shadowLightIndexes;
+    std::vector<LocalShadowRequest>         shadowRequests;
+    nyaMat4x4f                              localShadowCasterMatrices[MAX_LOCAL_SHADOW_CASTER_COUNT];
 
-    std::stack<IBLProbeCaptureCommand*>     probeCaptureCmds;
-    std::stack<IBLProbeConvolutionCommand*> probeConvolutionCmds;
+    // Render side handles of the persistent line batches (LineBatchHandle_t; allocated on the first update of a batch key)
+    HashMap<nyaStringHash_t, uint32_t>      lineBatchHandles;
 
 private:
-    void                        resetEntityCounters();
-    void                        buildMeshDrawCmds( WorldRenderer* worldRenderer, CameraData* camera, const uint8_t cameraIdx, const uint8_t layer, const uint8_t viewportLayer );
+    void                        scheduleProbeCaptures( LightGrid* lightGrid );
+    // Returns the number of draw commands built (if cullingFrustum is null, the camera frustum is used)
+    uint32_t                    buildMeshDrawCmds( WorldRenderer* worldRenderer, CameraData* camera, const uint8_t cameraIdx, const uint8_t layer, const uint8_t viewportLayer, const Frustum* cullingFrustum = nullptr );
+    void                        computeVisibleDepthRange( const CameraData* camera, float& minDepth, float& maxDepth );
     void                        buildHUDDrawCmds( WorldRenderer* worldRenderer, CameraData* camera, const uint8_t cameraIdx );
+    void                        buildLocalShadowDrawCmds( WorldRenderer* worldRenderer, LightGrid* lightGrid, CameraData* camera, const uint8_t cameraIdx );
+    void                        invalidateMovedShadowCasters( WorldRenderer* worldRenderer );
+    void                        restoreCachedProbes( WorldRenderer* worldRenderer, LightGrid* lightGrid );
+    void                        updateLineBatches( LineRenderingModule* lineRenderModule );
+    void                        buildProbeCaptureRenderQueue( WorldRenderer* worldRenderer, LightGrid* lightGrid, const IBLProbeUpdateCommand& command, const uint8_t cameraIdx );
 };
@@ -0,0 +1,166 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "DynamicResolutionController.h"
+
+#include <Core/EnvVarsRegister.h>
+
+#include <Maths/Helpers.h>
+
+#include <cmath>
+
+NYA_ENV_VAR( DynamicResolutionFrameBudget, 16.6667f, float ) // "Frame time targeted by the dynamic resolution controller (in ms)"
+NYA_ENV_VAR( DynamicResolutionMinImageQuality, 0.5f, float ) // "Lowest image quality the dynamic resolution controller can pick [0.1..N]"
+NYA_ENV_VAR( DynamicResolutionMaxImageQuality, 1.0f, float ) // "Highest image quality the dynamic resolution controller can pick [0.1..N]"
+NYA_ENV_VAR( DynamicResolutionUpscaleThreshold, 0.85f, float ) // "Fraction of the frame budget below which the resolution is increased [0.1..1]"
+
+// Exponential moving average weight for frame times
+static constexpr double FRAME_TIME_SMOOTHING = 0.2;
+
+// Consecutive frames over (or under) budget required to change the resolution
+static constexpr uint32_t DOWNSCALE_FRAME_COUNT = 3u;
+static constexpr uint32_t UPSCALE_FRAME_COUNT = 30u;
+
+// Frames to wait after a change (GPU timings are retrieved a few frames late)
+static constexpr uint32_t COOLDOWN_FRAME_COUNT = 8u;
+
+// Image quality granularity (avoids reallocating render targets for tiny changes)
+static constexpr float IMAGE_QUALITY_STEP = 0.05f;
+
+// Max relative change of the image quality per decision
+static constexpr float MAX_DOWNSCALE_RATIO = 0.75f;
+static constexpr float MAX_UPSCALE_RATIO = 1.10f;
+
+DynamicResolutionController::DynamicResolutionController()
+    : imageQuality( 1.0f )
+    , smoothedFrameTime( -1.0 )
+    , overBudgetFrameCount( 0u )
+    , underBudgetFrameCount( 0u )
+    , cooldownFrameCount( 0u )
+    , lastDecision( DECISION_HOLD )
+    , isCPUBoundFrame( false )
+{
+
+}
+
+DynamicResolutionController::~DynamicResolutionController()
+{
+    imageQuality = 1.0f;
+    smoothedFrameTime = -1.0;
+}
+
+float DynamicResolutionController::onFrame( const double gpuFrameTimeInMs, const double cpuFrameTimeInMs )
+{
+    const float minImageQuality = nya::maths::max( 0.1f, static_cast<float>( DynamicResolutionMinImageQuality ) );
+    const float maxImageQuality = nya::maths::max( minImageQuality, static_cast<float>( DynamicResolutionMaxImageQuality ) );
+    const double frameBudget = nya::maths::max( 0.1, static_cast<double>( DynamicResolutionFrameBudget ) );
+    const double upscaleThreshold = frameBudget * nya::maths::clamp( static_cast<double>( DynamicResolutionUpscaleThreshold ), 0.1, 1.0 );
+
+    // The resolution only affects the GPU cost; the CPU frame time is used if no GPU timing is available
+    const bool hasGPUTime = ( gpuFrameTimeInMs >= 0.0 );
+    const double frameTime = ( hasGPUTime ) ? gpuFrameTimeInMs : cpuFrameTimeInMs;
+
+    smoothedFrameTime = ( smoothedFrameTime < 0.0 ) ? frameTime : nya::maths::lerp( smoothedFrameTime, frameTime, FRAME_TIME_SMOOTHING );
+
+    // Lowering the resolution won't help if the CPU is the bottleneck
+    isCPUBoundFrame = ( hasGPUTime && cpuFrameTimeInMs > frameBudget && smoothedFrameTime <= frameBudget );
+
+    lastDecision = DECISION_HOLD;
+
+    if ( cooldownFrameCount > 0u ) {
+        cooldownFrameCount--;
+    } else if ( smoothedFrameTime > frameBudget ) {
+        underBudgetFrameCount = 0u;
+        overBudgetFrameCount++;
+
+        if ( overBudgetFrameCount >= DOWNSCALE_FRAME_COUNT && imageQuality > minImageQuality ) {
+            lastDecision = DECISION_DOWNSCALE;
+        }
+    } else if ( smoothedFrameTime < upscaleThreshold ) {
+        overBudgetFrameCount = 0u;
+        underBudgetFrameCount++;
+
+        if ( underBudgetFrameCount >= UPSCALE_FRAME_COUNT && imageQuality < maxImageQuality ) {
+            lastDecision = DECISION_UPSCALE;
+        }
+    } else {
+        overBudgetFrameCount = 0u;
+        underBudgetFrameCount = 0u;
+    }
+
+    if ( lastDecision != DECISION_HOLD ) {
+        // Aim for the middle of the hysteresis band
+        // The GPU cost is roughly proportional to the pixel count (imageQuality^2)
+        const double targetFrameTime = ( frameBudget + upscaleThreshold ) * 0.5;
+        const float scaleRatio = static_cast<float>( std::sqrt( targetFrameTime / nya::maths::max( smoothedFrameTime, 1e-3 ) ) );
+
+        float targetImageQuality = imageQuality * nya::maths::clamp( scaleRatio, MAX_DOWNSCALE_RATIO, MAX_UPSCALE_RATIO );
+        targetImageQuality = std::round( targetImageQuality / IMAGE_QUALITY_STEP ) * IMAGE_QUALITY_STEP;
+
+        // Always move by at least one step
+        if ( lastDecision == DECISION_DOWNSCALE ) {
+            targetImageQuality = nya::maths::min( targetImageQuality, imageQuality - IMAGE_QUALITY_STEP );
+        } else {
+            targetImageQuality = nya::maths::max( targetImageQuality, imageQuality + IMAGE_QUALITY_STEP );
+        }
+
+        imageQuality = nya::maths::clamp( targetImageQuality, minImageQuality, maxImageQuality );
+
+        overBudgetFrameCount = 0u;
+        underBudgetFrameCount = 0u;
+        cooldownFrameCount = COOLDOWN_FRAME_COUNT;
+    }
+
+    // The allowed range might have changed since the last frame
+    imageQuality = nya::maths::clamp( imageQuality, minImageQuality, maxImageQuality );
+
+    NYA_PROFILE_STAT( "Dynamic Resolution Image Quality", imageQuality )
+    NYA_PROFILE_STAT( "Dynamic Resolution Frame Time (ms)", smoothedFrameTime )
+    NYA_PROFILE_STAT( "Dynamic Resolution Decision", static_cast<int32_t>( lastDecision ) )
+    NYA_PROFILE_STAT( "Dynamic Resolution CPU Bound", isCPUBoundFrame )
+
+    return imageQuality;
+}
+
+void DynamicResolutionController::reset( const float initialImageQuality )
+{
+    imageQuality = initialImageQuality;
+    smoothedFrameTime = -1.0;
+    overBudgetFrameCount = 0u;
+    underBudgetFrameCount = 0u;
+    cooldownFrameCount = 0u;
+    lastDecision = DECISION_HOLD;
+    isCPUBoundFrame = false;
+}
+
+float DynamicResolutionController::getImageQuality() const
+{
+    return imageQuality;
+}
+
+DynamicResolutionController::eDecision DynamicResolutionController::getLastDecision() const
+{
+    return lastDecision;
+}
+
+bool DynamicResolutionController::isCPUBound() const
+{
+    return isCPUBoundFrame;
+}
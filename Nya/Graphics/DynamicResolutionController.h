@@ -0,0 +1,62 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+// Adjusts the render resolution (camera image quality) to keep the frame time below a frame budget
+// Frame times are smoothed and decisions need several consecutive frames to be taken (the resolution is only
+// increased once the frame time is well below the budget, to avoid oscillations)
+// NOTE The controller does not depend on the renderer (timings can be fed by hand, e.g. synthetic timings)
+class DynamicResolutionController
+{
+public:
+    enum eDecision : int32_t
+    {
+        DECISION_DOWNSCALE = -1,
+        DECISION_HOLD = 0,
+        DECISION_UPSCALE = 1,
+    };
+
+public:
+                                    DynamicResolutionController();
+                                    DynamicResolutionController( DynamicResolutionController& ) = delete;
+                                    DynamicResolutionController& operator = ( DynamicResolutionController& ) = delete;
+                                    ~DynamicResolutionController();
+
+    // Feed the timings of the latest frame (in ms) and return the image quality to use for the next frame
+    // gpuFrameTimeInMs can be negative if no GPU timing is available (the CPU frame time is used instead)
+    float                           onFrame( const double gpuFrameTimeInMs, const double cpuFrameTimeInMs );
+
+    void                            reset( const float initialImageQuality = 1.0f );
+
+    float                           getImageQuality() const;
+    eDecision                       getLastDecision() const;
+    bool                            isCPUBound() const;
+
+private:
+    float                           imageQuality;
+    double                          smoothedFrameTime;
+
+    uint32_t                        overBudgetFrameCount;
+    uint32_t                        underBudgetFrameCount;
+    uint32_t                        cooldownFrameCount;
+
+    eDecision                       lastDecision;
+    bool                            isCPUBoundFrame;
+};
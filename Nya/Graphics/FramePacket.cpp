@@ -0,0 +1,207 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "FramePacket.h"
+
+#include <Core/Timer.h>
+
+void FramePacket::create( BaseAllocator* allocator )
+{
+    meshes.create( allocator, 4096 );
+    spheres.create( allocator, 4096 );
+    primitives.create( allocator, 4096 );
+    texts.create( allocator, 1024 );
+    lines.create( allocator, 1024 );
+
+    clear();
+}
+
+void FramePacket::destroy( BaseAllocator* allocator )
+{
+    meshes.destroy( allocator );
+    spheres.destroy( allocator );
+    primitives.destroy( allocator );
+    texts.destroy( allocator );
+    lines.destroy( allocator );
+
+    iblProbesToCapture.clear();
+    lineBatches.clear();
+    lineBatchUpdates.clear();
+}
+
+void FramePacket::clear()
+{
+    frameIndex = 0u;
+    frameTime = 0.0f;
+    sceneHash = 0u;
+    cameraCount = 0u;
+
+    meshes.clear();
+    spheres.clear();
+    primitives.clear();
+    texts.clear();
+    lines.clear();
+
+    iblProbesToCapture.clear();
+    lineBatches.clear();
+    lineBatchUpdates.clear();
+}
+
+void FramePacket::merge()
+{
+    meshes.merge();
+    spheres.merge();
+    primitives.merge();
+    texts.merge();
+    lines.merge();
+}
+
+FramePacketQueue::FramePacketQueue( BaseAllocator* allocator, const uint32_t packetCount )
+    : memoryAllocator( allocator )
+    , packetCount( packetCount )
+    , frameIndex( 0u )
+    , submissionIndex( 0u )
+    , renderIndex( 0u )
+    , usedPacketCount( 0u )
+    , pendingPacketCount( 0u )
+    , isShutdown( false )
+    , lastSubmissionWaitTime( 0.0 )
+    , lastRenderWaitTime( 0.0 )
+{
+    NYA_DEV_ASSERT( packetCount > 0u && packetCount <= MAX_PACKET_COUNT, "Invalid frame packet count (%u; should be in [1..%u])", packetCount, MAX_PACKET_COUNT );
+
+    for ( uint32_t packetIdx = 0u; packetIdx < packetCount; packetIdx++ ) {
+        packets[packetIdx].create( allocator );
+    }
+}
+
+FramePacketQueue::~FramePacketQueue()
+{
+    for ( uint32_t packetIdx = 0u; packetIdx < packetCount; packetIdx++ ) {
+        packets[packetIdx].destroy( memoryAllocator );
+    }
+
+    packetCount = 0u;
+}
+
+FramePacket* FramePacketQueue::acquireSubmissionPacket()
+{
+    Timer waitTimer;
+    nya::core::StartTimer( &waitTimer );
+
+    FramePacket* packet = nullptr;
+    {
+        std::unique_lock<std::mutex> lock( queueMutex );
+        packetReleasedEvent.wait( lock, [&]() { return isShutdown || usedPacketCount < packetCount; } );
+
+        if ( !isShutdown ) {
+            packet = &packets[submissionIndex];
+            usedPacketCount++;
+        }
+    }
+
+    lastSubmissionWaitTime = nya::core::GetTimerDeltaAsMiliseconds( &waitTimer );
+    NYA_PROFILE_STAT( "Frame Packet Submission Wait (ms)", lastSubmissionWaitTime )
+
+    if ( packet != nullptr ) {
+        packet->clear();
+        packet->frameIndex = frameIndex++;
+    }
+
+    return packet;
+}
+
+void FramePacketQueue::submit( FramePacket* packet )
+{
+    {
+        std::lock_guard<std::mutex> lock( queueMutex );
+
+        NYA_DEV_ASSERT( packet == &packets[submissionIndex], "Frame packets should be submitted in the order they have been acquired (expected packet %u)", submissionIndex );
+
+        submissionIndex = ( submissionIndex + 1u ) % packetCount;
+        pendingPacketCount++;
+
+        NYA_PROFILE_STAT( "Frame Packets In Flight", usedPacketCount )
+    }
+
+    packetSubmittedEvent.notify_one();
+}
+
+FramePacket* FramePacketQueue::acquireRenderPacket()
+{
+    Timer waitTimer;
+    nya::core::StartTimer( &waitTimer );
+
+    FramePacket* packet = nullptr;
+    {
+        std::unique_lock<std::mutex> lock( queueMutex );
+        packetSubmittedEvent.wait( lock, [&]() { return isShutdown || pendingPacketCount > 0u; } );
+
+        if ( pendingPacketCount > 0u ) {
+            packet = &packets[renderIndex];
+            pendingPacketCount--;
+        }
+    }
+
+    lastRenderWaitTime = nya::core::GetTimerDeltaAsMiliseconds( &waitTimer );
+    NYA_PROFILE_STAT( "Frame Packet Render Wait (ms)", lastRenderWaitTime )
+
+    return packet;
+}
+
+void FramePacketQueue::release( FramePacket* packet )
+{
+    {
+        std::lock_guard<std::mutex> lock( queueMutex );
+
+        NYA_DEV_ASSERT( packet == &packets[renderIndex], "Frame packets should be released in the order they have been submitted (expected packet %u)", renderIndex );
+
+        renderIndex = ( renderIndex + 1u ) % packetCount;
+        usedPacketCount--;
+    }
+
+    packetReleasedEvent.notify_one();
+}
+
+void FramePacketQueue::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock( queueMutex );
+        isShutdown = true;
+    }
+
+    packetReleasedEvent.notify_all();
+    packetSubmittedEvent.notify_all();
+}
+
+uint32_t FramePacketQueue::getPacketCount() const
+{
+    return packetCount;
+}
+
+double FramePacketQueue::getLastSubmissionWaitTime() const
+{
+    return lastSubmissionWaitTime;
+}
+
+double FramePacketQueue::getLastRenderWaitTime() const
+{
+    return lastRenderWaitTime;
+}
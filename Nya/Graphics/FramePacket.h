@@ -0,0 +1,182 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+class Mesh;
+class Material;
+
+#include <Maths/Vector.h>
+#include <Maths/Matrix.h>
+#include <Maths/AABB.h>
+
+#include <Framework/Cameras/Camera.h>
+
+#include <Core/Threading/SubmissionQueue.h>
+
+#include "LightGrid.h"
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+
+// Snapshot of everything the renderer needs to draw a frame (cameras, draw lists, lights)
+// Written by the game thread, then handed off to the render thread (which owns the packet until it is released)
+// NOTE Packets only store copies; game data can be modified as soon as the packet is submitted
+struct FramePacket
+{
+    static constexpr uint32_t   MAX_CAMERA_COUNT = 8u;
+
+    struct MeshInstance {
+        const Mesh*         mesh;
+        nyaMat4x4f          modelMatrix;
+
+        // Address of the game side matrix (identifies the instance from one frame to the next)
+        const nyaMat4x4f*   modelMatrixKey;
+
+        // TODO Unify with Scene mesh instance flagset
+        union {
+            struct {
+                uint8_t isVisible : 1;
+                uint8_t renderDepth : 1;
+                uint8_t useBatching : 1;
+                uint8_t : 0;
+            };
+
+            uint32_t    flags;
+        };
+    };
+
+    struct PrimitiveInstance {
+        nyaMat4x4f      modelMatrix;
+        Material*       material;
+    };
+
+    struct TextDrawCommand {
+        std::string     stringToPrint;
+        nyaStringHash_t stringHashcode;
+        nyaVec4f        color;
+        nyaVec2f        positionScreenSpace;
+        float           scale;
+    };
+
+    struct LineDrawCommand {
+        nyaVec3f        from;
+        nyaVec3f        to;
+        nyaVec4f        color;
+        float           lifetime; // In seconds (0 means a single frame)
+    };
+
+    // Replaces the content of a persistent debug line batch (only submitted when the content has changed)
+    struct LineBatchUpdate {
+        nyaStringHash_t         batchKey;
+        nyaVec4f                color;
+        std::vector<AABB>       aabbs;
+        std::vector<nyaVec4f>   spheres; // Center (xyz) and radius (w)
+
+        // Optional ground grid (ignored if gridCellCount is 0)
+        nyaVec3f                gridCenter;
+        float                   gridExtent;
+        uint32_t                gridCellCount;
+    };
+
+    uint32_t                            frameIndex;
+    float                               frameTime;
+    uint32_t                            sceneHash;
+
+    CameraData                          cameras[MAX_CAMERA_COUNT];
+    uint32_t                            cameraCount;
+
+    SubmissionQueue<MeshInstance>       meshes;
+    SubmissionQueue<PrimitiveInstance>  spheres;
+    SubmissionQueue<PrimitiveInstance>  primitives;
+    SubmissionQueue<TextDrawCommand>    texts;
+    SubmissionQueue<LineDrawCommand>    lines;
+
+    // Probe array indexes (IBLProbeData::ProbeIndex)
+    std::vector<uint32_t>               iblProbesToCapture;
+
+    // Persistent debug line batches drawn this frame (batch keys), and batches whose content has been replaced
+    std::vector<nyaStringHash_t>        lineBatches;
+    std::vector<LineBatchUpdate>        lineBatchUpdates;
+
+    LightGrid::FrameLights              lights;
+
+    void                                create( BaseAllocator* allocator );
+    void                                destroy( BaseAllocator* allocator );
+    void                                clear();
+
+    // Build the iteration order of the submission queues (call once every producer is done)
+    void                                merge();
+};
+
+// Bounded FIFO of frame packets between the game thread and the render thread
+// With N packets, the game thread can run up to N - 1 frames ahead of the render thread (2: double buffering; 3: triple buffering)
+// Sequential execution (acquire, submit then render on the same thread) is supported
+class FramePacketQueue
+{
+public:
+    static constexpr uint32_t           MAX_PACKET_COUNT = 3u;
+
+public:
+                                        FramePacketQueue( BaseAllocator* allocator, const uint32_t packetCount );
+                                        FramePacketQueue( FramePacketQueue& ) = delete;
+                                        FramePacketQueue& operator = ( FramePacketQueue& ) = delete;
+                                        ~FramePacketQueue();
+
+    // Game thread: returns an empty packet (blocks until the render thread releases one); returns nullptr once the queue is shut down
+    FramePacket*                        acquireSubmissionPacket();
+    void                                submit( FramePacket* packet );
+
+    // Render thread: returns the oldest submitted packet (blocks until a packet is submitted)
+    // Returns nullptr once the queue is shut down and every submitted packet has been rendered
+    FramePacket*                        acquireRenderPacket();
+    void                                release( FramePacket* packet );
+
+    // Wake up both threads (pending packets are still returned to the render thread)
+    void                                shutdown();
+
+    uint32_t                            getPacketCount() const;
+
+    // Time spent waiting in the last call to acquireSubmissionPacket/acquireRenderPacket (in milliseconds)
+    double                              getLastSubmissionWaitTime() const;
+    double                              getLastRenderWaitTime() const;
+
+private:
+    BaseAllocator*                      memoryAllocator;
+
+    FramePacket                         packets[MAX_PACKET_COUNT];
+    uint32_t                            packetCount;
+    uint32_t                            frameIndex;
+
+    std::mutex                          queueMutex;
+    std::condition_variable             packetReleasedEvent;
+    std::condition_variable             packetSubmittedEvent;
+
+    // Packets are used in a round robin order (the oldest packet is always released first)
+    uint32_t                            submissionIndex;
+    uint32_t                            renderIndex;
+    uint32_t                            usedPacketCount;
+    uint32_t                            pendingPacketCount;
+    bool                                isShutdown;
+
+    double                              lastSubmissionWaitTime;
+    double                              lastRenderWaitTime;
+};
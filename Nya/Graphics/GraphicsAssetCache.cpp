@@ -17,13 +17,13 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
-
 #include "Shared.h"
 #include "GraphicsAssetCache.h"
 
 // Io
 #include <FileSystem/VirtualFileSystem.h>
 #include <FileSystem/FileSystemObject.h>
+#include <FileSystem/FileSystemObjectMemory.h>
 
 #include <Io/DirectDrawSurface.h>
 #include <Io/FontDescriptor.h>
@@ -36,7 +36,7 @@
 #endif
 
 #include <Core/Allocators/BaseAllocator.h>
-#include <Core/Allocators/FreeListAllocator.h>
+#include <Core/Allocators/TLSFAllocator.h>
 
 // Assets
 #include <Rendering/RenderDevice.h>
@@ -46,40 +46,73 @@
 #include <Framework/Material.h>
 
 #include <Core/StringHelpers.h>
+#include <Core/EnvVarsRegister.h>
+#include <Core/Timer.h>
+
+#include <Maths/Helpers.h>
+
+#include <string.h>
+#include <algorithm>
 
 using namespace nya::core;
 
-GraphicsAssetCache::GraphicsAssetCache( BaseAllocator* allocator, RenderDevice* renderDevice, ShaderCache* shaderCache, VirtualFileSystem* virtualFileSystem )
-    : assetStreamingHeap( nya::core::allocate<FreeListAllocator>( allocator, 32 * 1024 * 1024, allocator->allocate( 32 * 1024 * 1024 ) ) )
-    , renderDevice( renderDevice )
-    , shaderCache( shaderCache )
-    , virtualFileSystem( virtualFileSystem )
-{
-    defaultMaterial = getMaterial( NYA_STRING( "GameData/materials/DefaultMaterial.mat" ) );
-}
+NYA_ENV_VAR( AssetStreamingWorkerCount, 2, uint32_t ) // "Number of threads loading and decoding the assets requested asynchronously (0: requests are loaded by the thread finalizing them) [0..8]"
+NYA_ENV_VAR( AssetStreamingBudget, 2.0f, float ) // "Per-frame time budget for the finalization (GPU resource creation) of the assets requested asynchronously (in ms)"
+NYA_ENV_VAR( AssetTextureBudget, 512, uint32_t ) // "Memory budget of the cached textures (in MB; unreferenced textures are evicted once the budget is exceeded)"
+NYA_ENV_VAR( AssetMeshBudget, 256, uint32_t ) // "Memory budget of the cached meshes (in MB; unreferenced meshes are evicted once the budget is exceeded)"
+NYA_ENV_VAR( AssetMaterialBudget, 8, uint32_t ) // "Memory budget of the cached materials (in MB; unreferenced materials are evicted once the budget is exceeded)"
 
-GraphicsAssetCache::~GraphicsAssetCache()
-{
-    meshMap.clear();
-    materialMap.clear();
-    fontMap.clear();
-    textureMap.clear();
-}
+// Number of frames an unreferenced asset stays resident (frames in flight might still use it)
+static constexpr uint32_t EVICTION_FRAME_DELAY = 4u;
 
-void GraphicsAssetCache::destroy()
+// Free memory kept in the streaming heap (free list fragmentation)
+static constexpr size_t HEAP_RESERVE_MARGIN = 64 * 1024;
+
+// TODO Custom Distance Definition (define per model LoD distance?)
+static constexpr float LOD_DISTANCE[4] = { 250.0f, 500.0f, 1000.0f, 2048.0f };
+
+// Decoded texels, ready to be uploaded
+struct TextureLoadData
 {
-    for ( auto& meshes : meshMap ) {
-        meshes.second->destroy( renderDevice );
-    }
+    TextureDescription      description;
+    std::vector<uint8_t>    texels;
+    size_t                  rowPitch;
 
-    for ( auto& mat : materialMap ) {
-        mat.second->destroy( renderDevice );
-    }
+    // Texels to upload (point either to texels or to the mapped file content)
+    const uint8_t*          texelsData = nullptr;
+    size_t                  texelsSize = 0;
+};
 
-    for ( auto& texture : textureMap ) {
-        renderDevice->destroyTexture( texture.second );
-    }
-}
+struct AsyncLoadRequest
+{
+    enum eAssetType {
+        ASSET_TYPE_TEXTURE = 0,
+        ASSET_TYPE_MESH,
+        ASSET_TYPE_MATERIAL,
+    } assetType;
+
+    enum eRequestState {
+        REQUEST_STATE_PENDING = 0,
+        REQUEST_STATE_LOADED,
+        REQUEST_STATE_FAILED,
+    } state;
+
+    nyaString_t             assetName;
+    nyaStringHash_t         assetHashcode;
+
+    // Handle returned to the caller (backed by a placeholder until the request is finalized)
+    union {
+        Texture*            texture;
+        Mesh*               mesh;
+        Material*           material;
+    };
+
+    // Worker output
+    FileSystemObject*       mappedFile; // Kept open until finalization if the loaded data points to the file content
+    TextureLoadData         textureData;
+    GeomLoadData            meshData;
+    std::vector<uint8_t>    materialContent; // Parsed on finalization (the material might request other assets)
+};
 
 int stbi_readcallback( void *user, char *data, int size )
 {
@@ -100,22 +133,8 @@ void stbi_skipcallback( void *user, int n )
     f->skip( n );
 }
 
-Texture* GraphicsAssetCache::getTexture( const nyaChar_t* assetName, const bool forceReload )
+static bool LoadTextureData( FileSystemObject* file, const nyaString_t& assetName, TextureLoadData& textureData )
 {
-    auto file = virtualFileSystem->openFile( assetName, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY );
-    if ( file == nullptr ) {
-        NYA_CERR << "'" << assetName << "' does not exist!" << std::endl;
-        return nullptr;
-    }
-
-    auto assetHashcode = file->getHashcode();
-    auto mapIterator = textureMap.find( assetHashcode );
-    const bool alreadyExists = ( mapIterator != textureMap.end() );
-
-    if ( alreadyExists && !forceReload ) {
-        return mapIterator->second;
-    }
-
     auto texFileFormat = GetFileExtensionFromPath( assetName );
     StringToLower( texFileFormat );
     auto texFileFormatHashcode = CRC32( texFileFormat );
@@ -125,22 +144,12 @@ Texture* GraphicsAssetCache::getTexture( const nyaChar_t* assetName, const bool
         DirectDrawSurface ddsData;
         LoadDirectDrawSurface( file, ddsData );
 
-        if ( alreadyExists ) {
-            renderDevice->destroyTexture( textureMap[assetHashcode] );
-        }
-
-        switch ( ddsData.textureDescription.dimension ) {
-        case TextureDescription::DIMENSION_TEXTURE_1D:
-            textureMap[assetHashcode] = renderDevice->createTexture1D( ddsData.textureDescription, ddsData.textureData.data(), ddsData.textureData.size() / ddsData.textureDescription.height );
-            break;
-        case TextureDescription::DIMENSION_TEXTURE_2D:
-            textureMap[assetHashcode] = renderDevice->createTexture2D( ddsData.textureDescription, ddsData.textureData.data(), ddsData.textureData.size() / ddsData.textureDescription.height );
-            break;
-        case TextureDescription::DIMENSION_TEXTURE_3D:
-            textureMap[assetHashcode] = renderDevice->createTexture3D( ddsData.textureDescription, ddsData.textureData.data(), ddsData.textureData.size() / ddsData.textureDescription.height );
-            break;
-        }
-    } break;
+        textureData.description = ddsData.textureDescription;
+        textureData.texels.swap( ddsData.textureData );
+        textureData.texelsData = ddsData.texels;
+        textureData.texelsSize = ddsData.texelsSize;
+        textureData.rowPitch = textureData.texelsSize / textureData.description.height;
+    } return true;
 
     case NYA_STRING_HASH( "png16" ):
     case NYA_STRING_HASH( "hmap" ): {
@@ -154,11 +163,11 @@ Texture* GraphicsAssetCache::getTexture( const nyaChar_t* assetName, const bool
         int comp;
         auto* image = stbi_load_16_from_callbacks( &callbacks, file, &w, &h, &comp, STBI_default );
 
-        if ( alreadyExists ) {
-            renderDevice->destroyTexture( textureMap[assetHashcode] );
+        if ( image == nullptr ) {
+            return false;
         }
 
-        TextureDescription desc;
+        TextureDescription desc = {};
         desc.width = w;
         desc.height = h;
         desc.dimension = TextureDescription::DIMENSION_TEXTURE_2D;
@@ -180,10 +189,19 @@ Texture* GraphicsAssetCache::getTexture( const nyaChar_t* assetName, const bool
             break;
         }
 
-        textureMap[assetHashcode] = renderDevice->createTexture2D( desc, image, w * comp );
+        const size_t imageSize = static_cast<size_t>( w ) * h * comp * sizeof( stbi_us );
+
+        textureData.description = desc;
+        textureData.texels.resize( imageSize );
+        textureData.rowPitch = w * comp;
+
+        memcpy( textureData.texels.data(), image, imageSize );
+
+        textureData.texelsData = textureData.texels.data();
+        textureData.texelsSize = imageSize;
 
         stbi_image_free( image );
-    } break;
+    } return true;
     
     case NYA_STRING_HASH( "jpg" ):
     case NYA_STRING_HASH( "jpeg" ):
@@ -203,11 +221,11 @@ Texture* GraphicsAssetCache::getTexture( const nyaChar_t* assetName, const bool
         int comp;
         unsigned char* image = stbi_load_from_callbacks( &callbacks, file, &w, &h, &comp, STBI_default );
 
-        if ( alreadyExists ) {
-            renderDevice->destroyTexture( textureMap[assetHashcode] );
+        if ( image == nullptr ) {
+            return false;
         }
 
-        TextureDescription desc;
+        TextureDescription desc = {};
         desc.width = w;
         desc.height = h;
         desc.dimension = TextureDescription::DIMENSION_TEXTURE_2D;
@@ -229,17 +247,214 @@ Texture* GraphicsAssetCache::getTexture( const nyaChar_t* assetName, const bool
             break;
         }
 
-        textureMap[assetHashcode] = renderDevice->createTexture2D( desc, image, w * comp );
+        const size_t imageSize = static_cast<size_t>( w ) * h * comp;
+
+        textureData.description = desc;
+        textureData.texels.resize( imageSize );
+        textureData.rowPitch = w * comp;
+
+        memcpy( textureData.texels.data(), image, imageSize );
+
+        textureData.texelsData = textureData.texels.data();
+        textureData.texelsSize = imageSize;
 
         stbi_image_free( image );
-    } break;
+    } return true;
 
     default:
-        NYA_CERR << "Unsupported fileformat with extension: " << texFileFormat << std::endl;
+        return false;
+    }
+}
+
+// Called by the streaming workers (should only touch the request)
+static void LoadAsyncRequest( VirtualFileSystem* virtualFileSystem, AsyncLoadRequest* request )
+{
+    const bool useMappedFile = ( request->assetType != AsyncLoadRequest::ASSET_TYPE_MATERIAL );
+
+    auto file = virtualFileSystem->openFile( request->assetName, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY | ( useMappedFile ? eFileOpenMode::FILE_OPEN_MODE_MEMORY_MAPPED : 0 ) );
+    if ( file == nullptr ) {
+        request->state = AsyncLoadRequest::REQUEST_STATE_FAILED;
+        return;
+    }
+
+    bool isLoaded = true;
+    switch ( request->assetType ) {
+    case AsyncLoadRequest::ASSET_TYPE_TEXTURE:
+        isLoaded = LoadTextureData( file, request->assetName, request->textureData );
+        break;
+
+    case AsyncLoadRequest::ASSET_TYPE_MESH:
+        LoadGeometryFile( file, request->meshData );
+        break;
+
+    case AsyncLoadRequest::ASSET_TYPE_MATERIAL:
+        request->materialContent.resize( file->getSize() );
+        file->read( request->materialContent.data(), request->materialContent.size() );
+        break;
+    }
+
+    // Loaded data might point to the file content; the file is closed once the data has been uploaded
+    uint64_t mappedSize = 0ull;
+    if ( isLoaded && file->map( mappedSize ) != nullptr ) {
+        request->mappedFile = file;
+    } else {
+        file->close();
+    }
+
+    request->state = ( isLoaded ) ? AsyncLoadRequest::REQUEST_STATE_LOADED : AsyncLoadRequest::REQUEST_STATE_FAILED;
+}
+
+GraphicsAssetCache::GraphicsAssetCache( BaseAllocator* allocator, RenderDevice* renderDevice, ShaderCache* shaderCache, VirtualFileSystem* virtualFileSystem )
+    : assetStreamingHeap( nya::core::allocate<TLSFAllocator>( allocator, 32 * 1024 * 1024, allocator->allocate( 32 * 1024 * 1024 ) ) )
+    , renderDevice( renderDevice )
+    , shaderCache( shaderCache )
+    , virtualFileSystem( virtualFileSystem )
+    , defaultMaterial( nullptr )
+    , inFlightRequestCount( 0u )
+    , stopStreamingWorkersRequested( false )
+    , recordedDependencies( nullptr )
+    , residencyFrameIndex( 0u )
+    , residentBytes{ 0 }
+    , evictionCount{ 0u }
+    , cacheHitCount( 0ull )
+    , cacheMissCount( 0ull )
+{
+    materialMap.create( assetStreamingHeap, 128u );
+    meshMap.create( assetStreamingHeap, 128u );
+    modelMap.create( assetStreamingHeap );
+    textureMap.create( assetStreamingHeap, 512u );
+    fontMap.create( assetStreamingHeap );
+
+    cachedAssets.create( assetStreamingHeap, 1024u );
+    cachedAssetHashcodes.create( assetStreamingHeap, 1024u );
+
+    defaultMaterial = getMaterial( NYA_STRING( "GameData/materials/DefaultMaterial.mat" ) );
+
+    const uint32_t workerCount = nya::maths::min( AssetStreamingWorkerCount, 8u );
+    for ( uint32_t workerIdx = 0u; workerIdx < workerCount; workerIdx++ ) {
+        streamingWorkers.push_back( std::thread( &GraphicsAssetCache::streamingWorkerLoop, this ) );
+    }
+}
+
+GraphicsAssetCache::~GraphicsAssetCache()
+{
+    stopStreamingWorkers();
+
+    meshMap.clear();
+    materialMap.clear();
+    fontMap.clear();
+    textureMap.clear();
+}
+
+void GraphicsAssetCache::destroy()
+{
+    stopStreamingWorkers();
+
+    // Discard the requests which have not been finalized (placeholder materials share the default material pipeline states)
+    std::vector<AsyncLoadRequest*> discardedRequests;
+    while ( !pendingRequests.empty() ) {
+        discardedRequests.push_back( pendingRequests.front() );
+        pendingRequests.pop();
+    }
+
+    while ( !loadedRequests.empty() ) {
+        discardedRequests.push_back( loadedRequests.front() );
+        loadedRequests.pop();
+    }
+
+    for ( AsyncLoadRequest* request : discardedRequests ) {
+        if ( request->mappedFile != nullptr ) {
+            request->mappedFile->close();
+        }
+
+        if ( request->assetType == AsyncLoadRequest::ASSET_TYPE_MATERIAL ) {
+            materialMap.erase( request->assetHashcode );
+            nya::core::free( assetStreamingHeap, request->material );
+        }
+
+        nya::core::free( assetStreamingHeap, request );
+    }
+
+    inFlightRequestCount = 0u;
+
+    for ( auto& meshes : meshMap ) {
+        // Placeholder meshes have no buffers
+        if ( meshes.second->getVertexBuffer() == nullptr ) {
+            continue;
+        }
+
+        meshes.second->destroy( renderDevice );
+    }
+
+    for ( auto& mat : materialMap ) {
+        mat.second->destroy( renderDevice );
+    }
+
+    for ( auto& texture : textureMap ) {
+        renderDevice->destroyTexture( texture.second );
+    }
+
+    cachedAssets.clear();
+    cachedAssetHashcodes.clear();
+
+    for ( uint32_t assetClass = 0u; assetClass < ASSET_CLASS_COUNT; assetClass++ ) {
+        residentBytes[assetClass] = 0;
+    }
+}
+
+Texture* GraphicsAssetCache::getTexture( const nyaChar_t* assetName, const bool forceReload )
+{
+    auto file = virtualFileSystem->openFile( assetName, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY | eFileOpenMode::FILE_OPEN_MODE_MEMORY_MAPPED );
+    if ( file == nullptr ) {
+        NYA_CERR << "'" << assetName << "' does not exist!" << std::endl;
         return nullptr;
     }
 
+    auto assetHashcode = file->getHashcode();
+    auto mapIterator = textureMap.find( assetHashcode );
+    const bool alreadyExists = ( mapIterator != textureMap.end() );
+
+    if ( alreadyExists && !forceReload ) {
+        file->close();
+
+        acquireAsset( assetHashcode );
+        cacheHitCount++;
+
+        return mapIterator->second;
+    }
+
+    TextureLoadData textureData;
+    const bool isLoaded = LoadTextureData( file, assetName, textureData );
+
+    if ( !isLoaded ) {
+        file->close();
+
+        NYA_CERR << "Failed to load '" << assetName << "' (unsupported or invalid file)" << std::endl;
+        return nullptr;
+    }
+
+    // Texels might point to the file content
+    Texture* texture = createTexture( textureData );
     file->close();
+
+    if ( texture == nullptr ) {
+        NYA_CERR << "Failed to create '" << assetName << "' (unsupported texture dimension)" << std::endl;
+        return ( alreadyExists ) ? mapIterator->second : nullptr;
+    }
+
+    if ( alreadyExists ) {
+        // Replace the texture in place (materials keep a pointer to the texture)
+        renderDevice->swapTexture( mapIterator->second, texture );
+        renderDevice->destroyTexture( texture );
+
+        setAssetSize( assetHashcode, textureData.texelsSize );
+    } else {
+        textureMap[assetHashcode] = texture;
+
+        registerAsset( assetHashcode, ASSET_CLASS_TEXTURE, texture, textureData.texelsSize, !forceReload );
+        cacheMissCount++;
+    }
+
     renderDevice->setDebugMarker( textureMap[assetHashcode], WideStringToString( assetName ).c_str() );
 
     return textureMap[assetHashcode];
@@ -288,6 +503,13 @@ Material* GraphicsAssetCache::getMaterial( const nyaChar_t* assetName, const boo
     auto file = virtualFileSystem->openFile( assetName, eFileOpenMode::FILE_OPEN_MODE_READ );
     if ( file == nullptr ) {
         NYA_CERR << "'" << assetName << "' does not exist!" << std::endl;
+
+        // The caller is expected to release the returned material
+        nyaStringHash_t defaultMaterialHashcode;
+        if ( findAssetHashcode( defaultMaterial, defaultMaterialHashcode ) ) {
+            acquireAsset( defaultMaterialHashcode );
+        }
+
         return defaultMaterial;
     }
 
@@ -296,15 +518,22 @@ Material* GraphicsAssetCache::getMaterial( const nyaChar_t* assetName, const boo
     const bool alreadyExists = ( mapIterator != materialMap.end() );
 
     if ( alreadyExists && !forceReload ) {
+        acquireAsset( assetHashcode );
+        cacheHitCount++;
+
         return mapIterator->second;
     }
 
     if ( !alreadyExists ) {
+        reserveHeapMemory( sizeof( Material ) );
         materialMap[assetHashcode] = nya::core::allocate<Material>( assetStreamingHeap );
+
+        registerAsset( assetHashcode, ASSET_CLASS_MATERIAL, materialMap[assetHashcode], sizeof( Material ), !forceReload );
+        cacheMissCount++;
     }
 
     auto materialInstance = materialMap[assetHashcode];
-    materialInstance->load( file, this );
+    loadMaterial( materialInstance, file, assetHashcode, false );
     materialInstance->create( renderDevice, shaderCache );
 
     file->close();
@@ -314,7 +543,7 @@ Material* GraphicsAssetCache::getMaterial( const nyaChar_t* assetName, const boo
 
 Mesh* GraphicsAssetCache::getMesh( const nyaChar_t* assetName, const bool forceReload )
 {
-    auto file = virtualFileSystem->openFile( assetName, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY );
+    auto file = virtualFileSystem->openFile( assetName, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY | eFileOpenMode::FILE_OPEN_MODE_MEMORY_MAPPED );
     if ( file == nullptr ) {
         NYA_CERR << "'" << assetName << "' does not exist!" << std::endl;
         return nullptr;
@@ -325,11 +554,18 @@ Mesh* GraphicsAssetCache::getMesh( const nyaChar_t* assetName, const bool forceR
     const bool alreadyExists = ( mapIterator != meshMap.end() );
 
     if ( alreadyExists && !forceReload ) {
+        acquireAsset( assetHashcode );
+        cacheHitCount++;
+
         return mapIterator->second;
     }
 
     if ( !alreadyExists ) {
+        reserveHeapMemory( sizeof( Mesh ) );
         meshMap[assetHashcode] = nya::core::allocate<Mesh>( assetStreamingHeap );
+
+        registerAsset( assetHashcode, ASSET_CLASS_MESH, meshMap[assetHashcode], sizeof( Mesh ), !forceReload );
+        cacheMissCount++;
     } else {
         meshMap[assetHashcode]->reset();
     }
@@ -338,14 +574,294 @@ Mesh* GraphicsAssetCache::getMesh( const nyaChar_t* assetName, const bool forceR
     
     GeomLoadData loadData;
     nya::core::LoadGeometryFile( file, loadData );
+
+    // Buffers might point to the file content
+    createMesh( meshInstance, assetHashcode, assetName, loadData );
+    file->close();
+
+    setAssetSize( assetHashcode, sizeof( Mesh ) + loadData.vertexBufferSize + loadData.indiceBufferSize );
+
+    return meshInstance;
+}
+
+Texture* GraphicsAssetCache::getTextureAsync( const nyaChar_t* assetName )
+{
+    auto file = virtualFileSystem->openFile( assetName, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY );
+    if ( file == nullptr ) {
+        NYA_CERR << "'" << assetName << "' does not exist!" << std::endl;
+        return nullptr;
+    }
+
+    auto assetHashcode = file->getHashcode();
+    file->close();
+
+    auto mapIterator = textureMap.find( assetHashcode );
+    if ( mapIterator != textureMap.end() ) {
+        acquireAsset( assetHashcode );
+        cacheHitCount++;
+
+        return mapIterator->second;
+    }
+
+    // Placeholder: 1x1 mid grey texture
+    static constexpr uint8_t PLACEHOLDER_TEXEL[4] = { 0x80, 0x80, 0x80, 0xFF };
+
+    TextureDescription placeholderDesc = {};
+    placeholderDesc.dimension = TextureDescription::DIMENSION_TEXTURE_2D;
+    placeholderDesc.format = eImageFormat::IMAGE_FORMAT_R8G8B8A8_UNORM;
+    placeholderDesc.width = 1;
+    placeholderDesc.height = 1;
+    placeholderDesc.depth = 0;
+    placeholderDesc.arraySize = 1;
+    placeholderDesc.mipCount = 1;
+    placeholderDesc.samplerCount = 1;
+
+    Texture* texture = renderDevice->createTexture2D( placeholderDesc, PLACEHOLDER_TEXEL, sizeof( PLACEHOLDER_TEXEL ) );
+    textureMap[assetHashcode] = texture;
+
+    registerAsset( assetHashcode, ASSET_CLASS_TEXTURE, texture, sizeof( PLACEHOLDER_TEXEL ), true );
+    cachedAssets[assetHashcode].isStreaming = true;
+    cacheMissCount++;
+
+    reserveHeapMemory( sizeof( AsyncLoadRequest ) );
+    AsyncLoadRequest* request = nya::core::allocate<AsyncLoadRequest>( assetStreamingHeap );
+    request->assetType = AsyncLoadRequest::ASSET_TYPE_TEXTURE;
+    request->assetName = assetName;
+    request->assetHashcode = assetHashcode;
+    request->texture = texture;
+
+    pushAsyncLoadRequest( request );
+
+    return texture;
+}
+
+Material* GraphicsAssetCache::getMaterialAsync( const nyaChar_t* assetName )
+{
+    auto file = virtualFileSystem->openFile( assetName, eFileOpenMode::FILE_OPEN_MODE_READ );
+    if ( file == nullptr ) {
+        NYA_CERR << "'" << assetName << "' does not exist!" << std::endl;
+
+        nyaStringHash_t defaultMaterialHashcode;
+        if ( findAssetHashcode( defaultMaterial, defaultMaterialHashcode ) ) {
+            acquireAsset( defaultMaterialHashcode );
+        }
+
+        return defaultMaterial;
+    }
+
+    auto assetHashcode = file->getHashcode();
+    file->close();
+
+    auto mapIterator = materialMap.find( assetHashcode );
+    if ( mapIterator != materialMap.end() ) {
+        acquireAsset( assetHashcode );
+        cacheHitCount++;
+
+        return mapIterator->second;
+    }
+
+    reserveHeapMemory( sizeof( Material ) + sizeof( AsyncLoadRequest ) );
+
+    // Placeholder: copy of the default material (pipeline states are shared until the material is loaded)
+    Material* material = nya::core::allocate<Material>( assetStreamingHeap, *defaultMaterial );
+    materialMap[assetHashcode] = material;
+
+    registerAsset( assetHashcode, ASSET_CLASS_MATERIAL, material, sizeof( Material ), true );
+    cachedAssets[assetHashcode].isStreaming = true;
+    cacheMissCount++;
+
+    AsyncLoadRequest* request = nya::core::allocate<AsyncLoadRequest>( assetStreamingHeap );
+    request->assetType = AsyncLoadRequest::ASSET_TYPE_MATERIAL;
+    request->assetName = assetName;
+    request->assetHashcode = assetHashcode;
+    request->material = material;
+
+    pushAsyncLoadRequest( request );
+
+    return material;
+}
+
+Mesh* GraphicsAssetCache::getMeshAsync( const nyaChar_t* assetName )
+{
+    auto file = virtualFileSystem->openFile( assetName, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY );
+    if ( file == nullptr ) {
+        NYA_CERR << "'" << assetName << "' does not exist!" << std::endl;
+        return nullptr;
+    }
+
+    auto assetHashcode = file->getHashcode();
     file->close();
 
+    auto mapIterator = meshMap.find( assetHashcode );
+    if ( mapIterator != meshMap.end() ) {
+        acquireAsset( assetHashcode );
+        cacheHitCount++;
+
+        return mapIterator->second;
+    }
+
+    reserveHeapMemory( sizeof( Mesh ) + sizeof( AsyncLoadRequest ) );
+
+    // Placeholder: single LOD without submesh (nothing is drawn until the mesh is loaded)
+    Mesh* mesh = nya::core::allocate<Mesh>( assetStreamingHeap );
+    mesh->reset();
+    mesh->setName( assetName );
+    mesh->addLevelOfDetail( 0, LOD_DISTANCE[0] );
+
+    meshMap[assetHashcode] = mesh;
+
+    registerAsset( assetHashcode, ASSET_CLASS_MESH, mesh, sizeof( Mesh ), true );
+    cachedAssets[assetHashcode].isStreaming = true;
+    cacheMissCount++;
+
+    AsyncLoadRequest* request = nya::core::allocate<AsyncLoadRequest>( assetStreamingHeap );
+    request->assetType = AsyncLoadRequest::ASSET_TYPE_MESH;
+    request->assetName = assetName;
+    request->assetHashcode = assetHashcode;
+    request->mesh = mesh;
+
+    pushAsyncLoadRequest( request );
+
+    return mesh;
+}
+
+uint32_t GraphicsAssetCache::finalizeAsyncLoads()
+{
+    NYA_PROFILE_FUNCTION
+
+    Timer finalizationTimer;
+    nya::core::StartTimer( &finalizationTimer );
+
+    const double finalizationBudget = static_cast<double>( AssetStreamingBudget );
+    const bool hasStreamingWorkers = !streamingWorkers.empty();
+
+    uint32_t finalizedRequestCount = 0u;
+    while ( inFlightRequestCount > 0u ) {
+        AsyncLoadRequest* request = nullptr;
+        {
+            std::lock_guard<std::mutex> lock( asyncRequestsLock );
+            if ( !loadedRequests.empty() ) {
+                request = loadedRequests.front();
+                loadedRequests.pop();
+            } else if ( !hasStreamingWorkers && !pendingRequests.empty() ) {
+                request = pendingRequests.front();
+                pendingRequests.pop();
+            }
+        }
+
+        if ( request == nullptr ) {
+            break;
+        }
+
+        // Without workers, requests are loaded by the finalizing thread (and count against the budget)
+        if ( request->state == AsyncLoadRequest::REQUEST_STATE_PENDING ) {
+            LoadAsyncRequest( virtualFileSystem, request );
+        }
+
+        finalizeAsyncLoadRequest( request );
+        finalizedRequestCount++;
+
+        if ( nya::core::GetTimerElapsedTimeAsMiliseconds( &finalizationTimer ) >= finalizationBudget ) {
+            break;
+        }
+    }
+
+    NYA_PROFILE_STAT( "Asset Streaming Requests In Flight", inFlightRequestCount )
+
+    return finalizedRequestCount;
+}
+
+uint32_t GraphicsAssetCache::getPendingAsyncLoadCount() const
+{
+    return inFlightRequestCount;
+}
+
+void GraphicsAssetCache::releaseTexture( Texture* texture )
+{
+    nyaStringHash_t assetHashcode;
+    if ( findAssetHashcode( texture, assetHashcode ) ) {
+        releaseAsset( assetHashcode );
+    }
+}
+
+void GraphicsAssetCache::releaseMaterial( Material* material )
+{
+    nyaStringHash_t assetHashcode;
+    if ( findAssetHashcode( material, assetHashcode ) ) {
+        releaseAsset( assetHashcode );
+    }
+}
+
+void GraphicsAssetCache::releaseMesh( Mesh* mesh )
+{
+    nyaStringHash_t assetHashcode;
+    if ( findAssetHashcode( mesh, assetHashcode ) ) {
+        releaseAsset( assetHashcode );
+    }
+}
+
+void GraphicsAssetCache::updateResidency()
+{
+    NYA_PROFILE_FUNCTION
+
+    residencyFrameIndex++;
+
+    const size_t assetBudgets[ASSET_CLASS_COUNT] = {
+        static_cast<size_t>( AssetTextureBudget ) * 1024 * 1024,
+        static_cast<size_t>( AssetMeshBudget ) * 1024 * 1024,
+        static_cast<size_t>( AssetMaterialBudget ) * 1024 * 1024,
+    };
+
+    // Materials are evicted first (evicted materials release their textures)
+    static constexpr eAssetClass EVICTION_ORDER[ASSET_CLASS_COUNT] = { ASSET_CLASS_MATERIAL, ASSET_CLASS_MESH, ASSET_CLASS_TEXTURE };
+
+    for ( const eAssetClass assetClass : EVICTION_ORDER ) {
+        const size_t assetBudget = assetBudgets[assetClass];
+
+        if ( residentBytes[assetClass] > assetBudget ) {
+            evictAssets( assetClass, [&]() { return residentBytes[assetClass] <= assetBudget; } );
+        }
+    }
+
+    constexpr double BYTES_TO_MB = 1.0 / ( 1024.0 * 1024.0 );
+    const uint64_t requestCount = ( cacheHitCount + cacheMissCount );
+
+    NYA_PROFILE_STAT( "Asset Cache Resident Textures (MB)", residentBytes[ASSET_CLASS_TEXTURE] * BYTES_TO_MB )
+    NYA_PROFILE_STAT( "Asset Cache Resident Meshes (MB)", residentBytes[ASSET_CLASS_MESH] * BYTES_TO_MB )
+    NYA_PROFILE_STAT( "Asset Cache Resident Materials (MB)", residentBytes[ASSET_CLASS_MATERIAL] * BYTES_TO_MB )
+    NYA_PROFILE_STAT( "Asset Cache Evicted Textures", evictionCount[ASSET_CLASS_TEXTURE] )
+    NYA_PROFILE_STAT( "Asset Cache Evicted Meshes", evictionCount[ASSET_CLASS_MESH] )
+    NYA_PROFILE_STAT( "Asset Cache Evicted Materials", evictionCount[ASSET_CLASS_MATERIAL] )
+    NYA_PROFILE_STAT( "Asset Cache Hit Rate (%)", ( requestCount > 0ull ) ? ( 100.0 * cacheHitCount / requestCount ) : 100.0 )
+    NYA_PROFILE_STAT( "Asset Streaming Heap Usage (MB)", assetStreamingHeap->getMemoryUsage() * BYTES_TO_MB )
+    NYA_PROFILE_STAT( "Asset Streaming Heap Largest Free Block (MB)", assetStreamingHeap->getLargestFreeBlockSize() * BYTES_TO_MB )
+    NYA_PROFILE_STAT( "Asset Streaming Heap Fragmentation (%)", assetStreamingHeap->getFragmentation() * 100.0f )
+}
+
+Texture* GraphicsAssetCache::createTexture( const TextureLoadData& textureData )
+{
+    const TextureDescription& description = textureData.description;
+
+    switch ( description.dimension ) {
+    case TextureDescription::DIMENSION_TEXTURE_1D:
+        return renderDevice->createTexture1D( description, textureData.texelsData, textureData.rowPitch );
+    case TextureDescription::DIMENSION_TEXTURE_2D:
+        return renderDevice->createTexture2D( description, textureData.texelsData, textureData.rowPitch );
+    case TextureDescription::DIMENSION_TEXTURE_3D:
+        return renderDevice->createTexture3D( description, textureData.texelsData, textureData.rowPitch );
+    default:
+        return nullptr;
+    }
+}
+
+void GraphicsAssetCache::createMesh( Mesh* meshInstance, const nyaStringHash_t hashcode, const nyaChar_t* assetName, const GeomLoadData& loadData )
+{
     meshInstance->setName( assetName );
 
     // Allocate VertexBuffer
     BufferDesc vertexBufferDesc;
     vertexBufferDesc.type = BufferDesc::VERTEX_BUFFER;
-    vertexBufferDesc.size = loadData.vertices.size() * sizeof( float );
+    vertexBufferDesc.size = loadData.vertexBufferSize;
 
     // Compute vertex stride (sum component count per vertex)
     uint32_t vertexBufferStride = 0;
@@ -358,18 +874,20 @@ Mesh* GraphicsAssetCache::getMesh( const nyaChar_t* assetName, const bool forceR
     // Allocate IndiceBuffer
     BufferDesc indiceBufferDesc;
     indiceBufferDesc.type = BufferDesc::INDICE_BUFFER;
-    indiceBufferDesc.size = loadData.indices.size() * sizeof( uint32_t );
-    indiceBufferDesc.stride = sizeof( uint32_t );
+    indiceBufferDesc.size = loadData.indiceBufferSize;
+    indiceBufferDesc.stride = loadData.indiceStride;
 
-    meshInstance->create( renderDevice, vertexBufferDesc, indiceBufferDesc, loadData.vertices.data(), loadData.indices.data() );
+    meshInstance->create( renderDevice, vertexBufferDesc, indiceBufferDesc, loadData.vertexBuffer, loadData.indiceBuffer );
     
-    // TODO Custom Distance Definition (define per model LoD distance?)
-    constexpr float LOD_DISTANCE[4] = { 250.0f, 500.0f, 1000.0f, 2048.0f };
     for ( int i = 0; i < 1; i++ )
         meshInstance->addLevelOfDetail( i, LOD_DISTANCE[i] );
 
-    // Build each LevelOfDetail
-    for ( GeomLoadData::SubMesh& subMesh : loadData.subMesh ) {
+    nyaStringHash_t defaultMaterialHashcode;
+    const bool isDefaultMaterialCached = findAssetHashcode( defaultMaterial, defaultMaterialHashcode );
+
+    // Build each LevelOfDetail (each submesh keeps a reference on its material)
+    std::vector<nyaStringHash_t> meshDependencies;
+    for ( const GeomLoadData::SubMesh& subMesh : loadData.subMesh ) {
         meshInstance->addSubMesh( subMesh.levelOfDetailIndex, {
             defaultMaterial,
             subMesh.indiceBufferOffset, 
@@ -377,9 +895,354 @@ Mesh* GraphicsAssetCache::getMesh( const nyaChar_t* assetName, const bool forceR
             subMesh.boundingSphere,
             subMesh.aabb
         } );
+
+        if ( isDefaultMaterialCached ) {
+            acquireAsset( defaultMaterialHashcode );
+            meshDependencies.push_back( defaultMaterialHashcode );
+        }
     }
 
-    return meshInstance;
+    // Release the materials referenced by the previous version of the mesh (reload)
+    setAssetDependencies( hashcode, meshDependencies );
+}
+
+void GraphicsAssetCache::pushAsyncLoadRequest( AsyncLoadRequest* request )
+{
+    request->state = AsyncLoadRequest::REQUEST_STATE_PENDING;
+    request->mappedFile = nullptr;
+    inFlightRequestCount++;
+
+    {
+        std::lock_guard<std::mutex> lock( asyncRequestsLock );
+        pendingRequests.push( request );
+    }
+
+    asyncRequestPushedEvent.notify_one();
+}
+
+void GraphicsAssetCache::finalizeAsyncLoadRequest( AsyncLoadRequest* request )
+{
+    const bool isLoaded = ( request->state == AsyncLoadRequest::REQUEST_STATE_LOADED );
+
+    if ( !isLoaded ) {
+        NYA_CERR << "Failed to load '" << request->assetName << "' (the placeholder is kept)" << std::endl;
+    }
+
+    switch ( request->assetType ) {
+    case AsyncLoadRequest::ASSET_TYPE_TEXTURE: {
+        Texture* texture = ( isLoaded ) ? createTexture( request->textureData ) : nullptr;
+
+        if ( texture != nullptr ) {
+            // The temporary texture receives the placeholder resources
+            renderDevice->swapTexture( request->texture, texture );
+            renderDevice->destroyTexture( texture );
+
+            renderDevice->setDebugMarker( request->texture, WideStringToString( request->assetName ).c_str() );
+
+            setAssetSize( request->assetHashcode, request->textureData.texelsSize );
+        }
+    } break;
+
+    case AsyncLoadRequest::ASSET_TYPE_MESH: {
+        if ( isLoaded ) {
+            const GeomLoadData& meshData = request->meshData;
+
+            request->mesh->reset();
+            createMesh( request->mesh, request->assetHashcode, request->assetName.c_str(), meshData );
+
+            setAssetSize( request->assetHashcode, sizeof( Mesh ) + meshData.vertexBufferSize + meshData.indiceBufferSize );
+        }
+    } break;
+
+    case AsyncLoadRequest::ASSET_TYPE_MATERIAL: {
+        if ( isLoaded ) {
+            FileSystemObjectMemory materialStream( request->assetName, std::move( request->materialContent ) );
+
+            Material loadedMaterial;
+            loadMaterial( &loadedMaterial, &materialStream, request->assetHashcode, true );
+            loadedMaterial.create( renderDevice, shaderCache );
+
+            *request->material = loadedMaterial;
+        } else {
+            // The placeholder should own its pipeline states
+            request->material->create( renderDevice, shaderCache );
+        }
+    } break;
+    }
+
+    if ( request->mappedFile != nullptr ) {
+        request->mappedFile->close();
+    }
+
+    auto cachedAsset = cachedAssets.find( request->assetHashcode );
+    if ( cachedAsset != cachedAssets.end() ) {
+        cachedAsset->second.isStreaming = false;
+    }
+
+    nya::core::free( assetStreamingHeap, request );
+    inFlightRequestCount--;
+}
+
+void GraphicsAssetCache::streamingWorkerLoop()
+{
+    while ( true ) {
+        AsyncLoadRequest* request = nullptr;
+        {
+            std::unique_lock<std::mutex> lock( asyncRequestsLock );
+            asyncRequestPushedEvent.wait( lock, [&]() { return stopStreamingWorkersRequested || !pendingRequests.empty(); } );
+
+            if ( stopStreamingWorkersRequested ) {
+                return;
+            }
+
+            request = pendingRequests.front();
+            pendingRequests.pop();
+        }
+
+        LoadAsyncRequest( virtualFileSystem, request );
+
+        {
+            std::lock_guard<std::mutex> lock( asyncRequestsLock );
+            loadedRequests.push( request );
+        }
+    }
+}
+
+void GraphicsAssetCache::stopStreamingWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock( asyncRequestsLock );
+        stopStreamingWorkersRequested = true;
+    }
+
+    asyncRequestPushedEvent.notify_all();
+
+    for ( std::thread& worker : streamingWorkers ) {
+        worker.join();
+    }
+
+    streamingWorkers.clear();
+}
+
+void GraphicsAssetCache::registerAsset( const nyaStringHash_t hashcode, const eAssetClass assetClass, const void* asset, const size_t sizeInBytes, const bool acquireReference )
+{
+    CachedAsset& cachedAsset = cachedAssets[hashcode];
+    cachedAsset.assetClass = assetClass;
+    cachedAsset.asset = asset;
+    cachedAsset.sizeInBytes = sizeInBytes;
+    cachedAsset.referenceCount = 0u;
+    cachedAsset.lastUsedFrame = residencyFrameIndex;
+    cachedAsset.isStreaming = false;
+
+    // Textures are null with the null renderer (they can't be released)
+    if ( asset != nullptr ) {
+        cachedAssetHashcodes[asset] = hashcode;
+    }
+
+    residentBytes[assetClass] += sizeInBytes;
+
+    if ( acquireReference ) {
+        acquireAsset( hashcode );
+    }
+}
+
+void GraphicsAssetCache::acquireAsset( const nyaStringHash_t hashcode )
+{
+    auto cachedAsset = cachedAssets.find( hashcode );
+    if ( cachedAsset == cachedAssets.end() ) {
+        return;
+    }
+
+    cachedAsset->second.referenceCount++;
+    cachedAsset->second.lastUsedFrame = residencyFrameIndex;
+
+    if ( recordedDependencies != nullptr && cachedAsset->second.assetClass == ASSET_CLASS_TEXTURE ) {
+        recordedDependencies->push_back( hashcode );
+    }
+}
+
+void GraphicsAssetCache::releaseAsset( const nyaStringHash_t hashcode )
+{
+    auto cachedAsset = cachedAssets.find( hashcode );
+    if ( cachedAsset == cachedAssets.end() ) {
+        return;
+    }
+
+    NYA_DEV_ASSERT( cachedAsset->second.referenceCount > 0u, "Asset 0x%X has been released more times than it has been acquired", hashcode );
+
+    if ( cachedAsset->second.referenceCount > 0u ) {
+        cachedAsset->second.referenceCount--;
+    }
+
+    cachedAsset->second.lastUsedFrame = residencyFrameIndex;
+}
+
+bool GraphicsAssetCache::findAssetHashcode( const void* asset, nyaStringHash_t& hashcode ) const
+{
+    if ( asset == nullptr ) {
+        return false;
+    }
+
+    auto assetHashcode = cachedAssetHashcodes.find( asset );
+    if ( assetHashcode == cachedAssetHashcodes.end() ) {
+        return false;
+    }
+
+    hashcode = assetHashcode->second;
+    return true;
+}
+
+void GraphicsAssetCache::setAssetSize( const nyaStringHash_t hashcode, const size_t sizeInBytes )
+{
+    auto cachedAsset = cachedAssets.find( hashcode );
+    if ( cachedAsset == cachedAssets.end() ) {
+        return;
+    }
+
+    residentBytes[cachedAsset->second.assetClass] -= cachedAsset->second.sizeInBytes;
+    residentBytes[cachedAsset->second.assetClass] += sizeInBytes;
+
+    cachedAsset->second.sizeInBytes = sizeInBytes;
+}
+
+void GraphicsAssetCache::loadMaterial( Material* material, FileSystemObject* stream, const nyaStringHash_t hashcode, const bool useAsyncTextureLoading )
+{
+    std::vector<nyaStringHash_t> materialDependencies;
+
+    std::vector<nyaStringHash_t>* previousRecordedDependencies = recordedDependencies;
+    recordedDependencies = &materialDependencies;
+
+    material->load( stream, this, useAsyncTextureLoading );
+
+    recordedDependencies = previousRecordedDependencies;
+
+    // Release the textures referenced by the previous version of the material (after the new ones have been acquired)
+    setAssetDependencies( hashcode, materialDependencies );
+}
+
+void GraphicsAssetCache::setAssetDependencies( const nyaStringHash_t hashcode, std::vector<nyaStringHash_t>& dependencies )
+{
+    auto cachedAsset = cachedAssets.find( hashcode );
+    if ( cachedAsset == cachedAssets.end() ) {
+        // The asset is not tracked; drop the references acquired for it
+        for ( const nyaStringHash_t dependency : dependencies ) {
+            releaseAsset( dependency );
+        }
+
+        dependencies.clear();
+        return;
+    }
+
+    cachedAsset->second.dependencies.swap( dependencies );
+
+    for ( const nyaStringHash_t dependency : dependencies ) {
+        releaseAsset( dependency );
+    }
+}
+
+void GraphicsAssetCache::evictAssets( const eAssetClass assetClass, const std::function<bool()>& isEvictionDone )
+{
+    // (last used frame, hashcode)
+    std::vector<std::pair<uint32_t, nyaStringHash_t>> evictionCandidates;
+
+    for ( const auto& cachedAsset : cachedAssets ) {
+        const CachedAsset& asset = cachedAsset.second;
+
+        if ( asset.assetClass != assetClass
+          || asset.referenceCount > 0u
+          || asset.isStreaming
+          || ( residencyFrameIndex - asset.lastUsedFrame ) < EVICTION_FRAME_DELAY ) {
+            continue;
+        }
+
+        evictionCandidates.push_back( std::make_pair( asset.lastUsedFrame, cachedAsset.first ) );
+    }
+
+    std::sort( evictionCandidates.begin(), evictionCandidates.end() );
+
+    for ( const auto& evictionCandidate : evictionCandidates ) {
+        if ( isEvictionDone() ) {
+            break;
+        }
+
+        evictAsset( evictionCandidate.second );
+    }
+}
+
+void GraphicsAssetCache::evictAsset( const nyaStringHash_t hashcode )
+{
+    auto cachedAsset = cachedAssets.find( hashcode );
+    if ( cachedAsset == cachedAssets.end() ) {
+        return;
+    }
+
+    const eAssetClass assetClass = cachedAsset->second.assetClass;
+
+    switch ( assetClass ) {
+    case ASSET_CLASS_TEXTURE: {
+        auto texture = textureMap.find( hashcode );
+        renderDevice->destroyTexture( texture->second );
+        textureMap.erase( texture );
+    } break;
+
+    case ASSET_CLASS_MESH: {
+        auto mesh = meshMap.find( hashcode );
+
+        // Placeholder meshes have no buffers
+        if ( mesh->second->getVertexBuffer() != nullptr ) {
+            mesh->second->destroy( renderDevice );
+        }
+
+        nya::core::free( assetStreamingHeap, mesh->second );
+        meshMap.erase( mesh );
+    } break;
+
+    case ASSET_CLASS_MATERIAL: {
+        auto material = materialMap.find( hashcode );
+        material->second->destroy( renderDevice );
+
+        nya::core::free( assetStreamingHeap, material->second );
+        materialMap.erase( material );
+    } break;
+
+    default:
+        break;
+    }
+
+    std::vector<nyaStringHash_t> dependencies;
+    dependencies.swap( cachedAsset->second.dependencies );
+
+    residentBytes[assetClass] -= cachedAsset->second.sizeInBytes;
+    evictionCount[assetClass]++;
+
+    if ( cachedAsset->second.asset != nullptr ) {
+        cachedAssetHashcodes.erase( cachedAsset->second.asset );
+    }
+
+    cachedAssets.erase( cachedAsset );
+
+    for ( const nyaStringHash_t dependency : dependencies ) {
+        releaseAsset( dependency );
+    }
+}
+
+void GraphicsAssetCache::reserveHeapMemory( const size_t allocationSize )
+{
+    auto hasEnoughMemory = [&]() {
+        return ( assetStreamingHeap->getMemoryUsage() + allocationSize + HEAP_RESERVE_MARGIN ) <= assetStreamingHeap->getSize();
+    };
+
+    if ( hasEnoughMemory() ) {
+        return;
+    }
+
+    // Textures are not allocated from the streaming heap
+    evictAssets( ASSET_CLASS_MATERIAL, hasEnoughMemory );
+    evictAssets( ASSET_CLASS_MESH, hasEnoughMemory );
+
+    if ( !hasEnoughMemory() ) {
+        NYA_CWARN << "Asset streaming heap is full (" << assetStreamingHeap->getMemoryUsage() << " bytes used; every cached mesh and material is referenced)" << std::endl;
+    }
 }
 
 //
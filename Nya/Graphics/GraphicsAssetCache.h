@@ -23,6 +23,7 @@
 class RenderDevice;
 class ShaderCache;
 class VirtualFileSystem;
+class FileSystemObject;
 
 class Material;
 class Mesh;
@@ -32,10 +33,24 @@ struct FontDescriptor;
 struct Model;
 
 class BaseAllocator;
-class FreeListAllocator;
+class TLSFAllocator;
 
-#include <map>
+struct GeomLoadData;
+struct TextureLoadData;
+struct AsyncLoadRequest;
 
+#include <Core/Containers/HashMap.h>
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Cached textures, meshes and materials are reference counted: each get call acquires a reference (except reloads), which should be
+// released once the asset is no longer used. Unreferenced assets stay resident until their class exceeds its memory budget; they are
+// then evicted (least recently used first)
 class GraphicsAssetCache
 {
 /*
@@ -60,25 +75,119 @@ public:
 
     Texture*        getTexture( const nyaChar_t* assetName, const bool forceReload = false );
     FontDescriptor* getFont( const nyaChar_t* assetName, const bool forceReload = false );
-    Material*       getMaterialCopy( const nyaChar_t* assetName );
+    Material*       getMaterialCopy( const nyaChar_t* assetName ); // The copy keeps a reference on the cached material (textures are shared)
     Material*       getMaterial( const nyaChar_t* assetName, const bool forceReload = false );
     Mesh*           getMesh( const nyaChar_t* assetName, const bool forceReload = false );
     //Model*          getModel( const nyaChar_t* assetName, const bool forceReload = false );
 
+    // Asynchronous requests return immediately (nullptr if the asset does not exist). The returned asset is a placeholder until the request is
+    // finalized; the address stays the same once loaded (the loaded content replaces the placeholder in place)
+    // Placeholders: 1x1 texture; mesh with a single empty LOD (nothing is drawn); copy of the default material
+    // File I/O and decoding are done by worker threads; GPU resources are created by finalizeAsyncLoads
+    // NOTE Requests and finalization should be done on the same thread (the one using the assets; e.g. the render thread)
+    Texture*        getTextureAsync( const nyaChar_t* assetName );
+    Material*       getMaterialAsync( const nyaChar_t* assetName );
+    Mesh*           getMeshAsync( const nyaChar_t* assetName );
+
+    // Create the resources of the loaded requests until the per-frame budget is exhausted (at least one request is finalized per call)
+    // Should be called once per frame; returns the number of finalized requests
+    uint32_t        finalizeAsyncLoads();
+
+    uint32_t        getPendingAsyncLoadCount() const;
+
+    // Release a reference acquired by a get call (the asset is not destroyed until it is evicted)
+    void            releaseTexture( Texture* texture );
+    void            releaseMaterial( Material* material );
+    void            releaseMesh( Mesh* mesh );
+
+    // Evict unreferenced assets until each asset class fits in its budget; should be called once per frame
+    // NOTE Assets released during the last frames are not evicted (frames in flight might still use them)
+    void            updateResidency();
+
     // WARNING (for now) you are responsible of releasing the memory (which is a bad thing)
     //void            getImageTexels( const nyaChar_t* assetName, GraphicsAssetCache::RawTexels& texels );
     
 private:
-    FreeListAllocator*      assetStreamingHeap;
+    enum eAssetClass {
+        ASSET_CLASS_TEXTURE = 0,
+        ASSET_CLASS_MESH,
+        ASSET_CLASS_MATERIAL,
+
+        ASSET_CLASS_COUNT
+    };
+
+    struct CachedAsset {
+        eAssetClass                     assetClass;
+        const void*                     asset;
+        size_t                          sizeInBytes;
+        uint32_t                        referenceCount;
+        uint32_t                        lastUsedFrame;
+        bool                            isStreaming; // Async request in flight (can't be evicted)
+
+        // Textures referenced by a material
+        std::vector<nyaStringHash_t>    dependencies;
+    };
+
+private:
+    Texture*        createTexture( const TextureLoadData& textureData );
+    // Submesh materials are recorded as dependencies of the mesh (the previous dependencies are released)
+    void            createMesh( Mesh* meshInstance, const nyaStringHash_t hashcode, const nyaChar_t* assetName, const GeomLoadData& loadData );
+
+    void            pushAsyncLoadRequest( AsyncLoadRequest* request );
+    void            finalizeAsyncLoadRequest( AsyncLoadRequest* request );
+
+    void            streamingWorkerLoop();
+    void            stopStreamingWorkers();
+
+    void            registerAsset( const nyaStringHash_t hashcode, const eAssetClass assetClass, const void* asset, const size_t sizeInBytes, const bool acquireReference );
+    void            acquireAsset( const nyaStringHash_t hashcode );
+    void            releaseAsset( const nyaStringHash_t hashcode );
+    bool            findAssetHashcode( const void* asset, nyaStringHash_t& hashcode ) const;
+    void            setAssetSize( const nyaStringHash_t hashcode, const size_t sizeInBytes );
+
+    // Replace the dependencies of an asset; the previous dependencies are released (dependencies is swapped with them)
+    void            setAssetDependencies( const nyaStringHash_t hashcode, std::vector<nyaStringHash_t>& dependencies );
+
+    // Textures acquired during the load are recorded as dependencies of the material (the previous dependencies are released)
+    void            loadMaterial( Material* material, FileSystemObject* stream, const nyaStringHash_t hashcode, const bool useAsyncTextureLoading );
+
+    // Evict unreferenced assets of a class (least recently used first) until isEvictionDone returns true
+    void            evictAssets( const eAssetClass assetClass, const std::function<bool()>& isEvictionDone );
+    void            evictAsset( const nyaStringHash_t hashcode );
+
+    // Evict meshes and materials until the streaming heap can hold a new allocation
+    void            reserveHeapMemory( const size_t allocationSize );
+
+private:
+    TLSFAllocator*          assetStreamingHeap;
     RenderDevice*           renderDevice;
     ShaderCache*            shaderCache;
     VirtualFileSystem*      virtualFileSystem;
 
-    std::map<nyaStringHash_t, Material*>           materialMap;
-    std::map<nyaStringHash_t, Mesh*>               meshMap;
-    std::map<nyaStringHash_t, Model*>              modelMap;
-    std::map<nyaStringHash_t, Texture*>            textureMap;
-    std::map<nyaStringHash_t, FontDescriptor*>     fontMap;
+    HashMap<nyaStringHash_t, Material*>            materialMap;
+    HashMap<nyaStringHash_t, Mesh*>                meshMap;
+    HashMap<nyaStringHash_t, Model*>               modelMap;
+    HashMap<nyaStringHash_t, Texture*>             textureMap;
+    HashMap<nyaStringHash_t, FontDescriptor*>      fontMap;
 
     Material*   defaultMaterial;
+
+    // Asynchronous loading
+    std::vector<std::thread>        streamingWorkers;
+    std::mutex                      asyncRequestsLock;
+    std::condition_variable         asyncRequestPushedEvent;
+    std::queue<AsyncLoadRequest*>   pendingRequests; // Waiting for a worker
+    std::queue<AsyncLoadRequest*>   loadedRequests; // Waiting for finalization
+    uint32_t                        inFlightRequestCount; // Requested but not finalized yet (only used by the owner thread)
+    bool                            stopStreamingWorkersRequested;
+
+    // Residency
+    HashMap<nyaStringHash_t, CachedAsset>          cachedAssets;
+    HashMap<const void*, nyaStringHash_t>          cachedAssetHashcodes; // Lookup for release calls
+    std::vector<nyaStringHash_t>*                   recordedDependencies; // Textures acquired while a material is loaded
+    uint32_t                                        residencyFrameIndex;
+    size_t                                          residentBytes[ASSET_CLASS_COUNT];
+    uint32_t                                        evictionCount[ASSET_CLASS_COUNT];
+    uint64_t                                        cacheHitCount;
+    uint64_t                                        cacheMissCount;
 };
@@ -25,19 +25,23 @@
 #include <Rendering/RenderDevice.h>
 #include <Rendering/CommandList.h>
 
+#include <stdio.h>
+
 GraphicsProfiler::GraphicsProfiler()
-    : frameIndex( 0 )
-    , timestampQueryPool( nullptr )
+    : timestampQueryPool( nullptr )
+    , recordedFrameCount( 0ull )
+    , activeFrame( nullptr )
+    , activeSection( nullptr )
     , sectionSummaryString( "" )
-    , sectionsResult{ -1.0 }
-    , sectionsBeginQueryHandle{ 0 }
-    , sectionsEndQueryHandle{ 0 }
-    , sectionsName{ "" }
-    , sectionCount( 0 )
-    , sectionReadIndex( 0 )
-    , sectionWriteIndex( 0 )
+    , lastFrameResult{ 0ull, 0u, -1.0 }
+    , hasLastFrameResult( false )
 {
-
+    for ( RecordedFrame& frame : recordedFrames ) {
+        frame.FrameIndex = 0ull;
+        frame.ViewKey = 0u;
+        frame.SectionCount = 0u;
+        frame.QueryCount = 0u;
+    }
 }
 
 GraphicsProfiler::~GraphicsProfiler()
@@ -48,10 +52,6 @@ GraphicsProfiler::~GraphicsProfiler()
 void GraphicsProfiler::create( RenderDevice* renderDevice )
 {
     timestampQueryPool = renderDevice->createQueryPool( eQueryType::QUERY_TYPE_TIMESTAMP, TOTAL_QUERY_COUNT );
-
-    std::fill_n( sectionsResult, TOTAL_QUERY_COUNT, -1.0 );
-    std::fill_n( sectionsBeginQueryHandle, TOTAL_QUERY_COUNT, ~0 );
-    std::fill_n( sectionsEndQueryHandle, TOTAL_QUERY_COUNT, ~0 );
 }
 
 void GraphicsProfiler::destroy( RenderDevice* renderDevice )
@@ -59,98 +59,133 @@ void GraphicsProfiler::destroy( RenderDevice* renderDevice )
     renderDevice->destroyQueryPool( timestampQueryPool );
 }
 
-void GraphicsProfiler::onFrame( RenderDevice* renderDevice )
+void GraphicsProfiler::onFrame( RenderDevice* renderDevice, const uint64_t frameIndex, const nyaStringHash_t viewKey )
 {
     NYA_PROFILE_FUNCTION
 
-    frameIndex++;
+    RecordedFrame& frame = recordedFrames[recordedFrameCount % RESULT_RETRIVAL_FRAME_LAG];
 
-    if ( ( frameIndex - RESULT_RETRIVAL_FRAME_LAG ) >= 0 ) {
-        auto retrievedQueryCount = getSectionsResult( renderDevice );
+    // The slot about to be reused holds the oldest recorded frame
+    hasLastFrameResult = ( recordedFrameCount >= RESULT_RETRIVAL_FRAME_LAG ) && retrieveFrameResult( renderDevice, frame );
 
-        // Move on the next frame if at least one result is available
-        if ( retrievedQueryCount > 0 ) {
-            // Build profiler summary string
-            sectionSummaryString.clear();
+    frame.FrameIndex = frameIndex;
+    frame.ViewKey = viewKey;
+    frame.SectionCount = 0u;
+    frame.QueryCount = 0u;
 
-            for ( unsigned int sectionIdx = sectionReadIndex; sectionIdx < ( sectionReadIndex + retrievedQueryCount ); sectionIdx++ ) {
-                sectionSummaryString.append( sectionsName[sectionIdx] );
-                sectionSummaryString.append( "  " );
-                sectionSummaryString.append( std::to_string( sectionsResult[sectionIdx] ) + "ms\n" );
-            }
-        }
+    activeFrame = &frame;
+    recordedFrameCount++;
+}
 
-        sectionReadIndex = ( sectionReadIndex + MAX_PROFILE_SECTION_COUNT ) % TOTAL_QUERY_COUNT;
+void GraphicsProfiler::beginSection( const std::string& sectionName )
+{
+    if ( activeFrame == nullptr || activeFrame->SectionCount >= MAX_PROFILE_SECTION_COUNT ) {
+        return;
     }
 
-    sectionWriteIndex = ( sectionWriteIndex + MAX_PROFILE_SECTION_COUNT ) % TOTAL_QUERY_COUNT;
-    sectionCount = 0;
+    activeSection = &activeFrame->Sections[activeFrame->SectionCount++];
+    activeSection->Name = sectionName;
+    activeSection->BeginQueryHandle = INVALID_QUERY_HANDLE;
+    activeSection->EndQueryHandle = INVALID_QUERY_HANDLE;
+
+    nya::rendering::SetCommandListListener( this );
 }
 
-void GraphicsProfiler::beginSection( CommandList* cmdList, const std::string& sectionName )
+void GraphicsProfiler::endSection()
 {
-    const auto sectionIdx = ( sectionWriteIndex + sectionCount );
-    sectionsResult[sectionIdx] = -1.0;
-    sectionsBeginQueryHandle[sectionIdx] = cmdList->allocateQuery( timestampQueryPool );
-    sectionsEndQueryHandle[sectionIdx] = cmdList->allocateQuery( timestampQueryPool );
-    sectionsName[sectionIdx] = sectionName;
+    nya::rendering::SetCommandListListener( nullptr );
+
+    activeSection = nullptr;
+}
 
-    sectionCount++;
+void GraphicsProfiler::onCommandListBegin( CommandList* cmdList )
+{
+    // The section starts with the first command list recorded
+    if ( activeSection == nullptr
+      || activeSection->BeginQueryHandle != INVALID_QUERY_HANDLE
+      || activeFrame->QueryCount >= MAX_QUERY_COUNT_PER_FRAME ) {
+        return;
+    }
 
-    // Write start timestamp
-    cmdList->writeTimestamp( timestampQueryPool, sectionsBeginQueryHandle[sectionIdx] );
+    activeSection->BeginQueryHandle = cmdList->allocateQuery( timestampQueryPool );
+    cmdList->writeTimestamp( timestampQueryPool, activeSection->BeginQueryHandle );
 
-    recordedSectionIndexes.push( sectionIdx );
+    activeFrame->QueryCount++;
 }
 
-void GraphicsProfiler::endSection( CommandList* cmdList )
+void GraphicsProfiler::onCommandListEnd( CommandList* cmdList )
 {
-    if ( recordedSectionIndexes.empty() ) {
+    // The section ends with the last command list recorded (command lists are executed in submission order)
+    if ( activeSection == nullptr
+      || activeSection->BeginQueryHandle == INVALID_QUERY_HANDLE
+      || activeFrame->QueryCount >= MAX_QUERY_COUNT_PER_FRAME ) {
         return;
     }
 
-    auto latestSectionIdx = recordedSectionIndexes.back();
-    cmdList->writeTimestamp( timestampQueryPool, sectionsEndQueryHandle[latestSectionIdx] );
+    activeSection->EndQueryHandle = cmdList->allocateQuery( timestampQueryPool );
+    cmdList->writeTimestamp( timestampQueryPool, activeSection->EndQueryHandle );
 
-    recordedSectionIndexes.pop();
+    activeFrame->QueryCount++;
 }
 
-std::size_t GraphicsProfiler::getSectionsResult( RenderDevice* renderDevice )
+bool GraphicsProfiler::retrieveFrameResult( RenderDevice* renderDevice, const RecordedFrame& frame )
 {
-    for ( std::size_t sectionIdx = 0; sectionIdx < sectionCount; sectionIdx++ ) {
-        const std::size_t sectionArrayIdx = ( sectionReadIndex + sectionIdx );
+    double sectionsResult[MAX_PROFILE_SECTION_COUNT];
+    double frameTime = 0.0;
 
-        uint64_t beginQueryResult = 0, endQueryResult = 0;
+    for ( uint32_t sectionIdx = 0; sectionIdx < frame.SectionCount; sectionIdx++ ) {
+        const Section& section = frame.Sections[sectionIdx];
 
-        auto beginQueryHandle = sectionsBeginQueryHandle[sectionArrayIdx];
-        auto endQueryHandle = sectionsEndQueryHandle[sectionArrayIdx];
+        // Sections which haven't recorded any command list don't cost anything on the GPU
+        if ( section.BeginQueryHandle == INVALID_QUERY_HANDLE || section.EndQueryHandle == INVALID_QUERY_HANDLE ) {
+            sectionsResult[sectionIdx] = 0.0;
+            continue;
+        }
 
-        // Check if the current handle is valid and available
-        // If not, stop the retrival here
-        if ( beginQueryHandle > TOTAL_QUERY_COUNT
-          || endQueryHandle > TOTAL_QUERY_COUNT
-          || !renderDevice->getQueryResult( timestampQueryPool, beginQueryHandle, beginQueryResult )
-          || !renderDevice->getQueryResult( timestampQueryPool, endQueryHandle, endQueryResult ) ) {
-            return sectionIdx;
+        // If a result is not available yet, the whole frame is discarded
+        uint64_t beginQueryResult = 0, endQueryResult = 0;
+        if ( !renderDevice->getQueryResult( timestampQueryPool, section.BeginQueryHandle, beginQueryResult )
+          || !renderDevice->getQueryResult( timestampQueryPool, section.EndQueryHandle, endQueryResult ) ) {
+            return false;
         }
 
-        uint64_t elapsedTicks = ( endQueryResult - beginQueryResult );
+        const uint64_t elapsedTicks = ( endQueryResult - beginQueryResult );
 
-        double elapsedMs = renderDevice->convertTimestampToMs( timestampQueryPool, static_cast<double>( elapsedTicks ) );
+        sectionsResult[sectionIdx] = renderDevice->convertTimestampToMs( timestampQueryPool, static_cast<double>( elapsedTicks ) );
+        frameTime += sectionsResult[sectionIdx];
+    }
 
-        sectionsResult[sectionArrayIdx] = elapsedMs;
+    // Build profiler summary string
+    char frameInfos[128];
+    snprintf( frameInfos, sizeof( frameInfos ), "View 0x%08X (Frame %llu)  %fms\n", frame.ViewKey, static_cast<unsigned long long>( frame.FrameIndex ), frameTime );
+
+    sectionSummaryString.assign( frameInfos );
+
+    for ( uint32_t sectionIdx = 0; sectionIdx < frame.SectionCount; sectionIdx++ ) {
+        sectionSummaryString.append( frame.Sections[sectionIdx].Name );
+        sectionSummaryString.append( "  " );
+        sectionSummaryString.append( std::to_string( sectionsResult[sectionIdx] ) + "ms\n" );
     }
 
-    return sectionCount;
-}
+    lastFrameResult.FrameIndex = frame.FrameIndex;
+    lastFrameResult.ViewKey = frame.ViewKey;
+    lastFrameResult.GPUTime = frameTime;
 
-const double* GraphicsProfiler::getSectionResultArray() const
-{
-    return sectionsResult;
+    return true;
 }
 
 const std::string& GraphicsProfiler::getProfilingSummaryString() const
 {
     return sectionSummaryString;
 }
+
+bool GraphicsProfiler::getLastFrameResult( FrameResult& result ) const
+{
+    if ( !hasLastFrameResult ) {
+        return false;
+    }
+
+    result = lastFrameResult;
+    return true;
+}
 #endif
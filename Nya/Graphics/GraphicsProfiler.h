@@ -23,12 +23,23 @@
 struct QueryPool;
 
 class RenderDevice;
-class CommandList;
 
-#include <queue>
+#include <Rendering/CommandList.h>
+#include <string>
 
-class GraphicsProfiler
+// Times the sections of a render pipeline on the GPU
+// Timestamps are written in the command lists recorded between beginSection and endSection (no extra command list
+// is submitted). Results are retrieved a few executions later and tagged with the frame and view they were recorded for
+class GraphicsProfiler : public CommandListListener
 {
+public:
+    struct FrameResult
+    {
+        uint64_t                    FrameIndex;
+        nyaStringHash_t             ViewKey;
+        double                      GPUTime; // Sum of the sections (in ms)
+    };
+
 public:
                                     GraphicsProfiler();
                                     GraphicsProfiler( GraphicsProfiler& ) = delete;
@@ -37,37 +48,61 @@ public:
 
     void                            create( RenderDevice* renderDevice );
     void                            destroy( RenderDevice* renderDevice );
-    void                            onFrame( RenderDevice* renderDevice );
 
-    void                            beginSection( CommandList* cmdList, const std::string& sectionName );
-    void                            endSection( CommandList* cmdList );
+    // Start the recording of a new frame (the results of the oldest recorded frame are retrieved first)
+    void                            onFrame( RenderDevice* renderDevice, const uint64_t frameIndex, const nyaStringHash_t viewKey );
+
+    // Sections have to be opened and closed on the thread recording the command lists
+    void                            beginSection( const std::string& sectionName );
+    void                            endSection();
+
+    void                            onCommandListBegin( CommandList* cmdList ) override;
+    void                            onCommandListEnd( CommandList* cmdList ) override;
 
-    const double*                   getSectionResultArray() const;
     const std::string&              getProfilingSummaryString() const;
 
+    // Return false if no result has been retrieved during the latest onFrame call
+    bool                            getLastFrameResult( FrameResult& result ) const;
+
 private:
     static constexpr int            RESULT_RETRIVAL_FRAME_LAG = 5;
     static constexpr int            MAX_PROFILE_SECTION_COUNT = 128;
-    static constexpr int            TOTAL_QUERY_COUNT = MAX_PROFILE_SECTION_COUNT * RESULT_RETRIVAL_FRAME_LAG;
 
-private:
-    int64_t                         frameIndex;
+    // A section uses two queries (plus one per extra command list recorded by the section)
+    static constexpr int            MAX_QUERY_COUNT_PER_FRAME = MAX_PROFILE_SECTION_COUNT * 4;
+    static constexpr int            TOTAL_QUERY_COUNT = MAX_QUERY_COUNT_PER_FRAME * RESULT_RETRIVAL_FRAME_LAG;
 
-    QueryPool*                      timestampQueryPool;
-    std::queue<uint32_t>            recordedSectionIndexes;
+    static constexpr uint32_t       INVALID_QUERY_HANDLE = ~0u;
 
-    std::string                     sectionSummaryString;
+    struct Section
+    {
+        std::string                 Name;
+        uint32_t                    BeginQueryHandle;
+        uint32_t                    EndQueryHandle;
+    };
+
+    struct RecordedFrame
+    {
+        uint64_t                    FrameIndex;
+        nyaStringHash_t             ViewKey;
+        uint32_t                    SectionCount;
+        uint32_t                    QueryCount;
+        Section                     Sections[MAX_PROFILE_SECTION_COUNT];
+    };
+
+private:
+    QueryPool*                      timestampQueryPool;
 
-    double                          sectionsResult[TOTAL_QUERY_COUNT];
-    uint32_t                        sectionsBeginQueryHandle[TOTAL_QUERY_COUNT];
-    uint32_t                        sectionsEndQueryHandle[TOTAL_QUERY_COUNT];
-    std::string                     sectionsName[TOTAL_QUERY_COUNT];
+    RecordedFrame                   recordedFrames[RESULT_RETRIVAL_FRAME_LAG];
+    uint64_t                        recordedFrameCount;
+    RecordedFrame*                  activeFrame;
+    Section*                        activeSection;
 
-    unsigned int                    sectionCount;
-    unsigned int                    sectionReadIndex;
-    unsigned int                    sectionWriteIndex;
+    std::string                     sectionSummaryString;
+    FrameResult                     lastFrameResult;
+    bool                            hasLastFrameResult;
 
 private:
-    std::size_t                     getSectionsResult( RenderDevice* renderDevice );
+    bool                            retrieveFrameResult( RenderDevice* renderDevice, const RecordedFrame& frame );
 };
 #endif
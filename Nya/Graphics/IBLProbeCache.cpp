@@ -0,0 +1,274 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "IBLProbeCache.h"
+
+#include "LightGrid.h"
+#include "RenderModules/ProbeCaptureModule.h"
+
+#include <Framework/Light.h>
+
+#include <FileSystem/VirtualFileSystem.h>
+#include <FileSystem/FileSystemObject.h>
+
+#include <Io/DirectDrawSurface.h>
+
+#include <Rendering/RenderDevice.h>
+#include <Rendering/ImageFormat.h>
+
+#include <Core/EnvVarsRegister.h>
+#include <Core/Hashing/MurmurHash3.h>
+
+#include <Shaders/Shared.h>
+
+#include <cmath>
+#include <string.h>
+
+NYA_ENV_VAR( IBLProbeCacheComputeIrradianceSH, false, bool ) // "Project the irradiance of the IBL probes restored from the cache to SH9 (CPU; replaces the diffuse cubemap)"
+
+// Probe positions are quantized before being hashed (in world units)
+static constexpr float PROBE_POSITION_QUANTIZATION = 0.01f;
+
+namespace
+{
+    float DecodePackedFloat( const uint32_t value, const uint32_t mantissaBitCount )
+    {
+        const uint32_t mantissa = value & ( ( 1u << mantissaBitCount ) - 1u );
+        const uint32_t exponent = value >> mantissaBitCount;
+        const float mantissaScale = 1.0f / static_cast<float>( 1u << mantissaBitCount );
+
+        if ( exponent == 0u ) {
+            return std::ldexp( static_cast<float>( mantissa ) * mantissaScale, -14 );
+        } else if ( exponent == 31u ) {
+            return 0.0f; // Inf/NaN
+        }
+
+        return std::ldexp( 1.0f + static_cast<float>( mantissa ) * mantissaScale, static_cast<int>( exponent ) - 15 );
+    }
+
+    void DecodeR11G11B10Float( const uint32_t* texels, const size_t texelCount, float* decodedTexels )
+    {
+        for ( size_t texelIdx = 0; texelIdx < texelCount; texelIdx++ ) {
+            const uint32_t packedValue = texels[texelIdx];
+
+            float* decodedTexel = decodedTexels + texelIdx * 4;
+            decodedTexel[0] = DecodePackedFloat( packedValue & 0x7FF, 6 );
+            decodedTexel[1] = DecodePackedFloat( ( packedValue >> 11 ) & 0x7FF, 6 );
+            decodedTexel[2] = DecodePackedFloat( ( packedValue >> 22 ) & 0x3FF, 5 );
+            decodedTexel[3] = 1.0f;
+        }
+    }
+}
+
+IBLProbeCache::IBLProbeCache( RenderDevice* renderDevice, VirtualFileSystem* virtualFileSystem )
+    : renderDevice( renderDevice )
+    , virtualFileSystem( virtualFileSystem )
+    , sceneHash( 0 )
+    , isCacheEnabled( true )
+{
+    diffuseTexels.resize( ProbeCaptureModule::GetConvolutedProbeSize() );
+    specularTexels.resize( ProbeCaptureModule::GetConvolutedProbeSize() );
+}
+
+IBLProbeCache::~IBLProbeCache()
+{
+    renderDevice = nullptr;
+    virtualFileSystem = nullptr;
+    sceneHash = 0;
+    isCacheEnabled = false;
+
+    pendingWrites.clear();
+    queuedWrites.clear();
+}
+
+void IBLProbeCache::setSceneHash( const uint32_t contentHash )
+{
+    sceneHash = contentHash;
+}
+
+bool IBLProbeCache::restoreProbe( ProbeCaptureModule* probeCaptureModule, LightGrid* lightGrid, const IBLProbeData* probeData )
+{
+    if ( !isCacheEnabled ) {
+        return false;
+    }
+
+    if ( !loadEntry( getEntryFilename( probeData, NYA_STRING( "_Diffuse.dds" ) ), diffuseTexels )
+      || !loadEntry( getEntryFilename( probeData, NYA_STRING( "_Specular.dds" ) ), specularTexels ) ) {
+        return false;
+    }
+
+    if ( !probeCaptureModule->uploadConvolutedProbe( renderDevice, probeData->ProbeIndex, diffuseTexels.data(), specularTexels.data() ) ) {
+        NYA_CERR << "Failed to upload IBL probe " << probeData->ProbeIndex << " from the cache" << std::endl;
+        disable();
+        return false;
+    }
+
+    if ( IBLProbeCacheComputeIrradianceSH ) {
+        // Specular mip 0 is not convoluted (radiance); faces are stored with their whole mip chain
+        const size_t faceTexelCount = IBL_PROBE_DIMENSION * IBL_PROBE_DIMENSION;
+        const size_t faceSize = ProbeCaptureModule::GetConvolutedProbeSize() / 6;
+
+        std::vector<float> radianceTexels( faceTexelCount * 4 * 6 );
+        const float* faceTexels[6];
+
+        for ( uint32_t faceIdx = 0; faceIdx < 6; faceIdx++ ) {
+            float* decodedFace = radianceTexels.data() + faceIdx * faceTexelCount * 4;
+            DecodeR11G11B10Float( reinterpret_cast<const uint32_t*>( specularTexels.data() + faceIdx * faceSize ), faceTexelCount, decodedFace );
+
+            faceTexels[faceIdx] = decodedFace;
+        }
+
+        lightGrid->setIBLProbeIrradianceFromCubemap( probeData->ProbeIndex, faceTexels, IBL_PROBE_DIMENSION );
+    }
+
+    return true;
+}
+
+void IBLProbeCache::queueProbeWrite( const IBLProbeData* probeData )
+{
+    if ( !isCacheEnabled ) {
+        return;
+    }
+
+    queuedWrites.push_back( probeData );
+}
+
+uint32_t IBLProbeCache::flushPendingWrites( ProbeCaptureModule* probeCaptureModule )
+{
+    uint32_t writtenProbeCount = 0;
+
+    for ( const IBLProbeData* probeData : pendingWrites ) {
+        if ( !probeCaptureModule->readConvolutedProbe( renderDevice, probeData->ProbeIndex, diffuseTexels.data(), specularTexels.data() ) ) {
+            NYA_CERR << "Failed to read back IBL probe " << probeData->ProbeIndex << std::endl;
+            disable();
+            return writtenProbeCount;
+        }
+
+        if ( writeEntry( getEntryFilename( probeData, NYA_STRING( "_Diffuse.dds" ) ), diffuseTexels )
+          && writeEntry( getEntryFilename( probeData, NYA_STRING( "_Specular.dds" ) ), specularTexels ) ) {
+            writtenProbeCount++;
+        }
+    }
+
+    // Probes queued during this frame will be written during the next flush
+    pendingWrites.swap( queuedWrites );
+    queuedWrites.clear();
+
+    return writtenProbeCount;
+}
+
+bool IBLProbeCache::hasPendingWrites() const
+{
+    return !pendingWrites.empty() || !queuedWrites.empty();
+}
+
+bool IBLProbeCache::isEnabled() const
+{
+    return isCacheEnabled;
+}
+
+nyaString_t IBLProbeCache::getEntryFilename( const IBLProbeData* probeData, const nyaChar_t* entrySuffix ) const
+{
+    const int32_t quantizedPosition[3] = {
+        static_cast<int32_t>( std::floor( probeData->worldPosition.x / PROBE_POSITION_QUANTIZATION + 0.5f ) ),
+        static_cast<int32_t>( std::floor( probeData->worldPosition.y / PROBE_POSITION_QUANTIZATION + 0.5f ) ),
+        static_cast<int32_t>( std::floor( probeData->worldPosition.z / PROBE_POSITION_QUANTIZATION + 0.5f ) ),
+    };
+
+    // Fallback probes discard their position; use the array index instead
+    uint32_t positionKey = 0;
+    if ( probeData->isFallbackProbe ) {
+        positionKey = probeData->ProbeIndex;
+    } else {
+        MurmurHash3_x86_32( quantizedPosition, sizeof( quantizedPosition ), 0, &positionKey );
+    }
+
+    return NYA_STRING( "GameData/IBLProbe_" ) + NYA_TO_STRING( sceneHash ) + NYA_STRING( "_" ) + ( probeData->isFallbackProbe ? NYA_STRING( "Global" ) : NYA_STRING( "" ) ) + NYA_TO_STRING( positionKey ) + entrySuffix;
+}
+
+bool IBLProbeCache::loadEntry( const nyaString_t& filename, std::vector<uint8_t>& texels ) const
+{
+    FileSystemObject* file = virtualFileSystem->openFile( filename, nya::core::eFileOpenMode::FILE_OPEN_MODE_READ | nya::core::eFileOpenMode::FILE_OPEN_MODE_BINARY | nya::core::eFileOpenMode::FILE_OPEN_MODE_MEMORY_MAPPED );
+    if ( file == nullptr ) {
+        return false;
+    }
+
+    DirectDrawSurface ddsData;
+    nya::core::LoadDirectDrawSurface( file, ddsData );
+
+    const TextureDescription& desc = ddsData.textureDescription;
+    const bool isValidEntry = ( desc.format == eImageFormat::IMAGE_FORMAT_R11G11B10_FLOAT
+                             && desc.width == IBL_PROBE_DIMENSION
+                             && desc.height == IBL_PROBE_DIMENSION
+                             && desc.arraySize == 6
+                             && desc.mipCount == ProbeCaptureModule::CONVOLUTED_PROBE_MIP_COUNT
+                             && ddsData.texelsSize == texels.size() );
+
+    if ( !isValidEntry ) {
+        file->close();
+
+        NYA_CWARN << "'" << filename << "': invalid IBL probe cache entry (the probe will be captured)" << std::endl;
+        return false;
+    }
+
+    // Texels might point to the mapped file; copy them before closing the file
+    memcpy( texels.data(), ddsData.texels, ddsData.texelsSize );
+    file->close();
+
+    return true;
+}
+
+bool IBLProbeCache::writeEntry( const nyaString_t& filename, std::vector<uint8_t>& texels ) const
+{
+    FileSystemObject* file = virtualFileSystem->openFile( filename, nya::core::eFileOpenMode::FILE_OPEN_MODE_WRITE | nya::core::eFileOpenMode::FILE_OPEN_MODE_BINARY | nya::core::eFileOpenMode::FILE_OPEN_MODE_TRUNCATE );
+    if ( file == nullptr ) {
+        NYA_CERR << "'" << filename << "': failed to open IBL probe cache entry for writing" << std::endl;
+        return false;
+    }
+
+    DirectDrawSurface ddsData;
+    ddsData.textureDescription.dimension = TextureDescription::DIMENSION_TEXTURE_2D;
+    ddsData.textureDescription.width = IBL_PROBE_DIMENSION;
+    ddsData.textureDescription.height = IBL_PROBE_DIMENSION;
+    ddsData.textureDescription.depth = 1;
+    ddsData.textureDescription.arraySize = 6;
+    ddsData.textureDescription.mipCount = ProbeCaptureModule::CONVOLUTED_PROBE_MIP_COUNT;
+    ddsData.textureDescription.format = eImageFormat::IMAGE_FORMAT_R11G11B10_FLOAT;
+    ddsData.textureDescription.flags.isCubeMap = 1;
+
+    // Borrow the staging memory (avoids a copy of the texels)
+    ddsData.textureData.swap( texels );
+    nya::core::SaveDirectDrawSurface( file, ddsData );
+    ddsData.textureData.swap( texels );
+
+    file->close();
+
+    return true;
+}
+
+void IBLProbeCache::disable()
+{
+    NYA_CWARN << "Render target copies are not supported by the render backend; the IBL probe cache is disabled (probes will be captured at runtime)" << std::endl;
+
+    isCacheEnabled = false;
+
+    pendingWrites.clear();
+    queuedWrites.clear();
+}
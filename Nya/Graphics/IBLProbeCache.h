@@ -0,0 +1,74 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+class RenderDevice;
+class VirtualFileSystem;
+class ProbeCaptureModule;
+class LightGrid;
+
+struct IBLProbeData;
+
+#include <vector>
+
+// On-disk cache of convoluted IBL probes (diffuse/specular mip chains are stored as DDS cubemaps)
+// Entries are keyed by the probe position and a hash of the scene content: entries baked from a different scene
+// state are never found, and the probe falls back to a live capture
+class IBLProbeCache
+{
+public:
+                                        IBLProbeCache( RenderDevice* renderDevice, VirtualFileSystem* virtualFileSystem );
+                                        IBLProbeCache( IBLProbeCache& ) = delete;
+                                        IBLProbeCache& operator = ( IBLProbeCache& ) = delete;
+                                        ~IBLProbeCache();
+
+    void                                setSceneHash( const uint32_t contentHash );
+
+    // Upload the cached convoluted faces of a probe; returns false if the cache entry is missing (or stale)
+    bool                                restoreProbe( ProbeCaptureModule* probeCaptureModule, LightGrid* lightGrid, const IBLProbeData* probeData );
+
+    // Queue the write of a probe entry
+    // Writes are deferred to the next flushPendingWrites call (the GPU has to execute the probe convolution first)
+    void                                queueProbeWrite( const IBLProbeData* probeData );
+    uint32_t                            flushPendingWrites( ProbeCaptureModule* probeCaptureModule );
+    bool                                hasPendingWrites() const;
+
+    // False once a probe copy has failed (render target copies are not supported by every render backend)
+    bool                                isEnabled() const;
+
+private:
+    RenderDevice*                       renderDevice;
+    VirtualFileSystem*                  virtualFileSystem;
+    uint32_t                            sceneHash;
+    bool                                isCacheEnabled;
+
+    std::vector<const IBLProbeData*>    pendingWrites;
+    std::vector<const IBLProbeData*>    queuedWrites;
+
+    // Staging memory (convoluted faces of a single probe)
+    std::vector<uint8_t>                diffuseTexels;
+    std::vector<uint8_t>                specularTexels;
+
+private:
+    nyaString_t                         getEntryFilename( const IBLProbeData* probeData, const nyaChar_t* entrySuffix ) const;
+    bool                                loadEntry( const nyaString_t& filename, std::vector<uint8_t>& texels ) const;
+    bool                                writeEntry( const nyaString_t& filename, std::vector<uint8_t>& texels ) const;
+    void                                disable();
+};
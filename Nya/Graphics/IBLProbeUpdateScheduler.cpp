@@ -0,0 +1,314 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "IBLProbeUpdateScheduler.h"
+
+#include <Framework/Light.h>
+
+#include <Core/EnvVarsRegister.h>
+
+#include <Maths/Helpers.h>
+
+NYA_ENV_VAR( IBLProbeUpdateBudget, 2.0f, float ) // "Per-frame time budget for IBL probe capture and convolution (in ms)"
+
+// Default GPU cost estimates (in ms); used until GPU timings are available (GPU timings are only retrieved in dev builds)
+static constexpr double DEFAULT_CAPTURE_COST = 1.0;
+static constexpr double DEFAULT_CONVOLUTION_COST = 0.5;
+
+// Priority weights
+static constexpr float AGE_WEIGHT = 0.05f;
+static constexpr float DISTANCE_WEIGHT = 0.1f;
+static constexpr float DIRTY_WEIGHT = 4.0f;
+static constexpr float IN_PROGRESS_WEIGHT = 8.0f;
+
+// Exponential moving average weight for measured costs
+static constexpr double COST_SMOOTHING = 0.1;
+
+namespace
+{
+    // Relative cost of a convolution step (proportional to the mip pixel count)
+    double GetConvolutionWeight( const uint16_t mipIndex )
+    {
+        return nya::maths::max( 1.0 / static_cast<double>( 1u << ( mipIndex * 2u ) ), 1.0 / 64.0 );
+    }
+}
+
+IBLProbeUpdateScheduler::IBLProbeUpdateScheduler()
+    : measuredCaptureCPUCost( 0.0 )
+    , measuredConvolutionCPUCost( 0.0 )
+    , measuredCaptureGPUCost( 0.0 )
+    , measuredConvolutionGPUCost( 0.0 )
+    , lastCaptureCount( 0u )
+    , lastConvolutionWeight( 0.0 )
+{
+    for ( ProbeUpdateState& state : probeStates ) {
+        state.Probe = nullptr;
+        state.AgeInFrames = 0u;
+        state.NextStep = 0u;
+        state.IsPending = 0;
+        state.IsDirty = 0;
+    }
+
+    for ( RecordedFrame& frame : recordedFrames ) {
+        frame.FrameIndex = ~0ull;
+        frame.ConvolutionWeight = 0.0;
+    }
+}
+
+IBLProbeUpdateScheduler::~IBLProbeUpdateScheduler()
+{
+    measuredCaptureCPUCost = 0.0;
+    measuredConvolutionCPUCost = 0.0;
+    measuredCaptureGPUCost = 0.0;
+    measuredConvolutionGPUCost = 0.0;
+    lastCaptureCount = 0u;
+    lastConvolutionWeight = 0.0;
+}
+
+void IBLProbeUpdateScheduler::requestUpdate( const IBLProbeData* probeData, const bool isDirty )
+{
+    NYA_DEV_ASSERT( probeData->ProbeIndex < MAX_IBL_PROBE_COUNT, "Probe index out of bounds (%u >= %u)", probeData->ProbeIndex, MAX_IBL_PROBE_COUNT );
+
+    ProbeUpdateState& state = probeStates[probeData->ProbeIndex];
+    state.Probe = probeData;
+    state.NextStep = 0u;
+    state.IsPending = 1;
+    state.IsDirty = ( state.IsDirty || isDirty ) ? 1 : 0;
+}
+
+void IBLProbeUpdateScheduler::cancelUpdate( const IBLProbeData* probeData )
+{
+    ProbeUpdateState& state = probeStates[probeData->ProbeIndex];
+    state.Probe = nullptr;
+    state.AgeInFrames = 0u;
+    state.NextStep = 0u;
+    state.IsPending = 0;
+    state.IsDirty = 0;
+}
+
+uint32_t IBLProbeUpdateScheduler::scheduleUpdates( const nyaVec3f& viewerWorldPosition, IBLProbeUpdateCommand* commands, const uint32_t maxCaptureCount, const uint32_t maxCommandCount )
+{
+    lastCaptureCount = 0u;
+    lastConvolutionWeight = 0.0;
+
+    // Sort pending probes by descending priority (insertion sort; the probe count is small)
+    uint32_t sortedProbes[MAX_IBL_PROBE_COUNT];
+    float probePriorities[MAX_IBL_PROBE_COUNT];
+    uint32_t pendingProbeCount = 0u;
+
+    for ( uint32_t probeIdx = 0u; probeIdx < MAX_IBL_PROBE_COUNT; probeIdx++ ) {
+        ProbeUpdateState& state = probeStates[probeIdx];
+
+        if ( !state.IsPending ) {
+            continue;
+        }
+
+        state.AgeInFrames++;
+
+        const float priority = computePriority( state, viewerWorldPosition );
+
+        uint32_t insertionIdx = pendingProbeCount;
+        while ( insertionIdx > 0u && probePriorities[insertionIdx - 1u] < priority ) {
+            sortedProbes[insertionIdx] = sortedProbes[insertionIdx - 1u];
+            probePriorities[insertionIdx] = probePriorities[insertionIdx - 1u];
+            insertionIdx--;
+        }
+
+        sortedProbes[insertionIdx] = probeIdx;
+        probePriorities[insertionIdx] = priority;
+        pendingProbeCount++;
+    }
+
+    // Captures need to be executed before convolutions (a convolution samples every face of the probe)
+    IBLProbeUpdateCommand convolutionCommands[MAX_IBL_PROBE_COUNT * STEP_COUNT];
+    uint32_t captureCount = 0u, convolutionCount = 0u;
+
+    const double frameBudget = static_cast<double>( IBLProbeUpdateBudget );
+    double frameCost = 0.0;
+
+    for ( uint32_t sortedIdx = 0u; sortedIdx < pendingProbeCount; sortedIdx++ ) {
+        ProbeUpdateState& state = probeStates[sortedProbes[sortedIdx]];
+
+        while ( state.NextStep < STEP_COUNT && ( captureCount + convolutionCount ) < maxCommandCount ) {
+            const bool isConvolution = ( state.NextStep >= CAPTURE_STEP_COUNT );
+            if ( !isConvolution && captureCount >= maxCaptureCount ) {
+                break;
+            }
+
+            const double stepCost = getStepCost( state.NextStep );
+
+            // Always issue at least one command per frame to guarantee progress
+            if ( ( captureCount + convolutionCount ) != 0u && ( frameCost + stepCost ) > frameBudget ) {
+                break;
+            }
+
+            IBLProbeUpdateCommand* command = ( isConvolution ) ? &convolutionCommands[convolutionCount++] : &commands[captureCount++];
+            command->Probe = state.Probe;
+            command->IsConvolution = isConvolution;
+
+            if ( isConvolution ) {
+                const uint16_t convolutionStep = static_cast<uint16_t>( state.NextStep - CAPTURE_STEP_COUNT );
+                command->Step = static_cast<eProbeCaptureStep>( convolutionStep / CONVOLUTION_MIP_COUNT );
+                command->MipIndex = static_cast<uint16_t>( convolutionStep % CONVOLUTION_MIP_COUNT );
+
+                lastConvolutionWeight += GetConvolutionWeight( command->MipIndex );
+            } else {
+                command->Step = static_cast<eProbeCaptureStep>( state.NextStep );
+                command->MipIndex = 0u;
+            }
+
+            frameCost += stepCost;
+            state.NextStep++;
+        }
+
+        if ( state.NextStep >= STEP_COUNT ) {
+            state.Probe = nullptr;
+            state.AgeInFrames = 0u;
+            state.NextStep = 0u;
+            state.IsPending = 0;
+            state.IsDirty = 0;
+        }
+    }
+
+    for ( uint32_t convolutionIdx = 0u; convolutionIdx < convolutionCount; convolutionIdx++ ) {
+        commands[captureCount + convolutionIdx] = convolutionCommands[convolutionIdx];
+    }
+
+    lastCaptureCount = captureCount;
+
+    NYA_PROFILE_STAT( "IBL Probes Pending", getPendingProbeCount() )
+    NYA_PROFILE_STAT( "IBL Probe Commands Pending", getPendingCommandCount() )
+    NYA_PROFILE_STAT( "IBL Probe Commands Issued", captureCount + convolutionCount )
+    NYA_PROFILE_STAT( "IBL Probe Estimated Cost (ms)", frameCost )
+
+    return captureCount + convolutionCount;
+}
+
+void IBLProbeUpdateScheduler::onCommandsRecorded( const uint64_t frameIndex, const double captureTimeInMs, const double convolutionTimeInMs )
+{
+    if ( lastCaptureCount != 0u ) {
+        const double captureCost = captureTimeInMs / static_cast<double>( lastCaptureCount );
+        measuredCaptureCPUCost = ( measuredCaptureCPUCost == 0.0 ) ? captureCost : nya::maths::lerp( measuredCaptureCPUCost, captureCost, COST_SMOOTHING );
+    }
+
+    if ( lastConvolutionWeight > 0.0 ) {
+        const double convolutionCost = convolutionTimeInMs / lastConvolutionWeight;
+        measuredConvolutionCPUCost = ( measuredConvolutionCPUCost == 0.0 ) ? convolutionCost : nya::maths::lerp( measuredConvolutionCPUCost, convolutionCost, COST_SMOOTHING );
+
+        RecordedFrame& frame = recordedFrames[frameIndex % RECORDED_FRAME_HISTORY];
+        frame.FrameIndex = frameIndex;
+        frame.ConvolutionWeight = lastConvolutionWeight;
+    }
+}
+
+void IBLProbeUpdateScheduler::onCaptureGPUTimeRetrieved( const double gpuTimeInMs )
+{
+    measuredCaptureGPUCost = ( measuredCaptureGPUCost == 0.0 ) ? gpuTimeInMs : nya::maths::lerp( measuredCaptureGPUCost, gpuTimeInMs, COST_SMOOTHING );
+}
+
+void IBLProbeUpdateScheduler::onConvolutionGPUTimeRetrieved( const uint64_t frameIndex, const double gpuTimeInMs )
+{
+    // The frame might have been overwritten if the timing is too old
+    RecordedFrame& frame = recordedFrames[frameIndex % RECORDED_FRAME_HISTORY];
+    if ( frame.FrameIndex != frameIndex || frame.ConvolutionWeight <= 0.0 ) {
+        return;
+    }
+
+    const double convolutionCost = gpuTimeInMs / frame.ConvolutionWeight;
+    measuredConvolutionGPUCost = ( measuredConvolutionGPUCost == 0.0 ) ? convolutionCost : nya::maths::lerp( measuredConvolutionGPUCost, convolutionCost, COST_SMOOTHING );
+
+    frame.FrameIndex = ~0ull;
+}
+
+uint32_t IBLProbeUpdateScheduler::getPendingProbeCount() const
+{
+    uint32_t pendingProbeCount = 0u;
+    for ( const ProbeUpdateState& state : probeStates ) {
+        pendingProbeCount += state.IsPending;
+    }
+
+    return pendingProbeCount;
+}
+
+uint32_t IBLProbeUpdateScheduler::getPendingCommandCount() const
+{
+    uint32_t pendingCommandCount = 0u;
+    for ( const ProbeUpdateState& state : probeStates ) {
+        if ( state.IsPending ) {
+            pendingCommandCount += ( STEP_COUNT - state.NextStep );
+        }
+    }
+
+    return pendingCommandCount;
+}
+
+double IBLProbeUpdateScheduler::getEstimatedPendingCost() const
+{
+    double pendingCost = 0.0;
+    for ( const ProbeUpdateState& state : probeStates ) {
+        if ( !state.IsPending ) {
+            continue;
+        }
+
+        for ( uint16_t step = state.NextStep; step < STEP_COUNT; step++ ) {
+            pendingCost += getStepCost( step );
+        }
+    }
+
+    return pendingCost;
+}
+
+double IBLProbeUpdateScheduler::getStepCost( const uint16_t step ) const
+{
+    // CPU and GPU run in parallel: the frame pays for the most expensive of both
+    if ( step < CAPTURE_STEP_COUNT ) {
+        const double captureGPUCost = ( measuredCaptureGPUCost > 0.0 ) ? measuredCaptureGPUCost : DEFAULT_CAPTURE_COST;
+        return nya::maths::max( captureGPUCost, measuredCaptureCPUCost );
+    }
+
+    const double convolutionGPUCost = ( measuredConvolutionGPUCost > 0.0 ) ? measuredConvolutionGPUCost : DEFAULT_CONVOLUTION_COST;
+
+    const uint16_t mipIndex = static_cast<uint16_t>( ( step - CAPTURE_STEP_COUNT ) % CONVOLUTION_MIP_COUNT );
+    return nya::maths::max( convolutionGPUCost, measuredConvolutionCPUCost ) * GetConvolutionWeight( mipIndex );
+}
+
+float IBLProbeUpdateScheduler::computePriority( const ProbeUpdateState& state, const nyaVec3f& viewerWorldPosition ) const
+{
+    const IBLProbeData* probe = state.Probe;
+
+    // Fallback probes are visible from everywhere
+    float distanceToViewer = 0.0f;
+    if ( !probe->isFallbackProbe ) {
+        distanceToViewer = nya::maths::max( 0.0f, sqrtf( nyaVec3f::distanceSquared( viewerWorldPosition, probe->worldPosition ) ) - probe->radius );
+    }
+
+    float priority = ( 1.0f + static_cast<float>( state.AgeInFrames ) * AGE_WEIGHT ) / ( 1.0f + distanceToViewer * DISTANCE_WEIGHT );
+
+    if ( state.IsDirty ) {
+        priority *= DIRTY_WEIGHT;
+    }
+
+    // Finish started updates first to avoid partially updated probes
+    if ( state.NextStep != 0u ) {
+        priority *= IN_PROGRESS_WEIGHT;
+    }
+
+    return priority;
+}
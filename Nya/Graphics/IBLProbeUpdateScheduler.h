@@ -0,0 +1,121 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <Maths/Vector.h>
+#include <Shaders/Shared.h>
+
+struct IBLProbeData;
+
+enum eProbeCaptureStep : uint16_t
+{
+    FACE_X_PLUS = 0,
+    FACE_X_MINUS,
+
+    FACE_Y_PLUS,
+    FACE_Y_MINUS,
+
+    FACE_Z_PLUS,
+    FACE_Z_MINUS,
+};
+
+struct IBLProbeUpdateCommand
+{
+    const IBLProbeData* Probe;
+    eProbeCaptureStep   Step;
+    uint16_t            MipIndex;
+    bool                IsConvolution;
+};
+
+// Spreads IBL probe capture/convolution over several frames
+// Pending probes are sorted by priority (distance to the viewer, dirtiness and age) and
+// commands are issued until the estimated cost of the frame reaches the update budget
+class IBLProbeUpdateScheduler
+{
+public:
+    static constexpr uint32_t       CAPTURE_STEP_COUNT = 6u;
+    static constexpr uint32_t       CONVOLUTION_MIP_COUNT = 8u;
+    static constexpr uint32_t       STEP_COUNT = CAPTURE_STEP_COUNT + CAPTURE_STEP_COUNT * CONVOLUTION_MIP_COUNT;
+
+public:
+                                    IBLProbeUpdateScheduler();
+                                    IBLProbeUpdateScheduler( IBLProbeUpdateScheduler& ) = delete;
+                                    IBLProbeUpdateScheduler& operator = ( IBLProbeUpdateScheduler& ) = delete;
+                                    ~IBLProbeUpdateScheduler();
+
+    // Queue a probe update (restarts the update if the probe is already pending)
+    void                            requestUpdate( const IBLProbeData* probeData, const bool isDirty = true );
+    void                            cancelUpdate( const IBLProbeData* probeData );
+
+    // Fill commands for the current frame (capture commands are returned first) and return the command count
+    // At least one command is returned if work is pending, even if the budget is exceeded
+    uint32_t                        scheduleUpdates( const nyaVec3f& viewerWorldPosition, IBLProbeUpdateCommand* commands, const uint32_t maxCaptureCount, const uint32_t maxCommandCount );
+
+    // Refine CPU cost estimates using the recording time of the commands returned by the latest scheduleUpdates call
+    // frameIndex is the frame the commands are rendered at (used to match the GPU timings retrieved later)
+    void                            onCommandsRecorded( const uint64_t frameIndex, const double captureTimeInMs, const double convolutionTimeInMs );
+
+    // Refine GPU cost estimates using the GPU time of a capture pipeline (a single face capture)
+    void                            onCaptureGPUTimeRetrieved( const double gpuTimeInMs );
+
+    // Refine GPU cost estimates using the GPU time of the convolution pipeline rendered at frameIndex
+    void                            onConvolutionGPUTimeRetrieved( const uint64_t frameIndex, const double gpuTimeInMs );
+
+    uint32_t                        getPendingProbeCount() const;
+    uint32_t                        getPendingCommandCount() const;
+    double                          getEstimatedPendingCost() const;
+
+private:
+    struct ProbeUpdateState
+    {
+        const IBLProbeData* Probe;
+        uint32_t            AgeInFrames;
+        uint16_t            NextStep;
+        uint8_t             IsPending : 1;
+        uint8_t             IsDirty : 1;
+    };
+
+    // Convolution weight of the commands recorded for a frame (GPU timings are retrieved a few frames late)
+    struct RecordedFrame
+    {
+        uint64_t            FrameIndex;
+        double              ConvolutionWeight;
+    };
+
+    static constexpr uint32_t       RECORDED_FRAME_HISTORY = 16u;
+
+private:
+    ProbeUpdateState                probeStates[MAX_IBL_PROBE_COUNT];
+
+    // Measured cost (in ms) of a face capture and of a mip 0 face convolution
+    double                          measuredCaptureCPUCost;
+    double                          measuredConvolutionCPUCost;
+    double                          measuredCaptureGPUCost;
+    double                          measuredConvolutionGPUCost;
+
+    uint32_t                        lastCaptureCount;
+    double                          lastConvolutionWeight;
+
+    RecordedFrame                   recordedFrames[RECORDED_FRAME_HISTORY];
+
+private:
+    double                          getStepCost( const uint16_t step ) const;
+    float                           computePriority( const ProbeUpdateState& state, const nyaVec3f& viewerWorldPosition ) const;
+};
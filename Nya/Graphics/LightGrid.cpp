@@ -30,44 +30,265 @@
 #include <Rendering/ImageFormat.h>
 
 #include <Maths/Helpers.h>
+#include <Maths/AABB.h>
+#include <Maths/Frustum.h>
+#include <Maths/SphericalHarmonics.h>
+
+#include <Core/SIMD/Intrinsics.h>
+#include <Core/EnvVarsRegister.h>
+
+#include <string.h>
+#include <algorithm>
 
 using namespace nya::maths;
 
 static constexpr int CLUSTER_X = 16;
 static constexpr int CLUSTER_Y = 8;
 static constexpr int CLUSTER_Z = 24;
+static constexpr int CLUSTER_COUNT = ( CLUSTER_X * CLUSTER_Y * CLUSTER_Z );
+
+// Max distance (in entities) between two modified entities for their upload to be merged
+static constexpr uint32_t DIRTY_RANGE_MERGE_DISTANCE = 8u;
+
+NYA_ENV_VAR( LightGridCPUCulling, false, bool ) // "Also build light clusters on the CPU each frame (profiling/validation of the compute path; devbuild compares the CPU clusters with the GPU clusters) [false/true]"
+NYA_ENV_VAR( LightGridCPUWorkerCount, 4, uint32_t ) // "Number of threads used to build light clusters on the CPU (Z slices are split between threads) [1..24]"
+NYA_ENV_VAR( IBLProbeSHValidationSampleCount, 0, uint32_t ) // "Number of directions used to validate the SH9 irradiance of IBL probes against a brute force convolution (0 disables validation; devbuild only)"
+NYA_ENV_VAR( IBLProbeSHMaxRelativeError, 0.05f, float ) // "Max relative error tolerated between the SH9 irradiance and the brute force convolution before a warning is emitted"
+
+static_assert( sizeof( PointLightData ) == sizeof( nyaVec4f ) * POINT_LIGHT_VECTOR_COUNT, "PointLightData layout does not match the shader layout!" );
+static_assert( sizeof( IBLProbeData ) == sizeof( nyaVec4f ) * IBL_PROBE_VECTOR_COUNT, "IBLProbeData layout does not match the shader layout!" );
+
+using ClusterCullingSoA = LightGrid::ClusterCullingSoA;
+
+// NOTE entities must be stored in the same order as the spatial index entities
+static void GatherSliceCandidates( const LightSpatialIndex& spatialIndex, const ClusterCullingSoA& entities, const AABB& sliceAABB, std::vector<uint32_t>& queryResults, ClusterCullingSoA& candidates )
+{
+    candidates.clear();
+
+    queryResults.clear();
+    spatialIndex.query( sliceAABB, queryResults );
+
+    for ( const uint32_t i : queryResults ) {
+        candidates.add( nyaVec3f( entities.positionX[i], entities.positionY[i], entities.positionZ[i] ), entities.radius[i], entities.index[i] );
+    }
+
+    candidates.pad();
+}
+
+// Append the index of each candidate intersecting the cluster AABB; returns the updated item count
+static uint32_t CullClusterEntities( const ClusterCullingSoA& candidates, const nyaVec3f& clusterMin, const nyaVec3f& clusterMax, uint32_t* items, uint32_t itemCount )
+{
+#if NYA_SSE42
+    const fnSIMDVecf_t zero = nya::simd::Create();
+    const fnSIMDVecf_t clusterMinX = nya::simd::Load( clusterMin.x );
+    const fnSIMDVecf_t clusterMinY = nya::simd::Load( clusterMin.y );
+    const fnSIMDVecf_t clusterMinZ = nya::simd::Load( clusterMin.z );
+    const fnSIMDVecf_t clusterMaxX = nya::simd::Load( clusterMax.x );
+    const fnSIMDVecf_t clusterMaxY = nya::simd::Load( clusterMax.y );
+    const fnSIMDVecf_t clusterMaxZ = nya::simd::Load( clusterMax.z );
+
+    const uint32_t paddedCount = static_cast<uint32_t>( candidates.positionX.size() );
+    for ( uint32_t i = 0u; i < paddedCount; i += 4 ) {
+        const fnSIMDVecf_t px = nya::simd::LoadUnaligned( &candidates.positionX[i] );
+        const fnSIMDVecf_t py = nya::simd::LoadUnaligned( &candidates.positionY[i] );
+        const fnSIMDVecf_t pz = nya::simd::LoadUnaligned( &candidates.positionZ[i] );
+        const fnSIMDVecf_t r = nya::simd::LoadUnaligned( &candidates.radius[i] );
+
+        // Distance from the sphere center to the cluster AABB (per axis)
+        const fnSIMDVecf_t dx = nya::simd::Add( nya::simd::Max( nya::simd::Sub( clusterMinX, px ), zero ), nya::simd::Max( nya::simd::Sub( px, clusterMaxX ), zero ) );
+        const fnSIMDVecf_t dy = nya::simd::Add( nya::simd::Max( nya::simd::Sub( clusterMinY, py ), zero ), nya::simd::Max( nya::simd::Sub( py, clusterMaxY ), zero ) );
+        const fnSIMDVecf_t dz = nya::simd::Add( nya::simd::Max( nya::simd::Sub( clusterMinZ, pz ), zero ), nya::simd::Max( nya::simd::Sub( pz, clusterMaxZ ), zero ) );
+
+        const fnSIMDVecf_t squaredDistance = nya::simd::MulAdd( dx, dx, nya::simd::MulAdd( dy, dy, nya::simd::Mul( dz, dz ) ) );
+        const int intersectionMask = nya::simd::MoveMask( nya::simd::CompareLessMask( squaredDistance, nya::simd::Mul( r, r ) ) );
+
+        if ( intersectionMask == 0 ) {
+            continue;
+        }
+
+        for ( uint32_t lane = 0u; lane < 4u; lane++ ) {
+            if ( ( intersectionMask & ( 1 << lane ) ) != 0 && itemCount < MAX_CLUSTER_ITEM_COUNT ) {
+                items[itemCount++] = candidates.index[i + lane];
+            }
+        }
+    }
+#else
+    for ( uint32_t i = 0u; i < candidates.count; i++ ) {
+        const float dx = nya::maths::max( clusterMin.x - candidates.positionX[i], 0.0f ) + nya::maths::max( candidates.positionX[i] - clusterMax.x, 0.0f );
+        const float dy = nya::maths::max( clusterMin.y - candidates.positionY[i], 0.0f ) + nya::maths::max( candidates.positionY[i] - clusterMax.y, 0.0f );
+        const float dz = nya::maths::max( clusterMin.z - candidates.positionZ[i], 0.0f ) + nya::maths::max( candidates.positionZ[i] - clusterMax.z, 0.0f );
+
+        if ( ( dx * dx + dy * dy + dz * dz ) < ( candidates.radius[i] * candidates.radius[i] ) && itemCount < MAX_CLUSTER_ITEM_COUNT ) {
+            items[itemCount++] = candidates.index[i];
+        }
+    }
+#endif
+
+    return itemCount;
+}
+
+static void BuildClusterSlices( const LightGrid::SceneInfosBuffer& sceneInfos, const LightSpatialIndex& pointLightIndex, const ClusterCullingSoA& pointLights, const LightSpatialIndex& iblProbeIndex, const ClusterCullingSoA& iblProbes, LightGrid::ClusterCullingScratch& scratch, uint32_t* clusters, uint32_t* itemList, const int firstSlice, const int sliceStep )
+{
+    const nyaVec3f& clusterSize = sceneInfos.ClustersInverseScale;
+
+    ClusterCullingSoA& slicePointLights = scratch.SlicePointLights;
+    ClusterCullingSoA& sliceIBLProbes = scratch.SliceIBLProbes;
+    std::vector<uint32_t>& queryResults = scratch.QueryResults;
+
+    for ( int z = firstSlice; z < CLUSTER_Z; z += sliceStep ) {
+        const float sliceMinZ = sceneInfos.SceneAABBMin.z + z * clusterSize.z;
+        const float sliceMaxZ = sliceMinZ + clusterSize.z;
+
+        AABB sliceAABB = {};
+        nya::maths::CreateAABBFromMinMaxPoints( sliceAABB, nyaVec3f( sceneInfos.SceneAABBMin.x, sceneInfos.SceneAABBMin.y, sliceMinZ ), nyaVec3f( sceneInfos.SceneAABBMax.x, sceneInfos.SceneAABBMax.y, sliceMaxZ ) );
+
+        GatherSliceCandidates( pointLightIndex, pointLights, sliceAABB, queryResults, slicePointLights );
+        GatherSliceCandidates( iblProbeIndex, iblProbes, sliceAABB, queryResults, sliceIBLProbes );
+
+        for ( int y = 0; y < CLUSTER_Y; y++ ) {
+            for ( int x = 0; x < CLUSTER_X; x++ ) {
+                const int clusterIndex = ( x + y * CLUSTER_X + z * CLUSTER_X * CLUSTER_Y );
+                const uint32_t itemListOffset = static_cast<uint32_t>( clusterIndex ) * MAX_CLUSTER_ITEM_COUNT;
+
+                const nyaVec3f clusterMin = nyaVec3f(
+                    sceneInfos.SceneAABBMin.x + x * clusterSize.x,
+                    sceneInfos.SceneAABBMin.y + y * clusterSize.y,
+                    sliceMinZ );
+                const nyaVec3f clusterMax = nyaVec3f( clusterMin.x + clusterSize.x, clusterMin.y + clusterSize.y, sliceMaxZ );
+
+                uint32_t* items = &itemList[itemListOffset];
+                const uint32_t pointLightCount = CullClusterEntities( slicePointLights, clusterMin, clusterMax, items, 0u );
+                const uint32_t iblProbeCount = CullClusterEntities( sliceIBLProbes, clusterMin, clusterMax, items, pointLightCount ) - pointLightCount;
+                const uint32_t spotLightCount = 0u;
+
+                clusters[clusterIndex * 2 + 0] = itemListOffset;
+                clusters[clusterIndex * 2 + 1] = ( ( pointLightCount << 20 ) & 0xFFF00000 ) | ( ( spotLightCount << 8 ) & 0x000FFF00 ) | ( iblProbeCount & 0x000000FF );
+            }
+        }
+    }
+}
+
+// Add an entity to the dirty ranges; close ranges are merged to limit the number of uploads
+static void MarkDirtyRange( std::vector<LightGrid::DirtyRange>& dirtyRanges, const uint32_t index )
+{
+    if ( !dirtyRanges.empty() ) {
+        LightGrid::DirtyRange& lastRange = dirtyRanges.back();
+        const uint32_t rangeEnd = ( lastRange.First + lastRange.Count );
+
+        if ( index >= lastRange.First && index < ( rangeEnd + DIRTY_RANGE_MERGE_DISTANCE ) ) {
+            lastRange.Count = nya::maths::max( rangeEnd, index + 1u ) - lastRange.First;
+            return;
+        }
+    }
+
+    dirtyRanges.push_back( { index, 1u } );
+}
+
+static uint32_t RoundToNextPowerOfTwo( uint32_t value )
+{
+    uint32_t powerOfTwo = 1u;
+    while ( powerOfTwo < value ) {
+        powerOfTwo <<= 1;
+    }
+
+    return powerOfTwo;
+}
 
 LightGrid::LightGrid( BaseAllocator* allocator )
     : memoryAllocator( allocator )
+    , renderDevice( nullptr )
     , lightCullingPso( nullptr )
     , sceneInfosBuffer{ 0 }
     , pointLightCount( 0 )
     , localIBLProbeCount( 0 )
     , lights{}
+    , iblProbes{}
+    , sceneAABBMin( 0.0f, 0.0f, 0.0f )
+    , sceneAABBMax( 0.0f, 0.0f, 0.0f )
+    , iblProbeIrradiances{}
+    , lightsGpuBuffer( nullptr )
+    , pointLightsGpuBuffer( nullptr )
+    , iblProbesGpuBuffer( nullptr )
+    , pointLightUploadBuffer( nullptr )
+    , pointLightUploadCapacity( 0u )
+    , uploadedPointLightCount( 0u )
+    , uploadedIBLProbes{}
+    , uploadedIBLProbeCount( 0u )
+    , uploadedLights{}
+    , isLightsBufferDirty( true )
+    , uploadFrameIndex( ~0ull )
+    , uploadedBytesThisFrame( 0 )
+    , pointLightCullingEntities{}
+    , localIBLProbeCullingEntities{}
+    , areClustersCPUDirty( true )
+    , clustersCPU( nullptr )
+    , itemListCPU( nullptr )
+    , clusterBuildIndex( 0u )
+    , pendingClusterWorkerCount( 0u )
+    , isClusterWorkersShutdownRequested( false )
+#if NYA_DEVBUILD
+    , isClustersReadbackSupported( true )
+#endif
 {
-
+    resizePointLightBuffers( LIGHT_GRID_POINT_LIGHT_PAGE_SIZE );
 }
 
 LightGrid::~LightGrid()
 {
+    destroyClusterWorkers();
+
+    for ( PointLightData* page : pointLightPages ) {
+        nya::core::freeArray( memoryAllocator, page );
+    }
+    pointLightPages.clear();
+    freePointLightSlots.clear();
+    isPointLightSlotFree.clear();
+
+    nya::core::freeArray( memoryAllocator, pointLightUploadBuffer );
 
+    if ( clustersCPU != nullptr ) {
+        nya::core::freeArray( memoryAllocator, clustersCPU );
+        nya::core::freeArray( memoryAllocator, itemListCPU );
+    }
+
+    pointLightCount = 0u;
+    localIBLProbeCount = 0u;
+    pointLightUploadCapacity = 0u;
+    uploadedPointLightCount = 0u;
+    uploadedIBLProbeCount = 0u;
 }
 
 void LightGrid::destroy( RenderDevice* renderDevice )
 {
     renderDevice->destroyPipelineState( lightCullingPso );
+
+    renderDevice->destroyBuffer( lightsGpuBuffer );
+    renderDevice->destroyBuffer( pointLightsGpuBuffer );
+    renderDevice->destroyBuffer( iblProbesGpuBuffer );
+
+    lightsGpuBuffer = nullptr;
+    pointLightsGpuBuffer = nullptr;
+    iblProbesGpuBuffer = nullptr;
+
+    this->renderDevice = nullptr;
 }
 
 LightGrid::PassData LightGrid::updateClusters( RenderPipeline* renderPipeline )
 {
+    if ( LightGridCPUCulling ) {
+        buildClustersCPU();
+    }
+
+    renderPipeline->importPersistentBuffer( NYA_STRING_HASH( "LightGrid/LightsBuffer" ), lightsGpuBuffer );
+    renderPipeline->importPersistentBuffer( NYA_STRING_HASH( "LightGrid/PointLightsBuffer" ), pointLightsGpuBuffer );
+    renderPipeline->importPersistentBuffer( NYA_STRING_HASH( "LightGrid/IBLProbesBuffer" ), iblProbesGpuBuffer );
+
     PassData& passData = renderPipeline->addRenderPass<PassData>(
         "Light Clusters Update Pass",
         [&]( RenderPipelineBuilder& renderPipelineBuilder, PassData& passData ) {
-            BufferDesc lightBufferDesc = {};
-            lightBufferDesc.type = BufferDesc::CONSTANT_BUFFER;
-            lightBufferDesc.size = sizeof( lights );
-            
-            passData.lightsBuffer = renderPipelineBuilder.allocateBuffer( lightBufferDesc, SHADER_STAGE_COMPUTE );
+            passData.lightsBuffer = renderPipelineBuilder.retrievePersistentBuffer( NYA_STRING_HASH( "LightGrid/LightsBuffer" ) );
+            passData.pointLightsBuffer = renderPipelineBuilder.retrievePersistentBuffer( NYA_STRING_HASH( "LightGrid/PointLightsBuffer" ) );
+            passData.iblProbesBuffer = renderPipelineBuilder.retrievePersistentBuffer( NYA_STRING_HASH( "LightGrid/IBLProbesBuffer" ) );
 
             BufferDesc sceneClustersBufferDesc = {};
             sceneClustersBufferDesc.type = BufferDesc::CONSTANT_BUFFER;
@@ -88,7 +309,7 @@ LightGrid::PassData LightGrid::updateClusters( RenderPipeline* renderPipeline )
             bufferDesc = {};
             bufferDesc.type = BufferDesc::UNORDERED_ACCESS_VIEW_BUFFER;
             bufferDesc.viewFormat = eImageFormat::IMAGE_FORMAT_R32_UINT;
-            bufferDesc.size = sizeof( uint32_t ) * CLUSTER_X * CLUSTER_Y * CLUSTER_Z * ( MAX_POINT_LIGHT_COUNT + MAX_LOCAL_IBL_PROBE_COUNT );
+            bufferDesc.size = sizeof( uint32_t ) * CLUSTER_X * CLUSTER_Y * CLUSTER_Z * MAX_CLUSTER_ITEM_COUNT;
             bufferDesc.stride = static_cast<uint32_t>( bufferDesc.size / sizeof( uint32_t ) );
             
             passData.itemList = renderPipelineBuilder.allocateBuffer( bufferDesc, SHADER_STAGE_COMPUTE );
@@ -96,7 +317,9 @@ LightGrid::PassData LightGrid::updateClusters( RenderPipeline* renderPipeline )
         [=]( const PassData& passData, const RenderPipelineResources& renderPipelineResources, RenderDevice* renderDevice ) {
             Buffer* lightsClusters = renderPipelineResources.getBuffer( passData.lightsClusters );
             Buffer* itemList = renderPipelineResources.getBuffer( passData.itemList );
-            Buffer* lightsBuffer = renderPipelineResources.getBuffer( passData.lightsBuffer );
+            Buffer* lightsBuffer = renderPipelineResources.getPersistentBuffer( passData.lightsBuffer );
+            Buffer* pointLightsBuffer = renderPipelineResources.getPersistentBuffer( passData.pointLightsBuffer );
+            Buffer* iblProbesBuffer = renderPipelineResources.getPersistentBuffer( passData.iblProbesBuffer );
             Buffer* lightsClustersInfos = renderPipelineResources.getBuffer( passData.lightsClustersInfosBuffer );
 
             ResourceList resourceList;
@@ -104,13 +327,16 @@ LightGrid::PassData LightGrid::updateClusters( RenderPipeline* renderPipeline )
             resourceList.resource[1].buffer = itemList;
             resourceList.resource[2].buffer = lightsBuffer;
             resourceList.resource[3].buffer = lightsClustersInfos;
+            resourceList.resource[4].buffer = pointLightsBuffer;
+            resourceList.resource[5].buffer = iblProbesBuffer;
             renderDevice->updateResourceList( lightCullingPso, resourceList );
 
             CommandList& cmdList = renderDevice->allocateComputeCommandList();
             {
                 cmdList.begin();
 
-                cmdList.updateBuffer( lightsBuffer, &lights, sizeof( lights ) );
+                uploadModifiedLights( cmdList, lightsBuffer, pointLightsBuffer, iblProbesBuffer );
+
                 cmdList.updateBuffer( lightsClustersInfos, &sceneInfosBuffer, sizeof( SceneInfosBuffer ) );
 
                 cmdList.bindPipelineState( lightCullingPso );
@@ -121,6 +347,12 @@ LightGrid::PassData LightGrid::updateClusters( RenderPipeline* renderPipeline )
             }
 
             renderDevice->submitCommandList( &cmdList );
+
+#if NYA_DEVBUILD
+            if ( LightGridCPUCulling ) {
+                compareClustersWithGPU( renderDevice, lightsClusters, itemList );
+            }
+#endif
         }
     );
 
@@ -129,37 +361,95 @@ LightGrid::PassData LightGrid::updateClusters( RenderPipeline* renderPipeline )
 
 void LightGrid::loadCachedResources( RenderDevice* renderDevice, ShaderCache* shaderCache, GraphicsAssetCache* graphicsAssetCache )
 {
+    this->renderDevice = renderDevice;
+
     PipelineStateDesc pipelineState = {};
     pipelineState.computeShader = shaderCache->getOrUploadStage( "Lighting/LightCulling", eShaderStage::SHADER_STAGE_COMPUTE );
     pipelineState.resourceListLayout.resources[0] = { 0, SHADER_STAGE_COMPUTE, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_UAV_TEXTURE };
     pipelineState.resourceListLayout.resources[1] = { 1, SHADER_STAGE_COMPUTE, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_UAV_BUFFER };
     pipelineState.resourceListLayout.resources[2] = { 2, SHADER_STAGE_COMPUTE, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_CBUFFER };
     pipelineState.resourceListLayout.resources[3] = { 4, SHADER_STAGE_COMPUTE, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_CBUFFER };
+    pipelineState.resourceListLayout.resources[4] = { 17, SHADER_STAGE_COMPUTE, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_GENERIC_BUFFER };
+    pipelineState.resourceListLayout.resources[5] = { 18, SHADER_STAGE_COMPUTE, ResourceListLayoutDesc::RESOURCE_LIST_RESOURCE_TYPE_GENERIC_BUFFER };
 
     lightCullingPso = renderDevice->createPipelineState( pipelineState );
+
+    BufferDesc lightsBufferDesc = {};
+    lightsBufferDesc.type = BufferDesc::CONSTANT_BUFFER;
+    lightsBufferDesc.size = sizeof( LightsBuffer );
+
+    lightsGpuBuffer = renderDevice->createBuffer( lightsBufferDesc );
+
+    // NOTE Light buffers are UAV buffers (default usage) to allow partial updates; shaders only read them through an SRV
+    BufferDesc iblProbesBufferDesc = {};
+    iblProbesBufferDesc.type = BufferDesc::UNORDERED_ACCESS_VIEW_BUFFER;
+    iblProbesBufferDesc.viewFormat = eImageFormat::IMAGE_FORMAT_R32G32B32A32_UINT;
+    iblProbesBufferDesc.size = sizeof( IBLProbeData ) * MAX_IBL_PROBE_COUNT;
+    iblProbesBufferDesc.stride = MAX_IBL_PROBE_COUNT * IBL_PROBE_VECTOR_COUNT;
+
+    iblProbesGpuBuffer = renderDevice->createBuffer( iblProbesBufferDesc );
+
+    // Create the point light buffer and force a full upload
+    resizePointLightBuffers( pointLightUploadCapacity );
+
+    isLightsBufferDirty = true;
+    uploadedIBLProbeCount = 0u;
 }
 
 void LightGrid::setSceneBounds( const nyaVec3f& sceneAABBMax, const nyaVec3f& sceneAABBMin )
 {
-    sceneInfosBuffer.SceneAABBMax = sceneAABBMax;
-    sceneInfosBuffer.SceneAABBMin = sceneAABBMin;
-
-    updateClustersInfos();
+    this->sceneAABBMax = sceneAABBMax;
+    this->sceneAABBMin = sceneAABBMin;
 }
 
 PointLightData* LightGrid::allocatePointLightData( const PointLightData&& lightData )
 {
-    if ( localIBLProbeCount >= MAX_POINT_LIGHT_COUNT ) {
-        NYA_CERR << "Too many Point Lights! (max is set to " << MAX_POINT_LIGHT_COUNT << ")" << std::endl;
-        return nullptr;
+    uint32_t slotIndex = pointLightCount;
+
+    if ( !freePointLightSlots.empty() ) {
+        slotIndex = freePointLightSlots.back();
+        freePointLightSlots.pop_back();
+    } else {
+        if ( ( slotIndex / LIGHT_GRID_POINT_LIGHT_PAGE_SIZE ) >= pointLightPages.size() ) {
+            pointLightPages.push_back( nya::core::allocateArray<PointLightData>( memoryAllocator, LIGHT_GRID_POINT_LIGHT_PAGE_SIZE ) );
+        }
+
+        isPointLightSlotFree.push_back( 0u );
+        pointLightCount++;
     }
 
-    PointLightData& light = lights.PointLights[pointLightCount++]; \
+    isPointLightSlotFree[slotIndex] = 0u;
+
+    PointLightData& light = pointLightPages[slotIndex / LIGHT_GRID_POINT_LIGHT_PAGE_SIZE][slotIndex % LIGHT_GRID_POINT_LIGHT_PAGE_SIZE];
     light = std::move( lightData );
 
+    lights.PointLightCount = pointLightCount - static_cast<uint32_t>( freePointLightSlots.size() );
+
     return &light;
 }
 
+void LightGrid::releasePointLightData( PointLightData* lightData )
+{
+    for ( uint32_t pageIndex = 0u; pageIndex < pointLightPages.size(); pageIndex++ ) {
+        PointLightData* page = pointLightPages[pageIndex];
+
+        if ( lightData < page || lightData >= ( page + LIGHT_GRID_POINT_LIGHT_PAGE_SIZE ) ) {
+            continue;
+        }
+
+        const uint32_t slotIndex = pageIndex * LIGHT_GRID_POINT_LIGHT_PAGE_SIZE + static_cast<uint32_t>( lightData - page );
+        NYA_DEV_ASSERT( slotIndex < pointLightCount && isPointLightSlotFree[slotIndex] == 0u, "Invalid point light release (slot %u)", slotIndex );
+
+        isPointLightSlotFree[slotIndex] = 1u;
+        freePointLightSlots.push_back( slotIndex );
+
+        lights.PointLightCount = pointLightCount - static_cast<uint32_t>( freePointLightSlots.size() );
+        return;
+    }
+
+    NYA_CWARN << "Tried to release a point light which doesn't belong to the light grid" << std::endl;
+}
+
 IBLProbeData* LightGrid::allocateLocalIBLProbeData( const IBLProbeData&& probeData )
 {
     if ( localIBLProbeCount >= MAX_LOCAL_IBL_PROBE_COUNT ) {
@@ -169,8 +459,9 @@ IBLProbeData* LightGrid::allocateLocalIBLProbeData( const IBLProbeData&& probeDa
 
     // NOTE Offset probe array index (first probe should be the global IBL probe)
     const uint16_t probeIndex = ( 1u + localIBLProbeCount++ );
+    lights.LocalIBLProbeCount = localIBLProbeCount;
 
-    IBLProbeData& light = lights.IBLProbes[probeIndex];
+    IBLProbeData& light = iblProbes[probeIndex];
     light = std::move( probeData );
     light.ProbeIndex = probeIndex;
 
@@ -185,20 +476,344 @@ DirectionalLightData* LightGrid::updateDirectionalLightData( const DirectionalLi
 
 IBLProbeData* LightGrid::updateGlobalIBLProbeData( const IBLProbeData&& probeData )
 {
-    lights.IBLProbes[0] = std::move( probeData );
-    lights.IBLProbes[0].ProbeIndex = 0u;
+    iblProbes[0] = std::move( probeData );
+    iblProbes[0].ProbeIndex = 0u;
 
-    return &lights.IBLProbes[0];
+    return &iblProbes[0];
+}
+
+void LightGrid::captureFrameLights( FrameLights& frameLights ) const
+{
+    frameLights.Lights = lights;
+    frameLights.SceneAABBMin = sceneAABBMin;
+    frameLights.SceneAABBMax = sceneAABBMax;
+
+    // Point lights are stored contiguously in the packet (released slots are skipped)
+    if ( freePointLightSlots.empty() ) {
+        frameLights.PointLights.resize( pointLightCount );
+        for ( uint32_t firstLightIdx = 0u; firstLightIdx < pointLightCount; firstLightIdx += LIGHT_GRID_POINT_LIGHT_PAGE_SIZE ) {
+            const uint32_t pageLightCount = nya::maths::min( LIGHT_GRID_POINT_LIGHT_PAGE_SIZE, pointLightCount - firstLightIdx );
+            memcpy( &frameLights.PointLights[firstLightIdx], pointLightPages[firstLightIdx / LIGHT_GRID_POINT_LIGHT_PAGE_SIZE], sizeof( PointLightData ) * pageLightCount );
+        }
+    } else {
+        frameLights.PointLights.clear();
+        frameLights.PointLights.reserve( pointLightCount - freePointLightSlots.size() );
+
+        for ( uint32_t slotIndex = 0u; slotIndex < pointLightCount; slotIndex++ ) {
+            if ( isPointLightSlotFree[slotIndex] == 0u ) {
+                frameLights.PointLights.push_back( pointLightPages[slotIndex / LIGHT_GRID_POINT_LIGHT_PAGE_SIZE][slotIndex % LIGHT_GRID_POINT_LIGHT_PAGE_SIZE] );
+            }
+        }
+    }
+
+    memcpy( frameLights.IBLProbes, iblProbes, sizeof( IBLProbeData ) * ( 1u + localIBLProbeCount ) );
+}
+
+void LightGrid::setFrameLights( const FrameLights& frameLights )
+{
+    if ( memcmp( &sceneInfosBuffer.SceneAABBMax, &frameLights.SceneAABBMax, sizeof( nyaVec3f ) ) != 0
+      || memcmp( &sceneInfosBuffer.SceneAABBMin, &frameLights.SceneAABBMin, sizeof( nyaVec3f ) ) != 0 ) {
+        areClustersCPUDirty = true;
+    }
+
+    sceneInfosBuffer.SceneAABBMax = frameLights.SceneAABBMax;
+    sceneInfosBuffer.SceneAABBMin = frameLights.SceneAABBMin;
+
+    updateClustersInfos();
+    updateLightBuffers( frameLights );
 }
 
 const DirectionalLightData* LightGrid::getDirectionalLightData() const
 {
-    return &lights.DirectionalLight;
+    return &uploadedLights.DirectionalLight;
 }
 
 const IBLProbeData* LightGrid::getGlobalIBLProbeData() const
 {
-    return &lights.IBLProbes[0];
+    return &uploadedIBLProbes[0];
+}
+
+const IBLProbeData* LightGrid::getIBLProbeData( const uint32_t probeArrayIndex ) const
+{
+    if ( probeArrayIndex >= uploadedIBLProbeCount ) {
+        return nullptr;
+    }
+
+    return &uploadedIBLProbes[probeArrayIndex];
+}
+
+uint32_t LightGrid::getPointLightCount() const
+{
+    return uploadedPointLightCount;
+}
+
+const PointLightData* LightGrid::getPointLightData( const uint32_t lightIndex ) const
+{
+    if ( lightIndex >= uploadedPointLightCount ) {
+        return nullptr;
+    }
+
+    return &pointLightUploadBuffer[lightIndex];
+}
+
+uint32_t LightGrid::getLocalIBLProbeCount() const
+{
+    return ( uploadedIBLProbeCount > 0u ) ? ( uploadedIBLProbeCount - 1u ) : 0u;
+}
+
+void LightGrid::setIBLProbeIrradianceFromCubemap( const uint32_t probeArrayIndex, const float* const faceTexels[6], const uint32_t faceSize )
+{
+    NYA_DEV_ASSERT( probeArrayIndex < uploadedIBLProbeCount, "Probe index out of bounds (%u >= %u)", probeArrayIndex, uploadedIBLProbeCount );
+
+    SH9Projection projection;
+    SH9ClearProjection( projection );
+
+    for ( uint32_t faceIdx = 0u; faceIdx < 6u; faceIdx++ ) {
+        SH9ProjectCubemapFace( projection, faceTexels[faceIdx], faceSize, faceIdx );
+    }
+
+    const SH9 irradiance = SH9ComputeIrradiance( projection );
+
+#if NYA_DEVBUILD
+    const uint32_t validationSampleCount = static_cast<uint32_t>( IBLProbeSHValidationSampleCount );
+    if ( validationSampleCount > 0u ) {
+        const float relativeError = SH9ComputeIrradianceError( irradiance, faceTexels, faceSize, validationSampleCount );
+        if ( relativeError > static_cast<float>( IBLProbeSHMaxRelativeError ) ) {
+            NYA_CWARN << "IBL Probe " << probeArrayIndex << ": SH9 irradiance max relative error is " << ( relativeError * 100.0f ) << "%" << std::endl;
+        }
+
+        NYA_PROFILE_STAT( "IBL Probe SH9 Max Relative Error", relativeError )
+    }
+#endif
+
+    ProbeIrradiance& probeIrradiance = iblProbeIrradiances[probeArrayIndex];
+    for ( uint32_t i = 0u; i < SH9_COEFFICIENT_COUNT; i++ ) {
+        probeIrradiance.IrradianceSH[i] = irradiance.Coefficients[i];
+    }
+    probeIrradiance.HasIrradianceSH = true;
+
+    // Upload the irradiance with the current frame lights
+    applyProbeIrradiance( probeArrayIndex, uploadedIBLProbes[probeArrayIndex] );
+    MarkDirtyRange( dirtyIBLProbeRanges, probeArrayIndex );
+}
+
+void LightGrid::clearIBLProbeIrradianceSH( const uint32_t probeArrayIndex )
+{
+    NYA_DEV_ASSERT( probeArrayIndex < uploadedIBLProbeCount, "Probe index out of bounds (%u >= %u)", probeArrayIndex, uploadedIBLProbeCount );
+
+    iblProbeIrradiances[probeArrayIndex].HasIrradianceSH = false;
+
+    applyProbeIrradiance( probeArrayIndex, uploadedIBLProbes[probeArrayIndex] );
+    MarkDirtyRange( dirtyIBLProbeRanges, probeArrayIndex );
+}
+
+void LightGrid::queryPointLights( const AABB& aabb, std::vector<uint32_t>& lightIndexes ) const
+{
+    pointLightSpatialIndex.query( aabb, lightIndexes );
+}
+
+void LightGrid::queryPointLights( const Frustum& frustum, std::vector<uint32_t>& lightIndexes ) const
+{
+    pointLightSpatialIndex.query( frustum, lightIndexes );
+}
+
+void LightGrid::queryLocalIBLProbes( const AABB& aabb, std::vector<uint32_t>& probeIndexes ) const
+{
+    localIBLProbeSpatialIndex.query( aabb, probeIndexes );
+}
+
+void LightGrid::queryLocalIBLProbes( const Frustum& frustum, std::vector<uint32_t>& probeIndexes ) const
+{
+    localIBLProbeSpatialIndex.query( frustum, probeIndexes );
+}
+
+void LightGrid::buildClustersCPU()
+{
+    NYA_PROFILE_FUNCTION
+
+    if ( clustersCPU == nullptr ) {
+        clustersCPU = nya::core::allocateArray<uint32_t>( memoryAllocator, CLUSTER_COUNT * 2 );
+        itemListCPU = nya::core::allocateArray<uint32_t>( memoryAllocator, CLUSTER_COUNT * MAX_CLUSTER_ITEM_COUNT );
+    } else if ( !areClustersCPUDirty ) {
+        return;
+    }
+
+    const uint32_t sliceSetCount = static_cast<uint32_t>( nya::maths::clamp( static_cast<int>( LightGridCPUWorkerCount ), 1, CLUSTER_Z ) );
+    if ( sliceSetCount != clusterCullingScratches.size() ) {
+        destroyClusterWorkers();
+        createClusterWorkers( sliceSetCount );
+    }
+
+    // Wake the workers up (the calling thread processes the first set of slices)
+    {
+        std::lock_guard<std::mutex> lock( clusterWorkersLock );
+        pendingClusterWorkerCount = static_cast<uint32_t>( clusterWorkers.size() );
+        clusterBuildIndex++;
+    }
+    clusterBuildRequestedEvent.notify_all();
+
+    BuildClusterSlices( sceneInfosBuffer, pointLightSpatialIndex, pointLightCullingEntities, localIBLProbeSpatialIndex, localIBLProbeCullingEntities, clusterCullingScratches[0], clustersCPU, itemListCPU, 0, static_cast<int>( sliceSetCount ) );
+
+    std::unique_lock<std::mutex> lock( clusterWorkersLock );
+    clusterBuildCompletedEvent.wait( lock, [&]() { return pendingClusterWorkerCount == 0u; } );
+
+    areClustersCPUDirty = false;
+}
+
+void LightGrid::createClusterWorkers( const uint32_t sliceSetCount )
+{
+    clusterCullingScratches.resize( sliceSetCount );
+
+    isClusterWorkersShutdownRequested = false;
+    for ( uint32_t sliceSetIndex = 1u; sliceSetIndex < sliceSetCount; sliceSetIndex++ ) {
+        clusterWorkers.push_back( std::thread( &LightGrid::clusterWorkerLoop, this, sliceSetIndex, clusterBuildIndex ) );
+    }
+}
+
+void LightGrid::destroyClusterWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock( clusterWorkersLock );
+        isClusterWorkersShutdownRequested = true;
+    }
+    clusterBuildRequestedEvent.notify_all();
+
+    for ( std::thread& worker : clusterWorkers ) {
+        worker.join();
+    }
+
+    clusterWorkers.clear();
+    clusterCullingScratches.clear();
+}
+
+void LightGrid::clusterWorkerLoop( const uint32_t sliceSetIndex, uint32_t lastBuildIndex )
+{
+    while ( true ) {
+        {
+            std::unique_lock<std::mutex> lock( clusterWorkersLock );
+            clusterBuildRequestedEvent.wait( lock, [&]() { return isClusterWorkersShutdownRequested || clusterBuildIndex != lastBuildIndex; } );
+
+            if ( isClusterWorkersShutdownRequested ) {
+                return;
+            }
+
+            lastBuildIndex = clusterBuildIndex;
+        }
+
+        const int sliceSetCount = static_cast<int>( clusterCullingScratches.size() );
+        BuildClusterSlices( sceneInfosBuffer, pointLightSpatialIndex, pointLightCullingEntities, localIBLProbeSpatialIndex, localIBLProbeCullingEntities, clusterCullingScratches[sliceSetIndex], clustersCPU, itemListCPU, static_cast<int>( sliceSetIndex ), sliceSetCount );
+
+        bool isLastWorker = false;
+        {
+            std::lock_guard<std::mutex> lock( clusterWorkersLock );
+            isLastWorker = ( --pendingClusterWorkerCount == 0u );
+        }
+
+        if ( isLastWorker ) {
+            clusterBuildCompletedEvent.notify_one();
+        }
+    }
+}
+
+#if NYA_DEVBUILD
+void LightGrid::compareClustersWithGPU( RenderDevice* renderDevice, Buffer* lightsClusters, Buffer* itemList )
+{
+    if ( !isClustersReadbackSupported ) {
+        return;
+    }
+
+    clustersReadback.resize( CLUSTER_COUNT * 2 );
+    itemListReadback.resize( CLUSTER_COUNT * MAX_CLUSTER_ITEM_COUNT );
+
+    if ( !renderDevice->readBuffer( lightsClusters, clustersReadback.data(), sizeof( uint32_t ) * clustersReadback.size() )
+      || !renderDevice->readBuffer( itemList, itemListReadback.data(), sizeof( uint32_t ) * itemListReadback.size() ) ) {
+        NYA_CWARN << "Failed to read the light clusters back; CPU/GPU light culling comparison is disabled" << std::endl;
+        isClustersReadbackSupported = false;
+        return;
+    }
+
+    // Items order may differ between the CPU and GPU (compare sorted item lists)
+    std::vector<uint32_t> cpuItems;
+    std::vector<uint32_t> gpuItems;
+
+    uint32_t mismatchingClusterCount = 0u;
+    int firstMismatchingCluster = -1;
+    for ( int clusterIndex = 0; clusterIndex < CLUSTER_COUNT; clusterIndex++ ) {
+        const uint32_t packedCount = clustersCPU[clusterIndex * 2 + 1];
+        const uint32_t gpuItemListOffset = clustersReadback[clusterIndex * 2 + 0];
+
+        bool isMatching = ( packedCount == clustersReadback[clusterIndex * 2 + 1] );
+        if ( isMatching ) {
+            const uint32_t itemCount = ( packedCount >> 20 ) + ( ( packedCount >> 8 ) & 0xFFF ) + ( packedCount & 0xFF );
+            const uint32_t* clusterCpuItems = &itemListCPU[clustersCPU[clusterIndex * 2 + 0]];
+
+            isMatching = ( gpuItemListOffset + itemCount <= itemListReadback.size() );
+            if ( isMatching ) {
+                cpuItems.assign( clusterCpuItems, clusterCpuItems + itemCount );
+                gpuItems.assign( &itemListReadback[gpuItemListOffset], &itemListReadback[gpuItemListOffset] + itemCount );
+                std::sort( cpuItems.begin(), cpuItems.end() );
+                std::sort( gpuItems.begin(), gpuItems.end() );
+
+                isMatching = ( cpuItems == gpuItems );
+            }
+        }
+
+        if ( !isMatching ) {
+            mismatchingClusterCount++;
+
+            if ( firstMismatchingCluster < 0 ) {
+                firstMismatchingCluster = clusterIndex;
+            }
+        }
+    }
+
+    NYA_PROFILE_STAT( "Light Grid CPU/GPU Mismatching Clusters", mismatchingClusterCount )
+
+    if ( mismatchingClusterCount > 0u ) {
+        NYA_CWARN << mismatchingClusterCount << " light cluster(s) differ between the CPU and GPU light culling (first cluster: " << firstMismatchingCluster << ")" << std::endl;
+    }
+}
+#endif
+
+size_t LightGrid::uploadModifiedLights( CommandList& cmdList, Buffer* lightsBuffer, Buffer* pointLightsBuffer, Buffer* iblProbesBuffer )
+{
+    size_t uploadSize = 0;
+
+    if ( isLightsBufferDirty ) {
+        cmdList.updateBuffer( lightsBuffer, &uploadedLights, sizeof( LightsBuffer ) );
+        uploadSize += sizeof( LightsBuffer );
+
+        isLightsBufferDirty = false;
+    }
+
+    for ( const DirtyRange& range : dirtyPointLightRanges ) {
+        const size_t rangeSize = sizeof( PointLightData ) * range.Count;
+        cmdList.updateBufferRange( pointLightsBuffer, &pointLightUploadBuffer[range.First], rangeSize, sizeof( PointLightData ) * range.First );
+        uploadSize += rangeSize;
+    }
+    dirtyPointLightRanges.clear();
+
+    for ( const DirtyRange& range : dirtyIBLProbeRanges ) {
+        const size_t rangeSize = sizeof( IBLProbeData ) * range.Count;
+        cmdList.updateBufferRange( iblProbesBuffer, &uploadedIBLProbes[range.First], rangeSize, sizeof( IBLProbeData ) * range.First );
+        uploadSize += rangeSize;
+    }
+    dirtyIBLProbeRanges.clear();
+
+    uploadedBytesThisFrame += uploadSize;
+    NYA_PROFILE_STAT( "Light Grid Uploaded Bytes", uploadedBytesThisFrame )
+
+    return uploadSize;
+}
+
+const uint32_t* LightGrid::getClustersCPU() const
+{
+    return clustersCPU;
+}
+
+const uint32_t* LightGrid::getItemListCPU() const
+{
+    return itemListCPU;
 }
 
 void LightGrid::updateClustersInfos()
@@ -207,3 +822,137 @@ void LightGrid::updateClustersInfos()
     sceneInfosBuffer.ClustersInverseScale = 1.0f / sceneInfosBuffer.ClustersScale;
     sceneInfosBuffer.ClustersBias = -sceneInfosBuffer.ClustersScale * sceneInfosBuffer.SceneAABBMin;
 }
+
+void LightGrid::updateLightBuffers( const FrameLights& frameLights )
+{
+    if ( renderDevice != nullptr && renderDevice->getFrameIndex() != uploadFrameIndex ) {
+        uploadFrameIndex = renderDevice->getFrameIndex();
+        uploadedBytesThisFrame = 0;
+
+        NYA_PROFILE_STAT( "Light Grid Uploaded Bytes", 0 )
+    }
+
+    const uint32_t framePointLightCount = static_cast<uint32_t>( frameLights.PointLights.size() );
+    if ( framePointLightCount > pointLightUploadCapacity ) {
+        resizePointLightBuffers( RoundToNextPowerOfTwo( framePointLightCount ) );
+    }
+
+    // Diff point lights against the uploaded copy (the spatial index is rebuilt if lights have been added/removed and refitted otherwise)
+    const bool rebuildPointLightIndex = ( framePointLightCount != pointLightSpatialIndex.getEntityCount() );
+    bool arePointLightsModified = false;
+    for ( uint32_t i = 0u; i < framePointLightCount; i++ ) {
+        const PointLightData& light = frameLights.PointLights[i];
+        PointLightData& uploadedLight = pointLightUploadBuffer[i];
+
+        if ( i < uploadedPointLightCount && memcmp( &light, &uploadedLight, sizeof( PointLightData ) ) == 0 ) {
+            continue;
+        }
+
+        uploadedLight = light;
+        MarkDirtyRange( dirtyPointLightRanges, i );
+
+        if ( !rebuildPointLightIndex ) {
+            pointLightSpatialIndex.updateEntity( i, light.worldPosition, light.radius );
+            pointLightCullingEntities.update( i, light.worldPosition, light.radius );
+            arePointLightsModified = true;
+        }
+    }
+    uploadedPointLightCount = framePointLightCount;
+
+    // NOTE CPU culling entities are stored in the same order as the spatial index entities
+    if ( rebuildPointLightIndex ) {
+        pointLightSpatialIndex.clear();
+        pointLightCullingEntities.clear();
+        for ( uint32_t i = 0u; i < framePointLightCount; i++ ) {
+            pointLightSpatialIndex.addEntity( pointLightUploadBuffer[i].worldPosition, pointLightUploadBuffer[i].radius );
+            pointLightCullingEntities.add( pointLightUploadBuffer[i].worldPosition, pointLightUploadBuffer[i].radius, i );
+        }
+        pointLightSpatialIndex.build();
+    } else if ( arePointLightsModified ) {
+        pointLightSpatialIndex.refit();
+    }
+
+    areClustersCPUDirty |= ( rebuildPointLightIndex || arePointLightsModified );
+
+    // Diff probes (global probe included)
+    const uint32_t iblProbeCount = ( 1u + frameLights.Lights.LocalIBLProbeCount );
+    bool areLocalIBLProbesModified = ( iblProbeCount != uploadedIBLProbeCount );
+    for ( uint32_t i = 0u; i < iblProbeCount; i++ ) {
+        IBLProbeData probe = frameLights.IBLProbes[i];
+        applyProbeIrradiance( i, probe );
+
+        if ( i < uploadedIBLProbeCount && memcmp( &probe, &uploadedIBLProbes[i], sizeof( IBLProbeData ) ) == 0 ) {
+            continue;
+        }
+
+        uploadedIBLProbes[i] = probe;
+        MarkDirtyRange( dirtyIBLProbeRanges, i );
+        areLocalIBLProbesModified |= ( i != 0u );
+    }
+    uploadedIBLProbeCount = iblProbeCount;
+
+    // NOTE Probe indexes are local (the global IBL probe is not culled)
+    if ( areLocalIBLProbesModified ) {
+        localIBLProbeSpatialIndex.clear();
+        localIBLProbeCullingEntities.clear();
+        for ( uint32_t i = 1u; i < iblProbeCount; i++ ) {
+            localIBLProbeSpatialIndex.addEntity( uploadedIBLProbes[i].worldPosition, uploadedIBLProbes[i].radius );
+            localIBLProbeCullingEntities.add( uploadedIBLProbes[i].worldPosition, uploadedIBLProbes[i].radius, i - 1u );
+        }
+        localIBLProbeSpatialIndex.build();
+
+        areClustersCPUDirty = true;
+    }
+
+    if ( memcmp( &frameLights.Lights, &uploadedLights, sizeof( LightsBuffer ) ) != 0 ) {
+        uploadedLights = frameLights.Lights;
+        isLightsBufferDirty = true;
+    }
+
+    NYA_PROFILE_STAT( "Point Lights", framePointLightCount )
+    NYA_PROFILE_STAT( "Point Lights Spatial Index Nodes", pointLightSpatialIndex.getNodeCount() )
+}
+
+void LightGrid::applyProbeIrradiance( const uint32_t probeArrayIndex, IBLProbeData& probe ) const
+{
+    const ProbeIrradiance& probeIrradiance = iblProbeIrradiances[probeArrayIndex];
+
+    probe.hasIrradianceSH = probeIrradiance.HasIrradianceSH;
+    if ( probeIrradiance.HasIrradianceSH ) {
+        memcpy( probe.irradianceSH, probeIrradiance.IrradianceSH, sizeof( probe.irradianceSH ) );
+    }
+}
+
+void LightGrid::resizePointLightBuffers( const uint32_t capacity )
+{
+    PointLightData* resizedUploadBuffer = nya::core::allocateArray<PointLightData>( memoryAllocator, capacity );
+
+    if ( pointLightUploadBuffer != nullptr ) {
+        memcpy( resizedUploadBuffer, pointLightUploadBuffer, sizeof( PointLightData ) * uploadedPointLightCount );
+        nya::core::freeArray( memoryAllocator, pointLightUploadBuffer );
+    }
+
+    pointLightUploadBuffer = resizedUploadBuffer;
+    pointLightUploadCapacity = capacity;
+
+    // The GPU buffer can't be created until the grid has a device (see loadCachedResources)
+    if ( renderDevice == nullptr ) {
+        return;
+    }
+
+    if ( pointLightsGpuBuffer != nullptr ) {
+        renderDevice->destroyBuffer( pointLightsGpuBuffer );
+    }
+
+    BufferDesc pointLightsBufferDesc = {};
+    pointLightsBufferDesc.type = BufferDesc::UNORDERED_ACCESS_VIEW_BUFFER;
+    pointLightsBufferDesc.viewFormat = eImageFormat::IMAGE_FORMAT_R32G32B32A32_UINT;
+    pointLightsBufferDesc.size = sizeof( PointLightData ) * capacity;
+    pointLightsBufferDesc.stride = capacity * POINT_LIGHT_VECTOR_COUNT;
+
+    pointLightsGpuBuffer = renderDevice->createBuffer( pointLightsBufferDesc );
+
+    // Previous content is lost; upload every light again
+    uploadedPointLightCount = 0u;
+    dirtyPointLightRanges.clear();
+}
@@ -32,10 +32,23 @@ class RenderPipeline;
 class ShaderCache;
 class GraphicsAssetCache;
 
+struct AABB;
+struct Frustum;
+
 #include <Framework/Light.h>
 #include <Shaders/Shared.h>
 #include <Maths/Vector.h>
 
+#include "LightSpatialIndex.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Point lights are allocated per page so that the pointers handed to the scene stay valid when the grid grows
+static constexpr uint32_t LIGHT_GRID_POINT_LIGHT_PAGE_SIZE = 256u;
+
 class LightGrid
 {
 public:
@@ -52,17 +65,99 @@ public:
         uint32_t __PADDING5__;
     };
     
+    struct LightsBuffer {
+        DirectionalLightData    DirectionalLight;
+        uint32_t                PointLightCount;
+        uint32_t                LocalIBLProbeCount;
+        uint32_t                __PADDING__[2];
+    };
+
     struct PassData {
         ResHandle_t lightsClusters;
         ResHandle_t lightsClustersInfosBuffer;
-        ResHandle_t lightsBuffer;
         ResHandle_t itemList;
+
+        // Persistent buffers handles (use RenderPipelineResources::getPersistentBuffer)
+        ResHandle_t lightsBuffer;
+        ResHandle_t pointLightsBuffer;
+        ResHandle_t iblProbesBuffer;
+    };
+
+    struct DirtyRange {
+        uint32_t    First;
+        uint32_t    Count;
+    };
+
+    // Culled entities (lights or probes) stored as a structure of arrays so that they can be tested 4 at a time
+    struct ClusterCullingSoA {
+        std::vector<float>      positionX;
+        std::vector<float>      positionY;
+        std::vector<float>      positionZ;
+        std::vector<float>      radius;
+        std::vector<uint32_t>   index;
+        uint32_t                count;
+
+        void clear()
+        {
+            positionX.clear();
+            positionY.clear();
+            positionZ.clear();
+            radius.clear();
+            index.clear();
+            count = 0u;
+        }
+
+        void add( const nyaVec3f& position, const float entityRadius, const uint32_t entityIndex )
+        {
+            positionX.push_back( position.x );
+            positionY.push_back( position.y );
+            positionZ.push_back( position.z );
+            radius.push_back( entityRadius );
+            index.push_back( entityIndex );
+            count++;
+        }
+
+        void update( const uint32_t entityIndex, const nyaVec3f& position, const float entityRadius )
+        {
+            positionX[entityIndex] = position.x;
+            positionY[entityIndex] = position.y;
+            positionZ[entityIndex] = position.z;
+            radius[entityIndex] = entityRadius;
+        }
+
+        // Pad with zero radius entities (which can't intersect anything) up to a multiple of 4
+        void pad()
+        {
+            while ( ( positionX.size() & 3 ) != 0 ) {
+                positionX.push_back( 0.0f );
+                positionY.push_back( 0.0f );
+                positionZ.push_back( 0.0f );
+                radius.push_back( 0.0f );
+                index.push_back( ~0u );
+            }
+        }
+    };
+
+    // Per thread storage of the CPU light culling
+    struct ClusterCullingScratch {
+        ClusterCullingSoA       SlicePointLights;
+        ClusterCullingSoA       SliceIBLProbes;
+        std::vector<uint32_t>   QueryResults;
+    };
+
+    // Copy of the lights submitted for a frame (see FramePacket)
+    struct FrameLights {
+        LightsBuffer                    Lights;
+        nyaVec3f                        SceneAABBMin;
+        nyaVec3f                        SceneAABBMax;
+        std::vector<PointLightData>     PointLights;
+        IBLProbeData                    IBLProbes[MAX_IBL_PROBE_COUNT];
     };
 
 public:
                                     LightGrid( BaseAllocator* allocator );
-                                    LightGrid( LightGrid& ) = default;
-                                    LightGrid& operator = ( LightGrid& ) = default;
+                                    LightGrid( LightGrid& ) = delete;
+                                    LightGrid& operator = ( LightGrid& ) = delete;
                                     ~LightGrid();
 
     void                            destroy( RenderDevice* renderDevice );
@@ -70,32 +165,145 @@ public:
     PassData                        updateClusters( RenderPipeline* renderPipeline );
     void                            loadCachedResources( RenderDevice* renderDevice, ShaderCache* shaderCache, GraphicsAssetCache* graphicsAssetCache );
 
+    // Game side: lights are written by the scene through the returned pointers and copied to a frame packet once the frame is submitted
     void                            setSceneBounds( const nyaVec3f& aabbMax, const nyaVec3f& aabbMin );
   
     PointLightData*                 allocatePointLightData( const PointLightData&& lightData );
+
+    // Released slots are recycled by the next allocations (the light is no longer submitted once released)
+    void                            releasePointLightData( PointLightData* lightData );
     IBLProbeData*                   allocateLocalIBLProbeData( const IBLProbeData&& probeData );
 
     DirectionalLightData*           updateDirectionalLightData( const DirectionalLightData&& lightData );
     IBLProbeData*                   updateGlobalIBLProbeData( const IBLProbeData&& probeData );
 
+    void                            captureFrameLights( FrameLights& frameLights ) const;
+
+    // Render side: diff the lights of a frame against the uploaded lights
+    // The accessors below read the lights of the last frame set (pointers stay valid until the next call)
+    void                            setFrameLights( const FrameLights& frameLights );
+
     const DirectionalLightData*     getDirectionalLightData() const;
     const IBLProbeData*             getGlobalIBLProbeData() const;
+    const IBLProbeData*             getIBLProbeData( const uint32_t probeArrayIndex ) const;
+
+    uint32_t                        getPointLightCount() const;
+    const PointLightData*           getPointLightData( const uint32_t lightIndex ) const;
+    uint32_t                        getLocalIBLProbeCount() const;
+
+    // Project the given cubemap (linear RGBA float faces; D3D face order) to SH9 irradiance and use it for the probe diffuse lighting
+    // probeArrayIndex is the probe array index (IBLProbeData::ProbeIndex; 0 is the global probe)
+    void                            setIBLProbeIrradianceFromCubemap( const uint32_t probeArrayIndex, const float* const faceTexels[6], const uint32_t faceSize );
+
+    // Fallback to the convoluted diffuse cubemap for the probe diffuse lighting
+    void                            clearIBLProbeIrradianceSH( const uint32_t probeArrayIndex );
+
+    // Append the index of each light/local probe intersecting the given volume (probe indexes are local; the global probe is never returned)
+    // NOTE The spatial index is rebuilt when the lights are modified (on the next cluster update)
+    // The index only serves these queries and the CPU cluster build; the GPU culling pass still tests every light per cluster
+    void                            queryPointLights( const AABB& aabb, std::vector<uint32_t>& lightIndexes ) const;
+    void                            queryPointLights( const Frustum& frustum, std::vector<uint32_t>& lightIndexes ) const;
+    void                            queryLocalIBLProbes( const AABB& aabb, std::vector<uint32_t>& probeIndexes ) const;
+    void                            queryLocalIBLProbes( const Frustum& frustum, std::vector<uint32_t>& probeIndexes ) const;
+
+    // CPU implementation of the light culling pass (Lighting/LightCulling); outputs the same layout as the compute shader
+    // (one uint2 per cluster (item list offset, packed entity count) and MAX_CLUSTER_ITEM_COUNT items per cluster)
+    // Clusters are only rebuilt if the lights (or the scene bounds) have changed since the last build
+    void                            buildClustersCPU();
+    const uint32_t*                 getClustersCPU() const;
+    const uint32_t*                 getItemListCPU() const;
+
+    // Record the upload of the lights modified since the last upload (nothing is uploaded if the lights haven't changed)
+    // Returns the uploaded size (in bytes)
+    size_t                          uploadModifiedLights( CommandList& cmdList, Buffer* lightsBuffer, Buffer* pointLightsBuffer, Buffer* iblProbesBuffer );
 
 private:
     BaseAllocator*                  memoryAllocator;
+    RenderDevice*                   renderDevice;
 
     PipelineState*                  lightCullingPso;
     SceneInfosBuffer                sceneInfosBuffer;
 
+    // Game side lights
     uint32_t                        pointLightCount;
     uint32_t                        localIBLProbeCount;
 
-    struct {
-        PointLightData              PointLights[MAX_POINT_LIGHT_COUNT];
-        IBLProbeData                IBLProbes[MAX_IBL_PROBE_COUNT];
-        DirectionalLightData        DirectionalLight;
-    } lights;
+    LightsBuffer                    lights;
+    std::vector<PointLightData*>    pointLightPages;
+    std::vector<uint32_t>           freePointLightSlots;
+    std::vector<uint8_t>            isPointLightSlotFree;
+    IBLProbeData                    iblProbes[MAX_IBL_PROBE_COUNT];
+    nyaVec3f                        sceneAABBMin;
+    nyaVec3f                        sceneAABBMax;
+
+    // SH irradiance computed on the render side (overrides the irradiance of the submitted probes)
+    struct ProbeIrradiance {
+        nyaVec4f                    IrradianceSH[9];
+        bool                        HasIrradianceSH;
+    };
+
+    ProbeIrradiance                 iblProbeIrradiances[MAX_IBL_PROBE_COUNT];
+
+    // Persistent GPU buffers (only the ranges modified since the last upload are uploaded)
+    Buffer*                         lightsGpuBuffer;
+    Buffer*                         pointLightsGpuBuffer;
+    Buffer*                         iblProbesGpuBuffer;
+
+    // Render side: CPU mirror of the GPU buffers content (contiguous; diffed against the frame lights to find the modified lights)
+    PointLightData*                 pointLightUploadBuffer;
+    uint32_t                        pointLightUploadCapacity;
+    uint32_t                        uploadedPointLightCount;
+    IBLProbeData                    uploadedIBLProbes[MAX_IBL_PROBE_COUNT];
+    uint32_t                        uploadedIBLProbeCount;
+    LightsBuffer                    uploadedLights;
+
+    // Ranges waiting for the next light culling pass
+    std::vector<DirtyRange>         dirtyPointLightRanges;
+    std::vector<DirtyRange>         dirtyIBLProbeRanges;
+    bool                            isLightsBufferDirty;
+
+    size_t                          uploadFrameIndex;
+    size_t                          uploadedBytesThisFrame;
+
+    LightSpatialIndex               pointLightSpatialIndex;
+    LightSpatialIndex               localIBLProbeSpatialIndex;
+
+    // CPU light culling input (gathered when the frame lights are set) and output (allocated on the first CPU build)
+    ClusterCullingSoA               pointLightCullingEntities;
+    ClusterCullingSoA               localIBLProbeCullingEntities;
+    bool                            areClustersCPUDirty;
+    uint32_t*                       clustersCPU;
+    uint32_t*                       itemListCPU;
+
+    // Persistent CPU light culling workers (Z slices are interleaved between the calling thread and the workers)
+    // Workers are parked until a build is requested; scratches are indexed by slice set (0 is the calling thread)
+    std::vector<ClusterCullingScratch>  clusterCullingScratches;
+    std::vector<std::thread>        clusterWorkers;
+    std::mutex                      clusterWorkersLock;
+    std::condition_variable         clusterBuildRequestedEvent;
+    std::condition_variable         clusterBuildCompletedEvent;
+    uint32_t                        clusterBuildIndex;
+    uint32_t                        pendingClusterWorkerCount;
+    bool                            isClusterWorkersShutdownRequested;
+
+#if NYA_DEVBUILD
+    // GPU light clusters read back for the comparison with the CPU light culling
+    std::vector<uint32_t>           clustersReadback;
+    std::vector<uint32_t>           itemListReadback;
+    bool                            isClustersReadbackSupported;
+#endif
 
 private:
+    void                            createClusterWorkers( const uint32_t sliceSetCount );
+    void                            destroyClusterWorkers();
+    void                            clusterWorkerLoop( const uint32_t sliceSetIndex, uint32_t lastBuildIndex );
+
+#if NYA_DEVBUILD
+    void                            compareClustersWithGPU( RenderDevice* renderDevice, Buffer* lightsClusters, Buffer* itemList );
+#endif
+
     void                            updateClustersInfos();
+    void                            updateLightBuffers( const FrameLights& frameLights );
+    void                            applyProbeIrradiance( const uint32_t probeArrayIndex, IBLProbeData& probe ) const;
+    void                            resizePointLightBuffers( const uint32_t capacity );
 };
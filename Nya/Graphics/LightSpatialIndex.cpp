@@ -0,0 +1,271 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "LightSpatialIndex.h"
+
+#include <Maths/Frustum.h>
+#include <Maths/Helpers.h>
+
+#include <algorithm>
+
+// Max depth of a median split hierarchy is log2(entity count) (64 is way more than enough)
+static constexpr uint32_t MAX_TRAVERSAL_DEPTH = 64u;
+
+static bool SphereAABBIntersectionTest( const BoundingSphere& sphere, const AABB& aabb )
+{
+    const nyaVec3f closestPoint = nyaVec3f::min( nyaVec3f::max( sphere.center, aabb.minPoint ), aabb.maxPoint );
+    const nyaVec3f distance = ( sphere.center - closestPoint );
+
+    return nyaVec3f::dot( distance, distance ) <= ( sphere.radius * sphere.radius );
+}
+
+static bool AABBAABBIntersectionTest( const AABB& left, const AABB& right )
+{
+    return left.minPoint.x <= right.maxPoint.x && left.maxPoint.x >= right.minPoint.x
+        && left.minPoint.y <= right.maxPoint.y && left.maxPoint.y >= right.minPoint.y
+        && left.minPoint.z <= right.maxPoint.z && left.maxPoint.z >= right.minPoint.z;
+}
+
+// NOTE Frustum planes point inside the frustum
+static bool SphereFrustumIntersectionTest( const BoundingSphere& sphere, const Frustum& frustum )
+{
+    for ( int i = 0; i < 6; i++ ) {
+        const nyaVec4f& plane = frustum.planes[i];
+
+        if ( ( plane.x * sphere.center.x + plane.y * sphere.center.y + plane.z * sphere.center.z + plane.w ) < -sphere.radius ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool AABBFrustumIntersectionTest( const AABB& aabb, const Frustum& frustum )
+{
+    for ( int i = 0; i < 6; i++ ) {
+        const nyaVec4f& plane = frustum.planes[i];
+
+        // Test the corner the furthest along the plane normal
+        const nyaVec3f positiveVertex = nyaVec3f(
+            ( plane.x >= 0.0f ) ? aabb.maxPoint.x : aabb.minPoint.x,
+            ( plane.y >= 0.0f ) ? aabb.maxPoint.y : aabb.minPoint.y,
+            ( plane.z >= 0.0f ) ? aabb.maxPoint.z : aabb.minPoint.z );
+
+        if ( ( plane.x * positiveVertex.x + plane.y * positiveVertex.y + plane.z * positiveVertex.z + plane.w ) < 0.0f ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+LightSpatialIndex::LightSpatialIndex()
+{
+
+}
+
+LightSpatialIndex::~LightSpatialIndex()
+{
+    clear();
+}
+
+void LightSpatialIndex::clear()
+{
+    spheres.clear();
+    entityIndexes.clear();
+    nodes.clear();
+}
+
+void LightSpatialIndex::addEntity( const nyaVec3f& center, const float radius )
+{
+    spheres.push_back( { center, radius } );
+}
+
+void LightSpatialIndex::build()
+{
+    const uint32_t entityCount = static_cast<uint32_t>( spheres.size() );
+
+    entityIndexes.resize( entityCount );
+    for ( uint32_t i = 0u; i < entityCount; i++ ) {
+        entityIndexes[i] = i;
+    }
+
+    nodes.clear();
+    nodes.reserve( ( entityCount / MAX_LEAF_ENTITY_COUNT + 1u ) * 2u );
+
+    if ( entityCount != 0u ) {
+        buildNode( 0u, entityCount );
+    }
+}
+
+void LightSpatialIndex::updateEntity( const uint32_t entityIndex, const nyaVec3f& center, const float radius )
+{
+    spheres[entityIndex] = { center, radius };
+}
+
+void LightSpatialIndex::refit()
+{
+    // Nodes are stored in depth first order (children are always stored after their parent)
+    for ( size_t nodeIdx = nodes.size(); nodeIdx-- > 0; ) {
+        Node& node = nodes[nodeIdx];
+
+        if ( node.EntityCount == 0u ) {
+            node.Bounds = nodes[nodeIdx + 1].Bounds;
+            nya::maths::ExpandAABB( node.Bounds, nodes[node.FirstEntity].Bounds );
+            continue;
+        }
+
+        const BoundingSphere& firstSphere = spheres[entityIndexes[node.FirstEntity]];
+        nya::maths::CreateAABB( node.Bounds, firstSphere.center, nyaVec3f( firstSphere.radius ) );
+
+        for ( uint32_t i = 1u; i < node.EntityCount; i++ ) {
+            nya::maths::ExpandAABB( node.Bounds, spheres[entityIndexes[node.FirstEntity + i]] );
+        }
+    }
+}
+
+void LightSpatialIndex::query( const AABB& aabb, std::vector<uint32_t>& entities ) const
+{
+    if ( nodes.empty() ) {
+        return;
+    }
+
+    uint32_t stack[MAX_TRAVERSAL_DEPTH];
+    uint32_t stackSize = 0u;
+    stack[stackSize++] = 0u;
+
+    while ( stackSize != 0u ) {
+        const Node& node = nodes[stack[--stackSize]];
+
+        if ( !AABBAABBIntersectionTest( node.Bounds, aabb ) ) {
+            continue;
+        }
+
+        if ( node.EntityCount == 0u ) {
+            const uint32_t nodeIndex = static_cast<uint32_t>( &node - nodes.data() );
+
+            stack[stackSize++] = node.FirstEntity;
+            stack[stackSize++] = nodeIndex + 1u;
+            continue;
+        }
+
+        for ( uint32_t i = 0u; i < node.EntityCount; i++ ) {
+            const uint32_t entityIndex = entityIndexes[node.FirstEntity + i];
+
+            if ( SphereAABBIntersectionTest( spheres[entityIndex], aabb ) ) {
+                entities.push_back( entityIndex );
+            }
+        }
+    }
+}
+
+void LightSpatialIndex::query( const Frustum& frustum, std::vector<uint32_t>& entities ) const
+{
+    if ( nodes.empty() ) {
+        return;
+    }
+
+    uint32_t stack[MAX_TRAVERSAL_DEPTH];
+    uint32_t stackSize = 0u;
+    stack[stackSize++] = 0u;
+
+    while ( stackSize != 0u ) {
+        const Node& node = nodes[stack[--stackSize]];
+
+        if ( !AABBFrustumIntersectionTest( node.Bounds, frustum ) ) {
+            continue;
+        }
+
+        if ( node.EntityCount == 0u ) {
+            const uint32_t nodeIndex = static_cast<uint32_t>( &node - nodes.data() );
+
+            stack[stackSize++] = node.FirstEntity;
+            stack[stackSize++] = nodeIndex + 1u;
+            continue;
+        }
+
+        for ( uint32_t i = 0u; i < node.EntityCount; i++ ) {
+            const uint32_t entityIndex = entityIndexes[node.FirstEntity + i];
+
+            if ( SphereFrustumIntersectionTest( spheres[entityIndex], frustum ) ) {
+                entities.push_back( entityIndex );
+            }
+        }
+    }
+}
+
+uint32_t LightSpatialIndex::getEntityCount() const
+{
+    return static_cast<uint32_t>( spheres.size() );
+}
+
+uint32_t LightSpatialIndex::getNodeCount() const
+{
+    return static_cast<uint32_t>( nodes.size() );
+}
+
+uint32_t LightSpatialIndex::buildNode( const uint32_t firstEntity, const uint32_t entityCount )
+{
+    const uint32_t nodeIndex = static_cast<uint32_t>( nodes.size() );
+    nodes.push_back( {} );
+
+    // Compute node bounds (and the bounds of the sphere centers to pick the split axis)
+    const BoundingSphere& firstSphere = spheres[entityIndexes[firstEntity]];
+
+    AABB nodeBounds = {};
+    nya::maths::CreateAABB( nodeBounds, firstSphere.center, nyaVec3f( firstSphere.radius ) );
+
+    AABB centroidBounds = {};
+    nya::maths::CreateAABBFromMinMaxPoints( centroidBounds, firstSphere.center, firstSphere.center );
+
+    for ( uint32_t i = 1u; i < entityCount; i++ ) {
+        const BoundingSphere& sphere = spheres[entityIndexes[firstEntity + i]];
+
+        nya::maths::ExpandAABB( nodeBounds, sphere );
+        nya::maths::ExpandAABB( centroidBounds, sphere.center );
+    }
+
+    nodes[nodeIndex].Bounds = nodeBounds;
+
+    if ( entityCount <= MAX_LEAF_ENTITY_COUNT ) {
+        nodes[nodeIndex].FirstEntity = firstEntity;
+        nodes[nodeIndex].EntityCount = entityCount;
+
+        return nodeIndex;
+    }
+
+    // Median split along the largest axis
+    const uint32_t splitAxis = nya::maths::GetMaxDimensionAxisAABB( centroidBounds );
+    const uint32_t leftEntityCount = ( entityCount / 2u );
+
+    uint32_t* entityBegin = entityIndexes.data() + firstEntity;
+    std::nth_element( entityBegin, entityBegin + leftEntityCount, entityBegin + entityCount, [&]( const uint32_t left, const uint32_t right ) {
+        return spheres[left].center[splitAxis] < spheres[right].center[splitAxis];
+    } );
+
+    buildNode( firstEntity, leftEntityCount );
+    const uint32_t rightChildIndex = buildNode( firstEntity + leftEntityCount, entityCount - leftEntityCount );
+
+    // NOTE nodes might have been reallocated during the recursion
+    nodes[nodeIndex].FirstEntity = rightChildIndex;
+    nodes[nodeIndex].EntityCount = 0u;
+
+    return nodeIndex;
+}
@@ -0,0 +1,75 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <Maths/AABB.h>
+#include <Maths/BoundingSphere.h>
+
+#include <vector>
+
+struct Frustum;
+
+// Bounding volume hierarchy of light spheres (point lights, IBL probes, ...)
+// The hierarchy is built from scratch (median split on the largest axis) when entities are added/removed and
+// refitted when entities are only moved. Queries return entity indexes (in insertion order) and are thread safe
+// (as long as the index is not modified)
+// NOTE The hierarchy lives on the CPU only (LightGrid CPU cluster build and light queries); it is not uploaded to the GPU
+class LightSpatialIndex
+{
+public:
+    static constexpr uint32_t   MAX_LEAF_ENTITY_COUNT = 4u;
+
+public:
+                                LightSpatialIndex();
+                                LightSpatialIndex( LightSpatialIndex& ) = delete;
+                                LightSpatialIndex& operator = ( LightSpatialIndex& ) = delete;
+                                ~LightSpatialIndex();
+
+    void                        clear();
+    void                        addEntity( const nyaVec3f& center, const float radius );
+    void                        build();
+
+    // Update an existing entity; call refit() once every modified entity has been updated
+    void                        updateEntity( const uint32_t entityIndex, const nyaVec3f& center, const float radius );
+    void                        refit();
+
+    // Append the index of each entity intersecting the given volume
+    void                        query( const AABB& aabb, std::vector<uint32_t>& entities ) const;
+    void                        query( const Frustum& frustum, std::vector<uint32_t>& entities ) const;
+
+    uint32_t                    getEntityCount() const;
+    uint32_t                    getNodeCount() const;
+
+private:
+    // Interior nodes store their left child right after them (EntityCount == 0)
+    struct Node {
+        AABB        Bounds;
+        uint32_t    FirstEntity; // Right child index for interior nodes
+        uint32_t    EntityCount;
+    };
+
+private:
+    std::vector<BoundingSphere> spheres;
+    std::vector<uint32_t>       entityIndexes;
+    std::vector<Node>           nodes;
+
+private:
+    uint32_t                    buildNode( const uint32_t firstEntity, const uint32_t entityCount );
+};
@@ -28,38 +28,51 @@
 #include <Rendering/CommandList.h>
 #include <Rendering/ImageFormat.h>
 
-#include <Maths/MatrixTransformations.h>
-
-#include <string.h>
+#include <Maths/AABB.h>
+#include <Maths/Packing.h>
 
 using namespace nya::rendering;
 
 LineRenderingModule::LineRenderingModule()
-    : indiceCount( 0 )
-    , vertexBufferIndex( 0 )
-    , lineVertexBuffers{ nullptr, nullptr }
-    , lineIndiceBuffer( nullptr )
-    , bufferIndex( 0 )
-    , buffer{ 0.0f }
+    : renderLinePso( nullptr )
+    , transientVertexBuffer( nullptr )
+    , transientBufferCapacity( 0 )
+    , uploadedTransientVertexCount( 0 )
+    , isTransientBufferDirty( false )
 {
-    memset( buffer, 0, sizeof( float ) * LINE_RENDERING_MAX_LINE_COUNT );
+    for ( StaticBatch& batch : staticBatches ) {
+        batch.VertexBuffer = nullptr;
+        batch.UploadedVertexCount = 0;
+        batch.IsAllocated = 0;
+        batch.IsVisible = 0;
+        batch.IsDirty = 0;
+        batch.IsPendingRelease = 0;
+    }
 }
 
 LineRenderingModule::~LineRenderingModule()
 {
-    indiceCount = 0;
-    vertexBufferIndex = 0;
+    transientVertices.clear();
+    transientLifetimes.clear();
 
-    bufferIndex = 0;
+    transientBufferCapacity = 0;
+    uploadedTransientVertexCount = 0;
+    isTransientBufferDirty = false;
 }
 
 void LineRenderingModule::destroy( RenderDevice* renderDevice )
 {
-    for ( int32_t i = 0; i < BUFFER_COUNT; i++ ) {
-        renderDevice->destroyBuffer( lineVertexBuffers[i] );
+    renderDevice->destroyBuffer( transientVertexBuffer );
+    transientVertexBuffer = nullptr;
+
+    for ( StaticBatch& batch : staticBatches ) {
+        if ( batch.VertexBuffer != nullptr ) {
+            renderDevice->destroyBuffer( batch.VertexBuffer );
+            batch.VertexBuffer = nullptr;
+        }
     }
 
-    renderDevice->destroyBuffer( lineIndiceBuffer );
+    renderDevice->destroyPipelineState( renderLinePso );
 }
 
 ResHandle_t LineRenderingModule::addLineRenderPass( RenderPipeline* renderPipeline, ResHandle_t output )
@@ -67,7 +80,7 @@ ResHandle_t LineRenderingModule::addLineRenderPass( RenderPipeline* renderPipeli
     struct PassData {
         MutableResHandle_t  output;
 
-        ResHandle_t         screenBuffer;
+        ResHandle_t         cameraBuffer;
     };
 
     PassData& data = renderPipeline->addRenderPass<PassData>(
@@ -78,11 +91,11 @@ ResHandle_t LineRenderingModule::addLineRenderPass( RenderPipeline* renderPipeli
             // Passthrough rendertarget
             passData.output = renderPipelineBuilder.readRenderTarget( output );
 
-            BufferDesc screenBufferDesc;
-            screenBufferDesc.type = BufferDesc::CONSTANT_BUFFER;
-            screenBufferDesc.size = sizeof( nyaMat4x4f );
+            BufferDesc cameraBufferDesc;
+            cameraBufferDesc.type = BufferDesc::CONSTANT_BUFFER;
+            cameraBufferDesc.size = sizeof( nyaMat4x4f );
 
-            passData.screenBuffer = renderPipelineBuilder.allocateBuffer( screenBufferDesc, SHADER_STAGE_VERTEX );
+            passData.cameraBuffer = renderPipelineBuilder.allocateBuffer( cameraBufferDesc, SHADER_STAGE_VERTEX );
         },
         [=]( const PassData& passData, const RenderPipelineResources& renderPipelineResources, RenderDevice* renderDevice ) {
             // Render Pass
@@ -91,7 +104,7 @@ ResHandle_t LineRenderingModule::addLineRenderPass( RenderPipeline* renderPipeli
             RenderPass renderPass;
             renderPass.attachement[0] = { outputTarget, 0, 0 };
 
-            Buffer* screenBuffer = renderPipelineResources.getBuffer( passData.screenBuffer );
+            Buffer* cameraBuffer = renderPipelineResources.getBuffer( passData.cameraBuffer );
 
             const CameraData* cameraData = renderPipelineResources.getMainCamera();
 
@@ -103,10 +116,8 @@ ResHandle_t LineRenderingModule::addLineRenderPass( RenderPipeline* renderPipeli
             vp.MinDepth = 0.0f;
             vp.MaxDepth = 1.0f;
 
-            nyaMat4x4f orthoMatrix = nya::maths::MakeOrtho( 0.0f, cameraData->viewportSize.x, cameraData->viewportSize.y, 0.0f, -1.0f, 1.0f );
-
             ResourceList resourceList;
-            resourceList.resource[0].buffer = screenBuffer;
+            resourceList.resource[0].buffer = cameraBuffer;
             renderDevice->updateResourceList( renderLinePso, resourceList );
 
             CommandList& cmdList = renderDevice->allocateGraphicsCommandList();
@@ -115,18 +126,29 @@ ResHandle_t LineRenderingModule::addLineRenderPass( RenderPipeline* renderPipeli
 
                 cmdList.setViewport( vp );
 
-                cmdList.updateBuffer( screenBuffer, &orthoMatrix, sizeof( nyaMat4x4f ) );
-                cmdList.updateBuffer( lineVertexBuffers[vertexBufferIndex], buffer, static_cast<size_t>( bufferIndex ) * sizeof( float ) );
+                cmdList.updateBuffer( cameraBuffer, &cameraData->viewProjectionMatrix, sizeof( nyaMat4x4f ) );
+
+                // Upload new/modified geometry (static batches are only uploaded once)
+                updateGPUBuffers( renderDevice, cmdList );
 
                 // Pipeline State
                 cmdList.beginRenderPass( renderLinePso, renderPass );
                 {
-                    cmdList.bindVertexBuffer( lineVertexBuffers[vertexBufferIndex] );
-                    cmdList.bindIndiceBuffer( lineIndiceBuffer );
-
                     cmdList.bindPipelineState( renderLinePso );
 
-                    cmdList.draw( static_cast< unsigned int >( indiceCount ) );
+                    if ( uploadedTransientVertexCount != 0u ) {
+                        cmdList.bindVertexBuffer( transientVertexBuffer );
+                        cmdList.draw( uploadedTransientVertexCount );
+                    }
+
+                    for ( const StaticBatch& batch : staticBatches ) {
+                        if ( !batch.IsAllocated || !batch.IsVisible || batch.UploadedVertexCount == 0u ) {
+                            continue;
+                        }
+
+                        cmdList.bindVertexBuffer( batch.VertexBuffer );
+                        cmdList.draw( batch.UploadedVertexCount );
+                    }
                 }
                 cmdList.endRenderPass();
 
@@ -134,13 +156,6 @@ ResHandle_t LineRenderingModule::addLineRenderPass( RenderPipeline* renderPipeli
             }
 
             renderDevice->submitCommandList( &cmdList );
-
-            // Swap buffers
-            vertexBufferIndex = ( vertexBufferIndex == 0 ) ? 1 : 0;
-
-            // Reset buffers
-            indiceCount = 0;
-            bufferIndex = 0;
         } 
     );
 
@@ -149,42 +164,6 @@ ResHandle_t LineRenderingModule::addLineRenderPass( RenderPipeline* renderPipeli
 
 void LineRenderingModule::loadCachedResources( RenderDevice* renderDevice, ShaderCache* shaderCache, GraphicsAssetCache* graphicsAssetCache )
 {
-    // Create static indice buffer
-    static constexpr int IndexStride = sizeof( uint32_t );
-
-    // Indices per line (2 triangles; 3 indices per triangle)
-    static constexpr int indexBufferSize = LINE_RENDERING_MAX_LINE_COUNT * 2 * sizeof( uint32_t );
-    static constexpr int indexBufferLength = indexBufferSize / IndexStride;
-
-    uint32_t indexBufferData[indexBufferLength];
-
-    for ( uint32_t c = 0; c < LINE_RENDERING_MAX_LINE_COUNT; c++ ) {
-        indexBufferData[c * 2] = c;
-        indexBufferData[( c * 2 ) + 1] = ( c + 1 );
-    }
-
-    BufferDesc indiceBufferDescription;
-    indiceBufferDescription.type = BufferDesc::INDICE_BUFFER;
-    indiceBufferDescription.size = indexBufferSize;
-
-    lineIndiceBuffer = renderDevice->createBuffer( indiceBufferDescription, indexBufferData );
-    
-    // Create dynamic vertex buffer
-    // 4 + 4
-    constexpr std::size_t SINGLE_VERTEX_SIZE = sizeof( float ) * 8;
-
-    // XYZW Position + RGBA Color (w/ 2 vertices per line)
-    constexpr std::size_t VERTEX_BUFFER_SIZE = SINGLE_VERTEX_SIZE * LINE_RENDERING_MAX_LINE_COUNT * 2;
-
-    BufferDesc bufferDescription;
-    bufferDescription.type = BufferDesc::DYNAMIC_VERTEX_BUFFER;
-    bufferDescription.size = VERTEX_BUFFER_SIZE;
-    bufferDescription.stride = SINGLE_VERTEX_SIZE;
-
-    for ( int32_t i = 0; i < BUFFER_COUNT; i++ ) {
-        lineVertexBuffers[i] = renderDevice->createBuffer( bufferDescription );
-    }
-
     PipelineStateDesc pipelineState = {};
     pipelineState.vertexShader = shaderCache->getOrUploadStage( "LineRendering", eShaderStage::SHADER_STAGE_VERTEX );
     pipelineState.pixelShader = shaderCache->getOrUploadStage( "LineRendering", eShaderStage::SHADER_STAGE_PIXEL );
@@ -210,8 +189,8 @@ void LineRenderingModule::loadCachedResources( RenderDevice* renderDevice, Shade
     pipelineState.depthStencilState.enableDepthWrite = false;
     pipelineState.depthStencilState.depthComparisonFunc = eComparisonFunction::COMPARISON_FUNCTION_ALWAYS;
 
-    pipelineState.inputLayout[0] = { 0, IMAGE_FORMAT_R32G32B32A32_FLOAT, 0, 0, 0, true, "POSITION" };
-    pipelineState.inputLayout[1] = { 0, IMAGE_FORMAT_R32G32B32A32_FLOAT, 0, 0, 0, true, "COLOR" };
+    pipelineState.inputLayout[0] = { 0, IMAGE_FORMAT_R32G32B32_FLOAT, 0, 0, 0, true, "POSITION" };
+    pipelineState.inputLayout[1] = { 0, IMAGE_FORMAT_R8G8B8A8_UNORM, 0, 0, 0, true, "COLOR" };
 
     pipelineState.renderPassLayout.attachements[0].stageBind = SHADER_STAGE_PIXEL;
     pipelineState.renderPassLayout.attachements[0].bindMode = RenderPassLayoutDesc::WRITE;
@@ -223,31 +202,284 @@ void LineRenderingModule::loadCachedResources( RenderDevice* renderDevice, Shade
     renderLinePso = renderDevice->createPipelineState( pipelineState );
 }
 
-void LineRenderingModule::addLine( const nyaVec3f& from, const nyaVec3f& to, const float thickness, const nyaVec4f& color )
+void LineRenderingModule::updateLifetimes( const float deltaTime )
+{
+    const size_t lineCount = transientLifetimes.size();
+
+    // Compact alive lines (keep submission order)
+    size_t aliveLineCount = 0;
+    for ( size_t lineIdx = 0; lineIdx < lineCount; lineIdx++ ) {
+        const float remainingLifetime = transientLifetimes[lineIdx] - deltaTime;
+
+        if ( remainingLifetime <= 0.0f ) {
+            continue;
+        }
+
+        transientLifetimes[aliveLineCount] = remainingLifetime;
+        transientVertices[aliveLineCount * 2] = transientVertices[lineIdx * 2];
+        transientVertices[aliveLineCount * 2 + 1] = transientVertices[lineIdx * 2 + 1];
+
+        aliveLineCount++;
+    }
+
+    if ( aliveLineCount != lineCount ) {
+        transientLifetimes.resize( aliveLineCount );
+        transientVertices.resize( aliveLineCount * 2 );
+
+        isTransientBufferDirty = true;
+    }
+}
+
+void LineRenderingModule::addLine( const nyaVec3f& from, const nyaVec3f& to, const nyaVec4f& color, const float lifetime )
+{
+    AppendLine( transientVertices, from, to, nya::maths::PackColorRGBA8( color ) );
+    transientLifetimes.push_back( lifetime );
+
+    isTransientBufferDirty = true;
+}
+
+void LineRenderingModule::addAABB( const AABB& aabb, const nyaVec4f& color, const float lifetime )
+{
+    AppendAABB( transientVertices, aabb, nya::maths::PackColorRGBA8( color ) );
+    transientLifetimes.resize( transientVertices.size() / 2, lifetime );
+
+    isTransientBufferDirty = true;
+}
+
+void LineRenderingModule::addSphere( const nyaVec3f& center, const float radius, const nyaVec4f& color, const float lifetime )
+{
+    AppendSphere( transientVertices, center, radius, nya::maths::PackColorRGBA8( color ) );
+    transientLifetimes.resize( transientVertices.size() / 2, lifetime );
+
+    isTransientBufferDirty = true;
+}
+
+LineBatchHandle_t LineRenderingModule::allocateStaticBatch()
+{
+    for ( LineBatchHandle_t batchIdx = 0; batchIdx < LINE_RENDERING_MAX_STATIC_BATCH_COUNT; batchIdx++ ) {
+        StaticBatch& batch = staticBatches[batchIdx];
+
+        if ( batch.IsAllocated || batch.IsPendingRelease ) {
+            continue;
+        }
+
+        batch.IsAllocated = 1;
+        batch.IsVisible = 1;
+        batch.IsDirty = 0;
+
+        return batchIdx;
+    }
+
+    NYA_CWARN << "Static line batch pool is full!" << std::endl;
+
+    return LINE_RENDERING_INVALID_BATCH_HANDLE;
+}
+
+void LineRenderingModule::releaseStaticBatch( const LineBatchHandle_t batchHandle )
+{
+    if ( batchHandle >= LINE_RENDERING_MAX_STATIC_BATCH_COUNT ) {
+        return;
+    }
+
+    StaticBatch& batch = staticBatches[batchHandle];
+
+    // GPU resources are released during the next render pass
+    batch.IsAllocated = 0;
+    batch.IsPendingRelease = 1;
+    batch.Vertices.clear();
+}
+
+void LineRenderingModule::setStaticBatchVisibility( const LineBatchHandle_t batchHandle, const bool isVisible )
+{
+    if ( batchHandle >= LINE_RENDERING_MAX_STATIC_BATCH_COUNT ) {
+        return;
+    }
+
+    staticBatches[batchHandle].IsVisible = ( isVisible ) ? 1 : 0;
+}
+
+void LineRenderingModule::clearStaticBatch( const LineBatchHandle_t batchHandle )
+{
+    if ( batchHandle >= LINE_RENDERING_MAX_STATIC_BATCH_COUNT || !staticBatches[batchHandle].IsAllocated ) {
+        return;
+    }
+
+    staticBatches[batchHandle].Vertices.clear();
+    staticBatches[batchHandle].IsDirty = 1;
+}
+
+void LineRenderingModule::addLine( const LineBatchHandle_t batchHandle, const nyaVec3f& from, const nyaVec3f& to, const nyaVec4f& color )
+{
+    if ( batchHandle >= LINE_RENDERING_MAX_STATIC_BATCH_COUNT || !staticBatches[batchHandle].IsAllocated ) {
+        return;
+    }
+
+    AppendLine( staticBatches[batchHandle].Vertices, from, to, nya::maths::PackColorRGBA8( color ) );
+    staticBatches[batchHandle].IsDirty = 1;
+}
+
+void LineRenderingModule::addAABB( const LineBatchHandle_t batchHandle, const AABB& aabb, const nyaVec4f& color )
+{
+    if ( batchHandle >= LINE_RENDERING_MAX_STATIC_BATCH_COUNT || !staticBatches[batchHandle].IsAllocated ) {
+        return;
+    }
+
+    AppendAABB( staticBatches[batchHandle].Vertices, aabb, nya::maths::PackColorRGBA8( color ) );
+    staticBatches[batchHandle].IsDirty = 1;
+}
+
+void LineRenderingModule::addSphere( const LineBatchHandle_t batchHandle, const nyaVec3f& center, const float radius, const nyaVec4f& color )
 {
-    if ( bufferIndex + 16 >= LINE_RENDERING_MAX_LINE_COUNT ) {
+    if ( batchHandle >= LINE_RENDERING_MAX_STATIC_BATCH_COUNT || !staticBatches[batchHandle].IsAllocated ) {
         return;
     }
 
-    buffer[bufferIndex++] = ( from.x );
-    buffer[bufferIndex++] = ( from.y );
-    buffer[bufferIndex++] = ( from.z );
-    buffer[bufferIndex++] = ( thickness );
+    AppendSphere( staticBatches[batchHandle].Vertices, center, radius, nya::maths::PackColorRGBA8( color ) );
+    staticBatches[batchHandle].IsDirty = 1;
+}
+
+void LineRenderingModule::addGrid( const LineBatchHandle_t batchHandle, const nyaVec3f& center, const float extent, const uint32_t cellCount, const nyaVec4f& color )
+{
+    if ( batchHandle >= LINE_RENDERING_MAX_STATIC_BATCH_COUNT || !staticBatches[batchHandle].IsAllocated || cellCount == 0u ) {
+        return;
+    }
+
+    std::vector<LineVertex>& vertices = staticBatches[batchHandle].Vertices;
+    const uint32_t packedColor = nya::maths::PackColorRGBA8( color );
+
+    const float cellSize = ( extent * 2.0f ) / static_cast<float>( cellCount );
+
+    for ( uint32_t lineIdx = 0; lineIdx <= cellCount; lineIdx++ ) {
+        const float offset = -extent + cellSize * static_cast<float>( lineIdx );
+
+        AppendLine( vertices, center + nyaVec3f( offset, 0.0f, -extent ), center + nyaVec3f( offset, 0.0f, extent ), packedColor );
+        AppendLine( vertices, center + nyaVec3f( -extent, 0.0f, offset ), center + nyaVec3f( extent, 0.0f, offset ), packedColor );
+    }
+
+    staticBatches[batchHandle].IsDirty = 1;
+}
+
+void LineRenderingModule::updateGPUBuffers( RenderDevice* renderDevice, CommandList& cmdList )
+{
+    uint32_t staticLineCount = 0u;
+
+    for ( StaticBatch& batch : staticBatches ) {
+        if ( batch.IsPendingRelease ) {
+            if ( batch.VertexBuffer != nullptr ) {
+                renderDevice->destroyBuffer( batch.VertexBuffer );
+                batch.VertexBuffer = nullptr;
+            }
+
+            batch.UploadedVertexCount = 0;
+            batch.IsPendingRelease = 0;
+            batch.IsDirty = 0;
+            continue;
+        }
+
+        if ( batch.IsDirty ) {
+            if ( batch.VertexBuffer != nullptr ) {
+                renderDevice->destroyBuffer( batch.VertexBuffer );
+                batch.VertexBuffer = nullptr;
+            }
+
+            batch.UploadedVertexCount = static_cast<uint32_t>( batch.Vertices.size() );
+
+            if ( batch.UploadedVertexCount != 0u ) {
+                BufferDesc bufferDescription;
+                bufferDescription.type = BufferDesc::VERTEX_BUFFER;
+                bufferDescription.size = sizeof( LineVertex ) * batch.UploadedVertexCount;
+                bufferDescription.stride = sizeof( LineVertex );
+
+                batch.VertexBuffer = renderDevice->createBuffer( bufferDescription, batch.Vertices.data() );
+            }
+
+            batch.IsDirty = 0;
+        }
+
+        if ( batch.IsAllocated && batch.IsVisible ) {
+            staticLineCount += ( batch.UploadedVertexCount >> 1 );
+        }
+    }
+
+    // Transient lines are only uploaded when modified (added or expired)
+    if ( isTransientBufferDirty ) {
+        const uint32_t transientVertexCount = static_cast<uint32_t>( transientVertices.size() );
+
+        if ( transientVertexCount > transientBufferCapacity ) {
+            if ( transientVertexBuffer != nullptr ) {
+                renderDevice->destroyBuffer( transientVertexBuffer );
+            }
+
+            transientBufferCapacity = ( transientBufferCapacity == 0u ) ? 4096u : transientBufferCapacity;
+            while ( transientBufferCapacity < transientVertexCount ) {
+                transientBufferCapacity <<= 1;
+            }
+
+            BufferDesc bufferDescription;
+            bufferDescription.type = BufferDesc::DYNAMIC_VERTEX_BUFFER;
+            bufferDescription.size = sizeof( LineVertex ) * transientBufferCapacity;
+            bufferDescription.stride = sizeof( LineVertex );
 
-    buffer[bufferIndex++] = ( color.x );
-    buffer[bufferIndex++] = ( color.y );
-    buffer[bufferIndex++] = ( color.z );
-    buffer[bufferIndex++] = ( color.w );
+            transientVertexBuffer = renderDevice->createBuffer( bufferDescription );
+        }
 
-    buffer[bufferIndex++] = ( to.x );
-    buffer[bufferIndex++] = ( to.y );
-    buffer[bufferIndex++] = ( to.z );
-    buffer[bufferIndex++] = ( thickness );
+        if ( transientVertexCount != 0u ) {
+            cmdList.updateBuffer( transientVertexBuffer, transientVertices.data(), sizeof( LineVertex ) * transientVertexCount );
+        }
 
-    buffer[bufferIndex++] = ( color.x );
-    buffer[bufferIndex++] = ( color.y );
-    buffer[bufferIndex++] = ( color.z );
-    buffer[bufferIndex++] = ( color.w );
+        uploadedTransientVertexCount = transientVertexCount;
+        isTransientBufferDirty = false;
+    }
 
-    indiceCount += 2;
+    NYA_PROFILE_STAT( "Debug Lines (Transient)", uploadedTransientVertexCount >> 1 )
+    NYA_PROFILE_STAT( "Debug Lines (Static)", staticLineCount )
+}
+
+void LineRenderingModule::AppendLine( std::vector<LineVertex>& vertices, const nyaVec3f& from, const nyaVec3f& to, const uint32_t color )
+{
+    vertices.push_back( { from, color } );
+    vertices.push_back( { to, color } );
+}
+
+void LineRenderingModule::AppendAABB( std::vector<LineVertex>& vertices, const AABB& aabb, const uint32_t color )
+{
+    const nyaVec3f& minPoint = aabb.minPoint;
+    const nyaVec3f& maxPoint = aabb.maxPoint;
+
+    const nyaVec3f corners[8] = {
+        nyaVec3f( minPoint.x, minPoint.y, minPoint.z ),
+        nyaVec3f( maxPoint.x, minPoint.y, minPoint.z ),
+        nyaVec3f( maxPoint.x, maxPoint.y, minPoint.z ),
+        nyaVec3f( minPoint.x, maxPoint.y, minPoint.z ),
+
+        nyaVec3f( minPoint.x, minPoint.y, maxPoint.z ),
+        nyaVec3f( maxPoint.x, minPoint.y, maxPoint.z ),
+        nyaVec3f( maxPoint.x, maxPoint.y, maxPoint.z ),
+        nyaVec3f( minPoint.x, maxPoint.y, maxPoint.z ),
+    };
+
+    for ( int i = 0; i < 4; i++ ) {
+        AppendLine( vertices, corners[i], corners[( i + 1 ) % 4], color );
+        AppendLine( vertices, corners[4 + i], corners[4 + ( i + 1 ) % 4], color );
+        AppendLine( vertices, corners[i], corners[4 + i], color );
+    }
+}
+
+void LineRenderingModule::AppendSphere( std::vector<LineVertex>& vertices, const nyaVec3f& center, const float radius, const uint32_t color )
+{
+    static constexpr int SEGMENT_COUNT = 16;
+    static constexpr float SEGMENT_ANGLE = nya::maths::TWO_PI<float>() / static_cast<float>( SEGMENT_COUNT );
+
+    // One circle per axis plane
+    for ( int segmentIdx = 0; segmentIdx < SEGMENT_COUNT; segmentIdx++ ) {
+        const float angleA = SEGMENT_ANGLE * static_cast<float>( segmentIdx );
+        const float angleB = SEGMENT_ANGLE * static_cast<float>( segmentIdx + 1 );
+
+        const float cosA = cosf( angleA ) * radius, sinA = sinf( angleA ) * radius;
+        const float cosB = cosf( angleB ) * radius, sinB = sinf( angleB ) * radius;
+
+        AppendLine( vertices, center + nyaVec3f( cosA, sinA, 0.0f ), center + nyaVec3f( cosB, sinB, 0.0f ), color );
+        AppendLine( vertices, center + nyaVec3f( cosA, 0.0f, sinA ), center + nyaVec3f( cosB, 0.0f, sinB ), color );
+        AppendLine( vertices, center + nyaVec3f( 0.0f, cosA, sinA ), center + nyaVec3f( 0.0f, cosB, sinB ), color );
+    }
 }
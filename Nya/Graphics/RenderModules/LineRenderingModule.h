@@ -21,17 +21,23 @@
 
 #include <Maths/Vector.h>
 
+#include <vector>
+
 struct PipelineState;
 struct Buffer;
+struct AABB;
 
 class RenderPipeline;
 class RenderDevice;
+class CommandList;
 class GraphicsAssetCache;
 class ShaderCache;
 
 using ResHandle_t = uint32_t;
+using LineBatchHandle_t = uint32_t;
 
-static constexpr int32_t LINE_RENDERING_MAX_LINE_COUNT = 32000;
+static constexpr uint32_t LINE_RENDERING_MAX_STATIC_BATCH_COUNT = 64u;
+static constexpr LineBatchHandle_t LINE_RENDERING_INVALID_BATCH_HANDLE = ~0u;
 
 class LineRenderingModule
 {
@@ -44,20 +50,63 @@ public:
     ResHandle_t                  addLineRenderPass( RenderPipeline* renderPipeline, ResHandle_t output );
     void                         loadCachedResources( RenderDevice* renderDevice, ShaderCache* shaderCache, GraphicsAssetCache* graphicsAssetCache );
 
-    void                         addLine( const nyaVec3f& from, const nyaVec3f& to, const float thickness, const nyaVec4f& color );
+    // Age transient primitives and remove the expired ones (should be called once per frame, after rendering)
+    void                         updateLifetimes( const float deltaTime );
+
+    // Transient primitives (world space); lifetime is in seconds (0 means a single frame)
+    void                         addLine( const nyaVec3f& from, const nyaVec3f& to, const nyaVec4f& color, const float lifetime = 0.0f );
+    void                         addAABB( const AABB& aabb, const nyaVec4f& color, const float lifetime = 0.0f );
+    void                         addSphere( const nyaVec3f& center, const float radius, const nyaVec4f& color, const float lifetime = 0.0f );
+
+    // Persistent batches (uploaded once, then drawn every frame until released)
+    LineBatchHandle_t            allocateStaticBatch();
+    void                         releaseStaticBatch( const LineBatchHandle_t batchHandle );
+    void                         setStaticBatchVisibility( const LineBatchHandle_t batchHandle, const bool isVisible );
+
+    // Remove every primitive from the batch (the batch is kept allocated and can be refilled)
+    void                         clearStaticBatch( const LineBatchHandle_t batchHandle );
+
+    void                         addLine( const LineBatchHandle_t batchHandle, const nyaVec3f& from, const nyaVec3f& to, const nyaVec4f& color );
+    void                         addAABB( const LineBatchHandle_t batchHandle, const AABB& aabb, const nyaVec4f& color );
+    void                         addSphere( const LineBatchHandle_t batchHandle, const nyaVec3f& center, const float radius, const nyaVec4f& color );
+    void                         addGrid( const LineBatchHandle_t batchHandle, const nyaVec3f& center, const float extent, const uint32_t cellCount, const nyaVec4f& color );
 
 private:
-    static constexpr int BUFFER_COUNT = 2;
+    // Compact line vertex (16 bytes)
+    struct LineVertex
+    {
+        nyaVec3f    Position;
+        uint32_t    Color;
+    };
+
+    struct StaticBatch
+    {
+        std::vector<LineVertex> Vertices;
+        Buffer*                 VertexBuffer;
+        uint32_t                UploadedVertexCount;
+        uint8_t                 IsAllocated : 1;
+        uint8_t                 IsVisible : 1;
+        uint8_t                 IsDirty : 1;
+        uint8_t                 IsPendingRelease : 1;
+    };
 
 private:
-    PipelineState* renderLinePso;
+    PipelineState*              renderLinePso;
+
+    // Transient lines (two vertices per line; one lifetime per line)
+    std::vector<LineVertex>     transientVertices;
+    std::vector<float>          transientLifetimes;
+    Buffer*                     transientVertexBuffer;
+    uint32_t                    transientBufferCapacity;
+    uint32_t                    uploadedTransientVertexCount;
+    bool                        isTransientBufferDirty;
 
-    int         indiceCount;
-    int         vertexBufferIndex;
+    StaticBatch                 staticBatches[LINE_RENDERING_MAX_STATIC_BATCH_COUNT];
 
-    Buffer*     lineVertexBuffers[BUFFER_COUNT];
-    Buffer*     lineIndiceBuffer;
+private:
+    void                         updateGPUBuffers( RenderDevice* renderDevice, CommandList& cmdList );
 
-    int         bufferIndex;
-    float       buffer[LINE_RENDERING_MAX_LINE_COUNT];
+    static void                  AppendLine( std::vector<LineVertex>& vertices, const nyaVec3f& from, const nyaVec3f& to, const uint32_t color );
+    static void                  AppendAABB( std::vector<LineVertex>& vertices, const AABB& aabb, const uint32_t color );
+    static void                  AppendSphere( std::vector<LineVertex>& vertices, const nyaVec3f& center, const float radius, const uint32_t color );
 };
\ No newline at end of file
@@ -0,0 +1,207 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "Shared.h"
+#include "LocalShadowRenderModule.h"
+
+#include <Graphics/RenderPipeline.h>
+#include <Graphics/ShaderCache.h>
+
+#include <Rendering/RenderDevice.h>
+#include <Rendering/ImageFormat.h>
+
+#include <Maths/Helpers.h>
+#include <Maths/MatrixTransformations.h>
+
+#include <string.h>
+
+using namespace nya::rendering;
+
+// Faces are ordered by major axis (X+, X-, Y+, Y-, Z+, Z-) so that the shader can pick a face without any lookup
+static const nyaVec3f FACE_DIRECTIONS[LOCAL_SHADOW_MAX_FACE_COUNT] = {
+    nyaVec3f( 1.0f, 0.0f, 0.0f ),
+    nyaVec3f( -1.0f, 0.0f, 0.0f ),
+    nyaVec3f( 0.0f, 1.0f, 0.0f ),
+    nyaVec3f( 0.0f, -1.0f, 0.0f ),
+    nyaVec3f( 0.0f, 0.0f, 1.0f ),
+    nyaVec3f( 0.0f, 0.0f, -1.0f ),
+};
+
+static const nyaVec3f FACE_UP_VECTORS[LOCAL_SHADOW_MAX_FACE_COUNT] = {
+    nyaVec3f( 0.0f, 1.0f, 0.0f ),
+    nyaVec3f( 0.0f, 1.0f, 0.0f ),
+    nyaVec3f( 0.0f, 0.0f, -1.0f ),
+    nyaVec3f( 0.0f, 0.0f, 1.0f ),
+    nyaVec3f( 0.0f, 1.0f, 0.0f ),
+    nyaVec3f( 0.0f, 1.0f, 0.0f ),
+};
+
+LocalShadowRenderModule::LocalShadowRenderModule()
+    : shadowAtlasRenderTarget( nullptr )
+    , shadowGpuBuffer( nullptr )
+    , tileClearPso( nullptr )
+{
+    memset( &shadowBuffer, 0, sizeof( ShadowBuffer ) );
+    memset( faceUpdates, 0, sizeof( LocalShadowFaceUpdate ) * LOCAL_SHADOW_MAX_FACE_UPDATE_COUNT );
+
+    captureInfos.FaceUpdates = faceUpdates;
+    captureInfos.FaceUpdateCount = 0u;
+    captureInfos.ShadowBufferData = &shadowBuffer;
+    captureInfos.TileClearPipelineState = nullptr;
+
+    shadowAtlas.create( LOCAL_SHADOW_ATLAS_DIMENSIONS, LOCAL_SHADOW_MIN_TILE_DIMENSIONS, LOCAL_SHADOW_MAX_TILE_DIMENSIONS );
+}
+
+LocalShadowRenderModule::~LocalShadowRenderModule()
+{
+
+}
+
+void LocalShadowRenderModule::destroy( RenderDevice* renderDevice )
+{
+    renderDevice->destroyRenderTarget( shadowAtlasRenderTarget );
+    renderDevice->destroyBuffer( shadowGpuBuffer );
+    renderDevice->destroyPipelineState( tileClearPso );
+
+    shadowAtlasRenderTarget = nullptr;
+    shadowGpuBuffer = nullptr;
+    tileClearPso = nullptr;
+    captureInfos.TileClearPipelineState = nullptr;
+}
+
+void LocalShadowRenderModule::loadCachedResources( RenderDevice* renderDevice, ShaderCache* shaderCache, GraphicsAssetCache* graphicsAssetCache )
+{
+    TextureDescription shadowAtlasDesc = {};
+    shadowAtlasDesc.dimension = TextureDescription::DIMENSION_TEXTURE_2D;
+    shadowAtlasDesc.format = eImageFormat::IMAGE_FORMAT_R32_TYPELESS;
+    shadowAtlasDesc.flags.isDepthResource = 1;
+    shadowAtlasDesc.width = LOCAL_SHADOW_ATLAS_DIMENSIONS;
+    shadowAtlasDesc.height = LOCAL_SHADOW_ATLAS_DIMENSIONS;
+
+    shadowAtlasRenderTarget = renderDevice->createRenderTarget2D( shadowAtlasDesc );
+
+    BufferDesc shadowBufferDesc = {};
+    shadowBufferDesc.type = BufferDesc::CONSTANT_BUFFER;
+    shadowBufferDesc.size = sizeof( ShadowBuffer );
+
+    shadowGpuBuffer = renderDevice->createBuffer( shadowBufferDesc );
+
+    // Tiles are cleared by drawing a triangle on the far plane (the atlas is never cleared as a whole)
+    PipelineStateDesc psoDesc = {};
+    psoDesc.vertexShader = shaderCache->getOrUploadStage( "Lighting/ShadowTileClear", SHADER_STAGE_VERTEX );
+    psoDesc.pixelShader = shaderCache->getOrUploadStage( "Lighting/ShadowTileClear", SHADER_STAGE_PIXEL );
+    psoDesc.primitiveTopology = nya::rendering::ePrimitiveTopology::PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    psoDesc.rasterizerState.cullMode = eCullMode::CULL_MODE_NONE;
+    psoDesc.depthStencilState.enableDepthTest = true;
+    psoDesc.depthStencilState.enableDepthWrite = true;
+    psoDesc.depthStencilState.depthComparisonFunc = eComparisonFunction::COMPARISON_FUNCTION_ALWAYS;
+
+    psoDesc.renderPassLayout.attachements[0].stageBind = SHADER_STAGE_PIXEL;
+    psoDesc.renderPassLayout.attachements[0].bindMode = RenderPassLayoutDesc::WRITE_DEPTH;
+    psoDesc.renderPassLayout.attachements[0].targetState = RenderPassLayoutDesc::DONT_CARE;
+    psoDesc.renderPassLayout.attachements[0].viewFormat = eImageFormat::IMAGE_FORMAT_R32_TYPELESS;
+
+    tileClearPso = renderDevice->createPipelineState( psoDesc );
+    captureInfos.TileClearPipelineState = tileClearPso;
+
+    // Tiles content is lost
+    shadowAtlas.clear();
+}
+
+void LocalShadowRenderModule::importResourcesToPipeline( RenderPipeline* renderPipeline )
+{
+    renderPipeline->importPersistentRenderTarget( NYA_STRING_HASH( "LocalShadows/ShadowAtlas" ), shadowAtlasRenderTarget );
+    renderPipeline->importPersistentBuffer( NYA_STRING_HASH( "LocalShadows/ShadowBuffer" ), shadowGpuBuffer );
+}
+
+uint32_t LocalShadowRenderModule::updateShadowAtlas( const LocalShadowRequest* requests, const uint32_t requestCount, const uint32_t maxFaceUpdateCount )
+{
+    const uint32_t faceUpdateCount = shadowAtlas.update( requests, requestCount, faceUpdates, nya::maths::min( maxFaceUpdateCount, LOCAL_SHADOW_MAX_FACE_UPDATE_COUNT ) );
+
+    constexpr float ATLAS_TEXEL_SIZE = ( 1.0f / static_cast<float>( LOCAL_SHADOW_ATLAS_DIMENSIONS ) );
+
+    shadowBuffer.ShadowCount = 0u;
+    for ( uint32_t slotIdx = 0u; slotIdx < ShadowAtlas::MAX_SLOT_COUNT; slotIdx++ ) {
+        const ShadowAtlas::Slot& slot = shadowAtlas.getSlot( slotIdx );
+        if ( !slot.IsAllocated ) {
+            continue;
+        }
+
+        const nyaMat4x4f faceProjectionMatrix = nya::maths::MakeFovProj( nya::maths::HALF_PI<float>(), 1.0f, LOCAL_SHADOW_NEAR_PLANE, slot.Radius );
+
+        for ( uint32_t faceIdx = 0u; faceIdx < slot.FaceCount; faceIdx++ ) {
+            const nyaMat4x4f faceViewMatrix = nya::maths::MakeLookAtMat( slot.WorldPosition, slot.WorldPosition + FACE_DIRECTIONS[faceIdx], FACE_UP_VECTORS[faceIdx] );
+            faceViewProjectionMatrices[slotIdx][faceIdx] = faceProjectionMatrix * faceViewMatrix;
+        }
+
+        // Tiles of lights with pending faces are not sampled (their content might be garbage)
+        if ( !slot.HasValidTiles ) {
+            continue;
+        }
+
+        const uint32_t shadowIdx = shadowBuffer.ShadowCount++;
+        shadowBuffer.LightIndexes[shadowIdx] = slot.LightIndex;
+
+        for ( uint32_t faceIdx = 0u; faceIdx < slot.FaceCount; faceIdx++ ) {
+            nyaVec4f* faceData = &shadowBuffer.FaceData[( shadowIdx * LOCAL_SHADOW_MAX_FACE_COUNT + faceIdx ) * LOCAL_SHADOW_FACE_VECTOR_COUNT];
+
+            // Faces still waiting for an update (e.g. the light has moved but the face update budget is exhausted) are
+            // sampled with the transform they have been rendered with
+            const nyaVec3f& capturePosition = slot.FaceCapturePositions[faceIdx];
+            const nyaMat4x4f captureProjectionMatrix = nya::maths::MakeFovProj( nya::maths::HALF_PI<float>(), 1.0f, LOCAL_SHADOW_NEAR_PLANE, slot.FaceCaptureRadii[faceIdx] );
+            const nyaMat4x4f captureViewMatrix = nya::maths::MakeLookAtMat( capturePosition, capturePosition + FACE_DIRECTIONS[faceIdx], FACE_UP_VECTORS[faceIdx] );
+
+            const nyaMat4x4f shadowMatrix = ( captureProjectionMatrix * captureViewMatrix ).transpose();
+            faceData[0] = shadowMatrix[0];
+            faceData[1] = shadowMatrix[1];
+            faceData[2] = shadowMatrix[2];
+            faceData[3] = shadowMatrix[3];
+
+            const ShadowAtlasTile& tile = slot.Tiles[faceIdx];
+            faceData[4] = nyaVec4f( tile.Size * ATLAS_TEXEL_SIZE, tile.Size * ATLAS_TEXEL_SIZE, tile.X * ATLAS_TEXEL_SIZE, tile.Y * ATLAS_TEXEL_SIZE );
+        }
+    }
+
+    captureInfos.FaceUpdateCount = faceUpdateCount;
+
+    NYA_PROFILE_STAT( "Local Shadows Face Updates", faceUpdateCount )
+    NYA_PROFILE_STAT( "Local Shadows Atlas Usage (%)", 100.0 * shadowAtlas.getAllocator().getAllocatedArea() / ( LOCAL_SHADOW_ATLAS_DIMENSIONS * LOCAL_SHADOW_ATLAS_DIMENSIONS ) )
+
+    return faceUpdateCount;
+}
+
+void LocalShadowRenderModule::invalidate( const AABB& aabb )
+{
+    shadowAtlas.invalidate( aabb );
+}
+
+const LocalShadowFaceUpdate& LocalShadowRenderModule::getFaceUpdate( const uint32_t updateIndex ) const
+{
+    return faceUpdates[updateIndex];
+}
+
+const nyaMat4x4f& LocalShadowRenderModule::getFaceViewProjectionMatrix( const uint32_t slotIndex, const uint32_t faceIndex ) const
+{
+    return faceViewProjectionMatrices[slotIndex][faceIndex];
+}
+
+const LocalShadowRenderModule::CaptureInfos* LocalShadowRenderModule::getCaptureInfos() const
+{
+    return &captureInfos;
+}
@@ -0,0 +1,89 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <Graphics/ShadowAtlas.h>
+
+#include <Maths/Vector.h>
+#include <Maths/Matrix.h>
+#include <Shaders/ShadowMappingShared.h>
+
+struct RenderTarget;
+struct PipelineState;
+struct Buffer;
+struct AABB;
+
+class RenderPipeline;
+class RenderDevice;
+class GraphicsAssetCache;
+class ShaderCache;
+
+// Max number of atlas faces rendered in a single frame (faces are identified by a 6 bits draw command sub-layer)
+static constexpr uint32_t LOCAL_SHADOW_MAX_FACE_UPDATE_COUNT = 64u;
+
+// Point light shadow maps (cached in a persistent depth atlas)
+class LocalShadowRenderModule
+{
+public:
+    // cbuffer LocalShadowBuffer (b5); only lights whose tiles are fully rendered are listed
+    struct ShadowBuffer {
+        uint32_t    LightIndexes[LOCAL_SHADOW_MAX_LIGHT_COUNT];
+        uint32_t    ShadowCount;
+        uint32_t    __PADDING__[3];
+        nyaVec4f    FaceData[LOCAL_SHADOW_MAX_LIGHT_COUNT * LOCAL_SHADOW_MAX_FACE_COUNT * LOCAL_SHADOW_FACE_VECTOR_COUNT];
+    };
+
+    // Faces to render this frame (consumed by the shadow capture pass)
+    struct CaptureInfos {
+        const LocalShadowFaceUpdate*    FaceUpdates;
+        uint32_t                        FaceUpdateCount;
+        const ShadowBuffer*             ShadowBufferData;
+        PipelineState*                  TileClearPipelineState;
+    };
+
+public:
+                                LocalShadowRenderModule();
+                                LocalShadowRenderModule( LocalShadowRenderModule& ) = delete;
+                                ~LocalShadowRenderModule();
+
+    void                        destroy( RenderDevice* renderDevice );
+    void                        loadCachedResources( RenderDevice* renderDevice, ShaderCache* shaderCache, GraphicsAssetCache* graphicsAssetCache );
+
+    void                        importResourcesToPipeline( RenderPipeline* renderPipeline );
+
+    // Update the atlas with this frame requests and returns the number of faces to render
+    uint32_t                    updateShadowAtlas( const LocalShadowRequest* requests, const uint32_t requestCount, const uint32_t maxFaceUpdateCount );
+    void                        invalidate( const AABB& aabb );
+
+    const LocalShadowFaceUpdate& getFaceUpdate( const uint32_t updateIndex ) const;
+    const nyaMat4x4f&           getFaceViewProjectionMatrix( const uint32_t slotIndex, const uint32_t faceIndex ) const;
+    const CaptureInfos*         getCaptureInfos() const;
+
+private:
+    ShadowAtlas                 shadowAtlas;
+    RenderTarget*               shadowAtlasRenderTarget;
+    Buffer*                     shadowGpuBuffer;
+    PipelineState*              tileClearPso;
+
+    ShadowBuffer                shadowBuffer;
+    nyaMat4x4f                  faceViewProjectionMatrices[LOCAL_SHADOW_MAX_LIGHT_COUNT][LOCAL_SHADOW_MAX_FACE_COUNT];
+    LocalShadowFaceUpdate       faceUpdates[LOCAL_SHADOW_MAX_FACE_UPDATE_COUNT];
+    CaptureInfos                captureInfos;
+};
@@ -37,6 +37,25 @@
 
 using namespace nya::rendering;
 
+// R11G11B10_FLOAT
+static constexpr size_t PROBE_TEXEL_SIZE = 4;
+
+static size_t GetProbeMipSize( const uint32_t mipLevel )
+{
+    const size_t mipDimension = static_cast<size_t>( IBL_PROBE_DIMENSION >> mipLevel );
+    return mipDimension * mipDimension * PROBE_TEXEL_SIZE;
+}
+
+size_t ProbeCaptureModule::GetConvolutedProbeSize()
+{
+    size_t faceSize = 0;
+    for ( uint32_t mipLevel = 0; mipLevel < CONVOLUTED_PROBE_MIP_COUNT; mipLevel++ ) {
+        faceSize += GetProbeMipSize( mipLevel );
+    }
+
+    return faceSize * 6;
+}
+
 ProbeCaptureModule::ProbeCaptureModule()
     : capturedProbesArray( nullptr )
     , diffuseProbesArray( nullptr )
@@ -75,7 +94,7 @@ void ProbeCaptureModule::loadCachedResources( RenderDevice* renderDevice, Shader
 
     capturedProbesArray = renderDevice->createRenderTarget2D( probeArrayDesc );
 
-    probeArrayDesc.mipCount = 8;
+    probeArrayDesc.mipCount = CONVOLUTED_PROBE_MIP_COUNT;
     probeArrayDesc.flags.useHardwareMipGen = 1;
 
     diffuseProbesArray = renderDevice->createRenderTarget2D( probeArrayDesc );
@@ -331,3 +350,45 @@ void ProbeCaptureModule::saveCapturedProbeFace( RenderPipeline* renderPipeline,
         }
     );
 }
+
+bool ProbeCaptureModule::readConvolutedProbe( RenderDevice* renderDevice, const int32_t probeArrayIndex, uint8_t* diffuseTexels, uint8_t* specularTexels )
+{
+    size_t offset = 0;
+    for ( uint32_t faceIndex = 0; faceIndex < 6; faceIndex++ ) {
+        const uint32_t arrayIndex = static_cast<uint32_t>( probeArrayIndex ) * 6 + faceIndex;
+
+        for ( uint32_t mipLevel = 0; mipLevel < CONVOLUTED_PROBE_MIP_COUNT; mipLevel++ ) {
+            const size_t mipSize = GetProbeMipSize( mipLevel );
+
+            if ( !renderDevice->readRenderTarget( diffuseProbesArray, mipLevel, arrayIndex, diffuseTexels + offset, mipSize )
+              || !renderDevice->readRenderTarget( specularProbesArray, mipLevel, arrayIndex, specularTexels + offset, mipSize ) ) {
+                return false;
+            }
+
+            offset += mipSize;
+        }
+    }
+
+    return true;
+}
+
+bool ProbeCaptureModule::uploadConvolutedProbe( RenderDevice* renderDevice, const int32_t probeArrayIndex, const uint8_t* diffuseTexels, const uint8_t* specularTexels )
+{
+    size_t offset = 0;
+    for ( uint32_t faceIndex = 0; faceIndex < 6; faceIndex++ ) {
+        const uint32_t arrayIndex = static_cast<uint32_t>( probeArrayIndex ) * 6 + faceIndex;
+
+        for ( uint32_t mipLevel = 0; mipLevel < CONVOLUTED_PROBE_MIP_COUNT; mipLevel++ ) {
+            const size_t mipSize = GetProbeMipSize( mipLevel );
+
+            if ( !renderDevice->updateRenderTarget( diffuseProbesArray, mipLevel, arrayIndex, diffuseTexels + offset, mipSize )
+              || !renderDevice->updateRenderTarget( specularProbesArray, mipLevel, arrayIndex, specularTexels + offset, mipSize ) ) {
+                return false;
+            }
+
+            offset += mipSize;
+        }
+    }
+
+    return true;
+}
@@ -36,6 +36,12 @@ using ResHandle_t = uint32_t;
 
 class ProbeCaptureModule
 {
+public:
+    static constexpr uint32_t   CONVOLUTED_PROBE_MIP_COUNT = 8u;
+
+    // Size (in bytes) of the convoluted faces of a probe (6 faces; each face stores its whole mip chain)
+    static size_t               GetConvolutedProbeSize();
+
 public:
                                 ProbeCaptureModule();
                                 ProbeCaptureModule( ProbeCaptureModule& ) = delete;
@@ -47,6 +53,10 @@ public:
     void                        importResourcesToPipeline( RenderPipeline* renderPipeline );
     void                        convoluteProbeFace( RenderPipeline* renderPipeline, const int32_t probeArrayIndex, const uint16_t probeCaptureStep, const int32_t mipLevel = 0 );
     void                        saveCapturedProbeFace( RenderPipeline* renderPipeline, ResHandle_t capturedFace, const int32_t probeArrayIndex, const int16_t probeCaptureStep );
+
+    // Read back/upload the convoluted faces of a probe (texels are laid out per face, then per mip; see GetConvolutedProbeSize)
+    bool                        readConvolutedProbe( RenderDevice* renderDevice, const int32_t probeArrayIndex, uint8_t* diffuseTexels, uint8_t* specularTexels );
+    bool                        uploadConvolutedProbe( RenderDevice* renderDevice, const int32_t probeArrayIndex, const uint8_t* diffuseTexels, const uint8_t* specularTexels );
     
 private:
     RenderTarget*               capturedProbesArray;
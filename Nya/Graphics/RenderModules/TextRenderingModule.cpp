@@ -17,12 +17,13 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
-
 #include "Shared.h"
 #include "TextRenderingModule.h"
 
 #include <Io/FontDescriptor.h>
 
+#include <Core/Hashing/MurmurHash3.h>
+
 #include <Graphics/RenderPipeline.h>
 #include <Graphics/GraphicsAssetCache.h>
 #include <Graphics/ShaderCache.h>
@@ -31,18 +32,25 @@
 #include <Rendering/CommandList.h>
 #include <Rendering/ImageFormat.h>
 
+#include <Maths/Packing.h>
+
+#include <cstring>
+
 using namespace nya::rendering;
 
 TextRenderingModule::TextRenderingModule()
     : fontAtlas( nullptr )
     , fontDescriptor( nullptr )
     , renderTextPso( nullptr )
-    , indiceCount( 0 )
-    , vertexBufferIndex( 0 )
-    , glyphVertexBuffers{ nullptr, nullptr }
+    , glyphInstanceBuffer( nullptr )
     , glyphIndiceBuffer( nullptr )
-    , bufferOffset( 0 )
-    , buffer{ 0.0f }
+    , fontHashcode( 0 )
+    , frameIndex( 0 )
+    , glyphCount( 0 )
+    , cacheHitCount( 0 )
+    , cacheMissCount( 0 )
+    , runCount( 0 )
+    , uploadedRunCount( 0 )
 {
 
 }
@@ -52,18 +60,20 @@ TextRenderingModule::~TextRenderingModule()
     fontAtlas = nullptr;
     fontDescriptor = nullptr;
 
-    indiceCount = 0;
-    vertexBufferIndex = 0;
+    fontHashcode = 0;
+    frameIndex = 0;
+    glyphCount = 0;
+    runCount = 0;
+    uploadedRunCount = 0;
+    cacheHitCount = 0;
+    cacheMissCount = 0;
 
-    bufferOffset = 0;
+    glyphRunCache.clear();
 }
 
 void TextRenderingModule::destroy( RenderDevice* renderDevice )
 {
-    for ( int32_t i = 0; i < BUFFER_COUNT; i++ ) {
-        renderDevice->destroyBuffer( glyphVertexBuffers[i] );
-    }
-
+    renderDevice->destroyBuffer( glyphInstanceBuffer );
     renderDevice->destroyBuffer( glyphIndiceBuffer );
     renderDevice->destroyPipelineState( renderTextPso );
 }
@@ -133,32 +143,48 @@ MutableResHandle_t TextRenderingModule::renderText( RenderPipeline* renderPipeli
                 RenderPass renderPass;
                 renderPass.attachement[0] = { outputTarget, 0, 0 };
 
-                // Update vertex buffer content
-                cmdList.updateBuffer( glyphVertexBuffers[vertexBufferIndex], buffer, static_cast<size_t>( bufferOffset ) * sizeof( float ) );
+                // Upload the glyph runs which have changed since the previous frame
+                const uint32_t uploadedGlyphCount = updateGlyphInstances( cmdList );
 
                 // Pipeline State
                 cmdList.beginRenderPass( renderTextPso, renderPass );
                 {
                     cmdList.bindPipelineState( renderTextPso );
 
-                    cmdList.bindVertexBuffer( glyphVertexBuffers[vertexBufferIndex] );
+                    cmdList.bindVertexBuffer( glyphInstanceBuffer );
                     cmdList.bindIndiceBuffer( glyphIndiceBuffer );
 
-                    cmdList.drawIndexed( static_cast< uint32_t >( indiceCount ) );
+                    if ( glyphCount != 0u ) {
+                        cmdList.drawInstancedIndexed( 6u, glyphCount, 0u );
+                    }
                 }
                 cmdList.endRenderPass();
 
                 cmdList.end();
+
+                NYA_PROFILE_STAT( "Text Glyphs Uploaded", uploadedGlyphCount )
             }
 
             renderDevice->submitCommandList( &cmdList );
 
-            // Swap buffers
-            vertexBufferIndex = ( vertexBufferIndex == 0 ) ? 1 : 0;
+            NYA_PROFILE_STAT( "Text Layout Cache Hits", cacheHitCount )
+            NYA_PROFILE_STAT( "Text Layout Cache Misses", cacheMissCount )
 
-            // Reset buffers
-            indiceCount = 0;
-            bufferOffset = 0;
+            // Evict the runs which haven't been used for a while
+            for ( auto it = glyphRunCache.begin(); it != glyphRunCache.end(); ) {
+                if ( ( frameIndex - it->second.LastUsedFrame ) > TEXT_RENDERING_RUN_EVICTION_DELAY ) {
+                    it = glyphRunCache.erase( it );
+                } else {
+                    ++it;
+                }
+            }
+
+            // Reset per-frame data
+            frameIndex++;
+            glyphCount = 0;
+            runCount = 0;
+            cacheHitCount = 0;
+            cacheMissCount = 0;
         } );
 
     return data.output;
@@ -175,50 +201,25 @@ void TextRenderingModule::loadCachedResources( RenderDevice* renderDevice, Shade
     }
 
     fontAtlas = graphicsAssetCache->getTexture( fontDescriptor->Name.c_str() );
+    fontHashcode = nya::core::CRC32( fontDescriptor->Name );
 
-    // Create static indice buffer
-    static constexpr int IndexStride = sizeof( uint32_t );
-
-    // Indices per glyph (2 triangles; 3 indices per triangle)
-    static constexpr int indexBufferSize = MaxCharactersPerLine * MaxCharactersLines * 6 * sizeof( uint32_t );
-    static constexpr int indexBufferLength = indexBufferSize / IndexStride;
-
-    uint32_t indexBufferData[indexBufferLength];
-
-    uint32_t i = 0;
-    for ( uint32_t c = 0; c < MaxCharactersPerLine * MaxCharactersLines; c++ ) {
-        indexBufferData[i + 0] = c * 4 + 0;
-        indexBufferData[i + 1] = c * 4 + 1;
-        indexBufferData[i + 2] = c * 4 + 2;
-
-        indexBufferData[i + 3] = c * 4 + 0;
-        indexBufferData[i + 4] = c * 4 + 2;
-        indexBufferData[i + 5] = c * 4 + 3;
-
-        i += 6;
-    }
+    // Create static indice buffer (a single quad; glyphes are instanced)
+    static constexpr uint32_t indexBufferData[6] = { 0, 1, 2, 0, 2, 3 };
 
     BufferDesc indiceBufferDescription;
     indiceBufferDescription.type = BufferDesc::INDICE_BUFFER;
-    indiceBufferDescription.size = indexBufferSize;
+    indiceBufferDescription.size = sizeof( indexBufferData );
+    indiceBufferDescription.stride = sizeof( uint32_t );
 
     glyphIndiceBuffer = renderDevice->createBuffer( indiceBufferDescription, indexBufferData );
 
-    // Create dynamic vertex buffer
-    // 4 + 2 + 4
-    constexpr std::size_t SINGLE_VERTEX_SIZE = sizeof( float ) * 10;
-
-    // XYZ Position + RGBA Color + XY TexCoords (w/ 6 vertices per glyph)
-    constexpr std::size_t VERTEX_BUFFER_SIZE = SINGLE_VERTEX_SIZE * TEXT_RENDERING_MAX_GLYPH_COUNT;
-
+    // Create persistent instance buffer (updated per range)
     BufferDesc bufferDescription;
-    bufferDescription.type = BufferDesc::DYNAMIC_VERTEX_BUFFER;
-    bufferDescription.size = VERTEX_BUFFER_SIZE;
-    bufferDescription.stride = SINGLE_VERTEX_SIZE;
+    bufferDescription.type = BufferDesc::VERTEX_BUFFER;
+    bufferDescription.size = sizeof( GlyphInstance ) * TEXT_RENDERING_MAX_GLYPH_COUNT;
+    bufferDescription.stride = sizeof( GlyphInstance );
 
-    for ( int32_t i = 0; i < BUFFER_COUNT; i++ ) {
-        glyphVertexBuffers[i] = renderDevice->createBuffer( bufferDescription );
-    }
+    glyphInstanceBuffer = renderDevice->createBuffer( bufferDescription );
 
     PipelineStateDesc pipelineState = {};
     pipelineState.vertexShader = shaderCache->getOrUploadStage( "UI/SDFTextRendering", eShaderStage::SHADER_STAGE_VERTEX );
@@ -245,9 +246,11 @@ void TextRenderingModule::loadCachedResources( RenderDevice* renderDevice, Shade
     pipelineState.depthStencilState.enableDepthWrite = false;
     pipelineState.depthStencilState.depthComparisonFunc = eComparisonFunction::COMPARISON_FUNCTION_ALWAYS;
 
-    pipelineState.inputLayout[0] = { 0, IMAGE_FORMAT_R32G32B32A32_FLOAT, 0, 0, 0, true, "POSITION" };
-    pipelineState.inputLayout[1] = { 0, IMAGE_FORMAT_R32G32_FLOAT, 0, 0,  0, true, "TEXCOORD" };
-    pipelineState.inputLayout[2] = { 0, IMAGE_FORMAT_R32G32B32A32_FLOAT, 0, 0, 0, true, "COLOR" };
+    // Per instance data
+    pipelineState.inputLayout[0] = { 0, IMAGE_FORMAT_R32G32B32A32_FLOAT, 1, 0, 0, true, "POSITION" };
+    pipelineState.inputLayout[1] = { 0, IMAGE_FORMAT_R16G16B16A16_UNORM, 1, 0, 0, true, "TEXCOORD" };
+    pipelineState.inputLayout[2] = { 0, IMAGE_FORMAT_R8G8B8A8_UNORM, 1, 0, 0, true, "COLOR" };
+    pipelineState.inputLayout[3] = { 1, IMAGE_FORMAT_R32_FLOAT, 1, 0, 0, true, "TEXCOORD" };
 
     pipelineState.renderPassLayout.attachements[0].stageBind = SHADER_STAGE_PIXEL;
     pipelineState.renderPassLayout.attachements[0].bindMode = RenderPassLayoutDesc::WRITE;
@@ -261,86 +264,246 @@ void TextRenderingModule::loadCachedResources( RenderDevice* renderDevice, Shade
     renderTextPso = renderDevice->createPipelineState( pipelineState );
 }
 
-void TextRenderingModule::addOutlinedText( const char* text, float size, float x, float y, const nyaVec4f& textColor, const float outlineThickness )
+void TextRenderingModule::addOutlinedText( const char* text, float size, float x, float y, const nyaVec4f& textColor, const float outlineThickness, const float wrapWidth )
 {
-    const float baseX = x, localSize = size;
-    float localX = x, localY = y;
+    addOutlinedText( text, nya::core::CRC32( text ), size, x, y, textColor, outlineThickness, wrapWidth );
+}
 
-    const auto localTextColor = textColor;
+void TextRenderingModule::addOutlinedText( const char* text, const nyaStringHash_t textHashcode, float size, float x, float y, const nyaVec4f& textColor, const float outlineThickness, const float wrapWidth )
+{
+    if ( fontDescriptor == nullptr || runCount >= TEXT_RENDERING_MAX_RUN_COUNT ) {
+        return;
+    }
 
-    int charIdx = 0;
-    for ( const char* p = text; *p != '\0'; p++, charIdx++ ) {
-        auto g = fontDescriptor->Glyphes[static_cast<size_t>( *p )];
+    uint64_t layoutKey = computeLayoutKey( textHashcode, size, wrapWidth );
+    const GlyphRun* glyphRun = getOrLayoutGlyphRun( text, layoutKey, size, wrapWidth );
 
-        float gx = localX + static_cast<float>( g.OffsetX ) * localSize;
-        float gy = -localY - static_cast<float>( g.OffsetY ) * localSize;
-        float gw = static_cast<float>( g.Width ) * localSize;
-        float gh = static_cast<float>( g.Height ) * localSize;
+    if ( glyphRun == nullptr ) {
+        // The key is already used by a different text this frame; fallback to a key built from the text content
+        layoutKey = computeLayoutKey( text, size, wrapWidth );
+        glyphRun = getOrLayoutGlyphRun( text, layoutKey, size, wrapWidth );
 
-        localX += g.AdvanceX * localSize;
+        if ( glyphRun == nullptr ) {
+            return;
+        }
+    }
+
+    const uint32_t runGlyphCount = static_cast<uint32_t>( glyphRun->Glyphes.size() );
+
+    if ( runGlyphCount == 0u || ( glyphCount + runGlyphCount ) > TEXT_RENDERING_MAX_GLYPH_COUNT ) {
+        return;
+    }
+
+    GlyphRunDrawCommand& drawCmd = runs[runCount++];
+    drawCmd.Run = glyphRun;
+    drawCmd.LayoutKey = layoutKey;
+    drawCmd.RunVersion = glyphRun->Version;
+    drawCmd.Position = nyaVec2f( x, y );
+    drawCmd.Color = nya::maths::PackColorRGBA8( textColor );
+    drawCmd.OutlineThickness = outlineThickness;
+    drawCmd.GlyphOffset = glyphCount;
+    drawCmd.GlyphCount = runGlyphCount;
+
+    glyphCount += runGlyphCount;
+}
+
+uint64_t TextRenderingModule::computeLayoutKey( const nyaStringHash_t textHashcode, const float size, const float wrapWidth ) const
+{
+    struct {
+        nyaStringHash_t textHashcode;
+        nyaStringHash_t fontHashcode;
+        float           size;
+        float           wrapWidth;
+    } layoutInfos = { textHashcode, fontHashcode, size, wrapWidth };
+
+    uint64_t layoutHashcode[2];
+    MurmurHash3_x64_128( &layoutInfos, static_cast<int>( sizeof( layoutInfos ) ), 19081996, layoutHashcode );
+
+    return layoutHashcode[0];
+}
+
+uint64_t TextRenderingModule::computeLayoutKey( const char* text, const float size, const float wrapWidth ) const
+{
+    uint64_t textHashcode[2];
+    MurmurHash3_x64_128( text, static_cast<int>( strlen( text ) ), 19081996, textHashcode );
+
+    struct {
+        uint64_t        textHashcode[2];
+        nyaStringHash_t fontHashcode;
+        float           size;
+        float           wrapWidth;
+    } layoutInfos = { { textHashcode[0], textHashcode[1] }, fontHashcode, size, wrapWidth };
+
+    uint64_t layoutHashcode[2];
+    MurmurHash3_x64_128( &layoutInfos, static_cast<int>( sizeof( layoutInfos ) ), 19081996, layoutHashcode );
+
+    return layoutHashcode[0];
+}
+
+const TextRenderingModule::GlyphRun* TextRenderingModule::getOrLayoutGlyphRun( const char* text, const uint64_t layoutKey, const float size, const float wrapWidth )
+{
+    auto cachedRun = glyphRunCache.find( layoutKey );
+    if ( cachedRun != glyphRunCache.end() ) {
+        GlyphRun& glyphRun = cachedRun->second;
+
+        if ( glyphRun.Text == text ) {
+            glyphRun.LastUsedFrame = frameIndex;
+            cacheHitCount++;
+
+            return &glyphRun;
+        }
+
+        // Either a key collision or a text using a stable key whose content has changed
+        // If the run has already been referenced this frame, it cannot be laid out again in place
+        if ( glyphRun.LastUsedFrame == frameIndex ) {
+            return nullptr;
+        }
+
+        cacheMissCount++;
+
+        glyphRun.LastUsedFrame = frameIndex;
+        layoutGlyphRun( glyphRun, text, size, wrapWidth );
+
+        return &glyphRun;
+    }
+
+    cacheMissCount++;
+
+    GlyphRun& glyphRun = glyphRunCache[layoutKey];
+    glyphRun.LastUsedFrame = frameIndex;
+    glyphRun.Version = 0u;
+
+    layoutGlyphRun( glyphRun, text, size, wrapWidth );
+
+    return &glyphRun;
+}
+
+void TextRenderingModule::layoutGlyphRun( GlyphRun& glyphRun, const char* text, const float size, const float wrapWidth ) const
+{
+    glyphRun.Glyphes.clear();
+    glyphRun.Text = text;
+    glyphRun.Version++;
+
+    const float atlasWidth = static_cast<float>( fontDescriptor->AtlasWidth );
+    const float atlasHeight = static_cast<float>( fontDescriptor->AtlasHeight );
+
+    // Layout is done relative to the run origin
+    float localX = 0.0f, localY = 0.0f;
+
+    int charIdx = 0;
+    for ( const char* p = text; *p != '\0'; p++, charIdx++ ) {
+        const auto& g = fontDescriptor->Glyphes[static_cast<uint8_t>( *p )];
+        const float advanceX = g.AdvanceX * size;
 
         if ( *p == '\n' ) {
-            localY += 38 * localSize;
-            localX = baseX;
+            localY += 38 * size;
+            localX = 0.0f;
             charIdx = 0;
             continue;
         } else if ( *p == '\t' ) {
-            localX += 28 * localSize * ( ( charIdx + 1 ) % 4 );
+            localX += advanceX + 28 * size * ( ( charIdx + 1 ) % 4 );
             continue;
         }
 
+        if ( wrapWidth > 0.0f && localX > 0.0f && ( localX + advanceX ) > wrapWidth ) {
+            localY += 38 * size;
+            localX = 0.0f;
+            charIdx = 0;
+        }
+
+        const float gx = localX + static_cast<float>( g.OffsetX ) * size;
+        const float gy = -localY - static_cast<float>( g.OffsetY ) * size;
+        const float gw = static_cast<float>( g.Width ) * size;
+        const float gh = static_cast<float>( g.Height ) * size;
+
+        localX += advanceX;
+
         if ( gw <= 0.0f || gh <= 0.0f )
             continue;
 
-        float u1 = static_cast<float>( g.PositionX ) / static_cast<float>( fontDescriptor->AtlasWidth );
-        float u2 = u1 + ( static_cast<float>( g.Width ) / static_cast<float>( fontDescriptor->AtlasWidth ) );
-        float v1 = static_cast<float>( g.PositionY ) / static_cast<float>( fontDescriptor->AtlasHeight );
-        float v2 = v1 + ( static_cast<float>( g.Height ) / static_cast<float>( fontDescriptor->AtlasHeight ) );
-
-        buffer[bufferOffset++] = ( gx );
-        buffer[bufferOffset++] = ( gy );
-        buffer[bufferOffset++] = ( 1.0f );
-        buffer[bufferOffset++] = ( outlineThickness );
-        buffer[bufferOffset++] = ( u1 );
-        buffer[bufferOffset++] = ( v1 );
-        buffer[bufferOffset++] = ( localTextColor.x );
-        buffer[bufferOffset++] = ( localTextColor.y );
-        buffer[bufferOffset++] = ( localTextColor.z );
-        buffer[bufferOffset++] = ( localTextColor.w );
-
-        buffer[bufferOffset++] = ( gx );
-        buffer[bufferOffset++] = ( gy - gh );
-        buffer[bufferOffset++] = ( 1.0f );
-        buffer[bufferOffset++] = ( outlineThickness );
-        buffer[bufferOffset++] = ( u1 );
-        buffer[bufferOffset++] = ( v2 );
-        buffer[bufferOffset++] = ( localTextColor.x );
-        buffer[bufferOffset++] = ( localTextColor.y );
-        buffer[bufferOffset++] = ( localTextColor.z );
-        buffer[bufferOffset++] = ( localTextColor.w );
-
-        buffer[bufferOffset++] = ( gx + gw );
-        buffer[bufferOffset++] = ( gy - gh );
-        buffer[bufferOffset++] = ( 1.0f );
-        buffer[bufferOffset++] = ( outlineThickness );
-        buffer[bufferOffset++] = ( u2 );
-        buffer[bufferOffset++] = ( v2 );
-        buffer[bufferOffset++] = ( localTextColor.x );
-        buffer[bufferOffset++] = ( localTextColor.y );
-        buffer[bufferOffset++] = ( localTextColor.z );
-        buffer[bufferOffset++] = ( localTextColor.w );
-
-        buffer[bufferOffset++] = ( gx + gw );
-        buffer[bufferOffset++] = ( gy );
-        buffer[bufferOffset++] = ( 1.0f );
-        buffer[bufferOffset++] = ( outlineThickness );
-        buffer[bufferOffset++] = ( u2 );
-        buffer[bufferOffset++] = ( v1 );
-        buffer[bufferOffset++] = ( localTextColor.x );
-        buffer[bufferOffset++] = ( localTextColor.y );
-        buffer[bufferOffset++] = ( localTextColor.z );
-        buffer[bufferOffset++] = ( localTextColor.w );
-
-        indiceCount += 6;
+        const float u1 = static_cast<float>( g.PositionX ) / atlasWidth;
+        const float u2 = u1 + ( static_cast<float>( g.Width ) / atlasWidth );
+        const float v1 = static_cast<float>( g.PositionY ) / atlasHeight;
+        const float v2 = v1 + ( static_cast<float>( g.Height ) / atlasHeight );
+
+        GlyphInstance glyph;
+        glyph.PositionAndSize = nyaVec4f( gx, gy, gw, gh );
+        glyph.TexCoordinates[0] = nya::maths::PackUnorm16( u1 );
+        glyph.TexCoordinates[1] = nya::maths::PackUnorm16( v1 );
+        glyph.TexCoordinates[2] = nya::maths::PackUnorm16( u2 );
+        glyph.TexCoordinates[3] = nya::maths::PackUnorm16( v2 );
+        glyph.Color = 0u;
+        glyph.OutlineThickness = 0.0f;
+
+        glyphRun.Glyphes.push_back( glyph );
     }
 }
+
+uint32_t TextRenderingModule::updateGlyphInstances( CommandList& cmdList )
+{
+    uint32_t uploadedGlyphCount = 0u;
+
+    // Contiguous range of instances to upload
+    uint32_t dirtyRangeBegin = 0u, dirtyRangeEnd = 0u;
+
+    auto flushDirtyRange = [&]() {
+        if ( dirtyRangeBegin == dirtyRangeEnd ) {
+            return;
+        }
+
+        const uint32_t rangeGlyphCount = ( dirtyRangeEnd - dirtyRangeBegin );
+
+        cmdList.updateBufferRange( glyphInstanceBuffer, &glyphInstances[dirtyRangeBegin], sizeof( GlyphInstance ) * rangeGlyphCount, sizeof( GlyphInstance ) * dirtyRangeBegin );
+
+        uploadedGlyphCount += rangeGlyphCount;
+        dirtyRangeBegin = dirtyRangeEnd = 0u;
+    };
+
+    for ( uint32_t runIdx = 0; runIdx < runCount; runIdx++ ) {
+        const GlyphRunDrawCommand& drawCmd = runs[runIdx];
+
+        if ( runIdx < uploadedRunCount ) {
+            const GlyphRunDrawCommand& uploadedCmd = uploadedRuns[runIdx];
+
+            const bool isUpToDate = ( uploadedCmd.LayoutKey == drawCmd.LayoutKey
+                && uploadedCmd.RunVersion == drawCmd.RunVersion
+                && uploadedCmd.Position.x == drawCmd.Position.x
+                && uploadedCmd.Position.y == drawCmd.Position.y
+                && uploadedCmd.Color == drawCmd.Color
+                && uploadedCmd.OutlineThickness == drawCmd.OutlineThickness
+                && uploadedCmd.GlyphOffset == drawCmd.GlyphOffset
+                && uploadedCmd.GlyphCount == drawCmd.GlyphCount );
+
+            if ( isUpToDate ) {
+                flushDirtyRange();
+                continue;
+            }
+        }
+
+        // Build absolute instances from the cached layout
+        const GlyphInstance* runGlyphes = drawCmd.Run->Glyphes.data();
+        GlyphInstance* instances = &glyphInstances[drawCmd.GlyphOffset];
+
+        for ( uint32_t glyphIdx = 0; glyphIdx < drawCmd.GlyphCount; glyphIdx++ ) {
+            instances[glyphIdx] = runGlyphes[glyphIdx];
+            instances[glyphIdx].PositionAndSize.x += drawCmd.Position.x;
+            instances[glyphIdx].PositionAndSize.y -= drawCmd.Position.y;
+            instances[glyphIdx].Color = drawCmd.Color;
+            instances[glyphIdx].OutlineThickness = drawCmd.OutlineThickness;
+        }
+
+        if ( dirtyRangeBegin == dirtyRangeEnd ) {
+            dirtyRangeBegin = drawCmd.GlyphOffset;
+        }
+
+        dirtyRangeEnd = drawCmd.GlyphOffset + drawCmd.GlyphCount;
+
+        uploadedRuns[runIdx] = drawCmd;
+    }
+
+    flushDirtyRange();
+
+    uploadedRunCount = runCount;
+
+    return uploadedGlyphCount;
+}
@@ -22,6 +22,10 @@
 
 #include <Maths/Vector.h>
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 struct Texture;
 struct FontDescriptor;
 struct PipelineState;
@@ -29,6 +33,7 @@ struct Buffer;
 
 class RenderPipeline;
 class RenderDevice;
+class CommandList;
 class GraphicsAssetCache;
 class ShaderCache;
 
@@ -37,7 +42,11 @@ using MutableResHandle_t = uint32_t;
 static constexpr int32_t MaxCharactersPerLine = 240;
 static constexpr int32_t MaxCharactersLines = 65;
 
-static constexpr int32_t TEXT_RENDERING_MAX_GLYPH_COUNT = MaxCharactersPerLine * MaxCharactersLines * 4;
+static constexpr int32_t TEXT_RENDERING_MAX_GLYPH_COUNT = MaxCharactersPerLine * MaxCharactersLines;
+static constexpr int32_t TEXT_RENDERING_MAX_RUN_COUNT = 512;
+
+// Number of frames an unused glyph run stays in the layout cache
+static constexpr uint32_t TEXT_RENDERING_RUN_EVICTION_DELAY = 120u;
 
 class TextRenderingModule
 {
@@ -50,21 +59,74 @@ public:
     MutableResHandle_t           renderText( RenderPipeline* renderPipeline, MutableResHandle_t output );
     void                         loadCachedResources( RenderDevice* renderDevice, ShaderCache* shaderCache, GraphicsAssetCache* graphicsAssetCache );
 
-    void                         addOutlinedText( const char* text, float size, float x, float y, const nyaVec4f& textColor = nyaVec4f( 1, 1, 1, 1 ), const float outlineThickness = 0.80f );
+    // wrapWidth: max width of a line in screen space (0 to disable wrapping)
+    void                         addOutlinedText( const char* text, float size, float x, float y, const nyaVec4f& textColor = nyaVec4f( 1, 1, 1, 1 ), const float outlineThickness = 0.80f, const float wrapWidth = 0.0f );
+
+    // Same as above, using a precomputed text key to skip the string hashing
+    // The key can either be the text hashcode (nya::core::CRC32) or a stable key for text updated every frame (e.g. profiling
+    // summaries); the cached run is then laid out again in place when the text changes instead of allocating a new run
+    void                         addOutlinedText( const char* text, const nyaStringHash_t textHashcode, float size, float x, float y, const nyaVec4f& textColor = nyaVec4f( 1, 1, 1, 1 ), const float outlineThickness = 0.80f, const float wrapWidth = 0.0f );
 
 private:
-    static constexpr int BUFFER_COUNT = 2;
+    // Per glyph instance data (32 bytes; the quad is expanded in the vertex shader)
+    struct GlyphInstance
+    {
+        nyaVec4f    PositionAndSize;
+        uint16_t    TexCoordinates[4];
+        uint32_t    Color;
+        float       OutlineThickness;
+    };
+
+    // Cached glyph layout (positions are relative to the run origin)
+    struct GlyphRun
+    {
+        std::vector<GlyphInstance>  Glyphes;
+        std::string                 Text;
+        uint32_t                    LastUsedFrame;
+        uint32_t                    Version; // Incremented each time the run is laid out again
+    };
+
+    struct GlyphRunDrawCommand
+    {
+        const GlyphRun* Run;
+        uint64_t        LayoutKey;
+        uint32_t        RunVersion;
+        nyaVec2f        Position;
+        uint32_t        Color;
+        float           OutlineThickness;
+        uint32_t        GlyphOffset;
+        uint32_t        GlyphCount;
+    };
 
 private:
     Texture*                    fontAtlas;
     FontDescriptor*             fontDescriptor;
     PipelineState*              renderTextPso;
 
-    uint32_t                    indiceCount;
-    uint32_t                    vertexBufferIndex;
-    Buffer*                     glyphVertexBuffers[BUFFER_COUNT];
+    Buffer*                     glyphInstanceBuffer;
     Buffer*                     glyphIndiceBuffer;
 
-    int                         bufferOffset;
-    float                       buffer[9 * TEXT_RENDERING_MAX_GLYPH_COUNT];
+    nyaStringHash_t             fontHashcode;
+    uint32_t                    frameIndex;
+    uint32_t                    glyphCount;
+    uint32_t                    cacheHitCount;
+    uint32_t                    cacheMissCount;
+
+    std::unordered_map<uint64_t, GlyphRun>  glyphRunCache;
+
+    GlyphRunDrawCommand         runs[TEXT_RENDERING_MAX_RUN_COUNT];
+    uint32_t                    runCount;
+
+    // Runs currently stored in the instance buffer (used to detect which runs need an upload)
+    GlyphRunDrawCommand         uploadedRuns[TEXT_RENDERING_MAX_RUN_COUNT];
+    uint32_t                    uploadedRunCount;
+
+    GlyphInstance               glyphInstances[TEXT_RENDERING_MAX_GLYPH_COUNT];
+
+private:
+    uint64_t                    computeLayoutKey( const nyaStringHash_t textHashcode, const float size, const float wrapWidth ) const;
+    uint64_t                    computeLayoutKey( const char* text, const float size, const float wrapWidth ) const;
+    const GlyphRun*             getOrLayoutGlyphRun( const char* text, const uint64_t layoutKey, const float size, const float wrapWidth );
+    void                        layoutGlyphRun( GlyphRun& glyphRun, const char* text, const float size, const float wrapWidth ) const;
+    uint32_t                    updateGlyphInstances( CommandList& cmdList );
 };
@@ -11,10 +11,57 @@
 #include <Framework/Material.h>
 #include <Shaders/ShadowMappingShared.h>
 
-ResHandle_t AddCSMCapturePass( RenderPipeline* renderPipeline )
+static RenderTarget*   g_CachedShadowMap = nullptr;
+static PipelineState*  g_TileClearPipelineStateObject = nullptr;
+
+void LoadCachedResourcesCSM( RenderDevice* renderDevice, ShaderCache* shaderCache )
+{
+    TextureDescription shadowMapDesc = {};
+    shadowMapDesc.dimension = TextureDescription::DIMENSION_TEXTURE_2D;
+    shadowMapDesc.format = eImageFormat::IMAGE_FORMAT_R32_TYPELESS;
+    shadowMapDesc.flags.isDepthResource = 1;
+    shadowMapDesc.width = CSM_SHADOW_MAP_DIMENSIONS * CSM_SLICE_COUNT;
+    shadowMapDesc.height = CSM_SHADOW_MAP_DIMENSIONS;
+
+    g_CachedShadowMap = renderDevice->createRenderTarget2D( shadowMapDesc );
+
+    // Cascades are cleared by drawing a triangle on the far plane (the shadow map is never cleared as a whole)
+    PipelineStateDesc psoDesc = {};
+    psoDesc.vertexShader = shaderCache->getOrUploadStage( "Lighting/ShadowTileClear", SHADER_STAGE_VERTEX );
+    psoDesc.pixelShader = shaderCache->getOrUploadStage( "Lighting/ShadowTileClear", SHADER_STAGE_PIXEL );
+    psoDesc.primitiveTopology = nya::rendering::ePrimitiveTopology::PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    psoDesc.rasterizerState.cullMode = nya::rendering::eCullMode::CULL_MODE_NONE;
+    psoDesc.depthStencilState.enableDepthTest = true;
+    psoDesc.depthStencilState.enableDepthWrite = true;
+    psoDesc.depthStencilState.depthComparisonFunc = nya::rendering::eComparisonFunction::COMPARISON_FUNCTION_ALWAYS;
+
+    psoDesc.renderPassLayout.attachements[0].stageBind = SHADER_STAGE_PIXEL;
+    psoDesc.renderPassLayout.attachements[0].bindMode = RenderPassLayoutDesc::WRITE_DEPTH;
+    psoDesc.renderPassLayout.attachements[0].targetState = RenderPassLayoutDesc::DONT_CARE;
+    psoDesc.renderPassLayout.attachements[0].viewFormat = eImageFormat::IMAGE_FORMAT_R32_TYPELESS;
+
+    g_TileClearPipelineStateObject = renderDevice->createPipelineState( psoDesc );
+}
+
+void FreeCachedResourcesCSM( RenderDevice* renderDevice )
+{
+    renderDevice->destroyRenderTarget( g_CachedShadowMap );
+    renderDevice->destroyPipelineState( g_TileClearPipelineStateObject );
+
+    g_CachedShadowMap = nullptr;
+    g_TileClearPipelineStateObject = nullptr;
+}
+
+CSMPassOutput AddCSMCapturePass( RenderPipeline* renderPipeline, const LocalShadowRenderModule::CaptureInfos* localShadows, const uint32_t cascadeUpdateMask, const bool useCachedShadowMap )
 {
+    if ( useCachedShadowMap ) {
+        renderPipeline->importPersistentRenderTarget( NYA_STRING_HASH( "CSM/CachedShadowMap" ), g_CachedShadowMap );
+    }
+
     struct PassData  {
         ResHandle_t output;
+        ResHandle_t localShadowAtlas;
+        ResHandle_t localShadowBuffer;
 
         ResHandle_t bilinearSampler;
 
@@ -45,7 +92,11 @@ ResHandle_t AddCSMCapturePass( RenderPipeline* renderPipeline )
             shadowMapRenderTargetDesc.width = CSM_SHADOW_MAP_DIMENSIONS * CSM_SLICE_COUNT;
             shadowMapRenderTargetDesc.height = CSM_SHADOW_MAP_DIMENSIONS;
 
-            passData.output = renderPipelineBuilder.allocateRenderTarget( shadowMapRenderTargetDesc );
+            if ( useCachedShadowMap ) {
+                passData.output = renderPipelineBuilder.retrievePersistentRenderTarget( NYA_STRING_HASH( "CSM/CachedShadowMap" ) );
+            } else {
+                passData.output = renderPipelineBuilder.allocateRenderTarget( shadowMapRenderTargetDesc );
+            }
 
             // Buffers
             BufferDesc instanceBufferDesc;
@@ -65,10 +116,8 @@ ResHandle_t AddCSMCapturePass( RenderPipeline* renderPipeline )
             BufferDesc vectorDataBufferDesc;
             vectorDataBufferDesc.type = BufferDesc::GENERIC_BUFFER;
             vectorDataBufferDesc.viewFormat = eImageFormat::IMAGE_FORMAT_R32G32B32A32_FLOAT;
-            vectorDataBufferDesc.size = sizeof( nyaVec4f ) * 1024;
-            vectorDataBufferDesc.stride = 1024;
 
-            passData.vectorDataBuffer = renderPipelineBuilder.allocateBuffer( vectorDataBufferDesc, SHADER_STAGE_VERTEX );
+            passData.vectorDataBuffer = renderPipelineBuilder.allocateBuffer( vectorDataBufferDesc, SHADER_STAGE_VERTEX, RenderPipelineBuilder::USE_PIPELINE_VECTOR_BUFFER_SIZE );
 
             // Misc Resources
             SamplerDesc bilinearSamplerDesc = {};
@@ -78,6 +127,11 @@ ResHandle_t AddCSMCapturePass( RenderPipeline* renderPipeline )
             bilinearSamplerDesc.filter = nya::rendering::eSamplerFilter::SAMPLER_FILTER_BILINEAR;
 
             passData.bilinearSampler = renderPipelineBuilder.allocateSampler( bilinearSamplerDesc );
+
+            if ( localShadows != nullptr ) {
+                passData.localShadowAtlas = renderPipelineBuilder.retrievePersistentRenderTarget( NYA_STRING_HASH( "LocalShadows/ShadowAtlas" ) );
+                passData.localShadowBuffer = renderPipelineBuilder.retrievePersistentBuffer( NYA_STRING_HASH( "LocalShadows/ShadowBuffer" ) );
+            }
         },
         [=]( const PassData& passData, const RenderPipelineResources& renderPipelineResources, RenderDevice* renderDevice ) {
             Sampler* bilinearSampler = renderPipelineResources.getSampler( passData.bilinearSampler );
@@ -99,22 +153,41 @@ ResHandle_t AddCSMCapturePass( RenderPipeline* renderPipeline )
 #endif
 
             // RenderPass
-            RenderTarget* outputTarget = renderPipelineResources.getRenderTarget( passData.output );
+            RenderTarget* outputTarget = ( useCachedShadowMap )
+                ? renderPipelineResources.getPersitentRenderTarget( passData.output )
+                : renderPipelineResources.getRenderTarget( passData.output );
 
             // Upload buffer data
             CommandList& cmdList = renderDevice->allocateGraphicsCommandList();
             cmdList.begin();
 
             const void* vectorBuffer = renderPipelineResources.getVectorBufferData();
-            cmdList.updateBuffer( vectorDataBuffer, vectorBuffer, sizeof( nyaVec4f ) * 1024 );
+            cmdList.updateBuffer( vectorDataBuffer, vectorBuffer, renderPipelineResources.getVectorBufferSize() );
 
             RenderPass renderPass;
             renderPass.attachement[0] = { outputTarget, 0, 0 };
-            cmdList.clearDepthStencilRenderTarget( outputTarget, 1.0f );
+
+            // Cached shadow map: only the cascades updated this frame are cleared (the others are reused as is)
+            if ( !useCachedShadowMap ) {
+                cmdList.clearDepthStencilRenderTarget( outputTarget, 1.0f );
+            }
 
             for ( int i = 0; i < CSM_SLICE_COUNT; i++ ) {
+                if ( ( cascadeUpdateMask & ( 1u << i ) ) == 0 ) {
+                    continue;
+                }
+
                 cmdList.setViewport( { CSM_SHADOW_MAP_DIMENSIONS * i, 0, CSM_SHADOW_MAP_DIMENSIONS, CSM_SHADOW_MAP_DIMENSIONS, 0.0f, 1.0f } );
 
+                if ( useCachedShadowMap ) {
+                    cmdList.beginRenderPass( g_TileClearPipelineStateObject, renderPass );
+                    {
+                        cmdList.bindPipelineState( g_TileClearPipelineStateObject );
+                        cmdList.draw( 3 );
+                    }
+                    cmdList.endRenderPass();
+                }
+
                 const auto& drawCmdBucket = renderPipelineResources.getDrawCmdBucket( DrawCommandKey::LAYER_DEPTH, static_cast<uint8_t>( DrawCommandKey::DEPTH_VIEWPORT_LAYER_CSM0 + i ) );
 
                 InstanceBuffer instanceBufferData;
@@ -144,10 +217,67 @@ ResHandle_t AddCSMCapturePass( RenderPipeline* renderPipeline )
                 }
             }
 
+            if ( localShadows != nullptr ) {
+                RenderTarget* localShadowAtlas = renderPipelineResources.getPersitentRenderTarget( passData.localShadowAtlas );
+                Buffer* localShadowBuffer = renderPipelineResources.getPersistentBuffer( passData.localShadowBuffer );
+
+                // Upload the shadow data for the lighting passes (updated even if no face is rendered since tiles might have been evicted)
+                cmdList.updateBuffer( localShadowBuffer, localShadows->ShadowBufferData, sizeof( LocalShadowRenderModule::ShadowBuffer ) );
+
+                RenderPass atlasRenderPass;
+                atlasRenderPass.attachement[0] = { localShadowAtlas, 0, 0 };
+
+                // Draw commands are sorted by face update index (viewport sub layer)
+                const auto& drawCmdBucket = renderPipelineResources.getDrawCmdBucket( DrawCommandKey::LAYER_DEPTH, DrawCommandKey::DEPTH_VIEWPORT_LAYER_LOCAL_SHADOW );
+                const DrawCmd* drawCmd = drawCmdBucket.begin();
+
+                InstanceBuffer instanceBufferData;
+                instanceBufferData.StartVector = drawCmdBucket.instanceDataStartOffset;
+                instanceBufferData.VectorPerInstance = drawCmdBucket.vectorPerInstance;
+
+                cmdList.updateBuffer( instanceBuffer, &instanceBufferData, sizeof( InstanceBuffer ) );
+
+                for ( uint32_t updateIdx = 0u; updateIdx < localShadows->FaceUpdateCount; updateIdx++ ) {
+                    const ShadowAtlasTile& tile = localShadows->FaceUpdates[updateIdx].Tile;
+                    cmdList.setViewport( { tile.X, tile.Y, tile.Size, tile.Size, 0.0f, 1.0f } );
+
+                    // Clear the tile (the rest of the atlas is cached)
+                    cmdList.beginRenderPass( localShadows->TileClearPipelineState, atlasRenderPass );
+                    {
+                        cmdList.bindPipelineState( localShadows->TileClearPipelineState );
+                        cmdList.draw( 3 );
+                    }
+                    cmdList.endRenderPass();
+
+                    for ( ; drawCmd != drawCmdBucket.end() && drawCmd->key.bitfield.viewportSubLayer == updateIdx; drawCmd++ ) {
+#if NYA_DEVBUILD
+                        const Material::EditorBuffer& matEditBuffer = drawCmd->infos.material->getEditorBuffer();
+                        cmdList.updateBuffer( materialEditorBuffer, &matEditBuffer, sizeof( Material::EditorBuffer ) );
+#endif
+
+                        drawCmd->infos.material->bindDepthOnly( renderDevice, cmdList, atlasRenderPass, resourceList );
+                        {
+                            cmdList.bindVertexBuffer( drawCmd->infos.vertexBuffer );
+                            cmdList.bindIndiceBuffer( drawCmd->infos.indiceBuffer );
+
+                            cmdList.drawInstancedIndexed( drawCmd->infos.indiceBufferCount, drawCmd->infos.instanceCount, drawCmd->infos.indiceBufferOffset );
+                        }
+                        cmdList.endRenderPass();
+
+                        instanceBufferData.StartVector += ( drawCmd->infos.instanceCount * drawCmdBucket.vectorPerInstance );
+                        cmdList.updateBuffer( instanceBuffer, &instanceBufferData, sizeof( InstanceBuffer ) );
+                    }
+                }
+            }
+
             cmdList.end();
             renderDevice->submitCommandList( &cmdList );
         }
     );
 
-    return passData.output;
+    CSMPassOutput output;
+    output.sunShadowMap = passData.output;
+    output.isCached = useCachedShadowMap;
+
+    return output;
 }
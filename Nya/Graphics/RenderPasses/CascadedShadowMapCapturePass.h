@@ -20,7 +20,27 @@
 
 #pragma once
 
+#include <Graphics/RenderModules/LocalShadowRenderModule.h>
+
 class RenderPipeline;
+class RenderDevice;
+class ShaderCache;
 using ResHandle_t = uint32_t;
 
-ResHandle_t AddCSMCapturePass( RenderPipeline* renderPipeline );
+static constexpr uint32_t CSM_ALL_CASCADES_MASK = ~0u;
+
+struct CSMPassOutput
+{
+    ResHandle_t sunShadowMap;
+
+    // If true, sunShadowMap is the persistent cached shadow map ("CSM/CachedShadowMap")
+    bool        isCached;
+};
+
+void LoadCachedResourcesCSM( RenderDevice* renderDevice, ShaderCache* shaderCache );
+void FreeCachedResourcesCSM( RenderDevice* renderDevice );
+
+// NOTE Local shadow faces (if any) are rendered to the persistent local shadow atlas by the same pass
+// If useCachedShadowMap is true, cascades are rendered to a persistent shadow map and only the cascades
+// flagged in cascadeUpdateMask are cleared and rendered (the others keep the content of the previous frames)
+CSMPassOutput AddCSMCapturePass( RenderPipeline* renderPipeline, const LocalShadowRenderModule::CaptureInfos* localShadows = nullptr, const uint32_t cascadeUpdateMask = CSM_ALL_CASCADES_MASK, const bool useCachedShadowMap = false );
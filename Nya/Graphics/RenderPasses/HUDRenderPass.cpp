@@ -57,10 +57,8 @@ ResHandle_t AddHUDRenderPass( RenderPipeline* renderPipeline, ResHandle_t output
             BufferDesc vectorDataBufferDesc;
             vectorDataBufferDesc.type = BufferDesc::GENERIC_BUFFER;
             vectorDataBufferDesc.viewFormat = eImageFormat::IMAGE_FORMAT_R32G32B32A32_FLOAT;
-            vectorDataBufferDesc.size = sizeof( nyaVec4f ) * 1024;
-            vectorDataBufferDesc.stride = 1024;
 
-            passData.vectorDataBuffer = renderPipelineBuilder.allocateBuffer( vectorDataBufferDesc, SHADER_STAGE_VERTEX );
+            passData.vectorDataBuffer = renderPipelineBuilder.allocateBuffer( vectorDataBufferDesc, SHADER_STAGE_VERTEX, RenderPipelineBuilder::USE_PIPELINE_VECTOR_BUFFER_SIZE );
 
 #if NYA_DEVBUILD
             BufferDesc materialBufferDesc;
@@ -105,7 +103,7 @@ ResHandle_t AddHUDRenderPass( RenderPipeline* renderPipeline, ResHandle_t output
 
             // Upload buffer data
             const void* vectorBuffer = renderPipelineResources.getVectorBufferData();
-            cmdList.updateBuffer( vectorDataBuffer, vectorBuffer, sizeof( nyaVec4f ) * 1024 );
+            cmdList.updateBuffer( vectorDataBuffer, vectorBuffer, renderPipelineResources.getVectorBufferSize() );
 
             const CameraData* cameraData = renderPipelineResources.getMainCamera();
 
@@ -1,5 +1,6 @@
 #include <Shared.h>
 #include "LightRenderPass.h"
+#include "CascadedShadowMapCapturePass.h"
 
 #include <Graphics/ShaderCache.h>
 #include <Graphics/RenderPipeline.h>
@@ -23,7 +24,7 @@ NYA_ENV_OPTION_LIST( TextureFiltering, TEXTURE_FILTERING_OPTION_LIST )
 
 NYA_ENV_VAR( TextureFiltering, BILINEAR, eTextureFiltering ) // "Defines texture filtering quality [Bilinear/Trilinear/Anisotropic (8)/Anisotropic (16)]"
 
-LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightGrid::PassData& lightClustersInfos, ResHandle_t sunShadowMap, ResHandle_t output, const bool isCapturingProbe )
+LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightGrid::PassData& lightClustersInfos, const CSMPassOutput& sunShadowMap, ResHandle_t output, const bool isCapturingProbe )
 {
     struct PassData  {
         ResHandle_t input;
@@ -35,6 +36,7 @@ LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightG
         ResHandle_t iblDiffuseArray;
         ResHandle_t iblSpecularArray;
         ResHandle_t iblCapturedArray;
+        ResHandle_t localShadowAtlas;
 
         ResHandle_t bilinearSampler;
         ResHandle_t anisotropicSampler;
@@ -44,7 +46,10 @@ LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightG
         ResHandle_t instanceBuffer;
         ResHandle_t clustersBuffer;
         ResHandle_t lightsBuffer;
+        ResHandle_t pointLightsBuffer;
+        ResHandle_t iblProbesBuffer;
         ResHandle_t itemListBuffer;
+        ResHandle_t localShadowBuffer;
 
         ResHandle_t sceneInfosBuffer;
         ResHandle_t vectorDataBuffer;
@@ -66,11 +71,17 @@ LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightG
         [&]( RenderPipelineBuilder& renderPipelineBuilder, PassData& passData ) {
             // Render Targets
             passData.input = renderPipelineBuilder.readRenderTarget( output );
-            passData.sunShadowMap = renderPipelineBuilder.readRenderTarget( sunShadowMap );
+            if ( sunShadowMap.isCached ) {
+                passData.sunShadowMap = renderPipelineBuilder.retrievePersistentRenderTarget( NYA_STRING_HASH( "CSM/CachedShadowMap" ) );
+            } else {
+                passData.sunShadowMap = renderPipelineBuilder.readRenderTarget( sunShadowMap.sunShadowMap );
+            }
 
             passData.iblCapturedArray = renderPipelineBuilder.retrievePersistentRenderTarget( NYA_STRING_HASH( "IBL/CapturedProbesArray" ) );
             passData.iblDiffuseArray = renderPipelineBuilder.retrievePersistentRenderTarget( NYA_STRING_HASH( "IBL/DiffuseProbesArray" ) );
             passData.iblSpecularArray = renderPipelineBuilder.retrievePersistentRenderTarget( NYA_STRING_HASH( "IBL/SpecularProbesArray" ) );
+            passData.localShadowAtlas = renderPipelineBuilder.retrievePersistentRenderTarget( NYA_STRING_HASH( "LocalShadows/ShadowAtlas" ) );
+            passData.localShadowBuffer = renderPipelineBuilder.retrievePersistentBuffer( NYA_STRING_HASH( "LocalShadows/ShadowBuffer" ) );
 
             TextureDescription velocityRenderTargetDesc = {};
             velocityRenderTargetDesc.dimension = TextureDescription::DIMENSION_TEXTURE_2D;
@@ -104,7 +115,9 @@ LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightG
             passData.instanceBuffer = renderPipelineBuilder.allocateBuffer( instanceBufferDesc, SHADER_STAGE_VERTEX );
 
             passData.clustersBuffer = renderPipelineBuilder.readBuffer( lightClustersInfos.lightsClusters );
-            passData.lightsBuffer = renderPipelineBuilder.readBuffer( lightClustersInfos.lightsBuffer );
+            passData.lightsBuffer = lightClustersInfos.lightsBuffer;
+            passData.pointLightsBuffer = lightClustersInfos.pointLightsBuffer;
+            passData.iblProbesBuffer = lightClustersInfos.iblProbesBuffer;
             passData.sceneInfosBuffer = renderPipelineBuilder.readBuffer( lightClustersInfos.lightsClustersInfosBuffer );
             passData.itemListBuffer = renderPipelineBuilder.readBuffer( lightClustersInfos.itemList );
 
@@ -125,10 +138,8 @@ LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightG
             BufferDesc vectorDataBufferDesc;
             vectorDataBufferDesc.type = BufferDesc::GENERIC_BUFFER;
             vectorDataBufferDesc.viewFormat = eImageFormat::IMAGE_FORMAT_R32G32B32A32_FLOAT;
-            vectorDataBufferDesc.size = sizeof( nyaVec4f ) * 1024;
-            vectorDataBufferDesc.stride = 1024;
 
-            passData.vectorDataBuffer = renderPipelineBuilder.allocateBuffer( vectorDataBufferDesc, SHADER_STAGE_VERTEX );
+            passData.vectorDataBuffer = renderPipelineBuilder.allocateBuffer( vectorDataBufferDesc, SHADER_STAGE_VERTEX, RenderPipelineBuilder::USE_PIPELINE_VECTOR_BUFFER_SIZE );
 
             // Misc Resources
             SamplerDesc bilinearSamplerDesc = {};
@@ -184,18 +195,24 @@ LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightG
             Buffer* sceneInfosBuffer = renderPipelineResources.getBuffer( passData.sceneInfosBuffer );
             Buffer* cameraBuffer = renderPipelineResources.getBuffer( passData.cameraBuffer );
             Buffer* vectorDataBuffer = renderPipelineResources.getBuffer( passData.vectorDataBuffer );
-            Buffer* lightsBuffer = renderPipelineResources.getBuffer( passData.lightsBuffer );
+            Buffer* lightsBuffer = renderPipelineResources.getPersistentBuffer( passData.lightsBuffer );
+            Buffer* pointLightsBuffer = renderPipelineResources.getPersistentBuffer( passData.pointLightsBuffer );
+            Buffer* iblProbesBuffer = renderPipelineResources.getPersistentBuffer( passData.iblProbesBuffer );
             Buffer* itemListBuffer = renderPipelineResources.getBuffer( passData.itemListBuffer );
+            Buffer* localShadowBuffer = renderPipelineResources.getPersistentBuffer( passData.localShadowBuffer );
 
 #if NYA_DEVBUILD
             Buffer* materialEditorBuffer = renderPipelineResources.getBuffer( passData.materialEditionBuffer );
 #endif
 
-            RenderTarget* sunShadowMapTarget = renderPipelineResources.getRenderTarget( passData.sunShadowMap );
+            RenderTarget* sunShadowMapTarget = ( sunShadowMap.isCached )
+                ? renderPipelineResources.getPersitentRenderTarget( passData.sunShadowMap )
+                : renderPipelineResources.getRenderTarget( passData.sunShadowMap );
 
             RenderTarget* iblCapturedArray = renderPipelineResources.getPersitentRenderTarget( passData.iblCapturedArray );
             RenderTarget* iblDiffuseArray = renderPipelineResources.getPersitentRenderTarget( passData.iblDiffuseArray );
             RenderTarget* iblSpecularArray = renderPipelineResources.getPersitentRenderTarget( passData.iblSpecularArray );
+            RenderTarget* localShadowAtlas = renderPipelineResources.getPersitentRenderTarget( passData.localShadowAtlas );
 
             ResourceList resourceList;
             resourceList.resource[0].sampler = bilinearSampler;
@@ -216,6 +233,10 @@ LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightG
             resourceList.resource[11].renderTarget = sunShadowMapTarget;
             resourceList.resource[12].renderTarget = iblDiffuseArray;
             resourceList.resource[13].renderTarget = iblSpecularArray;
+            resourceList.resource[14].buffer = pointLightsBuffer;
+            resourceList.resource[15].buffer = iblProbesBuffer;
+            resourceList.resource[16].renderTarget = localShadowAtlas;
+            resourceList.resource[17].buffer = localShadowBuffer;
 
             // RenderPass
             RenderTarget* outputTarget = renderPipelineResources.getRenderTarget( passData.input );
@@ -228,7 +249,7 @@ LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightG
 
             CommandList& cmdList = renderDevice->allocateGraphicsCommandList();
             cmdList.begin();
-            cmdList.updateBuffer( vectorDataBuffer, vectorBuffer, sizeof( nyaVec4f ) * 1024 );
+            cmdList.updateBuffer( vectorDataBuffer, vectorBuffer, renderPipelineResources.getVectorBufferSize() );
 
             const CameraData* cameraData = renderPipelineResources.getMainCamera();
 
@@ -252,6 +273,7 @@ LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightG
             renderPass.attachement[4] = { sunShadowMapTarget, 0u, 0u };
             renderPass.attachement[5] = { iblDiffuseArray, 0u, 0u };
             renderPass.attachement[6] = { iblSpecularArray, 0u, 0u };
+            renderPass.attachement[7] = { localShadowAtlas, 0u, 0u };
 
             // Clear renderTargets only once (kinda crap since we can't reuse the renderpass cleaning of D3D12/Vulkan)
             RenderTarget* clearRenderTargets[2] = {
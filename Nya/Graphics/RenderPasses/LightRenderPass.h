@@ -25,6 +25,7 @@ using ResHandle_t = uint32_t;
 
 struct Texture;
 struct Buffer;
+struct CSMPassOutput;
 
 #include <Graphics/LightGrid.h>
 
@@ -35,4 +36,4 @@ struct LightPassOutput
     ResHandle_t velocityRenderTarget;
 };
 
-LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightGrid::PassData& lightClustersInfos, ResHandle_t sunShadowMap, ResHandle_t output, const bool isCapturingProbe = false );
+LightPassOutput AddLightRenderPass( RenderPipeline* renderPipeline, const LightGrid::PassData& lightClustersInfos, const CSMPassOutput& sunShadowMap, ResHandle_t output, const bool isCapturingProbe = false );
@@ -23,9 +23,13 @@
 #include "GraphicsProfiler.h"
 
 #include <Rendering/ImageFormat.h>
+#include <Rendering/CommandList.h>
 
 #include <string.h>
 
+// Initial instance vector buffer size (in bytes); the buffer grows if the frame draw commands need more space
+static constexpr size_t INSTANCE_BUFFER_DEFAULT_SIZE = sizeof( nyaVec4f ) * 1024;
+
 RenderPipelineBuilder::RenderPipelineBuilder()
     : passRefs{ {0} }
     , renderPassCount( -1 )
@@ -106,6 +110,13 @@ void RenderPipelineBuilder::compile( RenderDevice* renderDevice, RenderPipelineR
 
     for ( uint32_t i = 0; i < bufferCount; i++ ) {
         auto& resToAlloc = buffers[i];
+
+        // NOTE Draw commands are dispatched before the pipeline is compiled (the vector buffer size is known at this point)
+        if ( resToAlloc.flags & eRenderTargetFlags::USE_PIPELINE_VECTOR_BUFFER_SIZE ) {
+            resToAlloc.description.size = resources.getVectorBufferSize();
+            resToAlloc.description.stride = static_cast<uint32_t>( resToAlloc.description.size / sizeof( nyaVec4f ) );
+        }
+
         resources.allocateBuffer( renderDevice, i, resToAlloc.description );
     }
 
@@ -204,7 +215,8 @@ ResHandle_t RenderPipelineBuilder::allocateBuffer( BufferDesc& description, cons
     buffers[bufferCount] = {
         description,
         shaderStageBinding,
-        0u
+        0u,
+        flags
     };
 
     auto& passInfos = passRefs[renderPassCount];
@@ -257,7 +269,10 @@ ResHandle_t RenderPipelineBuilder::retrievePersistentBuffer( const nyaStringHash
 }
 
 RenderPipelineResources::RenderPipelineResources()
-    : cbuffers{ 0 }
+    : memoryAllocator( nullptr )
+    , instanceBufferData( nullptr )
+    , instanceBufferSize( 0 )
+    , cbuffers{ 0 }
     , isCBufferFree{ false }
     , cbufferAllocatedCount( 0 )
     , genBuffer{ 0 }
@@ -291,13 +306,21 @@ RenderPipelineResources::~RenderPipelineResources()
 
 void RenderPipelineResources::create( BaseAllocator* allocator )
 {
-    instanceBufferData = nya::core::allocateArray<uint8_t>( allocator, sizeof( nyaVec4f ) * 1024 );
-    memset( instanceBufferData, 0, sizeof( nyaVec4f ) * 1024 );
+    memoryAllocator = allocator;
+    instanceBufferSize = INSTANCE_BUFFER_DEFAULT_SIZE;
+    instanceBufferData = nya::core::allocateArray<uint8_t>( allocator, instanceBufferSize );
+    memset( instanceBufferData, 0, instanceBufferSize );
+
+    persistentBuffers.create( allocator, 64u );
+    persistentRenderTarget.create( allocator, 64u );
 }
 
 void RenderPipelineResources::destroy( BaseAllocator* allocator )
 {
     nya::core::freeArray<uint8_t>( allocator, (uint8_t*)instanceBufferData );
+
+    persistentBuffers.destroy();
+    persistentRenderTarget.destroy();
 }
 
 void RenderPipelineResources::releaseResources( RenderDevice* renderDevice )
@@ -354,10 +377,17 @@ void RenderPipelineResources::updateVectorBuffer( const DrawCmd& cmd, size_t& in
     switch ( cmd.key.bitfield.layer ) {
     case DrawCommandKey::LAYER_DEPTH: {
         const size_t instancesDataSize = sizeof( nyaMat4x4f ) * cmd.infos.instanceCount;
-        
-        nyaMat4x4f modelViewProjection = *cmd.infos.modelMatrix * activeCameraData.shadowViewMatrix[cmd.key.bitfield.viewportLayer - 1u];
-        memcpy( ( uint8_t* )instanceBufferData + instanceBufferOffset, &modelViewProjection, sizeof( nyaMat4x4f ) );
-         
+
+        NYA_DEV_ASSERT( instanceBufferOffset + instancesDataSize <= instanceBufferSize, "Instance vector buffer overflow (%u bytes)", static_cast<uint32_t>( instanceBufferOffset + instancesDataSize ) );
+
+        // Local shadow casters matrices are premultiplied by the builder (one view projection per atlas face)
+        if ( cmd.key.bitfield.viewportLayer == DrawCommandKey::DEPTH_VIEWPORT_LAYER_LOCAL_SHADOW ) {
+            memcpy( ( uint8_t* )instanceBufferData + instanceBufferOffset, cmd.infos.modelMatrix, instancesDataSize );
+        } else {
+            nyaMat4x4f modelViewProjection = *cmd.infos.modelMatrix * activeCameraData.shadowViewMatrix[cmd.key.bitfield.viewportLayer - 1u];
+            memcpy( ( uint8_t* )instanceBufferData + instanceBufferOffset, &modelViewProjection, sizeof( nyaMat4x4f ) );
+        }
+
         instanceBufferOffset += instancesDataSize;
     } break;
 
@@ -365,6 +395,8 @@ void RenderPipelineResources::updateVectorBuffer( const DrawCmd& cmd, size_t& in
     default: {
         const size_t instancesDataSize = sizeof( nyaMat4x4f ) * cmd.infos.instanceCount;
 
+        NYA_DEV_ASSERT( instanceBufferOffset + instancesDataSize <= instanceBufferSize, "Instance vector buffer overflow (%u bytes)", static_cast<uint32_t>( instanceBufferOffset + instancesDataSize ) );
+
         memcpy( ( uint8_t* )instanceBufferData + instanceBufferOffset, cmd.infos.modelMatrix, instancesDataSize );
 
         instanceBufferOffset += instancesDataSize;
@@ -374,10 +406,30 @@ void RenderPipelineResources::updateVectorBuffer( const DrawCmd& cmd, size_t& in
 
 void RenderPipelineResources::dispatchToBuckets( DrawCmd* drawCmds, const size_t drawCmdCount )
 {
+    // Reset buckets from the previous frame (a layer might be empty this frame)
+    memset( drawCmdBuckets, 0, sizeof( drawCmdBuckets ) );
+
     if ( drawCmdCount == 0 ) {
         return; 
     }
 
+    // Grow the vector buffer if the frame instances do not fit (passes allocate their GPU copy from the buffer size)
+    size_t instanceBufferRequiredSize = 0ull;
+    for ( size_t drawCmdIdx = 0; drawCmdIdx < drawCmdCount; drawCmdIdx++ ) {
+        instanceBufferRequiredSize += sizeof( nyaMat4x4f ) * drawCmds[drawCmdIdx].infos.instanceCount;
+    }
+
+    if ( instanceBufferRequiredSize > instanceBufferSize ) {
+        nya::core::freeArray<uint8_t>( memoryAllocator, ( uint8_t* )instanceBufferData );
+
+        while ( instanceBufferSize < instanceBufferRequiredSize ) {
+            instanceBufferSize *= 2;
+        }
+
+        instanceBufferData = nya::core::allocateArray<uint8_t>( memoryAllocator, instanceBufferSize );
+        memset( instanceBufferData, 0, instanceBufferSize );
+    }
+
     const auto& firstDrawCmdKey = drawCmds[0].key.bitfield;
 
     DrawCommandKey::Layer layer = firstDrawCmdKey.layer;
@@ -436,6 +488,11 @@ void* RenderPipelineResources::getVectorBufferData() const
     return instanceBufferData;
 }
 
+size_t RenderPipelineResources::getVectorBufferSize() const
+{
+    return instanceBufferSize;
+}
+
 const CameraData* RenderPipelineResources::getMainCamera() const
 {
     return &activeCameraData;
@@ -670,6 +727,8 @@ RenderPipeline::RenderPipeline( BaseAllocator* allocator )
     , pipelineImageQuality( 1.0f )
     , lastFrameRenderTarget( nullptr )
     , graphicsProfiler( nullptr )
+    , profilingFrameIndex( 0ull )
+    , profilingViewKey( 0u )
 {
     renderPipelineResources.create( allocator );
 }
@@ -734,8 +793,27 @@ void RenderPipeline::execute( RenderDevice* renderDevice, const float deltaTime
     renderPipelineBuilder.cullRenderPasses( renderPasses, renderPassCount );
     renderPipelineBuilder.compile( renderDevice, renderPipelineResources );
 
+#if NYA_DEVBUILD
+    if ( graphicsProfiler != nullptr ) {
+        graphicsProfiler->onFrame( renderDevice, profilingFrameIndex, profilingViewKey );
+    }
+#endif
+
     for ( int passIdx = 0; passIdx < renderPassCount; passIdx++ ) {
+#if NYA_DEVBUILD
+        // Each pass is timed separately (timestamps are written in the command lists recorded by the pass)
+        if ( graphicsProfiler != nullptr ) {
+            graphicsProfiler->beginSection( renderPasses[passIdx].name );
+        }
+#endif
+
         renderPasses[passIdx].execute( renderPipelineResources, renderDevice );
+
+#if NYA_DEVBUILD
+        if ( graphicsProfiler != nullptr ) {
+            graphicsProfiler->endSection();
+        }
+#endif
     }
 
     renderPassCount = 0;
@@ -783,6 +861,27 @@ void RenderPipeline::importPersistentBuffer( const nyaStringHash_t resourceHashc
     renderPipelineResources.importPersistentBuffer( resourceHashcode, buffer );
 }
 
+void RenderPipeline::setProfilingKey( const uint64_t frameIndex, const nyaStringHash_t viewKey )
+{
+    profilingFrameIndex = frameIndex;
+    profilingViewKey = viewKey;
+}
+
+bool RenderPipeline::getLastGPUTiming( PipelineGPUTiming& timing ) const
+{
+#if NYA_DEVBUILD
+    GraphicsProfiler::FrameResult frameResult;
+    if ( graphicsProfiler != nullptr && graphicsProfiler->getLastFrameResult( frameResult ) ) {
+        timing.FrameIndex = frameResult.FrameIndex;
+        timing.ViewKey = frameResult.ViewKey;
+        timing.GPUTime = frameResult.GPUTime;
+        return true;
+    }
+#endif
+
+    return false;
+}
+
 #if NYA_DEVBUILD
 const char* RenderPipeline::getProfilingSummary() const
 {
@@ -20,7 +20,8 @@
 #pragma once
 
 #include <functional>
-#include <map>
+
+#include <Core/Containers/HashMap.h>
 
 #include <Rendering/RenderDevice.h>
 #include <Rendering/CommandList.h>
@@ -66,6 +67,7 @@ public:
     enum eRenderTargetFlags {
         USE_PIPELINE_DIMENSIONS     = 1 << 0, // Use builder viewport dimensions (override width/height)
         USE_PIPELINE_SAMPLER_COUNT  = 1 << 1, // Use builder sampler count (override samplerCount)
+        USE_PIPELINE_VECTOR_BUFFER_SIZE = 1 << 2, // Use the instance vector buffer size of the frame (override size/stride; buffers only)
     };
 
     enum eRenderTargetCopyFlags {
@@ -125,6 +127,7 @@ private:
         BufferDesc  description;
         uint32_t    shaderStageBinding;
         uint32_t    referenceCount;
+        uint32_t    flags;
     } buffers[48]; 
     uint32_t bufferCount;
 
@@ -186,6 +189,7 @@ public:
 
     const DrawCmdBucket&    getDrawCmdBucket( const DrawCommandKey::Layer layer, const uint8_t viewportLayer ) const;
     void*                   getVectorBufferData() const;
+    size_t                  getVectorBufferSize() const;
 
     const CameraData*       getMainCamera() const;
     const Viewport*         getMainViewport() const;
@@ -212,7 +216,9 @@ public:
     bool                    isPersistentBufferAvailable( const nyaStringHash_t resourceHashcode ) const;
 
 private:
+    BaseAllocator*          memoryAllocator;
     void*                   instanceBufferData;
+    size_t                  instanceBufferSize;
 
     Buffer*                 cbuffers[96];
     size_t                  cbuffersSize[96];
@@ -262,8 +268,8 @@ private:
     float                   pipelineImageQuality;
     float                   deltaTime;
 
-    std::map<nyaStringHash_t, Buffer*>          persistentBuffers;
-    std::map<nyaStringHash_t, RenderTarget*>    persistentRenderTarget;
+    HashMap<nyaStringHash_t, Buffer*>           persistentBuffers;
+    HashMap<nyaStringHash_t, RenderTarget*>     persistentRenderTarget;
 
 private:
     void                    updateVectorBuffer( const DrawCmd& cmd, size_t& instanceBufferOffset );
@@ -315,6 +321,13 @@ public:
         return passData;
     }
 
+    // Tag the GPU timings of the next execution (the pipeline can render a different view on each frame)
+    void        setProfilingKey( const uint64_t frameIndex, const nyaStringHash_t viewKey );
+
+    // GPU timing retrieved during the latest execution (results are a few executions late)
+    // Returns false if no result is available (GPU profiling is only available in dev builds)
+    bool        getLastGPUTiming( PipelineGPUTiming& timing ) const;
+
 #if NYA_DEVBUILD
     const char* getProfilingSummary() const;
 #endif
@@ -336,4 +349,6 @@ private:
     RenderPipelineBuilder               renderPipelineBuilder;
 
     GraphicsProfiler*                   graphicsProfiler;
+    uint64_t                            profilingFrameIndex;
+    nyaStringHash_t                     profilingViewKey;
 };
@@ -37,6 +37,9 @@ ShaderCache::ShaderCache( BaseAllocator* allocator, RenderDevice* activeRenderDe
     , renderDevice( activeRenderDevice )
     , memoryAllocator( allocator )
 {
+    // Leave room for the shader permutations (slots are not reclaimed by linear allocators if the map grows)
+    cachedStages.create( memoryAllocator, 1024u );
+
     defaultVertexStage = getOrUploadStage( "Error", eShaderStage::SHADER_STAGE_VERTEX );
     defaultPixelStage = getOrUploadStage( "Error", eShaderStage::SHADER_STAGE_PIXEL );
     defaultComputeStage = getOrUploadStage( "Error", eShaderStage::SHADER_STAGE_COMPUTE );
@@ -20,7 +20,7 @@
 
 #pragma once
 
-#include <map>
+#include <Core/Containers/HashMap.h>
 
 #include <Rendering/RenderDevice.h>
 
@@ -45,7 +45,7 @@ private:
     RenderDevice*                                   renderDevice;
     BaseAllocator*                                  memoryAllocator;
 
-	std::map<nyaStringHash_t, Shader*>	            cachedStages;
+    HashMap<nyaStringHash_t, Shader*>               cachedStages;
 
     // Fallbacks incase of missing shader
     Shader*                                         defaultVertexStage;
@@ -0,0 +1,344 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "ShadowAtlas.h"
+
+#include <Maths/AABB.h>
+#include <Maths/Helpers.h>
+
+#include <algorithm>
+#include <string.h>
+
+// Squared distance (in world units) a light has to move to invalidate its shadow maps
+static constexpr float LIGHT_MOVE_THRESHOLD_SQUARED = 1e-6f;
+
+static uint32_t GetFaceMask( const uint32_t faceCount )
+{
+    return ( 1u << faceCount ) - 1u;
+}
+
+static bool SphereAABBIntersectionTest( const nyaVec3f& sphereCenter, const float sphereRadius, const AABB& aabb )
+{
+    const nyaVec3f closestPoint = nyaVec3f::min( nyaVec3f::max( sphereCenter, aabb.minPoint ), aabb.maxPoint );
+    const nyaVec3f distance = ( sphereCenter - closestPoint );
+
+    return nyaVec3f::dot( distance, distance ) <= ( sphereRadius * sphereRadius );
+}
+
+ShadowAtlas::ShadowAtlas()
+    : minTileDimension( 0u )
+    , maxTileDimension( 0u )
+    , frameIndex( 0u )
+{
+    memset( slots, 0, sizeof( Slot ) * MAX_SLOT_COUNT );
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+    minTileDimension = 0u;
+    maxTileDimension = 0u;
+    frameIndex = 0u;
+}
+
+void ShadowAtlas::create( const uint32_t atlasDimension, const uint32_t minTileDimension, const uint32_t maxTileDimension )
+{
+    allocator.create( atlasDimension, minTileDimension );
+
+    this->minTileDimension = allocator.getMinTileDimension();
+    this->maxTileDimension = nya::maths::clamp( maxTileDimension, this->minTileDimension, allocator.getAtlasDimension() );
+
+    clear();
+}
+
+void ShadowAtlas::clear()
+{
+    allocator.clear();
+
+    memset( slots, 0, sizeof( Slot ) * MAX_SLOT_COUNT );
+    frameIndex = 0u;
+}
+
+uint32_t ShadowAtlas::update( const LocalShadowRequest* requests, const uint32_t requestCount, LocalShadowFaceUpdate* updates, const uint32_t maxUpdateCount )
+{
+    frameIndex++;
+
+    // Lights with the largest footprint get their tiles first
+    sortedRequests.resize( requestCount );
+    for ( uint32_t i = 0u; i < requestCount; i++ ) {
+        sortedRequests[i] = i;
+    }
+
+    std::stable_sort( sortedRequests.begin(), sortedRequests.end(), [&]( const uint32_t left, const uint32_t right ) {
+        return requests[left].ScreenFootprint > requests[right].ScreenFootprint;
+    } );
+
+    const uint32_t acceptedRequestCount = nya::maths::min( requestCount, MAX_SLOT_COUNT );
+
+    // Flag the slots requested this frame first (so that they can't be evicted by a new request)
+    int32_t requestSlots[MAX_SLOT_COUNT];
+    for ( uint32_t i = 0u; i < acceptedRequestCount; i++ ) {
+        const LocalShadowRequest& request = requests[sortedRequests[i]];
+
+        requestSlots[i] = findSlot( request.LightIndex );
+
+        if ( requestSlots[i] >= 0 ) {
+            slots[requestSlots[i]].LastRequestFrame = frameIndex;
+        }
+    }
+
+    // Scale every tile down until the requests fit in the atlas (keeps the relative resolution between lights)
+    uint32_t tileDimensions[MAX_SLOT_COUNT];
+    for ( uint32_t i = 0u; i < acceptedRequestCount; i++ ) {
+        tileDimensions[i] = computeTileDimension( requests[sortedRequests[i]].ScreenFootprint );
+    }
+
+    const uint64_t atlasArea = static_cast<uint64_t>( allocator.getAtlasDimension() ) * allocator.getAtlasDimension();
+    while ( true ) {
+        uint64_t requestedArea = 0ull;
+        bool canShrink = false;
+
+        for ( uint32_t i = 0u; i < acceptedRequestCount; i++ ) {
+            const uint32_t faceCount = nya::maths::clamp( requests[sortedRequests[i]].FaceCount, 1u, MAX_FACE_COUNT );
+
+            requestedArea += static_cast<uint64_t>( tileDimensions[i] ) * tileDimensions[i] * faceCount;
+            canShrink |= ( tileDimensions[i] > minTileDimension );
+        }
+
+        if ( requestedArea <= atlasArea || !canShrink ) {
+            break;
+        }
+
+        for ( uint32_t i = 0u; i < acceptedRequestCount; i++ ) {
+            tileDimensions[i] = nya::maths::max( tileDimensions[i] >> 1u, minTileDimension );
+        }
+    }
+
+    for ( uint32_t i = 0u; i < acceptedRequestCount; i++ ) {
+        const LocalShadowRequest& request = requests[sortedRequests[i]];
+
+        const uint32_t tileDimension = tileDimensions[i];
+        const uint32_t faceCount = nya::maths::clamp( request.FaceCount, 1u, MAX_FACE_COUNT );
+
+        if ( requestSlots[i] >= 0 ) {
+            Slot& slot = slots[requestSlots[i]];
+
+            const bool hasMoved = nyaVec3f::distanceSquared( slot.WorldPosition, request.WorldPosition ) > LIGHT_MOVE_THRESHOLD_SQUARED
+                                || slot.Radius != request.Radius;
+
+            if ( hasMoved ) {
+                slot.WorldPosition = request.WorldPosition;
+                slot.Radius = request.Radius;
+                slot.DirtyFaceMask = GetFaceMask( slot.FaceCount );
+            }
+
+            // Only shrink tiles which are two levels (or more) too large to avoid reallocating tiles each frame when
+            // the footprint oscillates around a power of two
+            const bool needResize = ( faceCount != slot.FaceCount )
+                                 || ( tileDimension > slot.RequestedTileSize )
+                                 || ( tileDimension * 4u <= slot.RequestedTileSize );
+
+            if ( needResize ) {
+                releaseSlotTiles( slot );
+
+                slot.FaceCount = faceCount;
+                if ( !allocateSlotTiles( slot, tileDimension ) ) {
+                    requestSlots[i] = -1;
+                }
+            }
+        } else {
+            int32_t slotIndex = findSlot( ~0u );
+            if ( slotIndex < 0 && evictLeastRecentlyUsedSlot() ) {
+                slotIndex = findSlot( ~0u );
+            }
+
+            if ( slotIndex < 0 ) {
+                continue;
+            }
+
+            Slot& slot = slots[slotIndex];
+            slot.LightIndex = request.LightIndex;
+            slot.WorldPosition = request.WorldPosition;
+            slot.Radius = request.Radius;
+            slot.FaceCount = faceCount;
+            slot.LastRequestFrame = frameIndex;
+
+            if ( allocateSlotTiles( slot, tileDimension ) ) {
+                requestSlots[i] = slotIndex;
+            }
+        }
+    }
+
+    // Emit dirty faces (following the requests priority)
+    uint32_t updateCount = 0u;
+    for ( uint32_t i = 0u; i < acceptedRequestCount && updateCount < maxUpdateCount; i++ ) {
+        if ( requestSlots[i] < 0 ) {
+            continue;
+        }
+
+        Slot& slot = slots[requestSlots[i]];
+
+        for ( uint32_t faceIdx = 0u; faceIdx < slot.FaceCount && updateCount < maxUpdateCount; faceIdx++ ) {
+            const uint32_t faceBit = ( 1u << faceIdx );
+            if ( ( slot.DirtyFaceMask & faceBit ) == 0u ) {
+                continue;
+            }
+
+            updates[updateCount++] = { slot.LightIndex, static_cast<uint32_t>( requestSlots[i] ), faceIdx, slot.Tiles[faceIdx] };
+            slot.DirtyFaceMask &= ~faceBit;
+
+            slot.FaceCapturePositions[faceIdx] = slot.WorldPosition;
+            slot.FaceCaptureRadii[faceIdx] = slot.Radius;
+        }
+
+        if ( slot.DirtyFaceMask == 0u ) {
+            slot.HasValidTiles = true;
+        }
+    }
+
+    return updateCount;
+}
+
+void ShadowAtlas::invalidate( const AABB& aabb )
+{
+    for ( Slot& slot : slots ) {
+        if ( slot.IsAllocated && SphereAABBIntersectionTest( slot.WorldPosition, slot.Radius, aabb ) ) {
+            slot.DirtyFaceMask = GetFaceMask( slot.FaceCount );
+        }
+    }
+}
+
+void ShadowAtlas::invalidateAll()
+{
+    for ( Slot& slot : slots ) {
+        if ( slot.IsAllocated ) {
+            slot.DirtyFaceMask = GetFaceMask( slot.FaceCount );
+        }
+    }
+}
+
+int32_t ShadowAtlas::findSlot( const uint32_t lightIndex ) const
+{
+    // NOTE Unallocated slots are retrieved using ~0u as light index
+    for ( uint32_t i = 0u; i < MAX_SLOT_COUNT; i++ ) {
+        if ( slots[i].IsAllocated ? ( slots[i].LightIndex == lightIndex ) : ( lightIndex == ~0u ) ) {
+            return static_cast<int32_t>( i );
+        }
+    }
+
+    return -1;
+}
+
+const ShadowAtlas::Slot& ShadowAtlas::getSlot( const uint32_t slotIndex ) const
+{
+    return slots[slotIndex];
+}
+
+uint32_t ShadowAtlas::computeTileDimension( const float screenFootprint ) const
+{
+    uint32_t tileDimension = minTileDimension;
+    while ( tileDimension < maxTileDimension && static_cast<float>( tileDimension ) < screenFootprint ) {
+        tileDimension <<= 1u;
+    }
+
+    return tileDimension;
+}
+
+const ShadowAtlasAllocator& ShadowAtlas::getAllocator() const
+{
+    return allocator;
+}
+
+bool ShadowAtlas::allocateSlotTiles( Slot& slot, const uint32_t tileDimension )
+{
+    slot.RequestedTileSize = tileDimension;
+
+    while ( true ) {
+        // Fallback to smaller tiles if the atlas is full
+        for ( uint32_t dimension = tileDimension; dimension >= minTileDimension; dimension >>= 1u ) {
+            uint32_t allocatedFaceCount = 0u;
+            for ( ; allocatedFaceCount < slot.FaceCount; allocatedFaceCount++ ) {
+                if ( !allocator.allocate( dimension, slot.Tiles[allocatedFaceCount] ) ) {
+                    break;
+                }
+            }
+
+            if ( allocatedFaceCount == slot.FaceCount ) {
+                slot.TileSize = dimension;
+                slot.DirtyFaceMask = GetFaceMask( slot.FaceCount );
+                slot.IsAllocated = true;
+                slot.HasValidTiles = false;
+
+                return true;
+            }
+
+            for ( uint32_t faceIdx = 0u; faceIdx < allocatedFaceCount; faceIdx++ ) {
+                allocator.free( slot.Tiles[faceIdx] );
+            }
+        }
+
+        // Make some room (slots requested this frame are never evicted)
+        if ( !evictLeastRecentlyUsedSlot() ) {
+            break;
+        }
+    }
+
+    slot.IsAllocated = false;
+    slot.HasValidTiles = false;
+    slot.DirtyFaceMask = 0u;
+
+    return false;
+}
+
+void ShadowAtlas::releaseSlotTiles( Slot& slot )
+{
+    if ( !slot.IsAllocated ) {
+        return;
+    }
+
+    for ( uint32_t faceIdx = 0u; faceIdx < slot.FaceCount; faceIdx++ ) {
+        allocator.free( slot.Tiles[faceIdx] );
+    }
+
+    slot.IsAllocated = false;
+    slot.HasValidTiles = false;
+    slot.DirtyFaceMask = 0u;
+}
+
+bool ShadowAtlas::evictLeastRecentlyUsedSlot()
+{
+    Slot* leastRecentlyUsedSlot = nullptr;
+    for ( Slot& slot : slots ) {
+        if ( !slot.IsAllocated || slot.LastRequestFrame == frameIndex ) {
+            continue;
+        }
+
+        if ( leastRecentlyUsedSlot == nullptr || slot.LastRequestFrame < leastRecentlyUsedSlot->LastRequestFrame ) {
+            leastRecentlyUsedSlot = &slot;
+        }
+    }
+
+    if ( leastRecentlyUsedSlot == nullptr ) {
+        return false;
+    }
+
+    releaseSlotTiles( *leastRecentlyUsedSlot );
+
+    return true;
+}
@@ -0,0 +1,110 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ShadowAtlasAllocator.h"
+
+#include <Maths/Vector.h>
+#include <Shaders/ShadowMappingShared.h>
+
+#include <vector>
+
+struct AABB;
+
+struct LocalShadowRequest
+{
+    uint32_t    LightIndex;
+    nyaVec3f    WorldPosition;
+    float       Radius;
+    float       ScreenFootprint; // Projected light diameter (in pixels)
+    uint32_t    FaceCount; // 6 for point lights; 1 for spot lights
+};
+
+struct LocalShadowFaceUpdate
+{
+    uint32_t        LightIndex;
+    uint32_t        SlotIndex;
+    uint32_t        FaceIndex;
+    ShadowAtlasTile Tile;
+};
+
+// Cache of local light shadow maps packed in a single atlas
+// Tiles are kept from one frame to another and are only re-rendered when the light moves or when a caster moving inside
+// the light volume invalidates them (see invalidate()). The cache only deals with tiles and dirty flags (no GPU resources)
+class ShadowAtlas
+{
+public:
+    static constexpr uint32_t   MAX_SLOT_COUNT = LOCAL_SHADOW_MAX_LIGHT_COUNT;
+    static constexpr uint32_t   MAX_FACE_COUNT = 6u;
+
+    struct Slot {
+        uint32_t        LightIndex;
+        nyaVec3f        WorldPosition;
+        float           Radius;
+        uint32_t        FaceCount;
+        uint32_t        TileSize;
+        uint32_t        RequestedTileSize; // Might be larger than TileSize if the atlas was full during the allocation
+        ShadowAtlasTile Tiles[MAX_FACE_COUNT];
+        nyaVec3f        FaceCapturePositions[MAX_FACE_COUNT]; // Light position/radius of the last face render (the face content
+        float           FaceCaptureRadii[MAX_FACE_COUNT];     // must be sampled with these until the dirty face is rendered again)
+        uint32_t        DirtyFaceMask;
+        uint32_t        LastRequestFrame;
+        bool            IsAllocated;
+        bool            HasValidTiles; // True once every face has been rendered at least once since the tiles allocation
+    };
+
+public:
+                                ShadowAtlas();
+                                ShadowAtlas( ShadowAtlas& ) = delete;
+                                ShadowAtlas& operator = ( ShadowAtlas& ) = delete;
+                                ~ShadowAtlas();
+
+    void                        create( const uint32_t atlasDimension, const uint32_t minTileDimension, const uint32_t maxTileDimension );
+    void                        clear();
+
+    // Assign atlas tiles to the requested lights (the largest footprints first) and write the faces to render this frame
+    // (at most maxUpdateCount; remaining dirty faces are kept for the next frames). Returns the number of face updates written
+    uint32_t                    update( const LocalShadowRequest* requests, const uint32_t requestCount, LocalShadowFaceUpdate* updates, const uint32_t maxUpdateCount );
+
+    // Mark the shadow maps of every light whose volume intersects the given bounds as dirty (e.g. when a caster has moved)
+    void                        invalidate( const AABB& aabb );
+    void                        invalidateAll();
+
+    // Returns -1 if the light has no slot
+    int32_t                     findSlot( const uint32_t lightIndex ) const;
+    const Slot&                 getSlot( const uint32_t slotIndex ) const;
+
+    uint32_t                    computeTileDimension( const float screenFootprint ) const;
+    const ShadowAtlasAllocator& getAllocator() const;
+
+private:
+    ShadowAtlasAllocator        allocator;
+    Slot                        slots[MAX_SLOT_COUNT];
+    std::vector<uint32_t>       sortedRequests;
+
+    uint32_t                    minTileDimension;
+    uint32_t                    maxTileDimension;
+    uint32_t                    frameIndex;
+
+private:
+    bool                        allocateSlotTiles( Slot& slot, const uint32_t tileDimension );
+    void                        releaseSlotTiles( Slot& slot );
+    bool                        evictLeastRecentlyUsedSlot();
+};
@@ -0,0 +1,215 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "ShadowAtlasAllocator.h"
+
+#include <algorithm>
+
+static uint32_t NextPowerOfTwo( uint32_t value )
+{
+    value--;
+    value |= value >> 1;
+    value |= value >> 2;
+    value |= value >> 4;
+    value |= value >> 8;
+    value |= value >> 16;
+    value++;
+
+    return value;
+}
+
+static uint32_t Log2( uint32_t powerOfTwo )
+{
+    uint32_t log = 0u;
+    while ( powerOfTwo > 1u ) {
+        powerOfTwo >>= 1;
+        log++;
+    }
+
+    return log;
+}
+
+ShadowAtlasAllocator::ShadowAtlasAllocator()
+    : atlasDimension( 0u )
+    , minTileDimension( 0u )
+    , levelCount( 0u )
+    , allocatedTileCount( 0u )
+    , allocatedArea( 0u )
+{
+
+}
+
+ShadowAtlasAllocator::~ShadowAtlasAllocator()
+{
+    atlasDimension = 0u;
+    minTileDimension = 0u;
+    levelCount = 0u;
+    allocatedTileCount = 0u;
+    allocatedArea = 0u;
+}
+
+void ShadowAtlasAllocator::create( const uint32_t atlasDimension, const uint32_t minTileDimension )
+{
+    NYA_DEV_ASSERT( minTileDimension != 0u && minTileDimension <= atlasDimension, "Invalid shadow atlas tile dimension (%u; atlas is %u)", minTileDimension, atlasDimension );
+
+    this->atlasDimension = NextPowerOfTwo( atlasDimension );
+    this->minTileDimension = NextPowerOfTwo( minTileDimension );
+
+    // Tile coordinates and node indexes are stored on 16 bits
+    NYA_DEV_ASSERT( this->atlasDimension <= 32768u, "Shadow atlas is too large (%u)", this->atlasDimension );
+
+    levelCount = Log2( this->atlasDimension / this->minTileDimension ) + 1u;
+
+    // Node count of a complete quadtree: (4^levelCount - 1) / 3
+    const uint32_t nodeCount = ( ( 1u << ( 2u * levelCount ) ) - 1u ) / 3u;
+    NYA_DEV_ASSERT( nodeCount <= 0xFFFFu, "Too many shadow atlas quadtree levels (%u)", levelCount );
+
+    nodeStates.resize( nodeCount );
+
+    clear();
+}
+
+void ShadowAtlasAllocator::clear()
+{
+    std::fill( nodeStates.begin(), nodeStates.end(), static_cast<uint8_t>( NODE_STATE_FREE ) );
+
+    allocatedTileCount = 0u;
+    allocatedArea = 0u;
+}
+
+bool ShadowAtlasAllocator::allocate( const uint32_t tileDimension, ShadowAtlasTile& tile )
+{
+    if ( nodeStates.empty() || tileDimension > atlasDimension ) {
+        return false;
+    }
+
+    const uint32_t clampedDimension = ( tileDimension < minTileDimension ) ? minTileDimension : NextPowerOfTwo( tileDimension );
+    const uint32_t targetLevel = Log2( atlasDimension / clampedDimension );
+
+    // Find the deepest free node able to hold the tile (so that large free blocks are kept intact)
+    ShadowAtlasTile freeNode = {};
+    uint32_t freeNodeLevel = ~0u;
+    findFreeNode( 0u, 0u, targetLevel, 0u, 0u, freeNode, freeNodeLevel );
+
+    if ( freeNodeLevel == ~0u ) {
+        return false;
+    }
+
+    // Split the free node down to the requested level (always descend into the top left child)
+    uint32_t nodeIndex = freeNode.NodeIndex;
+    for ( uint32_t level = freeNodeLevel; level < targetLevel; level++ ) {
+        nodeStates[nodeIndex] = NODE_STATE_SPLIT;
+        nodeIndex = nodeIndex * 4u + 1u;
+    }
+
+    nodeStates[nodeIndex] = NODE_STATE_ALLOCATED;
+
+    tile.X = freeNode.X;
+    tile.Y = freeNode.Y;
+    tile.Size = static_cast<uint16_t>( clampedDimension );
+    tile.NodeIndex = static_cast<uint16_t>( nodeIndex );
+
+    allocatedTileCount++;
+    allocatedArea += ( clampedDimension * clampedDimension );
+
+    return true;
+}
+
+void ShadowAtlasAllocator::free( const ShadowAtlasTile& tile )
+{
+    uint32_t nodeIndex = tile.NodeIndex;
+
+    if ( nodeIndex >= nodeStates.size() || nodeStates[nodeIndex] != NODE_STATE_ALLOCATED ) {
+        NYA_DEV_ASSERT( false, "Invalid shadow atlas tile (node %u)", nodeIndex );
+        return;
+    }
+
+    nodeStates[nodeIndex] = NODE_STATE_FREE;
+
+    allocatedTileCount--;
+    allocatedArea -= ( tile.Size * tile.Size );
+
+    // Merge siblings back into their parent
+    while ( nodeIndex != 0u ) {
+        const uint32_t parentIndex = ( nodeIndex - 1u ) / 4u;
+        const uint32_t firstChildIndex = parentIndex * 4u + 1u;
+
+        for ( uint32_t i = 0u; i < 4u; i++ ) {
+            if ( nodeStates[firstChildIndex + i] != NODE_STATE_FREE ) {
+                return;
+            }
+        }
+
+        nodeStates[parentIndex] = NODE_STATE_FREE;
+        nodeIndex = parentIndex;
+    }
+}
+
+uint32_t ShadowAtlasAllocator::getAtlasDimension() const
+{
+    return atlasDimension;
+}
+
+uint32_t ShadowAtlasAllocator::getMinTileDimension() const
+{
+    return minTileDimension;
+}
+
+uint32_t ShadowAtlasAllocator::getAllocatedTileCount() const
+{
+    return allocatedTileCount;
+}
+
+uint32_t ShadowAtlasAllocator::getAllocatedArea() const
+{
+    return allocatedArea;
+}
+
+void ShadowAtlasAllocator::findFreeNode( const uint32_t nodeIndex, const uint32_t level, const uint32_t targetLevel, const uint16_t x, const uint16_t y, ShadowAtlasTile& bestNode, uint32_t& bestLevel ) const
+{
+    switch ( nodeStates[nodeIndex] ) {
+    case NODE_STATE_FREE:
+        if ( bestLevel == ~0u || level > bestLevel ) {
+            bestNode = { x, y, 0u, static_cast<uint16_t>( nodeIndex ) };
+            bestLevel = level;
+        }
+        break;
+
+    case NODE_STATE_SPLIT: {
+        if ( level >= targetLevel ) {
+            break;
+        }
+
+        const uint16_t childDimension = static_cast<uint16_t>( ( atlasDimension >> level ) / 2u );
+        const uint32_t firstChildIndex = nodeIndex * 4u + 1u;
+
+        for ( uint32_t i = 0u; i < 4u && bestLevel != targetLevel; i++ ) {
+            const uint16_t childX = x + static_cast<uint16_t>( ( i & 1u ) * childDimension );
+            const uint16_t childY = y + static_cast<uint16_t>( ( i >> 1u ) * childDimension );
+
+            findFreeNode( firstChildIndex + i, level + 1u, targetLevel, childX, childY, bestNode, bestLevel );
+        }
+    } break;
+
+    case NODE_STATE_ALLOCATED:
+    default:
+        break;
+    }
+}
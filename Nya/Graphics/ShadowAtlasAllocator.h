@@ -0,0 +1,74 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+
+struct ShadowAtlasTile
+{
+    uint16_t    X;
+    uint16_t    Y;
+    uint16_t    Size;
+    uint16_t    NodeIndex;
+};
+
+// Quadtree allocator of square power of two tiles inside a square shadow atlas
+// The tree is stored implicitly (children of node n are 4n+1..4n+4); freeing a tile merges its siblings back
+// into their parent whenever possible. The allocator does not touch any GPU resource
+class ShadowAtlasAllocator
+{
+public:
+                                ShadowAtlasAllocator();
+                                ShadowAtlasAllocator( ShadowAtlasAllocator& ) = delete;
+                                ShadowAtlasAllocator& operator = ( ShadowAtlasAllocator& ) = delete;
+                                ~ShadowAtlasAllocator();
+
+    // Both dimensions must be powers of two (minTileDimension <= atlasDimension)
+    void                        create( const uint32_t atlasDimension, const uint32_t minTileDimension );
+    void                        clear();
+
+    // Returns false if there is no free space for a tile of the given dimension (rounded up to a power of two)
+    bool                        allocate( const uint32_t tileDimension, ShadowAtlasTile& tile );
+    void                        free( const ShadowAtlasTile& tile );
+
+    uint32_t                    getAtlasDimension() const;
+    uint32_t                    getMinTileDimension() const;
+    uint32_t                    getAllocatedTileCount() const;
+    uint32_t                    getAllocatedArea() const;
+
+private:
+    enum eNodeState : uint8_t
+    {
+        NODE_STATE_FREE = 0,
+        NODE_STATE_SPLIT,
+        NODE_STATE_ALLOCATED
+    };
+
+private:
+    std::vector<uint8_t>        nodeStates;
+    uint32_t                    atlasDimension;
+    uint32_t                    minTileDimension;
+    uint32_t                    levelCount;
+    uint32_t                    allocatedTileCount;
+    uint32_t                    allocatedArea;
+
+private:
+    void                        findFreeNode( const uint32_t nodeIndex, const uint32_t level, const uint32_t targetLevel, const uint16_t x, const uint16_t y, ShadowAtlasTile& bestNode, uint32_t& bestLevel ) const;
+};
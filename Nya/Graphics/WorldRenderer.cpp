@@ -32,7 +32,9 @@
 #include "RenderPasses/BlurPyramidRenderPass.h"
 #include "RenderPasses/CopyRenderPass.h"
 #include "RenderPasses/MSAAResolveRenderPass.h"
+#include "RenderPasses/CascadedShadowMapCapturePass.h"
 #include "RenderModules/ProbeCaptureModule.h"
+#include "RenderModules/LocalShadowRenderModule.h"
 
 #include "PrimitiveCache.h"
 
@@ -105,15 +107,20 @@ done:
 }
 
 WorldRenderer::WorldRenderer( BaseAllocator* allocator )
-    : primitiveCache( nya::core::allocate<PrimitiveCache>( allocator, allocator ) )
-    , renderPipelineCount( 0u )
-    , drawCmdAllocator( nya::core::allocate<PoolAllocator>( allocator, sizeof( DrawCmd ), 4, sizeof( DrawCmd ) * MAX_DRAW_CMD_COUNT, allocator->allocate( sizeof( DrawCmd ) * 8192 ) ) )
-    , LineRenderModule( nya::core::allocate<LineRenderingModule>( allocator ) )
+    : LineRenderModule( nya::core::allocate<LineRenderingModule>( allocator ) )
     , TextRenderModule( nya::core::allocate<TextRenderingModule>( allocator ) )
     , SkyRenderModule( nya::core::allocate<BrunetonSkyRenderModule>( allocator ) )
     , automaticExposureModule( nya::core::allocate<AutomaticExposureModule>( allocator ) )
     , probeCaptureModule( nya::core::allocate<ProbeCaptureModule>( allocator ) )
-    , renderPipelines( nya::core::allocateArray<RenderPipeline>( allocator, 8, allocator ) )
+    , localShadowModule( nya::core::allocate<LocalShadowRenderModule>( allocator ) )
+    , primitiveCache( nya::core::allocate<PrimitiveCache>( allocator, allocator ) )
+    , drawCmdAllocator( nya::core::allocate<PoolAllocator>( allocator, sizeof( DrawCmd ), 4, sizeof( DrawCmd ) * MAX_DRAW_CMD_COUNT, allocator->allocate( sizeof( DrawCmd ) * 8192 ) ) )
+    , renderPipelineCount( 0u )
+    , renderPipelines( nya::core::allocateArray<RenderPipeline>( allocator, MAX_RENDER_PIPELINE_COUNT, allocator ) )
+    , frameIndex( 0ull )
+    , lastFrameGPUTime( -1.0 )
+    , gpuTimings{}
+    , gpuTimingCount( 0u )
 {
 
 }
@@ -125,7 +132,7 @@ WorldRenderer::~WorldRenderer()
 
 void WorldRenderer::destroy( RenderDevice* renderDevice )
 {
-    for ( uint32_t i = 0; i < 8; i++ ) {
+    for ( uint32_t i = 0; i < MAX_RENDER_PIPELINE_COUNT; i++ ) {
         renderPipelines[i].destroy( renderDevice );
     }
 
@@ -137,12 +144,14 @@ void WorldRenderer::destroy( RenderDevice* renderDevice )
     SkyRenderModule->destroy( renderDevice );
     automaticExposureModule->destroy( renderDevice );
     probeCaptureModule->destroy( renderDevice );
+    localShadowModule->destroy( renderDevice );
 
     FreeCachedResourcesCP( renderDevice );
     FreeCachedResourcesBP( renderDevice );
     FreeCachedResourcesFP( renderDevice );
     FreeCachedResourcesPP( renderDevice );
     FreeCachedResourcesMRP( renderDevice );
+    FreeCachedResourcesCSM( renderDevice );
 }
 
 void WorldRenderer::drawWorld( RenderDevice* renderDevice, const float deltaTime )
@@ -161,26 +170,52 @@ void WorldRenderer::drawWorld( RenderDevice* renderDevice, const float deltaTime
         }
     }
 
+    gpuTimingCount = 0u;
+
     // Execute pipelines linearly
     // TODO Could it be parallelized?
     for ( uint32_t pipelineIdx = 0; pipelineIdx < renderPipelineCount; pipelineIdx++ ) {
         renderPipelines[pipelineIdx].submitAndDispatchDrawCmds( drawCmds, drawCmdCount );
         renderPipelines[pipelineIdx].execute( renderDevice, deltaTime );
 
+        // Pipelines are pooled: the timing retrieved might belong to a different view (and frame) than the current one
+        if ( renderPipelines[pipelineIdx].getLastGPUTiming( gpuTimings[gpuTimingCount] ) ) {
+            gpuTimingCount++;
+        }
+
 #if NYA_DEVBUILD
 #ifndef NYA_NULL_RENDERER
         const char* profilingString = renderPipelines[pipelineIdx].getProfilingSummary();
 
         if ( profilingString != nullptr ) {
-            TextRenderModule->addOutlinedText( profilingString, 0.35f, 10.0f + 200.0f * pipelineIdx, 96.0f );
+            TextRenderModule->addOutlinedText( profilingString, NYA_STRING_HASH( "WorldRenderer/ProfilingSummary" ) + pipelineIdx, 0.35f, 10.0f + 200.0f * pipelineIdx, 96.0f );
         }
 #endif
 #endif
     }
 
+    // Sum the timings of the most recent frame retrieved
+    uint64_t lastTimedFrameIndex = 0ull;
+    lastFrameGPUTime = -1.0;
+
+    for ( uint32_t timingIdx = 0u; timingIdx < gpuTimingCount; timingIdx++ ) {
+        const PipelineGPUTiming& timing = gpuTimings[timingIdx];
+
+        if ( lastFrameGPUTime < 0.0 || timing.FrameIndex > lastTimedFrameIndex ) {
+            lastTimedFrameIndex = timing.FrameIndex;
+            lastFrameGPUTime = timing.GPUTime;
+        } else if ( timing.FrameIndex == lastTimedFrameIndex ) {
+            lastFrameGPUTime += timing.GPUTime;
+        }
+    }
+
+    // Expire transient debug primitives
+    LineRenderModule->updateLifetimes( deltaTime );
+
     // Reset DrawCmd Pool
     drawCmdAllocator->clear();
     renderPipelineCount = 0;
+    frameIndex++;
 }
 
 DrawCmd& WorldRenderer::allocateDrawCmd()
@@ -228,27 +263,53 @@ void WorldRenderer::loadCachedResources( RenderDevice* renderDevice, ShaderCache
     TextRenderModule->loadCachedResources( renderDevice, shaderCache, graphicsAssetCache );
     automaticExposureModule->loadCachedResources( renderDevice, shaderCache, graphicsAssetCache );
     probeCaptureModule->loadCachedResources( renderDevice, shaderCache, graphicsAssetCache );
+    localShadowModule->loadCachedResources( renderDevice, shaderCache, graphicsAssetCache );
 
     LoadCachedResourcesFP( renderDevice, shaderCache );
     LoadCachedResourcesPP( renderDevice, shaderCache );
     LoadCachedResourcesBP( renderDevice, shaderCache );
     LoadCachedResourcesCP( renderDevice, shaderCache );
     LoadCachedResourcesMRP( renderDevice, shaderCache );
+    LoadCachedResourcesCSM( renderDevice, shaderCache );
 
     primitiveCache->createPrimitivesBuffer( renderDevice );
 
 #if NYA_DEVBUILD
 #ifndef NYA_NULL_RENDERER
-    for ( int i = 0; i < 8; i++ ) {
+    for ( uint32_t i = 0; i < MAX_RENDER_PIPELINE_COUNT; i++ ) {
         renderPipelines[i].enableProfiling( renderDevice );
     }
 #endif
 #endif
 }
 
-RenderPipeline& WorldRenderer::allocateRenderPipeline( const Viewport& viewport, const CameraData* camera )
+RenderPipeline& WorldRenderer::allocateRenderPipeline( const Viewport& viewport, const CameraData* camera, const nyaStringHash_t viewKey )
 {
+    NYA_DEV_ASSERT( renderPipelineCount < MAX_RENDER_PIPELINE_COUNT, "Render pipeline pool is full! (%u pipelines allocated)", renderPipelineCount );
+
     RenderPipeline& renderPipeline = renderPipelines[renderPipelineCount++];
     renderPipeline.setViewport( viewport, camera );
+    renderPipeline.setProfilingKey( frameIndex, viewKey );
     return renderPipeline;
 }
+
+uint64_t WorldRenderer::getFrameIndex() const
+{
+    return frameIndex;
+}
+
+const PipelineGPUTiming* WorldRenderer::getLastGPUTimings( uint32_t& timingCount ) const
+{
+    timingCount = gpuTimingCount;
+    return gpuTimings;
+}
+
+double WorldRenderer::getLastFrameGPUTime() const
+{
+    return lastFrameGPUTime;
+}
+
+uint32_t WorldRenderer::getAvailableRenderPipelineCount() const
+{
+    return ( MAX_RENDER_PIPELINE_COUNT - renderPipelineCount );
+}
@@ -25,6 +25,7 @@ class PoolAllocator;
 class Material;
 class VertexArrayObject;
 class ProbeCaptureModule;
+class LocalShadowRenderModule;
 class AutomaticExposureModule;
 class BrunetonSkyRenderModule;
 class TextRenderingModule;
@@ -58,7 +59,8 @@ struct DrawCommandKey
         DEPTH_VIEWPORT_LAYER_CSM0,
         DEPTH_VIEWPORT_LAYER_CSM1,
         DEPTH_VIEWPORT_LAYER_CSM2,
-        DEPTH_VIEWPORT_LAYER_CSM3
+        DEPTH_VIEWPORT_LAYER_CSM3,
+        DEPTH_VIEWPORT_LAYER_LOCAL_SHADOW // Local lights shadow atlas (the sub-layer is the index of the atlas face to render)
     };
 
     enum WorldViewportLayer : uint8_t
@@ -89,7 +91,7 @@ struct DrawCommandKey
             uint32_t materialSortKey; // material sort key (contains states and pipeline setup infos as a bitfield)
 
             uint16_t depth; // half float depth for distance sorting
-            uint8_t __PLACEHOLDER__ : 6;
+            uint8_t viewportSubLayer : 6; // viewport layer subdivision (e.g. shadow atlas tile)
             SortOrder sortOrder : 2; // front to back or back to front (opaque or transparent)
 
             uint8_t viewportLayer : 3;
@@ -128,6 +130,16 @@ struct DrawCmd
     }
 };
 
+static constexpr uint32_t MAX_RENDER_PIPELINE_COUNT = 8u;
+
+// GPU time of a render pipeline execution (results are retrieved a few frames late)
+struct PipelineGPUTiming
+{
+    uint64_t            FrameIndex; // WorldRenderer frame the pipeline has been executed at
+    nyaStringHash_t     ViewKey;
+    double              GPUTime; // in ms
+};
+
 class WorldRenderer
 {
 public:
@@ -146,13 +158,25 @@ public:
 
     void                        loadCachedResources( RenderDevice* renderDevice, ShaderCache* shaderCache, GraphicsAssetCache* graphicsAssetCache );
 
-    RenderPipeline&             allocateRenderPipeline( const Viewport& viewport, const CameraData* camera = nullptr );
+    // viewKey identifies what the pipeline renders (GPU timings are tagged with it, since pipelines are pooled)
+    RenderPipeline&             allocateRenderPipeline( const Viewport& viewport, const CameraData* camera = nullptr, const nyaStringHash_t viewKey = 0u );
+    uint32_t                    getAvailableRenderPipelineCount() const;
+
+    // Index of the frame being built (incremented once the frame has been drawn)
+    uint64_t                    getFrameIndex() const;
+
+    // GPU timings retrieved during the latest drawWorld call
+    const PipelineGPUTiming*    getLastGPUTimings( uint32_t& timingCount ) const;
+
+    // GPU time of the most recent frame with timings retrieved during the latest drawWorld call (in ms; negative if unavailable)
+    double                      getLastFrameGPUTime() const;
 
     LineRenderingModule*        LineRenderModule;
     TextRenderingModule*        TextRenderModule;
     BrunetonSkyRenderModule*    SkyRenderModule;
     AutomaticExposureModule*    automaticExposureModule;
     ProbeCaptureModule*         probeCaptureModule;
+    LocalShadowRenderModule*    localShadowModule;
 
 private:
     PrimitiveCache*             primitiveCache;
@@ -160,4 +184,10 @@ private:
 
     uint32_t                    renderPipelineCount;
     RenderPipeline*             renderPipelines;
+
+    uint64_t                    frameIndex;
+    double                      lastFrameGPUTime;
+
+    PipelineGPUTiming           gpuTimings[MAX_RENDER_PIPELINE_COUNT];
+    uint32_t                    gpuTimingCount;
 };
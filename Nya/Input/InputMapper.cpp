@@ -25,13 +25,17 @@
 
 #include <FileSystem/FileSystemObject.h>
 #include <Io/TextStreamHelpers.h>
+#include <Io/TextStreamReader.h>
 #include <Core/StringHelpers.h>
 
 using namespace nya::input;
 
-InputMapper::InputMapper()
+InputMapper::InputMapper( BaseAllocator* allocator )
 {
+    inputContexts.create( allocator );
 
+    currentMappedInput.create( allocator );
+    frameMappedInput.create( allocator );
 }
 
 InputMapper::~InputMapper()
@@ -48,10 +52,10 @@ InputMapper::~InputMapper()
 
 void InputMapper::update( const float frameTime )
 {
-    MappedInput input = currentMappedInput;
+    frameMappedInput.copyFrom( currentMappedInput );
 
     for ( auto iter = callbackTable.begin(); iter != callbackTable.end(); ++iter ) {
-        iter->second( input, frameTime );
+        iter->second( frameMappedInput, frameTime );
     }
 }
 
@@ -106,7 +110,9 @@ void InputMapper::addCallback( InputCallback_t callback, int priority )
 
 void InputMapper::addContext( const nyaStringHash_t name, InputContext* context )
 {
-    inputContexts.emplace( name, context );
+    if ( !inputContexts.contains( name ) ) {
+        inputContexts.insert( name, context );
+    }
 }
 
 void InputMapper::pushContext( const nyaStringHash_t name )
@@ -166,48 +172,39 @@ NYA_LAZY_ENUM( ButtonType )
 
 void InputMapper::deserialize( FileSystemObject* file )
 {
-    nyaString_t streamLine, dictionaryKey, dictionaryValue;
+    TextStreamReader streamReader( file );
+    TextToken streamLine, dictionaryKey, dictionaryValueToken;
+    nyaString_t dictionaryValue;
 
     bool isReadingContext = false;
     InputContext* currentContext = nullptr;
-    while ( file->isGood() ) {
-        nya::core::ReadString( file, streamLine );
-
-        // Find seperator character offset in the line (if any)
-        const auto commentSeparator = streamLine.find_first_of( NYA_STRING( "#" ) );
-
+    while ( streamReader.readLine( streamLine ) ) {
         // Remove user comments before reading the keypair value
-        if ( commentSeparator != nyaString_t::npos ) {
-            streamLine.erase( streamLine.begin() + commentSeparator, streamLine.end() );
-        }
+        streamLine.end = streamLine.find( '#' );
 
         // Skip commented out and empty lines
         if ( streamLine.empty() ) {
             continue;
         }
 
-        if ( streamLine[0] == '{' ) {
+        if ( *streamLine.begin == '{' ) {
             continue;
-        } else if ( streamLine[0] == '}' ) {
+        } else if ( *streamLine.begin == '}' ) {
             isReadingContext = false;
             currentContext = nullptr;
             continue;
         }
 
-        const auto keyValueSeparator = streamLine.find_first_of( ':' );
-
         // Check if this is a key value line
-        if ( keyValueSeparator != nyaString_t::npos ) {
-            dictionaryKey = streamLine.substr( 0, keyValueSeparator );
-            dictionaryValue = streamLine.substr( keyValueSeparator + 1 );
-
+        if ( streamLine.split( ':', dictionaryKey, dictionaryValueToken ) ) {
             // Trim both key and values (useful if a file has inconsistent spacing, ...)
-            nya::core::TrimString( dictionaryKey );
-            nya::core::TrimString( dictionaryValue );
+            dictionaryKey = dictionaryKey.trim();
+            dictionaryValueToken = dictionaryValueToken.trim();
 
             // Do the check after triming, since the value might be a space or a tab character
-            if ( !dictionaryValue.empty() ) {
-                auto keyHashcode = nya::core::CRC32( dictionaryKey.c_str() );
+            if ( !dictionaryValueToken.empty() ) {
+                auto keyHashcode = dictionaryKey.hash();
+                dictionaryValueToken.toString( dictionaryValue );
 
                 switch ( keyHashcode ) {
                 case NYA_STRING_HASH( "Context" ): {
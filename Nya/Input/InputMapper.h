@@ -23,6 +23,8 @@
 #include "InputAxis.h"
 #include "MappedInput.h"
 
+#include <Core/Containers/HashMap.h>
+
 #include <map>
 #include <functional>
 #include <list>
@@ -35,7 +37,7 @@ class FileSystemObject;
 class InputMapper
 {
 public:
-                                            InputMapper();
+                                            InputMapper( BaseAllocator* allocator );
                                             InputMapper( InputMapper& ) = delete;
                                             ~InputMapper();
 
@@ -52,10 +54,11 @@ public:
     void                                    deserialize( FileSystemObject* file );
 
 private:
-    std::map<nyaStringHash_t, InputContext*>    inputContexts;
+    HashMap<nyaStringHash_t, InputContext*>     inputContexts;
     std::list<InputContext*>                    activeContexts;
     std::multimap<int, InputCallback_t>         callbackTable;
     MappedInput                                 currentMappedInput;
+    MappedInput                                 frameMappedInput; // Copy handed to the callbacks (which can eat inputs)
 
 private:
     bool                                    mapButtonToAction( nya::input::eInputKey button, nyaStringHash_t& action ) const;
@@ -22,14 +22,28 @@
 #include "InputKeys.h"
 #include "InputAxis.h"
 
-#include <map>
-#include <set>
+#include <Core/Containers/HashMap.h>
+#include <Core/Containers/HashSet.h>
 
 struct MappedInput
 {
-    std::set<nyaStringHash_t>          Actions;
-    std::set<nyaStringHash_t>          States;
-    std::map<nyaStringHash_t, double>  Ranges;
+    HashSet<nyaStringHash_t>            Actions;
+    HashSet<nyaStringHash_t>            States;
+    HashMap<nyaStringHash_t, double>    Ranges;
+
+    void create( BaseAllocator* allocator )
+    {
+        Actions.create( allocator, 64u );
+        States.create( allocator, 64u );
+        Ranges.create( allocator, 64u );
+    }
+
+    void copyFrom( const MappedInput& mappedInput )
+    {
+        Actions.copyFrom( mappedInput.Actions );
+        States.copyFrom( mappedInput.States );
+        Ranges.copyFrom( mappedInput.Ranges );
+    }
 
     // Consumption helpers
     void eatAction( const nyaStringHash_t action )
@@ -44,10 +58,6 @@ struct MappedInput
 
     void eatRange( const nyaStringHash_t range )
     {
-        auto iter = Ranges.find( range );
-
-        if ( iter != Ranges.end() ) {
-            Ranges.erase( iter );
-        }
+        Ranges.erase( range );
     }
 };
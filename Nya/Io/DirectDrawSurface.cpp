@@ -240,7 +240,14 @@ typedef enum D3D11_RESOURCE_MISC_FLAG
 #define DDS_ALPHA       0x00000002  // DDPF_ALPHA
 #define DDS_BUMPDUDV    0x00080000  // DDPF_BUMPDUDV
 
+#define DDS_HEADER_FLAGS_TEXTURE        0x00001007  // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+#define DDS_HEADER_FLAGS_MIPMAP         0x00020000  // DDSD_MIPMAPCOUNT
 #define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
+#define DDS_HEADER_FLAGS_PITCH          0x00000008  // DDSD_PITCH
+
+#define DDS_SURFACE_FLAGS_TEXTURE 0x00001000 // DDSCAPS_TEXTURE
+#define DDS_SURFACE_FLAGS_MIPMAP  0x00400008 // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+#define DDS_SURFACE_FLAGS_CUBEMAP 0x00000008 // DDSCAPS_COMPLEX
 
 #define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
 #define DDS_WIDTH  0x00000004 // DDSD_WIDTH
@@ -701,7 +708,78 @@ void nya::core::LoadDirectDrawSurface( FileSystemObject* stream, DirectDrawSurfa
     auto texelsSize = streamSize - stream->tell();
 
     data.textureDescription = desc;
-    data.textureData.resize( texelsSize );
+    data.texelsSize = static_cast<std::size_t>( texelsSize );
+
+    // Parse texels in place if possible
+    uint64_t mappedSize = 0ull;
+    const uint8_t* mappedContent = stream->map( mappedSize );
+    if ( mappedContent != nullptr && mappedSize == streamSize ) {
+        data.texels = mappedContent + stream->tell();
+        stream->skip( texelsSize );
+        return;
+    }
 
+    data.textureData.resize( texelsSize );
     stream->read( &data.textureData[0], texelsSize );
+
+    data.texels = data.textureData.data();
+}
+
+void nya::core::SaveDirectDrawSurface( FileSystemObject* stream, const DirectDrawSurface& data )
+{
+    const TextureDescription& desc = data.textureDescription;
+    const DXGI_FORMAT dxgiFormat = static_cast<DXGI_FORMAT>( desc.format );
+    const bool isCubeMap = ( desc.flags.isCubeMap == 1 );
+    const bool isVolume = ( desc.dimension == TextureDescription::DIMENSION_TEXTURE_3D );
+
+    DDS_HEADER hdr = {};
+    hdr.dwSize = sizeof( DDS_HEADER );
+    hdr.dwFlags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_PITCH;
+    hdr.dwWidth = desc.width;
+    hdr.dwHeight = desc.height;
+    hdr.dwPitchOrLinearSize = static_cast<uint32_t>( ( desc.width * BitsPerPixel( dxgiFormat ) + 7 ) / 8 );
+    hdr.dwMipMapCount = desc.mipCount;
+    hdr.dwCaps = DDS_SURFACE_FLAGS_TEXTURE;
+
+    if ( desc.mipCount > 1 ) {
+        hdr.dwFlags |= DDS_HEADER_FLAGS_MIPMAP;
+        hdr.dwCaps |= DDS_SURFACE_FLAGS_MIPMAP;
+    }
+
+    if ( isVolume ) {
+        hdr.dwFlags |= DDS_HEADER_FLAGS_VOLUME;
+        hdr.dwDepth = desc.depth;
+    }
+
+    if ( isCubeMap ) {
+        hdr.dwCaps |= DDS_SURFACE_FLAGS_CUBEMAP;
+        hdr.dwCaps2 = DDS_CUBEMAP_ALLFACES;
+    }
+
+    hdr.ddspf.dwSize = sizeof( DDS_PIXELFORMAT );
+    hdr.ddspf.dwFlags = DDS_FOURCC;
+    hdr.ddspf.dwFourCC = MAKEFOURCC( 'D', 'X', '1', '0' );
+
+    DDS_HEADER_DXT10 d3d10ext = {};
+    d3d10ext.dxgiFormat = dxgiFormat;
+    d3d10ext.miscFlag = ( isCubeMap ) ? static_cast<uint32_t>( D3D11_RESOURCE_MISC_TEXTURECUBE ) : 0u;
+    d3d10ext.arraySize = ( isCubeMap ) ? desc.arraySize / 6 : desc.arraySize;
+    d3d10ext.miscFlags2 = 0u;
+
+    switch ( desc.dimension ) {
+    case TextureDescription::DIMENSION_TEXTURE_1D:
+        d3d10ext.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE1D;
+        break;
+    case TextureDescription::DIMENSION_TEXTURE_3D:
+        d3d10ext.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE3D;
+        break;
+    default:
+        d3d10ext.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+        break;
+    }
+
+    stream->write( DDS_MAGIC );
+    stream->write( hdr );
+    stream->write( d3d10ext );
+    stream->write( ( uint8_t* )data.textureData.data(), data.textureData.size() );
 }
@@ -28,6 +28,11 @@ struct DirectDrawSurface
 {
     TextureDescription      textureDescription;
     std::vector<uint8_t>    textureData;
+
+    // Texels of a loaded surface; point in place to the stream content if it can be mapped (valid until the stream is closed),
+    // to textureData otherwise
+    const uint8_t*          texels = nullptr;
+    std::size_t             texelsSize = 0;
 };
 
 namespace nya
@@ -35,6 +40,8 @@ namespace nya
     namespace core
     {
         void LoadDirectDrawSurface( FileSystemObject* stream, DirectDrawSurface& data );
-        //void SaveDirectDrawSurface( FileSystemObject* stream, std::vector<float>& texels, const TextureDescription& description );
+
+        // Write a DDS with a DX10 header (texels are stored per array slice, then per mip level; cubemaps use 6 slices per cube)
+        void SaveDirectDrawSurface( FileSystemObject* stream, const DirectDrawSurface& data );
     }
 }
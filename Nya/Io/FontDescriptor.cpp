@@ -23,170 +23,112 @@
 
 #include <FileSystem/FileSystemObject.h>
 #include "TextStreamHelpers.h"
+#include "TextStreamReader.h"
 
 void nya::core::LoadFontFile( FileSystemObject* file, FontDescriptor& data )
 {
-    nyaString_t streamLine, lineToken;
-
-    while ( file->isGood() ) {
-        nya::core::ReadString( file, streamLine );
-
-        const auto keyValueSeparator = streamLine.find_first_of( ' ' );
-
-        // Check if this is a key value line
-        if ( keyValueSeparator != nyaString_t::npos ) {
-            lineToken = streamLine.substr( 0, keyValueSeparator );
-            
-            // Trim both key and values (useful if a file has inconsistent spacing, ...)
-            nya::core::TrimString( lineToken );
-
-            auto keyHashcode = nya::core::CRC32( lineToken.c_str() ); 
-            
-            switch ( keyHashcode ) {
-            case NYA_STRING_HASH( "page" ): {
-                auto commonVariablesLine = streamLine.substr( keyValueSeparator + 1 );
-
-                auto commonVariableOffset = commonVariablesLine.find( ' ' );
-                auto previousCommonVariableOffset = 0;
-                while ( commonVariableOffset != nyaString_t::npos ) {
-                    auto variable = commonVariablesLine.substr( previousCommonVariableOffset, commonVariableOffset - previousCommonVariableOffset );
-
-                    const auto keyValueSeparator = variable.find_first_of( '=' );
-                    if ( keyValueSeparator == nyaString_t::npos ) {
-                        continue;
-                    }
-
-                    auto key = variable.substr( 0, keyValueSeparator );
-                    auto value = variable.substr( keyValueSeparator + 1 );
-
-                    auto tokenHashcode = nya::core::CRC32( key.c_str() );
-                    switch ( tokenHashcode ) {
-                    case NYA_STRING_HASH( "file" ):
-                        data.Name = nya::core::WrappedStringToString( value );
-                        break;
-                    default:
-                        break;
-                    }
+    TextStreamReader streamReader( file );
+    TextToken streamLine, lineToken, variable, key, value;
 
-                    // TODO Shouldn't be needed
-                    if ( previousCommonVariableOffset > commonVariableOffset ) {
-                        break;
-                    }
+    while ( streamReader.readLine( streamLine ) ) {
+        // Lines start with a tag, followed by a list of space separated 'key=value' variables
+        if ( !streamLine.popToken( ' ', lineToken ) ) {
+            continue;
+        }
 
-                    // Look for the next var
-                    previousCommonVariableOffset = static_cast<int>( commonVariableOffset ) + 1;
-                    commonVariableOffset = commonVariablesLine.find( ' ', commonVariableOffset );
+        switch ( lineToken.hash() ) {
+        case NYA_STRING_HASH( "page" ): {
+            while ( streamLine.popToken( ' ', variable ) ) {
+                if ( !variable.split( '=', key, value ) ) {
+                    continue;
                 }
-            } break;
-
-
-            case NYA_STRING_HASH( "common" ): {
-                auto commonVariablesLine = streamLine.substr( keyValueSeparator + 1 );
-
-                auto commonVariableOffset = commonVariablesLine.find( ' ', keyValueSeparator + 1 );
-                auto previousCommonVariableOffset = 0;
-                while ( commonVariableOffset != nyaString_t::npos ) {
-                    auto variable = commonVariablesLine.substr( previousCommonVariableOffset, commonVariableOffset - previousCommonVariableOffset );
-
-                    const auto keyValueSeparator = variable.find_first_of( '=' );
-                    if ( keyValueSeparator == nyaString_t::npos ) {
-                        continue;
-                    }
 
-                    auto key = variable.substr( 0, keyValueSeparator );
-                    auto value = variable.substr( keyValueSeparator + 1 );
-
-                    auto tokenHashcode = nya::core::CRC32( key.c_str() );
-                    switch ( tokenHashcode ) {
-                    case NYA_STRING_HASH( "scaleW" ):
-                        data.AtlasWidth = std::stoi( value );
-                        break;
-                    case NYA_STRING_HASH( "scaleH" ):
-                        data.AtlasHeight = std::stoi( value );
-                        break;
-                    default:
-                        break;
-                    }
+                switch ( key.hash() ) {
+                case NYA_STRING_HASH( "file" ):
+                    data.Name = nya::core::WrappedStringToString( value.toString() );
+                    break;
+                default:
+                    break;
+                }
+            }
+        } break;
 
-                    // Look for the next var
-                    previousCommonVariableOffset = static_cast<int>( commonVariableOffset ) + 1;
-                    commonVariableOffset = commonVariablesLine.find( ' ', previousCommonVariableOffset );
+        case NYA_STRING_HASH( "common" ): {
+            while ( streamLine.popToken( ' ', variable ) ) {
+                if ( !variable.split( '=', key, value ) ) {
+                    continue;
                 }
-            } break;
 
-            case NYA_STRING_HASH( "char" ):
-            {
-                auto commonVariablesLine = streamLine.substr( keyValueSeparator + 1 );
+                switch ( key.hash() ) {
+                case NYA_STRING_HASH( "scaleW" ):
+                    data.AtlasWidth = value.toInteger();
+                    break;
+                case NYA_STRING_HASH( "scaleH" ):
+                    data.AtlasHeight = value.toInteger();
+                    break;
+                default:
+                    break;
+                }
+            }
+        } break;
 
-                FontDescriptor::Glyph* glyph = nullptr;
+        case NYA_STRING_HASH( "char" ): {
+            FontDescriptor::Glyph* glyph = nullptr;
 
-                auto commonVariableOffset = commonVariablesLine.find( ' ', keyValueSeparator + 1 );
-                auto previousCommonVariableOffset = 0;
-                while ( commonVariableOffset != nyaString_t::npos ) {
-                    auto variable = commonVariablesLine.substr( previousCommonVariableOffset, commonVariableOffset - previousCommonVariableOffset );
+            while ( streamLine.popToken( ' ', variable ) ) {
+                if ( !variable.split( '=', key, value ) ) {
+                    continue;
+                }
 
-                    if ( variable.empty() ) {
-                        previousCommonVariableOffset++;
-                        commonVariableOffset = commonVariablesLine.find( ' ', previousCommonVariableOffset );
-                        continue;
-                    }
+                const auto tokenHashcode = key.hash();
 
-                    const auto keyValueSeparator = variable.find_first_of( '=' );
-                    if ( keyValueSeparator == nyaString_t::npos ) {
-                        continue;
-                    }
+                if ( tokenHashcode == NYA_STRING_HASH( "id" ) ) {
+                    auto glyphIndex = value.toInteger();
+                    auto requiredAtlasCapacity = static_cast<std::size_t>( glyphIndex + 1 );
 
-                    auto key = variable.substr( 0, keyValueSeparator );
-                    auto value = variable.substr( keyValueSeparator + 1 );
-
-                    auto tokenHashcode = nya::core::CRC32( key.c_str() );
-                    switch ( tokenHashcode ) {
-                    case NYA_STRING_HASH( "id" ):
-                    {
-                        auto glyphIndex = std::stoi( value );
-                        auto requiredAtlasCapacity = ( glyphIndex + 1 );
-
-                        if ( requiredAtlasCapacity > data.Glyphes.size() ) {
-                            data.Glyphes.resize( requiredAtlasCapacity );
-                        }
-
-                        glyph = &data.Glyphes[glyphIndex];
-                    } break;
-                    case NYA_STRING_HASH( "x" ):
-                        glyph->PositionX = std::stoi( value );
-                        break;
-                    case NYA_STRING_HASH( "y" ):
-                        glyph->PositionY = std::stoi( value );
-                        break;
-                    case NYA_STRING_HASH( "width" ):
-                        glyph->Width = std::stoi( value );
-                        break;
-                    case NYA_STRING_HASH( "height" ):
-                        glyph->Height = std::stoi( value );
-                        break;
-                    case NYA_STRING_HASH( "xoffset" ):
-                        glyph->OffsetX = std::stoi( value );
-                        break;
-                    case NYA_STRING_HASH( "yoffset" ):
-                        glyph->OffsetY = std::stoi( value );
-                        break;
-                    case NYA_STRING_HASH( "xadvance" ):
-                        glyph->AdvanceX = std::stoi( value );
-                        break;
-                    default:
-                        break;
+                    if ( requiredAtlasCapacity > data.Glyphes.size() ) {
+                        data.Glyphes.resize( requiredAtlasCapacity );
                     }
 
-                    // Look for the next var
-                    previousCommonVariableOffset = static_cast<int>( commonVariableOffset ) + 1;
-                    commonVariableOffset = commonVariablesLine.find( ' ', previousCommonVariableOffset );
+                    glyph = &data.Glyphes[glyphIndex];
+                    continue;
                 }
-            } break;
 
+                // Glyph variables are expected after the glyph id
+                if ( glyph == nullptr ) {
+                    continue;
+                }
 
-            default:
-                continue;
+                switch ( tokenHashcode ) {
+                case NYA_STRING_HASH( "x" ):
+                    glyph->PositionX = value.toInteger();
+                    break;
+                case NYA_STRING_HASH( "y" ):
+                    glyph->PositionY = value.toInteger();
+                    break;
+                case NYA_STRING_HASH( "width" ):
+                    glyph->Width = value.toInteger();
+                    break;
+                case NYA_STRING_HASH( "height" ):
+                    glyph->Height = value.toInteger();
+                    break;
+                case NYA_STRING_HASH( "xoffset" ):
+                    glyph->OffsetX = value.toInteger();
+                    break;
+                case NYA_STRING_HASH( "yoffset" ):
+                    glyph->OffsetY = value.toInteger();
+                    break;
+                case NYA_STRING_HASH( "xadvance" ):
+                    glyph->AdvanceX = value.toInteger();
+                    break;
+                default:
+                    break;
+                }
             }
+        } break;
+
+        default:
+            continue;
         }
     }
 
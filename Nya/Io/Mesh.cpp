@@ -21,59 +21,102 @@
 #include "Shared.h"
 #include "Mesh.h"
 
+#include "MeshFile.h"
+
 #include <FileSystem/FileSystemObject.h>
+#include <Maths/Packing.h>
 #include "TextStreamHelpers.h"
 
-using blockMagic_t = uint32_t;
+#include <string.h>
+
+using namespace nya::core;
 
-//=====================================
-// Mesh file header
-//=====================================
-struct FileHeader
+static void SkipBlockPadding( FileSystemObject* file )
 {
-    uint32_t    version;
-    uint32_t    fileSize;
-
-    union
-    {
-        struct
-        {
-            uint8_t hasUvMap0 : 1;
-            uint8_t hasNormals : 1;
-            uint8_t : 0;
-        };
-
-        uint32_t flagset;
-    };
-
-    uint32_t    __PADDING__;
-};
-
-//=====================================
-// Mesh file data block header
-//=====================================
-struct BlockHeader
+    // TODO This should not be necessary...
+    // Skip padding and seek to the next block offset
+    int32_t streamPos = ( file->tell() % MESH_BLOCK_ALIGNMENT );
+    if ( streamPos <= 0 ) streamPos = MESH_BLOCK_ALIGNMENT;
+    file->skip( MESH_BLOCK_ALIGNMENT - streamPos );
+}
+
+// Decode compact vertices to the uncompressed layout (float32 position, normal and uv)
+static void DecodeCompactVertices( const MeshFileHeader& fileHeader, const uint8_t* compactVertices, const std::size_t compactVerticesSize, const std::vector<MeshVertexRange>& vertexRanges, GeomLoadData& data )
 {
-    blockMagic_t	magic;
-	uint32_t        size;
-    uint32_t        subBlock1Size;
-    uint32_t        subBlock2Size;
-};
+    const uint32_t compactVertexSize = GetCompactVertexSize( fileHeader );
+    const uint32_t vertexScalarCount = GetDecodedVertexScalarCount( fileHeader );
+    const uint32_t fileVertexCount = static_cast<uint32_t>( compactVerticesSize / compactVertexSize );
+
+    uint32_t vertexCount = 0u;
+    for ( const MeshVertexRange& vertexRange : vertexRanges ) {
+        vertexCount = nya::maths::max( vertexCount, vertexRange.vertexOffset + vertexRange.vertexCount );
+    }
 
-//=====================================
-// Data block magic
-//=====================================
+    if ( vertexCount > fileVertexCount ) {
+        NYA_CWARN << "Submeshes reference " << vertexCount << " vertices (the file only stores " << fileVertexCount << " vertices)" << std::endl;
+        vertexCount = fileVertexCount;
+    }
+
+    data.vertices.resize( static_cast<std::size_t>( vertexCount ) * vertexScalarCount, 0.0f );
+
+    for ( const MeshVertexRange& vertexRange : vertexRanges ) {
+        const uint32_t rangeEnd = nya::maths::min( vertexRange.vertexOffset + vertexRange.vertexCount, vertexCount );
 
-// MATerial Library
-constexpr uint32_t MATL_MAGIC = 0x4C54414D;
+        for ( uint32_t vertexIdx = vertexRange.vertexOffset; vertexIdx < rangeEnd; vertexIdx++ ) {
+            const uint8_t* compactVertex = compactVertices + static_cast<std::size_t>( vertexIdx ) * compactVertexSize;
+            float* vertex = &data.vertices[static_cast<std::size_t>( vertexIdx ) * vertexScalarCount];
 
-// GEOMetry data
-constexpr uint32_t GEOM_MAGIC = 0x4D4F4547;
+            if ( fileHeader.hasQuantizedPositions == 1 ) {
+                uint16_t quantizedPosition[3];
+                memcpy( quantizedPosition, compactVertex, sizeof( quantizedPosition ) );
+                compactVertex += sizeof( quantizedPosition );
+
+                for ( int i = 0; i < 3; i++ ) {
+                    vertex[i] = vertexRange.positionMin[i] + nya::maths::UnpackUnorm16( quantizedPosition[i] ) * vertexRange.positionRange[i];
+                }
+            } else {
+                memcpy( vertex, compactVertex, 3 * sizeof( float ) );
+                compactVertex += 3 * sizeof( float );
+            }
+
+            vertex += 3;
+
+            if ( fileHeader.hasNormals == 1 ) {
+                int16_t encodedNormal[2];
+                memcpy( encodedNormal, compactVertex, sizeof( encodedNormal ) );
+                compactVertex += sizeof( encodedNormal );
+
+                const nyaVec3f normal = nya::maths::DecodeOctahedral( nya::maths::UnpackSnorm16( encodedNormal[0] ), nya::maths::UnpackSnorm16( encodedNormal[1] ) );
+                vertex[0] = normal.x;
+                vertex[1] = normal.y;
+                vertex[2] = normal.z;
+                vertex += 3;
+            }
+
+            if ( fileHeader.hasUvMap0 == 1 ) {
+                uint16_t uvMap0[2];
+                memcpy( uvMap0, compactVertex, sizeof( uvMap0 ) );
+
+                vertex[0] = nya::maths::UnpackHalf( uvMap0[0] );
+                vertex[1] = nya::maths::UnpackHalf( uvMap0[1] );
+            }
+        }
+    }
+}
 
 void nya::core::LoadGeometryFile( FileSystemObject* file, GeomLoadData& data )
 {
-    FileHeader fileHeader = {};
-    file->read( ( uint8_t* )&fileHeader, sizeof( FileHeader ) );
+    MeshFileHeader fileHeader = {};
+    file->read( ( uint8_t* )&fileHeader, sizeof( MeshFileHeader ) );
+
+    // Flags added by the compact version are not meaningful for older files
+    if ( fileHeader.version < MESH_VERSION_COMPACT ) {
+        fileHeader.hasQuantizedPositions = 0;
+        fileHeader.hasShortIndices = 0;
+    }
+
+    uint64_t mappedSize = 0ull;
+    const uint8_t* mappedContent = file->map( mappedSize );
 
     // The script ALWAYS export position (3D)
     data.vertexStrides = { 3 };
@@ -87,13 +130,15 @@ void nya::core::LoadGeometryFile( FileSystemObject* file, GeomLoadData& data )
         data.vertexStrides.push_back( 3 );
     }
 
+    data.indiceStride = ( fileHeader.hasShortIndices == 1 ) ? sizeof( uint16_t ) : sizeof( uint32_t );
+
     while ( file->tell() < fileHeader.fileSize ) {
-        BlockHeader blockHeader = {};
-        file->read( ( uint8_t* )&blockHeader, sizeof( BlockHeader ) );
+        MeshBlockHeader blockHeader = {};
+        file->read( ( uint8_t* )&blockHeader, sizeof( MeshBlockHeader ) );
 
         // For modularity sake, we check the block magic
         switch ( blockHeader.magic ) {
-        case MATL_MAGIC: {
+        case MESH_MATL_MAGIC: {
             const std::streampos blockEndOffset = static_cast< std::size_t >( file->tell() ) + blockHeader.size;
 
             while ( file->tell() < static_cast<uint64_t>( blockEndOffset ) ) {
@@ -108,7 +153,9 @@ void nya::core::LoadGeometryFile( FileSystemObject* file, GeomLoadData& data )
             break;
         }
 
-        case GEOM_MAGIC: {
+        case MESH_GEOM_MAGIC: {
+            std::vector<MeshVertexRange> vertexRanges;
+
             if ( fileHeader.version == 1 ) {      
                 //// Read submesh entries
                 //const uint32_t subMeshCount = ( blockHeader.size / sizeof( submeshEntry_t ) );
@@ -140,23 +187,70 @@ void nya::core::LoadGeometryFile( FileSystemObject* file, GeomLoadData& data )
 
                     file->read( subMesh.levelOfDetailIndex );
 
-                    // TODO This should not be necessary...
-                    // Skip padding and seek to the next block offset
-                    int32_t streamPos = ( file->tell() % 16 );
-                    if ( streamPos <= 0 ) streamPos = 16;
-                    file->skip( 16 - streamPos );
+                    if ( fileHeader.version >= MESH_VERSION_COMPACT ) {
+                        vertexRanges.push_back( {} );
+                        file->read( ( uint8_t* )&vertexRanges.back(), sizeof( MeshVertexRange ) );
+                    }
+
+                    SkipBlockPadding( file );
                 }
             }
 
             auto vertexBufferSize = blockHeader.subBlock1Size;
             auto indiceBufferSize = blockHeader.subBlock2Size;
 
+            data.indiceBufferSize = indiceBufferSize;
+
+            // Use buffer data in place if possible (buffers are 16 bytes aligned in the file)
+            const bool useMappedContent = ( mappedContent != nullptr && ( file->tell() + vertexBufferSize + indiceBufferSize ) <= mappedSize );
+
+            if ( fileHeader.version >= MESH_VERSION_COMPACT ) {
+                // Compact vertices are decoded (indices are used as is)
+                std::vector<uint8_t> compactVertices;
+                const uint8_t* compactVertexBuffer = nullptr;
+
+                if ( useMappedContent ) {
+                    compactVertexBuffer = mappedContent + file->tell();
+                    data.indiceBuffer = mappedContent + file->tell() + vertexBufferSize;
+
+                    file->skip( vertexBufferSize + indiceBufferSize );
+                } else {
+                    compactVertices.resize( vertexBufferSize );
+                    data.indices.resize( indiceBufferSize );
+
+                    file->read( compactVertices.data(), vertexBufferSize );
+                    file->read( data.indices.data(), indiceBufferSize );
+
+                    compactVertexBuffer = compactVertices.data();
+                    data.indiceBuffer = data.indices.data();
+                }
+
+                DecodeCompactVertices( fileHeader, compactVertexBuffer, vertexBufferSize, vertexRanges, data );
+
+                data.vertexBuffer = data.vertices.data();
+                data.vertexBufferSize = data.vertices.size() * sizeof( float );
+                break;
+            }
+
+            data.vertexBufferSize = vertexBufferSize;
+
+            if ( useMappedContent ) {
+                data.vertexBuffer = reinterpret_cast<const float*>( mappedContent + file->tell() );
+                data.indiceBuffer = mappedContent + file->tell() + vertexBufferSize;
+
+                file->skip( vertexBufferSize + indiceBufferSize );
+                break;
+            }
+
             data.vertices.resize( vertexBufferSize / sizeof( float ) );
-            data.indices.resize( indiceBufferSize / sizeof( uint32_t ) );
+            data.indices.resize( indiceBufferSize );
 
             // Read buffer data
             file->read( ( uint8_t* )data.vertices.data(), vertexBufferSize );
-            file->read( ( uint8_t* )data.indices.data(), indiceBufferSize );
+            file->read( data.indices.data(), indiceBufferSize );
+
+            data.vertexBuffer = data.vertices.data();
+            data.indiceBuffer = data.indices.data();
             break;
         }
 
@@ -164,12 +258,6 @@ void nya::core::LoadGeometryFile( FileSystemObject* file, GeomLoadData& data )
             continue;
         }
             
-        // TODO This should not be necessary...
-        // Skip padding and seek to the next block offset
-        int32_t streamPos = ( file->tell() % 16 );
-        if ( streamPos <= 0 ) streamPos = 16;
-        file->skip( 16 - streamPos );
+        SkipBlockPadding( file );
     } 
-
-    file->close();
 }
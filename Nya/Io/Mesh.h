@@ -49,17 +49,29 @@ struct GeomLoadData
     };
 
     std::vector<float>      vertices;
-    std::vector<uint32_t>   indices;
+    std::vector<uint8_t>    indices; // Raw indice data (indiceStride bytes per indice)
     std::vector<uint32_t>   vertexStrides; // Scalars per component (e.g. a basic 3D position/2D uvmap would be { 3, 2 })
 
 	std::vector<GeomLoadData::SubMesh>				subMesh;
 	std::vector<std::pair<uint32_t, nyaString_t>>	materialsReferences;
 
+    // Buffers of a loaded geometry (sizes are in bytes); point in place to the file content if it can be mapped (valid until the
+    // file is closed), to vertices/indices otherwise
+    // NOTE Compact geometry (version 4) is always decoded to vertices (the vertex layout does not depend on the file version)
+    const float*            vertexBuffer;
+    const void*             indiceBuffer;
+    std::size_t             vertexBufferSize;
+    std::size_t             indiceBufferSize;
+    uint32_t                indiceStride; // sizeof( uint16_t ) or sizeof( uint32_t )
+
     GeomLoadData()
+        : vertexBuffer( nullptr )
+        , indiceBuffer( nullptr )
+        , vertexBufferSize( 0 )
+        , indiceBufferSize( 0 )
+        , indiceStride( sizeof( uint32_t ) )
     {
-        // TODO Use proper allocators instead of std (if needed)
-        vertices.reserve( 8 * 1000 );
-        indices.reserve( 8 * 1000 * 3 );
+
     }
 
     ~GeomLoadData()
@@ -76,6 +88,7 @@ struct GeomLoadData
 //  ReadGeometryFile
 //      Read a geometry file (.mesh).
 //      NOTE This function only return the file's data; you still need to build the mesh
+//      NOTE The file is not closed (buffers might point to the file content)
 //
 //      Parameters:
 //          fileName: the geometry file to load
@@ -0,0 +1,108 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <Maths/Vector.h>
+
+// Mesh file layout (little endian; blocks start on a MESH_BLOCK_ALIGNMENT boundary)
+//  MeshFileHeader
+//  Blocks (MeshBlockHeader followed by the block content)
+//      MATL: material references (hashcode and null terminated name)
+//      GEOM: submesh entries (size bytes), vertex data (subBlock1Size bytes) then indice data (subBlock2Size bytes)
+//            (vertex data might be padded for indices alignment)
+//
+// Submesh entry (padded to MESH_BLOCK_ALIGNMENT):
+//  hashcode, name (null terminated), indiceBufferOffset (in indices), indiceCount, bounding sphere
+//  AABB location and dimensions (version >= 3), levelOfDetailIndex
+//  vertexOffset, vertexCount, position minimum and range (version >= 4; see MeshVertexRange)
+//
+// Vertex data is interleaved (position, normal then uv)
+//  Version 1 to 3: 3 x float32 position, 3 x float32 normal, 2 x float32 uv; 32 bits indices
+//  Version 4: 3 x float32 position (3 x unorm16 if hasQuantizedPositions is set; dequantized with the range of the submesh),
+//             2 x snorm16 octahedral normal, 2 x float16 uv; 16 bits indices if hasShortIndices is set
+namespace nya
+{
+    namespace core
+    {
+        static constexpr uint32_t MESH_MATL_MAGIC = 0x4C54414D; // "MATL"
+        static constexpr uint32_t MESH_GEOM_MAGIC = 0x4D4F4547; // "GEOM"
+        static constexpr uint32_t MESH_VERSION_COMPACT = 4u;
+        static constexpr uint32_t MESH_BLOCK_ALIGNMENT = 16u;
+
+        struct MeshFileHeader
+        {
+            uint32_t    version;
+            uint32_t    fileSize;
+
+            union
+            {
+                struct
+                {
+                    uint8_t hasUvMap0 : 1;
+                    uint8_t hasNormals : 1;
+                    uint8_t hasQuantizedPositions : 1;
+                    uint8_t hasShortIndices : 1;
+                    uint8_t : 0;
+                };
+
+                uint32_t flagset;
+            };
+
+            uint32_t    __PADDING__;
+        };
+
+        struct MeshBlockHeader
+        {
+            uint32_t    magic;
+            uint32_t    size;
+            uint32_t    subBlock1Size;
+            uint32_t    subBlock2Size;
+        };
+
+        // Vertices of a submesh (positions are dequantized as positionMin + unorm * positionRange)
+        struct MeshVertexRange
+        {
+            uint32_t    vertexOffset;
+            uint32_t    vertexCount;
+            nyaVec3f    positionMin;
+            nyaVec3f    positionRange;
+        };
+
+        static_assert( sizeof( MeshFileHeader ) == 16, "MeshFileHeader layout is part of the mesh format" );
+        static_assert( sizeof( MeshBlockHeader ) == 16, "MeshBlockHeader layout is part of the mesh format" );
+        static_assert( sizeof( MeshVertexRange ) == 32, "MeshVertexRange layout is part of the mesh format" );
+
+        // Size of a vertex in the file (compact layout)
+        inline uint32_t GetCompactVertexSize( const MeshFileHeader& header )
+        {
+            uint32_t vertexSize = ( header.hasQuantizedPositions == 1 ) ? 3u * sizeof( uint16_t ) : 3u * sizeof( float );
+            vertexSize += ( header.hasNormals == 1 ) ? 2u * sizeof( int16_t ) : 0u;
+            vertexSize += ( header.hasUvMap0 == 1 ) ? 2u * sizeof( uint16_t ) : 0u;
+
+            return vertexSize;
+        }
+
+        // Scalars per vertex once decoded (same layout as the uncompressed versions)
+        inline uint32_t GetDecodedVertexScalarCount( const MeshFileHeader& header )
+        {
+            return 3u + ( ( header.hasNormals == 1 ) ? 3u : 0u ) + ( ( header.hasUvMap0 == 1 ) ? 2u : 0u );
+        }
+    }
+}
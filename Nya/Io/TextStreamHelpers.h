@@ -26,7 +26,7 @@ namespace nya
 {
     namespace core
     {
-        static void ReadString( FileSystemObject* file, nyaString_t& string )
+        inline void ReadString( FileSystemObject* file, nyaString_t& string )
         {
             string.clear();
 
@@ -0,0 +1,260 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "TextStreamReader.h"
+
+#include <FileSystem/FileSystemObject.h>
+
+#include <cstring>
+#include <cstdlib>
+
+namespace
+{
+    bool IsBlankCharacter( const char character )
+    {
+        return character == ' ' || character == '\t' || character == '\r' || character == '\n';
+    }
+
+    bool IsEndOfLineCharacter( const char character )
+    {
+        return character == '\n' || character == '\r' || character == '\0' || character == static_cast<char>( 0xFF );
+    }
+
+    // Copy the token to a null terminated buffer (for the C conversion functions; numbers are never that long)
+    void CopyNumberToken( const TextToken& token, char ( &numberString )[64] )
+    {
+        const std::size_t length = ( token.length() < 63 ) ? token.length() : 63;
+
+        memcpy( numberString, token.begin, length );
+        numberString[length] = '\0';
+    }
+}
+
+bool TextToken::empty() const
+{
+    return begin == end;
+}
+
+std::size_t TextToken::length() const
+{
+    return static_cast<std::size_t>( end - begin );
+}
+
+const char* TextToken::find( const char character ) const
+{
+    const char* characterPointer = static_cast<const char*>( memchr( begin, character, length() ) );
+    return ( characterPointer != nullptr ) ? characterPointer : end;
+}
+
+TextToken TextToken::trim() const
+{
+    TextToken trimmedToken = *this;
+
+    while ( trimmedToken.begin != trimmedToken.end && IsBlankCharacter( *trimmedToken.begin ) ) {
+        trimmedToken.begin++;
+    }
+
+    while ( trimmedToken.end != trimmedToken.begin && IsBlankCharacter( *( trimmedToken.end - 1 ) ) ) {
+        trimmedToken.end--;
+    }
+
+    return trimmedToken;
+}
+
+bool TextToken::split( const char separator, TextToken& left, TextToken& right ) const
+{
+    const char* separatorPointer = find( separator );
+
+    if ( separatorPointer == end ) {
+        return false;
+    }
+
+    left = { begin, separatorPointer };
+    right = { separatorPointer + 1, end };
+
+    return true;
+}
+
+bool TextToken::popToken( const char separator, TextToken& token )
+{
+    while ( begin != end && *begin == separator ) {
+        begin++;
+    }
+
+    if ( begin == end ) {
+        return false;
+    }
+
+    const char* separatorPointer = find( separator );
+
+    token = { begin, separatorPointer };
+    begin = separatorPointer;
+
+    return true;
+}
+
+nyaStringHash_t TextToken::hash() const
+{
+    return nya::core::CRC32( begin, length() );
+}
+
+void TextToken::toString( nyaString_t& string ) const
+{
+    string.assign( begin, end );
+}
+
+nyaString_t TextToken::toString() const
+{
+    return nyaString_t( begin, end );
+}
+
+int32_t TextToken::toInteger() const
+{
+    char numberString[64];
+    CopyNumberToken( *this, numberString );
+
+    return static_cast<int32_t>( strtol( numberString, nullptr, 10 ) );
+}
+
+float TextToken::toFloat() const
+{
+    char numberString[64];
+    CopyNumberToken( *this, numberString );
+
+    return strtof( numberString, nullptr );
+}
+
+bool TextToken::toBoolean() const
+{
+    const std::size_t tokenLength = length();
+
+    if ( tokenLength == 1 ) {
+        return *begin == '1';
+    }
+
+    static constexpr char TRUE_STRING[] = "true";
+    if ( tokenLength != sizeof( TRUE_STRING ) - 1 ) {
+        return false;
+    }
+
+    for ( std::size_t i = 0; i < tokenLength; i++ ) {
+        if ( ( begin[i] | 0x20 ) != TRUE_STRING[i] ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+TextStreamReader::TextStreamReader( FileSystemObject* stream )
+    : stream( stream )
+    , remainingStreamSize( 0ull )
+    , readPointer( nullptr )
+    , endPointer( nullptr )
+{
+    const uint64_t streamOffset = stream->tell();
+
+    uint64_t mappedSize = 0ull;
+    const uint8_t* mappedContent = stream->map( mappedSize );
+
+    if ( mappedContent != nullptr ) {
+        readPointer = reinterpret_cast<const char*>( mappedContent + streamOffset );
+        endPointer = reinterpret_cast<const char*>( mappedContent + mappedSize );
+    } else {
+        remainingStreamSize = stream->getSize() - streamOffset;
+        buffer.resize( BUFFER_SIZE );
+    }
+}
+
+TextStreamReader::~TextStreamReader()
+{
+    stream = nullptr;
+}
+
+bool TextStreamReader::readLine( TextToken& line )
+{
+    const char* scanPointer = readPointer;
+
+    while ( true ) {
+        for ( ; scanPointer != endPointer; scanPointer++ ) {
+            if ( IsEndOfLineCharacter( *scanPointer ) ) {
+                line = { readPointer, scanPointer };
+                readPointer = scanPointer + 1;
+
+                return true;
+            }
+        }
+
+        // Keep the characters scanned so far (the buffer might be moved or grown)
+        const std::ptrdiff_t scannedLength = ( scanPointer - readPointer );
+
+        if ( !fillBuffer() ) {
+            break;
+        }
+
+        scanPointer = readPointer + scannedLength;
+    }
+
+    // Last line (not terminated)
+    if ( readPointer == endPointer ) {
+        return false;
+    }
+
+    line = { readPointer, endPointer };
+    readPointer = endPointer;
+
+    return true;
+}
+
+bool TextStreamReader::fillBuffer()
+{
+    if ( remainingStreamSize == 0ull ) {
+        return false;
+    }
+
+    // Move the partial line to the front of the buffer (grow the buffer if the line does not fit)
+    const std::size_t pendingLength = static_cast<std::size_t>( endPointer - readPointer );
+
+    if ( pendingLength != 0 ) {
+        memmove( buffer.data(), readPointer, pendingLength );
+    }
+
+    if ( pendingLength == buffer.size() ) {
+        buffer.resize( buffer.size() * 2 );
+    }
+
+    char* chunk = buffer.data() + pendingLength;
+
+    const uint64_t freeSize = static_cast<uint64_t>( buffer.size() - pendingLength );
+    const uint64_t chunkSize = ( remainingStreamSize < freeSize ) ? remainingStreamSize : freeSize;
+
+    // Text mode streams might return less characters than their size; the end of the last chunk is left zeroed (empty lines)
+    if ( chunkSize == remainingStreamSize ) {
+        memset( chunk, 0, static_cast<std::size_t>( chunkSize ) );
+    }
+
+    stream->read( reinterpret_cast<uint8_t*>( chunk ), chunkSize );
+    remainingStreamSize -= chunkSize;
+
+    readPointer = buffer.data();
+    endPointer = chunk + chunkSize;
+
+    return true;
+}
@@ -0,0 +1,90 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+class FileSystemObject;
+
+#include <vector>
+
+// Characters of a line read by a TextStreamReader (not null terminated; valid until the next line is read)
+struct TextToken
+{
+    const char*         begin;
+    const char*         end;
+
+    bool                empty() const;
+    std::size_t         length() const;
+
+    // Return the first occurrence of the character (or end if the token does not contain it)
+    const char*         find( const char character ) const;
+
+    // Remove leading and trailing blank characters (spaces, tabs and end of line characters)
+    TextToken           trim() const;
+
+    // Split the token at the first occurrence of the separator (neither side is trimmed)
+    // Return false (and leave left and right untouched) if the token does not contain the separator
+    bool                split( const char separator, TextToken& left, TextToken& right ) const;
+
+    // Remove the next non empty token delimited by the separator from the front of this token; return false once there is no token left
+    bool                popToken( const char separator, TextToken& token );
+
+    // Same hashcode as nya::core::CRC32 (or NYA_STRING_HASH) of the token characters
+    nyaStringHash_t     hash() const;
+
+    // Assign the characters to the string (reuses the string storage)
+    void                toString( nyaString_t& string ) const;
+    nyaString_t         toString() const;
+
+    int32_t             toInteger() const;
+    float               toFloat() const;
+    bool                toBoolean() const;
+};
+
+// Line reader over a FileSystemObject
+// Lines are scanned in place if the object content can be mapped; otherwise the stream is read in chunks of BUFFER_SIZE bytes
+// NOTE Reading starts at the current stream offset; the stream should not be read or moved while the reader is in use
+class TextStreamReader
+{
+public:
+    static constexpr std::size_t BUFFER_SIZE = 16384;
+
+public:
+                        TextStreamReader( FileSystemObject* stream );
+                        TextStreamReader( TextStreamReader& ) = delete;
+                        TextStreamReader& operator = ( TextStreamReader& ) = delete;
+                        ~TextStreamReader();
+
+    // Read the next line (without its end of line character); return false once the end of the stream is reached
+    // Lines are delimited by '\n', '\r', '\0' or 0xFF (same as nya::core::ReadString; "\r\n" yields an empty line)
+    bool                readLine( TextToken& line );
+
+private:
+    FileSystemObject*   stream;
+    std::vector<char>   buffer;
+    uint64_t            remainingStreamSize;
+
+    // Characters which have not been scanned yet (from the mapped content or the buffer)
+    const char*         readPointer;
+    const char*         endPointer;
+
+private:
+    // Read the next chunk of the stream after the characters left in the buffer; return false if the stream has been read entirely
+    bool                fillBuffer();
+};
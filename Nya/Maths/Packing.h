@@ -0,0 +1,151 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Vector.h"
+#include "Helpers.h"
+
+#include <string.h>
+#include <cmath>
+
+namespace nya
+{
+    namespace maths
+    {
+        // Pack a normalized float (0..1 range) to a 16 bits unsigned integer
+        inline uint16_t PackUnorm16( const float value )
+        {
+            return static_cast<uint16_t>( clamp( value, 0.0f, 1.0f ) * 65535.0f + 0.5f );
+        }
+
+        inline float UnpackUnorm16( const uint16_t value )
+        {
+            return static_cast<float>( value ) * ( 1.0f / 65535.0f );
+        }
+
+        // Pack a signed normalized float (-1..1 range) to a 16 bits signed integer
+        inline int16_t PackSnorm16( const float value )
+        {
+            const float scaledValue = clamp( value, -1.0f, 1.0f ) * 32767.0f;
+            return static_cast<int16_t>( scaledValue + ( ( scaledValue >= 0.0f ) ? 0.5f : -0.5f ) );
+        }
+
+        inline float UnpackSnorm16( const int16_t value )
+        {
+            return max( static_cast<float>( value ) * ( 1.0f / 32767.0f ), -1.0f );
+        }
+
+        // Convert a float to a IEEE 754 half (round to nearest; out of range values are clamped to the largest half)
+        // NOTE Denormals are flushed to zero (UVs don't need them)
+        inline uint16_t PackHalf( const float value )
+        {
+            uint32_t floatBits = 0u;
+            memcpy( &floatBits, &value, sizeof( float ) );
+
+            const uint16_t signBit = static_cast<uint16_t>( ( floatBits >> 16u ) & 0x8000u );
+            const int32_t exponent = static_cast<int32_t>( ( floatBits >> 23u ) & 0xFFu ) - 127 + 15;
+            const uint32_t mantissa = ( floatBits & 0x7FFFFFu );
+
+            if ( exponent <= 0 ) {
+                return signBit;
+            }
+
+            if ( exponent >= 31 ) {
+                // Keep NaNs; clamp everything else
+                return ( ( ( floatBits >> 23u ) & 0xFFu ) == 0xFFu && mantissa != 0u ) ? static_cast<uint16_t>( signBit | 0x7E00u ) : static_cast<uint16_t>( signBit | 0x7BFFu );
+            }
+
+            // Rounding can carry into the exponent (which is still a valid half)
+            const uint32_t halfBits = ( static_cast<uint32_t>( exponent ) << 10u ) + ( ( mantissa + 0x1000u ) >> 13u );
+            return static_cast<uint16_t>( signBit | min( halfBits, 0x7BFFu ) );
+        }
+
+        inline float UnpackHalf( const uint16_t value )
+        {
+            const uint32_t signBit = ( static_cast<uint32_t>( value & 0x8000u ) << 16u );
+            const uint32_t exponent = ( ( value >> 10u ) & 0x1Fu );
+            const uint32_t mantissa = ( value & 0x3FFu );
+
+            uint32_t floatBits = signBit;
+            if ( exponent == 0x1Fu ) {
+                floatBits |= 0x7F800000u | ( mantissa << 13u );
+            } else if ( exponent != 0u ) {
+                floatBits |= ( ( exponent + 127u - 15u ) << 23u ) | ( mantissa << 13u );
+            } else if ( mantissa != 0u ) {
+                // Denormal half (normalized float)
+                const float denormalValue = static_cast<float>( mantissa ) * ( 1.0f / 16777216.0f );
+                return ( signBit != 0u ) ? -denormalValue : denormalValue;
+            }
+
+            float unpackedValue = 0.0f;
+            memcpy( &unpackedValue, &floatBits, sizeof( float ) );
+            return unpackedValue;
+        }
+
+        // Octahedral encoding of a unit vector (two -1..1 components)
+        // See 'A Survey of Efficient Representations for Independent Unit Vectors' (Cigolle et al.)
+        inline nyaVec2f EncodeOctahedral( const nyaVec3f& unitVector )
+        {
+            const float l1Norm = abs( unitVector.x ) + abs( unitVector.y ) + abs( unitVector.z );
+            if ( l1Norm <= 0.0f ) {
+                return nyaVec2f( 0.0f, 0.0f );
+            }
+
+            const float x = unitVector.x / l1Norm;
+            const float y = unitVector.y / l1Norm;
+
+            if ( unitVector.z >= 0.0f ) {
+                return nyaVec2f( x, y );
+            }
+
+            // Fold the lower hemisphere over the diagonals
+            return nyaVec2f( ( 1.0f - abs( y ) ) * sign( x ), ( 1.0f - abs( x ) ) * sign( y ) );
+        }
+
+        // NOTE Branchless (decoded on load for every vertex of compact meshes)
+        inline nyaVec3f DecodeOctahedral( const float encodedX, const float encodedY )
+        {
+            const float z = 1.0f - fabsf( encodedX ) - fabsf( encodedY );
+
+            // Unfold the lower hemisphere (t is zero for the upper hemisphere)
+            const float t = fmaxf( -z, 0.0f );
+            const float x = encodedX + copysignf( t, -encodedX );
+            const float y = encodedY + copysignf( t, -encodedY );
+
+            const float inverseLength = 1.0f / sqrtf( x * x + y * y + z * z );
+            return nyaVec3f( x * inverseLength, y * inverseLength, z * inverseLength );
+        }
+
+        // Pack a normalized float (0..1 range) to a 8 bits unsigned integer
+        inline uint8_t PackUnorm8( const float value )
+        {
+            return static_cast<uint8_t>( clamp( value, 0.0f, 1.0f ) * 255.0f + 0.5f );
+        }
+
+        // Pack a normalized color to a RGBA8 unorm value (red in the lowest byte)
+        inline uint32_t PackColorRGBA8( const nyaVec4f& color )
+        {
+            return static_cast<uint32_t>( PackUnorm8( color.x ) )
+                | ( static_cast<uint32_t>( PackUnorm8( color.y ) ) << 8 )
+                | ( static_cast<uint32_t>( PackUnorm8( color.z ) ) << 16 )
+                | ( static_cast<uint32_t>( PackUnorm8( color.w ) ) << 24 );
+        }
+    }
+}
@@ -0,0 +1,338 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "SphericalHarmonics.h"
+
+#include "Helpers.h"
+#include "Sampling.h"
+
+#include <cmath>
+
+#if NYA_SSE42
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // SH basis normalization constants
+    static constexpr float SH_Y00 = 0.282095f;
+    static constexpr float SH_Y1 = 0.488603f;
+    static constexpr float SH_Y2 = 1.092548f;
+    static constexpr float SH_Y20 = 0.315392f;
+    static constexpr float SH_Y22 = 0.546274f;
+
+    // Clamped cosine lobe convolution factors (divided by PI) per band
+    static constexpr float SH_COSINE_LOBE_BAND[nya::maths::SH9_COEFFICIENT_COUNT] = {
+        1.0f,
+        2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f,
+        0.25f, 0.25f, 0.25f, 0.25f, 0.25f
+    };
+
+    // Face basis (X, Y, Z); texel direction is Z + u * X + v * Y (same convention as the IBL probe convolution)
+    static constexpr float CUBE_FACE_AXIS[6][9] = {
+        { 0.0f, 0.0f, -1.0f,    0.0f, 1.0f, 0.0f,   1.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f,     0.0f, 1.0f, 0.0f,   -1.0f, 0.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f,     0.0f, 0.0f, -1.0f,  0.0f, 1.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f,     0.0f, 0.0f, 1.0f,   0.0f, -1.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f,     0.0f, 1.0f, 0.0f,   0.0f, 0.0f, 1.0f },
+        { -1.0f, 0.0f, 0.0f,    0.0f, 1.0f, 0.0f,   0.0f, 0.0f, -1.0f },
+    };
+
+    void EvaluateBasis( const float x, const float y, const float z, float basis[nya::maths::SH9_COEFFICIENT_COUNT] )
+    {
+        basis[0] = SH_Y00;
+        basis[1] = SH_Y1 * y;
+        basis[2] = SH_Y1 * z;
+        basis[3] = SH_Y1 * x;
+        basis[4] = SH_Y2 * x * y;
+        basis[5] = SH_Y2 * y * z;
+        basis[6] = SH_Y20 * ( 3.0f * z * z - 1.0f );
+        basis[7] = SH_Y2 * x * z;
+        basis[8] = SH_Y22 * ( x * x - y * y );
+    }
+
+    // Normalized texel direction; returns the texel solid angle
+    float GetTexelDirection( const uint32_t faceIndex, const float u, const float v, float& x, float& y, float& z, const float texelArea )
+    {
+        const float* axis = CUBE_FACE_AXIS[faceIndex];
+
+        x = axis[6] + u * axis[0] + v * axis[3];
+        y = axis[7] + u * axis[1] + v * axis[4];
+        z = axis[8] + u * axis[2] + v * axis[5];
+
+        const float invLength = 1.0f / std::sqrt( x * x + y * y + z * z );
+        x *= invLength;
+        y *= invLength;
+        z *= invLength;
+
+        return texelArea * invLength * invLength * invLength;
+    }
+
+#if NYA_SSE42
+    float HorizontalSum( const __m128 value )
+    {
+        __m128 shuffled = _mm_shuffle_ps( value, value, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+        __m128 sum = _mm_add_ps( value, shuffled );
+        shuffled = _mm_movehl_ps( shuffled, sum );
+        sum = _mm_add_ss( sum, shuffled );
+
+        return _mm_cvtss_f32( sum );
+    }
+#endif
+}
+
+namespace nya
+{
+    namespace maths
+    {
+        void SH9ClearProjection( SH9Projection& projection )
+        {
+            for ( nyaVec4f& coefficient : projection.Radiance.Coefficients ) {
+                coefficient = nyaVec4f( 0.0f, 0.0f, 0.0f, 0.0f );
+            }
+
+            projection.WeightSum = 0.0f;
+        }
+
+        void SH9ProjectCubemapFace( SH9Projection& projection, const float* faceTexels, const uint32_t faceSize, const uint32_t faceIndex )
+        {
+            NYA_DEV_ASSERT( faceIndex < 6u, "Invalid cubemap face index (%u >= 6)", faceIndex );
+
+            const float texelSize = 2.0f / static_cast<float>( faceSize );
+            const float texelArea = texelSize * texelSize;
+
+            // Rows are accumulated in float (one lane per texel) then flushed to double to keep the precision on big faces
+            double radianceSum[SH9_COEFFICIENT_COUNT][3] = {};
+            double weightSum = 0.0;
+
+            uint32_t simdTexelCount = 0u;
+
+#if NYA_SSE42
+            simdTexelCount = ( faceSize & ~3u );
+
+            const float* axis = CUBE_FACE_AXIS[faceIndex];
+            const __m128 laneOffsets = _mm_set_ps( 3.5f, 2.5f, 1.5f, 0.5f );
+            const __m128 texelSizeVec = _mm_set1_ps( texelSize );
+            const __m128 texelAreaVec = _mm_set1_ps( texelArea );
+            const __m128 one = _mm_set1_ps( 1.0f );
+            const __m128 three = _mm_set1_ps( 3.0f );
+
+            const __m128 axisX[3] = { _mm_set1_ps( axis[0] ), _mm_set1_ps( axis[1] ), _mm_set1_ps( axis[2] ) };
+#endif
+
+            for ( uint32_t y = 0u; y < faceSize; y++ ) {
+                const float v = 1.0f - ( static_cast<float>( y ) + 0.5f ) * texelSize;
+                const float* rowTexels = faceTexels + static_cast<size_t>( y ) * faceSize * 4u;
+
+#if NYA_SSE42
+                __m128 rowRadiance[SH9_COEFFICIENT_COUNT][3];
+                for ( uint32_t i = 0u; i < SH9_COEFFICIENT_COUNT; i++ ) {
+                    rowRadiance[i][0] = _mm_setzero_ps();
+                    rowRadiance[i][1] = _mm_setzero_ps();
+                    rowRadiance[i][2] = _mm_setzero_ps();
+                }
+                __m128 rowWeight = _mm_setzero_ps();
+
+                // Z + v * Y is constant for the whole row
+                const __m128 rowOriginX = _mm_set1_ps( axis[6] + v * axis[3] );
+                const __m128 rowOriginY = _mm_set1_ps( axis[7] + v * axis[4] );
+                const __m128 rowOriginZ = _mm_set1_ps( axis[8] + v * axis[5] );
+
+                for ( uint32_t x = 0u; x < simdTexelCount; x += 4u ) {
+                    const __m128 u = _mm_sub_ps( _mm_mul_ps( _mm_add_ps( _mm_set1_ps( static_cast<float>( x ) ), laneOffsets ), texelSizeVec ), one );
+
+                    __m128 dirX = _mm_add_ps( rowOriginX, _mm_mul_ps( u, axisX[0] ) );
+                    __m128 dirY = _mm_add_ps( rowOriginY, _mm_mul_ps( u, axisX[1] ) );
+                    __m128 dirZ = _mm_add_ps( rowOriginZ, _mm_mul_ps( u, axisX[2] ) );
+
+                    const __m128 lengthSquared = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dirX, dirX ), _mm_mul_ps( dirY, dirY ) ), _mm_mul_ps( dirZ, dirZ ) );
+                    const __m128 invLength = _mm_div_ps( one, _mm_sqrt_ps( lengthSquared ) );
+
+                    dirX = _mm_mul_ps( dirX, invLength );
+                    dirY = _mm_mul_ps( dirY, invLength );
+                    dirZ = _mm_mul_ps( dirZ, invLength );
+
+                    // Texel solid angle
+                    const __m128 weight = _mm_mul_ps( texelAreaVec, _mm_mul_ps( invLength, _mm_mul_ps( invLength, invLength ) ) );
+                    rowWeight = _mm_add_ps( rowWeight, weight );
+
+                    // Load 4 RGBA texels and transpose them to SoA
+                    __m128 red = _mm_loadu_ps( rowTexels + x * 4u );
+                    __m128 green = _mm_loadu_ps( rowTexels + x * 4u + 4u );
+                    __m128 blue = _mm_loadu_ps( rowTexels + x * 4u + 8u );
+                    __m128 alpha = _mm_loadu_ps( rowTexels + x * 4u + 12u );
+                    _MM_TRANSPOSE4_PS( red, green, blue, alpha );
+
+                    red = _mm_mul_ps( red, weight );
+                    green = _mm_mul_ps( green, weight );
+                    blue = _mm_mul_ps( blue, weight );
+
+                    const __m128 basis[SH9_COEFFICIENT_COUNT] = {
+                        _mm_set1_ps( SH_Y00 ),
+                        _mm_mul_ps( _mm_set1_ps( SH_Y1 ), dirY ),
+                        _mm_mul_ps( _mm_set1_ps( SH_Y1 ), dirZ ),
+                        _mm_mul_ps( _mm_set1_ps( SH_Y1 ), dirX ),
+                        _mm_mul_ps( _mm_set1_ps( SH_Y2 ), _mm_mul_ps( dirX, dirY ) ),
+                        _mm_mul_ps( _mm_set1_ps( SH_Y2 ), _mm_mul_ps( dirY, dirZ ) ),
+                        _mm_mul_ps( _mm_set1_ps( SH_Y20 ), _mm_sub_ps( _mm_mul_ps( three, _mm_mul_ps( dirZ, dirZ ) ), one ) ),
+                        _mm_mul_ps( _mm_set1_ps( SH_Y2 ), _mm_mul_ps( dirX, dirZ ) ),
+                        _mm_mul_ps( _mm_set1_ps( SH_Y22 ), _mm_sub_ps( _mm_mul_ps( dirX, dirX ), _mm_mul_ps( dirY, dirY ) ) ),
+                    };
+
+                    for ( uint32_t i = 0u; i < SH9_COEFFICIENT_COUNT; i++ ) {
+                        rowRadiance[i][0] = _mm_add_ps( rowRadiance[i][0], _mm_mul_ps( basis[i], red ) );
+                        rowRadiance[i][1] = _mm_add_ps( rowRadiance[i][1], _mm_mul_ps( basis[i], green ) );
+                        rowRadiance[i][2] = _mm_add_ps( rowRadiance[i][2], _mm_mul_ps( basis[i], blue ) );
+                    }
+                }
+
+                for ( uint32_t i = 0u; i < SH9_COEFFICIENT_COUNT; i++ ) {
+                    radianceSum[i][0] += HorizontalSum( rowRadiance[i][0] );
+                    radianceSum[i][1] += HorizontalSum( rowRadiance[i][1] );
+                    radianceSum[i][2] += HorizontalSum( rowRadiance[i][2] );
+                }
+                weightSum += HorizontalSum( rowWeight );
+#endif
+
+                // Scalar path (remaining texels or no SIMD support)
+                for ( uint32_t x = simdTexelCount; x < faceSize; x++ ) {
+                    const float u = ( static_cast<float>( x ) + 0.5f ) * texelSize - 1.0f;
+
+                    float dirX, dirY, dirZ;
+                    const float weight = GetTexelDirection( faceIndex, u, v, dirX, dirY, dirZ, texelArea );
+
+                    float basis[SH9_COEFFICIENT_COUNT];
+                    EvaluateBasis( dirX, dirY, dirZ, basis );
+
+                    const float* texel = rowTexels + x * 4u;
+                    for ( uint32_t i = 0u; i < SH9_COEFFICIENT_COUNT; i++ ) {
+                        radianceSum[i][0] += basis[i] * texel[0] * weight;
+                        radianceSum[i][1] += basis[i] * texel[1] * weight;
+                        radianceSum[i][2] += basis[i] * texel[2] * weight;
+                    }
+
+                    weightSum += weight;
+                }
+            }
+
+            for ( uint32_t i = 0u; i < SH9_COEFFICIENT_COUNT; i++ ) {
+                projection.Radiance.Coefficients[i].x += static_cast<float>( radianceSum[i][0] );
+                projection.Radiance.Coefficients[i].y += static_cast<float>( radianceSum[i][1] );
+                projection.Radiance.Coefficients[i].z += static_cast<float>( radianceSum[i][2] );
+            }
+
+            projection.WeightSum += static_cast<float>( weightSum );
+        }
+
+        SH9 SH9ComputeIrradiance( const SH9Projection& projection )
+        {
+            // Renormalize using the actual sum of the texels solid angle (should be close to 4 PI)
+            const float normalization = ( projection.WeightSum > 0.0f ) ? ( 4.0f * PI<float>() ) / projection.WeightSum : 0.0f;
+
+            SH9 irradiance;
+            for ( uint32_t i = 0u; i < SH9_COEFFICIENT_COUNT; i++ ) {
+                const float scale = normalization * SH_COSINE_LOBE_BAND[i];
+                const nyaVec4f& radiance = projection.Radiance.Coefficients[i];
+
+                irradiance.Coefficients[i] = nyaVec4f( radiance.x * scale, radiance.y * scale, radiance.z * scale, 0.0f );
+            }
+
+            return irradiance;
+        }
+
+        nyaVec3f SH9Evaluate( const SH9& sh, const nyaVec3f& direction )
+        {
+            float basis[SH9_COEFFICIENT_COUNT];
+            EvaluateBasis( direction.x, direction.y, direction.z, basis );
+
+            nyaVec3f result( 0.0f, 0.0f, 0.0f );
+            for ( uint32_t i = 0u; i < SH9_COEFFICIENT_COUNT; i++ ) {
+                result.x += sh.Coefficients[i].x * basis[i];
+                result.y += sh.Coefficients[i].y * basis[i];
+                result.z += sh.Coefficients[i].z * basis[i];
+            }
+
+            return result;
+        }
+
+        nyaVec3f ComputeCubemapIrradianceReference( const float* const faceTexels[6], const uint32_t faceSize, const nyaVec3f& normal )
+        {
+            const float texelSize = 2.0f / static_cast<float>( faceSize );
+            const float texelArea = texelSize * texelSize;
+
+            double irradiance[3] = { 0.0, 0.0, 0.0 };
+            double weightSum = 0.0;
+
+            for ( uint32_t faceIndex = 0u; faceIndex < 6u; faceIndex++ ) {
+                for ( uint32_t y = 0u; y < faceSize; y++ ) {
+                    const float v = 1.0f - ( static_cast<float>( y ) + 0.5f ) * texelSize;
+
+                    for ( uint32_t x = 0u; x < faceSize; x++ ) {
+                        const float u = ( static_cast<float>( x ) + 0.5f ) * texelSize - 1.0f;
+
+                        float dirX, dirY, dirZ;
+                        const float weight = GetTexelDirection( faceIndex, u, v, dirX, dirY, dirZ, texelArea );
+                        weightSum += weight;
+
+                        const float cosTheta = dirX * normal.x + dirY * normal.y + dirZ * normal.z;
+                        if ( cosTheta <= 0.0f ) {
+                            continue;
+                        }
+
+                        const float* texel = faceTexels[faceIndex] + ( static_cast<size_t>( y ) * faceSize + x ) * 4u;
+                        irradiance[0] += texel[0] * cosTheta * weight;
+                        irradiance[1] += texel[1] * cosTheta * weight;
+                        irradiance[2] += texel[2] * cosTheta * weight;
+                    }
+                }
+            }
+
+            const double normalization = ( weightSum > 0.0 ) ? ( 4.0 / weightSum ) : 0.0; // ( 4 PI / weightSum ) / PI
+
+            return nyaVec3f( static_cast<float>( irradiance[0] * normalization ), static_cast<float>( irradiance[1] * normalization ), static_cast<float>( irradiance[2] * normalization ) );
+        }
+
+        float SH9ComputeIrradianceError( const SH9& irradiance, const float* const faceTexels[6], const uint32_t faceSize, const uint32_t sampleCount )
+        {
+            float maxError = 0.0f;
+
+            for ( uint32_t sampleIdx = 0u; sampleIdx < sampleCount; sampleIdx++ ) {
+                // Uniform distribution on the sphere
+                const nyaVec2f xi = Hammersley2D( sampleIdx, sampleCount );
+                const float cosTheta = 1.0f - 2.0f * xi.x;
+                const float sinTheta = std::sqrt( max( 0.0f, 1.0f - cosTheta * cosTheta ) );
+                const float phi = TWO_PI<float>() * xi.y;
+
+                const nyaVec3f direction( sinTheta * std::cos( phi ), sinTheta * std::sin( phi ), cosTheta );
+
+                const nyaVec3f reference = ComputeCubemapIrradianceReference( faceTexels, faceSize, direction );
+                const nyaVec3f approximation = SH9Evaluate( irradiance, direction );
+
+                const float referenceMagnitude = max( max( reference.x, reference.y ), max( reference.z, 1e-4f ) );
+                const float difference = max( max( std::fabs( approximation.x - reference.x ), std::fabs( approximation.y - reference.y ) ), std::fabs( approximation.z - reference.z ) );
+
+                maxError = max( maxError, difference / referenceMagnitude );
+            }
+
+            return maxError;
+        }
+    }
+}
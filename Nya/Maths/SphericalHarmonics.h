@@ -0,0 +1,63 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Vector.h"
+
+namespace nya
+{
+    namespace maths
+    {
+        static constexpr uint32_t SH9_COEFFICIENT_COUNT = 9u;
+
+        // Order 2 RGB spherical harmonics (xyz: rgb; w: unused)
+        struct SH9
+        {
+            nyaVec4f    Coefficients[SH9_COEFFICIENT_COUNT];
+        };
+
+        // Radiance projection of a cubemap (faces can be accumulated independently, e.g. as they are captured)
+        struct SH9Projection
+        {
+            SH9         Radiance;
+            float       WeightSum; // Sum of the solid angles of the projected texels
+        };
+
+        void        SH9ClearProjection( SH9Projection& projection );
+
+        // Accumulate the projection of a cubemap face
+        // Texels are linear RGBA float (faceSize * faceSize, rows from top to bottom); faces use the D3D order (+X, -X, +Y, -Y, +Z, -Z)
+        void        SH9ProjectCubemapFace( SH9Projection& projection, const float* faceTexels, const uint32_t faceSize, const uint32_t faceIndex );
+
+        // Convolve the projected radiance with a clamped cosine lobe
+        // NOTE Irradiance is divided by PI (same scale as the convoluted diffuse probes)
+        SH9         SH9ComputeIrradiance( const SH9Projection& projection );
+
+        nyaVec3f    SH9Evaluate( const SH9& sh, const nyaVec3f& direction );
+
+        // Brute force cosine convolution of a cubemap (divided by PI); this is the integral estimated by the GPU diffuse convolution
+        // NOTE Slow (iterates over every texel); should only be used as a reference
+        nyaVec3f    ComputeCubemapIrradianceReference( const float* const faceTexels[6], const uint32_t faceSize, const nyaVec3f& normal );
+
+        // Return the max relative error between the SH irradiance and the reference convolution (evaluated on sampleCount directions)
+        float       SH9ComputeIrradianceError( const SH9& irradiance, const float* const faceTexels[6], const uint32_t faceSize, const uint32_t sampleCount );
+    }
+}
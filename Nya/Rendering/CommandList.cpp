@@ -27,3 +27,26 @@ CommandList::CommandList( BaseAllocator* allocator )
 
 }
 
+#if NYA_DEVBUILD
+static thread_local CommandListListener* g_CommandListListener = nullptr;
+
+void nya::rendering::SetCommandListListener( CommandListListener* listener )
+{
+    g_CommandListListener = listener;
+}
+
+void nya::rendering::NotifyCommandListBegin( CommandList* cmdList )
+{
+    if ( g_CommandListListener != nullptr ) {
+        g_CommandListListener->onCommandListBegin( cmdList );
+    }
+}
+
+void nya::rendering::NotifyCommandListEnd( CommandList* cmdList )
+{
+    if ( g_CommandListListener != nullptr ) {
+        g_CommandListListener->onCommandListEnd( cmdList );
+    }
+}
+#endif
+
@@ -104,6 +104,8 @@ public:
     void                dispatchCompute( const unsigned int threadCountX, const unsigned int threadCountY, const unsigned int threadCountZ );
 
     void                updateBuffer( Buffer* buffer, const void* data, const size_t dataSize );
+    // Update a sub range of a non-dynamic buffer (the rest of the buffer content is preserved)
+    void                updateBufferRange( Buffer* buffer, const void* data, const size_t dataSize, const size_t offsetInBytes );
     void                copyStructureCount( Buffer* srcBuffer, Buffer* dstBuffer, const unsigned int offset = 0 );
 
     unsigned int        allocateQuery( QueryPool* queryPool );
@@ -114,3 +116,27 @@ public:
 private:
     BaseAllocator*      memoryAllocator;
 };
+
+#if NYA_DEVBUILD
+// Notified when a command list is opened/closed on the thread the listener is registered on
+// (used by the GPU profiler to write timestamps in the command lists recorded by a render pass)
+class CommandListListener
+{
+public:
+    virtual void        onCommandListBegin( CommandList* cmdList ) = 0;
+    virtual void        onCommandListEnd( CommandList* cmdList ) = 0;
+};
+
+namespace nya
+{
+    namespace rendering
+    {
+        // Register a listener for the calling thread (nullptr to unregister)
+        void            SetCommandListListener( CommandListListener* listener );
+
+        // Called by the backends from CommandList::begin/end
+        void            NotifyCommandListBegin( CommandList* cmdList );
+        void            NotifyCommandListEnd( CommandList* cmdList );
+    }
+}
+#endif
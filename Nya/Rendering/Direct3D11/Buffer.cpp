@@ -31,8 +31,12 @@
 
 #include "Texture.h"
 
+#include <Maths/Helpers.h>
+
 #include <d3d11.h>
 
+size_t BitsPerPixel( DXGI_FORMAT fmt );
+
 Buffer* CreateConstantBuffer( ID3D11Device* device, Buffer* preallocatedBuffer, const BufferDesc& description, const void* initialData )
 {
     // Subresource description
@@ -93,6 +97,8 @@ Buffer* CreateIndiceBuffer( ID3D11Device* device, Buffer* preallocatedBuffer, co
 
     device->CreateBuffer( &bufferDescription, ( initialData != nullptr ) ? &subresourceDataDesc : nullptr, &preallocatedBuffer->bufferObject );
 
+    preallocatedBuffer->bufferStride = description.stride;
+
     return preallocatedBuffer;
 }
 
@@ -429,6 +435,107 @@ void RenderDevice::destroyBuffer( Buffer* buffer )
     nya::core::free( memoryAllocator, buffer );
 }
 
+static bool ReadTexture3D( ID3D11Device* nativeDevice, ID3D11DeviceContext* nativeDeviceContext, ID3D11Texture3D* texture, void* data, const size_t dataSize )
+{
+    D3D11_TEXTURE3D_DESC textureDesc;
+    texture->GetDesc( &textureDesc );
+
+    const UINT rowSize = static_cast<UINT>( ( textureDesc.Width * BitsPerPixel( textureDesc.Format ) + 7 ) / 8 );
+    const size_t sliceSize = static_cast<size_t>( rowSize ) * textureDesc.Height;
+    if ( dataSize < sliceSize * textureDesc.Depth ) {
+        NYA_CERR << "Buffer readback storage is too small (" << dataSize << " bytes; " << ( sliceSize * textureDesc.Depth ) << " bytes expected)" << std::endl;
+        return false;
+    }
+
+    D3D11_TEXTURE3D_DESC stagingDesc = textureDesc;
+    stagingDesc.MipLevels = 1;
+    stagingDesc.Usage = D3D11_USAGE_STAGING;
+    stagingDesc.BindFlags = 0;
+    stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    stagingDesc.MiscFlags = 0;
+
+    ID3D11Texture3D* stagingTexture = nullptr;
+    HRESULT operationResult = nativeDevice->CreateTexture3D( &stagingDesc, nullptr, &stagingTexture );
+    if ( FAILED( operationResult ) ) {
+        NYA_CERR << "Failed to create readback texture! (error code: " << NYA_PRINT_HEX( operationResult ) << ")" << std::endl;
+        return false;
+    }
+
+    nativeDeviceContext->CopySubresourceRegion( stagingTexture, 0, 0, 0, 0, texture, 0, nullptr );
+
+    // Map blocks until the copy is done
+    D3D11_MAPPED_SUBRESOURCE mappedSubresource;
+    operationResult = nativeDeviceContext->Map( stagingTexture, 0, D3D11_MAP_READ, 0, &mappedSubresource );
+    if ( FAILED( operationResult ) ) {
+        NYA_CERR << "Failed to map readback texture! (error code: " << NYA_PRINT_HEX( operationResult ) << ")" << std::endl;
+        stagingTexture->Release();
+        return false;
+    }
+
+    const uint8_t* mappedTexels = static_cast<const uint8_t*>( mappedSubresource.pData );
+    uint8_t* outputTexels = static_cast<uint8_t*>( data );
+    for ( UINT slice = 0; slice < textureDesc.Depth; slice++ ) {
+        for ( UINT row = 0; row < textureDesc.Height; row++ ) {
+            memcpy( outputTexels + slice * sliceSize + row * rowSize, mappedTexels + slice * mappedSubresource.DepthPitch + row * mappedSubresource.RowPitch, rowSize );
+        }
+    }
+
+    nativeDeviceContext->Unmap( stagingTexture, 0 );
+    stagingTexture->Release();
+
+    return true;
+}
+
+bool RenderDevice::readBuffer( Buffer* buffer, void* data, const size_t dataSize )
+{
+    ID3D11Device* nativeDevice = renderContext->nativeDevice;
+    ID3D11DeviceContext* nativeDeviceContext = renderContext->nativeDeviceContext;
+
+    if ( buffer->bufferTexture != nullptr ) {
+        D3D11_RESOURCE_DIMENSION resourceDimension;
+        buffer->bufferTexture->textureResource->GetType( &resourceDimension );
+
+        if ( resourceDimension != D3D11_RESOURCE_DIMENSION_TEXTURE3D ) {
+            NYA_CERR << "Buffer readback is only implemented for plain and 3D texture buffers!" << std::endl;
+            return false;
+        }
+
+        return ReadTexture3D( nativeDevice, nativeDeviceContext, buffer->bufferTexture->texture3D, data, dataSize );
+    }
+
+    D3D11_BUFFER_DESC bufferDesc;
+    buffer->bufferObject->GetDesc( &bufferDesc );
+
+    D3D11_BUFFER_DESC stagingDesc = {};
+    stagingDesc.ByteWidth = bufferDesc.ByteWidth;
+    stagingDesc.Usage = D3D11_USAGE_STAGING;
+    stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+    ID3D11Buffer* stagingBuffer = nullptr;
+    HRESULT operationResult = nativeDevice->CreateBuffer( &stagingDesc, nullptr, &stagingBuffer );
+    if ( FAILED( operationResult ) ) {
+        NYA_CERR << "Failed to create readback buffer! (error code: " << NYA_PRINT_HEX( operationResult ) << ")" << std::endl;
+        return false;
+    }
+
+    nativeDeviceContext->CopyResource( stagingBuffer, buffer->bufferObject );
+
+    D3D11_MAPPED_SUBRESOURCE mappedSubresource;
+    operationResult = nativeDeviceContext->Map( stagingBuffer, 0, D3D11_MAP_READ, 0, &mappedSubresource );
+    if ( FAILED( operationResult ) ) {
+        NYA_CERR << "Failed to map readback buffer! (error code: " << NYA_PRINT_HEX( operationResult ) << ")" << std::endl;
+        stagingBuffer->Release();
+        return false;
+    }
+
+    memcpy( data, mappedSubresource.pData, nya::maths::min( dataSize, static_cast<size_t>( bufferDesc.ByteWidth ) ) );
+
+    nativeDeviceContext->Unmap( stagingBuffer, 0 );
+    stagingBuffer->Release();
+
+    return true;
+}
+
 void RenderDevice::setDebugMarker( Buffer* buffer, const char* objectName )
 {
     buffer->bufferObject->SetPrivateData( WKPDID_D3DDebugObjectName, static_cast< UINT >( strlen( objectName ) ), objectName );
@@ -443,7 +550,10 @@ void CommandList::bindVertexBuffer( const Buffer* buffer, const unsigned int bin
 
 void CommandList::bindIndiceBuffer( const Buffer* buffer )
 {
-    CommandListObject->deferredContext->IASetIndexBuffer( buffer->bufferObject, DXGI_FORMAT::DXGI_FORMAT_R32_UINT, 0u );
+    // Indices are 32 bits unless the buffer has been created with a 16 bits stride
+    const DXGI_FORMAT indiceFormat = ( buffer->bufferStride == sizeof( uint16_t ) ) ? DXGI_FORMAT::DXGI_FORMAT_R16_UINT : DXGI_FORMAT::DXGI_FORMAT_R32_UINT;
+
+    CommandListObject->deferredContext->IASetIndexBuffer( buffer->bufferObject, indiceFormat, 0u );
 }
 
 void CommandList::updateBuffer( Buffer* buffer, const void* data, const size_t dataSize )
@@ -463,6 +573,26 @@ void CommandList::updateBuffer( Buffer* buffer, const void* data, const size_t d
     }
 }
 
+void CommandList::updateBufferRange( Buffer* buffer, const void* data, const size_t dataSize, const size_t offsetInBytes )
+{
+    D3D11_BOX updateBox = {};
+    updateBox.left = static_cast<UINT>( offsetInBytes );
+    updateBox.right = static_cast<UINT>( offsetInBytes + dataSize );
+    updateBox.top = 0;
+    updateBox.bottom = 1;
+    updateBox.front = 0;
+    updateBox.back = 1;
+
+    // If the command list is emulated by the runtime, the box offset is applied to the source pointer too
+    // (the pointer has to be moved backward to compensate)
+    const uint8_t* sourceData = static_cast<const uint8_t*>( data );
+    if ( CommandListObject->emulatedCommandList ) {
+        sourceData -= offsetInBytes;
+    }
+
+    CommandListObject->deferredContext->UpdateSubresource( buffer->bufferObject, 0, &updateBox, sourceData, 0, 0 );
+}
+
 void CommandList::copyStructureCount( Buffer* srcBuffer, Buffer* dstBuffer, const unsigned int offset )
 {
     CommandListObject->deferredContext->CopyStructureCount( dstBuffer->bufferObject, offset, srcBuffer->bufferUAVObject );
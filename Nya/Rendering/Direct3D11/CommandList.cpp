@@ -32,11 +32,17 @@ CommandList::~CommandList()
 
 void CommandList::begin()
 {
-
+#if NYA_DEVBUILD
+    nya::rendering::NotifyCommandListBegin( this );
+#endif
 }
 
 void CommandList::end()
 {
+#if NYA_DEVBUILD
+    nya::rendering::NotifyCommandListEnd( this );
+#endif
+
     CommandListObject->deferredContext->FinishCommandList( FALSE, &CommandListObject->commandList );
 }
 
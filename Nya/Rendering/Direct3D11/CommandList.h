@@ -28,5 +28,9 @@ struct NativeCommandList
 {
     ID3D11DeviceContext*    deferredContext;
     ID3D11CommandList*      commandList;
+
+    // True if the driver does not support command lists natively (UpdateSubresource source pointer has to be adjusted
+    // when a destination box is provided; see ID3D11DeviceContext::UpdateSubresource remarks)
+    bool                    emulatedCommandList;
 };
 #endif
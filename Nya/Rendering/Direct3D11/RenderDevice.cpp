@@ -275,6 +275,7 @@ void RenderDevice::create( DisplaySurface* surface )
     for ( size_t i = 0; i < 16; i++ ) {
         renderContext->cmdListPool[i].CommandListObject = nya::core::allocate<NativeCommandList>( memoryAllocator );
         renderContext->nativeDevice->CreateDeferredContext( 0, &renderContext->cmdListPool[i].CommandListObject->deferredContext );
+        renderContext->cmdListPool[i].CommandListObject->emulatedCommandList = ( threadingInfos.DriverCommandLists == FALSE );
     }
 
     renderContext->cmdListPoolCapacity = 16;
@@ -29,7 +29,12 @@
 #include "Texture.h"
 #include "RenderTarget.h"
 
+#include <Maths/Helpers.h>
+
 #include <d3d11.h>
+#include <string.h>
+
+size_t BitsPerPixel( DXGI_FORMAT fmt );
 
 ID3D11RenderTargetView* CreateRenderTargetView( ID3D11Device* device, ID3D11Resource* texResource, const D3D11_RTV_DIMENSION dimension, const DXGI_FORMAT format )
 {
@@ -298,6 +303,108 @@ void RenderDevice::destroyRenderTarget( RenderTarget* renderTarget )
     nya::core::free( memoryAllocator, renderTarget );
 }
 
+static bool GetSubresourceFootprint( RenderTarget* renderTarget, const uint32_t mipLevel, const uint32_t arrayIndex, D3D11_TEXTURE2D_DESC& textureDesc, UINT& subresourceIndex, UINT& rowSize )
+{
+    D3D11_RESOURCE_DIMENSION resourceDimension;
+    renderTarget->texture->textureResource->GetType( &resourceDimension );
+
+    if ( resourceDimension != D3D11_RESOURCE_DIMENSION_TEXTURE2D ) {
+        NYA_CERR << "Render target subresource access is only implemented for 2D render targets!" << std::endl;
+        return false;
+    }
+
+    renderTarget->texture->texture2D->GetDesc( &textureDesc );
+
+    if ( mipLevel >= textureDesc.MipLevels || arrayIndex >= textureDesc.ArraySize ) {
+        NYA_CERR << "Render target subresource out of bounds (mip " << mipLevel << ", slice " << arrayIndex << ")" << std::endl;
+        return false;
+    }
+
+    textureDesc.Width = nya::maths::max( 1u, textureDesc.Width >> mipLevel );
+    textureDesc.Height = nya::maths::max( 1u, textureDesc.Height >> mipLevel );
+
+    subresourceIndex = D3D11CalcSubresource( mipLevel, arrayIndex, textureDesc.MipLevels );
+    rowSize = static_cast<UINT>( ( textureDesc.Width * BitsPerPixel( textureDesc.Format ) + 7 ) / 8 );
+
+    return true;
+}
+
+bool RenderDevice::readRenderTarget( RenderTarget* renderTarget, const uint32_t mipLevel, const uint32_t arrayIndex, void* data, const size_t dataSize )
+{
+    D3D11_TEXTURE2D_DESC textureDesc;
+    UINT subresourceIndex, rowSize;
+    if ( !GetSubresourceFootprint( renderTarget, mipLevel, arrayIndex, textureDesc, subresourceIndex, rowSize ) ) {
+        return false;
+    }
+
+    if ( dataSize < static_cast<size_t>( rowSize ) * textureDesc.Height ) {
+        NYA_CERR << "Render target readback buffer is too small (" << dataSize << " bytes; " << ( rowSize * textureDesc.Height ) << " bytes expected)" << std::endl;
+        return false;
+    }
+
+    // Copy the subresource to a CPU readable texture
+    D3D11_TEXTURE2D_DESC stagingDesc = {};
+    stagingDesc.Width = textureDesc.Width;
+    stagingDesc.Height = textureDesc.Height;
+    stagingDesc.MipLevels = 1;
+    stagingDesc.ArraySize = 1;
+    stagingDesc.Format = textureDesc.Format;
+    stagingDesc.SampleDesc.Count = 1;
+    stagingDesc.SampleDesc.Quality = 0;
+    stagingDesc.Usage = D3D11_USAGE_STAGING;
+    stagingDesc.BindFlags = 0;
+    stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    stagingDesc.MiscFlags = 0;
+
+    ID3D11Texture2D* stagingTexture = nullptr;
+    HRESULT operationResult = renderContext->nativeDevice->CreateTexture2D( &stagingDesc, nullptr, &stagingTexture );
+    if ( FAILED( operationResult ) ) {
+        NYA_CERR << "Failed to create readback texture! (error code: " << NYA_PRINT_HEX( operationResult ) << ")" << std::endl;
+        return false;
+    }
+
+    ID3D11DeviceContext* nativeDeviceContext = renderContext->nativeDeviceContext;
+    nativeDeviceContext->CopySubresourceRegion( stagingTexture, 0, 0, 0, 0, renderTarget->texture->texture2D, subresourceIndex, nullptr );
+
+    // Map blocks until the copy is done
+    D3D11_MAPPED_SUBRESOURCE mappedSubresource;
+    operationResult = nativeDeviceContext->Map( stagingTexture, 0, D3D11_MAP_READ, 0, &mappedSubresource );
+    if ( FAILED( operationResult ) ) {
+        NYA_CERR << "Failed to map readback texture! (error code: " << NYA_PRINT_HEX( operationResult ) << ")" << std::endl;
+        stagingTexture->Release();
+        return false;
+    }
+
+    const uint8_t* mappedTexels = static_cast<const uint8_t*>( mappedSubresource.pData );
+    uint8_t* outputTexels = static_cast<uint8_t*>( data );
+    for ( UINT row = 0; row < textureDesc.Height; row++ ) {
+        memcpy( outputTexels + row * rowSize, mappedTexels + row * mappedSubresource.RowPitch, rowSize );
+    }
+
+    nativeDeviceContext->Unmap( stagingTexture, 0 );
+    stagingTexture->Release();
+
+    return true;
+}
+
+bool RenderDevice::updateRenderTarget( RenderTarget* renderTarget, const uint32_t mipLevel, const uint32_t arrayIndex, const void* data, const size_t dataSize )
+{
+    D3D11_TEXTURE2D_DESC textureDesc;
+    UINT subresourceIndex, rowSize;
+    if ( !GetSubresourceFootprint( renderTarget, mipLevel, arrayIndex, textureDesc, subresourceIndex, rowSize ) ) {
+        return false;
+    }
+
+    if ( dataSize < static_cast<size_t>( rowSize ) * textureDesc.Height ) {
+        NYA_CERR << "Not enough texels to update the render target subresource (" << dataSize << " bytes; " << ( rowSize * textureDesc.Height ) << " bytes expected)" << std::endl;
+        return false;
+    }
+
+    renderContext->nativeDeviceContext->UpdateSubresource( renderTarget->texture->texture2D, subresourceIndex, nullptr, data, rowSize, rowSize * textureDesc.Height );
+
+    return true;
+}
+
 void CommandList::clearColorRenderTargets( RenderTarget** renderTargets, const uint32_t renderTargetCount, const float clearValue[4] )
 {
     for (uint32_t i = 0; i < renderTargetCount; i++)
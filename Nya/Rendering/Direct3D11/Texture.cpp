@@ -34,6 +34,7 @@
 
 #include <d3d11.h>
 #include <vector>
+#include <utility>
 
 bool IsUsingCompressedFormat( const eImageFormat format )
 {
@@ -596,6 +597,11 @@ void RenderDevice::destroyTexture( Texture* texture )
     nya::core::free( memoryAllocator, texture );
 }
 
+void RenderDevice::swapTexture( Texture* texture, Texture* otherTexture )
+{
+    std::swap( *texture, *otherTexture );
+}
+
 void RenderDevice::setDebugMarker( Texture* texture, const char* objectName )
 {
     texture->textureResource->SetPrivateData( WKPDID_D3DDebugObjectName, static_cast< UINT >( strlen( objectName ) ), objectName );
@@ -33,6 +33,11 @@ void RenderDevice::destroyBuffer( Buffer* buffer )
 
 }
 
+bool RenderDevice::readBuffer( Buffer* buffer, void* data, const size_t dataSize )
+{
+    return false;
+}
+
 void RenderDevice::setDebugMarker( Buffer* buffer, const char* objectName )
 {
 
@@ -53,6 +58,11 @@ void CommandList::updateBuffer( Buffer* buffer, const void* data, const size_t d
 
 }
 
+void CommandList::updateBufferRange( Buffer* buffer, const void* data, const size_t dataSize, const size_t offsetInBytes )
+{
+
+}
+
 void CommandList::copyStructureCount( Buffer* srcBuffer, Buffer* dstBuffer, const unsigned int offset )
 {
 
@@ -29,12 +29,16 @@ CommandList::~CommandList()
 
 void CommandList::begin()
 {
-
+#if NYA_DEVBUILD
+    nya::rendering::NotifyCommandListBegin( this );
+#endif
 }
 
 void CommandList::end()
 {
-
+#if NYA_DEVBUILD
+    nya::rendering::NotifyCommandListEnd( this );
+#endif
 }
 
 void CommandList::draw( const unsigned int vertexCount, const unsigned int vertexOffset )
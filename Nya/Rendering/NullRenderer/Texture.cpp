@@ -43,6 +43,11 @@ void RenderDevice::destroyTexture( Texture* texture )
 
 }
 
+void RenderDevice::swapTexture( Texture* texture, Texture* otherTexture )
+{
+
+}
+
 void RenderDevice::setDebugMarker( Texture* texture, const char* objectName )
 {
 
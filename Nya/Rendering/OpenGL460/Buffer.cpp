@@ -120,6 +120,15 @@ void RenderDevice::destroyBuffer( Buffer* buffer )
     nya::core::free( memoryAllocator, buffer );
 }
 
+bool RenderDevice::readBuffer( Buffer* buffer, void* data, const size_t dataSize )
+{
+    // NOTE Texture buffers are backed by a plain buffer object (see createBuffer)
+    glMemoryBarrier( GL_BUFFER_UPDATE_BARRIER_BIT );
+    glGetNamedBufferSubData( buffer->bufferHandle, 0, static_cast<GLsizeiptr>( dataSize ), data );
+
+    return true;
+}
+
 void RenderDevice::setDebugMarker( Buffer* buffer, const char* objectName )
 {
     glObjectLabel( GL_BUFFER, buffer->bufferHandle, strlen( objectName ), objectName );
@@ -152,6 +161,13 @@ void CommandList::updateBuffer( Buffer* buffer, const void* data, const size_t d
     glBindBuffer( buffer->target, 0 );
 }
 
+void CommandList::updateBufferRange( Buffer* buffer, const void* data, const size_t dataSize, const size_t offsetInBytes )
+{
+    glBindBuffer( buffer->target, buffer->bufferHandle );
+    glBufferSubData( buffer->target, static_cast<GLintptr>( offsetInBytes ), static_cast<GLsizeiptr>( dataSize ), data );
+    glBindBuffer( buffer->target, 0 );
+}
+
 void CommandList::copyStructureCount( Buffer* srcBuffer, Buffer* dstBuffer, const unsigned int offset )
 {
 
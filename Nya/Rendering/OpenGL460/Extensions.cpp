@@ -157,6 +157,7 @@ PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC pglCheckNamedFramebufferStatus = nullptr;
 PFNGLNAMEDBUFFERDATAPROC pglNamedBufferData = nullptr;
 PFNGLCREATEVERTEXARRAYSPROC pglCreateVertexArrays = nullptr;
 PFNGLNAMEDBUFFERSUBDATAPROC pglNamedBufferSubData = nullptr;
+PFNGLGETNAMEDBUFFERSUBDATAPROC pglGetNamedBufferSubData = nullptr;
 
 PFNGLPRIMITIVERESTARTINDEXPROC pglPrimitiveRestartIndex = nullptr;
 PFNGLNAMEDFRAMEBUFFERTEXTURELAYERPROC pglNamedFramebufferTextureLayer = nullptr;
@@ -213,6 +214,7 @@ bool nya::rendering::LoadOpenGLExtensions()
     LOAD_EXT( glNamedFramebufferTextureLayer, PFNGLNAMEDFRAMEBUFFERTEXTURELAYERPROC );
     LOAD_EXT( glPrimitiveRestartIndex, PFNGLPRIMITIVERESTARTINDEXPROC );
     LOAD_EXT( glNamedBufferSubData, PFNGLNAMEDBUFFERSUBDATAPROC );
+    LOAD_EXT( glGetNamedBufferSubData, PFNGLGETNAMEDBUFFERSUBDATAPROC );
     LOAD_EXT( glCreateVertexArrays, PFNGLCREATEVERTEXARRAYSPROC );
     LOAD_EXT( glNamedBufferData, PFNGLNAMEDBUFFERDATAPROC );
     LOAD_EXT( glCheckNamedFramebufferStatus, PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC );
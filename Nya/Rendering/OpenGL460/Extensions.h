@@ -177,6 +177,7 @@ extern PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC pglCheckNamedFramebufferStatus;
 extern PFNGLNAMEDBUFFERDATAPROC pglNamedBufferData;
 extern PFNGLCREATEVERTEXARRAYSPROC pglCreateVertexArrays;
 extern PFNGLNAMEDBUFFERSUBDATAPROC pglNamedBufferSubData;
+extern PFNGLGETNAMEDBUFFERSUBDATAPROC pglGetNamedBufferSubData;
 extern PFNGLPRIMITIVERESTARTINDEXPROC pglPrimitiveRestartIndex;
 extern PFNGLNAMEDFRAMEBUFFERTEXTURELAYERPROC pglNamedFramebufferTextureLayer;
 extern PFNGLGETTEXTURESUBIMAGEPROC pglGetTextureSubImage;
@@ -200,6 +201,7 @@ extern PFNGLGETQUERYOBJECTUI64VPROC pglGetQueryObjectui64v;
 #define glPrimitiveRestartIndex pglPrimitiveRestartIndex
 
 #define glNamedBufferSubData pglNamedBufferSubData
+#define glGetNamedBufferSubData pglGetNamedBufferSubData
 #define glCreateVertexArrays pglCreateVertexArrays
 #define glNamedBufferData pglNamedBufferData
 
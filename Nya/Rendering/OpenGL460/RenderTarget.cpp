@@ -43,6 +43,18 @@ void RenderDevice::destroyRenderTarget( RenderTarget* renderTarget )
 
 }
 
+// NOTE Subresource copies are not supported by this backend yet; callers have to handle the failure (e.g. the IBL probe
+// cache disables itself and probes are captured at runtime)
+bool RenderDevice::readRenderTarget( RenderTarget* renderTarget, const uint32_t mipLevel, const uint32_t arrayIndex, void* data, const size_t dataSize )
+{
+    return false;
+}
+
+bool RenderDevice::updateRenderTarget( RenderTarget* renderTarget, const uint32_t mipLevel, const uint32_t arrayIndex, const void* data, const size_t dataSize )
+{
+    return false;
+}
+
 void CommandList::clearColorRenderTargets( RenderTarget** renderTargets, const uint32_t renderTargetCount, const float clearValue[4] )
 {
 
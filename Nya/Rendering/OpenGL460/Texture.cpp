@@ -27,6 +27,7 @@
 #include "ImageHelpers.h"
 
 #include <string.h>
+#include <utility>
 
 struct Texture
 {
@@ -241,6 +242,11 @@ void RenderDevice::destroyTexture( Texture* texture )
     nya::core::free( memoryAllocator, texture );
 }
 
+void RenderDevice::swapTexture( Texture* texture, Texture* otherTexture )
+{
+    std::swap( *texture, *otherTexture );
+}
+
 void RenderDevice::setDebugMarker( Texture* texture, const char* objectName )
 {
     glObjectLabel( GL_TEXTURE, texture->textureHandle, strlen( objectName ), objectName );
@@ -497,11 +497,25 @@ public:
     void                destroyTexture( Texture* texture );
     void                destroyRenderTarget( RenderTarget* renderTarget );
     void                destroyBuffer( Buffer* buffer );
+
+    // Copy the content of a buffer (3D/2D UAV textures texels are tightly packed; slices are stored one after another)
+    // NOTE Reads are synchronous (stall until the GPU is done with the buffer); meant for debug/validation code
+    bool                readBuffer( Buffer* buffer, void* data, const size_t dataSize );
     void                destroyShader( Shader* shader );
     void                destroyPipelineState( PipelineState* pipelineState );
     void                destroySampler( Sampler* sampler );
     void                destroyQueryPool( QueryPool* queryPool );
 
+    // Exchange the resources of two textures (both objects keep their address; e.g. to replace a placeholder texture in place)
+    void                swapTexture( Texture* texture, Texture* otherTexture );
+
+    // Copy a single render target subresource (texels are tightly packed; uncompressed formats only)
+    // arrayIndex uses the RenderPass attachement layout (e.g. cubemap arrays: cubemapIndex * 6 + faceIndex)
+    // NOTE Reads are synchronous (stall until the GPU is done with the render target); meant for offline/loading code
+    // Both return false if the copy failed or is not supported by the backend (OpenGL and Vulkan for now)
+    bool                readRenderTarget( RenderTarget* renderTarget, const uint32_t mipLevel, const uint32_t arrayIndex, void* data, const size_t dataSize );
+    bool                updateRenderTarget( RenderTarget* renderTarget, const uint32_t mipLevel, const uint32_t arrayIndex, const void* data, const size_t dataSize );
+
     void                setDebugMarker( Texture* texture, const char* objectName );
     void                setDebugMarker( Buffer* buffer, const char* objectName );
 
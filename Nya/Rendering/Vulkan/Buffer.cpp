@@ -25,6 +25,7 @@
 #include "Buffer.h"
 
 #include <Rendering/ImageFormat.h>
+#include <Maths/Helpers.h>
 
 #include "RenderDevice.h"
 #include "CommandList.h"
@@ -242,6 +243,24 @@ void RenderDevice::destroyBuffer( Buffer* buffer )
     nya::core::free( memoryAllocator, buffer );
 }
 
+bool RenderDevice::readBuffer( Buffer* buffer, void* data, const size_t dataSize )
+{
+    // NOTE Buffers memory is host visible and coherent (see createBuffer); texture buffers are stored linearly
+    vkQueueWaitIdle( renderContext->graphicsQueue );
+
+    void* mappedMemory = nullptr;
+    VkResult mapResult = vkMapMemory( renderContext->device, buffer->deviceMemory, 0ull, static_cast<VkDeviceSize>( dataSize ), 0u, &mappedMemory );
+    if ( mapResult != VK_SUCCESS ) {
+        NYA_CERR << "Failed to map buffer memory for readback (error code: " << mapResult << ")" << std::endl;
+        return false;
+    }
+
+    memcpy( data, mappedMemory, dataSize );
+    vkUnmapMemory( renderContext->device, buffer->deviceMemory );
+
+    return true;
+}
+
 void RenderDevice::setDebugMarker( Buffer* buffer, const char* objectName )
 {
     VkDebugMarkerObjectNameInfoEXT dbgMarkerObjName = {};
@@ -268,7 +287,23 @@ void CommandList::bindIndiceBuffer( const Buffer* buffer )
 
 void CommandList::updateBuffer( Buffer* buffer, const void* data, const size_t dataSize )
 {
-    vkCmdUpdateBuffer(CommandListObject->cmdBuffer, buffer->bufferObject, 0ull, dataSize, data);
+    updateBufferRange( buffer, data, dataSize, 0ull );
+}
+
+void CommandList::updateBufferRange( Buffer* buffer, const void* data, const size_t dataSize, const size_t offsetInBytes )
+{
+    // vkCmdUpdateBuffer is limited to 65536 bytes per call; split the update into several commands
+    static constexpr size_t MAX_UPDATE_SIZE = 65536ull;
+
+    NYA_DEV_ASSERT( ( offsetInBytes & 3 ) == 0 && ( dataSize & 3 ) == 0, "Buffer update offset and size must be a multiple of 4 (offset: %zu size: %zu)", offsetInBytes, dataSize );
+
+    const uint8_t* sourceData = static_cast<const uint8_t*>( data );
+
+    for ( size_t updateOffset = 0ull; updateOffset < dataSize; updateOffset += MAX_UPDATE_SIZE ) {
+        const size_t updateSize = nya::maths::min( dataSize - updateOffset, MAX_UPDATE_SIZE );
+
+        vkCmdUpdateBuffer( CommandListObject->cmdBuffer, buffer->bufferObject, static_cast<VkDeviceSize>( offsetInBytes + updateOffset ), static_cast<VkDeviceSize>( updateSize ), sourceData + updateOffset );
+    }
 }
 
 void CommandList::copyStructureCount( Buffer* srcBuffer, Buffer* dstBuffer, const unsigned int offset )
@@ -49,10 +49,18 @@ void CommandList::begin()
     cmdBufferInfos.pInheritanceInfo = nullptr;
 
     vkBeginCommandBuffer( CommandListObject->cmdBuffer, &cmdBufferInfos );
+
+#if NYA_DEVBUILD
+    nya::rendering::NotifyCommandListBegin( this );
+#endif
 }
 
 void CommandList::end()
 {
+#if NYA_DEVBUILD
+    nya::rendering::NotifyCommandListEnd( this );
+#endif
+
     vkEndCommandBuffer( CommandListObject->cmdBuffer );
 }
 
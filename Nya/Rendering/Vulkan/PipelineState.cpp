@@ -391,7 +391,7 @@ PipelineState* RenderDevice::createPipelineState( const PipelineStateDesc& descr
         VkVertexInputBindingDescription vertexInputBindingDesc;
         vertexInputBindingDesc.binding = 0;
         vertexInputBindingDesc.stride = vertexStride;
-        vertexInputBindingDesc.inputRate = ( description.inputLayout[0].instanceCount ) > 1u ? VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX;
+        vertexInputBindingDesc.inputRate = ( description.inputLayout[0].instanceCount != 0u ) ? VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX;
 
         bool needVertexBinding = ( description.inputLayout[0].semanticName != nullptr );
         VkPipelineVertexInputStateCreateInfo vertexInputStateDesc;
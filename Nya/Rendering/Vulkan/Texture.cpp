@@ -33,6 +33,7 @@
 
 #include <vulkan/vulkan.h>
 #include <string.h>
+#include <utility>
 
 VkImageCreateFlags GetTextureCreateFlags( const TextureDescription& description )
 {
@@ -281,6 +282,11 @@ void RenderDevice::destroyTexture( Texture* texture )
     nya::core::free( memoryAllocator, texture );
 }
 
+void RenderDevice::swapTexture( Texture* texture, Texture* otherTexture )
+{
+    std::swap( *texture, *otherTexture );
+}
+
 void RenderDevice::setDebugMarker( Texture* texture, const char* objectName )
 {
     VkDebugMarkerObjectNameInfoEXT dbgMarkerObjName = {};
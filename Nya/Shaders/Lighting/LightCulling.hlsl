@@ -15,21 +15,19 @@ static const uint CLUSTER_COUNT = ( CLUSTER_Z * CLUSTER_Y * CLUSTER_X );
 RWTexture3D<uint2> g_LightClusters : register( u0 );
 RWBuffer<uint> g_ItemList : register( u1 );
 
-groupshared uint g_ClusterItems[( MAX_POINT_LIGHT_COUNT + MAX_LOCAL_IBL_PROBE_COUNT )];
+groupshared uint g_ClusterItems[MAX_CLUSTER_ITEM_COUNT];
 
 [numthreads( NUM_THREADS_X, NUM_THREADS_Y, NUM_THREADS_Z )]
 void EntryPointCS( uint3 globalIdx : SV_DispatchThreadID, uint3 localIdx : SV_GroupThreadID, uint3 groupIdx : SV_GroupID, uint groupIndex : SV_GroupIndex )
 {	
 	int3 groupClusterOffset = int3( groupIdx * int3( NUM_THREADS_X, NUM_THREADS_Y, NUM_THREADS_Z ) );
 	int3 clusterIdx = int3( localIdx ) + groupClusterOffset;
-    // uint localIdxFlattened = localIdx.x + localIdx.y * NUM_THREADS_X + localIdx.z * NUM_THREADS_X * NUM_THREADS_Y;
-	// uint localItemListOffset = localIdxFlattened * ( MAX_POINT_LIGHT_COUNT + MAX_LOCAL_IBL_PROBE_COUNT );
 	
     uint threadListOffset = 0u;
     
 	// PointLight Culling
-    for ( uint i = 0; i < MAX_POINT_LIGHT_COUNT; i++ ) {
-		PointLight light = g_PointLights[i];
+    for ( uint i = 0; i < g_PointLightCount; i++ ) {
+		PointLight light = LoadPointLight( i );
 		
         const float3 p = ( light.PositionAndRadius.xyz - g_SceneAABBMin );
         const float3 pMin = ( p - light.PositionAndRadius.w ) * g_ClustersScale;
@@ -78,7 +76,7 @@ void EntryPointCS( uint3 globalIdx : SV_DispatchThreadID, uint3 localIdx : SV_Gr
 		dx *= dx;
 		dx += dy;
 	            			
-		if ( dx < squaredRadius ) {
+		if ( dx < squaredRadius && threadListOffset < MAX_CLUSTER_ITEM_COUNT ) {
 			g_ClusterItems[threadListOffset] = i;
             threadListOffset++;
 		}
@@ -87,8 +85,8 @@ void EntryPointCS( uint3 globalIdx : SV_DispatchThreadID, uint3 localIdx : SV_Gr
     const uint pointLightCount = threadListOffset;
 	
 	// IBLProbe Culling
-    for ( uint j = 0; j < MAX_LOCAL_IBL_PROBE_COUNT; j++ ) {
-		IBLProbe probe = g_IBLProbes[j + 1u];
+    for ( uint j = 0; j < g_LocalIBLProbeCount; j++ ) {
+		IBLProbe probe = LoadIBLProbe( j + 1u );
 		
         const float3 p = ( probe.PositionAndRadius.xyz - g_SceneAABBMin );
         const float3 pMin = ( p - probe.PositionAndRadius.w ) * g_ClustersScale;
@@ -137,7 +135,7 @@ void EntryPointCS( uint3 globalIdx : SV_DispatchThreadID, uint3 localIdx : SV_Gr
 		dx *= dx;
 		dx += dy;
 	            			
-		if ( dx < squaredRadius ) {
+		if ( dx < squaredRadius && threadListOffset < MAX_CLUSTER_ITEM_COUNT ) {
 			g_ClusterItems[threadListOffset] = j;
             threadListOffset++;
 		}
@@ -146,10 +144,10 @@ void EntryPointCS( uint3 globalIdx : SV_DispatchThreadID, uint3 localIdx : SV_Gr
     uint iblProbeCount = ( threadListOffset - pointLightCount );	
     uint spotLightCount = 0u;
 	
-	uint itemListOffset = ( globalIdx.x + globalIdx.y * CLUSTER_X + globalIdx.z * CLUSTER_X * CLUSTER_Y ) * ( MAX_POINT_LIGHT_COUNT + MAX_LOCAL_IBL_PROBE_COUNT );	
+	uint itemListOffset = ( globalIdx.x + globalIdx.y * CLUSTER_X + globalIdx.z * CLUSTER_X * CLUSTER_Y ) * MAX_CLUSTER_ITEM_COUNT;	
     g_LightClusters[globalIdx] = uint2( itemListOffset, ( pointLightCount << 20 ) & 0xFFF00000 | ( spotLightCount << 8 ) & 0x000FFF00 | ( iblProbeCount & 0x000000FF ) );
 	
     // Write from LDS memory to UAV
-	for ( int x = 0; x < ( MAX_POINT_LIGHT_COUNT + MAX_LOCAL_IBL_PROBE_COUNT ); x++ )
+	for ( uint x = 0; x < threadListOffset; x++ )
 		g_ItemList[itemListOffset+x] = g_ClusterItems[x];
 }
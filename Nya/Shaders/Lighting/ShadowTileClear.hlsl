@@ -0,0 +1,20 @@
+struct VertexStageData
+{
+    float4 Position : SV_POSITION;
+};
+
+// Fullscreen triangle on the far plane (the viewport covers the atlas tile to clear)
+VertexStageData EntryPointVS( uint VertexID : SV_VERTEXID )
+{
+    float2 texCoordinates = float2( ( VertexID << 1 ) & 2, VertexID & 2 );
+
+    VertexStageData output;
+    output.Position = float4( texCoordinates * float2( 2.0f, -2.0f ) + float2( -1.0f, 1.0f ), 1.0f, 1.0f );
+
+    return output;
+}
+
+void EntryPointPS( VertexStageData VertexStage )
+{
+
+}
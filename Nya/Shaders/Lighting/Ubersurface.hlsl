@@ -126,6 +126,15 @@ Texture2D               g_SunShadowMap : register( t13 );
 TextureCubeArray        g_EnvProbeDiffuseArray : register( t14 );
 TextureCubeArray        g_EnvProbeSpecularArray : register( t15 );
 Buffer<uint> g_ItemList : register( t16 );
+Texture2D               g_LocalShadowAtlas : register( t19 );
+
+cbuffer LocalShadowBuffer : register( b5 )
+{
+    uint4   g_LocalShadowLightIndexes[LOCAL_SHADOW_MAX_LIGHT_COUNT / 4];
+    uint    g_LocalShadowCount;
+    uint3   EXPLICIT_PADDING_LOCAL_SHADOW;
+    float4  g_LocalShadowFaceData[LOCAL_SHADOW_MAX_LIGHT_COUNT * LOCAL_SHADOW_MAX_FACE_COUNT * LOCAL_SHADOW_FACE_VECTOR_COUNT];
+};
 
 #if NYA_EDITOR
 #include <MaterialShared.h>
@@ -410,6 +419,44 @@ float3 SampleShadowCascade( in DirectionalLight light, in float3 shadowPosition,
     return cascadeColor * SampleCascadedShadowMapOptimizedPCF( shadowPosition, shadowPosDX, shadowPosDY, cascadeIdx );
 }
 
+// Returns 1 if the light has no shadow map in the local shadow atlas
+float GetPointLightShadowVisibility( in uint lightIndex, in PointLight light, in float3 positionWS )
+{
+    for ( uint shadowIdx = 0; shadowIdx < g_LocalShadowCount; shadowIdx++ ) {
+        if ( g_LocalShadowLightIndexes[shadowIdx / 4][shadowIdx % 4] != lightIndex ) {
+            continue;
+        }
+
+        // Select the cube face using the light to surface vector major axis (X+, X-, Y+, Y-, Z+, Z-)
+        float3 lightToSurface = positionWS - light.PositionAndRadius.xyz;
+        float3 absLightToSurface = abs( lightToSurface );
+
+        uint axisIdx = ( absLightToSurface.x >= absLightToSurface.y && absLightToSurface.x >= absLightToSurface.z ) ? 0 : ( ( absLightToSurface.y >= absLightToSurface.z ) ? 1 : 2 );
+        uint faceIdx = axisIdx * 2 + ( ( lightToSurface[axisIdx] < 0.0f ) ? 1 : 0 );
+
+        uint vectorOffset = ( shadowIdx * LOCAL_SHADOW_MAX_FACE_COUNT + faceIdx ) * LOCAL_SHADOW_FACE_VECTOR_COUNT;
+
+        float4x4 shadowMatrix = float4x4( 
+            g_LocalShadowFaceData[vectorOffset + 0],
+            g_LocalShadowFaceData[vectorOffset + 1],
+            g_LocalShadowFaceData[vectorOffset + 2],
+            g_LocalShadowFaceData[vectorOffset + 3]
+        );
+        float4 atlasScaleBias = g_LocalShadowFaceData[vectorOffset + 4];
+
+        float4 shadowPosition = mul( shadowMatrix, float4( positionWS, 1.0f ) );
+        shadowPosition.xyz /= shadowPosition.w;
+
+        // Clamp to the tile bounds to avoid filtering texels from neighbor tiles
+        float halfTexelSize = 0.5f / ( atlasScaleBias.x * LOCAL_SHADOW_ATLAS_DIMENSIONS );
+        float2 tileUV = clamp( shadowPosition.xy * float2( 0.5f, -0.5f ) + 0.5f, halfTexelSize, 1.0f - halfTexelSize );
+
+        return g_LocalShadowAtlas.SampleCmpLevelZero( g_ShadowMapSampler, tileUV * atlasScaleBias.xy + atlasScaleBias.zw, shadowPosition.z - LOCAL_SHADOW_DEPTH_BIAS );
+    }
+
+    return 1.0f;
+}
+
 float3 GetPointLightIlluminance( in PointLight light, in LightSurfaceInfos surface, in float depth, inout float3 L )
 {
     float3 unormalizedL = light.PositionAndRadius.xyz - surface.PositionWorldSpace;
@@ -635,8 +682,10 @@ PixelStageData EntryPointPS( VertexStageData VertexStage, bool isFrontFace : SV_
 	for ( uint i = 0; i < entityCount.r; i++ ) {
         // Do lighting
         float3 L;
-		PointLight light = g_PointLights[g_ItemList[light_mask.r + i]];
+        uint lightIndex = g_ItemList[light_mask.r + i];
+		PointLight light = LoadPointLight( lightIndex );
         float3 pointLightIlluminance = GetPointLightIlluminance( light, surface, VertexStage.depth, L );        
+        pointLightIlluminance *= GetPointLightShadowVisibility( lightIndex, light, surface.PositionWorldSpace );
 		LightContribution.rgb += DoShading( L, surface ) * pointLightIlluminance;	
     }
 	
@@ -662,7 +711,9 @@ PixelStageData EntryPointPS( VertexStageData VertexStage, bool isFrontFace : SV_
 
     float mipLevel = linearRoughnessToMipLevel( surface.LinearRoughness, LD_MIP_COUNT );
 
-    float3 diffuseSum = g_EnvProbeDiffuseArray.Sample( g_BilinearSampler, float4( dominantN, 0 ) ).rgb;
+    float3 diffuseSum = ( HasIrradianceSH( 0 ) )
+        ? EvaluateIrradianceSH( 0, dominantN )
+        : g_EnvProbeDiffuseArray.Sample( g_BilinearSampler, float4( dominantN, 0 ) ).rgb;
     float3 specularSum = g_EnvProbeSpecularArray.SampleLevel( g_BilinearSampler, float4( dominantR, 0 ), mipLevel ).rgb;
     
     float4 localEnvProbeSumDiff = float4( 0, 0, 0, 0 );
@@ -671,7 +722,8 @@ PixelStageData EntryPointPS( VertexStageData VertexStage, bool isFrontFace : SV_
     // Iterate IBL probes
 	for ( uint i = 0; i < entityCount.b; i++ ) {
         // NOTE Offset probe index since the first probe should always be the global ibl probe
-        IBLProbe probe = g_IBLProbes[g_ItemList[light_mask.r + i] + 1];
+        const uint probeBufferIndex = g_ItemList[light_mask.r + i] + 1;
+        IBLProbe probe = LoadIBLProbe( probeBufferIndex );
         
         float3 clipSpacePos = mul( float4( VertexStage.positionWS.xyz, 1.0f ), probe.InverseModelMatrix );
         float3 uvw = clipSpacePos.xyz*float3( 0.5f, -0.5f, 0.5f ) + 0.5f;
@@ -697,7 +749,9 @@ PixelStageData EntryPointPS( VertexStageData VertexStage, bool isFrontFace : SV_
             float mip = 1.0 - 1.2 * log2( distRough );
             mip = LD_MIP_COUNT - 1.0 - mip;
 
-            float4 envMapDiff = g_EnvProbeDiffuseArray.Sample( g_BilinearSampler, float4( dominantN, probe.Index ) );
+            float4 envMapDiff = ( HasIrradianceSH( probeBufferIndex ) )
+                ? float4( EvaluateIrradianceSH( probeBufferIndex, dominantN ), 1.0f )
+                : g_EnvProbeDiffuseArray.Sample( g_BilinearSampler, float4( dominantN, probe.Index ) );
             float4 envMapSpec = g_EnvProbeSpecularArray.SampleLevel( g_BilinearSampler, float4( R_parallaxCorrected, probe.Index ), mip );
 
             float edgeBlend = 1 - pow( saturate( max( abs( clipSpacePos.x ), max( abs( clipSpacePos.y ), abs( clipSpacePos.z ) ) ) ), 8 );
@@ -62,8 +62,72 @@ struct IBLProbe
 
 cbuffer LightsBuffer : register( b2 )
 {
-    PointLight          g_PointLights[MAX_POINT_LIGHT_COUNT];
-    IBLProbe            g_IBLProbes[MAX_IBL_PROBE_COUNT];
     DirectionalLight    g_DirectionalLight;
+    uint                g_PointLightCount;
+    uint                g_LocalIBLProbeCount;
+    uint2               EXPLICIT_PADDING;
 };
+
+// NOTE Lights/Probes are fetched as raw 128 bits vectors (the buffers are sized by the engine at runtime)
+Buffer<uint4> g_PointLightBuffer : register( t17 );
+Buffer<uint4> g_IBLProbeBuffer : register( t18 );
+
+PointLight LoadPointLight( uint lightIndex )
+{
+    const uint vectorOffset = lightIndex * POINT_LIGHT_VECTOR_COUNT;
+
+    PointLight light;
+    light.PositionAndRadius = asfloat( g_PointLightBuffer[vectorOffset] );
+    light.ColorAndPowerInLux = asfloat( g_PointLightBuffer[vectorOffset + 1] );
+
+    return light;
+}
+
+IBLProbe LoadIBLProbe( uint probeIndex )
+{
+    const uint vectorOffset = probeIndex * IBL_PROBE_VECTOR_COUNT;
+
+    IBLProbe probe;
+    probe.PositionAndRadius = asfloat( g_IBLProbeBuffer[vectorOffset] );
+
+    // NOTE Matrix is stored column major (same layout as a cbuffer matrix)
+    probe.InverseModelMatrix = transpose( float4x4( 
+        asfloat( g_IBLProbeBuffer[vectorOffset + 1] ), 
+        asfloat( g_IBLProbeBuffer[vectorOffset + 2] ), 
+        asfloat( g_IBLProbeBuffer[vectorOffset + 3] ), 
+        asfloat( g_IBLProbeBuffer[vectorOffset + 4] ) ) );
+
+    const uint4 probeInfos = g_IBLProbeBuffer[vectorOffset + 5];
+    probe.Index = probeInfos.x;
+    probe.Flags = probeInfos.y;
+    probe.CaptureFrequencyPadded = probeInfos.z;
+
+    return probe;
+}
+
+bool HasIrradianceSH( uint probeIndex )
+{
+    const uint4 probeInfos = g_IBLProbeBuffer[probeIndex * IBL_PROBE_VECTOR_COUNT + 5];
+    return ( ( probeInfos.z >> 8 ) & 0xFF ) != 0;
+}
+
+// Evaluate the probe SH9 irradiance (divided by PI; same scale as the convoluted diffuse probes)
+float3 EvaluateIrradianceSH( uint probeIndex, float3 N )
+{
+    const uint vectorOffset = probeIndex * IBL_PROBE_VECTOR_COUNT + IBL_PROBE_SH_VECTOR_OFFSET;
+
+    float3 sh[9];
+    [unroll]
+    for ( uint i = 0; i < 9; i++ ) {
+        sh[i] = asfloat( g_IBLProbeBuffer[vectorOffset + i].xyz );
+    }
+
+    float3 irradiance = 0.282095f * sh[0]
+                      + 0.488603f * ( N.y * sh[1] + N.z * sh[2] + N.x * sh[3] )
+                      + 1.092548f * ( N.x * N.y * sh[4] + N.y * N.z * sh[5] + N.x * N.z * sh[7] )
+                      + 0.315392f * ( 3.0f * N.z * N.z - 1.0f ) * sh[6]
+                      + 0.546274f * ( N.x * N.x - N.y * N.y ) * sh[8];
+
+    return max( irradiance, float3( 0, 0, 0 ) );
+}
 #endif
@@ -1,6 +1,6 @@
 struct VertexBufferData
 {
-    float4 Position : POSITION;
+    float3 Position : POSITION;
     float4 Color    : COLOR0;
 };
 
@@ -10,14 +10,14 @@ struct VertexStageData
     float4 Color    : COLOR0;
 };
 
-cbuffer ScreenInfos : register( b0 )
+cbuffer CameraInfos : register( b0 )
 {
-    float4x4  g_OrthographicMatrix;
+    float4x4  g_ViewProjectionMatrix;
 };
 
 VertexStageData EntryPointVS( VertexBufferData VertexBuffer )
 {
-    float4 Position = mul( float4( VertexBuffer.Position.xyz, 1.0f ), g_OrthographicMatrix );
+    float4 Position = mul( g_ViewProjectionMatrix, float4( VertexBuffer.Position, 1.0f ) );
 
     VertexStageData output = {
         Position,
@@ -25,3 +25,13 @@
 #define CSM_SLICE_COUNT             4
 #define CSM_SLICE_BLEND_THRESHOLD   0.1
 #define CSM_SHADOW_MAP_DIMENSIONS   2048
+
+// Local lights (point/spot) shadow atlas
+#define LOCAL_SHADOW_ATLAS_DIMENSIONS       4096
+#define LOCAL_SHADOW_MIN_TILE_DIMENSIONS    64
+#define LOCAL_SHADOW_MAX_TILE_DIMENSIONS    1024
+#define LOCAL_SHADOW_MAX_LIGHT_COUNT        32
+#define LOCAL_SHADOW_MAX_FACE_COUNT         6
+#define LOCAL_SHADOW_FACE_VECTOR_COUNT      5 // Face view projection matrix (4 rows) + atlas scale/bias
+#define LOCAL_SHADOW_NEAR_PLANE             0.05
+#define LOCAL_SHADOW_DEPTH_BIAS             0.0005
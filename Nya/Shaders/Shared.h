@@ -21,14 +21,24 @@
 #define __SHARED_H__ 1
 
 // Lights Constants
-#define MAX_POINT_LIGHT_COUNT               32
 #define MAX_SPOT_LIGHT_COUNT                256
 #define MAX_DIRECTIONAL_LIGHT_COUNT         1
 
+// NOTE Probe count is bounded by the size of the probe cubemap arrays (light count is not)
 #define MAX_LOCAL_IBL_PROBE_COUNT   31
 #define MAX_GLOBAL_IBL_PROBE_COUNT  1
 
 #define MAX_IBL_PROBE_COUNT                 ( MAX_LOCAL_IBL_PROBE_COUNT + MAX_GLOBAL_IBL_PROBE_COUNT )
 #define IBL_PROBE_DIMENSION                 256
 
+// Max number of entities (lights and probes) referenced by a single light cluster
+#define MAX_CLUSTER_ITEM_COUNT              256
+
+// Number of 128 bits vectors used to store a light/probe in the light buffers
+#define POINT_LIGHT_VECTOR_COUNT            2
+#define IBL_PROBE_VECTOR_COUNT              15
+
+// Offset (in 128 bits vectors) of the probe SH9 irradiance coefficients
+#define IBL_PROBE_SH_VECTOR_OFFSET          6
+
 #endif
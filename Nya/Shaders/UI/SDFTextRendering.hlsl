@@ -1,8 +1,9 @@
-struct VertexBufferData
+struct GlyphInstanceData
 {
-    float4 Position         : POSITION;
-    float2 TexCoordinates   : TEXCOORD0;
+    float4 PositionAndSize  : POSITION; // xy: top left corner; zw: glyph dimensions (screen space)
+    float4 TexCoordinates   : TEXCOORD0; // xy: top left corner; zw: bottom right corner (atlas space)
     float4 Color            : COLOR0;
+    float  OutlineThickness : TEXCOORD1;
 };
 
 struct VertexOutput
@@ -23,14 +24,19 @@ float2 projectPoint( float2 vPoint )
     return ( vPoint * ( 1.0f / ( g_ScreenSize * 0.5f ) ) + float2( -1.0f, 1.0f ) );
 }
 
-VertexOutput EntryPointVS( in VertexBufferData VertexBuffer )
+VertexOutput EntryPointVS( in GlyphInstanceData Instance, uint VertexID : SV_VertexID )
 {
     VertexOutput output;
 
-    output.Position = float4( projectPoint( VertexBuffer.Position.xy ), VertexBuffer.Position.z, 1 );
-    output.Color = VertexBuffer.Color;
-    output.TexCoordinates = VertexBuffer.TexCoordinates;
-    output.OutlineThickness = VertexBuffer.Position.w;
+    // Expand the glyph quad (0: top left; 1: bottom left; 2: bottom right; 3: top right)
+    float2 corner = float2( ( VertexID >= 2 ) ? 1.0f : 0.0f, ( VertexID == 1 || VertexID == 2 ) ? 1.0f : 0.0f );
+
+    float2 position = Instance.PositionAndSize.xy + float2( corner.x, -corner.y ) * Instance.PositionAndSize.zw;
+
+    output.Position = float4( projectPoint( position ), 1.0f, 1 );
+    output.Color = Instance.Color;
+    output.TexCoordinates = lerp( Instance.TexCoordinates.xy, Instance.TexCoordinates.zw, corner );
+    output.OutlineThickness = Instance.OutlineThickness;
 
     return output;
 }
@@ -22,6 +22,9 @@
 #include <Graphics/GraphicsAssetCache.h>
 #include <Graphics/LightGrid.h>
 #include <Graphics/DrawCommandBuilder.h>
+#include <Graphics/IBLProbeCache.h>
+#include <Graphics/DynamicResolutionController.h>
+#include <Graphics/FramePacket.h>
 
 #include <Graphics/RenderModules/TextRenderingModule.h>
 #include <Graphics/RenderModules/LineRenderingModule.h>
@@ -39,6 +42,7 @@
 
 #include <FileSystem/VirtualFileSystem.h>
 #include <FileSystem/FileSystemNative.h>
+#include <FileSystem/FileSystemPack.h>
 
 #include <Input/InputMapper.h>
 #include <Input/InputReader.h>
@@ -64,6 +68,10 @@
 
 #include <FileSystem/FileSystemWatchdog.h>
 
+#include <thread>
+#include <mutex>
+#include <atomic>
+
 #if NYA_DEVBUILD
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
@@ -197,12 +205,20 @@ static VirtualFileSystem*      g_VirtualFileSystem;
 static FileSystemNative*       g_SaveFileSystem;
 static FileSystemNative*       g_DataFileSystem;
 static FileSystemNative*       g_DevFileSystem;
+static FileSystemPack*         g_PackFileSystem;
 static ShaderCache*            g_ShaderCache;
 static WorldRenderer*          g_WorldRenderer;
 static GraphicsAssetCache*     g_GraphicsAssetCache;
 static DrawCommandBuilder*     g_DrawCommandBuilder;
 static LightGrid*              g_LightGrid;
+static IBLProbeCache*          g_IBLProbeCache;
 static FileSystemWatchdog*     g_FileSystemWatchdog;
+static FramePacketQueue*       g_FramePacketQueue;
+
+// Held by the game thread while the scene is updated (render side tasks editing the scene also lock it)
+static std::mutex              g_SceneMutex;
+static std::atomic<double>     g_LastFrameGPUTime( -1.0 );
+static std::atomic<bool>       g_IsIBLProbeBakeComplete( false );
 
 static Scene*                  g_SceneTest;
 static FreeCamera*             g_FreeCamera;
@@ -212,6 +228,7 @@ static bool                    g_IsDevMenuVisible = false;
 static Scene::Node*            g_PickedNode = nullptr;
 static TransactionHandler*     g_TransactionHandler = nullptr;
 static Ray                     g_PickingRay( nyaVec3f( 0, 0, 0 ), nyaVec3f( 0, 0, 0 ) );
+static bool                    g_IsPickingRayPending = false; // Submitted once per pick (the line is kept alive by its lifetime)
 
 // Game Specifics
 #define WIN_MODE_OPTION_LIST( option ) option( WINDOWED ) option( FULLSCREEN ) option( BORDERLESS )
@@ -221,7 +238,10 @@ NYA_ENV_VAR( ScreenSize, nyaVec2u( 1280, 720 ), nyaVec2u ) // "Defines applicati
 NYA_ENV_VAR( WindowMode, WINDOWED, eWindowMode ) // Defines application window mode [Windowed/Fullscreen/Borderless]
 NYA_ENV_VAR( CameraFOV, 80.0f, float ) // "Camera FieldOfView (in degrees)"
 NYA_ENV_VAR( ImageQuality, 1.0f, float ) // "Image Quality Scale (in degrees) [0.1..N]"
+NYA_ENV_VAR( EnableDynamicResolution, false, bool ) // "Adjust Image Quality each frame to stay within the frame budget [false/true]"
 NYA_ENV_VAR( EnableVSync, false, bool ) // "Enable Vertical Synchronisation [false/true]"
+NYA_ENV_VAR( EnableRenderThread, true, bool ) // "Render frames on a dedicated thread (overlaps the simulation of the next frame; read at startup) [false/true]"
+NYA_ENV_VAR( FramePacketCount, 2, uint32_t ) // "Number of frames in flight between the game and render threads (2: double buffering; 3: triple buffering; read at startup) [1..3]"
 NYA_ENV_VAR( EnableTAA, false, bool ) // "Enable TemporalAntiAliasing [false/true]"
 NYA_ENV_VAR( MSAASamplerCount, 1, uint32_t ) // "MultiSampledAntiAliasing Sampler Count [1..8]"
 
@@ -352,6 +372,7 @@ void RegisterInputContexts()
 
                 g_PickingRay.origin = rayOrig;
                 g_PickingRay.direction = rayDirection;
+                g_IsPickingRayPending = true;
 
                 g_PickedNode = g_SceneTest->intersect( g_PickingRay );
             }
@@ -475,13 +496,13 @@ void TestStuff()
     g_FramerateGUILabel = g_DebugGUI->allocateWidget<GUILabel>();
     g_FramerateGUILabel->VirtualPosition = nyaVec2f( 995.0f, 0.0f );
     g_FramerateGUILabel->VirtualSize.x = 0.40f;
-    g_FramerateGUILabel->ColorAndAlpha = nyaVec4f( 0.9f, 0.9f, 0.0f, 1.0f );
+    g_FramerateGUILabel->setColorAndAlpha( nyaVec4f( 0.9f, 0.9f, 0.0f, 1.0f ) );
   /*
     GUILabel* windowLabelTest = g_DebugGUI->allocateWidget<GUILabel>();
     windowLabelTest->VirtualPosition = nyaVec2f( 0.01f, 0.0f );
     windowLabelTest->VirtualSize.x = 0.40f;
-    windowLabelTest->ColorAndAlpha = nyaVec4f( 1.0f, 1.0f, 1.0f, 1.0f );
-    windowLabelTest->Value = "New Window";
+    windowLabelTest->setColorAndAlpha( nyaVec4f( 1.0f, 1.0f, 1.0f, 1.0f ) );
+    windowLabelTest->setValue( "New Window" );
 
     GUIPanel& titleBarTest = g_DebugGUI->allocatePanel();
     titleBarTest.VirtualPosition = nyaVec2f( 640.0f, 480.0f );
@@ -503,8 +524,8 @@ void TestStuff()
     GUILabel* buttonLabel = g_DebugGUI->allocateWidget<GUILabel>();
     buttonLabel->VirtualPosition = nyaVec2f( 0.05f, 0.01f );
     buttonLabel->VirtualSize.x = 0.35f;
-    buttonLabel->ColorAndAlpha = nyaVec4f( 1.0f, 1.0f, 1.0f, 1.0f );
-    buttonLabel->Value = "EnableVSync";
+    buttonLabel->setColorAndAlpha( nyaVec4f( 1.0f, 1.0f, 1.0f, 1.0f ) );
+    buttonLabel->setValue( "EnableVSync" );
     g_CheckboxTestLabel = buttonLabel;
 */
     g_DebugGUI->onScreenResize( ScreenSize );
@@ -590,6 +611,14 @@ void InitializeIOSubsystems()
 
     g_VirtualFileSystem->mount( g_DataFileSystem, NYA_STRING( "GameData" ), 1 );
 
+    // Loose files override packed files (see Tools/NyaPack)
+    if ( g_DataFileSystem->fileExists( NYA_STRING( "./data.npk" ) ) ) {
+        NYA_CLOG << "Mounting data pack..." << std::endl;
+
+        g_PackFileSystem = nya::core::allocate<FileSystemPack>( g_GlobalAllocator, NYA_STRING( "./data.npk" ) );
+        g_VirtualFileSystem->mount( g_PackFileSystem, NYA_STRING( "GameData" ), 2 );
+    }
+
 #if NYA_DEVBUILD
     NYA_CLOG << "Mounting devbuild filesystem..." << std::endl;
 
@@ -628,7 +657,7 @@ void InitializeIOSubsystems()
 
 #if NYA_DEVBUILD
     g_FileSystemWatchdog = nya::core::allocate<FileSystemWatchdog>( g_GlobalAllocator );
-    g_FileSystemWatchdog->create();
+    g_FileSystemWatchdog->create( g_VirtualFileSystem );
 #endif
 }
 
@@ -636,7 +665,7 @@ void InitializeInputSubsystems()
 {
     NYA_CLOG << "Initializing input subsystems..." << std::endl;
 
-    g_InputMapper = nya::core::allocate<InputMapper>( g_GlobalAllocator );
+    g_InputMapper = nya::core::allocate<InputMapper>( g_GlobalAllocator, g_GlobalAllocator );
     g_InputReader = nya::core::allocate<InputReader>( g_GlobalAllocator );
     g_InputReader->create();
 
@@ -672,6 +701,10 @@ void InitializeRenderSubsystems()
     g_GraphicsAssetCache = nya::core::allocate<GraphicsAssetCache>( g_GlobalAllocator, g_GlobalAllocator, g_RenderDevice, g_ShaderCache, g_VirtualFileSystem );
     g_DrawCommandBuilder = nya::core::allocate<DrawCommandBuilder>( g_GlobalAllocator, g_GlobalAllocator );
     g_LightGrid = nya::core::allocate<LightGrid>( g_GlobalAllocator, g_GlobalAllocator );
+    g_IBLProbeCache = nya::core::allocate<IBLProbeCache>( g_GlobalAllocator, g_RenderDevice, g_VirtualFileSystem );
+    g_FramePacketQueue = nya::core::allocate<FramePacketQueue>( g_GlobalAllocator, g_GlobalAllocator, nya::maths::clamp( static_cast<uint32_t>( FramePacketCount ), 1u, FramePacketQueue::MAX_PACKET_COUNT ) );
+
+    g_DrawCommandBuilder->setIBLProbeCache( g_IBLProbeCache );
 
     g_LightGrid->loadCachedResources( g_RenderDevice, g_ShaderCache, g_GraphicsAssetCache );
     g_WorldRenderer->loadCachedResources( g_RenderDevice, g_ShaderCache, g_GraphicsAssetCache );
@@ -695,7 +728,7 @@ void InitializeGameLogicSubsystems()
 {
     NYA_CLOG << "Initializing game logic subsystems..." << std::endl;
 
-    g_SceneTest = nya::core::allocate<Scene>( g_GlobalAllocator, g_GlobalAllocator );
+    g_SceneTest = nya::core::allocate<Scene>( g_GlobalAllocator, g_GlobalAllocator, g_GraphicsAssetCache );
 }
 
 void InitializeMemorySubsystems()
@@ -824,7 +857,9 @@ static void DisplayMenuBar()
                 }
 
                 if ( ImGui::MenuItem( "Delete" ) ) {
-
+                    if ( g_PickedNode != nullptr && g_SceneTest->removeNode( g_PickedNode, g_LightGrid ) ) {
+                        g_PickedNode = nullptr;
+                    }
                 }
                 ImGui::EndMenu();
             }
@@ -895,6 +930,8 @@ static void DisplayMenuBar()
                     g_FreeCamera->setImageQuality( ImageQuality );
                 }
 
+                ImGui::Checkbox( "Enable Dynamic Resolution", &EnableDynamicResolution );
+
                 if ( ImGui::Checkbox( "Enable VSync", &EnableVSync ) ) {
                     g_RenderDevice->enableVerticalSynchronisation( EnableVSync );
                 }
@@ -954,6 +991,10 @@ void PrintEditorGUI()
                 ImGui::PushStyleColor( ImGuiCol_Button, ImVec4( 0.96f, 0.1f, 0.05f, 1.0f ) );
                 if ( ImGui::Button( "Delete!" ) ) {
                     ImGui::PopStyleColor();
+
+                    if ( g_SceneTest->removeNode( g_PickedNode, g_LightGrid ) ) {
+                        g_PickedNode = nullptr;
+                    }
                 }
                 else {
                     ImGui::PopStyleColor();
@@ -1132,7 +1173,11 @@ void PrintEditorGUI()
 
                                     std::replace( meshName.begin(), meshName.end(), '\\', '/' );
 
-                                    renderableMesh->meshResource = g_GraphicsAssetCache->getMesh( ( NYA_STRING( "GameData" ) + meshName ).c_str() );
+                                    renderableMesh->meshResource = g_GraphicsAssetCache->getMeshAsync( ( NYA_STRING( "GameData" ) + meshName ).c_str() );
+
+                                    if ( meshResource != nullptr ) {
+                                        g_GraphicsAssetCache->releaseMesh( meshResource );
+                                    }
                                 }
                             }
 
@@ -1193,72 +1238,199 @@ void PrintEditorGUI()
 }
 #endif
 
+static void RenderFrame( FramePacket* framePacket )
+{
+    Timer renderTimer = {};
+    nya::core::StartTimer( &renderTimer );
+
+    {
+        // Asset hot reload and streamed assets finalization modify resources referenced by the scene
+        std::lock_guard<std::mutex> sceneLock( g_SceneMutex );
+        g_FileSystemWatchdog->onFrame( g_GraphicsAssetCache, g_ShaderCache );
+        g_GraphicsAssetCache->finalizeAsyncLoads();
+        g_GraphicsAssetCache->updateResidency();
+    }
+
+    NYA_BEGIN_PROFILE_SCOPE( "Rendering" )
+        g_DrawCommandBuilder->buildRenderQueues( g_WorldRenderer, g_LightGrid, framePacket );
+        g_WorldRenderer->drawWorld( g_RenderDevice, framePacket->frameTime );
+    NYA_END_PROFILE_SCOPE()
+
+    g_LastFrameGPUTime.store( g_WorldRenderer->getLastFrameGPUTime() );
+
+#if NYA_DEVBUILD
+    {
+        // The editor GUI edits the scene; it can't overlap the game frame
+        std::lock_guard<std::mutex> sceneLock( g_SceneMutex );
+        PrintEditorGUI();
+    }
+#endif
+
+    g_RenderDevice->present();
+
+    // Bake mode: quit once every IBL probe has been written to the cache
+    if ( g_DrawCommandBuilder->isIBLProbeBakeComplete() ) {
+        g_IsIBLProbeBakeComplete.store( true );
+    }
+
+    NYA_PROFILE_STAT( "Render Thread Frame Time (ms)", nya::core::GetTimerDeltaAsMiliseconds( &renderTimer ) )
+}
+
+static void RenderThreadLoop()
+{
+    nya::core::SetSubmissionThreadIndex( 1u );
+
+    while ( 1 ) {
+        FramePacket* framePacket = g_FramePacketQueue->acquireRenderPacket();
+        if ( framePacket == nullptr ) {
+            break;
+        }
+
+        RenderFrame( framePacket );
+
+        g_FramePacketQueue->release( framePacket );
+    }
+}
+
 void MainLoop()
 {
+    nya::core::SetSubmissionThreadIndex( 0u );
+
     // Application main loop
     Timer updateTimer = {};
     FramerateCounter logicCounter = {};
+    DynamicResolutionController dynamicResolutionController;
+    bool wasDynamicResolutionEnabled = false;
 
     float frameTime = static_cast<float>( nya::core::GetTimerDeltaAsSeconds( &updateTimer ) );
     double accumulator = 0.0;
 
+#if NYA_GL460
+    // GL contexts are bound to the thread which created them
+    const bool useRenderThread = false;
+#else
+    const bool useRenderThread = EnableRenderThread;
+#endif
+
+    // The game thread simulates frame N + 1 while the render thread draws frame N
+    std::thread renderThread;
+    if ( useRenderThread ) {
+        NYA_CLOG << "Starting render thread (" << g_FramePacketQueue->getPacketCount() << " frame packets)..." << std::endl;
+        renderThread = std::thread( RenderThreadLoop );
+    }
+
     while ( 1 ) {
         g_Profiler.onFrame();
 
-        nya::display::PollSystemEvents( g_DisplaySurface, g_InputReader );
-
-        if ( nya::display::HasReceivedQuitSignal( g_DisplaySurface ) ) {
+        // Blocks while every packet is in flight (i.e. the game thread is too far ahead of the render thread)
+        FramePacket* framePacket = g_FramePacketQueue->acquireSubmissionPacket();
+        if ( framePacket == nullptr ) {
             break;
         }
 
-        frameTime = static_cast< float >( nya::core::GetTimerDeltaAsSeconds( &updateTimer ) );
+        bool hasReceivedQuitSignal = false;
 
-		// Update Input
-		g_InputReader->onFrame( g_InputMapper );
+        NYA_BEGIN_PROFILE_SCOPE( "Game Frame" )
+        {
+            std::lock_guard<std::mutex> sceneLock( g_SceneMutex );
 
-		// Update Local Game Instance
-		g_InputMapper->update( frameTime );
-		g_InputMapper->clear();
+            nya::display::PollSystemEvents( g_DisplaySurface, g_InputReader );
 
-        g_FileSystemWatchdog->onFrame( g_GraphicsAssetCache, g_ShaderCache );
+            hasReceivedQuitSignal = nya::display::HasReceivedQuitSignal( g_DisplaySurface );
+
+            frameTime = static_cast< float >( nya::core::GetTimerDeltaAsSeconds( &updateTimer ) );
+
+            // Update Input
+            g_InputReader->onFrame( g_InputMapper );
+
+            // Update Local Game Instance
+            g_InputMapper->update( frameTime );
+            g_InputMapper->clear();
 
-        logicCounter.onFrame( frameTime );
+            logicCounter.onFrame( frameTime );
 
-        accumulator += static_cast<double>( frameTime );
+            accumulator += static_cast<double>( frameTime );
         
-        NYA_BEGIN_PROFILE_SCOPE( "Fixed-step updates" )
-            while ( accumulator >= static_cast<double>( nya::editor::LOGIC_DELTA ) ) {
-                g_SceneTest->updateLogic( nya::editor::LOGIC_DELTA );
+            NYA_BEGIN_PROFILE_SCOPE( "Fixed-step updates" )
+                while ( accumulator >= static_cast<double>( nya::editor::LOGIC_DELTA ) ) {
+                    g_SceneTest->updateLogic( nya::editor::LOGIC_DELTA );
 
-                accumulator -= static_cast<double>( nya::editor::LOGIC_DELTA );
-            }
-        NYA_END_PROFILE_SCOPE()
+                    accumulator -= static_cast<double>( nya::editor::LOGIC_DELTA );
+                }
+            NYA_END_PROFILE_SCOPE()
+
+            NYA_BEGIN_PROFILE_SCOPE( "Draw Collection" )
+                g_DrawCommandBuilder->setSubmissionPacket( framePacket );
+
+                // Update Debug GUI widgets
+                g_FramerateGUILabel->setValue( "Main Loop " + std::to_string( logicCounter.AvgDeltaTime ).substr( 0, 6 ) + " ms / " + std::to_string( logicCounter.MaxDeltaTime ).substr( 0, 6 ) + " ms (" + std::to_string( logicCounter.AvgFramePerSecond ).substr( 0, 6 ) + " FPS)" );
+                g_DebugGUI->collectDrawCmds( *g_DrawCommandBuilder );
 
-        NYA_BEGIN_PROFILE_SCOPE( "Rendering" )
-            // Update Debug GUI widgets
-            g_FramerateGUILabel->Value = "Main Loop " + std::to_string( logicCounter.AvgDeltaTime ).substr( 0, 6 ) + " ms / " + std::to_string( logicCounter.MaxDeltaTime ).substr( 0, 6 ) + " ms (" + std::to_string( logicCounter.AvgFramePerSecond ).substr( 0, 6 ) + " FPS)";
-            g_DebugGUI->collectDrawCmds( *g_DrawCommandBuilder );
+                const std::string& profileString = g_Profiler.getProfilingSummaryString();
+                // The summary changes every frame; use a stable key so that its cached glyph run is updated in place
+                g_DrawCommandBuilder->addHUDText( nyaVec2f( 256.0f, 0.0f ), 0.350f, nyaVec4f( 1.0f, 1.0f, 1.0f, 1.0f ), profileString, NYA_STRING_HASH( "Editor/ProfilingSummary" ) );
 
-            const std::string& profileString = g_Profiler.getProfilingSummaryString();
-            g_WorldRenderer->TextRenderModule->addOutlinedText( profileString.c_str(), 0.350f, 256.0f, 0.0f );
-            g_WorldRenderer->LineRenderModule->addLine( g_PickingRay.origin, g_PickingRay.direction, 10.0f, nyaVec4f( 1, 0, 0, 1 ) );
+                if ( g_IsPickingRayPending ) {
+                    g_DrawCommandBuilder->addLineToRender( g_PickingRay.origin, g_PickingRay.direction, nyaVec4f( 1, 0, 0, 1 ), 5.0f );
+                    g_IsPickingRayPending = false;
+                }
 
-            g_SceneTest->collectDrawCmds( *g_DrawCommandBuilder );
+                framePacket->frameTime = frameTime;
+                g_SceneTest->collectDrawCmds( *g_DrawCommandBuilder );
 
-            // Update scene bounds each frame
-            const AABB& sceneAabb = g_SceneTest->getSceneAabb();
-            g_LightGrid->setSceneBounds( sceneAabb.maxPoint, sceneAabb.minPoint );
+                // Cached IBL probes are invalidated as soon as the scene content changes
+                // The hash is only needed to restore (or bake) the probes captured this frame
+                if ( !framePacket->iblProbesToCapture.empty() ) {
+                    framePacket->sceneHash = g_SceneTest->computeContentHash();
+                }
 
-            g_DrawCommandBuilder->buildRenderQueues( g_WorldRenderer, g_LightGrid );
+                // Update scene bounds each frame
+                const AABB& sceneAabb = g_SceneTest->getSceneAabb();
+                g_LightGrid->setSceneBounds( sceneAabb.maxPoint, sceneAabb.minPoint );
+                g_LightGrid->captureFrameLights( framePacket->lights );
 
-            g_WorldRenderer->drawWorld( g_RenderDevice, frameTime );
+                g_DrawCommandBuilder->setSubmissionPacket( nullptr );
+            NYA_END_PROFILE_SCOPE()
+        }
         NYA_END_PROFILE_SCOPE()
 
-#if NYA_DEVBUILD
-        PrintEditorGUI();
-#endif
+        if ( hasReceivedQuitSignal ) {
+            break;
+        }
+
+        g_FramePacketQueue->submit( framePacket );
+
+        if ( !useRenderThread ) {
+            FramePacket* renderPacket = g_FramePacketQueue->acquireRenderPacket();
+            RenderFrame( renderPacket );
+            g_FramePacketQueue->release( renderPacket );
+        }
+
+        // NOTE GPU time is retrieved from the last frame rendered (up to FramePacketCount - 1 frames late if the render thread is enabled)
+        if ( EnableDynamicResolution ) {
+            if ( !wasDynamicResolutionEnabled ) {
+                dynamicResolutionController.reset( ImageQuality );
+            }
+
+            const float dynamicImageQuality = dynamicResolutionController.onFrame( g_LastFrameGPUTime.load(), static_cast<double>( frameTime ) * 1000.0 );
+            g_FreeCamera->setImageQuality( dynamicImageQuality );
+        } else if ( wasDynamicResolutionEnabled ) {
+            g_FreeCamera->setImageQuality( ImageQuality );
+        }
+
+        wasDynamicResolutionEnabled = EnableDynamicResolution;
 
-        g_RenderDevice->present();
+        if ( g_IsIBLProbeBakeComplete.load() ) {
+            NYA_CLOG << "IBL probe bake complete; exiting..." << std::endl;
+            break;
+        }
+    }
+
+    // Let the render thread flush the frames already submitted
+    g_FramePacketQueue->shutdown();
+
+    if ( renderThread.joinable() ) {
+        renderThread.join();
     }
 }
 
@@ -1272,18 +1444,26 @@ void Shutdown()
 
     g_LightGrid->destroy( g_RenderDevice );
     g_WorldRenderer->destroy( g_RenderDevice );
+
+    // The scene releases its cached assets
+    nya::core::free( g_GlobalAllocator, g_SceneTest );
     g_GraphicsAssetCache->destroy();
 
     nya::display::DestroyDisplaySurface( g_DisplaySurface );
 
+    nya::core::free( g_GlobalAllocator, g_FramePacketQueue );
     nya::core::free( g_GlobalAllocator, g_DrawCommandBuilder );
-    nya::core::free( g_GlobalAllocator, g_SceneTest );
+    nya::core::free( g_GlobalAllocator, g_IBLProbeCache );
     nya::core::free( g_GlobalAllocator, g_GraphicsAssetCache );
     nya::core::free( g_GlobalAllocator, g_WorldRenderer );
     nya::core::free( g_GlobalAllocator, g_ShaderCache );
     nya::core::free( g_GlobalAllocator, g_AudioDevice );
     nya::core::free( g_GlobalAllocator, g_DevFileSystem );
     nya::core::free( g_GlobalAllocator, g_DataFileSystem );
+
+    if ( g_PackFileSystem != nullptr ) {
+        nya::core::free( g_GlobalAllocator, g_PackFileSystem );
+    }
     nya::core::free( g_GlobalAllocator, g_SaveFileSystem );
     nya::core::free( g_GlobalAllocator, g_VirtualFileSystem );
     nya::core::free( g_GlobalAllocator, g_RenderDevice );
@@ -1,8 +1,8 @@
 /*
-Project Alone Source Code
+    Project Nya Source Code
     Copyright (C) 2018 Prvost Baptiste
 
-    This file is part of Project Alone source code.
+    This file is part of Project Nya source code.
 
     This program is free software: you can redistribute it and/or modify
     it under the terms of the GNU General Public License as published by
@@ -19,25 +19,37 @@ Project Alone Source Code
 */
 #include <Shared.h>
 
-#if FLAN_DEVBUILD
-#if FLAN_UNIX
+#if NYA_DEVBUILD
+#if NYA_UNIX
 #include "FileSystemWatchdogUnix.h"
 
-#include <Core/TaskManager.h>
-#include <Core/Environment.h>
 #include <Core/StringHelpers.h>
 
-#include <Graphics/GraphicsAssetManager.h>
-#include <Graphics/ShaderStageManager.h>
+#include <Graphics/GraphicsAssetCache.h>
+#include <Graphics/ShaderCache.h>
 
-#include <AppShared.h>
+#include <FileSystem/VirtualFileSystem.h>
 
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/inotify.h>
 
+static constexpr uint32_t WATCH_EVENT_MASK = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO;
+
+// Only the folders mounted by the editor are watched recursively (the working directory itself is watched to catch
+// their creation)
+static bool IsMountedFolder( const nyaString_t& relativeFolder )
+{
+    return relativeFolder.compare( 0, 5, NYA_STRING( "data/" ) ) == 0
+        || relativeFolder.compare( 0, 4, NYA_STRING( "dev/" ) ) == 0;
+}
+
 FileSystemWatchdog::FileSystemWatchdog()
-    : fsWatchdogHandle( -1 )
-    , watchdogHandle( -1 )
+    : virtualFileSystem( nullptr )
+    , inotifyHandle( -1 )
     , shutdownSignal( false )
 {
 
@@ -45,174 +57,256 @@ FileSystemWatchdog::FileSystemWatchdog()
 
 FileSystemWatchdog::~FileSystemWatchdog()
 {
-    // Send signal to the watchdog handle first (should work)
-    inotify_rm_watch( fsWatchdogHandle, watchdogHandle );
-    close( fsWatchdogHandle );
-
-    // Then toggle the atomic boolean (which should properly stop the thread)
+    // The monitor thread polls with a timeout and checks the signal in between
     shutdownSignal.store( true );
+
+    if ( monitorThread.joinable() ) {
+        monitorThread.join();
+    }
+
+    // Closing the instance removes every watch
+    if ( inotifyHandle >= 0 ) {
+        close( inotifyHandle );
+        inotifyHandle = -1;
+    }
 }
 
-void FileSystemWatchdog::Create()
+void FileSystemWatchdog::create( VirtualFileSystem* virtualFileSystem )
 {
-    fnString_t workingDirectory;
-    flan::core::RetrieveWorkingDirectory( workingDirectory );
+    this->virtualFileSystem = virtualFileSystem;
 
-    // Create filesystem watchdog
-    fsWatchdogHandle = inotify_init();
+    inotifyHandle = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
 
-    if ( fsWatchdogHandle < 0 ) {
-        FLAN_CERR << "Failed to initialize inotify (error code: " << fsWatchdogHandle << ")" << std::endl;
-        FLAN_CWARN << "File changes won't be taken in account for this session" << std::endl;
+    if ( inotifyHandle < 0 ) {
+        NYA_CERR << "Failed to initialize inotify (error code: " << errno << ")" << std::endl;
+        NYA_CWARN << "File changes won't be taken in account for this session" << std::endl;
         return;
     }
 
-    // Create directory watchdog
-    watchdogHandle = inotify_add_watch( fsWatchdogHandle, workingDirectory.c_str(), IN_MODIFY | IN_CREATE | IN_DELETE );
+    // Paths are relative to the working directory (which holds the data and dev folders; see Editor)
+    if ( !watchFolder( NYA_STRING( "" ) ) ) {
+        NYA_CERR << "Failed to watch the working directory (error code: " << errno << ")" << std::endl;
+        NYA_CWARN << "File changes won't be taken in account for this session" << std::endl;
 
-    if ( watchdogHandle < 0 ) {
-        FLAN_CERR << "Failed to initialize watchdog handle (error code: " << watchdogHandle << ")" << std::endl;
-        FLAN_CWARN << "File changes won't be taken in account for this session" << std::endl;
+        close( inotifyHandle );
+        inotifyHandle = -1;
         return;
     }
 
-    g_TaskManager->addTask( std::bind( &FileSystemWatchdog::Monitor, this ) );
+    // External changes are now reported; the file system queries can be cached
+    virtualFileSystem->setQueryCachingEnabled( true );
+
+    monitorThread = std::thread( std::bind( &FileSystemWatchdog::monitor, this ) );
 }
 
-void FileSystemWatchdog::OnFrame()
+void FileSystemWatchdog::onFrame( GraphicsAssetCache* graphicsAssetManager, ShaderCache* shaderCache )
 {
+    std::lock_guard<std::mutex> reloadQueueLockGuard( reloadQueueLock );
+
     while ( !materialsToReload.empty() ) {
         auto& materialToReload = materialsToReload.front();
-        g_GraphicsAssetManager->getMaterial( materialToReload.c_str(), true );
+        graphicsAssetManager->getMaterial( materialToReload.c_str(), true );
 
         materialsToReload.pop();
     }
 
     while ( !texturesToReload.empty() ) {
         auto& textureToReload = texturesToReload.front();
-        g_GraphicsAssetManager->getTexture( textureToReload.c_str(), true );
+        graphicsAssetManager->getTexture( textureToReload.c_str(), true );
 
         texturesToReload.pop();
     }
 
     while ( !meshesToReload.empty() ) {
         auto& meshToReload = meshesToReload.front();
-        g_GraphicsAssetManager->getMesh( meshToReload.c_str(), true );
+        graphicsAssetManager->getMesh( meshToReload.c_str(), true );
 
         meshesToReload.pop();
     }
 
-   /* while ( !modelsToReload.empty() ) {
-        auto& modelToReload = modelsToReload.front();
-        g_GraphicsAssetManager->getOrLoadModel( modelToReload.c_str(), true );
-
-        modelsToReload.pop();
-    }*/
-    
     while ( !shadersToReload.empty() ) {
         auto& shaderToReload = shadersToReload.front();
-        g_ShaderStageManager->getOrUploadStage( shaderToReload.Filename, shaderToReload.StageType, true );
+        shaderCache->getOrUploadStage( shaderToReload.Filename, shaderToReload.StageType, true );
 
         shadersToReload.pop();
     }
 }
 
-void FileSystemWatchdog::Monitor()
+bool FileSystemWatchdog::watchFolder( const nyaString_t& relativeFolder )
+{
+    const nyaString_t folderPath = ( relativeFolder.empty() ) ? NYA_STRING( "./" ) : relativeFolder;
+
+    const int watchDescriptor = inotify_add_watch( inotifyHandle, folderPath.c_str(), WATCH_EVENT_MASK | IN_ONLYDIR );
+
+    if ( watchDescriptor < 0 ) {
+        return false;
+    }
+
+    watchedFolders[watchDescriptor] = relativeFolder;
+
+    DIR* directory = opendir( folderPath.c_str() );
+
+    if ( directory == nullptr ) {
+        return true;
+    }
+
+    struct dirent* directoryEntry = nullptr;
+    while ( ( directoryEntry = readdir( directory ) ) != nullptr ) {
+        if ( directoryEntry->d_type != DT_DIR
+          || strcmp( directoryEntry->d_name, "." ) == 0
+          || strcmp( directoryEntry->d_name, ".." ) == 0 ) {
+            continue;
+        }
+
+        const nyaString_t relativeSubfolder = relativeFolder + directoryEntry->d_name + NYA_STRING( "/" );
+
+        if ( !IsMountedFolder( relativeSubfolder ) ) {
+            continue;
+        }
+
+        // A subfolder which can't be watched (e.g. removed in the meantime) should not disable the whole watchdog
+        if ( !watchFolder( relativeSubfolder ) ) {
+            NYA_CWARN << "Failed to watch folder '" << relativeSubfolder << "' (error code: " << errno << ")" << std::endl;
+        }
+    }
+
+    closedir( directory );
+
+    return true;
+}
+
+void FileSystemWatchdog::onFileChanged( const nyaString_t& relativeFilename, const bool needReload )
 {
-    constexpr std::size_t EVENT_SIZE = ( sizeof (struct inotify_event) );
-    constexpr std::size_t MAX_BUFFER = ( 1024 * ( EVENT_SIZE + 16 ) );
+    nyaString_t relativeModifiedFilename = relativeFilename;
+
+    // Get VFS File paths
+    nya::core::RemoveWordFromString( relativeModifiedFilename, NYA_STRING( "data/" ) );
+    nya::core::RemoveWordFromString( relativeModifiedFilename, NYA_STRING( "dev/" ) );
+
+    // Any change (including file creation and renaming) invalidates the cached file system queries
+    virtualFileSystem->invalidateCachedFile( NYA_STRING( "GameData/" ) + relativeModifiedFilename );
+
+    if ( !needReload ) {
+        return;
+    }
 
-    char buffer[MAX_BUFFER] = {};
+    auto extension = nya::core::GetFileExtensionFromPath( relativeModifiedFilename );
+    nya::core::StringToLower( extension );
 
-    while ( 1 ) {
-        if ( shutdownSignal.load() ) {
-            break;
+    if ( extension.empty() ) {
+        return;
+    }
+
+    NYA_CLOG << relativeModifiedFilename << " has been edited" << std::endl;
+
+    auto vfsPath = NYA_STRING( "GameData/" ) + relativeModifiedFilename;
+
+    std::lock_guard<std::mutex> reloadQueueLockGuard( reloadQueueLock );
+
+    auto extensionHashcode = nya::core::CRC32( extension );
+    switch ( extensionHashcode ) {
+    case NYA_STRING_HASH( "amat" ):
+    case NYA_STRING_HASH( "mat" ):
+        materialsToReload.push( vfsPath );
+        break;
+
+    case NYA_STRING_HASH( "dds" ):
+    case NYA_STRING_HASH( "bmp" ):
+    case NYA_STRING_HASH( "jpeg" ):
+    case NYA_STRING_HASH( "jpg" ):
+    case NYA_STRING_HASH( "png" ):
+    case NYA_STRING_HASH( "tiff" ):
+    case NYA_STRING_HASH( "gif" ):
+        texturesToReload.push( vfsPath );
+        break;
+
+    case NYA_STRING_HASH( "mesh" ):
+        meshesToReload.push( vfsPath );
+        break;
+
+    case NYA_STRING_HASH( "vso" ):
+    case NYA_STRING_HASH( ".gl.spvv" ):
+    case NYA_STRING_HASH( ".vk.spvv" ):
+        nya::core::RemoveWordFromString( vfsPath, NYA_STRING( "/CompiledShaders/" ) );
+        shadersToReload.push( { vfsPath, SHADER_STAGE_VERTEX } );
+        break;
+
+    case NYA_STRING_HASH( "pso" ):
+    case NYA_STRING_HASH( ".gl.spvp" ):
+    case NYA_STRING_HASH( ".vk.spvp" ):
+        nya::core::RemoveWordFromString( vfsPath, NYA_STRING( "/CompiledShaders/" ) );
+        shadersToReload.push( { vfsPath, SHADER_STAGE_PIXEL } );
+        break;
+
+    case NYA_STRING_HASH( "cso" ):
+    case NYA_STRING_HASH( ".gl.spvc" ):
+    case NYA_STRING_HASH( ".vk.spvc" ):
+        nya::core::RemoveWordFromString( vfsPath, NYA_STRING( "/CompiledShaders/" ) );
+        shadersToReload.push( { vfsPath, SHADER_STAGE_COMPUTE } );
+        break;
+    }
+}
+
+void FileSystemWatchdog::monitor()
+{
+    constexpr std::size_t MAX_BUFFER = 1024 * ( sizeof( struct inotify_event ) + 16 );
+
+    alignas( struct inotify_event ) char buffer[MAX_BUFFER];
+
+    pollfd pollDescriptor = { inotifyHandle, POLLIN, 0 };
+
+    while ( !shutdownSignal.load() ) {
+        if ( poll( &pollDescriptor, 1, 100 ) <= 0 ) {
+            continue;
         }
 
-        auto length = read( fsWatchdogHandle, buffer, MAX_BUFFER );
+        const ssize_t length = read( inotifyHandle, buffer, MAX_BUFFER );
 
-        if ( length < 0 ) {
-            break;
+        if ( length <= 0 ) {
+            continue;
         }
 
-        for ( int i = 0; i < length;  ) {
-            struct inotify_event* event = reinterpret_cast<struct inotify_event*>( &buffer[ i ] );
-
-            if ( event->len > 0 ) {
-                if ( event->mask & IN_DELETE || event->mask & IN_MODIFY ) {
-                    FLAN_CLOG << "Changes detected! Trying to reload the asset..." << std::endl;
-
-                    // Ignore directory changes (for now)
-                    if ( event->mask & IN_ISDIR ) {
-                        continue;
-                    }
-
-                    auto relativeModifiedFilename = fnString_t( event->name, event->len );
-
-                    // Get VFS File paths
-                    flan::core::RemoveWordFromString( relativeModifiedFilename, FLAN_STRING( "data\\" ) );
-                    flan::core::RemoveWordFromString( relativeModifiedFilename, FLAN_STRING( "dev\\" ) );
-                    flan::core::RemoveWordFromString( relativeModifiedFilename, FLAN_STRING( "\\" ), FLAN_STRING( "/" ) );
-
-                    auto extension = flan::core::GetFileExtensionFromPath( relativeModifiedFilename );
-                    flan::core::StringToLower( extension );
-
-                    if ( !extension.empty() ) {
-                        FLAN_CLOG << relativeModifiedFilename << " has been edited" << std::endl;
-
-                        auto vfsPath = FLAN_STRING( "GameData/" ) + fnString_t( relativeModifiedFilename.c_str() );
-
-                        auto extensionHashcode = flan::core::CRC32( extension );
-                        switch ( extensionHashcode ) {
-                        case FLAN_STRING_HASH( "amat" ):
-                        case FLAN_STRING_HASH( "mat" ):
-                            materialsToReload.push( vfsPath );
-                            break;
-
-                        case FLAN_STRING_HASH( "dds" ):
-                        case FLAN_STRING_HASH( "bmp" ):
-                        case FLAN_STRING_HASH( "jpeg" ):
-                        case FLAN_STRING_HASH( "jpg" ):
-                        case FLAN_STRING_HASH( "png" ):
-                        case FLAN_STRING_HASH( "tiff" ):
-                        case FLAN_STRING_HASH( "gif" ):
-                            texturesToReload.push( vfsPath );
-                            break;
-
-                        case FLAN_STRING_HASH( "mesh" ):
-                            meshesToReload.push( vfsPath );
-                            break;
-
-                        case FLAN_STRING_HASH( "mdl" ):
-                            modelsToReload.push( vfsPath );
-                            break;
-
-                        case FLAN_STRING_HASH( "vso" ):
-                        case FLAN_STRING_HASH( ".gl.spvv" ):
-                        case FLAN_STRING_HASH( ".vk.spvv" ):
-                            flan::core::RemoveWordFromString( vfsPath, FLAN_STRING( "/CompiledShaders/" ) );
-                            shadersToReload.push( { vfsPath, SHADER_STAGE_VERTEX } );
-                            break;
-
-                        case FLAN_STRING_HASH( "pso" ):
-                        case FLAN_STRING_HASH( ".gl.spvp" ):
-                        case FLAN_STRING_HASH( ".vk.spvp" ):
-                            flan::core::RemoveWordFromString( vfsPath, FLAN_STRING( "/CompiledShaders/" ) );
-                            shadersToReload.push( { vfsPath, SHADER_STAGE_PIXEL } );
-                            break;
-
-                        case FLAN_STRING_HASH( "cso" ):
-                        case FLAN_STRING_HASH( ".gl.spvc" ):
-                        case FLAN_STRING_HASH( ".vk.spvc" ):
-                            flan::core::RemoveWordFromString( vfsPath, FLAN_STRING( "/CompiledShaders/" ) );
-                            shadersToReload.push( { vfsPath, SHADER_STAGE_COMPUTE } );
-                            break;
-                        }
-                    }
+        for ( ssize_t i = 0; i < length; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>( &buffer[i] );
+            i += sizeof( struct inotify_event ) + event->len;
+
+            // Events have been dropped; nothing cached can be trusted anymore
+            if ( event->mask & IN_Q_OVERFLOW ) {
+                NYA_CWARN << "inotify event queue overflow; dropping the cached file system queries" << std::endl;
+
+                virtualFileSystem->setQueryCachingEnabled( false );
+                virtualFileSystem->setQueryCachingEnabled( true );
+                continue;
+            }
+
+            // The watch is removed by the kernel once the folder has been deleted
+            if ( event->mask & IN_IGNORED ) {
+                watchedFolders.erase( event->wd );
+                continue;
+            }
+
+            auto watchedFolder = watchedFolders.find( event->wd );
+            if ( event->len == 0 || watchedFolder == watchedFolders.end() ) {
+                continue;
+            }
+
+            const nyaString_t relativeFilename = watchedFolder->second + event->name;
+
+            if ( event->mask & IN_ISDIR ) {
+                // Files can be created in the new folder before the watch is added; the folder invalidation below drops
+                // the cached listings anyway
+                const nyaString_t relativeFolder = relativeFilename + NYA_STRING( "/" );
+
+                if ( ( event->mask & ( IN_CREATE | IN_MOVED_TO ) ) && IsMountedFolder( relativeFolder ) ) {
+                    watchFolder( relativeFolder );
                 }
+
+                onFileChanged( relativeFilename, false );
+                continue;
             }
 
-            i += EVENT_SIZE + event->len;
+            // Modifications are reported once the file is closed (editors usually save through a rename)
+            onFileChanged( relativeFilename, ( event->mask & ( IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE ) ) != 0 );
         }
     }
 }
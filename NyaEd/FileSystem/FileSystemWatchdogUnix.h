@@ -1,8 +1,8 @@
 /*
-Project Alone Source Code
+    Project Nya Source Code
     Copyright (C) 2018 Prvost Baptiste
 
-    This file is part of Project Alone source code.
+    This file is part of Project Nya source code.
 
     This program is free software: you can redistribute it and/or modify
     it under the terms of the GNU General Public License as published by
@@ -19,13 +19,20 @@ Project Alone Source Code
 */
 #pragma once
 
-#if FLAN_DEVBUILD
-#if FLAN_UNIX
+#if NYA_DEVBUILD
+#if NYA_UNIX
 
 #include <atomic>
+#include <mutex>
 #include <queue>
+#include <thread>
+#include <unordered_map>
 
-#include <Rendering/ShaderStages.h>
+#include <Rendering/RenderDevice.h>
+
+class GraphicsAssetCache;
+class ShaderCache;
+class VirtualFileSystem;
 
 class FileSystemWatchdog
 {
@@ -34,30 +41,42 @@ public:
             FileSystemWatchdog( FileSystemWatchdog& ) = delete;
             ~FileSystemWatchdog();
 
-    void    Create();
-    void    OnFrame();
+    // Changes are reported to the virtual file system (cached existence and folder listings)
+    // The caching of the file system queries is only enabled if the working directory could be watched
+    void    create( VirtualFileSystem* virtualFileSystem );
+    void    onFrame( GraphicsAssetCache* graphicsAssetManager, ShaderCache* shaderCache );
 
 private:
     struct ShaderStageToReload
     {
-        fnString_t   Filename;
-        eShaderStage StageType;
+        std::string   Filename;
+        eShaderStage  StageType;
     };
 
 private:
-    int                 fsWatchdogHandle;
-    int                 watchdogHandle;
-    std::atomic<bool>   shutdownSignal;
-
-    std::queue<fnString_t> materialsToReload;
-    std::queue<fnString_t> texturesToReload;
-    std::queue<fnString_t> meshesToReload;
-    std::queue<fnString_t> modelsToReload;
+    VirtualFileSystem*  virtualFileSystem;
+    int                 inotifyHandle;
+    std::atomic_bool    shutdownSignal;
+    std::thread         monitorThread;
+
+    // inotify watches are not recursive; each folder is watched (keyed by watch descriptor; paths are relative to the
+    // working directory and are empty or end with a '/')
+    std::unordered_map<int, nyaString_t>    watchedFolders;
+
+    // Filled by the monitor thread
+    std::mutex              reloadQueueLock;
+    std::queue<nyaString_t> materialsToReload;
+    std::queue<nyaString_t> texturesToReload;
+    std::queue<nyaString_t> meshesToReload;
     
     std::queue<ShaderStageToReload> shadersToReload;
     
 private:
-    void    Monitor();
+    void    monitor();
+
+    // Watch a folder and its subfolders (relativeFolder is empty or ends with a '/')
+    bool    watchFolder( const nyaString_t& relativeFolder );
+    void    onFileChanged( const nyaString_t& relativeFilename, const bool needReload );
 };
 #endif
 #endif
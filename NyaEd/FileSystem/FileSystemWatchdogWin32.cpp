@@ -29,10 +29,13 @@ Project Alone Source Code
 #include <Graphics/GraphicsAssetCache.h>
 #include <Graphics/ShaderCache.h>
 
+#include <FileSystem/VirtualFileSystem.h>
+
 #include <thread>
 
 FileSystemWatchdog::FileSystemWatchdog()
-    : watchdogHandle( nullptr )
+    : virtualFileSystem( nullptr )
+    , watchdogHandle( nullptr )
     , shutdownSignal( false )
 {
 
@@ -49,12 +52,25 @@ FileSystemWatchdog::~FileSystemWatchdog()
     shutdownSignal.store( true );
 }
 
-void FileSystemWatchdog::create()
+void FileSystemWatchdog::create( VirtualFileSystem* virtualFileSystem )
 {
+    this->virtualFileSystem = virtualFileSystem;
+
     nyaString_t workingDirectory;
     nya::core::RetrieveWorkingDirectory( workingDirectory );
     watchdogHandle = ::CreateFile( workingDirectory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL );
 
+    if ( watchdogHandle == INVALID_HANDLE_VALUE ) {
+        NYA_CERR << "Failed to open the working directory (error code: " << GetLastError() << ")" << std::endl;
+        NYA_CWARN << "File changes won't be taken in account for this session" << std::endl;
+
+        watchdogHandle = nullptr;
+        return;
+    }
+
+    // External changes are now reported; the file system queries can be cached
+    virtualFileSystem->setQueryCachingEnabled( true );
+
     monitorThread = std::thread( std::bind( &FileSystemWatchdog::monitor, this ) );
 }
 
@@ -108,14 +124,17 @@ void FileSystemWatchdog::monitor()
             const FILE_NOTIFY_INFORMATION* pNotifyInfo = ( FILE_NOTIFY_INFORMATION* )Buffer;
             memcpy( fileNameModified, pNotifyInfo->FileName, pNotifyInfo->FileNameLength );
 
-            if ( pNotifyInfo->Action == FILE_ACTION_MODIFIED || pNotifyInfo->Action == FILE_ACTION_REMOVED ) {
-                nyaString_t relativeModifiedFilename = fileNameModified;
+            nyaString_t relativeModifiedFilename = fileNameModified;
 
-                // Get VFS File paths
-                nya::core::RemoveWordFromString( relativeModifiedFilename, NYA_STRING( "data\\" ) );
-                nya::core::RemoveWordFromString( relativeModifiedFilename, NYA_STRING( "dev\\" ) );
-                nya::core::RemoveWordFromString( relativeModifiedFilename, NYA_STRING( "\\" ), NYA_STRING( "/" ) );
+            // Get VFS File paths
+            nya::core::RemoveWordFromString( relativeModifiedFilename, NYA_STRING( "data\\" ) );
+            nya::core::RemoveWordFromString( relativeModifiedFilename, NYA_STRING( "dev\\" ) );
+            nya::core::RemoveWordFromString( relativeModifiedFilename, NYA_STRING( "\\" ), NYA_STRING( "/" ) );
 
+            // Any change (including file creation and renaming) invalidates the cached file system queries
+            virtualFileSystem->invalidateCachedFile( NYA_STRING( "GameData/" ) + relativeModifiedFilename );
+
+            if ( pNotifyInfo->Action == FILE_ACTION_MODIFIED || pNotifyInfo->Action == FILE_ACTION_REMOVED ) {
                 auto extension = nya::core::GetFileExtensionFromPath( relativeModifiedFilename );
                 nya::core::StringToLower( extension );
 
@@ -173,7 +192,7 @@ void FileSystemWatchdog::monitor()
         memset( Buffer, 0, MAX_BUFFER * sizeof( BYTE ) );
         memset( fileNameModified, 0, FILENAME_MAX * sizeof( WCHAR ) );
 
-        changesResult = ReadDirectoryChangesW( watchdogHandle, Buffer, MAX_BUFFER, TRUE, FILE_NOTIFY_CHANGE_LAST_WRITE, &dwBytesReturned, 0, 0 );
+        changesResult = ReadDirectoryChangesW( watchdogHandle, Buffer, MAX_BUFFER, TRUE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME, &dwBytesReturned, 0, 0 );
     }
 }
 #endif
@@ -30,6 +30,7 @@ Project Alone Source Code
 
 class GraphicsAssetCache;
 class ShaderCache;
+class VirtualFileSystem;
 
 class FileSystemWatchdog
 {
@@ -38,7 +39,8 @@ public:
             FileSystemWatchdog( FileSystemWatchdog& ) = delete;
             ~FileSystemWatchdog();
 
-    void    create();
+    // Changes are reported to the virtual file system (cached existence and folder listings)
+    void    create( VirtualFileSystem* virtualFileSystem );
     void    onFrame( GraphicsAssetCache* graphicsAssetManager, ShaderCache* shaderCache );
 
 private:
@@ -49,6 +51,7 @@ private:
     };
 
 private:
+    VirtualFileSystem*  virtualFileSystem;
     HANDLE              watchdogHandle;
     std::atomic_bool    shutdownSignal;
     std::thread         monitorThread;
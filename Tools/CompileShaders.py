@@ -327,6 +327,8 @@ compile_shader_CS( "Lighting/LightCulling" )
 compile_shader_VS( "Lighting/Ubersurface", [ "NYA_SCALE_UV_BY_MODEL_SCALE" ] )
 compile_shader_VS( "Lighting/UberDepthOnly", [ "NYA_SCALE_UV_BY_MODEL_SCALE" ] )
 compile_shader_PS( "Lighting/UberDepthOnly" )
+compile_shader_VS( "Lighting/ShadowTileClear" )
+compile_shader_PS( "Lighting/ShadowTileClear" )
 compile_shader_PS( "Lighting/Ubersurface", [ "NYA_EDITOR", "NYA_TERRAIN", "NYA_BRDF_STANDARD", "NYA_PROBE_CAPTURE", "NYA_ENCODE_RGBD", "NYA_USE_LOD_ALPHA_BLENDING", "NYA_USE_NORMAL_MAPPING", "NYA_RECEIVE_SHADOW", "NYA_CAST_SHADOW", "NYA_DEBUG_CSM_CASCADE" ] )
 compile_shader_PS( "Lighting/Ubersurface", [ "NYA_EDITOR", "NYA_TERRAIN", "NYA_BRDF_CLEAR_COAT", "NYA_PROBE_CAPTURE", "NYA_ENCODE_RGBD", "NYA_USE_LOD_ALPHA_BLENDING", "NYA_USE_NORMAL_MAPPING", "NYA_RECEIVE_SHADOW", "NYA_CAST_SHADOW", "NYA_DEBUG_CSM_CASCADE" ] )
 compile_shader_PS( "Lighting/Ubersurface", [ "NYA_EDITOR", "NYA_TERRAIN", "NYA_BRDF_EMISSIVE", "NYA_PROBE_CAPTURE", "NYA_ENCODE_RGBD", "NYA_USE_LOD_ALPHA_BLENDING", "NYA_USE_NORMAL_MAPPING", "NYA_RECEIVE_SHADOW", "NYA_CAST_SHADOW", "NYA_DEBUG_CSM_CASCADE" ] )
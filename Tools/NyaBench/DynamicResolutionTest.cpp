@@ -0,0 +1,201 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "NyaBench.h"
+
+#include <Graphics/DynamicResolutionController.h>
+
+#include <Core/EnvVarsRegister.h>
+
+#include <cmath>
+
+// Matches the controller defaults (see DynamicResolutionController.cpp)
+static constexpr double FRAME_BUDGET = 16.6667;
+static constexpr double OVER_BUDGET_FRAME_TIME = 25.0;
+static constexpr double UNDER_BUDGET_FRAME_TIME = 5.0;
+static constexpr uint32_t COOLDOWN_FRAME_COUNT = 8u;
+
+static bool IsQuantized( const float imageQuality )
+{
+    const float stepCount = imageQuality / 0.05f;
+    return std::fabs( stepCount - std::round( stepCount ) ) < 1e-3f;
+}
+
+static bool IsNearlyEqual( const float left, const float right )
+{
+    return std::fabs( left - right ) < 1e-4f;
+}
+
+// Feed frameCount frames with the same timings; return true if every frame took the expected decision
+static bool FeedFrames( DynamicResolutionController& controller, const uint32_t frameCount, const double gpuFrameTime, const double cpuFrameTime, const DynamicResolutionController::eDecision expectedDecision )
+{
+    bool isExpected = true;
+    for ( uint32_t frameIdx = 0u; frameIdx < frameCount; frameIdx++ ) {
+        controller.onFrame( gpuFrameTime, cpuFrameTime );
+        isExpected &= ( controller.getLastDecision() == expectedDecision );
+    }
+
+    return isExpected;
+}
+
+static int TestDownscale()
+{
+    int failureCount = 0;
+
+    DynamicResolutionController controller;
+    controller.reset( 1.0f );
+
+    // Three consecutive frames over budget are required
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 2u, OVER_BUDGET_FRAME_TIME, 1.0, DynamicResolutionController::DECISION_HOLD ) );
+    failureCount += !NYA_BENCH_CHECK( controller.getImageQuality() == 1.0f );
+
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 1u, OVER_BUDGET_FRAME_TIME, 1.0, DynamicResolutionController::DECISION_DOWNSCALE ) );
+
+    const float downscaledImageQuality = controller.getImageQuality();
+    failureCount += !NYA_BENCH_CHECK( downscaledImageQuality < 1.0f && downscaledImageQuality >= 0.75f );
+    failureCount += !NYA_BENCH_CHECK( IsQuantized( downscaledImageQuality ) );
+
+    // Nothing changes during the cooldown (even if the frame time stays over budget)
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, COOLDOWN_FRAME_COUNT, OVER_BUDGET_FRAME_TIME, 1.0, DynamicResolutionController::DECISION_HOLD ) );
+    failureCount += !NYA_BENCH_CHECK( controller.getImageQuality() == downscaledImageQuality );
+
+    // Then three frames are required again
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 2u, OVER_BUDGET_FRAME_TIME, 1.0, DynamicResolutionController::DECISION_HOLD ) );
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 1u, OVER_BUDGET_FRAME_TIME, 1.0, DynamicResolutionController::DECISION_DOWNSCALE ) );
+    failureCount += !NYA_BENCH_CHECK( controller.getImageQuality() < downscaledImageQuality && IsQuantized( controller.getImageQuality() ) );
+
+    // A frame within budget breaks the streak (frame times are smoothed; the frame has to bring the average back within budget)
+    controller.reset( 1.0f );
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 2u, FRAME_BUDGET + 1.0, 1.0, DynamicResolutionController::DECISION_HOLD ) );
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 20u, 10.0, 1.0, DynamicResolutionController::DECISION_HOLD ) );
+    failureCount += !NYA_BENCH_CHECK( controller.getImageQuality() == 1.0f );
+
+    return failureCount;
+}
+
+static int TestUpscale()
+{
+    int failureCount = 0;
+
+    DynamicResolutionController controller;
+    controller.reset( 0.5f );
+
+    // Thirty consecutive frames under the upscale threshold are required
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 29u, UNDER_BUDGET_FRAME_TIME, 1.0, DynamicResolutionController::DECISION_HOLD ) );
+    failureCount += !NYA_BENCH_CHECK( controller.getImageQuality() == 0.5f );
+
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 1u, UNDER_BUDGET_FRAME_TIME, 1.0, DynamicResolutionController::DECISION_UPSCALE ) );
+
+    const float upscaledImageQuality = controller.getImageQuality();
+    failureCount += !NYA_BENCH_CHECK( upscaledImageQuality > 0.5f && upscaledImageQuality <= 0.6f );
+    failureCount += !NYA_BENCH_CHECK( IsQuantized( upscaledImageQuality ) );
+
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, COOLDOWN_FRAME_COUNT, UNDER_BUDGET_FRAME_TIME, 1.0, DynamicResolutionController::DECISION_HOLD ) );
+    failureCount += !NYA_BENCH_CHECK( controller.getImageQuality() == upscaledImageQuality );
+
+    return failureCount;
+}
+
+static int TestImageQualityBounds()
+{
+    int failureCount = 0;
+
+    float* minImageQuality = EnvironmentVariables::getVariable<float>( NYA_STRING_HASH( "DynamicResolutionMinImageQuality" ) );
+    float* maxImageQuality = EnvironmentVariables::getVariable<float>( NYA_STRING_HASH( "DynamicResolutionMaxImageQuality" ) );
+
+    failureCount += !NYA_BENCH_CHECK( minImageQuality != nullptr && maxImageQuality != nullptr );
+    if ( minImageQuality == nullptr || maxImageQuality == nullptr ) {
+        return failureCount;
+    }
+
+    const float defaultMinImageQuality = *minImageQuality;
+    const float defaultMaxImageQuality = *maxImageQuality;
+
+    *minImageQuality = 0.6f;
+    *maxImageQuality = 0.8f;
+
+    DynamicResolutionController controller;
+
+    // The largest downscale step would go below the min image quality
+    controller.reset( 0.65f );
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 3u, 100.0, 1.0, DynamicResolutionController::DECISION_DOWNSCALE ) == false );
+    failureCount += !NYA_BENCH_CHECK( controller.getLastDecision() == DynamicResolutionController::DECISION_DOWNSCALE );
+    failureCount += !NYA_BENCH_CHECK( IsNearlyEqual( controller.getImageQuality(), 0.6f ) );
+
+    // No decision is taken once the bound is reached
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, COOLDOWN_FRAME_COUNT + 16u, 100.0, 1.0, DynamicResolutionController::DECISION_HOLD ) );
+    failureCount += !NYA_BENCH_CHECK( IsNearlyEqual( controller.getImageQuality(), 0.6f ) );
+
+    // Same thing for the max image quality
+    controller.reset( 0.75f );
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 30u, 1.0, 1.0, DynamicResolutionController::DECISION_UPSCALE ) == false );
+    failureCount += !NYA_BENCH_CHECK( controller.getLastDecision() == DynamicResolutionController::DECISION_UPSCALE );
+    failureCount += !NYA_BENCH_CHECK( IsNearlyEqual( controller.getImageQuality(), 0.8f ) );
+
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, COOLDOWN_FRAME_COUNT + 64u, 1.0, 1.0, DynamicResolutionController::DECISION_HOLD ) );
+    failureCount += !NYA_BENCH_CHECK( IsNearlyEqual( controller.getImageQuality(), 0.8f ) );
+
+    // An image quality out of the range is clamped on the next frame
+    controller.reset( 1.0f );
+    failureCount += !NYA_BENCH_CHECK( IsNearlyEqual( controller.onFrame( FRAME_BUDGET - 1.0, 1.0 ), 0.8f ) );
+
+    *minImageQuality = defaultMinImageQuality;
+    *maxImageQuality = defaultMaxImageQuality;
+
+    return failureCount;
+}
+
+static int TestCPUFallback()
+{
+    int failureCount = 0;
+
+    DynamicResolutionController controller;
+
+    // Without GPU timings, the CPU frame time drives the decisions
+    controller.reset( 1.0f );
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 2u, -1.0, OVER_BUDGET_FRAME_TIME, DynamicResolutionController::DECISION_HOLD ) );
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 1u, -1.0, OVER_BUDGET_FRAME_TIME, DynamicResolutionController::DECISION_DOWNSCALE ) );
+    failureCount += !NYA_BENCH_CHECK( !controller.isCPUBound() );
+
+    // With GPU timings, a slow CPU frame does not lower the resolution (the frame is flagged as CPU bound instead)
+    controller.reset( 1.0f );
+    failureCount += !NYA_BENCH_CHECK( FeedFrames( controller, 16u, UNDER_BUDGET_FRAME_TIME + 10.0, OVER_BUDGET_FRAME_TIME, DynamicResolutionController::DECISION_HOLD ) );
+    failureCount += !NYA_BENCH_CHECK( controller.isCPUBound() );
+    failureCount += !NYA_BENCH_CHECK( controller.getImageQuality() == 1.0f );
+
+    return failureCount;
+}
+
+int RunDynamicResolutionTest( int argc, char** argv )
+{
+    int failureCount = 0;
+    failureCount += TestDownscale();
+    failureCount += TestUpscale();
+    failureCount += TestImageQualityBounds();
+    failureCount += TestCPUFallback();
+
+    if ( failureCount > 0 ) {
+        NYA_COUT << "DynamicResolution: " << failureCount << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    NYA_COUT << "DynamicResolution: all checks passed" << std::endl;
+    return 0;
+}
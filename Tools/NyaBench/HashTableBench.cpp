@@ -0,0 +1,206 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "NyaBench.h"
+
+#include <Core/Containers/HashMap.h>
+#include <Core/Timer.h>
+
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+static constexpr uint32_t   LOOKUP_COUNT = 1000000u;
+static constexpr uint32_t   RANDOM_OPERATION_COUNT = 200000u;
+
+// Returns the average time per find (in nanoseconds); the checksum keeps the lookups from being optimized out
+template<typename Map>
+static double MeasureFindTime( const Map& map, const std::vector<uint32_t>& lookupKeys, uint64_t& checksum )
+{
+    Timer timer = {};
+    nya::core::StartTimer( &timer );
+
+    for ( const uint32_t key : lookupKeys ) {
+        auto entry = map.find( key );
+        if ( entry != map.end() ) {
+            checksum += entry->second;
+        }
+    }
+
+    return nya::core::GetTimerDeltaAsMiliseconds( &timer ) * 1000000.0 / lookupKeys.size();
+}
+
+template<typename Map>
+static double MeasureInsertTime( Map& map, const std::vector<uint32_t>& keys )
+{
+    Timer timer = {};
+    nya::core::StartTimer( &timer );
+
+    for ( const uint32_t key : keys ) {
+        map[key] = key;
+    }
+
+    return nya::core::GetTimerDeltaAsMiliseconds( &timer ) * 1000000.0 / keys.size();
+}
+
+template<typename Map>
+static double MeasureEraseTime( Map& map, const std::vector<uint32_t>& keys )
+{
+    Timer timer = {};
+    nya::core::StartTimer( &timer );
+
+    for ( const uint32_t key : keys ) {
+        map.erase( key );
+    }
+
+    return nya::core::GetTimerDeltaAsMiliseconds( &timer ) * 1000000.0 / keys.size();
+}
+
+static int RunBenchmark( BaseAllocator* allocator, const uint32_t keyCount, std::mt19937& randomGenerator )
+{
+    std::vector<uint32_t> keys( keyCount );
+    for ( uint32_t& key : keys ) {
+        key = randomGenerator();
+    }
+
+    // Lookups hit 3/4 of the time (the asset cache lookups mostly hit)
+    std::uniform_int_distribution<uint32_t> keyDistribution( 0u, keyCount - 1u );
+    std::vector<uint32_t> lookupKeys( LOOKUP_COUNT );
+    for ( uint32_t& lookupKey : lookupKeys ) {
+        lookupKey = ( ( randomGenerator() & 3u ) != 0u ) ? keys[keyDistribution( randomGenerator )] : randomGenerator();
+    }
+
+    HashMap<uint32_t, uint32_t> hashMap;
+    hashMap.create( allocator );
+
+    std::map<uint32_t, uint32_t> map;
+    std::unordered_map<uint32_t, uint32_t> unorderedMap;
+
+    const double hashMapInsertTime = MeasureInsertTime( hashMap, keys );
+    const double mapInsertTime = MeasureInsertTime( map, keys );
+    const double unorderedMapInsertTime = MeasureInsertTime( unorderedMap, keys );
+
+    uint64_t hashMapChecksum = 0ull, mapChecksum = 0ull, unorderedMapChecksum = 0ull;
+    const double hashMapFindTime = MeasureFindTime( hashMap, lookupKeys, hashMapChecksum );
+    const double mapFindTime = MeasureFindTime( map, lookupKeys, mapChecksum );
+    const double unorderedMapFindTime = MeasureFindTime( unorderedMap, lookupKeys, unorderedMapChecksum );
+
+    int failureCount = 0;
+    failureCount += !NYA_BENCH_CHECK( hashMap.size() == map.size() );
+    failureCount += !NYA_BENCH_CHECK( hashMapChecksum == mapChecksum );
+    failureCount += !NYA_BENCH_CHECK( hashMapChecksum == unorderedMapChecksum );
+
+    const double hashMapEraseTime = MeasureEraseTime( hashMap, keys );
+    const double mapEraseTime = MeasureEraseTime( map, keys );
+    const double unorderedMapEraseTime = MeasureEraseTime( unorderedMap, keys );
+
+    failureCount += !NYA_BENCH_CHECK( hashMap.size() == 0u );
+
+    hashMap.destroy();
+
+    NYA_COUT << keyCount << " keys (ns per operation; HashMap / std::map / std::unordered_map)" << std::endl
+             << "    find   " << hashMapFindTime << " / " << mapFindTime << " / " << unorderedMapFindTime << std::endl
+             << "    insert " << hashMapInsertTime << " / " << mapInsertTime << " / " << unorderedMapInsertTime << std::endl
+             << "    erase  " << hashMapEraseTime << " / " << mapEraseTime << " / " << unorderedMapEraseTime << std::endl;
+
+    return failureCount;
+}
+
+// Random inserts, erases and finds on a small key range (long probe sequences and backward shifts), checked against std::unordered_map
+static int RunRandomOperations( BaseAllocator* allocator, std::mt19937& randomGenerator )
+{
+    HashMap<uint32_t, uint32_t> hashMap;
+    hashMap.create( allocator );
+
+    std::unordered_map<uint32_t, uint32_t> expectedMap;
+
+    std::uniform_int_distribution<uint32_t> keyDistribution( 0u, 4095u );
+    std::uniform_int_distribution<uint32_t> operationDistribution( 0u, 2u );
+
+    int failureCount = 0;
+    for ( uint32_t i = 0u; i < RANDOM_OPERATION_COUNT && failureCount == 0; i++ ) {
+        const uint32_t key = keyDistribution( randomGenerator );
+
+        switch ( operationDistribution( randomGenerator ) ) {
+        case 0:
+            hashMap.insert( key, i );
+            expectedMap[key] = i;
+            break;
+
+        case 1:
+            failureCount += !NYA_BENCH_CHECK( hashMap.erase( key ) == ( expectedMap.erase( key ) != 0u ) );
+            break;
+
+        default: {
+            auto entry = hashMap.find( key );
+            auto expectedEntry = expectedMap.find( key );
+
+            failureCount += !NYA_BENCH_CHECK( ( entry != hashMap.end() ) == ( expectedEntry != expectedMap.end() ) );
+            if ( entry != hashMap.end() && expectedEntry != expectedMap.end() ) {
+                failureCount += !NYA_BENCH_CHECK( entry->second == expectedEntry->second );
+            }
+        } break;
+        }
+    }
+
+    failureCount += !NYA_BENCH_CHECK( hashMap.size() == expectedMap.size() );
+
+    // Iteration should visit each entry once
+    uint32_t iteratedEntryCount = 0u;
+    for ( const auto& entry : hashMap ) {
+        auto expectedEntry = expectedMap.find( entry.first );
+        failureCount += !NYA_BENCH_CHECK( expectedEntry != expectedMap.end() && expectedEntry->second == entry.second );
+        iteratedEntryCount++;
+    }
+
+    failureCount += !NYA_BENCH_CHECK( iteratedEntryCount == expectedMap.size() );
+
+    hashMap.destroy();
+
+    return failureCount;
+}
+
+int RunHashTableBench( int argc, char** argv )
+{
+    static constexpr uint32_t KEY_COUNTS[3] = { 64u, 1024u, 16384u };
+
+    // Fixed seed so that runs are comparable
+    std::mt19937 randomGenerator( 1337u );
+
+    BaseAllocator* allocator = nya::bench::CreateHeap( 32 * 1024 * 1024 );
+
+    int failureCount = RunRandomOperations( allocator, randomGenerator );
+    for ( const uint32_t keyCount : KEY_COUNTS ) {
+        failureCount += RunBenchmark( allocator, keyCount, randomGenerator );
+    }
+
+    // Every slot array should have been freed
+    failureCount += !NYA_BENCH_CHECK( allocator->getAllocationCount() == 0u );
+
+    nya::bench::DestroyHeap( allocator );
+
+    if ( failureCount > 0 ) {
+        NYA_COUT << "HashTable: " << failureCount << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
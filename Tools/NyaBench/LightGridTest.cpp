@@ -0,0 +1,305 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "NyaBench.h"
+
+#include <Graphics/LightGrid.h>
+#include <Rendering/CommandList.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#if NYA_NULL_RENDERER
+// NOTE Must match the cluster grid dimensions of LightGrid.cpp
+static constexpr int CLUSTER_X = 16;
+static constexpr int CLUSTER_Y = 8;
+static constexpr int CLUSTER_Z = 24;
+
+static constexpr std::size_t TEST_HEAP_SIZE = 256 * 1024 * 1024;
+
+static PointLightData CreatePointLight( const nyaVec3f& worldPosition, const float radius )
+{
+    PointLightData light = {};
+    light.worldPosition = worldPosition;
+    light.radius = radius;
+    light.colorRGB = nyaVec3f( 1.0f, 1.0f, 1.0f );
+    light.lightPower = 100.0f;
+
+    return light;
+}
+
+static size_t UploadFrameLights( LightGrid& lightGrid, CommandList& cmdList )
+{
+    LightGrid::FrameLights frameLights = {};
+    lightGrid.captureFrameLights( frameLights );
+    lightGrid.setFrameLights( frameLights );
+
+    // Buffers are never dereferenced by the Null Renderer
+    return lightGrid.uploadModifiedLights( cmdList, nullptr, nullptr, nullptr );
+}
+
+static int TestAllocation( BaseAllocator* allocator )
+{
+    int failureCount = 0;
+
+    LightGrid lightGrid( allocator );
+
+    // More lights than the previous fixed capacity (4096) and not a multiple of the page size
+    constexpr uint32_t LIGHT_COUNT = 5000u;
+
+    std::vector<PointLightData*> allocatedLights( LIGHT_COUNT );
+    for ( uint32_t i = 0u; i < LIGHT_COUNT; i++ ) {
+        allocatedLights[i] = lightGrid.allocatePointLightData( CreatePointLight( nyaVec3f( static_cast<float>( i ), 0.0f, 0.0f ), 1.0f ) );
+    }
+
+    // Pointers must stay valid while the grid grows
+    bool arePointersValid = true;
+    for ( uint32_t i = 0u; i < LIGHT_COUNT; i++ ) {
+        arePointersValid &= ( allocatedLights[i] != nullptr && allocatedLights[i]->worldPosition.x == static_cast<float>( i ) );
+    }
+    failureCount += !NYA_BENCH_CHECK( arePointersValid );
+
+    LightGrid::FrameLights frameLights = {};
+    lightGrid.captureFrameLights( frameLights );
+    failureCount += !NYA_BENCH_CHECK( frameLights.PointLights.size() == LIGHT_COUNT );
+    failureCount += !NYA_BENCH_CHECK( frameLights.Lights.PointLightCount == LIGHT_COUNT );
+
+    // Release one light out of ten; released lights must not be submitted anymore
+    std::vector<PointLightData*> releasedLights;
+    for ( uint32_t i = 0u; i < LIGHT_COUNT; i += 10u ) {
+        lightGrid.releasePointLightData( allocatedLights[i] );
+        releasedLights.push_back( allocatedLights[i] );
+    }
+
+    const uint32_t liveLightCount = LIGHT_COUNT - static_cast<uint32_t>( releasedLights.size() );
+
+    lightGrid.captureFrameLights( frameLights );
+    failureCount += !NYA_BENCH_CHECK( frameLights.PointLights.size() == liveLightCount );
+    failureCount += !NYA_BENCH_CHECK( frameLights.Lights.PointLightCount == liveLightCount );
+
+    bool isReleasedLightSubmitted = false;
+    for ( const PointLightData& light : frameLights.PointLights ) {
+        isReleasedLightSubmitted |= ( static_cast<uint32_t>( light.worldPosition.x ) % 10u ) == 0u;
+    }
+    failureCount += !NYA_BENCH_CHECK( !isReleasedLightSubmitted );
+
+    // Released slots are recycled before the grid grows
+    bool isSlotRecycled = true;
+    const uint32_t reallocatedLightCount = static_cast<uint32_t>( releasedLights.size() / 2 );
+    for ( uint32_t i = 0u; i < reallocatedLightCount; i++ ) {
+        PointLightData* light = lightGrid.allocatePointLightData( CreatePointLight( nyaVec3f( -1.0f ), 1.0f ) );
+        isSlotRecycled &= ( std::find( releasedLights.begin(), releasedLights.end(), light ) != releasedLights.end() );
+    }
+    failureCount += !NYA_BENCH_CHECK( isSlotRecycled );
+
+    lightGrid.captureFrameLights( frameLights );
+    failureCount += !NYA_BENCH_CHECK( frameLights.PointLights.size() == ( liveLightCount + reallocatedLightCount ) );
+    failureCount += !NYA_BENCH_CHECK( frameLights.Lights.PointLightCount == ( liveLightCount + reallocatedLightCount ) );
+
+    return failureCount;
+}
+
+static int TestUploadSizes( BaseAllocator* allocator )
+{
+    int failureCount = 0;
+
+    LightGrid lightGrid( allocator );
+    lightGrid.setSceneBounds( nyaVec3f( 64.0f ), nyaVec3f( -64.0f ) );
+
+    CommandList cmdList( allocator );
+
+    constexpr uint32_t LIGHT_COUNT = 1000u;
+
+    std::vector<PointLightData*> allocatedLights( LIGHT_COUNT );
+    for ( uint32_t i = 0u; i < LIGHT_COUNT; i++ ) {
+        allocatedLights[i] = lightGrid.allocatePointLightData( CreatePointLight( nyaVec3f( static_cast<float>( i % 64 ), 0.0f, 0.0f ), 1.0f ) );
+    }
+
+    // First upload: every light, the lights buffer and the global IBL probe
+    size_t uploadSize = UploadFrameLights( lightGrid, cmdList );
+    failureCount += !NYA_BENCH_CHECK( uploadSize == ( sizeof( LightGrid::LightsBuffer ) + sizeof( PointLightData ) * LIGHT_COUNT + sizeof( IBLProbeData ) ) );
+
+    // Nothing changed
+    uploadSize = UploadFrameLights( lightGrid, cmdList );
+    failureCount += !NYA_BENCH_CHECK( uploadSize == 0 );
+
+    // Single light modified
+    allocatedLights[500]->radius = 2.0f;
+    uploadSize = UploadFrameLights( lightGrid, cmdList );
+    failureCount += !NYA_BENCH_CHECK( uploadSize == sizeof( PointLightData ) );
+
+    // Close lights are merged in a single range
+    allocatedLights[10]->radius = 2.0f;
+    allocatedLights[13]->radius = 2.0f;
+    uploadSize = UploadFrameLights( lightGrid, cmdList );
+    failureCount += !NYA_BENCH_CHECK( uploadSize == sizeof( PointLightData ) * 4 );
+
+    // Releasing the last light only updates the light count
+    lightGrid.releasePointLightData( allocatedLights[LIGHT_COUNT - 1] );
+    uploadSize = UploadFrameLights( lightGrid, cmdList );
+    failureCount += !NYA_BENCH_CHECK( uploadSize == sizeof( LightGrid::LightsBuffer ) );
+    failureCount += !NYA_BENCH_CHECK( lightGrid.getPointLightCount() == ( LIGHT_COUNT - 1 ) );
+
+    // Growing the grid uploads the new lights only
+    constexpr uint32_t ADDITIONAL_LIGHT_COUNT = 2000u;
+    for ( uint32_t i = 0u; i < ADDITIONAL_LIGHT_COUNT; i++ ) {
+        lightGrid.allocatePointLightData( CreatePointLight( nyaVec3f( 0.0f, static_cast<float>( i % 64 ), 0.0f ), 1.0f ) );
+    }
+
+    uploadSize = UploadFrameLights( lightGrid, cmdList );
+    failureCount += !NYA_BENCH_CHECK( uploadSize == ( sizeof( LightGrid::LightsBuffer ) + sizeof( PointLightData ) * ADDITIONAL_LIGHT_COUNT ) );
+    failureCount += !NYA_BENCH_CHECK( lightGrid.getPointLightCount() == ( LIGHT_COUNT - 1 + ADDITIONAL_LIGHT_COUNT ) );
+
+    return failureCount;
+}
+
+// Returns the number of clusters whose point lights differ from a brute force sphere/AABB test
+static int CountMismatchingClusters( LightGrid& lightGrid, const nyaVec3f& sceneAABBMin, const nyaVec3f& sceneAABBMax )
+{
+    const nyaVec3f clusterSize = ( sceneAABBMax - sceneAABBMin ) / nyaVec3f( float( CLUSTER_X ), float( CLUSTER_Y ), float( CLUSTER_Z ) );
+
+    LightGrid::FrameLights frameLights = {};
+    lightGrid.captureFrameLights( frameLights );
+    lightGrid.setFrameLights( frameLights );
+    lightGrid.buildClustersCPU();
+
+    const uint32_t* clusters = lightGrid.getClustersCPU();
+    const uint32_t* itemList = lightGrid.getItemListCPU();
+
+    int mismatchingClusterCount = 0;
+    std::vector<uint32_t> expectedItems;
+    std::vector<uint32_t> clusterItems;
+
+    for ( int z = 0; z < CLUSTER_Z; z++ ) {
+        for ( int y = 0; y < CLUSTER_Y; y++ ) {
+            for ( int x = 0; x < CLUSTER_X; x++ ) {
+                const nyaVec3f clusterMin = sceneAABBMin + nyaVec3f( float( x ), float( y ), float( z ) ) * clusterSize;
+                const nyaVec3f clusterMax = clusterMin + clusterSize;
+
+                expectedItems.clear();
+                for ( uint32_t i = 0u; i < frameLights.PointLights.size(); i++ ) {
+                    const PointLightData& light = frameLights.PointLights[i];
+
+                    const float dx = nya::maths::max( clusterMin.x - light.worldPosition.x, 0.0f ) + nya::maths::max( light.worldPosition.x - clusterMax.x, 0.0f );
+                    const float dy = nya::maths::max( clusterMin.y - light.worldPosition.y, 0.0f ) + nya::maths::max( light.worldPosition.y - clusterMax.y, 0.0f );
+                    const float dz = nya::maths::max( clusterMin.z - light.worldPosition.z, 0.0f ) + nya::maths::max( light.worldPosition.z - clusterMax.z, 0.0f );
+
+                    if ( ( dx * dx + dy * dy + dz * dz ) < ( light.radius * light.radius ) ) {
+                        expectedItems.push_back( i );
+                    }
+                }
+
+                const int clusterIndex = ( x + y * CLUSTER_X + z * CLUSTER_X * CLUSTER_Y );
+                const uint32_t itemListOffset = clusters[clusterIndex * 2 + 0];
+                const uint32_t packedCount = clusters[clusterIndex * 2 + 1];
+                const uint32_t pointLightCount = ( packedCount >> 20 );
+                const uint32_t iblProbeCount = ( packedCount & 0xFF );
+
+                clusterItems.assign( itemList + itemListOffset, itemList + itemListOffset + pointLightCount );
+                std::sort( clusterItems.begin(), clusterItems.end() );
+
+                const bool isClusterValid = ( itemListOffset == static_cast<uint32_t>( clusterIndex ) * MAX_CLUSTER_ITEM_COUNT )
+                                         && ( iblProbeCount == 0u )
+                                         && ( clusterItems == expectedItems );
+
+                if ( !isClusterValid ) {
+                    NYA_COUT << "Cluster (" << x << ", " << y << ", " << z << "): " << pointLightCount << " lights (expected " << expectedItems.size() << ")" << std::endl;
+                    mismatchingClusterCount++;
+                }
+            }
+        }
+    }
+
+    return mismatchingClusterCount;
+}
+
+static int TestClusterAssignment( BaseAllocator* allocator )
+{
+    int failureCount = 0;
+
+    // Bounds are picked so that the cluster size is exactly 8 units on each axis (no rounding error on cluster bounds)
+    const nyaVec3f sceneAABBMin = nyaVec3f( -64.0f, -32.0f, -96.0f );
+    const nyaVec3f sceneAABBMax = nyaVec3f( 64.0f, 32.0f, 96.0f );
+
+    LightGrid lightGrid( allocator );
+    lightGrid.setSceneBounds( sceneAABBMax, sceneAABBMin );
+
+    std::mt19937 randomGenerator( 0x4E594131 );
+    std::uniform_real_distribution<float> randomX( sceneAABBMin.x, sceneAABBMax.x );
+    std::uniform_real_distribution<float> randomY( sceneAABBMin.y, sceneAABBMax.y );
+    std::uniform_real_distribution<float> randomZ( sceneAABBMin.z, sceneAABBMax.z );
+    std::uniform_real_distribution<float> randomRadius( 0.5f, 6.0f );
+
+    constexpr uint32_t LIGHT_COUNT = 400u;
+
+    std::vector<PointLightData*> allocatedLights( LIGHT_COUNT );
+    for ( uint32_t i = 0u; i < LIGHT_COUNT; i++ ) {
+        allocatedLights[i] = lightGrid.allocatePointLightData( CreatePointLight( nyaVec3f( randomX( randomGenerator ), randomY( randomGenerator ), randomZ( randomGenerator ) ), randomRadius( randomGenerator ) ) );
+    }
+
+    // Outside of the scene bounds (must not be assigned to any cluster)
+    lightGrid.allocatePointLightData( CreatePointLight( nyaVec3f( 0.0f, 0.0f, 1024.0f ), 4.0f ) );
+
+    failureCount += !NYA_BENCH_CHECK( CountMismatchingClusters( lightGrid, sceneAABBMin, sceneAABBMax ) == 0 );
+
+    // Moved lights (culling entities are updated in place)
+    for ( uint32_t i = 0u; i < LIGHT_COUNT; i += 2u ) {
+        allocatedLights[i]->worldPosition = nyaVec3f( randomX( randomGenerator ), randomY( randomGenerator ), randomZ( randomGenerator ) );
+    }
+
+    failureCount += !NYA_BENCH_CHECK( CountMismatchingClusters( lightGrid, sceneAABBMin, sceneAABBMax ) == 0 );
+
+    // Released lights (culling entities are gathered again)
+    for ( uint32_t i = 1u; i < LIGHT_COUNT; i += 4u ) {
+        lightGrid.releasePointLightData( allocatedLights[i] );
+    }
+
+    failureCount += !NYA_BENCH_CHECK( CountMismatchingClusters( lightGrid, sceneAABBMin, sceneAABBMax ) == 0 );
+
+    return failureCount;
+}
+
+int RunLightGridTest( int argc, char** argv )
+{
+    BaseAllocator* allocator = nya::bench::CreateHeap( TEST_HEAP_SIZE );
+
+    int failureCount = 0;
+    failureCount += TestAllocation( allocator );
+    failureCount += TestUploadSizes( allocator );
+    failureCount += TestClusterAssignment( allocator );
+
+    nya::bench::DestroyHeap( allocator );
+
+    if ( failureCount > 0 ) {
+        NYA_COUT << "LightGrid: " << failureCount << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    NYA_COUT << "LightGrid: all checks passed" << std::endl;
+    return 0;
+}
+#else
+int RunLightGridTest( int argc, char** argv )
+{
+    NYA_CERR << "The light grid test requires the Null Renderer backend (NYA_GFX_API=NYA_NULL_RENDERER)" << std::endl;
+    return 1;
+}
+#endif
@@ -0,0 +1,177 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "NyaBench.h"
+
+#include <Graphics/LightSpatialIndex.h>
+
+#include <Core/Timer.h>
+#include <Maths/Frustum.h>
+#include <Maths/MatrixTransformations.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// World half extent per cubic root of the light count (keeps the light density constant between runs)
+static constexpr float      WORLD_EXTENT_SCALE = 50.0f;
+static constexpr uint32_t   QUERY_COUNT = 1024u;
+
+static bool SphereAABBTest( const BoundingSphere& sphere, const AABB& aabb )
+{
+    const nyaVec3f closestPoint = nyaVec3f::min( nyaVec3f::max( sphere.center, aabb.minPoint ), aabb.maxPoint );
+    const nyaVec3f distance = ( sphere.center - closestPoint );
+
+    return nyaVec3f::dot( distance, distance ) <= ( sphere.radius * sphere.radius );
+}
+
+static bool SphereFrustumTest( const BoundingSphere& sphere, const Frustum& frustum )
+{
+    for ( int i = 0; i < 6; i++ ) {
+        const nyaVec4f& plane = frustum.planes[i];
+
+        if ( ( plane.x * sphere.center.x + plane.y * sphere.center.y + plane.z * sphere.center.z + plane.w ) < -sphere.radius ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Returns true if the (sorted) query results match the brute force results
+template<typename Volume, typename IntersectionTest>
+static bool CompareWithBruteForce( const std::vector<BoundingSphere>& spheres, const Volume& volume, IntersectionTest intersectionTest, std::vector<uint32_t>& queryResults )
+{
+    std::sort( queryResults.begin(), queryResults.end() );
+
+    std::vector<uint32_t> expectedResults;
+    for ( uint32_t i = 0u; i < static_cast<uint32_t>( spheres.size() ); i++ ) {
+        if ( intersectionTest( spheres[i], volume ) ) {
+            expectedResults.push_back( i );
+        }
+    }
+
+    return queryResults == expectedResults;
+}
+
+static int RunBenchmark( const uint32_t lightCount, std::mt19937& randomGenerator )
+{
+    const float worldExtent = WORLD_EXTENT_SCALE * std::cbrt( static_cast<float>( lightCount ) );
+
+    std::uniform_real_distribution<float> positionDistribution( -worldExtent, worldExtent );
+    std::uniform_real_distribution<float> radiusDistribution( 1.0f, 16.0f );
+    std::uniform_real_distribution<float> offsetDistribution( -4.0f, 4.0f );
+    std::uniform_real_distribution<float> extentDistribution( 32.0f, 128.0f );
+
+    std::vector<BoundingSphere> spheres( lightCount );
+    for ( BoundingSphere& sphere : spheres ) {
+        sphere.center = nyaVec3f( positionDistribution( randomGenerator ), positionDistribution( randomGenerator ), positionDistribution( randomGenerator ) );
+        sphere.radius = radiusDistribution( randomGenerator );
+    }
+
+    Timer timer = {};
+    nya::core::StartTimer( &timer );
+
+    LightSpatialIndex spatialIndex;
+    for ( const BoundingSphere& sphere : spheres ) {
+        spatialIndex.addEntity( sphere.center, sphere.radius );
+    }
+    spatialIndex.build();
+
+    const double buildTime = nya::core::GetTimerDeltaAsMiliseconds( &timer );
+
+    // Move every light a bit (what the light grid does when lights are animated)
+    for ( uint32_t i = 0u; i < lightCount; i++ ) {
+        spheres[i].center += nyaVec3f( offsetDistribution( randomGenerator ), offsetDistribution( randomGenerator ), offsetDistribution( randomGenerator ) );
+        spatialIndex.updateEntity( i, spheres[i].center, spheres[i].radius );
+    }
+
+    nya::core::GetTimerDeltaAsMiliseconds( &timer );
+    spatialIndex.refit();
+    const double refitTime = nya::core::GetTimerDeltaAsMiliseconds( &timer );
+
+    std::vector<AABB> queryVolumes( QUERY_COUNT );
+    for ( AABB& aabb : queryVolumes ) {
+        const nyaVec3f center( positionDistribution( randomGenerator ), positionDistribution( randomGenerator ), positionDistribution( randomGenerator ) );
+        const nyaVec3f halfExtents( extentDistribution( randomGenerator ), extentDistribution( randomGenerator ), extentDistribution( randomGenerator ) );
+
+        aabb = {};
+        aabb.minPoint = center - halfExtents;
+        aabb.maxPoint = center + halfExtents;
+    }
+
+    std::vector<uint32_t> queryResults;
+    size_t queryResultCount = 0;
+
+    nya::core::GetTimerDeltaAsMiliseconds( &timer );
+    for ( const AABB& aabb : queryVolumes ) {
+        queryResults.clear();
+        spatialIndex.query( aabb, queryResults );
+        queryResultCount += queryResults.size();
+    }
+    const double aabbQueryTime = nya::core::GetTimerDeltaAsMiliseconds( &timer );
+
+    Frustum frustum = {};
+    const nyaMat4x4f viewMatrix = nya::maths::MakeLookAtMat( nyaVec3f( 0.0f, 0.0f, 0.0f ), nyaVec3f( 1.0f, 0.0f, 0.5f ), nyaVec3f( 0.0f, 1.0f, 0.0f ) );
+    const nyaMat4x4f projectionMatrix = nya::maths::MakeFovProj( nya::maths::radians( 90.0f ), 16.0f / 9.0f, 0.1f, 250.0f );
+    nya::maths::UpdateFrustumPlanes( projectionMatrix * viewMatrix, frustum );
+
+    nya::core::GetTimerDeltaAsMiliseconds( &timer );
+    queryResults.clear();
+    spatialIndex.query( frustum, queryResults );
+    const double frustumQueryTime = nya::core::GetTimerDeltaAsMiliseconds( &timer );
+
+    int failureCount = 0;
+    failureCount += !NYA_BENCH_CHECK( CompareWithBruteForce( spheres, frustum, SphereFrustumTest, queryResults ) );
+
+    // Validating every query would be quadratic; a subset is enough
+    for ( uint32_t i = 0u; i < QUERY_COUNT; i += 64u ) {
+        queryResults.clear();
+        spatialIndex.query( queryVolumes[i], queryResults );
+        failureCount += !NYA_BENCH_CHECK( CompareWithBruteForce( spheres, queryVolumes[i], SphereAABBTest, queryResults ) );
+    }
+
+    NYA_COUT << lightCount << " lights (" << spatialIndex.getNodeCount() << " nodes): build " << buildTime << "ms; refit " << refitTime << "ms; "
+             << "AABB query " << ( aabbQueryTime * 1000.0 / QUERY_COUNT ) << "us (" << ( static_cast<double>( queryResultCount ) / QUERY_COUNT ) << " lights avg.); "
+             << "frustum query " << ( frustumQueryTime * 1000.0 ) << "us" << std::endl;
+
+    return failureCount;
+}
+
+int RunLightSpatialIndexBench( int argc, char** argv )
+{
+    static constexpr uint32_t LIGHT_COUNTS[4] = { 100u, 1000u, 10000u, 100000u };
+
+    // Fixed seed so that runs are comparable
+    std::mt19937 randomGenerator( 1337u );
+
+    int failureCount = 0;
+    for ( const uint32_t lightCount : LIGHT_COUNTS ) {
+        failureCount += RunBenchmark( lightCount, randomGenerator );
+    }
+
+    if ( failureCount > 0 ) {
+        NYA_COUT << "LightSpatialIndex: " << failureCount << " query result(s) differ from the brute force results" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "NyaBench.h"
+
+#include <FileSystem/FileSystemNative.h>
+#include <FileSystem/FileSystemObject.h>
+#include <Io/DirectDrawSurface.h>
+
+#include <Core/Timer.h>
+#include <Core/StringHelpers.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static constexpr uint32_t   SURFACE_DIMENSION = 2048u;
+static constexpr uint32_t   LOAD_COUNT = 50u;
+static constexpr uint32_t   CACHE_LINE_SIZE = 64u;
+
+// Sum of the first byte of each cache line (the texels are read the way the GPU upload would)
+static uint64_t ReadTexels( const uint8_t* texels, const std::size_t texelsSize )
+{
+    uint64_t checksum = 0ull;
+    for ( std::size_t i = 0; i < texelsSize; i += CACHE_LINE_SIZE ) {
+        checksum += texels[i];
+    }
+
+    return checksum;
+}
+
+// 2048x2048 RGBA8 surface with a full mip chain
+static bool WriteSurface( FileSystemNative& fileSystem, const nyaString_t& filename, uint64_t& expectedChecksum, std::size_t& expectedTexelsSize )
+{
+    DirectDrawSurface ddsData;
+    ddsData.textureDescription.dimension = TextureDescription::DIMENSION_TEXTURE_2D;
+    ddsData.textureDescription.width = SURFACE_DIMENSION;
+    ddsData.textureDescription.height = SURFACE_DIMENSION;
+    ddsData.textureDescription.depth = 1;
+    ddsData.textureDescription.arraySize = 1;
+    ddsData.textureDescription.mipCount = 0;
+    ddsData.textureDescription.format = eImageFormat::IMAGE_FORMAT_R8G8B8A8_UNORM;
+
+    std::size_t texelsSize = 0;
+    for ( uint32_t mipDimension = SURFACE_DIMENSION; mipDimension > 0u; mipDimension >>= 1u ) {
+        texelsSize += mipDimension * mipDimension * 4u;
+        ddsData.textureDescription.mipCount++;
+    }
+
+    ddsData.textureData.resize( texelsSize );
+    for ( std::size_t i = 0; i < texelsSize; i++ ) {
+        ddsData.textureData[i] = static_cast<uint8_t>( i * 31u );
+    }
+
+    FileSystemObject* file = fileSystem.openFile( filename, nya::core::eFileOpenMode::FILE_OPEN_MODE_WRITE | nya::core::eFileOpenMode::FILE_OPEN_MODE_BINARY | nya::core::eFileOpenMode::FILE_OPEN_MODE_TRUNCATE );
+    if ( file == nullptr || !file->isOpen() ) {
+        return false;
+    }
+
+    nya::core::SaveDirectDrawSurface( file, ddsData );
+    file->close();
+
+    expectedChecksum = ReadTexels( ddsData.textureData.data(), texelsSize );
+    expectedTexelsSize = texelsSize;
+
+    return true;
+}
+
+// Returns the average time per load (in milliseconds; opening the file is part of the load)
+static double MeasureLoadTime( FileSystemNative& fileSystem, const nyaString_t& filename, const int32_t openMode, const bool isMapped, const uint64_t expectedChecksum, const std::size_t expectedTexelsSize, int& failureCount )
+{
+    Timer timer = {};
+    nya::core::StartTimer( &timer );
+
+    for ( uint32_t i = 0u; i < LOAD_COUNT && failureCount == 0; i++ ) {
+        FileSystemObject* file = fileSystem.openFile( filename, openMode );
+        if ( !NYA_BENCH_CHECK( file != nullptr ) ) {
+            failureCount++;
+            break;
+        }
+
+        DirectDrawSurface ddsData;
+        nya::core::LoadDirectDrawSurface( file, ddsData );
+
+        const uint64_t checksum = ReadTexels( ddsData.texels, ddsData.texelsSize );
+
+        // Texels should be read in place from the mapping (no copy)
+        failureCount += !NYA_BENCH_CHECK( ddsData.textureData.empty() == isMapped );
+        failureCount += !NYA_BENCH_CHECK( ddsData.texelsSize == expectedTexelsSize );
+        failureCount += !NYA_BENCH_CHECK( checksum == expectedChecksum );
+
+        file->close();
+    }
+
+    return nya::core::GetTimerDeltaAsMiliseconds( &timer ) / LOAD_COUNT;
+}
+
+int RunLoaderBench( int argc, char** argv )
+{
+    // The surface is written to the working directory (unless a path is given)
+    const nyaString_t filename = ( argc >= 1 ) ? nyaString_t( argv[0], argv[0] + strlen( argv[0] ) ) : nyaString_t( NYA_STRING( "NyaBench_LoaderBench.dds" ) );
+
+    FileSystemNative fileSystem;
+
+    uint64_t expectedChecksum = 0ull;
+    std::size_t expectedTexelsSize = 0;
+    if ( !WriteSurface( fileSystem, filename, expectedChecksum, expectedTexelsSize ) ) {
+        NYA_CERR << "Failed to write '" << filename << "'" << std::endl;
+        return 1;
+    }
+
+    int failureCount = 0;
+
+    const int32_t nativeOpenMode = nya::core::eFileOpenMode::FILE_OPEN_MODE_READ | nya::core::eFileOpenMode::FILE_OPEN_MODE_BINARY;
+    const int32_t mappedOpenMode = nativeOpenMode | nya::core::eFileOpenMode::FILE_OPEN_MODE_MEMORY_MAPPED;
+
+    // Warm the page cache (the benchmark compares the loaders, not the disk)
+    MeasureLoadTime( fileSystem, filename, nativeOpenMode, false, expectedChecksum, expectedTexelsSize, failureCount );
+
+    const double nativeLoadTime = MeasureLoadTime( fileSystem, filename, nativeOpenMode, false, expectedChecksum, expectedTexelsSize, failureCount );
+    const double mappedLoadTime = MeasureLoadTime( fileSystem, filename, mappedOpenMode, true, expectedChecksum, expectedTexelsSize, failureCount );
+
+    remove( nya::core::WideStringToString( filename ).c_str() );
+
+    const double texelsSizeInMB = static_cast<double>( expectedTexelsSize ) / ( 1024.0 * 1024.0 );
+
+    NYA_COUT << SURFACE_DIMENSION << "x" << SURFACE_DIMENSION << " RGBA8 DDS with a full mip chain (" << texelsSizeInMB << " MB), " << LOAD_COUNT << " loads" << std::endl
+             << "    fstream " << nativeLoadTime << " ms/load (" << ( texelsSizeInMB * 1000.0 / nativeLoadTime ) << " MB/s)" << std::endl
+             << "    mmap    " << mappedLoadTime << " ms/load (" << ( texelsSizeInMB * 1000.0 / mappedLoadTime ) << " MB/s)" << std::endl;
+
+    if ( failureCount > 0 ) {
+        NYA_COUT << "Loader: " << failureCount << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
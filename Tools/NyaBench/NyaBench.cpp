@@ -0,0 +1,113 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "NyaBench.h"
+
+#include <Core/Allocators/TLSFAllocator.h>
+
+#include <string.h>
+
+static void PrintUsage()
+{
+    NYA_COUT << "Usage:" << std::endl
+             << "    NyaBench dynres-test" << std::endl
+             << "        Test the dynamic resolution controller decisions with synthetic GPU/CPU frame times" << std::endl
+             << "    NyaBench hashtable-bench" << std::endl
+             << "        Benchmark HashMap find/insert/erase against std::map and std::unordered_map (random operations are checked against std::unordered_map)" << std::endl
+             << "    NyaBench lightgrid-test" << std::endl
+             << "        Test the light grid point light allocation, upload sizes and CPU cluster assignment (Null Renderer only)" << std::endl
+             << "    NyaBench lightindex-bench" << std::endl
+             << "        Benchmark the light spatial index build/refit/queries from 100 to 100k lights (results are checked against a brute force test)" << std::endl
+             << "    NyaBench loader-bench [path]" << std::endl
+             << "        Benchmark the DDS loader with fstream and memory mapped files (a 22MB surface is written to path; default: working directory)" << std::endl
+             << "    NyaBench parser-bench [folder]" << std::endl
+             << "        Benchmark the BMFont and .mat text front ends against a ReadString reference (files are written to folder; default: working directory)" << std::endl
+             << "    NyaBench shadowatlas-test" << std::endl
+             << "        Test the shadow atlas tile allocator and the cached face updates of moving lights" << std::endl
+             << "    NyaBench sh-test" << std::endl
+             << "        Test the SH9 cubemap irradiance projection against analytic and brute force references" << std::endl
+             << "    NyaBench tlsf-bench" << std::endl
+             << "        Replay a synthetic asset load/unload trace with the TLSF and free list allocators (allocations are checked for corruption)" << std::endl;
+}
+
+BaseAllocator* nya::bench::CreateHeap( const std::size_t size )
+{
+    void* heapBaseAddress = nya::core::malloc( size );
+    return new TLSFAllocator( size, heapBaseAddress );
+}
+
+void nya::bench::DestroyHeap( BaseAllocator* allocator )
+{
+    void* heapBaseAddress = allocator->getBaseAddress();
+
+    delete allocator;
+    nya::core::free( heapBaseAddress );
+}
+
+bool nya::bench::Check( const bool condition, const char* description, const char* filename, const int line )
+{
+    if ( !condition ) {
+        NYA_COUT << "[FAILED] " << filename << ":" << line << " >> " << description << std::endl;
+    }
+
+    return condition;
+}
+
+int main( int argc, char** argv )
+{
+    if ( argc >= 2 && strcmp( argv[1], "dynres-test" ) == 0 ) {
+        return RunDynamicResolutionTest( argc - 2, argv + 2 );
+    }
+
+    if ( argc >= 2 && strcmp( argv[1], "hashtable-bench" ) == 0 ) {
+        return RunHashTableBench( argc - 2, argv + 2 );
+    }
+
+    if ( argc >= 2 && strcmp( argv[1], "lightgrid-test" ) == 0 ) {
+        return RunLightGridTest( argc - 2, argv + 2 );
+    }
+
+    if ( argc >= 2 && strcmp( argv[1], "lightindex-bench" ) == 0 ) {
+        return RunLightSpatialIndexBench( argc - 2, argv + 2 );
+    }
+
+    if ( argc >= 2 && strcmp( argv[1], "loader-bench" ) == 0 ) {
+        return RunLoaderBench( argc - 2, argv + 2 );
+    }
+
+    if ( argc >= 2 && strcmp( argv[1], "parser-bench" ) == 0 ) {
+        return RunParserBench( argc - 2, argv + 2 );
+    }
+
+    if ( argc >= 2 && strcmp( argv[1], "shadowatlas-test" ) == 0 ) {
+        return RunShadowAtlasTest( argc - 2, argv + 2 );
+    }
+
+    if ( argc >= 2 && strcmp( argv[1], "sh-test" ) == 0 ) {
+        return RunSphericalHarmonicsTest( argc - 2, argv + 2 );
+    }
+
+    if ( argc >= 2 && strcmp( argv[1], "tlsf-bench" ) == 0 ) {
+        return RunTLSFAllocatorBench( argc - 2, argv + 2 );
+    }
+
+    PrintUsage();
+    return 1;
+}
@@ -0,0 +1,48 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+class BaseAllocator;
+
+// Benchmarks and tests entry points (return the process exit code)
+int RunDynamicResolutionTest( int argc, char** argv );
+int RunHashTableBench( int argc, char** argv );
+int RunLightGridTest( int argc, char** argv );
+int RunLightSpatialIndexBench( int argc, char** argv );
+int RunLoaderBench( int argc, char** argv );
+int RunParserBench( int argc, char** argv );
+int RunShadowAtlasTest( int argc, char** argv );
+int RunSphericalHarmonicsTest( int argc, char** argv );
+int RunTLSFAllocatorBench( int argc, char** argv );
+
+namespace nya
+{
+    namespace bench
+    {
+        // Heap backed by a TLSF allocator (released by DestroyHeap)
+        BaseAllocator*  CreateHeap( const std::size_t size );
+        void            DestroyHeap( BaseAllocator* allocator );
+
+        // Log the failed check; returns the check result
+        bool            Check( const bool condition, const char* description, const char* filename, const int line );
+    }
+}
+
+#define NYA_BENCH_CHECK( condition ) nya::bench::Check( ( condition ), #condition, __FILE__, __LINE__ )
@@ -0,0 +1,407 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "NyaBench.h"
+
+#include <FileSystem/FileSystemNative.h>
+#include <FileSystem/FileSystemObject.h>
+#include <Io/FontDescriptor.h>
+#include <Io/TextStreamHelpers.h>
+#include <Io/TextStreamReader.h>
+
+#include <Core/Timer.h>
+#include <Core/StringHelpers.h>
+
+#include <random>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+static constexpr uint32_t   GLYPH_COUNT = 60000u;
+static constexpr uint32_t   MATERIAL_LINE_COUNT = 240000u;
+static constexpr uint32_t   PARSE_COUNT = 5u;
+
+// Key/value pairs read by a .mat front end (the material loader reads values from these)
+struct MaterialFrontEndResult
+{
+    uint32_t    pairCount;
+    uint32_t    keyChecksum; // Sum of the key hashcodes
+    uint64_t    valueLength; // Sum of the value lengths
+};
+
+static bool WriteFile( FileSystemNative& fileSystem, const nyaString_t& filename, const std::string& content )
+{
+    FileSystemObject* file = fileSystem.openFile( filename, nya::core::eFileOpenMode::FILE_OPEN_MODE_WRITE | nya::core::eFileOpenMode::FILE_OPEN_MODE_BINARY | nya::core::eFileOpenMode::FILE_OPEN_MODE_TRUNCATE );
+    if ( file == nullptr || !file->isOpen() ) {
+        return false;
+    }
+
+    file->writeString( content );
+    file->close();
+
+    return true;
+}
+
+// BMFont text descriptor (same layout as the files exported by BMFont)
+static void BuildFontFile( std::string& content, std::vector<FontDescriptor::Glyph>& glyphes, std::mt19937& randomGenerator )
+{
+    std::uniform_int_distribution<int32_t> positionDistribution( 0, 4095 );
+    std::uniform_int_distribution<int32_t> sizeDistribution( 1, 64 );
+    std::uniform_int_distribution<int32_t> offsetDistribution( -8, 8 );
+
+    content = "info face=\"Bench\" size=32 bold=0 italic=0 charset=\"\" unicode=1 stretchH=100 smooth=1 aa=1 padding=0,0,0,0 spacing=1,1 outline=0\n"
+              "common lineHeight=32 base=26 scaleW=4096 scaleH=4096 pages=1 packed=0 alphaChnl=1 redChnl=0 greenChnl=0 blueChnl=0\n"
+              "page id=0 file=\"Bench_0.dds\"\n"
+              "chars count=" + std::to_string( GLYPH_COUNT ) + "\n";
+
+    glyphes.resize( GLYPH_COUNT );
+
+    char line[256];
+    for ( uint32_t glyphIndex = 0u; glyphIndex < GLYPH_COUNT; glyphIndex++ ) {
+        FontDescriptor::Glyph& glyph = glyphes[glyphIndex];
+        glyph.PositionX = positionDistribution( randomGenerator );
+        glyph.PositionY = positionDistribution( randomGenerator );
+        glyph.Width = sizeDistribution( randomGenerator );
+        glyph.Height = sizeDistribution( randomGenerator );
+        glyph.OffsetX = offsetDistribution( randomGenerator );
+        glyph.OffsetY = offsetDistribution( randomGenerator );
+        glyph.AdvanceX = sizeDistribution( randomGenerator );
+
+        snprintf( line, sizeof( line ), "char id=%-4u x=%-5i y=%-5i width=%-5i height=%-5i xoffset=%-5i yoffset=%-5i xadvance=%-5i page=0  chnl=15\n",
+                  glyphIndex, glyph.PositionX, glyph.PositionY, glyph.Width, glyph.Height, glyph.OffsetX, glyph.OffsetY, glyph.AdvanceX );
+
+        content += line;
+    }
+}
+
+// Material layers repeated until the line count is reached (comments, blank lines and nested blocks included)
+static void BuildMaterialFile( std::string& content )
+{
+    static constexpr const char* MATERIAL_HEADER =
+        "Name: \"Bench Material\"\n"
+        "Version: 1\n"
+        "\n"
+        "ShadingModel: SHADING_MODEL_STANDARD\n"
+        "WriteVelocity: True\n"
+        "EnableAlphaTest: False\n"
+        "CastShadow: True ; Shadow casting\n"
+        "ReceiveShadow: True\n";
+
+    static constexpr const char* MATERIAL_LAYER =
+        "Layer \n"
+        "{\n"
+        "    BaseColor: { 0.42, 0.42, 0.42 } ;\"GameData/textures/default.dds\"\n"
+        "    AlphaMask: None\n"
+        "    Reflectance: 1.00\n"
+        "    Refraction: 0.000000\n"
+        "    RefractionIor: 0.000000\n"
+        "    Metalness: 0.000000\n"
+        "    AmbientOcclusion: None\n"
+        "    Normal: \"GameData/textures/default_normal.dds\"\n"
+        "    Roughness: 0.50\n"
+        "    Emissivity: 0.000000\n"
+        "\n"
+        "    Offset: { 0, 0 }\n"
+        "    Scale: { 1, 1 }\n"
+        "}\n"
+        "\n";
+
+    static constexpr uint32_t MATERIAL_HEADER_LINE_COUNT = 8u;
+    static constexpr uint32_t MATERIAL_LAYER_LINE_COUNT = 17u;
+
+    content = MATERIAL_HEADER;
+
+    for ( uint32_t lineCount = MATERIAL_HEADER_LINE_COUNT; lineCount < MATERIAL_LINE_COUNT; lineCount += MATERIAL_LAYER_LINE_COUNT ) {
+        content += MATERIAL_LAYER;
+    }
+}
+
+// Reference front ends: lines are read character per character with nya::core::ReadString, then split with substr
+// (what the text parsers did before TextStreamReader)
+static void ParseFontFileReference( FileSystemObject* file, std::vector<FontDescriptor::Glyph>& glyphes )
+{
+    nyaString_t streamLine, lineToken, variable, key, value;
+
+    while ( file->isGood() ) {
+        nya::core::ReadString( file, streamLine );
+
+        const auto tagSeparator = streamLine.find_first_of( ' ' );
+        if ( tagSeparator == nyaString_t::npos ) {
+            continue;
+        }
+
+        lineToken = streamLine.substr( 0, tagSeparator );
+        nya::core::TrimString( lineToken );
+
+        if ( nya::core::CRC32( lineToken.c_str() ) != NYA_STRING_HASH( "char" ) ) {
+            continue;
+        }
+
+        FontDescriptor::Glyph* glyph = nullptr;
+
+        std::size_t variableOffset = tagSeparator + 1;
+        while ( variableOffset < streamLine.size() ) {
+            std::size_t variableEnd = streamLine.find( ' ', variableOffset );
+            if ( variableEnd == nyaString_t::npos ) {
+                variableEnd = streamLine.size();
+            }
+
+            variable = streamLine.substr( variableOffset, variableEnd - variableOffset );
+            variableOffset = variableEnd + 1;
+
+            const auto keyValueSeparator = variable.find_first_of( '=' );
+            if ( keyValueSeparator == nyaString_t::npos ) {
+                continue;
+            }
+
+            key = variable.substr( 0, keyValueSeparator );
+            value = variable.substr( keyValueSeparator + 1 );
+
+            switch ( nya::core::CRC32( key.c_str() ) ) {
+            case NYA_STRING_HASH( "id" ): {
+                const std::size_t glyphIndex = static_cast<std::size_t>( std::stoi( value ) );
+                if ( glyphIndex >= glyphes.size() ) {
+                    glyphes.resize( glyphIndex + 1 );
+                }
+
+                glyph = &glyphes[glyphIndex];
+            } break;
+            case NYA_STRING_HASH( "x" ):
+                glyph->PositionX = std::stoi( value );
+                break;
+            case NYA_STRING_HASH( "y" ):
+                glyph->PositionY = std::stoi( value );
+                break;
+            case NYA_STRING_HASH( "width" ):
+                glyph->Width = std::stoi( value );
+                break;
+            case NYA_STRING_HASH( "height" ):
+                glyph->Height = std::stoi( value );
+                break;
+            case NYA_STRING_HASH( "xoffset" ):
+                glyph->OffsetX = std::stoi( value );
+                break;
+            case NYA_STRING_HASH( "yoffset" ):
+                glyph->OffsetY = std::stoi( value );
+                break;
+            case NYA_STRING_HASH( "xadvance" ):
+                glyph->AdvanceX = std::stoi( value );
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    file->close();
+}
+
+static void ParseMaterialFileReference( FileSystemObject* file, MaterialFrontEndResult& result )
+{
+    nyaString_t streamLine, dictionaryKey, dictionaryValue;
+
+    while ( file->isGood() ) {
+        nya::core::ReadString( file, streamLine );
+
+        const auto commentSeparator = streamLine.find_first_of( ';' );
+        if ( commentSeparator != nyaString_t::npos ) {
+            streamLine.erase( streamLine.begin() + static_cast<long>( commentSeparator ), streamLine.end() );
+        }
+
+        const auto keyValueSeparator = streamLine.find_first_of( ':' );
+        if ( keyValueSeparator == nyaString_t::npos ) {
+            continue;
+        }
+
+        dictionaryKey = streamLine.substr( 0, keyValueSeparator );
+        dictionaryValue = streamLine.substr( keyValueSeparator + 1 );
+
+        nya::core::TrimString( dictionaryKey );
+        nya::core::TrimString( dictionaryValue );
+
+        if ( !dictionaryValue.empty() ) {
+            result.pairCount++;
+            result.keyChecksum += nya::core::CRC32( dictionaryKey.c_str() );
+            result.valueLength += dictionaryValue.size();
+        }
+    }
+
+    file->close();
+}
+
+// Same front end as the material loader (see Material::load)
+static void ParseMaterialFile( FileSystemObject* file, MaterialFrontEndResult& result )
+{
+    TextStreamReader streamReader( file );
+    TextToken streamLine, dictionaryKey, dictionaryValueToken;
+    nyaString_t dictionaryValue;
+
+    while ( streamReader.readLine( streamLine ) ) {
+        streamLine.end = streamLine.find( ';' );
+
+        if ( !streamLine.split( ':', dictionaryKey, dictionaryValueToken ) ) {
+            continue;
+        }
+
+        dictionaryKey = dictionaryKey.trim();
+        dictionaryValueToken = dictionaryValueToken.trim();
+
+        if ( !dictionaryValueToken.empty() ) {
+            dictionaryValueToken.toString( dictionaryValue );
+
+            result.pairCount++;
+            result.keyChecksum += dictionaryKey.hash();
+            result.valueLength += dictionaryValue.size();
+        }
+    }
+
+    file->close();
+}
+
+static bool AreGlyphesEqual( const std::vector<FontDescriptor::Glyph>& glyphes, const std::vector<FontDescriptor::Glyph>& expectedGlyphes )
+{
+    if ( glyphes.size() != expectedGlyphes.size() ) {
+        return false;
+    }
+
+    for ( std::size_t i = 0; i < glyphes.size(); i++ ) {
+        const FontDescriptor::Glyph& glyph = glyphes[i];
+        const FontDescriptor::Glyph& expectedGlyph = expectedGlyphes[i];
+
+        if ( glyph.PositionX != expectedGlyph.PositionX || glyph.PositionY != expectedGlyph.PositionY
+          || glyph.Width != expectedGlyph.Width || glyph.Height != expectedGlyph.Height
+          || glyph.OffsetX != expectedGlyph.OffsetX || glyph.OffsetY != expectedGlyph.OffsetY
+          || glyph.AdvanceX != expectedGlyph.AdvanceX ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Returns the average time per parse (in milliseconds; opening the file is part of the parse)
+template<typename Parser>
+static double MeasureParseTime( FileSystemNative& fileSystem, const nyaString_t& filename, const int32_t openMode, Parser parser )
+{
+    Timer timer = {};
+    nya::core::StartTimer( &timer );
+
+    for ( uint32_t i = 0u; i < PARSE_COUNT; i++ ) {
+        FileSystemObject* file = fileSystem.openFile( filename, openMode );
+        if ( file == nullptr ) {
+            return 0.0;
+        }
+
+        parser( file );
+    }
+
+    return nya::core::GetTimerDeltaAsMiliseconds( &timer ) / PARSE_COUNT;
+}
+
+int RunParserBench( int argc, char** argv )
+{
+    // Files are written to the working directory (unless a folder is given)
+    const std::string folder = ( argc >= 1 ) ? std::string( argv[0] ) + "/" : std::string();
+    const std::string fontFilename = folder + "NyaBench_ParserBench.fnt";
+    const std::string materialFilename = folder + "NyaBench_ParserBench.mat";
+
+    const nyaString_t fontPath( fontFilename.begin(), fontFilename.end() );
+    const nyaString_t materialPath( materialFilename.begin(), materialFilename.end() );
+
+    // Fixed seed so that runs are comparable
+    std::mt19937 randomGenerator( 1337u );
+
+    std::string fontContent, materialContent;
+    std::vector<FontDescriptor::Glyph> expectedGlyphes;
+    BuildFontFile( fontContent, expectedGlyphes, randomGenerator );
+    BuildMaterialFile( materialContent );
+
+    FileSystemNative fileSystem;
+    if ( !WriteFile( fileSystem, fontPath, fontContent ) || !WriteFile( fileSystem, materialPath, materialContent ) ) {
+        NYA_CERR << "Failed to write the parser benchmark files to '" << folder << "'" << std::endl;
+        return 1;
+    }
+
+    const int32_t streamOpenMode = nya::core::eFileOpenMode::FILE_OPEN_MODE_READ | nya::core::eFileOpenMode::FILE_OPEN_MODE_BINARY;
+    const int32_t mappedOpenMode = streamOpenMode | nya::core::eFileOpenMode::FILE_OPEN_MODE_MEMORY_MAPPED;
+
+    int failureCount = 0;
+
+    // BMFont descriptor
+    std::vector<FontDescriptor::Glyph> referenceGlyphes;
+    const double fontReferenceTime = MeasureParseTime( fileSystem, fontPath, streamOpenMode, [&]( FileSystemObject* file ) {
+        referenceGlyphes.clear();
+        ParseFontFileReference( file, referenceGlyphes );
+    } );
+
+    FontDescriptor fontDescriptor;
+    const double fontStreamTime = MeasureParseTime( fileSystem, fontPath, streamOpenMode, [&]( FileSystemObject* file ) {
+        fontDescriptor = {};
+        nya::core::LoadFontFile( file, fontDescriptor );
+    } );
+
+    failureCount += !NYA_BENCH_CHECK( AreGlyphesEqual( fontDescriptor.Glyphes, expectedGlyphes ) );
+    failureCount += !NYA_BENCH_CHECK( fontDescriptor.AtlasWidth == 4096u && fontDescriptor.AtlasHeight == 4096u );
+
+    const double fontMappedTime = MeasureParseTime( fileSystem, fontPath, mappedOpenMode, [&]( FileSystemObject* file ) {
+        fontDescriptor = {};
+        nya::core::LoadFontFile( file, fontDescriptor );
+    } );
+
+    failureCount += !NYA_BENCH_CHECK( AreGlyphesEqual( fontDescriptor.Glyphes, expectedGlyphes ) );
+    failureCount += !NYA_BENCH_CHECK( AreGlyphesEqual( referenceGlyphes, expectedGlyphes ) );
+
+    // .mat front end
+    MaterialFrontEndResult referenceResult = {}, streamResult = {}, mappedResult = {};
+    const double materialReferenceTime = MeasureParseTime( fileSystem, materialPath, streamOpenMode, [&]( FileSystemObject* file ) {
+        referenceResult = {};
+        ParseMaterialFileReference( file, referenceResult );
+    } );
+
+    const double materialStreamTime = MeasureParseTime( fileSystem, materialPath, streamOpenMode, [&]( FileSystemObject* file ) {
+        streamResult = {};
+        ParseMaterialFile( file, streamResult );
+    } );
+
+    const double materialMappedTime = MeasureParseTime( fileSystem, materialPath, mappedOpenMode, [&]( FileSystemObject* file ) {
+        mappedResult = {};
+        ParseMaterialFile( file, mappedResult );
+    } );
+
+    failureCount += !NYA_BENCH_CHECK( referenceResult.pairCount > 0u );
+    failureCount += !NYA_BENCH_CHECK( streamResult.pairCount == referenceResult.pairCount && streamResult.keyChecksum == referenceResult.keyChecksum && streamResult.valueLength == referenceResult.valueLength );
+    failureCount += !NYA_BENCH_CHECK( mappedResult.pairCount == referenceResult.pairCount && mappedResult.keyChecksum == referenceResult.keyChecksum && mappedResult.valueLength == referenceResult.valueLength );
+
+    remove( fontFilename.c_str() );
+    remove( materialFilename.c_str() );
+
+    NYA_COUT << "ms per parse (ReadString reference / TextStreamReader / TextStreamReader mapped)" << std::endl
+             << "    BMFont, " << GLYPH_COUNT << " glyphs (" << ( fontContent.size() >> 10 ) << " KB): "
+             << fontReferenceTime << " / " << fontStreamTime << " / " << fontMappedTime << std::endl
+             << "    .mat front end, " << MATERIAL_LINE_COUNT << " lines (" << ( materialContent.size() >> 10 ) << " KB): "
+             << materialReferenceTime << " / " << materialStreamTime << " / " << materialMappedTime << std::endl;
+
+    if ( failureCount > 0 ) {
+        NYA_COUT << "Parser: " << failureCount << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "NyaBench.h"
+
+#include <Graphics/ShadowAtlas.h>
+
+#include <random>
+#include <vector>
+
+static constexpr uint32_t ATLAS_DIMENSION = 1024u;
+static constexpr uint32_t MIN_TILE_DIMENSION = 64u;
+
+static bool AreTilesOverlapping( const ShadowAtlasTile& left, const ShadowAtlasTile& right )
+{
+    return left.X < right.X + right.Size && right.X < left.X + left.Size
+        && left.Y < right.Y + right.Size && right.Y < left.Y + left.Size;
+}
+
+static bool IsTileInsideAtlas( const ShadowAtlasTile& tile )
+{
+    return ( tile.X + tile.Size ) <= ATLAS_DIMENSION && ( tile.Y + tile.Size ) <= ATLAS_DIMENSION;
+}
+
+static int TestAllocatorFill()
+{
+    int failureCount = 0;
+
+    ShadowAtlasAllocator allocator;
+    allocator.create( ATLAS_DIMENSION, MIN_TILE_DIMENSION );
+
+    // Dimensions are rounded up to the next power of two (and clamped to the min tile dimension)
+    ShadowAtlasTile tile = {};
+    failureCount += !NYA_BENCH_CHECK( allocator.allocate( 100u, tile ) && tile.Size == 128u );
+    allocator.free( tile );
+
+    failureCount += !NYA_BENCH_CHECK( allocator.allocate( 1u, tile ) && tile.Size == MIN_TILE_DIMENSION );
+    allocator.free( tile );
+
+    failureCount += !NYA_BENCH_CHECK( !allocator.allocate( ATLAS_DIMENSION * 2u, tile ) );
+    failureCount += !NYA_BENCH_CHECK( allocator.getAllocatedTileCount() == 0u && allocator.getAllocatedArea() == 0u );
+
+    // Fill the atlas with min size tiles
+    constexpr uint32_t MAX_TILE_COUNT = ( ATLAS_DIMENSION / MIN_TILE_DIMENSION ) * ( ATLAS_DIMENSION / MIN_TILE_DIMENSION );
+
+    std::vector<ShadowAtlasTile> tiles;
+    while ( allocator.allocate( MIN_TILE_DIMENSION, tile ) ) {
+        tiles.push_back( tile );
+    }
+
+    failureCount += !NYA_BENCH_CHECK( tiles.size() == MAX_TILE_COUNT );
+    failureCount += !NYA_BENCH_CHECK( allocator.getAllocatedArea() == ATLAS_DIMENSION * ATLAS_DIMENSION );
+
+    bool areTilesValid = true;
+    for ( size_t i = 0; i < tiles.size(); i++ ) {
+        areTilesValid &= IsTileInsideAtlas( tiles[i] );
+
+        for ( size_t j = i + 1; j < tiles.size(); j++ ) {
+            areTilesValid &= !AreTilesOverlapping( tiles[i], tiles[j] );
+        }
+    }
+    failureCount += !NYA_BENCH_CHECK( areTilesValid );
+
+    // Freeing every tile must merge the quadtree back (a full atlas tile should fit)
+    for ( const ShadowAtlasTile& allocatedTile : tiles ) {
+        allocator.free( allocatedTile );
+    }
+
+    failureCount += !NYA_BENCH_CHECK( allocator.getAllocatedTileCount() == 0u && allocator.getAllocatedArea() == 0u );
+    failureCount += !NYA_BENCH_CHECK( allocator.allocate( ATLAS_DIMENSION, tile ) && tile.X == 0u && tile.Y == 0u );
+
+    return failureCount;
+}
+
+static int TestAllocatorRandom()
+{
+    int failureCount = 0;
+
+    ShadowAtlasAllocator allocator;
+    allocator.create( ATLAS_DIMENSION, MIN_TILE_DIMENSION );
+
+    std::mt19937 randomGenerator( 1337u );
+    std::uniform_int_distribution<uint32_t> levelDistribution( 0u, 4u );
+
+    std::vector<ShadowAtlasTile> tiles;
+    bool areTilesValid = true;
+    uint32_t expectedArea = 0u;
+
+    for ( uint32_t i = 0u; i < 4096u; i++ ) {
+        // Free a random tile every other iteration once the atlas is busy
+        if ( !tiles.empty() && ( randomGenerator() % 2u ) == 0u ) {
+            const size_t tileIdx = randomGenerator() % tiles.size();
+
+            allocator.free( tiles[tileIdx] );
+            expectedArea -= tiles[tileIdx].Size * tiles[tileIdx].Size;
+
+            tiles[tileIdx] = tiles.back();
+            tiles.pop_back();
+            continue;
+        }
+
+        ShadowAtlasTile tile = {};
+        if ( !allocator.allocate( MIN_TILE_DIMENSION << levelDistribution( randomGenerator ), tile ) ) {
+            continue;
+        }
+
+        areTilesValid &= IsTileInsideAtlas( tile );
+        for ( const ShadowAtlasTile& allocatedTile : tiles ) {
+            areTilesValid &= !AreTilesOverlapping( tile, allocatedTile );
+        }
+
+        tiles.push_back( tile );
+        expectedArea += tile.Size * tile.Size;
+    }
+
+    failureCount += !NYA_BENCH_CHECK( areTilesValid );
+    failureCount += !NYA_BENCH_CHECK( allocator.getAllocatedArea() == expectedArea );
+    failureCount += !NYA_BENCH_CHECK( allocator.getAllocatedTileCount() == tiles.size() );
+
+    for ( const ShadowAtlasTile& allocatedTile : tiles ) {
+        allocator.free( allocatedTile );
+    }
+
+    ShadowAtlasTile tile = {};
+    failureCount += !NYA_BENCH_CHECK( allocator.allocate( ATLAS_DIMENSION, tile ) );
+
+    return failureCount;
+}
+
+static int TestMovedLightFaces()
+{
+    int failureCount = 0;
+
+    ShadowAtlas shadowAtlas;
+    shadowAtlas.create( ATLAS_DIMENSION, MIN_TILE_DIMENSION, 256u );
+
+    LocalShadowRequest request = {};
+    request.LightIndex = 0u;
+    request.WorldPosition = nyaVec3f( 0.0f, 0.0f, 0.0f );
+    request.Radius = 10.0f;
+    request.ScreenFootprint = 256.0f;
+    request.FaceCount = 6u;
+
+    LocalShadowFaceUpdate updates[ShadowAtlas::MAX_FACE_COUNT];
+
+    // Render every face once
+    failureCount += !NYA_BENCH_CHECK( shadowAtlas.update( &request, 1u, updates, 6u ) == 6u );
+
+    const int32_t slotIndex = shadowAtlas.findSlot( 0u );
+    failureCount += !NYA_BENCH_CHECK( slotIndex >= 0 );
+    if ( slotIndex < 0 ) {
+        return failureCount;
+    }
+
+    const ShadowAtlas::Slot& slot = shadowAtlas.getSlot( static_cast<uint32_t>( slotIndex ) );
+    failureCount += !NYA_BENCH_CHECK( slot.HasValidTiles && slot.DirtyFaceMask == 0u );
+
+    // Move the light with a budget of two faces per frame: faces which are not rendered yet must keep the transform they
+    // have been rendered with
+    request.WorldPosition = nyaVec3f( 5.0f, 0.0f, 0.0f );
+    request.Radius = 12.0f;
+
+    failureCount += !NYA_BENCH_CHECK( shadowAtlas.update( &request, 1u, updates, 2u ) == 2u );
+    failureCount += !NYA_BENCH_CHECK( slot.HasValidTiles && slot.DirtyFaceMask == 0x3Cu );
+
+    bool areCaptureTransformsValid = true;
+    for ( uint32_t faceIdx = 0u; faceIdx < 6u; faceIdx++ ) {
+        const bool isUpdated = ( faceIdx < 2u );
+
+        areCaptureTransformsValid &= ( slot.FaceCapturePositions[faceIdx].x == ( isUpdated ? 5.0f : 0.0f ) );
+        areCaptureTransformsValid &= ( slot.FaceCaptureRadii[faceIdx] == ( isUpdated ? 12.0f : 10.0f ) );
+    }
+    failureCount += !NYA_BENCH_CHECK( areCaptureTransformsValid );
+
+    // The remaining faces are rendered over the next frames
+    failureCount += !NYA_BENCH_CHECK( shadowAtlas.update( &request, 1u, updates, 2u ) == 2u );
+    failureCount += !NYA_BENCH_CHECK( shadowAtlas.update( &request, 1u, updates, 2u ) == 2u );
+    failureCount += !NYA_BENCH_CHECK( slot.DirtyFaceMask == 0u && slot.FaceCapturePositions[5].x == 5.0f );
+    failureCount += !NYA_BENCH_CHECK( shadowAtlas.update( &request, 1u, updates, 2u ) == 0u );
+
+    // A new slot is not sampled until every face has been rendered once
+    LocalShadowRequest newRequest = request;
+    newRequest.LightIndex = 1u;
+
+    LocalShadowRequest requests[2] = { request, newRequest };
+    shadowAtlas.update( requests, 2u, updates, 3u );
+
+    const int32_t newSlotIndex = shadowAtlas.findSlot( 1u );
+    failureCount += !NYA_BENCH_CHECK( newSlotIndex >= 0 && !shadowAtlas.getSlot( static_cast<uint32_t>( newSlotIndex ) ).HasValidTiles );
+
+    return failureCount;
+}
+
+int RunShadowAtlasTest( int argc, char** argv )
+{
+    int failureCount = 0;
+    failureCount += TestAllocatorFill();
+    failureCount += TestAllocatorRandom();
+    failureCount += TestMovedLightFaces();
+
+    if ( failureCount > 0 ) {
+        NYA_COUT << "ShadowAtlas: " << failureCount << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    NYA_COUT << "ShadowAtlas: all checks passed" << std::endl;
+    return 0;
+}
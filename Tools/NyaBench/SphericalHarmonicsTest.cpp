@@ -0,0 +1,218 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "NyaBench.h"
+
+#include <Maths/SphericalHarmonics.h>
+#include <Maths/Helpers.h>
+
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+using RadianceFunction_t = std::function<nyaVec3f( const nyaVec3f& )>;
+
+// Face basis (X, Y, Z) of the D3D cubemap faces (+X, -X, +Y, -Y, +Z, -Z); texel direction is Z + u * X + v * Y
+static constexpr float CUBE_FACE_AXIS[6][9] = {
+    { 0.0f, 0.0f, -1.0f,    0.0f, 1.0f, 0.0f,   1.0f, 0.0f, 0.0f },
+    { 0.0f, 0.0f, 1.0f,     0.0f, 1.0f, 0.0f,   -1.0f, 0.0f, 0.0f },
+    { 1.0f, 0.0f, 0.0f,     0.0f, 0.0f, -1.0f,  0.0f, 1.0f, 0.0f },
+    { 1.0f, 0.0f, 0.0f,     0.0f, 0.0f, 1.0f,   0.0f, -1.0f, 0.0f },
+    { 1.0f, 0.0f, 0.0f,     0.0f, 1.0f, 0.0f,   0.0f, 0.0f, 1.0f },
+    { -1.0f, 0.0f, 0.0f,    0.0f, 1.0f, 0.0f,   0.0f, 0.0f, -1.0f },
+};
+
+struct Cubemap
+{
+    std::vector<float>  Faces[6];
+    const float*        FacePointers[6];
+    uint32_t            FaceSize;
+};
+
+static void CreateCubemap( Cubemap& cubemap, const uint32_t faceSize, const RadianceFunction_t& radiance )
+{
+    cubemap.FaceSize = faceSize;
+
+    const float texelSize = 2.0f / static_cast<float>( faceSize );
+
+    for ( uint32_t faceIdx = 0u; faceIdx < 6u; faceIdx++ ) {
+        const float* axis = CUBE_FACE_AXIS[faceIdx];
+
+        std::vector<float>& texels = cubemap.Faces[faceIdx];
+        texels.resize( faceSize * faceSize * 4u );
+
+        for ( uint32_t y = 0u; y < faceSize; y++ ) {
+            const float v = 1.0f - ( static_cast<float>( y ) + 0.5f ) * texelSize;
+
+            for ( uint32_t x = 0u; x < faceSize; x++ ) {
+                const float u = ( static_cast<float>( x ) + 0.5f ) * texelSize - 1.0f;
+
+                const nyaVec3f direction = nyaVec3f(
+                    axis[6] + u * axis[0] + v * axis[3],
+                    axis[7] + u * axis[1] + v * axis[4],
+                    axis[8] + u * axis[2] + v * axis[5] ).normalize();
+
+                const nyaVec3f texelRadiance = radiance( direction );
+
+                float* texel = &texels[( y * faceSize + x ) * 4u];
+                texel[0] = texelRadiance.x;
+                texel[1] = texelRadiance.y;
+                texel[2] = texelRadiance.z;
+                texel[3] = 1.0f;
+            }
+        }
+
+        cubemap.FacePointers[faceIdx] = texels.data();
+    }
+}
+
+static nya::maths::SH9 ComputeIrradiance( const Cubemap& cubemap )
+{
+    nya::maths::SH9Projection projection;
+    nya::maths::SH9ClearProjection( projection );
+
+    for ( uint32_t faceIdx = 0u; faceIdx < 6u; faceIdx++ ) {
+        nya::maths::SH9ProjectCubemapFace( projection, cubemap.FacePointers[faceIdx], cubemap.FaceSize, faceIdx );
+    }
+
+    return nya::maths::SH9ComputeIrradiance( projection );
+}
+
+static std::vector<nyaVec3f> CreateTestDirections()
+{
+    std::vector<nyaVec3f> directions = {
+        nyaVec3f( 1.0f, 0.0f, 0.0f ), nyaVec3f( -1.0f, 0.0f, 0.0f ),
+        nyaVec3f( 0.0f, 1.0f, 0.0f ), nyaVec3f( 0.0f, -1.0f, 0.0f ),
+        nyaVec3f( 0.0f, 0.0f, 1.0f ), nyaVec3f( 0.0f, 0.0f, -1.0f ),
+    };
+
+    std::mt19937 randomGenerator( 1337u );
+    std::normal_distribution<float> normalDistribution( 0.0f, 1.0f );
+
+    for ( uint32_t i = 0u; i < 26u; i++ ) {
+        directions.push_back( nyaVec3f( normalDistribution( randomGenerator ), normalDistribution( randomGenerator ), normalDistribution( randomGenerator ) ).normalize() );
+    }
+
+    return directions;
+}
+
+static float ComputeMaxRelativeError( const nyaVec3f& value, const nyaVec3f& reference )
+{
+    float maxError = 0.0f;
+    for ( int channel = 0; channel < 3; channel++ ) {
+        maxError = nya::maths::max( maxError, std::fabs( value[channel] - reference[channel] ) / nya::maths::max( std::fabs( reference[channel] ), 1e-4f ) );
+    }
+
+    return maxError;
+}
+
+// Constant and linear radiance are exactly represented by the first two SH bands; the only error left is the cubemap discretization
+static int TestAnalyticIrradiance( const uint32_t faceSize )
+{
+    constexpr float TOLERANCE = 1e-3f;
+
+    int failureCount = 0;
+
+    const std::vector<nyaVec3f> directions = CreateTestDirections();
+
+    // Constant radiance L: irradiance / PI = L
+    const nyaVec3f constantRadiance( 0.5f, 1.0f, 2.0f );
+
+    Cubemap constantCubemap;
+    CreateCubemap( constantCubemap, faceSize, [&]( const nyaVec3f& ) { return constantRadiance; } );
+
+    const nya::maths::SH9 constantIrradiance = ComputeIrradiance( constantCubemap );
+
+    float maxConstantError = 0.0f;
+    for ( const nyaVec3f& direction : directions ) {
+        maxConstantError = nya::maths::max( maxConstantError, ComputeMaxRelativeError( nya::maths::SH9Evaluate( constantIrradiance, direction ), constantRadiance ) );
+    }
+    failureCount += !NYA_BENCH_CHECK( maxConstantError < TOLERANCE );
+
+    // Linear radiance L(w) = a + dot(b, w): irradiance / PI = a + 2/3 * dot(b, n)
+    const nyaVec3f a( 1.0f, 2.0f, 0.5f );
+    const nyaVec3f b( 0.3f, -0.2f, 0.4f );
+
+    Cubemap linearCubemap;
+    CreateCubemap( linearCubemap, faceSize, [&]( const nyaVec3f& direction ) { return a + nyaVec3f( 1.0f, 1.5f, 0.25f ) * nyaVec3f::dot( b, direction ); } );
+
+    const nya::maths::SH9 linearIrradiance = ComputeIrradiance( linearCubemap );
+
+    float maxLinearError = 0.0f, maxReferenceError = 0.0f;
+    for ( const nyaVec3f& direction : directions ) {
+        const nyaVec3f expectedIrradiance = a + nyaVec3f( 1.0f, 1.5f, 0.25f ) * ( nyaVec3f::dot( b, direction ) * ( 2.0f / 3.0f ) );
+
+        maxLinearError = nya::maths::max( maxLinearError, ComputeMaxRelativeError( nya::maths::SH9Evaluate( linearIrradiance, direction ), expectedIrradiance ) );
+
+        // The brute force reference should converge to the same value
+        const nyaVec3f referenceIrradiance = nya::maths::ComputeCubemapIrradianceReference( linearCubemap.FacePointers, faceSize, direction );
+        maxReferenceError = nya::maths::max( maxReferenceError, ComputeMaxRelativeError( referenceIrradiance, expectedIrradiance ) );
+    }
+    failureCount += !NYA_BENCH_CHECK( maxLinearError < TOLERANCE );
+    failureCount += !NYA_BENCH_CHECK( maxReferenceError < TOLERANCE );
+
+    NYA_COUT << "SH9 (" << faceSize << "x" << faceSize << " faces): constant error " << maxConstantError << "; linear error " << maxLinearError
+             << "; reference error " << maxReferenceError << std::endl;
+
+    return failureCount;
+}
+
+// Sky gradient with a sun lobe; order 2 SH is only an approximation of the irradiance (a few percents of error are expected)
+static int TestReferenceIrradiance()
+{
+    constexpr uint32_t FACE_SIZE = 32u;
+    constexpr float TOLERANCE = 0.1f;
+
+    const nyaVec3f sunDirection = nyaVec3f( 0.3f, 0.8f, 0.5f ).normalize();
+
+    Cubemap cubemap;
+    CreateCubemap( cubemap, FACE_SIZE, [&]( const nyaVec3f& direction ) {
+        const float sunIntensity = std::pow( nya::maths::max( 0.0f, nyaVec3f::dot( direction, sunDirection ) ), 4.0f );
+        const float skyGradient = 0.5f + 0.5f * direction.y;
+
+        return nyaVec3f( 0.2f, 0.4f, 0.8f ) * skyGradient + nyaVec3f( 4.0f, 3.5f, 3.0f ) * sunIntensity + nyaVec3f( 0.05f, 0.05f, 0.05f );
+    } );
+
+    const nya::maths::SH9 irradiance = ComputeIrradiance( cubemap );
+    const float maxError = nya::maths::SH9ComputeIrradianceError( irradiance, cubemap.FacePointers, FACE_SIZE, 64u );
+
+    NYA_COUT << "SH9 (sky and sun): max relative error " << maxError << " against the brute force convolution" << std::endl;
+
+    return !NYA_BENCH_CHECK( maxError < TOLERANCE );
+}
+
+int RunSphericalHarmonicsTest( int argc, char** argv )
+{
+    int failureCount = 0;
+
+    // 30 is not a multiple of the SIMD width (covers the scalar remainder)
+    failureCount += TestAnalyticIrradiance( 32u );
+    failureCount += TestAnalyticIrradiance( 30u );
+    failureCount += TestReferenceIrradiance();
+
+    if ( failureCount > 0 ) {
+        NYA_COUT << "SphericalHarmonics: " << failureCount << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    NYA_COUT << "SphericalHarmonics: all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,232 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+#include "NyaBench.h"
+
+#include <Core/Allocators/TLSFAllocator.h>
+#include <Core/Allocators/FreeListAllocator.h>
+#include <Core/Timer.h>
+
+#include <cmath>
+#include <random>
+#include <string.h>
+#include <vector>
+
+static constexpr std::size_t    HEAP_SIZE = 32 * 1024 * 1024;
+static constexpr uint32_t       TRACE_OPERATION_COUNT = 136000u;
+static constexpr std::size_t    MIN_ALLOCATION_SIZE = 32;
+static constexpr std::size_t    MAX_ALLOCATION_SIZE = 256 * 1024;
+
+// Unload bursts start once the live allocations go above this part of the heap (asset streaming heap usage when switching areas)
+static constexpr double         MAX_HEAP_OCCUPANCY = 0.6;
+
+struct TraceOperation
+{
+    uint32_t        allocationIndex;
+    uint32_t        size; // 0 if the operation frees the allocation
+    uint8_t         alignment;
+};
+
+// Synthetic asset load/unload trace: assets are loaded until the occupancy limit is reached, then a random part of them is unloaded
+static void BuildTrace( std::vector<TraceOperation>& trace, std::mt19937& randomGenerator )
+{
+    // Log-uniform sizes (many small materials, fewer large meshes)
+    std::uniform_real_distribution<double> sizeDistribution( std::log( static_cast<double>( MIN_ALLOCATION_SIZE ) ), std::log( static_cast<double>( MAX_ALLOCATION_SIZE ) ) );
+    std::uniform_real_distribution<double> unloadDistribution( 0.25, 0.75 );
+
+    static constexpr uint8_t ALIGNMENTS[4] = { 8u, 16u, 16u, 64u };
+
+    std::vector<uint32_t> liveAllocations;
+    std::vector<uint32_t> allocationSizes;
+    std::size_t liveSize = 0;
+
+    while ( trace.size() < TRACE_OPERATION_COUNT ) {
+        const uint32_t size = static_cast<uint32_t>( std::exp( sizeDistribution( randomGenerator ) ) );
+
+        if ( ( liveSize + size ) > static_cast<std::size_t>( HEAP_SIZE * MAX_HEAP_OCCUPANCY ) ) {
+            const std::size_t unloadCount = static_cast<std::size_t>( liveAllocations.size() * unloadDistribution( randomGenerator ) );
+
+            for ( std::size_t i = 0; i < unloadCount && trace.size() < TRACE_OPERATION_COUNT; i++ ) {
+                std::uniform_int_distribution<std::size_t> liveAllocationDistribution( 0, liveAllocations.size() - 1 );
+                const std::size_t liveIndex = liveAllocationDistribution( randomGenerator );
+                const uint32_t allocationIndex = liveAllocations[liveIndex];
+
+                liveAllocations[liveIndex] = liveAllocations.back();
+                liveAllocations.pop_back();
+
+                liveSize -= allocationSizes[allocationIndex];
+                trace.push_back( { allocationIndex, 0u, 0u } );
+            }
+
+            continue;
+        }
+
+        const uint32_t allocationIndex = static_cast<uint32_t>( allocationSizes.size() );
+        allocationSizes.push_back( size );
+        liveAllocations.push_back( allocationIndex );
+        liveSize += size;
+
+        trace.push_back( { allocationIndex, size, ALIGNMENTS[randomGenerator() & 3u] } );
+    }
+
+    // Unload everything left (each allocation should be merged back)
+    for ( const uint32_t allocationIndex : liveAllocations ) {
+        trace.push_back( { allocationIndex, 0u, 0u } );
+    }
+}
+
+struct ReplayResult
+{
+    double      operationTime; // Nanoseconds per operation
+    uint32_t    failedAllocationCount;
+    uint32_t    corruptedAllocationCount;
+    uint32_t    misalignedAllocationCount;
+};
+
+// Each allocation is tagged with its index (first and last bytes); tags are checked when the allocation is freed
+static void ReplayTrace( BaseAllocator* allocator, const std::vector<TraceOperation>& trace, const uint32_t allocationCount, ReplayResult& result, const uint32_t midTraceOperationIndex, TLSFAllocator* tlsfAllocator )
+{
+    std::vector<uint8_t*> allocations( allocationCount, nullptr );
+    std::vector<uint32_t> allocationSizes( allocationCount, 0u );
+
+    result = {};
+
+    Timer timer = {};
+    nya::core::StartTimer( &timer );
+
+    for ( uint32_t operationIndex = 0u; operationIndex < static_cast<uint32_t>( trace.size() ); operationIndex++ ) {
+        const TraceOperation& operation = trace[operationIndex];
+
+        if ( operation.size != 0u ) {
+            uint8_t* allocation = static_cast<uint8_t*>( allocator->allocate( operation.size, operation.alignment ) );
+
+            if ( allocation == nullptr ) {
+                result.failedAllocationCount++;
+                continue;
+            }
+
+            if ( ( reinterpret_cast<uintptr_t>( allocation ) & ( operation.alignment - 1u ) ) != 0u ) {
+                result.misalignedAllocationCount++;
+            }
+
+            memcpy( allocation, &operation.allocationIndex, sizeof( uint32_t ) );
+            memcpy( allocation + operation.size - sizeof( uint32_t ), &operation.allocationIndex, sizeof( uint32_t ) );
+
+            allocations[operation.allocationIndex] = allocation;
+            allocationSizes[operation.allocationIndex] = operation.size;
+        } else {
+            uint8_t* allocation = allocations[operation.allocationIndex];
+
+            if ( allocation == nullptr ) {
+                continue;
+            }
+
+            uint32_t headTag = 0u, tailTag = 0u;
+            memcpy( &headTag, allocation, sizeof( uint32_t ) );
+            memcpy( &tailTag, allocation + allocationSizes[operation.allocationIndex] - sizeof( uint32_t ), sizeof( uint32_t ) );
+
+            if ( headTag != operation.allocationIndex || tailTag != operation.allocationIndex ) {
+                result.corruptedAllocationCount++;
+            }
+
+            allocator->free( allocation );
+            allocations[operation.allocationIndex] = nullptr;
+        }
+
+        // Fragmentation metrics scan the bins (not timed)
+        if ( operationIndex == midTraceOperationIndex && tlsfAllocator != nullptr ) {
+            result.operationTime += nya::core::GetTimerDeltaAsMiliseconds( &timer );
+
+            NYA_COUT << "TLSFAllocator mid-trace: " << tlsfAllocator->getMemoryUsage() << " bytes used; " << tlsfAllocator->getFreeBlockCount() << " free blocks; "
+                     << "largest free block " << tlsfAllocator->getLargestFreeBlockSize() << " bytes; fragmentation " << tlsfAllocator->getFragmentation() << std::endl;
+
+            nya::core::GetTimerDeltaAsMiliseconds( &timer );
+        }
+    }
+
+    result.operationTime += nya::core::GetTimerDeltaAsMiliseconds( &timer );
+    result.operationTime *= 1000000.0 / trace.size();
+}
+
+static int CheckReplayResult( const char* allocatorName, const ReplayResult& result, const BaseAllocator* allocator )
+{
+    NYA_COUT << allocatorName << ": " << result.operationTime << " ns/op; " << result.failedAllocationCount << " failed allocation(s); "
+             << result.corruptedAllocationCount << " corrupted allocation(s)" << std::endl;
+
+    int failureCount = 0;
+    failureCount += !NYA_BENCH_CHECK( result.corruptedAllocationCount == 0u );
+    failureCount += !NYA_BENCH_CHECK( result.misalignedAllocationCount == 0u );
+    failureCount += !NYA_BENCH_CHECK( allocator->getAllocationCount() == 0u );
+
+    return failureCount;
+}
+
+int RunTLSFAllocatorBench( int argc, char** argv )
+{
+    // Fixed seed so that runs are comparable
+    std::mt19937 randomGenerator( 1337u );
+
+    std::vector<TraceOperation> trace;
+    BuildTrace( trace, randomGenerator );
+
+    uint32_t allocationCount = 0u;
+    for ( const TraceOperation& operation : trace ) {
+        allocationCount += ( operation.size != 0u ) ? 1u : 0u;
+    }
+
+    NYA_COUT << "Trace: " << trace.size() << " operations (" << allocationCount << " allocations) on a " << ( HEAP_SIZE >> 20 ) << "MB heap" << std::endl;
+
+    // Pre-fault the heap so that page faults are not part of the timings
+    void* heapBaseAddress = nya::core::malloc( HEAP_SIZE );
+
+    int failureCount = 0;
+    ReplayResult result = {};
+
+    {
+        memset( heapBaseAddress, 0, HEAP_SIZE );
+
+        TLSFAllocator tlsfAllocator( HEAP_SIZE, heapBaseAddress );
+        ReplayTrace( &tlsfAllocator, trace, allocationCount, result, TRACE_OPERATION_COUNT / 2u, &tlsfAllocator );
+
+        failureCount += CheckReplayResult( "TLSFAllocator", result, &tlsfAllocator );
+        failureCount += !NYA_BENCH_CHECK( result.failedAllocationCount == 0u );
+
+        // Every block should have been merged back
+        failureCount += !NYA_BENCH_CHECK( tlsfAllocator.getFreeBlockCount() == 1u );
+    }
+
+    {
+        memset( heapBaseAddress, 0, HEAP_SIZE );
+
+        FreeListAllocator freeListAllocator( HEAP_SIZE, heapBaseAddress );
+        ReplayTrace( &freeListAllocator, trace, allocationCount, result, 0u, nullptr );
+
+        failureCount += CheckReplayResult( "FreeListAllocator", result, &freeListAllocator );
+    }
+
+    nya::core::free( heapBaseAddress );
+
+    if ( failureCount > 0 ) {
+        NYA_COUT << "TLSFAllocator: " << failureCount << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
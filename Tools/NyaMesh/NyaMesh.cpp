@@ -0,0 +1,528 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+
+#include <FileSystem/FileSystemNative.h>
+#include <FileSystem/FileSystemObject.h>
+
+#include <Io/Mesh.h>
+#include <Io/MeshFile.h>
+
+#include <Maths/AABB.h>
+#include <Maths/Helpers.h>
+#include <Maths/Packing.h>
+
+#include <Core/Timer.h>
+#include <Core/StringHelpers.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include <string.h>
+
+using namespace nya::core;
+
+static constexpr int BENCHMARK_RUN_COUNT = 8;
+
+static void PrintUsage()
+{
+    NYA_COUT << "Usage:" << std::endl
+             << "    NyaMesh compact <input mesh> <output mesh> [--quantize-positions]" << std::endl
+             << "        Convert a mesh to the compact format (half uvs, octahedral normals and 16 bits indices when they fit)" << std::endl
+             << "        then compare both files (--quantize-positions: store 16 bits positions relative to the submesh bounds)" << std::endl
+             << "    NyaMesh compare <mesh> <other mesh>" << std::endl
+             << "        Compare the size, load time and content of two meshes" << std::endl;
+}
+
+static nyaString_t ToNativeString( const char* string )
+{
+    return nyaString_t( string, string + strlen( string ) );
+}
+
+static bool ReadMeshHeader( FileSystemNative& fileSystem, const nyaString_t& filename, MeshFileHeader& header, uint64_t& fileSize )
+{
+    FileSystemObject* file = fileSystem.openFile( filename, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY );
+    if ( file == nullptr ) {
+        NYA_CERR << "'" << filename << "': failed to open mesh" << std::endl;
+        return false;
+    }
+
+    fileSize = file->getSize();
+
+    header = {};
+    if ( fileSize >= sizeof( MeshFileHeader ) ) {
+        file->read( header );
+    }
+
+    file->close();
+
+    if ( fileSize < sizeof( MeshFileHeader ) || header.fileSize > fileSize ) {
+        NYA_CERR << "'" << filename << "': not a mesh file" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// Load a mesh the way the asset cache does (loaded data might point to the file content until the file is closed)
+static FileSystemObject* LoadMesh( FileSystemNative& fileSystem, const nyaString_t& filename, GeomLoadData& data )
+{
+    FileSystemObject* file = fileSystem.openFile( filename, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY | eFileOpenMode::FILE_OPEN_MODE_MEMORY_MAPPED );
+    if ( file == nullptr ) {
+        NYA_CERR << "'" << filename << "': failed to open mesh" << std::endl;
+        return nullptr;
+    }
+
+    LoadGeometryFile( file, data );
+
+    return file;
+}
+
+static uint32_t GetIndice( const GeomLoadData& data, const std::size_t indiceIdx )
+{
+    if ( data.indiceStride == sizeof( uint16_t ) ) {
+        return static_cast<const uint16_t*>( data.indiceBuffer )[indiceIdx];
+    }
+
+    return static_cast<const uint32_t*>( data.indiceBuffer )[indiceIdx];
+}
+
+template<typename T>
+static void Append( std::vector<uint8_t>& content, const T& value )
+{
+    const uint8_t* valueBytes = reinterpret_cast<const uint8_t*>( &value );
+    content.insert( content.end(), valueBytes, valueBytes + sizeof( T ) );
+}
+
+template<typename T>
+static void Patch( std::vector<uint8_t>& content, const std::size_t offset, const T& value )
+{
+    memcpy( &content[offset], &value, sizeof( T ) );
+}
+
+static void AppendPadding( std::vector<uint8_t>& content )
+{
+    while ( content.size() % MESH_BLOCK_ALIGNMENT != 0 ) {
+        content.push_back( 0xFF );
+    }
+}
+
+// Vertices used by each submesh; submeshes sharing vertices share the same range (a vertex is dequantized with a single range)
+static std::vector<MeshVertexRange> BuildVertexRanges( const GeomLoadData& data, const uint32_t vertexScalarCount, const uint32_t vertexCount )
+{
+    std::vector<MeshVertexRange> vertexRanges( data.subMesh.size() );
+    std::vector<std::size_t> rangeOrder( data.subMesh.size() );
+
+    for ( std::size_t subMeshIdx = 0; subMeshIdx < data.subMesh.size(); subMeshIdx++ ) {
+        const GeomLoadData::SubMesh& subMesh = data.subMesh[subMeshIdx];
+
+        uint32_t firstVertex = vertexCount;
+        uint32_t lastVertex = 0u;
+        for ( uint32_t indiceIdx = 0u; indiceIdx < subMesh.indiceCount; indiceIdx++ ) {
+            const uint32_t vertexIdx = GetIndice( data, subMesh.indiceBufferOffset + indiceIdx );
+            firstVertex = nya::maths::min( firstVertex, vertexIdx );
+            lastVertex = nya::maths::max( lastVertex, vertexIdx );
+        }
+
+        vertexRanges[subMeshIdx].vertexOffset = ( firstVertex <= lastVertex ) ? firstVertex : 0u;
+        vertexRanges[subMeshIdx].vertexCount = ( firstVertex <= lastVertex ) ? ( lastVertex - firstVertex + 1u ) : 0u;
+        rangeOrder[subMeshIdx] = subMeshIdx;
+    }
+
+    // Merge overlapping ranges
+    std::sort( rangeOrder.begin(), rangeOrder.end(), [&]( const std::size_t left, const std::size_t right ) {
+        return vertexRanges[left].vertexOffset < vertexRanges[right].vertexOffset;
+    } );
+
+    for ( std::size_t rangeIdx = 0; rangeIdx < rangeOrder.size(); ) {
+        uint32_t mergedBegin = vertexRanges[rangeOrder[rangeIdx]].vertexOffset;
+        uint32_t mergedEnd = mergedBegin + vertexRanges[rangeOrder[rangeIdx]].vertexCount;
+
+        std::size_t mergedRangeEnd = rangeIdx + 1;
+        while ( mergedRangeEnd < rangeOrder.size() && vertexRanges[rangeOrder[mergedRangeEnd]].vertexOffset < mergedEnd ) {
+            const MeshVertexRange& vertexRange = vertexRanges[rangeOrder[mergedRangeEnd]];
+            mergedEnd = nya::maths::max( mergedEnd, vertexRange.vertexOffset + vertexRange.vertexCount );
+            mergedRangeEnd++;
+        }
+
+        nyaVec3f positionMin = nyaVec3f::Max;
+        nyaVec3f positionMax = -nyaVec3f::Max;
+        for ( uint32_t vertexIdx = mergedBegin; vertexIdx < mergedEnd; vertexIdx++ ) {
+            const float* position = data.vertexBuffer + static_cast<std::size_t>( vertexIdx ) * vertexScalarCount;
+            for ( int i = 0; i < 3; i++ ) {
+                positionMin[i] = nya::maths::min( positionMin[i], position[i] );
+                positionMax[i] = nya::maths::max( positionMax[i], position[i] );
+            }
+        }
+
+        for ( ; rangeIdx < mergedRangeEnd; rangeIdx++ ) {
+            MeshVertexRange& vertexRange = vertexRanges[rangeOrder[rangeIdx]];
+            vertexRange.vertexOffset = mergedBegin;
+            vertexRange.vertexCount = mergedEnd - mergedBegin;
+            vertexRange.positionMin = ( mergedBegin < mergedEnd ) ? positionMin : nyaVec3f( 0.0f, 0.0f, 0.0f );
+            vertexRange.positionRange = ( mergedBegin < mergedEnd ) ? ( positionMax - positionMin ) : nyaVec3f( 0.0f, 0.0f, 0.0f );
+        }
+    }
+
+    return vertexRanges;
+}
+
+static void AppendCompactVertex( std::vector<uint8_t>& content, const MeshFileHeader& header, const float* vertex, const MeshVertexRange& vertexRange )
+{
+    if ( header.hasQuantizedPositions == 1 ) {
+        for ( int i = 0; i < 3; i++ ) {
+            const float normalizedPosition = ( vertexRange.positionRange[i] > 0.0f ) ? ( vertex[i] - vertexRange.positionMin[i] ) / vertexRange.positionRange[i] : 0.0f;
+            Append( content, nya::maths::PackUnorm16( normalizedPosition ) );
+        }
+    } else {
+        for ( int i = 0; i < 3; i++ ) {
+            Append( content, vertex[i] );
+        }
+    }
+
+    vertex += 3;
+
+    if ( header.hasNormals == 1 ) {
+        const nyaVec2f encodedNormal = nya::maths::EncodeOctahedral( nyaVec3f( vertex[0], vertex[1], vertex[2] ) );
+        Append( content, nya::maths::PackSnorm16( encodedNormal.x ) );
+        Append( content, nya::maths::PackSnorm16( encodedNormal.y ) );
+        vertex += 3;
+    }
+
+    if ( header.hasUvMap0 == 1 ) {
+        Append( content, nya::maths::PackHalf( vertex[0] ) );
+        Append( content, nya::maths::PackHalf( vertex[1] ) );
+    }
+}
+
+static std::vector<uint8_t> BuildCompactMesh( const MeshFileHeader& sourceHeader, const GeomLoadData& data, const bool quantizePositions )
+{
+    const uint32_t vertexScalarCount = GetDecodedVertexScalarCount( sourceHeader );
+    const uint32_t vertexCount = static_cast<uint32_t>( data.vertexBufferSize / ( vertexScalarCount * sizeof( float ) ) );
+    const std::size_t indiceCount = data.indiceBufferSize / data.indiceStride;
+
+    MeshFileHeader header = {};
+    header.version = MESH_VERSION_COMPACT;
+    header.hasUvMap0 = sourceHeader.hasUvMap0;
+    header.hasNormals = sourceHeader.hasNormals;
+    header.hasQuantizedPositions = ( quantizePositions ) ? 1 : 0;
+
+    std::vector<uint8_t> content;
+    Append( content, header );
+
+    if ( !data.materialsReferences.empty() ) {
+        const std::size_t blockHeaderOffset = content.size();
+        Append( content, MeshBlockHeader{ MESH_MATL_MAGIC, 0u, 0u, 0u } );
+
+        const std::size_t blockStart = content.size();
+        for ( const auto& materialReference : data.materialsReferences ) {
+            const std::string materialName = WideStringToString( materialReference.second );
+
+            Append( content, materialReference.first );
+            content.insert( content.end(), materialName.begin(), materialName.end() );
+            content.push_back( '\0' );
+        }
+
+        Patch( content, blockHeaderOffset, MeshBlockHeader{ MESH_MATL_MAGIC, static_cast<uint32_t>( content.size() - blockStart ), 0u, 0u } );
+        AppendPadding( content );
+    }
+
+    const std::vector<MeshVertexRange> vertexRanges = BuildVertexRanges( data, vertexScalarCount, vertexCount );
+
+    std::vector<MeshVertexRange> packedRanges;
+    for ( const MeshVertexRange& vertexRange : vertexRanges ) {
+        if ( vertexRange.vertexCount != 0u ) {
+            packedRanges.push_back( vertexRange );
+        }
+    }
+
+    std::sort( packedRanges.begin(), packedRanges.end(), []( const MeshVertexRange& left, const MeshVertexRange& right ) {
+        return left.vertexOffset < right.vertexOffset;
+    } );
+    packedRanges.erase( std::unique( packedRanges.begin(), packedRanges.end(), []( const MeshVertexRange& left, const MeshVertexRange& right ) {
+        return left.vertexOffset == right.vertexOffset;
+    } ), packedRanges.end() );
+
+    // Pack the vertices range by range; identical compact vertices of a range are merged (older exporters duplicated the
+    // vertices of every triangle). Vertices outside of every range are not referenced by any submesh and are dropped
+    std::vector<MeshVertexRange> subMeshRanges = vertexRanges;
+    std::vector<uint32_t> vertexRemap( vertexCount, 0u );
+    std::vector<uint8_t> compactVertices;
+    std::vector<uint8_t> compactVertex;
+    std::unordered_map<std::string, uint32_t> uniqueVertices;
+    uint32_t compactVertexCount = 0u;
+
+    for ( const MeshVertexRange& packedRange : packedRanges ) {
+        const uint32_t firstCompactVertex = compactVertexCount;
+        uniqueVertices.clear();
+
+        for ( uint32_t vertexIdx = packedRange.vertexOffset; vertexIdx < packedRange.vertexOffset + packedRange.vertexCount; vertexIdx++ ) {
+            compactVertex.clear();
+            AppendCompactVertex( compactVertex, header, data.vertexBuffer + static_cast<std::size_t>( vertexIdx ) * vertexScalarCount, packedRange );
+
+            auto insertion = uniqueVertices.insert( std::make_pair( std::string( compactVertex.begin(), compactVertex.end() ), compactVertexCount ) );
+            if ( insertion.second ) {
+                compactVertices.insert( compactVertices.end(), compactVertex.begin(), compactVertex.end() );
+                compactVertexCount++;
+            }
+
+            vertexRemap[vertexIdx] = insertion.first->second;
+        }
+
+        for ( std::size_t subMeshIdx = 0; subMeshIdx < vertexRanges.size(); subMeshIdx++ ) {
+            if ( vertexRanges[subMeshIdx].vertexCount != 0u && vertexRanges[subMeshIdx].vertexOffset == packedRange.vertexOffset ) {
+                subMeshRanges[subMeshIdx].vertexOffset = firstCompactVertex;
+                subMeshRanges[subMeshIdx].vertexCount = compactVertexCount - firstCompactVertex;
+            }
+        }
+    }
+
+    header.hasShortIndices = ( compactVertexCount <= ( UINT16_MAX + 1u ) ) ? 1 : 0;
+
+    const std::size_t blockHeaderOffset = content.size();
+    Append( content, MeshBlockHeader{} );
+
+    const std::size_t subMeshesStart = content.size();
+    for ( std::size_t subMeshIdx = 0; subMeshIdx < data.subMesh.size(); subMeshIdx++ ) {
+        const GeomLoadData::SubMesh& subMesh = data.subMesh[subMeshIdx];
+        const std::string subMeshName = WideStringToString( subMesh.name );
+
+        Append( content, subMesh.hashcode );
+        content.insert( content.end(), subMeshName.begin(), subMeshName.end() );
+        content.push_back( '\0' );
+        Append( content, subMesh.indiceBufferOffset );
+        Append( content, subMesh.indiceCount );
+        Append( content, subMesh.boundingSphere );
+        Append( content, nya::maths::GetAABBCentroid( subMesh.aabb ) );
+        Append( content, nya::maths::GetAABBHalfExtents( subMesh.aabb ) );
+        Append( content, subMesh.levelOfDetailIndex );
+        Append( content, subMeshRanges[subMeshIdx] );
+        AppendPadding( content );
+    }
+
+    MeshBlockHeader geometryBlockHeader = {};
+    geometryBlockHeader.magic = MESH_GEOM_MAGIC;
+    geometryBlockHeader.size = static_cast<uint32_t>( content.size() - subMeshesStart );
+
+    content.insert( content.end(), compactVertices.begin(), compactVertices.end() );
+    geometryBlockHeader.subBlock1Size = static_cast<uint32_t>( compactVertices.size() );
+
+    // Keep indices aligned (in place usage)
+    while ( content.size() % sizeof( uint32_t ) != 0 ) {
+        content.push_back( 0xFF );
+        geometryBlockHeader.subBlock1Size++;
+    }
+
+    const std::size_t indicesStart = content.size();
+    for ( std::size_t indiceIdx = 0; indiceIdx < indiceCount; indiceIdx++ ) {
+        const uint32_t vertexIdx = GetIndice( data, indiceIdx );
+        const uint32_t indice = ( vertexIdx < vertexCount ) ? vertexRemap[vertexIdx] : 0u;
+
+        if ( header.hasShortIndices == 1 ) {
+            Append( content, static_cast<uint16_t>( indice ) );
+        } else {
+            Append( content, indice );
+        }
+    }
+    geometryBlockHeader.subBlock2Size = static_cast<uint32_t>( content.size() - indicesStart );
+
+    Patch( content, blockHeaderOffset, geometryBlockHeader );
+    AppendPadding( content );
+
+    header.fileSize = static_cast<uint32_t>( content.size() );
+    Patch( content, 0, header );
+
+    return content;
+}
+
+// Best of several runs; the buffers are copied to a staging buffer (stands for the upload done by the asset cache)
+static double BenchmarkLoad( FileSystemNative& fileSystem, const nyaString_t& filename )
+{
+    std::vector<uint8_t> stagingBuffer;
+    double loadTime = 1e9;
+
+    for ( int runIdx = 0; runIdx < BENCHMARK_RUN_COUNT; runIdx++ ) {
+        Timer timer;
+        StartTimer( &timer );
+        {
+            GeomLoadData data;
+            FileSystemObject* file = LoadMesh( fileSystem, filename, data );
+            if ( file == nullptr ) {
+                return 0.0;
+            }
+
+            stagingBuffer.resize( data.vertexBufferSize + data.indiceBufferSize );
+            memcpy( stagingBuffer.data(), data.vertexBuffer, data.vertexBufferSize );
+            memcpy( stagingBuffer.data() + data.vertexBufferSize, data.indiceBuffer, data.indiceBufferSize );
+
+            file->close();
+        }
+        loadTime = std::min( loadTime, GetTimerDeltaAsMiliseconds( &timer ) );
+    }
+
+    return loadTime;
+}
+
+static int CompareMeshes( const nyaString_t& filename, const nyaString_t& otherFilename )
+{
+    FileSystemNative fileSystem;
+
+    MeshFileHeader header, otherHeader;
+    uint64_t fileSize = 0ull, otherFileSize = 0ull;
+    if ( !ReadMeshHeader( fileSystem, filename, header, fileSize ) || !ReadMeshHeader( fileSystem, otherFilename, otherHeader, otherFileSize ) ) {
+        return 1;
+    }
+
+    GeomLoadData data, otherData;
+    FileSystemObject* file = LoadMesh( fileSystem, filename, data );
+    FileSystemObject* otherFile = LoadMesh( fileSystem, otherFilename, otherData );
+
+    if ( file == nullptr || otherFile == nullptr ) {
+        return 1;
+    }
+
+    // Decoded triangles should match (up to the quantization error); vertices are compared through the indices since
+    // duplicated vertices might have been merged
+    const uint32_t vertexScalarCount = GetDecodedVertexScalarCount( header );
+    const std::size_t vertexCount = data.vertexBufferSize / ( vertexScalarCount * sizeof( float ) );
+    const std::size_t otherVertexCount = otherData.vertexBufferSize / ( vertexScalarCount * sizeof( float ) );
+    const std::size_t indiceCount = data.indiceBufferSize / data.indiceStride;
+
+    const bool isLayoutMatching = ( header.hasNormals == otherHeader.hasNormals && header.hasUvMap0 == otherHeader.hasUvMap0 )
+        && otherData.indiceBufferSize / otherData.indiceStride == indiceCount
+        && otherData.subMesh.size() == data.subMesh.size();
+
+    if ( isLayoutMatching ) {
+        float maxPositionError = 0.0f;
+        float maxNormalError = 0.0f;
+        float maxUvError = 0.0f;
+
+        for ( std::size_t indiceIdx = 0; indiceIdx < indiceCount; indiceIdx++ ) {
+            const uint32_t vertexIdx = GetIndice( data, indiceIdx );
+            const uint32_t otherVertexIdx = GetIndice( otherData, indiceIdx );
+
+            if ( vertexIdx >= vertexCount || otherVertexIdx >= otherVertexCount ) {
+                NYA_CWARN << "Indice " << indiceIdx << " is out of bounds" << std::endl;
+                continue;
+            }
+
+            const float* vertex = data.vertexBuffer + static_cast<std::size_t>( vertexIdx ) * vertexScalarCount;
+            const float* otherVertex = otherData.vertexBuffer + static_cast<std::size_t>( otherVertexIdx ) * vertexScalarCount;
+
+            for ( int i = 0; i < 3; i++ ) {
+                maxPositionError = nya::maths::max( maxPositionError, nya::maths::abs( vertex[i] - otherVertex[i] ) );
+            }
+
+            uint32_t scalarIdx = 3u;
+            if ( header.hasNormals == 1 ) {
+                const nyaVec3f normal( vertex[scalarIdx], vertex[scalarIdx + 1], vertex[scalarIdx + 2] );
+                const nyaVec3f otherNormal( otherVertex[scalarIdx], otherVertex[scalarIdx + 1], otherVertex[scalarIdx + 2] );
+
+                // Skip degenerated normals
+                if ( normal.length() > 0.5f ) {
+                    const float cosAngle = nya::maths::clamp( nyaVec3f::dot( normal.normalize(), otherNormal ), -1.0f, 1.0f );
+                    maxNormalError = nya::maths::max( maxNormalError, nya::maths::degrees( acosf( cosAngle ) ) );
+                }
+
+                scalarIdx += 3u;
+            }
+
+            if ( header.hasUvMap0 == 1 ) {
+                maxUvError = nya::maths::max( maxUvError, nya::maths::abs( vertex[scalarIdx] - otherVertex[scalarIdx] ) );
+                maxUvError = nya::maths::max( maxUvError, nya::maths::abs( vertex[scalarIdx + 1] - otherVertex[scalarIdx + 1] ) );
+            }
+        }
+
+        NYA_COUT << indiceCount << " indices; " << data.subMesh.size() << " submeshes" << std::endl
+                 << "    Max position error: " << maxPositionError << std::endl
+                 << "    Max normal error:   " << maxNormalError << " degrees" << std::endl
+                 << "    Max uv error:       " << maxUvError << std::endl;
+    } else {
+        NYA_CWARN << "Meshes layout don't match (content is not compared)" << std::endl;
+    }
+
+    file->close();
+    otherFile->close();
+
+    const double loadTime = BenchmarkLoad( fileSystem, filename );
+    const double otherLoadTime = BenchmarkLoad( fileSystem, otherFilename );
+
+    NYA_COUT << "    '" << filename << "' (version " << header.version << "; " << vertexCount << " vertices; " << ( data.indiceStride * 8u ) << " bits indices): "
+             << fileSize << " bytes; " << loadTime << " ms" << std::endl
+             << "    '" << otherFilename << "' (version " << otherHeader.version << "; " << otherVertexCount << " vertices; " << ( otherData.indiceStride * 8u ) << " bits indices): "
+             << otherFileSize << " bytes ("
+             << ( ( fileSize != 0ull ) ? static_cast<double>( otherFileSize ) * 100.0 / static_cast<double>( fileSize ) : 0.0 ) << "%); " << otherLoadTime << " ms" << std::endl;
+
+    return 0;
+}
+
+static int CompactMesh( const nyaString_t& inputFilename, const nyaString_t& outputFilename, const bool quantizePositions )
+{
+    FileSystemNative fileSystem;
+
+    MeshFileHeader header;
+    uint64_t fileSize = 0ull;
+    if ( !ReadMeshHeader( fileSystem, inputFilename, header, fileSize ) ) {
+        return 1;
+    }
+
+    if ( header.version < 2 ) {
+        NYA_CERR << "'" << inputFilename << "': version " << header.version << " meshes can't be converted (re-export the mesh)" << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> compactContent;
+    {
+        GeomLoadData data;
+        FileSystemObject* file = LoadMesh( fileSystem, inputFilename, data );
+        if ( file == nullptr ) {
+            return 1;
+        }
+
+        compactContent = BuildCompactMesh( header, data, quantizePositions );
+        file->close();
+    }
+
+    FileSystemObject* outputFile = fileSystem.openFile( outputFilename, eFileOpenMode::FILE_OPEN_MODE_WRITE | eFileOpenMode::FILE_OPEN_MODE_BINARY | eFileOpenMode::FILE_OPEN_MODE_TRUNCATE );
+    if ( outputFile == nullptr ) {
+        NYA_CERR << "'" << outputFilename << "': failed to open mesh for writing" << std::endl;
+        return 1;
+    }
+
+    outputFile->write( compactContent.data(), compactContent.size() );
+    outputFile->close();
+
+    return CompareMeshes( inputFilename, outputFilename );
+}
+
+int main( int argc, char** argv )
+{
+    if ( argc >= 4 && strcmp( argv[1], "compact" ) == 0 ) {
+        const bool quantizePositions = ( argc >= 5 && strcmp( argv[4], "--quantize-positions" ) == 0 );
+        return CompactMesh( ToNativeString( argv[2] ), ToNativeString( argv[3] ), quantizePositions );
+    }
+
+    if ( argc >= 4 && strcmp( argv[1], "compare" ) == 0 ) {
+        return CompareMeshes( ToNativeString( argv[2] ), ToNativeString( argv[3] ) );
+    }
+
+    PrintUsage();
+    return 1;
+}
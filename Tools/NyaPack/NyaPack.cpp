@@ -0,0 +1,317 @@
+/*
+    Project Nya Source Code
+    Copyright (C) 2018 Prvost Baptiste
+
+    This file is part of Project Nya source code.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Shared.h>
+
+#include <FileSystem/FileSystemNative.h>
+#include <FileSystem/FileSystemPack.h>
+#include <FileSystem/FileSystemObject.h>
+#include <FileSystem/VirtualFileSystem.h>
+#include <FileSystem/PackFile.h>
+
+#if NYA_UNIX
+#include <FileSystem/FileSystemUnix.h>
+#elif NYA_WIN
+#include <FileSystem/FileSystemWin32.h>
+#endif
+
+#include <Core/Compression/LZ4.h>
+#include <Core/Timer.h>
+#include <Core/StringHelpers.h>
+
+#include <algorithm>
+#include <vector>
+#include <string.h>
+
+using namespace nya::core;
+
+// Entries are only stored compressed if they shrink by at least 1/8 (decompression is not free)
+static constexpr uint64_t MIN_COMPRESSION_GAIN_DIVISOR = 8ull;
+static constexpr int BENCHMARK_RUN_COUNT = 3;
+
+static void PrintUsage()
+{
+    NYA_COUT << "Usage:" << std::endl
+             << "    NyaPack pack <input folder> <output pack> [--lz4]" << std::endl
+             << "        Pack every file of the input folder (--lz4: compress entries with LZ4 when it is worth it)" << std::endl
+             << "    NyaPack bench <input folder> <pack>" << std::endl
+             << "        Compare the time needed to open and read every file loose and packed" << std::endl;
+}
+
+static nyaString_t ToNativeString( const char* string )
+{
+    return nyaString_t( string, string + strlen( string ) );
+}
+
+static nyaString_t GetFolderPath( const nyaString_t& folderName )
+{
+    return ( !folderName.empty() && folderName.back() != '/' && folderName.back() != '\\' ) ? folderName + NYA_STRING( "/" ) : folderName;
+}
+
+static bool ReadFileContent( FileSystemNative& fileSystem, const nyaString_t& filename, std::vector<uint8_t>& content )
+{
+    FileSystemObject* file = fileSystem.openFile( filename, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY );
+    if ( file == nullptr ) {
+        return false;
+    }
+
+    content.resize( static_cast<std::size_t>( file->getSize() ) );
+    if ( !content.empty() ) {
+        file->read( content.data(), content.size() );
+    }
+
+    file->close();
+
+    return true;
+}
+
+static void WritePadding( FileSystemObject* packFile, uint64_t& packOffset, const uint64_t alignment )
+{
+    static constexpr uint8_t PADDING[PACK_ENTRY_ALIGNMENT] = {};
+
+    const uint64_t paddingSize = ( alignment - ( packOffset % alignment ) ) % alignment;
+    packFile->write( const_cast<uint8_t*>( PADDING ), paddingSize );
+    packOffset += paddingSize;
+}
+
+static int BuildPack( const nyaString_t& inputFolder, const nyaString_t& packFilename, const bool useCompression )
+{
+    const nyaString_t folderPath = GetFolderPath( inputFolder );
+
+    std::vector<nyaString_t> filenames;
+    ListFolderContentImpl( folderPath, filenames );
+
+    // Sort names to produce the same pack from the same content
+    std::sort( filenames.begin(), filenames.end() );
+
+    if ( filenames.empty() ) {
+        NYA_CERR << "'" << inputFolder << "': nothing to pack" << std::endl;
+        return 1;
+    }
+
+    FileSystemNative fileSystem;
+    FileSystemObject* packFile = fileSystem.openFile( packFilename, eFileOpenMode::FILE_OPEN_MODE_WRITE | eFileOpenMode::FILE_OPEN_MODE_BINARY | eFileOpenMode::FILE_OPEN_MODE_TRUNCATE );
+    if ( packFile == nullptr ) {
+        NYA_CERR << "'" << packFilename << "': failed to open pack for writing" << std::endl;
+        return 1;
+    }
+
+    // The header is written once the layout is known
+    PackHeader header = {};
+    packFile->write( header );
+
+    uint64_t packOffset = sizeof( PackHeader );
+    uint64_t totalSize = 0ull;
+
+    std::vector<PackEntry> entries;
+    std::string names;
+
+    std::vector<uint8_t> content;
+    std::vector<uint8_t> compressedContent;
+
+    for ( const nyaString_t& filename : filenames ) {
+        if ( filename.length() > UINT16_MAX ) {
+            NYA_CWARN << "'" << filename << "': name is too long (the file is skipped)" << std::endl;
+            continue;
+        }
+
+        if ( !ReadFileContent( fileSystem, folderPath + filename, content ) ) {
+            NYA_CWARN << "'" << filename << "': failed to read file (the file is skipped)" << std::endl;
+            continue;
+        }
+
+        PackEntry entry = {};
+        entry.size = content.size();
+        entry.nameHashcode = CRC32( filename );
+        entry.nameOffset = static_cast<uint32_t>( names.size() );
+        entry.nameLength = static_cast<uint16_t>( filename.length() );
+        entry.compression = ePackCompression::PACK_COMPRESSION_NONE;
+
+        const uint8_t* storedContent = content.data();
+        std::size_t storedSize = content.size();
+
+        if ( useCompression && !content.empty() ) {
+            compressedContent.resize( LZ4GetCompressBound( content.size() ) );
+
+            const std::size_t compressedSize = LZ4Compress( content.data(), content.size(), compressedContent.data(), compressedContent.size() );
+            if ( compressedSize != 0 && compressedSize <= content.size() - ( content.size() / MIN_COMPRESSION_GAIN_DIVISOR ) ) {
+                entry.compression = ePackCompression::PACK_COMPRESSION_LZ4;
+                storedContent = compressedContent.data();
+                storedSize = compressedSize;
+            }
+        }
+
+        WritePadding( packFile, packOffset, PACK_ENTRY_ALIGNMENT );
+
+        entry.offset = packOffset;
+        entry.storedSize = storedSize;
+
+        packFile->write( const_cast<uint8_t*>( storedContent ), storedSize );
+        packOffset += storedSize;
+        totalSize += entry.size;
+
+        names += WideStringToString( filename );
+        entries.push_back( entry );
+    }
+
+    // Keep the load factor below 3/4 (lookups stop on the first empty slot)
+    uint32_t tocSlotCount = 16u;
+    while ( entries.size() >= tocSlotCount - ( tocSlotCount >> 2u ) ) {
+        tocSlotCount <<= 1u;
+    }
+
+    std::vector<PackEntry> tableOfContents( tocSlotCount, PackEntry{} );
+    for ( const PackEntry& entry : entries ) {
+        uint32_t slotIdx = ( entry.nameHashcode & ( tocSlotCount - 1u ) );
+        while ( tableOfContents[slotIdx].nameLength != 0 ) {
+            slotIdx = ( slotIdx + 1u ) & ( tocSlotCount - 1u );
+        }
+
+        tableOfContents[slotIdx] = entry;
+    }
+
+    header.magic = PACK_MAGIC;
+    header.version = PACK_VERSION;
+    header.entryCount = static_cast<uint32_t>( entries.size() );
+    header.tocSlotCount = tocSlotCount;
+
+    header.namesOffset = packOffset;
+    header.namesSize = names.size();
+    packFile->write( reinterpret_cast<uint8_t*>( &names[0] ), names.size() );
+    packOffset += names.size();
+
+    WritePadding( packFile, packOffset, alignof( PackEntry ) );
+
+    header.tocOffset = packOffset;
+    packFile->write( reinterpret_cast<uint8_t*>( tableOfContents.data() ), tableOfContents.size() * sizeof( PackEntry ) );
+    packOffset += tableOfContents.size() * sizeof( PackEntry );
+
+    header.fileSize = packOffset;
+
+    packFile->seek( 0ull, eFileReadDirection::FILE_READ_DIRECTION_BEGIN );
+    packFile->write( header );
+    packFile->close();
+
+    NYA_COUT << "Packed " << entries.size() << " files (" << ( totalSize / 1024ull ) << " KiB) into '" << packFilename << "' (" << ( packOffset / 1024ull ) << " KiB)" << std::endl;
+
+    return 0;
+}
+
+static int BenchmarkPack( const nyaString_t& inputFolder, const nyaString_t& packFilename )
+{
+    const nyaString_t folderPath = GetFolderPath( inputFolder );
+
+    {
+        FileSystemPack packFileSystem( packFilename );
+        if ( !packFileSystem.isValid() ) {
+            return 1;
+        }
+    }
+
+    std::vector<nyaString_t> filenames;
+    ListFolderContentImpl( folderPath, filenames );
+
+    std::vector<uint8_t> content;
+    uint64_t readSize = 0ull;
+    uint64_t checksum = 0ull;
+
+    // Open files the way the asset cache does (content is parsed in place if the file can be mapped)
+    auto readEveryFile = [&]( VirtualFileSystem& virtualFileSystem ) {
+        readSize = 0ull;
+        checksum = 0ull;
+
+        for ( const nyaString_t& filename : filenames ) {
+            FileSystemObject* file = virtualFileSystem.openFile( NYA_STRING( "GameData/" ) + filename, eFileOpenMode::FILE_OPEN_MODE_READ | eFileOpenMode::FILE_OPEN_MODE_BINARY | eFileOpenMode::FILE_OPEN_MODE_MEMORY_MAPPED );
+            if ( file == nullptr ) {
+                NYA_CERR << "'" << filename << "': failed to open file" << std::endl;
+                continue;
+            }
+
+            uint64_t contentSize = 0ull;
+            const uint8_t* fileContent = file->map( contentSize );
+
+            if ( fileContent == nullptr ) {
+                content.resize( static_cast<std::size_t>( file->getSize() ) );
+                if ( !content.empty() ) {
+                    file->read( content.data(), content.size() );
+                }
+
+                fileContent = content.data();
+                contentSize = content.size();
+            }
+
+            // Touch every cache line (stands for the parsing/upload of the content)
+            for ( uint64_t byteIdx = 0ull; byteIdx < contentSize; byteIdx += 64ull ) {
+                checksum += fileContent[byteIdx];
+            }
+
+            file->close();
+
+            readSize += contentSize;
+        }
+    };
+
+    // Best of several runs; timings include the mount (the table of contents is read on mount)
+    double looseTime = 1e9;
+    double packedTime = 1e9;
+
+    for ( int runIdx = 0; runIdx < BENCHMARK_RUN_COUNT; runIdx++ ) {
+        Timer timer;
+        StartTimer( &timer );
+        {
+            VirtualFileSystem virtualFileSystem;
+            FileSystemNative dataFileSystem( folderPath );
+            virtualFileSystem.mount( &dataFileSystem, NYA_STRING( "GameData" ), 0 );
+
+            readEveryFile( virtualFileSystem );
+        }
+        looseTime = std::min( looseTime, GetTimerDeltaAsMiliseconds( &timer ) );
+
+        StartTimer( &timer );
+        {
+            VirtualFileSystem virtualFileSystem;
+            FileSystemPack packFileSystem( packFilename );
+            virtualFileSystem.mount( &packFileSystem, NYA_STRING( "GameData" ), 0 );
+
+            readEveryFile( virtualFileSystem );
+        }
+        packedTime = std::min( packedTime, GetTimerDeltaAsMiliseconds( &timer ) );
+    }
+
+    NYA_COUT << filenames.size() << " files (" << ( readSize / 1024ull ) << " KiB; checksum " << checksum << ")" << std::endl
+             << "    Loose:  " << looseTime << " ms" << std::endl
+             << "    Packed: " << packedTime << " ms" << std::endl;
+
+    return 0;
+}
+
+int main( int argc, char** argv )
+{
+    if ( argc >= 4 && strcmp( argv[1], "pack" ) == 0 ) {
+        const bool useCompression = ( argc >= 5 && strcmp( argv[4], "--lz4" ) == 0 );
+        return BuildPack( ToNativeString( argv[2] ), ToNativeString( argv[3] ), useCompression );
+    }
+
+    if ( argc >= 4 && strcmp( argv[1], "bench" ) == 0 ) {
+        return BenchmarkPack( ToNativeString( argv[2] ), ToNativeString( argv[3] ) );
+    }
+
+    PrintUsage();
+    return 1;
+}
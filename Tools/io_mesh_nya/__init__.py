@@ -18,12 +18,12 @@
 #	
 # <pep8-80 compliant>
 
-version = ( 3, 0, 0, 0 )
+version = ( 4, 0, 0, 0 )
 
 bl_info = {
 	"name": "Project Motorway Mesh",
 	"author": "Team Motorway",
-	"version": ( 2, 0, 0 ),
+	"version": ( 2, 1, 0 ),
 	"blender": ( 2, 77, 0 ),
 	"location": "File > Import-Export",
 	"description": "Export .mesh (Project Motorway Mesh)",
@@ -61,6 +61,11 @@ class ExportMesh(bpy.types.Operator, ExportHelper):
 		description="Include geometry optimized for collision detection within the file.",
 		default=False,
 	)
+	quantize_positions = BoolProperty(
+		name="Quantize Positions",
+		description="Store 16 bits positions relative to the bounds of each submesh (smaller file; positions lose precision).",
+		default=False,
+	)
  
 	path_mode = path_reference_mode
 	check_extension = True
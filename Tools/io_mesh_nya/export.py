@@ -38,6 +38,13 @@ mesh_vao_start = 0
 mesh_vbo_start = 0
 
 file_size_offset = 0
+flags_offset = 0
+
+# Header flags
+FLAG_HAS_UV_MAP_0 = 1
+FLAG_HAS_NORMALS = 2
+FLAG_HAS_QUANTIZED_POSITIONS = 4
+FLAG_HAS_SHORT_INDICES = 8
 
 # DEBUG: dump a certain object to the console (useful for undocumented stuff)
 def dump( obj ):
@@ -99,8 +106,9 @@ def write_padding( file ):
 #           file: current file stream
 #           version: current file version (set in the init script file)
 #==========================================================
-def write_header( file, version ):
+def write_header( file, version, flags ):
     global file_size_offset 
+    global flags_offset
 
     # File Version
     file.write( bytes( version ) )
@@ -111,9 +119,56 @@ def write_header( file, version ):
     
     # Buffer strides
     # 1100; has uvmap and normals
-    file.write( struct.pack( 'I', 3 ) )
+    # 0010; positions are quantized (version 4)
+    # 0001; 16 bits indices (version 4; written once the vertex count is known)
+    flags_offset = file.tell()
+    file.write( struct.pack( 'I', flags ) )
     write_padding( file )
 
+#==========================================================
+#   pack_half
+#       Convert a float to a IEEE 754 half (see PackHalf in Nya/Maths/Packing.h)
+#       NOTE struct 'e' format is not available in Blender Python (3.5)
+#==========================================================
+def pack_half( value ):
+    float_bits = struct.unpack( 'I', struct.pack( 'f', value ) )[0]
+
+    sign_bit = ( float_bits >> 16 ) & 0x8000
+    exponent = ( ( float_bits >> 23 ) & 0xFF ) - 127 + 15
+    mantissa = float_bits & 0x7FFFFF
+
+    if exponent <= 0:
+        return sign_bit
+
+    if exponent >= 31:
+        return sign_bit | 0x7BFF
+
+    return sign_bit | min( ( exponent << 10 ) + ( ( mantissa + 0x1000 ) >> 13 ), 0x7BFF )
+
+def pack_unorm16( value ):
+    return int( max( 0.0, min( value, 1.0 ) ) * 65535.0 + 0.5 )
+
+def pack_snorm16( value ):
+    scaled_value = max( -1.0, min( value, 1.0 ) ) * 32767.0
+    return int( scaled_value + ( 0.5 if scaled_value >= 0.0 else -0.5 ) )
+
+#==========================================================
+#   encode_octahedral
+#       Octahedral encoding of a unit vector (see EncodeOctahedral in Nya/Maths/Packing.h)
+#==========================================================
+def encode_octahedral( normal ):
+    l1_norm = abs( normal[0] ) + abs( normal[1] ) + abs( normal[2] )
+    if l1_norm <= 0.0:
+        return ( 0.0, 0.0 )
+
+    x = normal[0] / l1_norm
+    y = normal[1] / l1_norm
+
+    if normal[2] >= 0.0:
+        return ( x, y )
+
+    return ( ( 1.0 - abs( y ) ) * ( 1.0 if x >= 0.0 else -1.0 ), ( 1.0 - abs( x ) ) * ( 1.0 if y >= 0.0 else -1.0 ) )
+
 def write_bounding_sphere( file, object ):
     file.write( struct.pack( 'f', object.location.x ) )
     file.write( struct.pack( 'f', object.location.y ) )
@@ -133,15 +188,30 @@ def write_bounding_box( file, object ):
     file.write( struct.pack( 'f', object.dimensions.z ) )
     file.write( struct.pack( 'f', object.dimensions.y ) )
     
-def write_mesh( file, global_matrix, create_convex_collider, path ):
+#==========================================================
+#   pack_vertex
+#       Pack a vertex to the compact layout (see Nya/Io/MeshFile.h)
+#==========================================================
+def pack_vertex( position, normal, uv, quantize_positions, position_min, position_range ):
+    if quantize_positions:
+        packed_vertex = struct.pack( '3H', *[ pack_unorm16( ( position[i] - position_min[i] ) / position_range[i] ) if position_range[i] > 0.0 else 0 for i in range( 3 ) ] )
+    else:
+        packed_vertex = struct.pack( '3f', *position )
+
+    encoded_normal = encode_octahedral( normal )
+    packed_vertex += struct.pack( '2h', pack_snorm16( encoded_normal[0] ), pack_snorm16( encoded_normal[1] ) )
+    packed_vertex += struct.pack( '2H', pack_half( uv[0] ), pack_half( uv[1] ) )
+
+    return bytes( packed_vertex )
+
+def write_mesh( file, global_matrix, create_convex_collider, quantize_positions, path ):
     global mesh_vao_start
     global mesh_vbo_start
 
-    vbo = array( 'f' )
+    vbo = bytearray()
     ibo = array( 'I' )
     
-    indice = 0
-    indice_tracking = 0
+    vertex_count = 0
 
     file.write( bytearray( 'GEOM', 'utf-8' ) )
     submesh_size_offset = file.tell()
@@ -216,64 +286,91 @@ def write_mesh( file, global_matrix, create_convex_collider, path ):
                 
             print( "DEBUG > LOD = %i" % ( lod ) )
             
-            file.write( struct.pack( 'I', meshHash ) )
-            file.write( bytearray( obj.name, 'utf-8' ) )
-            file.write( struct.pack( 'B', 0x0 ) )
-            file.write( struct.pack( 'I', int( len( ibo ) ) ) )
-            indiceOffset = file.tell()
-            file.write( struct.pack( 'I', 0 ) )
-            write_bounding_sphere( file, obj )
-            write_bounding_box( file, obj )
-            file.write( struct.pack( 'I', lod ) )
-            write_padding( file )
-            
-            indice_tracking = 0
+            loop_vertices = []
             for face in mesh.polygons:
                 for loop_index in face.loop_indices:
-                    ibo.append( indice )
-
                     vertex = mesh.vertices[mesh.loops[loop_index].vertex_index]
+                    uv = mesh.uv_layers.active.data[loop_index].uv
+
+                    loop_vertices.append( ( ( vertex.co.x, vertex.co.y, vertex.co.z ), ( vertex.normal.x, vertex.normal.y, vertex.normal.z ), ( uv[0], uv[1] ) ) )
+
+            # Positions are quantized relative to the submesh bounds
+            position_min = [ 0.0, 0.0, 0.0 ]
+            position_range = [ 0.0, 0.0, 0.0 ]
+            if loop_vertices:
+                for i in range( 3 ):
+                    position_min[i] = min( loop_vertex[0][i] for loop_vertex in loop_vertices )
+                    position_range[i] = max( loop_vertex[0][i] for loop_vertex in loop_vertices ) - position_min[i]
+
+            # Identical vertices (once packed) are shared within the submesh
+            vertex_offset = vertex_count
+            submesh_vertices = {}
+            indice_offset = len( ibo )
 
-                    vbo.append( vertex.co.x )
-                    vbo.append( vertex.co.y )
-                    vbo.append( vertex.co.z )
+            for position, normal, uv in loop_vertices:
+                packed_vertex = pack_vertex( position, normal, uv, quantize_positions, position_min, position_range )
 
-                    vbo.append( vertex.normal.x )
-                    vbo.append( vertex.normal.y )
-                    vbo.append( vertex.normal.z )
+                indice = submesh_vertices.get( packed_vertex )
+                if indice is None:
+                    indice = vertex_count
+                    submesh_vertices[packed_vertex] = indice
+                    vbo += packed_vertex
+                    vertex_count += 1
 
-                    vbo.append( mesh.uv_layers.active.data[loop_index].uv[0] )
-                    vbo.append( mesh.uv_layers.active.data[loop_index].uv[1] )
+                ibo.append( indice )
 
-                    indice += 1
-                    indice_tracking += 1
-   
-            write_entity_count( file, indiceOffset, indice_tracking )
+            file.write( struct.pack( 'I', meshHash ) )
+            file.write( bytearray( obj.name, 'utf-8' ) )
+            file.write( struct.pack( 'B', 0x0 ) )
+            file.write( struct.pack( 'I', indice_offset ) )
+            file.write( struct.pack( 'I', len( ibo ) - indice_offset ) )
+            write_bounding_sphere( file, obj )
+            write_bounding_box( file, obj )
+            file.write( struct.pack( 'I', lod ) )
+            file.write( struct.pack( 'II', vertex_offset, vertex_count - vertex_offset ) )
+            file.write( struct.pack( '3f', *position_min ) )
+            file.write( struct.pack( '3f', *position_range ) )
+            write_padding( file )
 
     write_bloc_size( file, submesh_size_offset, submesh_start_offset )
 
+    use_short_indices = ( vertex_count <= 65536 )
+    if use_short_indices:
+        current_position = file.tell()
+        file.seek( flags_offset, 0 )
+        flags = struct.unpack( 'I', file.read( 4 ) )[0]
+        file.seek( flags_offset, 0 )
+        file.write( struct.pack( 'I', flags | FLAG_HAS_SHORT_INDICES ) )
+        file.seek( current_position, 0 )
+
     mesh_vbo_start = file.tell()
-    for x in vbo:
-        file.write( struct.pack( 'f', x ) )    
+    file.write( vbo )
+
+    # Keep indices aligned (they are used in place when the file is mapped)
+    while file.tell() % 4 != 0:
+        file.write( struct.pack( 'B', 0xFF ) )
     write_bloc_size( file, vbo_size_offset, mesh_vbo_start )
 
     mesh_vao_start = file.tell()
-    for x in ibo:
-        file.write( struct.pack( 'I', x ) )    
+    file.write( array( 'H' if use_short_indices else 'I', ibo ).tobytes() )
     write_bloc_size( file, ibo_size_offset, mesh_vao_start )
  
 #==========================================================
 # Blender Save Function
 #==========================================================
-def save( filepath, create_convex_collider, global_matrix, version ):
+def save( filepath, create_convex_collider, quantize_positions, global_matrix, version ):
     # Open file stream
     file = open( filepath, 'w+b' )
 	
-    write_header( file, version )
+    flags = FLAG_HAS_UV_MAP_0 | FLAG_HAS_NORMALS
+    if quantize_positions:
+        flags |= FLAG_HAS_QUANTIZED_POSITIONS
+
+    write_header( file, version, flags )
     
     bpy.ops.object.select_all( action = 'SELECT' )
     bpy.ops.object.origin_set( type = 'ORIGIN_GEOMETRY' )
-    write_mesh( file, global_matrix, True, filepath )
+    write_mesh( file, global_matrix, True, quantize_positions, filepath )
 
     # Write file size (end offset - 0)
     global file_size_offset